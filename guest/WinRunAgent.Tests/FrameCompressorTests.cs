@@ -1,3 +1,4 @@
+using System.Buffers.Binary;
 using K4os.Compression.LZ4;
 using WinRun.Agent.Services;
 using Xunit;
@@ -131,6 +132,50 @@ public sealed class FrameCompressorTests
         }
     }
 
+    [Fact]
+    public void TryCompressWritesIntoCallerBuffer()
+    {
+        var logger = new TestLogger();
+        var compressor = new FrameCompressor(logger);
+
+        var original = new byte[100000];
+        Array.Fill(original, (byte)0x42);
+        var destination = new byte[FrameCompressor.MaximumCompressedSize(original.Length)];
+
+        Assert.True(compressor.TryCompress(original, destination, out var compressedSize));
+        Assert.InRange(compressedSize, 1, original.Length / 2);
+        Assert.Equal(original, compressor.Decompress(destination.AsSpan(0, compressedSize), original.Length));
+        Assert.Equal(1, compressor.Stats.CompressedFrames);
+    }
+
+    [Fact]
+    public void TryCompressDeclinesWhenDisabled()
+    {
+        var logger = new TestLogger();
+        var compressor = new FrameCompressor(logger, new FrameCompressionConfig { Enabled = false });
+
+        var original = new byte[100000];
+        var destination = new byte[FrameCompressor.MaximumCompressedSize(original.Length)];
+
+        Assert.False(compressor.TryCompress(original, destination, out var compressedSize));
+        Assert.Equal(0, compressedSize);
+        Assert.Equal(1, compressor.Stats.TotalFrames);
+    }
+
+    [Fact]
+    public void CompressIntoReportsDestinationTooSmall()
+    {
+        var logger = new TestLogger();
+        var compressor = new FrameCompressor(logger);
+
+        var original = new byte[100000];
+        Random.Shared.NextBytes(original);
+        var destination = new byte[1000];
+
+        Assert.Equal(-1, compressor.CompressInto(original, destination));
+        Assert.Equal(0, compressor.Stats.TotalFrames);
+    }
+
     [Fact]
     public void StatsTrackTotalFrames()
     {
@@ -286,4 +331,211 @@ public sealed class FrameCompressorTests
         Assert.True(flags.HasFlag(FrameSlotFlags.KeyFrame));
         Assert.Equal(3u, (uint)flags);
     }
+
+    [Fact]
+    public void TiledFrameChoosesACodecPerTile()
+    {
+        var compressor = new FrameCompressor(new TestLogger());
+
+        // Four tiles: a flat background, text-like two-color detail,
+        // a repeating many-color pattern, and noise
+        var frame = new byte[128 * 128 * 4];
+        var random = new Random(7);
+        for (var y = 0; y < 128; y++)
+        {
+            for (var x = 0; x < 128; x++)
+            {
+                var pixel = (x < 64, y < 64) switch
+                {
+                    (true, true) => 0xFFF0F0F0u,
+                    (false, true) => ((x + y) & 1) == 0 ? 0xFF000000u : 0xFFFFFFFFu,
+                    (true, false) => 0xFF000000u | (uint)(x * 0x030507),
+                    _ => (uint)random.Next()
+                };
+                BinaryPrimitives.WriteUInt32LittleEndian(frame.AsSpan(((y * 128) + x) * 4), pixel);
+            }
+        }
+
+        var destination = new byte[compressor.MaximumCompressedFrameSize(128, 128, frame.Length)];
+        var size = compressor.CompressFrameInto(frame, 128, 128, 128 * 4, destination);
+
+        Assert.InRange(size, 1, frame.Length / 3);
+        Assert.Equal(
+            [TileCodec.Rle, TileCodec.Palette, TileCodec.Lz4, TileCodec.Raw],
+            TileCodecs(destination));
+        Assert.Equal(frame, DecodeTiled(destination.AsSpan(0, size), 128, 128));
+
+        var stats = compressor.Stats;
+        Assert.Equal(1, stats.CompressedFrames);
+        Assert.Equal((1, 1, 1, 1), (stats.RawTiles, stats.Lz4Tiles, stats.RleTiles, stats.PaletteTiles));
+    }
+
+    [Fact]
+    public void TiledFrameHandlesPartialTilesAndPaddedRows()
+    {
+        var compressor = new FrameCompressor(new TestLogger());
+
+        // 100x70 with padded rows: the right and bottom tiles are partial
+        const int Width = 100, Height = 70, Stride = 104 * 4;
+        var frame = new byte[Stride * Height];
+        for (var y = 0; y < Height; y++)
+        {
+            for (var x = 0; x < Width; x++)
+            {
+                var pixel = 0xFF000000u | (uint)((x / 10) * 0x112233) | (uint)(y / 7);
+                BinaryPrimitives.WriteUInt32LittleEndian(frame.AsSpan((y * Stride) + (x * 4)), pixel);
+            }
+        }
+
+        var destination = new byte[compressor.MaximumCompressedFrameSize(Width, Height, frame.Length)];
+        var size = compressor.CompressFrameInto(frame, Width, Height, Stride, destination);
+
+        Assert.True(size > 0);
+        Assert.Equal(4, TileCodecs(destination).Length);
+
+        var expected = new byte[Width * Height * 4];
+        for (var y = 0; y < Height; y++)
+        {
+            frame.AsSpan(y * Stride, Width * 4).CopyTo(expected.AsSpan(y * Width * 4));
+        }
+        Assert.Equal(expected, DecodeTiled(destination.AsSpan(0, size), Width, Height));
+    }
+
+    [Fact]
+    public void TiledFrameSendsBusyTilesRawOnceTheBudgetIsSpent()
+    {
+        var compressor = new FrameCompressor(new TestLogger());
+        compressor.SetFrameInterval(TimeSpan.Zero);
+        Assert.Equal(TimeSpan.Zero, compressor.EncodeBudget);
+
+        // 512 colors repeating every 8 rows: too many for a palette, and LZ4
+        // would shrink it to a fraction, but there is no time for LZ4
+        var frame = new byte[64 * 64 * 4];
+        for (var i = 0; i < frame.Length; i += 4)
+        {
+            BinaryPrimitives.WriteUInt32LittleEndian(frame.AsSpan(i), 0xFF000000u | (uint)((i / 4 % 512) * 0x030507));
+        }
+
+        // Flat tiles are still coded, since they cost no more than a raw copy
+        var flat = new byte[64 * 64 * 4];
+        var destination = new byte[compressor.MaximumCompressedFrameSize(64, 64, frame.Length)];
+        Assert.Equal(0, compressor.CompressFrameInto(frame, 64, 64, 64 * 4, destination));
+        Assert.True(compressor.CompressFrameInto(flat, 64, 64, 64 * 4, destination) > 0);
+        Assert.Equal([TileCodec.Rle], TileCodecs(destination));
+
+        compressor.SetFrameInterval(TimeSpan.FromMilliseconds(33));
+        Assert.True(compressor.CompressFrameInto(frame, 64, 64, 64 * 4, destination) > 0);
+        Assert.Equal([TileCodec.Lz4], TileCodecs(destination));
+
+        // A host that takes the whole budget to decode leaves none for LZ4
+        Assert.Equal(0, compressor.CompressFrameInto(frame, 64, 64, 64 * 4, destination, compressor.EncodeBudget));
+        Assert.True(compressor.CompressFrameInto(
+            frame, 64, 64, 64 * 4, destination, TimeSpan.FromMicroseconds(100)) > 0);
+        Assert.Equal([TileCodec.Lz4], TileCodecs(destination));
+    }
+
+    [Fact]
+    public void TiledFrameReportsDestinationTooSmall()
+    {
+        var compressor = new FrameCompressor(new TestLogger());
+        var frame = new byte[256 * 256 * 4];
+        Random.Shared.NextBytes(frame);
+
+        Assert.Equal(-1, compressor.CompressFrameInto(frame, 256, 256, 256 * 4, new byte[4096]));
+        Assert.Equal(0, compressor.Stats.TotalFrames);
+    }
+
+    [Fact]
+    public void TiledFlagIsSetWithCompressed()
+    {
+        Assert.Equal(8u, (uint)FrameSlotFlags.Tiled);
+        Assert.Equal(FrameCodec.Tiled, new FrameCompressionConfig().Codec);
+    }
+
+    private static TileCodec[] TileCodecs(byte[] payload)
+    {
+        var count = (int)BinaryPrimitives.ReadUInt32LittleEndian(payload.AsSpan(4));
+        return Enumerable.Range(0, count)
+            .Select(i => (TileCodec)payload[TiledFrameEncoder.HeaderSize + (i * TiledFrameEncoder.TileEntrySize)])
+            .ToArray();
+    }
+
+    /// <summary>
+    /// Decodes a tiled payload into packed rows, as the bridge does.
+    /// </summary>
+    private static byte[] DecodeTiled(ReadOnlySpan<byte> payload, int width, int height)
+    {
+        var tileSize = BinaryPrimitives.ReadUInt16LittleEndian(payload);
+        var frame = new byte[width * height * 4];
+        var entry = TiledFrameEncoder.HeaderSize;
+        var offset = entry + ((int)BinaryPrimitives.ReadUInt32LittleEndian(payload[4..]) * TiledFrameEncoder.TileEntrySize);
+
+        for (var tileY = 0; tileY < height; tileY += tileSize)
+        {
+            for (var tileX = 0; tileX < width; tileX += tileSize)
+            {
+                var (w, h) = (Math.Min(tileSize, width - tileX), Math.Min(tileSize, height - tileY));
+                var codec = (TileCodec)payload[entry];
+                var length = (int)BinaryPrimitives.ReadUInt32LittleEndian(payload[(entry + 4)..]);
+                var data = payload.Slice(offset, length);
+                entry += TiledFrameEncoder.TileEntrySize;
+                offset += length;
+
+                var pixels = new uint[w * h];
+                switch (codec)
+                {
+                    case TileCodec.Raw:
+                        for (var i = 0; i < pixels.Length; i++)
+                        {
+                            pixels[i] = BinaryPrimitives.ReadUInt32LittleEndian(data[(i * 4)..]);
+                        }
+                        break;
+                    case TileCodec.Lz4:
+                        var raw = new byte[w * h * 4];
+                        Assert.Equal(raw.Length, LZ4Codec.Decode(data, raw));
+                        for (var i = 0; i < pixels.Length; i++)
+                        {
+                            pixels[i] = BinaryPrimitives.ReadUInt32LittleEndian(raw.AsSpan(i * 4));
+                        }
+                        break;
+                    case TileCodec.Rle:
+                        var p = 0;
+                        for (var run = 0; run < data.Length; run += 6)
+                        {
+                            var count = BinaryPrimitives.ReadUInt16LittleEndian(data[run..]);
+                            Array.Fill(pixels, BinaryPrimitives.ReadUInt32LittleEndian(data[(run + 2)..]), p, count);
+                            p += count;
+                        }
+                        Assert.Equal(pixels.Length, p);
+                        break;
+                    case TileCodec.Palette:
+                        var colors = data[0] + 1;
+                        var bits = colors <= 2 ? 1 : colors <= 4 ? 2 : colors <= 16 ? 4 : 8;
+                        var rowBytes = ((w * bits) + 7) / 8;
+                        var indices = data[(1 + (colors * 4))..];
+                        for (var y = 0; y < h; y++)
+                        {
+                            for (var x = 0; x < w; x++)
+                            {
+                                var bit = x * bits;
+                                var index = (indices[(y * rowBytes) + (bit >> 3)] >> (bit & 7)) & ((1 << bits) - 1);
+                                pixels[(y * w) + x] = BinaryPrimitives.ReadUInt32LittleEndian(data[(1 + (index * 4))..]);
+                            }
+                        }
+                        break;
+                }
+
+                for (var y = 0; y < h; y++)
+                {
+                    for (var x = 0; x < w; x++)
+                    {
+                        BinaryPrimitives.WriteUInt32LittleEndian(
+                            frame.AsSpan((((tileY + y) * width) + tileX + x) * 4), pixels[(y * w) + x]);
+                    }
+                }
+            }
+        }
+
+        return frame;
+    }
 }
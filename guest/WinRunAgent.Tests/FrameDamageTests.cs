@@ -0,0 +1,271 @@
+using System.Buffers.Binary;
+using WinRun.Agent.Services;
+using Xunit;
+
+namespace WinRun.Agent.Tests;
+
+public sealed class FrameDamageTests
+{
+    [Fact]
+    public void ForWindowClipsAndTranslatesDirtyRects()
+    {
+        var damage = new FrameDamage([], [new Rect(90, 90, 20, 20), new Rect(500, 500, 10, 10)]);
+
+        var window = damage.ForWindow(new Rect(100, 100, 200, 200));
+
+        Assert.Empty(window.MoveRects);
+        _ = Assert.Single(window.DirtyRects);
+        Assert.Equal(new Rect(0, 0, 10, 10), window.DirtyRects[0]);
+    }
+
+    [Fact]
+    public void ForWindowKeepsMovesInsideTheWindow()
+    {
+        var move = new FrameMoveRect(110, 150, new Rect(110, 130, 100, 50));
+        var damage = new FrameDamage([move], []);
+
+        var window = damage.ForWindow(new Rect(100, 100, 200, 200));
+
+        _ = Assert.Single(window.MoveRects);
+        Assert.Equal(new FrameMoveRect(10, 50, new Rect(10, 30, 100, 50)), window.MoveRects[0]);
+        Assert.Empty(window.DirtyRects);
+    }
+
+    [Fact]
+    public void ForWindowTurnsMovesAcrossTheEdgeIntoDirtyRects()
+    {
+        // Source starts outside the window, so the host has nothing to move
+        var move = new FrameMoveRect(0, 0, new Rect(150, 150, 100, 100));
+        var damage = new FrameDamage([move], []);
+
+        var window = damage.ForWindow(new Rect(100, 100, 200, 200));
+
+        Assert.Empty(window.MoveRects);
+        Assert.Equal(new Rect(50, 50, 100, 100), Assert.Single(window.DirtyRects));
+    }
+
+    [Fact]
+    public void ForWindowWithoutOverlapIsEmpty()
+    {
+        var damage = new FrameDamage([], [new Rect(0, 0, 10, 10)]);
+
+        Assert.True(damage.ForWindow(new Rect(100, 100, 50, 50)).IsEmpty);
+    }
+
+    [Fact]
+    public void PayloadSizeCountsRectsAndPixels()
+    {
+        var damage = new FrameDamage(
+            [new FrameMoveRect(0, 10, new Rect(0, 0, 10, 10))],
+            [new Rect(0, 0, 8, 16)]);
+
+        Assert.Equal(8 + 24 + 16 + (8 * 16 * 4), damage.PayloadSize);
+    }
+
+    [Fact]
+    public void WritePayloadLaysOutHeaderRectsAndPixels()
+    {
+        var source = new SyntheticCaptureSource(64, 32);
+        _ = source.CaptureFrame();
+        source.Fill(new Rect(10, 5, 2, 2), 0x11223344);
+        var frame = source.CaptureFrame()!;
+        var damage = frame.Damage!.ForWindow(new Rect(8, 4, 32, 16));
+
+        var payload = new byte[damage.PayloadSize];
+        var written = damage.WritePayload(payload, frame, new Rect(8, 4, 32, 16));
+
+        Assert.Equal(payload.Length, written);
+        Assert.Equal(0u, BinaryPrimitives.ReadUInt32LittleEndian(payload));
+        Assert.Equal(1u, BinaryPrimitives.ReadUInt32LittleEndian(payload.AsSpan(4)));
+        Assert.Equal(2, BinaryPrimitives.ReadInt32LittleEndian(payload.AsSpan(8)));
+        Assert.Equal(1, BinaryPrimitives.ReadInt32LittleEndian(payload.AsSpan(12)));
+        Assert.Equal(0x11223344u, BinaryPrimitives.ReadUInt32LittleEndian(payload.AsSpan(24)));
+    }
+
+    [Fact]
+    public void AppliedPayloadReproducesTheNextFrame()
+    {
+        var source = new SyntheticCaptureSource(320, 200);
+        source.Fill(new Rect(0, 0, 320, 200), 0xFF202020);
+        for (var y = 0; y < 200; y += 10)
+        {
+            source.Fill(new Rect(0, y, 320, 2), 0xFF000000 | (uint)y);
+        }
+
+        var previous = source.CaptureFrame()!;
+        var composed = (byte[])previous.Data.Clone();
+
+        // Scroll up by 30 rows, then draw the newly exposed strip and a caret
+        source.Move(new Rect(0, 30, 320, 170), 0, 0);
+        source.Fill(new Rect(0, 170, 320, 30), 0xFFFFFFFF);
+        source.Fill(new Rect(40, 40, 2, 14), 0xFF0000FF);
+        var next = source.CaptureFrame()!;
+
+        var damage = next.Damage!;
+        _ = Assert.Single(damage.MoveRects);
+        var payload = new byte[damage.PayloadSize];
+        _ = damage.WritePayload(payload, next, new Rect(0, 0, 320, 200));
+
+        ApplyPayload(composed, next.Stride, payload);
+
+        Assert.Equal(next.Data, composed);
+        Assert.True(payload.Length < next.Data.Length / 4);
+    }
+
+    [Fact]
+    public void SyntheticSourceReportsNothingWhenUnchanged()
+    {
+        var source = new SyntheticCaptureSource(16, 16);
+
+        var first = source.CaptureFrame();
+        Assert.NotNull(first);
+        Assert.Equal(new Rect(0, 0, 16, 16), Assert.Single(first.Damage!.DirtyRects));
+
+        Assert.Null(source.CaptureFrame());
+        Assert.Equal(1, source.CaptureCount);
+    }
+
+    [Fact]
+    public void SyntheticSourceKeepsPreviousFrameUntilCaptureAfterNext()
+    {
+        var source = new SyntheticCaptureSource(16, 16);
+        var first = source.CaptureFrame()!;
+
+        source.Fill(new Rect(0, 0, 16, 16), 0xFFFFFFFF);
+        var second = source.CaptureFrame()!;
+
+        Assert.NotSame(first.Data, second.Data);
+        Assert.Equal(0u, BitConverter.ToUInt32(first.Data));
+        Assert.Equal(0xFFFFFFFFu, BitConverter.ToUInt32(second.Data));
+    }
+
+    [Fact]
+    public void SyntheticSourceWithoutDamageReportsUnknown()
+    {
+        var source = new SyntheticCaptureSource(16, 16) { ReportsDamage = false };
+        source.Fill(new Rect(0, 0, 4, 4), 0xFFFFFFFF);
+
+        Assert.Null(source.CaptureFrame()!.Damage);
+    }
+
+    [Fact]
+    public void TrackerNeedsKeyFrameFirst()
+    {
+        var tracker = new WindowDamageTracker();
+        var bounds = new Rect(0, 0, 100, 100);
+        var damage = new FrameDamage([], [new Rect(0, 0, 1, 1)]);
+
+        Assert.Null(tracker.Take(bounds, damage));
+
+        tracker.Committed(bounds, isKeyFrame: true, DateTime.UtcNow);
+        Assert.Same(damage, tracker.Take(bounds, damage));
+    }
+
+    [Fact]
+    public void TrackerNeedsKeyFrameAfterMoveOrUnknownDamage()
+    {
+        var tracker = new WindowDamageTracker();
+        var bounds = new Rect(0, 0, 100, 100);
+        tracker.Committed(bounds, isKeyFrame: true, DateTime.UtcNow);
+
+        Assert.Null(tracker.Take(new Rect(10, 0, 100, 100), FrameDamage.Empty));
+        Assert.Null(tracker.Take(bounds, null));
+        Assert.True(tracker.IsUpToDate(bounds, FrameDamage.Empty));
+    }
+
+    [Fact]
+    public void TrackerMergesSkippedDamageAsDirtyRects()
+    {
+        var tracker = new WindowDamageTracker();
+        var bounds = new Rect(0, 0, 100, 100);
+        tracker.Committed(bounds, isKeyFrame: true, DateTime.UtcNow);
+
+        tracker.Accumulate(new FrameDamage([new FrameMoveRect(0, 10, new Rect(0, 0, 100, 50))], []), maxRects: 8);
+        Assert.False(tracker.IsUpToDate(bounds, FrameDamage.Empty));
+
+        var merged = tracker.Take(bounds, new FrameDamage([], [new Rect(5, 5, 1, 1)]));
+
+        Assert.NotNull(merged);
+        Assert.Empty(merged.MoveRects);
+        Assert.Equal(new[] { new Rect(0, 0, 100, 50), new Rect(5, 5, 1, 1) }, merged.DirtyRects);
+    }
+
+    [Fact]
+    public void TrackerIsBehindUntilSkippedChangesAreSent()
+    {
+        var tracker = new WindowDamageTracker();
+        var bounds = new Rect(0, 0, 100, 100);
+        Assert.True(tracker.IsBehind);
+
+        tracker.Committed(bounds, isKeyFrame: true, DateTime.UtcNow);
+        Assert.False(tracker.IsBehind);
+
+        tracker.Accumulate(new FrameDamage([], [new Rect(5, 5, 1, 1)]), maxRects: 8);
+        Assert.True(tracker.IsBehind);
+
+        tracker.Committed(bounds, isKeyFrame: false, DateTime.UtcNow);
+        Assert.False(tracker.IsBehind);
+    }
+
+    [Fact]
+    public void TrackerFallsBackToKeyFrameWhenTooMuchIsPending()
+    {
+        var tracker = new WindowDamageTracker();
+        var bounds = new Rect(0, 0, 100, 100);
+        tracker.Committed(bounds, isKeyFrame: true, DateTime.UtcNow);
+
+        tracker.Accumulate(new FrameDamage([], [new Rect(0, 0, 1, 1), new Rect(2, 2, 1, 1)]), maxRects: 1);
+
+        Assert.Null(tracker.Take(bounds, FrameDamage.Empty));
+    }
+
+    /// <summary>
+    /// Applies a damage payload the way the host does: moves first, then dirty pixels.
+    /// </summary>
+    private static void ApplyPayload(byte[] surface, int stride, byte[] payload)
+    {
+        var moveCount = BinaryPrimitives.ReadInt32LittleEndian(payload);
+        var dirtyCount = BinaryPrimitives.ReadInt32LittleEndian(payload.AsSpan(4));
+        var offset = FrameDamageHeader.Size;
+
+        for (var i = 0; i < moveCount; i++, offset += FrameDamageHeader.MoveRectSize)
+        {
+            var srcX = BinaryPrimitives.ReadInt32LittleEndian(payload.AsSpan(offset));
+            var srcY = BinaryPrimitives.ReadInt32LittleEndian(payload.AsSpan(offset + 4));
+            var x = BinaryPrimitives.ReadInt32LittleEndian(payload.AsSpan(offset + 8));
+            var y = BinaryPrimitives.ReadInt32LittleEndian(payload.AsSpan(offset + 12));
+            var width = BinaryPrimitives.ReadInt32LittleEndian(payload.AsSpan(offset + 16));
+            var height = BinaryPrimitives.ReadInt32LittleEndian(payload.AsSpan(offset + 20));
+
+            var copy = new byte[height * width * 4];
+            for (var row = 0; row < height; row++)
+            {
+                surface.AsSpan(((srcY + row) * stride) + (srcX * 4), width * 4).CopyTo(copy.AsSpan(row * width * 4));
+            }
+
+            for (var row = 0; row < height; row++)
+            {
+                copy.AsSpan(row * width * 4, width * 4).CopyTo(surface.AsSpan(((y + row) * stride) + (x * 4)));
+            }
+        }
+
+        var rects = new List<Rect>();
+        for (var i = 0; i < dirtyCount; i++, offset += FrameDamageHeader.DirtyRectSize)
+        {
+            rects.Add(new Rect(
+                BinaryPrimitives.ReadInt32LittleEndian(payload.AsSpan(offset)),
+                BinaryPrimitives.ReadInt32LittleEndian(payload.AsSpan(offset + 4)),
+                BinaryPrimitives.ReadInt32LittleEndian(payload.AsSpan(offset + 8)),
+                BinaryPrimitives.ReadInt32LittleEndian(payload.AsSpan(offset + 12))));
+        }
+
+        foreach (var rect in rects)
+        {
+            for (var row = 0; row < rect.Height; row++)
+            {
+                payload.AsSpan(offset, rect.Width * 4).CopyTo(surface.AsSpan(((rect.Y + row) * stride) + (rect.X * 4)));
+                offset += rect.Width * 4;
+            }
+        }
+    }
+}
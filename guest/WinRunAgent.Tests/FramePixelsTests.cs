@@ -0,0 +1,114 @@
+using WinRun.Agent.Services;
+using Xunit;
+
+namespace WinRun.Agent.Tests;
+
+public sealed class FramePixelsTests
+{
+    [Fact]
+    public void SwapRedBlueMatchesScalarAtEveryLength()
+    {
+        var random = new Random(1);
+        for (var pixels = 0; pixels <= 40; pixels++)
+        {
+            var source = new byte[pixels * 4];
+            random.NextBytes(source);
+            var expected = new byte[source.Length];
+            var actual = new byte[source.Length];
+
+            FramePixels.SwapRedBlueScalar(source, expected);
+            FramePixels.SwapRedBlue(source, actual);
+
+            Assert.Equal(expected, actual);
+        }
+    }
+
+    [Fact]
+    public void SwapRedBlueSwapsTheFirstAndThirdBytes()
+    {
+        byte[] rgba = [1, 2, 3, 4, 5, 6, 7, 8];
+        var bgra = new byte[8];
+
+        FramePixels.SwapRedBlue(rgba, bgra);
+
+        Assert.Equal([3, 2, 1, 4, 7, 6, 5, 8], bgra);
+    }
+
+    [Theory]
+    [InlineData(false)]
+    [InlineData(true)]
+    public void Downscale2xRowMatchesScalarAtEveryLength(bool swapRedBlue)
+    {
+        var random = new Random(2);
+        for (var outPixels = 0; outPixels <= 20; outPixels++)
+        {
+            var top = new byte[outPixels * 8];
+            var bottom = new byte[outPixels * 8];
+            random.NextBytes(top);
+            random.NextBytes(bottom);
+            var expected = new byte[outPixels * 4];
+            var actual = new byte[outPixels * 4];
+
+            FramePixels.Downscale2xRowScalar(top, bottom, expected, swapRedBlue);
+            FramePixels.Downscale2xRow(top, bottom, actual, swapRedBlue);
+
+            Assert.Equal(expected, actual);
+        }
+    }
+
+    [Fact]
+    public void Downscale2xAveragesEachBlockWithRounding()
+    {
+        // One 2x2 block: channel sums 1+2+3+4 = 10 -> 3 (rounded), 255*4 -> 255
+        byte[] source =
+        [
+            1, 0, 255, 100, 2, 0, 255, 100,
+            3, 1, 255, 100, 4, 1, 255, 101,
+        ];
+        var destination = new byte[4];
+
+        FramePixels.Downscale2x(source, 8, 0, 0, 2, 2, swapRedBlue: false, destination);
+
+        Assert.Equal([3, 1, 255, 100], destination);
+    }
+
+    [Fact]
+    public void Downscale2xCropsAndDropsAnOddEdge()
+    {
+        // 10x7 frame of distinct pixels; halve the 5x5 region at (3, 1)
+        var stride = 10 * 4;
+        var source = new byte[stride * 7];
+        new Random(3).NextBytes(source);
+        var destination = new byte[FramePixels.Downscale2xSize(5, 5)];
+        Assert.Equal(2 * 2 * 4, destination.Length);
+
+        FramePixels.Downscale2x(source, stride, 3, 1, 5, 5, swapRedBlue: true, destination);
+
+        for (var row = 0; row < 2; row++)
+        {
+            var top = source.AsSpan(((1 + (row * 2)) * stride) + 12, 16);
+            var bottom = source.AsSpan(((2 + (row * 2)) * stride) + 12, 16);
+            var expected = new byte[8];
+            FramePixels.Downscale2xRowScalar(top, bottom, expected, swapRedBlue: true);
+            Assert.Equal(expected, destination.AsSpan(row * 8, 8).ToArray());
+        }
+    }
+
+    [Fact]
+    public void CopyRegionConvertsRgbaToBgra()
+    {
+        var stride = 40 * 4;
+        var source = new byte[stride * 3];
+        new Random(4).NextBytes(source);
+        var destination = new byte[33 * 2 * 4];
+
+        FramePixels.CopyRegion(source, stride, 5, 1, 33, 2, swapRedBlue: true, destination);
+
+        for (var row = 0; row < 2; row++)
+        {
+            var expected = new byte[33 * 4];
+            FramePixels.SwapRedBlueScalar(source.AsSpan(((1 + row) * stride) + 20, 33 * 4), expected);
+            Assert.Equal(expected, destination.AsSpan(row * 33 * 4, 33 * 4).ToArray());
+        }
+    }
+}
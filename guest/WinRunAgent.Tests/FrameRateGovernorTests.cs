@@ -0,0 +1,113 @@
+using WinRun.Agent.Services;
+using Xunit;
+
+namespace WinRun.Agent.Tests;
+
+public sealed class FrameRateGovernorTests
+{
+    private static readonly DateTime Start = new(2026, 1, 1, 0, 0, 0, DateTimeKind.Utc);
+
+    [Fact]
+    public void FocusedWindowGetsTheFocusedRate()
+    {
+        var governor = new FrameRateGovernor(minFps: 1);
+        Observe(governor, 1, changed: false, everyMs: 100, forMs: 2000);
+
+        var decision = governor.Evaluate(1, maxFps: 60, isFocused: true, Start.AddSeconds(2), out _);
+
+        Assert.Equal(new FrameRateDecision(60, FrameRateReason.Focused), decision);
+        Assert.Equal(16, decision.MinIntervalMs);
+    }
+
+    [Fact]
+    public void StaticWindowDropsToTheMinimumRate()
+    {
+        var governor = new FrameRateGovernor(minFps: 1);
+        Observe(governor, 1, changed: false, everyMs: 33, forMs: 2000);
+
+        var decision = governor.Evaluate(1, maxFps: 30, isFocused: false, Start.AddSeconds(2), out _);
+
+        Assert.Equal(new FrameRateDecision(1, FrameRateReason.Damage), decision);
+    }
+
+    [Fact]
+    public void WindowChangingEveryFrameIsHeldAtItsCap()
+    {
+        var governor = new FrameRateGovernor(minFps: 1);
+        Observe(governor, 1, changed: true, everyMs: 16, forMs: 1000);
+
+        Assert.Equal(
+            new FrameRateDecision(30, FrameRateReason.Capped),
+            governor.Evaluate(1, maxFps: 30, isFocused: false, Start.AddSeconds(1), out _));
+
+        // Background windows stay at their cap however fast they change
+        Assert.Equal(
+            new FrameRateDecision(2, FrameRateReason.Capped),
+            governor.Evaluate(1, maxFps: 2, isFocused: false, Start.AddSeconds(1), out _));
+    }
+
+    [Fact]
+    public void OccasionalChangesSetARateAboveTheChangeRate()
+    {
+        var governor = new FrameRateGovernor(minFps: 1);
+
+        // A blinking caret: two changes a second, observed on a 30 fps desktop
+        for (var ms = 0; ms <= 3000; ms += 33)
+        {
+            governor.ObserveDamage(1, changed: ms % 500 < 33, Start.AddMilliseconds(ms));
+        }
+
+        var decision = governor.Evaluate(1, maxFps: 30, isFocused: false, Start.AddMilliseconds(3000), out _);
+
+        Assert.Equal(FrameRateReason.Damage, decision.Reason);
+        Assert.InRange(decision.TargetFps, 3, 10);
+    }
+
+    [Fact]
+    public void HostBacklogHalvesTheRateUntilTheHoldExpires()
+    {
+        var governor = new FrameRateGovernor(minFps: 1);
+        Observe(governor, 1, changed: true, everyMs: 16, forMs: 1000);
+        var now = Start.AddSeconds(1);
+        Assert.Equal(30, governor.Evaluate(1, maxFps: 30, isFocused: false, now, out _).TargetFps);
+
+        governor.ObserveBackpressure(1, now);
+        var slowed = governor.Evaluate(1, maxFps: 30, isFocused: false, now, out var changed);
+        Assert.True(changed);
+        Assert.Equal(new FrameRateDecision(15, FrameRateReason.Backpressure), slowed);
+
+        // Still skipping: halve again
+        governor.ObserveBackpressure(1, now.AddMilliseconds(100));
+        Assert.Equal(7, governor.Evaluate(1, maxFps: 30, isFocused: false, now.AddMilliseconds(100), out _).TargetFps);
+
+        // Backpressure applies to the focused window too, then recovers
+        Assert.Equal(FrameRateReason.Backpressure, governor.Evaluate(1, 60, isFocused: true, now.AddMilliseconds(500), out _).Reason);
+        Assert.Equal(
+            new FrameRateDecision(60, FrameRateReason.Focused),
+            governor.Evaluate(1, maxFps: 60, isFocused: true, now.AddSeconds(2), out _));
+    }
+
+    [Fact]
+    public void UnobservedWindowStartsAtItsCap()
+    {
+        var governor = new FrameRateGovernor(minFps: 1);
+
+        Assert.Null(governor.GetDecision(5));
+        Assert.Equal(
+            new FrameRateDecision(30, FrameRateReason.Capped),
+            governor.Evaluate(5, maxFps: 30, isFocused: false, Start, out var changed));
+        Assert.False(changed);
+        Assert.Equal(30, governor.GetDecision(5)?.TargetFps);
+
+        governor.RemoveStale(new HashSet<ulong>());
+        Assert.Null(governor.GetDecision(5));
+    }
+
+    private static void Observe(FrameRateGovernor governor, ulong windowId, bool changed, int everyMs, int forMs)
+    {
+        for (var ms = 0; ms < forMs; ms += everyMs)
+        {
+            governor.ObserveDamage(windowId, changed, Start.AddMilliseconds(ms));
+        }
+    }
+}
@@ -1,3 +1,4 @@
+using System.Diagnostics;
 using System.Threading.Channels;
 using WinRun.Agent.Services;
 using Xunit;
@@ -383,6 +384,65 @@ public sealed class FrameStreamingServiceTests
         service.CleanupStaleWindowStates();
     }
 
+    [Fact]
+    public void SetWindowThrottleHiddenSkipsCapture()
+    {
+        var logger = new TestLogger();
+        var windowTracker = new WindowTracker(logger);
+        var desktopDuplication = new DesktopDuplicationBridge(logger);
+        var outboundChannel = Channel.CreateUnbounded<GuestMessage>();
+
+        using var service = new FrameStreamingService(
+            logger,
+            windowTracker,
+            desktopDuplication,
+            outboundChannel);
+
+        var now = DateTime.UtcNow;
+        Assert.True(service.ShouldCaptureWindow(1, now));
+
+        service.SetWindowThrottle(1, StreamVisibility.Hidden, 0);
+
+        Assert.Equal(StreamVisibility.Hidden, service.GetWindowVisibility(1));
+        Assert.False(service.ShouldCaptureWindow(1, now));
+        Assert.Equal(1, service.Stats.FramesThrottled);
+
+        service.SetWindowThrottle(1, StreamVisibility.Visible, 0);
+
+        Assert.Equal(StreamVisibility.Visible, service.GetWindowVisibility(1));
+        Assert.True(service.ShouldCaptureWindow(1, now));
+    }
+
+    [Fact]
+    public void SetWindowThrottleBackgroundLimitsRate()
+    {
+        var logger = new TestLogger();
+        var windowTracker = new WindowTracker(logger);
+        var desktopDuplication = new DesktopDuplicationBridge(logger);
+        var outboundChannel = Channel.CreateUnbounded<GuestMessage>();
+        var config = new FrameStreamingConfig { BackgroundMaxFps = 2 };
+
+        using var service = new FrameStreamingService(
+            logger,
+            windowTracker,
+            desktopDuplication,
+            outboundChannel,
+            config);
+
+        var start = DateTime.UtcNow;
+        service.SetWindowThrottle(7, StreamVisibility.Background, 0);
+        service.UpdateWindowFrameState(7, start);
+
+        // 2 FPS => 500ms minimum interval instead of the default 33ms
+        Assert.False(service.ShouldCaptureWindow(7, start.AddMilliseconds(100)));
+        Assert.True(service.ShouldCaptureWindow(7, start.AddMilliseconds(500)));
+        Assert.Equal(1, service.Stats.FramesThrottled);
+
+        // An explicit cap from the host overrides the background default
+        service.SetWindowThrottle(7, StreamVisibility.Background, 10);
+        Assert.True(service.ShouldCaptureWindow(7, start.AddMilliseconds(100)));
+    }
+
     [Fact]
     public void FrameStreamingConfigPerWindowCaptureCanBeDisabled()
     {
@@ -420,6 +480,474 @@ public sealed class FrameStreamingServiceTests
         Assert.False(service.UsesSharedMemory);
     }
 
+    [Fact]
+    public async Task FrameStreamingServiceSendsOnlyDamageAfterKeyFrame()
+    {
+        var logger = new TestLogger();
+        var windowTracker = new WindowTracker(logger);
+        var source = new SyntheticCaptureSource(1920, 1080);
+        var outboundChannel = Channel.CreateUnbounded<GuestMessage>();
+        var config = new FrameStreamingConfig { EnablePerWindowCapture = false, TargetFps = 60 };
+
+        using var service = new FrameStreamingService(logger, windowTracker, source, outboundChannel, config);
+        service.Start();
+
+        await WaitForAsync(() => service.Stats.FramesWritten == 1);
+        var keyFrameBytes = service.Stats.BytesWritten;
+        Assert.Equal(1920 * 1080 * 4, keyFrameBytes);
+
+        // A keystroke: an 8x16 glyph
+        source.Fill(new Rect(400, 300, 8, 16), 0xFF000000);
+        await WaitForAsync(() => service.Stats.FramesWritten == 2);
+
+        Assert.Equal(1, service.Stats.DamageFramesWritten);
+        Assert.Equal(8 + 16 + (8 * 16 * 4), service.Stats.BytesWritten - keyFrameBytes);
+
+        await service.StopAsync();
+
+        var frames = new List<FrameReadyMessage>();
+        while (outboundChannel.Reader.TryRead(out var message))
+        {
+            if (message is FrameReadyMessage frameReady)
+            {
+                frames.Add(frameReady);
+            }
+        }
+
+        Assert.Equal(2, frames.Count);
+        Assert.True(frames[0].IsKeyFrame);
+        Assert.False(frames[1].IsKeyFrame);
+    }
+
+    [Fact]
+    public async Task FrameStreamingServiceKeyFramesDoNotAllocateFrameBuffers()
+    {
+        var logger = new TestLogger { MinimumLevel = LogLevel.Info };
+        var windowTracker = new WindowTracker(logger);
+        var source = new SyntheticCaptureSource(1920, 1080) { ReportsDamage = false };
+        var outboundChannel = Channel.CreateUnbounded<GuestMessage>();
+        var config = new FrameStreamingConfig { EnablePerWindowCapture = false, TargetFps = 60 };
+
+        using var service = new FrameStreamingService(logger, windowTracker, source, outboundChannel, config);
+        service.Start();
+
+        // Frames are written off the capture loop; wait until the first is fully done
+        await WaitForAsync(() => service.Stats.FramesWritten == 1 && service.Stats.AverageFrameTime > TimeSpan.Zero);
+        var allocatedBefore = service.Stats.AllocatedBytes;
+
+        source.Fill(new Rect(0, 0, 8, 8), 0xFFFFFFFF);
+        await WaitForAsync(() => service.Stats.FramesWritten == 2);
+        await service.StopAsync();
+
+        // A full 8 MB key frame, none of it through a managed array
+        Assert.Equal(2 * 1920 * 1080 * 4L, service.Stats.BytesWritten);
+        Assert.InRange(service.Stats.AllocatedBytes - allocatedBefore, 0, 64 * 1024);
+    }
+
+    [Fact]
+    public async Task FrameStreamingServiceReusesCompressionBuffers()
+    {
+        var logger = new TestLogger { MinimumLevel = LogLevel.Info };
+        var windowTracker = new WindowTracker(logger);
+        var source = new SyntheticCaptureSource(1920, 1080);
+        var outboundChannel = Channel.CreateUnbounded<GuestMessage>();
+        var config = new FrameStreamingConfig
+        {
+            EnablePerWindowCapture = false,
+            TargetFps = 60,
+            BufferMode = FrameBufferMode.Compressed,
+            Compression = new FrameCompressionConfig()
+        };
+
+        using var service = new FrameStreamingService(logger, windowTracker, source, outboundChannel, config);
+        service.Start();
+
+        // The first frame sizes the scratch buffers
+        await WaitForAsync(() => service.Stats.FramesCompressed == 1 && service.Stats.AverageFrameTime > TimeSpan.Zero);
+        var allocatedBefore = service.Stats.AllocatedBytes;
+
+        // Nothing reads the ring here, so once its two free slots are used
+        // later frames are dropped before they are compressed
+        for (var i = 1; i <= 5; i++)
+        {
+            source.Fill(new Rect(i * 10, 0, 10, 1080), 0xFF000000 | (uint)i);
+            await WaitForAsync(() => service.Stats.FramesCompressed + service.Stats.BufferFullCount == i + 1);
+        }
+
+        await service.StopAsync();
+
+        Assert.Equal(2, service.Stats.FramesCompressed);
+        Assert.Equal(4, service.Stats.BufferFullCount);
+
+        // The old path allocated a crop and two compression arrays per frame;
+        // five frames now allocate less than one frame's worth
+        Assert.InRange(service.Stats.AllocatedBytes - allocatedBefore, 0, 1920 * 1080 * 4);
+    }
+
+    [Fact]
+    public async Task FrameStreamingServiceWritesWindowsInParallel()
+    {
+        var logger = new TestLogger { MinimumLevel = LogLevel.Info };
+        var windowTracker = new WindowTracker(logger);
+        for (var i = 0; i < 10; i++)
+        {
+            windowTracker.AddTrackedWindow(new WindowMetadata(
+                Hwnd: 100 + i, Title: $"Window {i}", Bounds: new Rect(i * 60, i * 40, 320, 240),
+                ProcessId: 1, ClassName: "Test", IsMinimized: false));
+        }
+
+        var source = new SyntheticCaptureSource(1280, 720);
+        var outboundChannel = Channel.CreateUnbounded<GuestMessage>();
+        var config = new FrameStreamingConfig
+        {
+            TargetFps = 60,
+            MinWindowFrameIntervalMs = 0,
+            MaxParallelWindows = 4,
+            BufferMode = FrameBufferMode.Compressed,
+            Compression = new FrameCompressionConfig()
+        };
+
+        using var service = new FrameStreamingService(logger, windowTracker, source, outboundChannel, config);
+        service.Start();
+
+        await WaitForAsync(() => service.Stats.FramesWritten == 10);
+        source.Fill(new Rect(0, 0, 1280, 720), 0xFF336699);
+        await WaitForAsync(() => service.Stats.FramesWritten == 20);
+        await service.StopAsync();
+
+        var frames = new List<FrameReadyMessage>();
+        while (outboundChannel.Reader.TryRead(out var message))
+        {
+            if (message is FrameReadyMessage frameReady)
+            {
+                frames.Add(frameReady);
+            }
+        }
+
+        // Notifications interleave across windows, but each window's frames stay in order
+        Assert.Equal(20, frames.Select(f => f.FrameNumber).Distinct().Count());
+        foreach (var window in frames.GroupBy(f => f.WindowId))
+        {
+            var numbers = window.Select(f => f.FrameNumber).ToList();
+            Assert.Equal(2, numbers.Count);
+            Assert.True(numbers[0] < numbers[1]);
+            Assert.Equal([0u, 1u], window.Select(f => f.SlotIndex));
+        }
+
+        Assert.True(service.Stats.AverageEncodeTime > TimeSpan.Zero);
+        Assert.True(service.Stats.AverageNotifyTime > TimeSpan.Zero);
+        Assert.True(service.Stats.AverageFrameTime > TimeSpan.Zero);
+    }
+
+    [Fact]
+    public async Task FrameStreamingServiceHalvesWindowsWhenDownscaling()
+    {
+        var logger = new TestLogger { MinimumLevel = LogLevel.Info };
+        var windowTracker = new WindowTracker(logger);
+        windowTracker.AddTrackedWindow(new WindowMetadata(
+            Hwnd: 100, Title: "Window", Bounds: new Rect(10, 10, 321, 240),
+            ProcessId: 1, ClassName: "Test", IsMinimized: false));
+
+        var source = new SyntheticCaptureSource(640, 480);
+        var outboundChannel = Channel.CreateUnbounded<GuestMessage>();
+        var config = new FrameStreamingConfig { TargetFps = 60, MinWindowFrameIntervalMs = 0, DownscaleWindows = true };
+
+        using var service = new FrameStreamingService(logger, windowTracker, source, outboundChannel, config);
+        service.Start();
+
+        await WaitForAsync(() => service.Stats.FramesWritten == 1);
+        source.Fill(new Rect(20, 20, 8, 16), 0xFF000000);
+        await WaitForAsync(() => service.Stats.FramesWritten == 2);
+        await service.StopAsync();
+
+        // Both frames are whole 160x120 windows; damage isn't scaled
+        Assert.Equal(2 * 160 * 120 * 4, service.Stats.BytesWritten);
+        Assert.Equal(0, service.Stats.DamageFramesWritten);
+
+        WindowBufferAllocatedMessage? allocation = null;
+        while (outboundChannel.Reader.TryRead(out var message))
+        {
+            allocation ??= message as WindowBufferAllocatedMessage;
+        }
+
+        Assert.Equal(FrameSlotHeader.Size + (160 * 120 * 4), allocation?.SlotSize);
+    }
+
+    [Fact]
+    public async Task FrameStreamingServicePipelinedCaptureKeepsDamageInOrder()
+    {
+        var logger = new TestLogger { MinimumLevel = LogLevel.Info };
+        var windowTracker = new WindowTracker(logger);
+        var source = new SyntheticCaptureSource(256, 256);
+        var outboundChannel = Channel.CreateUnbounded<GuestMessage>();
+        var config = new FrameStreamingConfig { EnablePerWindowCapture = false, TargetFps = 60, PipelineCapture = true };
+
+        using var service = new FrameStreamingService(logger, windowTracker, source, outboundChannel, config);
+        service.Start();
+
+        await WaitForAsync(() => service.Stats.FramesWritten == 1);
+        source.Fill(new Rect(0, 0, 16, 16), 0xFFFFFFFF);
+        await WaitForAsync(() => service.Stats.FramesWritten == 2);
+        await service.StopAsync();
+
+        var frames = new List<FrameReadyMessage>();
+        while (outboundChannel.Reader.TryRead(out var message))
+        {
+            if (message is FrameReadyMessage frameReady)
+            {
+                frames.Add(frameReady);
+            }
+        }
+
+        Assert.Equal(2, frames.Count);
+        Assert.True(frames[0].IsKeyFrame);
+        Assert.False(frames[1].IsKeyFrame);
+        Assert.True(service.Stats.AverageCaptureTime > TimeSpan.Zero);
+    }
+
+    [Fact]
+    public async Task FrameStreamingServiceSkipsUnchangedFrames()
+    {
+        var logger = new TestLogger();
+        var windowTracker = new WindowTracker(logger);
+        var source = new SyntheticCaptureSource(64, 64);
+        var outboundChannel = Channel.CreateUnbounded<GuestMessage>();
+        var config = new FrameStreamingConfig { EnablePerWindowCapture = false, TargetFps = 60 };
+
+        using var service = new FrameStreamingService(logger, windowTracker, source, outboundChannel, config);
+        service.Start();
+
+        await WaitForAsync(() => service.Stats.FramesWritten == 1);
+
+        // A frame where only the pointer moved
+        source.Present();
+        await WaitForAsync(() => source.CaptureCount == 2);
+        await WaitForAsync(() => service.Stats.WindowsUnchanged == 1);
+
+        Assert.Equal(1, service.Stats.FramesWritten);
+        await service.StopAsync();
+    }
+
+    [Fact]
+    public async Task FrameStreamingServiceSendsKeyFramesWithoutDamage()
+    {
+        var logger = new TestLogger();
+        var windowTracker = new WindowTracker(logger);
+        var source = new SyntheticCaptureSource(64, 64) { ReportsDamage = false };
+        var outboundChannel = Channel.CreateUnbounded<GuestMessage>();
+        var config = new FrameStreamingConfig { EnablePerWindowCapture = false, TargetFps = 60 };
+
+        using var service = new FrameStreamingService(logger, windowTracker, source, outboundChannel, config);
+        service.Start();
+
+        await WaitForAsync(() => service.Stats.FramesWritten == 1);
+        source.Fill(new Rect(0, 0, 1, 1), 0xFFFFFFFF);
+        await WaitForAsync(() => service.Stats.FramesWritten == 2);
+
+        Assert.Equal(0, service.Stats.DamageFramesWritten);
+        Assert.Equal(2 * 64 * 64 * 4, service.Stats.BytesWritten);
+        await service.StopAsync();
+    }
+
+    [Fact]
+    public async Task FrameStreamingServiceIdlesUntilTheHostShowsAWindow()
+    {
+        var logger = new TestLogger { MinimumLevel = LogLevel.Info };
+        var windowTracker = new WindowTracker(logger);
+        windowTracker.AddTrackedWindow(new WindowMetadata(
+            Hwnd: 42, Title: "Hidden", Bounds: new Rect(0, 0, 64, 64),
+            ProcessId: 1, ClassName: "Test", IsMinimized: false));
+
+        var source = new SyntheticCaptureSource(128, 128);
+        var outboundChannel = Channel.CreateUnbounded<GuestMessage>();
+
+        // Long enough that only the throttle hint can wake the loop in time
+        var config = new FrameStreamingConfig { IdleDemandCheckMs = 60_000 };
+
+        using var service = new FrameStreamingService(logger, windowTracker, source, outboundChannel, config);
+        service.SetWindowThrottle(42, StreamVisibility.Hidden, 0);
+        service.Start();
+
+        await WaitForAsync(() => service.Stats.IdleWaits > 0);
+        Assert.Equal(0, service.Stats.CaptureAttempts);
+        Assert.Equal(0, source.CaptureCount);
+
+        service.SetWindowThrottle(42, StreamVisibility.Visible, 0);
+        await WaitForAsync(() => service.Stats.FramesWritten == 1);
+        await service.StopAsync();
+
+        Assert.Equal(1, source.CaptureCount);
+    }
+
+    [Fact]
+    public void CaptureIntervalFollowsTheMostDemandingWindow()
+    {
+        var logger = new TestLogger();
+        var windowTracker = new WindowTracker(logger);
+        windowTracker.AddTrackedWindow(new WindowMetadata(
+            Hwnd: 1, Title: "Background", Bounds: new Rect(0, 0, 64, 64),
+            ProcessId: 1, ClassName: "Test", IsMinimized: false));
+        windowTracker.AddTrackedWindow(new WindowMetadata(
+            Hwnd: 2, Title: "Minimized", Bounds: new Rect(0, 0, 64, 64),
+            ProcessId: 1, ClassName: "Test", IsMinimized: true));
+        var config = new FrameStreamingConfig { TargetFps = 30, BackgroundMaxFps = 2 };
+
+        using var service = new FrameStreamingService(
+            logger, windowTracker, new SyntheticCaptureSource(64, 64), Channel.CreateUnbounded<GuestMessage>(), config);
+
+        // A minimized window never counts, so only the background window sets the pace
+        service.SetWindowThrottle(1, StreamVisibility.Background, 0);
+        Assert.True(service.TryGetCaptureInterval(out var interval));
+        Assert.Equal(TimeSpan.FromMilliseconds(500), interval);
+
+        service.SetWindowThrottle(1, StreamVisibility.Visible, 0);
+        Assert.True(service.TryGetCaptureInterval(out interval));
+        Assert.Equal(TimeSpan.FromMilliseconds(config.TargetFrameIntervalMs), interval);
+
+        service.SetWindowThrottle(1, StreamVisibility.Hidden, 0);
+        Assert.False(service.TryGetCaptureInterval(out _));
+    }
+
+    [Fact]
+    public void FocusedWindowRunsTheLoopAboveTheTargetRate()
+    {
+        var logger = new TestLogger();
+        var windowTracker = new WindowTracker(logger);
+        windowTracker.AddTrackedWindow(new WindowMetadata(
+            Hwnd: 1, Title: "Video", Bounds: new Rect(0, 0, 64, 64),
+            ProcessId: 1, ClassName: "Test", IsMinimized: false));
+        var config = new FrameStreamingConfig { TargetFps = 30, FocusedMaxFps = 60 };
+
+        using var service = new FrameStreamingService(
+            logger, windowTracker, new SyntheticCaptureSource(64, 64), Channel.CreateUnbounded<GuestMessage>(), config);
+
+        service.SetWindowThrottle(1, StreamVisibility.Visible, 0, isFocused: true);
+        Assert.True(service.TryGetCaptureInterval(out var interval));
+        Assert.Equal(TimeSpan.FromMilliseconds(16), interval);
+
+        var now = DateTime.UtcNow;
+        service.UpdateWindowFrameState(1, now);
+        Assert.True(service.ShouldCaptureWindow(1, now.AddMilliseconds(20)));
+
+        // Losing focus puts it back on the normal interval
+        service.SetWindowThrottle(1, StreamVisibility.Visible, 0);
+        Assert.True(service.TryGetCaptureInterval(out interval));
+        Assert.Equal(TimeSpan.FromMilliseconds(config.TargetFrameIntervalMs), interval);
+        Assert.False(service.ShouldCaptureWindow(1, now.AddMilliseconds(20)));
+    }
+
+    [Fact]
+    public void HostDecodeTimeIsKeptPerWindow()
+    {
+        var logger = new TestLogger();
+        var windowTracker = new WindowTracker(logger);
+        var desktopDuplication = new DesktopDuplicationBridge(logger);
+        var outboundChannel = Channel.CreateUnbounded<GuestMessage>();
+
+        using var service = new FrameStreamingService(
+            logger,
+            windowTracker,
+            desktopDuplication,
+            outboundChannel);
+
+        Assert.Equal(TimeSpan.Zero, service.GetHostDecodeTime(1));
+        service.SetHostDecodeTime(1, TimeSpan.FromMicroseconds(1500));
+        Assert.Equal(TimeSpan.FromMicroseconds(1500), service.GetHostDecodeTime(1));
+        Assert.Equal(TimeSpan.Zero, service.GetHostDecodeTime(2));
+
+        // Throttle hints without a decode time leave it alone
+        service.SetWindowThrottle(1, StreamVisibility.Background, 0);
+        Assert.Equal(TimeSpan.FromMicroseconds(1500), service.GetHostDecodeTime(1));
+    }
+
+    [Fact]
+    public void HostBacklogSlowsTheWindowDown()
+    {
+        var logger = new TestLogger();
+        var windowTracker = new WindowTracker(logger);
+        using var service = new FrameStreamingService(
+            logger, windowTracker, new SyntheticCaptureSource(64, 64), Channel.CreateUnbounded<GuestMessage>());
+
+        service.SetWindowThrottle(1, StreamVisibility.Visible, 30);
+        var now = DateTime.UtcNow;
+        service.UpdateWindowFrameState(1, now);
+        Assert.True(service.ShouldCaptureWindow(1, now.AddMilliseconds(40)));
+
+        // Skipped frames on the host halve the rate to 15 fps
+        service.ObserveHostBacklog(1);
+        Assert.False(service.ShouldCaptureWindow(1, now.AddMilliseconds(40)));
+        Assert.True(service.ShouldCaptureWindow(1, now.AddMilliseconds(70)));
+    }
+
+    [Fact]
+    public async Task FrameStreamingServiceSendsASkippedWindowsLastChange()
+    {
+        var logger = new TestLogger { MinimumLevel = LogLevel.Info };
+        var windowTracker = new WindowTracker(logger);
+        windowTracker.AddTrackedWindow(new WindowMetadata(
+            Hwnd: 9, Title: "Background", Bounds: new Rect(0, 0, 128, 128),
+            ProcessId: 1, ClassName: "Test", IsMinimized: false));
+
+        var source = new SyntheticCaptureSource(128, 128);
+        var outboundChannel = Channel.CreateUnbounded<GuestMessage>();
+
+        using var service = new FrameStreamingService(logger, windowTracker, source, outboundChannel);
+        service.SetWindowThrottle(9, StreamVisibility.Background, 5);
+        service.Start();
+
+        await WaitForAsync(() => service.Stats.FramesWritten == 1);
+
+        // Arrives before the window is due, and nothing changes after it
+        source.Fill(new Rect(10, 10, 4, 4), 0xFFFFFFFF);
+        await WaitForAsync(() => service.Stats.FramesWritten == 2);
+        await service.StopAsync();
+
+        Assert.Equal(2, source.CaptureCount);
+        Assert.Equal(1, service.Stats.DamageFramesWritten);
+
+        var frames = new List<FrameReadyMessage>();
+        while (outboundChannel.Reader.TryRead(out var message))
+        {
+            if (message is FrameReadyMessage frameReady)
+            {
+                frames.Add(frameReady);
+            }
+        }
+
+        // Each frame carries the governor's decision for the host's stats
+        Assert.All(frames, f => Assert.InRange(f.TargetFps ?? 0, 1, 5));
+        Assert.All(frames, f => Assert.NotNull(f.RateReason));
+    }
+
+    [Fact]
+    public async Task FramePacerWaitsOnlyForTheRestOfTheInterval()
+    {
+        using var pacer = new FramePacer(useHighResolutionTimer: false);
+        var interval = TimeSpan.FromMilliseconds(20);
+
+        var start = Stopwatch.GetTimestamp();
+        for (var i = 0; i < 5; i++)
+        {
+            _ = await pacer.WaitAsync(interval, CancellationToken.None);
+        }
+
+        Assert.True(Stopwatch.GetElapsedTime(start) >= TimeSpan.FromMilliseconds(80));
+
+        // Work that already took longer than the interval starts the next one at once
+        await Task.Delay(30);
+        Assert.Equal(TimeSpan.Zero, await pacer.WaitAsync(interval, CancellationToken.None));
+    }
+
+    private static async Task WaitForAsync(Func<bool> condition)
+    {
+        for (var i = 0; i < 200 && !condition(); i++)
+        {
+            await Task.Delay(10);
+        }
+
+        Assert.True(condition());
+    }
+
     [Fact]
     public void FrameStreamingServiceWithSharedMemoryUncompressedMode()
     {
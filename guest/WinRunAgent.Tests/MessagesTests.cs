@@ -630,6 +630,65 @@ public sealed class MessagesTests
         Assert.Equal(DragOperation.Copy, msg.SelectedOperation);
     }
 
+    [Fact]
+    public void DeserializeSetWindowThrottleMessage()
+    {
+        var throttle = new SetWindowThrottleMessage
+        {
+            MessageId = 700,
+            WindowId = 22222,
+            Visibility = StreamVisibility.Background,
+            MaxFps = 5,
+            IsFocused = true,
+            HostDecodeUs = 1500,
+            HostSkippedFrames = 3
+        };
+
+        // Host encodes Visibility as its raw integer value
+        var bytes = SerializeHostMessage(SpiceMessageType.SetWindowThrottle, throttle);
+        var result = SpiceMessageSerializer.Deserialize(bytes);
+
+        Assert.NotNull(result);
+        var msg = Assert.IsType<SetWindowThrottleMessage>(result);
+        Assert.Equal(700u, msg.MessageId);
+        Assert.Equal(22222UL, msg.WindowId);
+        Assert.Equal(StreamVisibility.Background, msg.Visibility);
+        Assert.Equal(5, msg.MaxFps);
+        Assert.True(msg.IsFocused);
+        Assert.Equal(1500, msg.HostDecodeUs);
+        Assert.Equal(3, msg.HostSkippedFrames);
+    }
+
+    [Fact]
+    public void DeserializePingMessage()
+    {
+        var ping = new PingMessage
+        {
+            MessageId = 0,
+            Sequence = 41,
+            SentAt = 1_700_000_000_123_456
+        };
+
+        var bytes = SerializeHostMessage(SpiceMessageType.Ping, ping);
+        var result = SpiceMessageSerializer.Deserialize(bytes);
+
+        var msg = Assert.IsType<PingMessage>(result);
+        Assert.Equal(41u, msg.Sequence);
+        Assert.Equal(1_700_000_000_123_456, msg.SentAt);
+    }
+
+    [Fact]
+    public void SerializeHeartbeatEchoesPingOnlyWhenAnswering()
+    {
+        var periodic = System.Text.Encoding.UTF8.GetString(SpiceMessageSerializer.Serialize(new HeartbeatMessage { UptimeMs = 5 }).AsSpan(5));
+        Assert.DoesNotContain("pingSequence", periodic);
+
+        var reply = new HeartbeatMessage { UptimeMs = 5, PingSequence = 41, PingSentAt = 123456 };
+        var json = System.Text.Encoding.UTF8.GetString(SpiceMessageSerializer.Serialize(reply).AsSpan(5));
+        Assert.Contains("\"pingSequence\":41", json);
+        Assert.Contains("\"pingSentAt\":123456", json);
+    }
+
     [Fact]
     public void DeserializeReturnsNullForUnknownMessageType()
     {
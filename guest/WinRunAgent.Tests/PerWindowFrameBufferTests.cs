@@ -1,3 +1,4 @@
+using System.Buffers;
 using WinRun.Agent.Services;
 using Xunit;
 
@@ -21,6 +22,8 @@ public sealed class PerWindowFrameBufferTests
         Assert.Equal(3, config.SlotsPerWindow);
         Assert.Equal(4, config.BytesPerPixel);
         Assert.Equal(1.0, config.ExactAllocationHeadroom);
+        Assert.True(config.ResizeHeadroom > 1.0);
+        Assert.InRange(config.ResizeShrinkRatio, 0.0, 1.0 / config.ResizeHeadroom);
         Assert.NotEmpty(config.CompressedTranches);
     }
 
@@ -106,6 +109,72 @@ public sealed class PerWindowFrameBufferTests
         Assert.True(buffer.BufferSize > size1080p);
     }
 
+    [Fact]
+    public void WindowFrameBufferAbsorbsResizesWithinHeadroom()
+    {
+        var logger = new TestLogger();
+        var config = new PerWindowBufferConfig();
+
+        using var buffer = new WindowFrameBuffer(1, config, logger);
+
+        // The first allocation is exact
+        Assert.True(buffer.EnsureAllocated(800, 600, 800 * 600 * 4));
+        Assert.Equal(FrameSlotHeader.Size + (800 * 600 * 4), buffer.SlotSize);
+
+        // Growing reallocates once, with room to keep growing
+        Assert.True(buffer.EnsureAllocated(810, 608, 810 * 608 * 4));
+        var slotSize = buffer.SlotSize;
+        Assert.True(slotSize >= FrameSlotHeader.Size + (810 * 608 * 4 * 3 / 2));
+
+        // A live resize inside that room, larger and smaller, keeps the buffer
+        for (var step = 0; step < 20; step++)
+        {
+            var width = 820 + (step % 5 * 40);
+            var height = 610 + (step % 4 * 30);
+            Assert.False(buffer.EnsureAllocated(width, height, width * height * 4));
+        }
+
+        Assert.Equal(slotSize, buffer.SlotSize);
+        Assert.Equal(2, buffer.AllocationCount);
+        Assert.Equal(20, buffer.ResizesInPlace);
+
+        // Frames written after a resize carry their own geometry
+        var header = new FrameSlotHeader { WindowId = 1, Width = 900, Height = 700, Stride = 900 * 4 };
+        Assert.Equal(0, buffer.WriteFrame(header, new byte[900 * 700 * 4]));
+    }
+
+    [Fact]
+    public void WindowFrameBufferShrinksOnlyPastTheShrinkRatio()
+    {
+        var logger = new TestLogger();
+        var config = new PerWindowBufferConfig();
+
+        using var buffer = new WindowFrameBuffer(1, config, logger);
+        _ = buffer.EnsureAllocated(1000, 1000, 1000 * 1000 * 4);
+        var slotSize = buffer.SlotSize;
+
+        // Half the area still uses a fair share of the slot
+        Assert.False(buffer.EnsureAllocated(1000, 500, 1000 * 500 * 4));
+        Assert.Equal(slotSize, buffer.SlotSize);
+
+        // A tenth doesn't
+        Assert.True(buffer.EnsureAllocated(1000, 100, 1000 * 100 * 4));
+        Assert.True(buffer.SlotSize < slotSize / 4);
+    }
+
+    [Theory]
+    [InlineData(100, 150)]
+    [InlineData(5000, 8192)]
+    [InlineData(1_000_036, 1_572_864)]
+    [InlineData(8_294_436, 12_582_912)]
+    public void ResizeSlotSizeRoundsUpToSizeClasses(int required, int expected)
+    {
+        var slotSize = WindowFrameBuffer.ResizeSlotSize(required, 1.5);
+
+        Assert.Equal(expected, slotSize);
+        Assert.True(slotSize >= required * 1.5);
+    }
+
     [Fact]
     public void WindowFrameBufferCompressedModeUsesTransches()
     {
@@ -158,6 +227,129 @@ public sealed class PerWindowFrameBufferTests
         Assert.Equal(0, slotIndex);
     }
 
+    [Fact]
+    public unsafe void WindowFrameBufferWritesFrameInPlace()
+    {
+        var logger = new TestLogger();
+        var config = new PerWindowBufferConfig();
+
+        using var buffer = new WindowFrameBuffer(1, config, logger);
+        _ = buffer.EnsureAllocated(16, 16, 16 * 16 * 4);
+
+        var header = new FrameSlotHeader
+        {
+            WindowId = 1,
+            FrameNumber = 7,
+            Width = 16,
+            Height = 16,
+            Stride = 64,
+            DataSize = 16 * 16 * 4,
+            Flags = FrameSlotFlags.KeyFrame
+        };
+
+        var slotIndex = buffer.WriteFrame(header, (byte)0x5A, static (slot, value) => slot.Fill(value));
+
+        Assert.Equal(0, slotIndex);
+        var slot = new ReadOnlySpan<byte>((void*)buffer.GetBufferPointer(), buffer.SlotSize);
+        Assert.Equal(7u, BitConverter.ToUInt32(slot[8..]));
+        Assert.Equal(16 * 16 * 4, BitConverter.ToInt32(slot[28..]));
+        Assert.True(slot.Slice(FrameSlotHeader.Size, 16 * 16 * 4).IndexOfAnyExcept((byte)0x5A) < 0);
+    }
+
+    [Fact]
+    public void WindowFrameBufferWriteDoesNotAllocate()
+    {
+        var logger = new TestLogger();
+        var config = new PerWindowBufferConfig();
+
+        using var buffer = new WindowFrameBuffer(1, config, logger);
+        _ = buffer.EnsureAllocated(64, 64, 64 * 64 * 4);
+
+        var header = new FrameSlotHeader { WindowId = 1, Width = 64, Height = 64, Stride = 256, DataSize = 64 * 64 * 4 };
+        var data = new byte[64 * 64 * 4];
+        SpanAction<byte, byte> fill = static (slot, value) => slot.Fill(value);
+
+        // Warm up so JIT and first-use costs aren't counted
+        _ = buffer.WriteFrame(header, data);
+        _ = buffer.WriteFrame(header, (byte)1, fill);
+        buffer.AdvanceReadIndex();
+        buffer.AdvanceReadIndex();
+
+        var before = GC.GetAllocatedBytesForCurrentThread();
+        for (var i = 0; i < 100; i++)
+        {
+            _ = buffer.WriteFrame(header, data);
+            _ = buffer.WriteFrame(header, (byte)i, fill);
+            buffer.AdvanceReadIndex();
+            buffer.AdvanceReadIndex();
+        }
+
+        Assert.Equal(0, GC.GetAllocatedBytesForCurrentThread() - before);
+    }
+
+    [Fact]
+    public unsafe void WindowFrameBufferCommitsFewerBytesThanReserved()
+    {
+        var logger = new TestLogger();
+        var config = new PerWindowBufferConfig();
+
+        using var buffer = new WindowFrameBuffer(1, config, logger);
+        _ = buffer.EnsureAllocated(16, 16, 16 * 16 * 4);
+
+        Assert.True(buffer.TryReserveSlot(buffer.SlotCapacity, out var reservation));
+        Assert.Equal(buffer.SlotCapacity, reservation.Data.Length);
+        reservation.Data[..100].Fill(0x33);
+
+        var header = new FrameSlotHeader { WindowId = 1, FrameNumber = 3, DataSize = 100, Flags = FrameSlotFlags.Compressed };
+        Assert.Equal(0, buffer.CommitSlot(reservation, header));
+
+        var slot = new ReadOnlySpan<byte>((void*)buffer.GetBufferPointer(), buffer.SlotSize);
+        Assert.Equal(100, BitConverter.ToInt32(slot[28..]));
+        Assert.True(slot.Slice(FrameSlotHeader.Size, 100).IndexOfAnyExcept((byte)0x33) < 0);
+
+        // The next reservation is the next slot
+        Assert.True(buffer.TryReserveSlot(100, out var next));
+        Assert.Equal(1, next.SlotIndex);
+    }
+
+    [Fact]
+    public void WindowFrameBufferRejectsStaleReservation()
+    {
+        var logger = new TestLogger();
+        var config = new PerWindowBufferConfig { Mode = FrameBufferMode.Compressed };
+
+        using var buffer = new WindowFrameBuffer(1, config, logger);
+        _ = buffer.EnsureAllocated(100, 100, 1000);
+        Assert.True(buffer.TryReserveSlot(1000, out var reservation));
+
+        // Growing to a bigger tranche frees the reserved slot's memory
+        Assert.True(buffer.EnsureAllocated(100, 100, buffer.SlotCapacity + 1));
+
+        var header = new FrameSlotHeader { WindowId = 1, DataSize = 1000 };
+        _ = Assert.Throws<InvalidOperationException>(() => buffer.CommitSlot(reservation, header));
+    }
+
+    [Fact]
+    public void WindowFrameBufferReserveFailsWhenFullOrTooLarge()
+    {
+        var logger = new TestLogger();
+        var config = new PerWindowBufferConfig { SlotsPerWindow = 3 };
+
+        using var buffer = new WindowFrameBuffer(1, config, logger);
+        _ = buffer.EnsureAllocated(10, 10, 400);
+
+        Assert.False(buffer.TryReserveSlot(buffer.SlotCapacity + 1, out _));
+
+        var header = new FrameSlotHeader { WindowId = 1, DataSize = 10 };
+        for (var i = 0; i < 2; i++)
+        {
+            Assert.True(buffer.TryReserveSlot(10, out var reservation));
+            _ = buffer.CommitSlot(reservation, header);
+        }
+
+        Assert.False(buffer.TryReserveSlot(10, out _));
+    }
+
     [Fact]
     public void WindowFrameBufferWriteFrameRotatesSlots()
     {
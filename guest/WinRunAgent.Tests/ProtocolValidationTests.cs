@@ -129,6 +129,7 @@ public sealed class ProtocolValidationTests
             SpiceMessageType.KeyboardInput, SpiceMessageType.DragDropEvent,
             SpiceMessageType.ConfigureStreaming, SpiceMessageType.ListSessions,
             SpiceMessageType.CloseSession, SpiceMessageType.ListShortcuts,
+            SpiceMessageType.SetWindowThrottle, SpiceMessageType.Ping,
             SpiceMessageType.Shutdown
         };
 
@@ -245,7 +246,7 @@ public sealed class ProtocolValidationTests
     public void AllMessageTypesExist()
     {
         var allValues = Enum.GetValues<SpiceMessageType>();
-        Assert.Equal(29, allValues.Length); // Includes ConfigureStreaming (0x07), FrameReady (0x8E), WindowBufferAllocated (0x8F)
+        Assert.Equal(31, allValues.Length); // Includes ConfigureStreaming (0x07), SetWindowThrottle (0x0B), Ping (0x0C), FrameReady (0x8E), WindowBufferAllocated (0x8F)
 
         // Verify no duplicate raw values
         var rawValues = allValues.Select(v => (byte)v).ToList();
@@ -282,6 +282,118 @@ public sealed class SharedMemoryAllocatorTests : IDisposable
         Assert.False(allocation.IsValid);
     }
 
+    [Fact]
+    public void SharedMemoryStatsReportsFragmentation()
+    {
+        var stats = new SharedMemoryStats
+        {
+            FreeBytes = 4 * 1024 * 1024,
+            LargestFreeBlockBytes = 1024 * 1024,
+            IsInitialized = true
+        };
+
+        Assert.Equal(0.75, stats.Fragmentation, 3);
+        Assert.Equal(0, new SharedMemoryStats().Fragmentation);
+    }
+
+    [Fact]
+    public void BuddyAllocatorTrimsAllocationsToWholePages()
+    {
+        var blocks = new SharedMemoryBuddyAllocator(1024 * 1024);
+        var initial = blocks.GetStats();
+        Assert.Equal((1024 * 1024) - 4096, initial.TotalFree);
+        Assert.Equal(512 * 1024, initial.LargestFreeBlock);
+
+        // Five pages come out of an eight-page block; the other three go back
+        var offset = blocks.Allocate((4 * 4096) + 100);
+        Assert.True(offset > 0);
+        Assert.Equal(0, offset % SharedMemoryBuddyAllocator.PageSize);
+
+        var stats = blocks.GetStats();
+        Assert.Equal(initial.TotalFree - (5 * 4096), stats.TotalFree);
+        Assert.Equal(5 * 4096, stats.AllocatedBytes);
+        Assert.Equal((4 * 4096) + 100, stats.RequestedBytes);
+        Assert.Equal(1, stats.AllocationCount);
+    }
+
+    [Fact]
+    public void BuddyAllocatorCoalescesAfterResizeStorm()
+    {
+        var blocks = new SharedMemoryBuddyAllocator(8 * 1024 * 1024);
+        var initial = blocks.GetStats();
+
+        // Three windows resizing in lockstep: each new buffer is allocated
+        // before the old one is freed, as EnsureAllocated does
+        var live = new (long Offset, int Size)[3];
+        for (var step = 0; step < 200; step++)
+        {
+            var window = step % 3;
+            var size = ((step * 7919) % 300 * 1024) + 1000;
+            var offset = blocks.Allocate(size);
+            Assert.True(offset > 0, $"step {step}: {size} bytes");
+
+            if (live[window].Size > 0)
+            {
+                Assert.True(blocks.Free(live[window].Offset, live[window].Size));
+            }
+            live[window] = (offset, size);
+        }
+
+        foreach (var (offset, size) in live)
+        {
+            Assert.True(blocks.Free(offset, size));
+        }
+
+        var after = blocks.GetStats();
+        Assert.Equal(initial.TotalFree, after.TotalFree);
+        Assert.Equal(initial.FreeBlockCount, after.FreeBlockCount);
+        Assert.Equal(initial.LargestFreeBlock, after.LargestFreeBlock);
+        Assert.Equal(0, after.AllocationCount);
+        Assert.Equal(0, after.RequestedBytes);
+    }
+
+    [Fact]
+    public void BuddyAllocatorReusesFreedBlockForSameSize()
+    {
+        var blocks = new SharedMemoryBuddyAllocator(4 * 1024 * 1024);
+        var keep = blocks.Allocate(100 * 1024);
+        var first = blocks.Allocate(300 * 1024);
+
+        Assert.True(blocks.Free(first, 300 * 1024));
+        Assert.Equal(first, blocks.Allocate(300 * 1024));
+        Assert.NotEqual(keep, first);
+    }
+
+    [Fact]
+    public void BuddyAllocatorRejectsUnknownAndRepeatedFrees()
+    {
+        var blocks = new SharedMemoryBuddyAllocator(1024 * 1024);
+        var offset = blocks.Allocate(8192);
+
+        Assert.False(blocks.Free(offset + 4096, 4096));
+        Assert.False(blocks.Free(offset + 1, 8192));
+        Assert.False(blocks.Free(-4096, 8192));
+        Assert.False(blocks.Free(1024 * 1024, 8192));
+        Assert.True(blocks.Free(offset, 8192));
+        Assert.False(blocks.Free(offset, 8192));
+
+        var stats = blocks.GetStats();
+        Assert.Equal((1024 * 1024) - 4096, stats.TotalFree);
+        Assert.Equal(0, stats.AllocationCount);
+    }
+
+    [Fact]
+    public void BuddyAllocatorCountsFailedAllocations()
+    {
+        var blocks = new SharedMemoryBuddyAllocator(1024 * 1024);
+
+        // The region is 1 MB less the header, so its largest block is 512 KB
+        Assert.Equal(-1, blocks.Allocate(600 * 1024));
+        Assert.True(blocks.Allocate(512 * 1024) > 0);
+        Assert.Equal(-1, blocks.Allocate(512 * 1024));
+        Assert.Equal(2, blocks.GetStats().FailedAllocations);
+    }
+
     [Fact]
     public void AllocatorCanWriteAndReadData()
     {
@@ -42,6 +42,8 @@ public enum SpiceMessageType : byte
     ListSessions = 0x08,
     CloseSession = 0x09,
     ListShortcuts = 0x0A,
+    SetWindowThrottle = 0x0B,
+    Ping = 0x0C,
     Shutdown = 0x0F,
 
     // Guest → Host (0x80-0xFF)
@@ -263,6 +265,8 @@ public enum GeneratedMessageType : byte
     ListSessions = 0x08,
     CloseSession = 0x09,
     ListShortcuts = 0x0A,
+    SetWindowThrottle = 0x0B,
+    Ping = 0x0C,
     Shutdown = 0x0F,
     WindowMetadata = 0x80,
     FrameData = 0x81,
@@ -6,7 +6,7 @@ namespace WinRun.Agent.Services;
 /// Bridge for capturing desktop/window content using DXGI Desktop Duplication API.
 /// Provides efficient screen capture for streaming window frames to the host.
 /// </summary>
-public sealed class DesktopDuplicationBridge : IDisposable
+public sealed class DesktopDuplicationBridge : IFrameCaptureSource, IDisposable
 {
     private readonly IAgentLogger _logger;
     private nint _device;
@@ -15,6 +15,16 @@ public sealed class DesktopDuplicationBridge : IDisposable
     private nint _stagingTexture;
     private bool _disposed;
 
+    // Desktop pixels as of the last capture. Frames with damage metadata only
+    // refresh the damaged rows, so CapturedFrame.Data is this same array.
+    // Captures alternate with a spare copy so the previous frame stays intact
+    // while it is being written out; the spare is behind by the damage of the
+    // frame that replaced it (null if unknown).
+    private byte[]? _desktopPixels;
+    private byte[]? _spareDesktopPixels;
+    private FrameDamage? _spareStaleDamage;
+    private byte[] _metadataBuffer = [];
+
     public DesktopDuplicationBridge(IAgentLogger logger)
     {
         _logger = logger;
@@ -184,6 +194,8 @@ public sealed class DesktopDuplicationBridge : IDisposable
 
     /// <summary>
     /// Captures a single frame from the desktop.
+    /// The returned data stays valid until the capture after next, so a frame can
+    /// be written out while the next one is captured; copy it to keep it longer.
     /// </summary>
     /// <param name="timeout">Timeout in milliseconds to wait for a new frame.</param>
     /// <returns>Frame data if captured, null if no new frame available or on error.</returns>
@@ -226,6 +238,21 @@ public sealed class DesktopDuplicationBridge : IDisposable
 
             try
             {
+                var damage = ReadFrameDamage(frameInfo);
+
+                // Only the pointer moved; the desktop image is unchanged
+                if (frameInfo.LastPresentTime == 0 && _desktopPixels != null)
+                {
+                    return new CapturedFrame(
+                        Width: OutputWidth,
+                        Height: OutputHeight,
+                        Stride: _desktopPixels.Length / OutputHeight,
+                        Format: PixelFormatType.Bgra32,
+                        Data: _desktopPixels,
+                        Timestamp: frameInfo.LastPresentTime,
+                        Damage: FrameDamage.Empty);
+                }
+
                 // Query for ID3D11Texture2D
                 var texture2dIid = D3D11.IID_ID3D11Texture2D;
                 hr = DXGI.QueryInterface(resource, ref texture2dIid, out frameTexture);
@@ -253,18 +280,41 @@ public sealed class DesktopDuplicationBridge : IDisposable
 
                 try
                 {
-                    // Copy pixel data
-                    var dataSize = (int)(OutputHeight * mappedResource.RowPitch);
-                    var data = new byte[dataSize];
-                    Marshal.Copy(mappedResource.pData, data, 0, dataSize);
+                    var stride = (int)mappedResource.RowPitch;
+                    var dataSize = OutputHeight * stride;
+                    if (_desktopPixels?.Length != dataSize)
+                    {
+                        // New mode; both copies are reused for every frame until the next one
+                        _desktopPixels = null;
+                        _spareDesktopPixels = null;
+                        damage = null;
+                    }
+
+                    // Refresh the spare: it missed the last frame's changes as well as this one's
+                    var target = _spareDesktopPixels ?? new byte[dataSize];
+                    if (damage == null || _spareStaleDamage == null || _spareDesktopPixels == null)
+                    {
+                        // No usable metadata: copy the whole desktop
+                        Marshal.Copy(mappedResource.pData, target, 0, dataSize);
+                    }
+                    else
+                    {
+                        CopyDamagedRegions(target, mappedResource.pData, stride, _spareStaleDamage);
+                        CopyDamagedRegions(target, mappedResource.pData, stride, damage);
+                    }
+
+                    _spareDesktopPixels = _desktopPixels;
+                    _spareStaleDamage = damage;
+                    _desktopPixels = target;
 
                     return new CapturedFrame(
                         Width: OutputWidth,
                         Height: OutputHeight,
-                        Stride: (int)mappedResource.RowPitch,
+                        Stride: stride,
                         Format: PixelFormatType.Bgra32,
-                        Data: data,
-                        Timestamp: frameInfo.LastPresentTime);
+                        Data: target,
+                        Timestamp: frameInfo.LastPresentTime,
+                        Damage: damage);
                 }
                 finally
                 {
@@ -290,7 +340,100 @@ public sealed class DesktopDuplicationBridge : IDisposable
     }
 
     /// <summary>
-    /// Extracts a region from a captured frame corresponding to a specific window.
+    /// Reads the move and dirty rectangles for the acquired frame.
+    /// Returns null when the metadata is unavailable, meaning everything may have changed.
+    /// </summary>
+    private FrameDamage? ReadFrameDamage(in DXGI.DXGI_OUTDUPL_FRAME_INFO frameInfo)
+    {
+        if (frameInfo.LastPresentTime == 0)
+        {
+            return FrameDamage.Empty;
+        }
+
+        if (frameInfo.TotalMetadataBufferSize == 0)
+        {
+            return null;
+        }
+
+        if (_metadataBuffer.Length < frameInfo.TotalMetadataBufferSize)
+        {
+            _metadataBuffer = new byte[frameInfo.TotalMetadataBufferSize];
+        }
+
+        unsafe
+        {
+            fixed (byte* buffer = _metadataBuffer)
+            {
+                // Move rects come first in the metadata; dirty rects use what's left
+                var hr = DXGI.IDXGIOutputDuplication_GetFrameMoveRects(
+                    _duplication, (uint)_metadataBuffer.Length, (nint)buffer, out var moveBytes);
+                if (hr < 0)
+                {
+                    return null;
+                }
+
+                hr = DXGI.IDXGIOutputDuplication_GetFrameDirtyRects(
+                    _duplication, (uint)_metadataBuffer.Length - moveBytes, (nint)(buffer + moveBytes), out var dirtyBytes);
+                if (hr < 0)
+                {
+                    return null;
+                }
+
+                var moveCount = (int)(moveBytes / sizeof(DXGI.DXGI_OUTDUPL_MOVE_RECT));
+                var moves = new FrameMoveRect[moveCount];
+                var moveRects = (DXGI.DXGI_OUTDUPL_MOVE_RECT*)buffer;
+                for (var i = 0; i < moveCount; i++)
+                {
+                    moves[i] = new FrameMoveRect(
+                        moveRects[i].SourcePoint.X,
+                        moveRects[i].SourcePoint.Y,
+                        ToRect(moveRects[i].DestinationRect));
+                }
+
+                var dirtyCount = (int)(dirtyBytes / sizeof(DXGI.RECT));
+                var dirty = new Rect[dirtyCount];
+                var dirtyRects = (DXGI.RECT*)(buffer + moveBytes);
+                for (var i = 0; i < dirtyCount; i++)
+                {
+                    dirty[i] = ToRect(dirtyRects[i]);
+                }
+
+                return new FrameDamage(moves, dirty);
+            }
+        }
+    }
+
+    private static Rect ToRect(DXGI.RECT rect) =>
+        new(rect.Left, rect.Top, rect.Right - rect.Left, rect.Bottom - rect.Top);
+
+    /// <summary>
+    /// Refreshes a retained desktop copy from the mapped staging texture,
+    /// touching only the rows of moved and dirty regions.
+    /// </summary>
+    private void CopyDamagedRegions(byte[] target, nint mapped, int stride, FrameDamage damage)
+    {
+        const int bytesPerPixel = 4;
+        var desktop = new Rect(0, 0, OutputWidth, OutputHeight);
+
+        foreach (var region in damage.TouchedRects())
+        {
+            if (FrameDamage.Intersect(region, desktop) is not { } clipped)
+            {
+                continue;
+            }
+
+            var rowBytes = clipped.Width * bytesPerPixel;
+            for (var row = clipped.Y; row < clipped.Y + clipped.Height; row++)
+            {
+                var offset = (row * stride) + (clipped.X * bytesPerPixel);
+                Marshal.Copy(mapped + offset, target, offset, rowBytes);
+            }
+        }
+    }
+
+    /// <summary>
+    /// Extracts a region from a captured frame corresponding to a specific window,
+    /// as BGRA.
     /// </summary>
     /// <param name="frame">The full desktop frame.</param>
     /// <param name="windowBounds">The window bounds to extract.</param>
@@ -311,30 +454,47 @@ public sealed class DesktopDuplicationBridge : IDisposable
             return null;
         }
 
-        var bytesPerPixel = 4; // BGRA32
-        var newStride = width * bytesPerPixel;
+        var newStride = width * 4; // BGRA32
         var newData = new byte[height * newStride];
-
-        // Copy each row from the source frame
-        for (var row = 0; row < height; row++)
-        {
-            var srcOffset = ((y + row) * frame.Stride) + (x * bytesPerPixel);
-            var dstOffset = row * newStride;
-
-            Array.Copy(frame.Data, srcOffset, newData, dstOffset, newStride);
-        }
+        CopyRegion(frame, new Rect(x, y, width, height), newData);
 
         return new CapturedFrame(
             Width: width,
             Height: height,
             Stride: newStride,
-            Format: frame.Format,
+            Format: PixelFormatType.Bgra32,
             Data: newData,
             Timestamp: frame.Timestamp);
     }
 
+    /// <summary>
+    /// Copies a region of a frame into <paramref name="destination"/> as tightly
+    /// packed BGRA rows (Width * 4 bytes each), e.g. straight into a shared memory slot.
+    /// </summary>
+    /// <param name="frame">The source frame.</param>
+    /// <param name="region">Region to copy; must lie within the frame.</param>
+    /// <param name="destination">Buffer of at least Width * Height * 4 bytes.</param>
+    public static void CopyRegion(CapturedFrame frame, Rect region, Span<byte> destination) =>
+        FramePixels.CopyRegion(
+            frame.Data, frame.Stride, region.X, region.Y, region.Width, region.Height,
+            swapRedBlue: frame.Format == PixelFormatType.Rgba32, destination);
+
+    /// <summary>
+    /// Copies a region of a frame into <paramref name="destination"/> at half
+    /// size, as packed BGRA rows: each output pixel averages a 2x2 block.
+    /// </summary>
+    /// <param name="destination">Buffer of at least (Width / 2) * (Height / 2) * 4 bytes.</param>
+    public static void DownscaleRegion(CapturedFrame frame, Rect region, Span<byte> destination) =>
+        FramePixels.Downscale2x(
+            frame.Data, frame.Stride, region.X, region.Y, region.Width, region.Height,
+            swapRedBlue: frame.Format == PixelFormatType.Rgba32, destination);
+
     private void Cleanup()
     {
+        _desktopPixels = null;
+        _spareDesktopPixels = null;
+        _spareStaleDamage = null;
+
         if (_stagingTexture != IntPtr.Zero)
         {
             _ = Marshal.Release(_stagingTexture);
@@ -377,13 +537,17 @@ public sealed class DesktopDuplicationBridge : IDisposable
 /// <summary>
 /// Represents a captured desktop frame.
 /// </summary>
+/// <param name="Damage">
+/// What changed since the previous capture, or null if unknown (treat the whole frame as changed).
+/// </param>
 public sealed record CapturedFrame(
     int Width,
     int Height,
     int Stride,
     PixelFormatType Format,
     byte[] Data,
-    long Timestamp);
+    long Timestamp,
+    FrameDamage? Damage = null);
 
 // Note: PixelFormatType is defined in Messages.cs to avoid duplication
 
@@ -428,6 +592,13 @@ internal static class DXGI
         public uint PointerShapeBufferSize;
     }
 
+    [StructLayout(LayoutKind.Sequential)]
+    public struct DXGI_OUTDUPL_MOVE_RECT
+    {
+        public POINT SourcePoint;
+        public RECT DestinationRect;
+    }
+
     [StructLayout(LayoutKind.Sequential)]
     public struct DXGI_OUTDUPL_POINTER_POSITION
     {
@@ -506,6 +677,27 @@ internal static class DXGI
     private delegate int AcquireNextFrameDelegate(
         nint self, uint timeout, out DXGI_OUTDUPL_FRAME_INFO frameInfo, out nint resource);
 
+    // IDXGIOutputDuplication::GetFrameDirtyRects - vtable index 9
+    public static int IDXGIOutputDuplication_GetFrameDirtyRects(
+        nint duplication, uint bufferSize, nint buffer, out uint requiredSize)
+    {
+        var vtable = Marshal.ReadIntPtr(duplication);
+        var func = Marshal.GetDelegateForFunctionPointer<GetFrameRectsDelegate>(
+            Marshal.ReadIntPtr(vtable, 9 * IntPtr.Size));
+        return func(duplication, bufferSize, buffer, out requiredSize);
+    }
+
+    // IDXGIOutputDuplication::GetFrameMoveRects - vtable index 10
+    public static int IDXGIOutputDuplication_GetFrameMoveRects(
+        nint duplication, uint bufferSize, nint buffer, out uint requiredSize)
+    {
+        var vtable = Marshal.ReadIntPtr(duplication);
+        var func = Marshal.GetDelegateForFunctionPointer<GetFrameRectsDelegate>(
+            Marshal.ReadIntPtr(vtable, 10 * IntPtr.Size));
+        return func(duplication, bufferSize, buffer, out requiredSize);
+    }
+    private delegate int GetFrameRectsDelegate(nint self, uint bufferSize, nint buffer, out uint requiredSize);
+
     // IDXGIOutputDuplication::ReleaseFrame - vtable index 14
     public static int IDXGIOutputDuplication_ReleaseFrame(nint duplication)
     {
@@ -0,0 +1,227 @@
+namespace WinRun.Agent.Services;
+
+/// <summary>
+/// Source of desktop frames for <see cref="FrameStreamingService"/>.
+/// </summary>
+public interface IFrameCaptureSource
+{
+    /// <summary>Width of the captured output in pixels.</summary>
+    int OutputWidth { get; }
+
+    /// <summary>Height of the captured output in pixels.</summary>
+    int OutputHeight { get; }
+
+    /// <summary>
+    /// Prepares the source for capture.
+    /// </summary>
+    /// <returns>True if capture is ready, false otherwise.</returns>
+    bool Initialize();
+
+    /// <summary>
+    /// Captures the next desktop frame.
+    /// </summary>
+    /// <remarks>
+    /// The frame's data must stay valid until the capture after next:
+    /// <see cref="FrameStreamingService"/> captures the next frame while the
+    /// previous one is still being written to the window buffers.
+    /// </remarks>
+    /// <param name="timeout">Timeout in milliseconds to wait for a new frame.</param>
+    /// <returns>Frame data if captured, null if no new frame available or on error.</returns>
+    CapturedFrame? CaptureFrame(int timeout = 100);
+}
+
+/// <summary>
+/// In-memory desktop for exercising the capture pipeline without DXGI.
+/// Drawing calls record damage the same way Desktop Duplication reports it,
+/// so each captured frame carries the move and dirty rectangles since the last one.
+/// </summary>
+public sealed class SyntheticCaptureSource : IFrameCaptureSource
+{
+    private const int BytesPerPixel = 4;
+
+    private readonly object _lock = new();
+    private readonly byte[] _pixels;
+    private readonly byte[][] _frames;
+    private int _nextFrame;
+    private readonly List<FrameMoveRect> _moves = [];
+    private readonly List<Rect> _dirty = [];
+    private bool _changed = true;
+    private bool _fullyDirty = true;
+    private long _timestamp;
+
+    /// <summary>
+    /// Creates a black desktop of the given size. The first capture is a full frame.
+    /// </summary>
+    public SyntheticCaptureSource(int width, int height)
+    {
+        ArgumentOutOfRangeException.ThrowIfNegativeOrZero(width);
+        ArgumentOutOfRangeException.ThrowIfNegativeOrZero(height);
+
+        OutputWidth = width;
+        OutputHeight = height;
+        _pixels = new byte[width * height * BytesPerPixel];
+        _frames = [new byte[_pixels.Length], new byte[_pixels.Length]];
+    }
+
+    public int OutputWidth { get; }
+
+    public int OutputHeight { get; }
+
+    /// <summary>
+    /// Whether captured frames carry damage. When false, frames look like
+    /// Desktop Duplication without metadata and every frame is a full frame.
+    /// </summary>
+    public bool ReportsDamage { get; set; } = true;
+
+    /// <summary>Number of frames captured so far.</summary>
+    public int CaptureCount { get; private set; }
+
+    private int Stride => OutputWidth * BytesPerPixel;
+
+    private void MarkChanged()
+    {
+        _changed = true;
+        Monitor.PulseAll(_lock);
+    }
+
+    public bool Initialize() => true;
+
+    /// <summary>
+    /// Fills a rectangle with a BGRA color and marks it dirty.
+    /// </summary>
+    public void Fill(Rect rect, uint bgra)
+    {
+        lock (_lock)
+        {
+            if (FrameDamage.Intersect(rect, new Rect(0, 0, OutputWidth, OutputHeight)) is not { } clipped)
+            {
+                return;
+            }
+
+            Span<byte> pixel = stackalloc byte[BytesPerPixel];
+            _ = BitConverter.TryWriteBytes(pixel, bgra);
+            for (var row = 0; row < clipped.Height; row++)
+            {
+                var line = _pixels.AsSpan(((clipped.Y + row) * Stride) + (clipped.X * BytesPerPixel), clipped.Width * BytesPerPixel);
+                for (var x = 0; x < line.Length; x += BytesPerPixel)
+                {
+                    pixel.CopyTo(line[x..]);
+                }
+            }
+
+            _dirty.Add(clipped);
+            MarkChanged();
+        }
+    }
+
+    /// <summary>
+    /// Moves a rectangle's pixels to a new position (like a scroll) and records a move rect.
+    /// The source and destination must lie within the desktop.
+    /// </summary>
+    public void Move(Rect source, int destinationX, int destinationY)
+    {
+        lock (_lock)
+        {
+            var desktop = new Rect(0, 0, OutputWidth, OutputHeight);
+            var destination = new Rect(destinationX, destinationY, source.Width, source.Height);
+            if (FrameDamage.Intersect(source, desktop) != source || FrameDamage.Intersect(destination, desktop) != destination)
+            {
+                throw new ArgumentOutOfRangeException(nameof(source), "Move must stay within the desktop");
+            }
+
+            // Rows overlap when scrolling vertically; walk away from the destination
+            var rowBytes = source.Width * BytesPerPixel;
+            for (var i = 0; i < source.Height; i++)
+            {
+                var row = destinationY > source.Y ? source.Height - 1 - i : i;
+                var from = ((source.Y + row) * Stride) + (source.X * BytesPerPixel);
+                var to = ((destinationY + row) * Stride) + (destinationX * BytesPerPixel);
+                _pixels.AsSpan(from, rowBytes).CopyTo(_pixels.AsSpan(to, rowBytes));
+            }
+
+            // Moves are applied before dirty rects, so one that follows drawing
+            // in the same frame can only be reported as dirty
+            if (_dirty.Count > 0)
+            {
+                _dirty.Add(destination);
+            }
+            else
+            {
+                _moves.Add(new FrameMoveRect(source.X, source.Y, destination));
+            }
+
+            MarkChanged();
+        }
+    }
+
+    /// <summary>
+    /// Produces a frame without drawing anything, like a pointer-only update:
+    /// the next capture returns a frame with empty damage.
+    /// </summary>
+    public void Present()
+    {
+        lock (_lock)
+        {
+            MarkChanged();
+        }
+    }
+
+    /// <summary>
+    /// Reads one pixel as BGRA.
+    /// </summary>
+    public uint GetPixel(int x, int y)
+    {
+        lock (_lock)
+        {
+            return BitConverter.ToUInt32(_pixels, (y * Stride) + (x * BytesPerPixel));
+        }
+    }
+
+    /// <summary>
+    /// Returns the next frame with its damage, or null if nothing changed within
+    /// <paramref name="timeout"/> milliseconds. Like Desktop Duplication, the
+    /// frame's data is reused by the capture after next.
+    /// </summary>
+    public CapturedFrame? CaptureFrame(int timeout = 100)
+    {
+        lock (_lock)
+        {
+            // Drawing pulses the lock, like AcquireNextFrame returning on a desktop update
+            if (!_changed && timeout > 0)
+            {
+                _ = Monitor.Wait(_lock, timeout);
+            }
+
+            if (!_changed)
+            {
+                return null;
+            }
+
+            FrameDamage? damage = null;
+            if (ReportsDamage)
+            {
+                damage = _fullyDirty
+                    ? new FrameDamage([], [new Rect(0, 0, OutputWidth, OutputHeight)])
+                    : new FrameDamage([.. _moves], [.. _dirty]);
+            }
+
+            var frame = _frames[_nextFrame];
+            _nextFrame ^= 1;
+            _pixels.CopyTo(frame, 0);
+            _moves.Clear();
+            _dirty.Clear();
+            _changed = false;
+            _fullyDirty = false;
+            CaptureCount++;
+
+            return new CapturedFrame(
+                Width: OutputWidth,
+                Height: OutputHeight,
+                Stride: Stride,
+                Format: PixelFormatType.Bgra32,
+                Data: frame,
+                Timestamp: ++_timestamp,
+                Damage: damage);
+        }
+    }
+}
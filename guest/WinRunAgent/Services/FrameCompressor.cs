@@ -1,7 +1,23 @@
+using System.Diagnostics;
 using K4os.Compression.LZ4;
 
 namespace WinRun.Agent.Services;
 
+/// <summary>
+/// How frames are compressed.
+/// </summary>
+public enum FrameCodec
+{
+    /// <summary>The whole frame as one LZ4 block.</summary>
+    Lz4,
+
+    /// <summary>
+    /// The frame cut into tiles, each coded raw, LZ4, RLE or palette
+    /// (see <see cref="TiledFrameEncoder"/>).
+    /// </summary>
+    Tiled
+}
+
 /// <summary>
 /// Configuration for frame compression.
 /// </summary>
@@ -10,6 +26,12 @@ public sealed record FrameCompressionConfig
     /// <summary>Whether compression is enabled.</summary>
     public bool Enabled { get; init; } = true;
 
+    /// <summary>
+    /// How frames are compressed. Tiled frames code flat UI regions with RLE
+    /// or a palette, which is far smaller than LZ4 on the same pixels.
+    /// </summary>
+    public FrameCodec Codec { get; init; } = FrameCodec.Tiled;
+
     /// <summary>
     /// LZ4 compression level. Higher = better compression but slower.
     /// Fast (0-2): Best for real-time streaming
@@ -28,6 +50,12 @@ public sealed record FrameCompressionConfig
     /// If compressed size / original size > this value, skip compression.
     /// </summary>
     public float MaxCompressionRatio { get; init; } = 0.95f;
+
+    /// <summary>
+    /// Share of the capture interval a tiled frame may spend LZ4 coding its
+    /// busy tiles. Tiles left when it runs out are sent raw.
+    /// </summary>
+    public float EncodeBudgetShare { get; init; } = 0.25f;
 }
 
 /// <summary>
@@ -36,18 +64,29 @@ public sealed record FrameCompressionConfig
 /// </summary>
 public sealed class FrameCompressor
 {
+    // Until the streaming loop sets an interval, budget for 30 fps
+    private static readonly TimeSpan DefaultFrameInterval = TimeSpan.FromMilliseconds(33);
+
     private readonly IAgentLogger _logger;
+    private readonly TiledFrameEncoder _tiledEncoder;
+    private long _encodeBudget;
 
     // Statistics
     private long _totalFrames;
     private long _compressedFrames;
     private long _uncompressedBytes;
     private long _compressedBytes;
+    private long _rawTiles;
+    private long _lz4Tiles;
+    private long _rleTiles;
+    private long _paletteTiles;
 
     public FrameCompressor(IAgentLogger logger, FrameCompressionConfig? config = null)
     {
         _logger = logger;
         Config = config ?? new FrameCompressionConfig();
+        _tiledEncoder = new TiledFrameEncoder(Config.CompressionLevel);
+        SetFrameInterval(DefaultFrameInterval);
     }
 
     /// <summary>
@@ -63,9 +102,45 @@ public sealed class FrameCompressor
         TotalFrames = Interlocked.Read(ref _totalFrames),
         CompressedFrames = Interlocked.Read(ref _compressedFrames),
         UncompressedBytes = Interlocked.Read(ref _uncompressedBytes),
-        CompressedBytes = Interlocked.Read(ref _compressedBytes)
+        CompressedBytes = Interlocked.Read(ref _compressedBytes),
+        RawTiles = Interlocked.Read(ref _rawTiles),
+        Lz4Tiles = Interlocked.Read(ref _lz4Tiles),
+        RleTiles = Interlocked.Read(ref _rleTiles),
+        PaletteTiles = Interlocked.Read(ref _paletteTiles)
     };
 
+    /// <summary>
+    /// Whether <see cref="CompressFrameInto"/> produces tiled payloads
+    /// (<see cref="FrameSlotFlags.Tiled"/>).
+    /// </summary>
+    public bool IsTiled => Config.Codec == FrameCodec.Tiled;
+
+    /// <summary>
+    /// Time a tiled frame may spend LZ4 coding tiles; the rest go raw.
+    /// </summary>
+    public TimeSpan EncodeBudget => Stopwatch.GetElapsedTime(0, Interlocked.Read(ref _encodeBudget));
+
+    /// <summary>
+    /// Sets the encode budget from the time the capture loop has per frame,
+    /// so a faster loop leaves less time for LZ4.
+    /// </summary>
+    public void SetFrameInterval(TimeSpan interval)
+    {
+        var budget = interval.TotalSeconds * Config.EncodeBudgetShare * Stopwatch.Frequency;
+        _ = Interlocked.Exchange(ref _encodeBudget, (long)budget);
+    }
+
+    /// <summary>
+    /// Largest output <see cref="TryCompress"/> can produce for <paramref name="length"/> input bytes.
+    /// </summary>
+    public static int MaximumCompressedSize(int length) => LZ4Codec.MaximumOutputSize(length);
+
+    /// <summary>
+    /// Largest output <see cref="CompressFrameInto"/> can produce for a frame.
+    /// </summary>
+    public int MaximumCompressedFrameSize(int width, int height, int length) =>
+        IsTiled ? TiledFrameEncoder.MaximumEncodedSize(width, height) : MaximumCompressedSize(length);
+
     /// <summary>
     /// Compresses frame data using LZ4.
     /// </summary>
@@ -73,11 +148,8 @@ public sealed class FrameCompressor
     /// <returns>Compression result with compressed data (or original if compression not beneficial).</returns>
     public CompressionResult Compress(ReadOnlySpan<byte> data)
     {
-        _ = Interlocked.Increment(ref _totalFrames);
-        _ = Interlocked.Add(ref _uncompressedBytes, data.Length);
-
-        // Skip compression for small frames or if disabled
-        if (!Config.Enabled || data.Length < Config.MinSizeToCompress)
+        var compressedBuffer = new byte[MaximumCompressedSize(data.Length)];
+        if (!TryCompress(data, compressedBuffer, out var compressedSize))
         {
             return new CompressionResult
             {
@@ -88,46 +160,150 @@ public sealed class FrameCompressor
             };
         }
 
-        // Allocate buffer for compressed data (max possible size)
-        var maxCompressedSize = LZ4Codec.MaximumOutputSize(data.Length);
-        var compressedBuffer = new byte[maxCompressedSize];
+        return new CompressionResult
+        {
+            Data = compressedBuffer[..compressedSize],
+            IsCompressed = true,
+            OriginalSize = data.Length,
+            CompressedSize = compressedSize
+        };
+    }
+
+    /// <summary>
+    /// Compresses frame data using LZ4 into a caller-supplied buffer, without allocating.
+    /// </summary>
+    /// <param name="data">Raw frame pixel data.</param>
+    /// <param name="destination">Output buffer of at least <see cref="MaximumCompressedSize"/> bytes.</param>
+    /// <param name="compressedSize">Number of bytes written to <paramref name="destination"/>.</param>
+    /// <returns>
+    /// True if the data was compressed. False if compression is disabled or not
+    /// beneficial; the caller should then send <paramref name="data"/> as is.
+    /// </returns>
+    public bool TryCompress(ReadOnlySpan<byte> data, Span<byte> destination, out int compressedSize)
+    {
+        compressedSize = Math.Max(CompressInto(data, destination), 0);
+        return compressedSize > 0;
+    }
+
+    /// <summary>
+    /// Compresses frame data using LZ4 into <paramref name="destination"/>, which
+    /// may be smaller than <see cref="MaximumCompressedSize"/> (e.g. a shared
+    /// memory slot sized for typical compressed frames).
+    /// </summary>
+    /// <param name="data">Raw frame pixel data.</param>
+    /// <param name="destination">Output buffer, typically a reserved frame slot.</param>
+    /// <returns>
+    /// The compressed size; 0 if compression is disabled or not beneficial, so
+    /// <paramref name="data"/> should be sent as is; or -1 if the output didn't
+    /// fit. A -1 result isn't counted in <see cref="Stats"/>, so the caller can
+    /// retry with a larger buffer.
+    /// </returns>
+    public int CompressInto(ReadOnlySpan<byte> data, Span<byte> destination)
+    {
+        // Skip compression for small frames or if disabled
+        if (!Config.Enabled || data.Length < Config.MinSizeToCompress)
+        {
+            RecordFrame(data.Length, compressedSize: 0);
+            return 0;
+        }
 
-        // Compress
-        var compressedSize = LZ4Codec.Encode(
-            data,
-            compressedBuffer.AsSpan(),
-            Config.CompressionLevel);
+        // Encode returns -1 if the output didn't fit
+        var compressedSize = LZ4Codec.Encode(data, destination, Config.CompressionLevel);
+        if (compressedSize <= 0)
+        {
+            return -1;
+        }
 
         // Check if compression is beneficial
         var ratio = (float)compressedSize / data.Length;
         if (ratio > Config.MaxCompressionRatio)
         {
-            // Compression didn't help enough, return original
-            return new CompressionResult
-            {
-                Data = data.ToArray(),
-                IsCompressed = false,
-                OriginalSize = data.Length,
-                CompressedSize = data.Length
-            };
+            RecordFrame(data.Length, compressedSize: 0);
+            return 0;
         }
 
-        // Return compressed data (trimmed to actual size)
-        var result = new byte[compressedSize];
-        Array.Copy(compressedBuffer, result, compressedSize);
+        RecordFrame(data.Length, compressedSize);
 
-        _ = Interlocked.Increment(ref _compressedFrames);
-        _ = Interlocked.Add(ref _compressedBytes, compressedSize);
+        // Per-frame message; don't format it unless it will be logged
+        if (_logger.MinimumLevel <= LogLevel.Debug)
+        {
+            _logger.Debug($"Frame compressed: {data.Length} -> {compressedSize} ({ratio:P1})");
+        }
 
-        _logger.Debug($"Frame compressed: {data.Length} -> {compressedSize} ({ratio:P1})");
+        return compressedSize;
+    }
 
-        return new CompressionResult
+    /// <summary>
+    /// Compresses a frame with the configured <see cref="FrameCompressionConfig.Codec"/>.
+    /// Same results as <see cref="CompressInto"/>.
+    /// </summary>
+    /// <param name="data">BGRA pixels, <paramref name="stride"/> bytes per row.</param>
+    /// <param name="hostDecodeTime">
+    /// Time the host reports it takes to decode one of the window's tiled
+    /// frames. It is taken out of <see cref="EncodeBudget"/>, since the frame
+    /// has to be encoded and decoded within the same interval.
+    /// </param>
+    public int CompressFrameInto(
+        ReadOnlySpan<byte> data,
+        int width,
+        int height,
+        int stride,
+        Span<byte> destination,
+        TimeSpan hostDecodeTime = default)
+    {
+        if (!IsTiled)
         {
-            Data = result,
-            IsCompressed = true,
-            OriginalSize = data.Length,
-            CompressedSize = compressedSize
-        };
+            return CompressInto(data, destination);
+        }
+
+        if (!Config.Enabled || data.Length < Config.MinSizeToCompress)
+        {
+            RecordFrame(data.Length, compressedSize: 0);
+            return 0;
+        }
+
+        var hostDecodeTicks = (long)(hostDecodeTime.TotalSeconds * Stopwatch.Frequency);
+        var lz4Budget = Math.Max(0, Interlocked.Read(ref _encodeBudget) - hostDecodeTicks);
+        var counts = new TileCounts();
+        var compressedSize = _tiledEncoder.Encode(data, width, height, stride, destination, lz4Budget, ref counts);
+        if (compressedSize <= 0)
+        {
+            return -1;
+        }
+
+        var rawSize = width * height * 4;
+        var ratio = (float)compressedSize / rawSize;
+        if (ratio > Config.MaxCompressionRatio)
+        {
+            RecordFrame(data.Length, compressedSize: 0);
+            return 0;
+        }
+
+        RecordFrame(data.Length, compressedSize);
+        _ = Interlocked.Add(ref _rawTiles, counts.Raw);
+        _ = Interlocked.Add(ref _lz4Tiles, counts.Lz4);
+        _ = Interlocked.Add(ref _rleTiles, counts.Rle);
+        _ = Interlocked.Add(ref _paletteTiles, counts.Palette);
+
+        if (_logger.MinimumLevel <= LogLevel.Debug)
+        {
+            _logger.Debug(
+                $"Frame tiled: {rawSize} -> {compressedSize} ({ratio:P1}), tiles raw={counts.Raw} " +
+                $"lz4={counts.Lz4} rle={counts.Rle} palette={counts.Palette}");
+        }
+
+        return compressedSize;
+    }
+
+    private void RecordFrame(int originalSize, int compressedSize)
+    {
+        _ = Interlocked.Increment(ref _totalFrames);
+        _ = Interlocked.Add(ref _uncompressedBytes, originalSize);
+        if (compressedSize > 0)
+        {
+            _ = Interlocked.Increment(ref _compressedFrames);
+            _ = Interlocked.Add(ref _compressedBytes, compressedSize);
+        }
     }
 
     /// <summary>
@@ -184,6 +360,12 @@ public sealed record CompressionStats
     public required long UncompressedBytes { get; init; }
     public required long CompressedBytes { get; init; }
 
+    /// <summary>Tiles of tiled frames sent with each codec.</summary>
+    public required long RawTiles { get; init; }
+    public required long Lz4Tiles { get; init; }
+    public required long RleTiles { get; init; }
+    public required long PaletteTiles { get; init; }
+
     public float AverageCompressionRatio =>
         UncompressedBytes > 0 ? (float)CompressedBytes / UncompressedBytes : 1.0f;
 
@@ -191,5 +373,6 @@ public sealed record CompressionStats
 
     public override string ToString() =>
         $"Total={TotalFrames}, Compressed={CompressedFrames}, " +
-        $"Ratio={AverageCompressionRatio:P1}, Saved={BytesSaved / 1024}KB";
+        $"Ratio={AverageCompressionRatio:P1}, Saved={BytesSaved / 1024}KB, " +
+        $"Tiles(raw={RawTiles}, lz4={Lz4Tiles}, rle={RleTiles}, palette={PaletteTiles})";
 }
@@ -0,0 +1,278 @@
+using System.Buffers.Binary;
+
+namespace WinRun.Agent.Services;
+
+// ============================================================================
+// Frame Damage
+//
+// Desktop Duplication reports, per frame, the regions that moved (scrolling,
+// dragged windows) and the regions whose pixels changed. Carrying those to the
+// host lets a keystroke in a maximized window cost a few kilobytes instead of
+// a full frame: moves become in-place blits on the host's copy of the window,
+// and only the dirty rectangles' pixels are written into the ring.
+//
+// Damage slot payload (FrameSlotFlags.Damage set, little-endian):
+//   [FrameDamageHeader: MoveCount, DirtyCount]
+//   [MoveCount x move rect: SourceX, SourceY, X, Y, Width, Height (int32)]
+//   [DirtyCount x dirty rect: X, Y, Width, Height (int32)]
+//   [Dirty pixels: each dirty rect in order, Width * 4 bytes per row, no padding]
+//
+// Moves are applied first, in order, then the dirty rectangles are copied.
+// ============================================================================
+
+/// <summary>
+/// A region that moved on screen: the pixels at (SourceX, SourceY) in the
+/// previous frame now appear at <see cref="Destination"/>.
+/// </summary>
+public readonly record struct FrameMoveRect(int SourceX, int SourceY, Rect Destination);
+
+/// <summary>
+/// Header at the start of a damage slot's payload.
+/// </summary>
+public struct FrameDamageHeader
+{
+    /// <summary>Number of move rectangles that follow.</summary>
+    public uint MoveCount;
+    /// <summary>Number of dirty rectangles that follow the moves.</summary>
+    public uint DirtyCount;
+
+    public const int Size = 8;
+    public const int MoveRectSize = 24;
+    public const int DirtyRectSize = 16;
+}
+
+/// <summary>
+/// Moved and changed regions of a frame relative to the previous one.
+/// </summary>
+/// <param name="MoveRects">Regions copied from elsewhere in the previous frame, applied first.</param>
+/// <param name="DirtyRects">Regions whose pixels changed, applied after the moves.</param>
+public sealed record FrameDamage(IReadOnlyList<FrameMoveRect> MoveRects, IReadOnlyList<Rect> DirtyRects)
+{
+    private const int BytesPerPixel = 4;
+
+    /// <summary>A frame identical to the previous one.</summary>
+    public static FrameDamage Empty { get; } = new([], []);
+
+    /// <summary>Whether nothing changed.</summary>
+    public bool IsEmpty => MoveRects.Count == 0 && DirtyRects.Count == 0;
+
+    /// <summary>Total pixel area of the dirty rectangles (overlaps counted twice).</summary>
+    public long DirtyArea => DirtyRects.Sum(r => (long)r.Width * r.Height);
+
+    /// <summary>
+    /// Size of the damage slot payload for this damage.
+    /// </summary>
+    public int PayloadSize =>
+        FrameDamageHeader.Size +
+        (MoveRects.Count * FrameDamageHeader.MoveRectSize) +
+        (DirtyRects.Count * FrameDamageHeader.DirtyRectSize) +
+        (int)(DirtyArea * BytesPerPixel);
+
+    /// <summary>
+    /// Projects desktop damage onto a window, in window-local coordinates.
+    /// Moves that cross the window's edge become dirty rectangles at their
+    /// destination, since the host only has the window's own pixels to move.
+    /// </summary>
+    /// <param name="windowBounds">Window bounds in desktop coordinates, already clipped to the desktop.</param>
+    public FrameDamage ForWindow(Rect windowBounds)
+    {
+        var moves = new List<FrameMoveRect>();
+        var dirty = new List<Rect>();
+
+        foreach (var move in MoveRects)
+        {
+            var source = new Rect(move.SourceX, move.SourceY, move.Destination.Width, move.Destination.Height);
+            if (Contains(windowBounds, source) && Contains(windowBounds, move.Destination))
+            {
+                moves.Add(new FrameMoveRect(
+                    move.SourceX - windowBounds.X,
+                    move.SourceY - windowBounds.Y,
+                    Translate(move.Destination, windowBounds)));
+            }
+            else if (Intersect(move.Destination, windowBounds) is { } clipped)
+            {
+                dirty.Add(Translate(clipped, windowBounds));
+            }
+        }
+
+        foreach (var rect in DirtyRects)
+        {
+            if (Intersect(rect, windowBounds) is { } clipped)
+            {
+                dirty.Add(Translate(clipped, windowBounds));
+            }
+        }
+
+        return moves.Count == 0 && dirty.Count == 0 ? Empty : new FrameDamage(moves, dirty);
+    }
+
+    /// <summary>
+    /// Collapses this damage into dirty rectangles only. Used when frames are
+    /// skipped: later moves would act on pixels the host never received, so
+    /// every touched region is resent from the newest frame instead.
+    /// </summary>
+    public IEnumerable<Rect> TouchedRects() =>
+        MoveRects.Select(m => m.Destination).Concat(DirtyRects);
+
+    /// <summary>
+    /// Writes the damage slot payload, taking dirty pixels from <paramref name="source"/>.
+    /// </summary>
+    /// <param name="destination">Buffer of at least <see cref="PayloadSize"/> bytes.</param>
+    /// <param name="source">The full desktop frame the damage was captured with.</param>
+    /// <param name="windowBounds">Window bounds in desktop coordinates the damage is relative to.</param>
+    /// <returns>Number of bytes written.</returns>
+    public int WritePayload(Span<byte> destination, CapturedFrame source, Rect windowBounds)
+    {
+        BinaryPrimitives.WriteUInt32LittleEndian(destination, (uint)MoveRects.Count);
+        BinaryPrimitives.WriteUInt32LittleEndian(destination[4..], (uint)DirtyRects.Count);
+        var offset = FrameDamageHeader.Size;
+
+        foreach (var move in MoveRects)
+        {
+            WriteInt32s(destination[offset..],
+                move.SourceX, move.SourceY,
+                move.Destination.X, move.Destination.Y, move.Destination.Width, move.Destination.Height);
+            offset += FrameDamageHeader.MoveRectSize;
+        }
+
+        foreach (var rect in DirtyRects)
+        {
+            WriteInt32s(destination[offset..], rect.X, rect.Y, rect.Width, rect.Height);
+            offset += FrameDamageHeader.DirtyRectSize;
+        }
+
+        foreach (var rect in DirtyRects)
+        {
+            FramePixels.CopyRegion(
+                source.Data, source.Stride, windowBounds.X + rect.X, windowBounds.Y + rect.Y, rect.Width, rect.Height,
+                swapRedBlue: source.Format == PixelFormatType.Rgba32, destination[offset..]);
+            offset += rect.Width * rect.Height * BytesPerPixel;
+        }
+
+        return offset;
+    }
+
+    private static void WriteInt32s(Span<byte> destination, params int[] values)
+    {
+        for (var i = 0; i < values.Length; i++)
+        {
+            BinaryPrimitives.WriteInt32LittleEndian(destination[(i * 4)..], values[i]);
+        }
+    }
+
+    private static bool Contains(Rect outer, Rect inner) =>
+        inner.X >= outer.X && inner.Y >= outer.Y &&
+        inner.X + inner.Width <= outer.X + outer.Width &&
+        inner.Y + inner.Height <= outer.Y + outer.Height;
+
+    internal static Rect? Intersect(Rect a, Rect b)
+    {
+        var x = Math.Max(a.X, b.X);
+        var y = Math.Max(a.Y, b.Y);
+        var right = Math.Min(a.X + a.Width, b.X + b.Width);
+        var bottom = Math.Min(a.Y + a.Height, b.Y + b.Height);
+        return right > x && bottom > y ? new Rect(x, y, right - x, bottom - y) : null;
+    }
+
+    private static Rect Translate(Rect rect, Rect origin) =>
+        new(rect.X - origin.X, rect.Y - origin.Y, rect.Width, rect.Height);
+}
+
+/// <summary>
+/// Tracks what the host already has for one window, so the next frame can be
+/// sent as damage instead of a key frame.
+/// </summary>
+internal sealed class WindowDamageTracker
+{
+    private readonly List<Rect> _pending = [];
+    private Rect _bounds;
+    private bool _needsKeyFrame = true;
+
+    /// <summary>
+    /// Forces the next frame to be a key frame (e.g. after a dropped frame or
+    /// a buffer reallocation the host can't compose across).
+    /// </summary>
+    public void Invalidate()
+    {
+        _needsKeyFrame = true;
+        _pending.Clear();
+    }
+
+    /// <summary>
+    /// Records damage for a frame this window skipped.
+    /// </summary>
+    /// <param name="damage">Window-local damage, or null if unknown.</param>
+    /// <param name="maxRects">Pending rectangles beyond which a key frame is cheaper.</param>
+    public void Accumulate(FrameDamage? damage, int maxRects)
+    {
+        if (_needsKeyFrame)
+        {
+            return;
+        }
+
+        if (damage == null)
+        {
+            Invalidate();
+            return;
+        }
+
+        _pending.AddRange(damage.TouchedRects());
+        if (_pending.Count > maxRects)
+        {
+            Invalidate();
+        }
+    }
+
+    /// <summary>
+    /// Returns the damage to send for this frame, merged with anything pending,
+    /// or null if the window needs a key frame.
+    /// </summary>
+    /// <param name="bounds">The window's current desktop bounds.</param>
+    /// <param name="damage">Window-local damage for this frame, or null if unknown.</param>
+    public FrameDamage? Take(Rect bounds, FrameDamage? damage)
+    {
+        if (_needsKeyFrame || damage == null || bounds != _bounds)
+        {
+            return null;
+        }
+
+        if (_pending.Count == 0)
+        {
+            return damage;
+        }
+
+        var dirty = new List<Rect>(_pending);
+        dirty.AddRange(damage.TouchedRects());
+        _pending.Clear();
+        return new FrameDamage([], dirty);
+    }
+
+    /// <summary>
+    /// Whether the host already shows this window as of the current frame,
+    /// so nothing needs to be sent.
+    /// </summary>
+    /// <param name="bounds">The window's current desktop bounds.</param>
+    /// <param name="damage">Window-local damage for this frame, or null if unknown.</param>
+    public bool IsUpToDate(Rect bounds, FrameDamage? damage) =>
+        !_needsKeyFrame && _pending.Count == 0 && bounds == _bounds && damage is { IsEmpty: true };
+
+    /// <summary>Whether the host is missing changes this window skipped.</summary>
+    public bool IsBehind => _needsKeyFrame || _pending.Count > 0;
+
+    /// <summary>When the last key frame was sent for this window.</summary>
+    public DateTime LastKeyFrameTime { get; private set; }
+
+    /// <summary>
+    /// Records that the host received a frame for <paramref name="bounds"/>.
+    /// </summary>
+    public void Committed(Rect bounds, bool isKeyFrame, DateTime now)
+    {
+        _bounds = bounds;
+        _needsKeyFrame = false;
+        _pending.Clear();
+        if (isKeyFrame)
+        {
+            LastKeyFrameTime = now;
+        }
+    }
+}
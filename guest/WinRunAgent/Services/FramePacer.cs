@@ -0,0 +1,135 @@
+using System.Diagnostics;
+using System.Runtime.InteropServices;
+using Microsoft.Win32.SafeHandles;
+
+namespace WinRun.Agent.Services;
+
+/// <summary>
+/// Caps the capture loop's rate without adding latency. The loop only waits
+/// for what is left of the interval since the previous iteration started, so
+/// an iteration that already took longer (or that waited for the desktop to
+/// change) starts the next one at once.
+/// </summary>
+/// <remarks>
+/// On Windows the remaining time is waited on a high-resolution waitable
+/// timer. <see cref="Task.Delay(TimeSpan)"/> rounds up to the ~15.6 ms system
+/// tick, which turns a 16.7 ms frame interval into 31 ms.
+/// </remarks>
+internal sealed class FramePacer : IDisposable
+{
+    private readonly HighResolutionTimer? _timer;
+    private long _intervalStart = Stopwatch.GetTimestamp();
+
+    /// <param name="useHighResolutionTimer">Use a waitable timer where available instead of Task.Delay.</param>
+    public FramePacer(bool useHighResolutionTimer = true)
+    {
+        if (useHighResolutionTimer && OperatingSystem.IsWindows())
+        {
+            _timer = HighResolutionTimer.TryCreate();
+        }
+    }
+
+    /// <summary>Whether waits use a high-resolution timer.</summary>
+    public bool IsHighResolution => _timer != null;
+
+    /// <summary>
+    /// Waits until <paramref name="interval"/> has passed since the previous
+    /// call returned, then starts the next interval.
+    /// </summary>
+    /// <returns>The time waited; zero if the interval had already passed.</returns>
+    public async ValueTask<TimeSpan> WaitAsync(TimeSpan interval, CancellationToken token)
+    {
+        var remaining = interval - Stopwatch.GetElapsedTime(_intervalStart);
+        if (remaining <= TimeSpan.Zero)
+        {
+            _intervalStart = Stopwatch.GetTimestamp();
+            return TimeSpan.Zero;
+        }
+
+        if (_timer != null)
+        {
+            await _timer.WaitAsync(remaining, token);
+        }
+        else
+        {
+            await Task.Delay(remaining, token);
+        }
+
+        _intervalStart = Stopwatch.GetTimestamp();
+        return remaining;
+    }
+
+    public void Dispose() => _timer?.Dispose();
+
+    /// <summary>
+    /// A waitable timer created with CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+    /// (Windows 10 1803 and later).
+    /// </summary>
+    private sealed class HighResolutionTimer : WaitHandle
+    {
+        public static HighResolutionTimer? TryCreate()
+        {
+            var handle = FramePacerNative.CreateWaitableTimerEx(
+                0, null, FramePacerNative.CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, FramePacerNative.TIMER_ALL_ACCESS);
+
+            if (handle.IsInvalid)
+            {
+                handle.Dispose();
+                return null;
+            }
+
+            return new HighResolutionTimer { SafeWaitHandle = handle };
+        }
+
+        public async Task WaitAsync(TimeSpan delay, CancellationToken token)
+        {
+            // Negative due times are relative, in 100 ns units
+            var dueTime = -delay.Ticks;
+            if (!FramePacerNative.SetWaitableTimerEx(SafeWaitHandle, dueTime, 0, 0, 0, 0, 0))
+            {
+                await Task.Delay(delay, token);
+                return;
+            }
+
+            var fired = new TaskCompletionSource(TaskCreationOptions.RunContinuationsAsynchronously);
+            var registration = ThreadPool.RegisterWaitForSingleObject(
+                this,
+                static (state, _) => ((TaskCompletionSource)state!).TrySetResult(),
+                fired,
+                Timeout.Infinite,
+                executeOnlyOnce: true);
+
+            try
+            {
+                await fired.Task.WaitAsync(token);
+            }
+            finally
+            {
+                _ = registration.Unregister(null);
+            }
+        }
+    }
+}
+
+/// <summary>
+/// Kernel32 waitable timer declarations for <see cref="FramePacer"/>.
+/// </summary>
+internal static partial class FramePacerNative
+{
+    public const uint CREATE_WAITABLE_TIMER_HIGH_RESOLUTION = 0x00000002;
+    public const uint TIMER_ALL_ACCESS = 0x001F0003;
+
+    [LibraryImport("kernel32.dll", EntryPoint = "CreateWaitableTimerExW", StringMarshalling = StringMarshalling.Utf16, SetLastError = true)]
+    public static partial SafeWaitHandle CreateWaitableTimerEx(nint timerAttributes, string? timerName, uint flags, uint desiredAccess);
+
+    [LibraryImport("kernel32.dll", SetLastError = true)]
+    [return: MarshalAs(UnmanagedType.Bool)]
+    public static partial bool SetWaitableTimerEx(
+        SafeWaitHandle timer,
+        in long dueTime,
+        int period,
+        nint completionRoutine,
+        nint completionRoutineArg,
+        nint wakeContext,
+        uint tolerableDelay);
+}
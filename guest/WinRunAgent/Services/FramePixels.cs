@@ -0,0 +1,246 @@
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+using System.Runtime.Intrinsics;
+using System.Runtime.Intrinsics.Arm;
+using System.Runtime.Intrinsics.X86;
+
+namespace WinRun.Agent.Services;
+
+// ============================================================================
+// Pixel kernels for window frames
+//
+// Crops a window out of the desktop frame into packed BGRA rows, swapping red
+// and blue when the source is RGBA, and optionally halves it with a 2x2 box
+// filter. Each kernel has a NEON path (the guest runs on ARM64 Windows), an
+// AVX2/SSE path for x64, and a scalar path that is both the fallback and the
+// reference the tests and tools/FramePixelsBench compare against.
+//
+// Plain row copies stay on Span.CopyTo: memmove is already vectorized, and
+// shuffling bytes that don't move would only slow it down.
+//
+// This file has no dependencies on the rest of the agent, so the benchmark
+// can compile it on its own.
+// ============================================================================
+
+internal static class FramePixels
+{
+    public const int BytesPerPixel = 4;
+
+    // Swaps bytes 0 and 2 of each pixel: BGRA <-> RGBA
+    private static readonly Vector128<byte> SwapRedBlueMask = Vector128.Create(
+        (byte)2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+    /// <summary>
+    /// Copies a region of a frame into <paramref name="destination"/> as packed
+    /// BGRA rows (<paramref name="width"/> * 4 bytes each).
+    /// </summary>
+    /// <param name="source">Source pixels, 4 bytes each.</param>
+    /// <param name="sourceStride">Bytes per source row.</param>
+    /// <param name="swapRedBlue">The source is RGBA; convert it to BGRA.</param>
+    /// <param name="destination">At least width * height * 4 bytes; must not overlap the source.</param>
+    public static void CopyRegion(
+        ReadOnlySpan<byte> source, int sourceStride, int x, int y, int width, int height,
+        bool swapRedBlue, Span<byte> destination)
+    {
+        var rowBytes = width * BytesPerPixel;
+        for (var row = 0; row < height; row++)
+        {
+            var src = source.Slice(((y + row) * sourceStride) + (x * BytesPerPixel), rowBytes);
+            var dst = destination.Slice(row * rowBytes, rowBytes);
+            if (swapRedBlue)
+            {
+                SwapRedBlue(src, dst);
+            }
+            else
+            {
+                src.CopyTo(dst);
+            }
+        }
+    }
+
+    /// <summary>
+    /// Halves a region of a frame into <paramref name="destination"/> as packed
+    /// BGRA rows, averaging each 2x2 block. An odd last row or column is dropped.
+    /// </summary>
+    /// <param name="destination">At least (width / 2) * (height / 2) * 4 bytes.</param>
+    public static void Downscale2x(
+        ReadOnlySpan<byte> source, int sourceStride, int x, int y, int width, int height,
+        bool swapRedBlue, Span<byte> destination)
+    {
+        var outWidth = width / 2;
+        var outRowBytes = outWidth * BytesPerPixel;
+        var inRowBytes = outWidth * 2 * BytesPerPixel;
+
+        for (var row = 0; row < height / 2; row++)
+        {
+            var top = ((y + (row * 2)) * sourceStride) + (x * BytesPerPixel);
+            Downscale2xRow(
+                source.Slice(top, inRowBytes),
+                source.Slice(top + sourceStride, inRowBytes),
+                destination.Slice(row * outRowBytes, outRowBytes),
+                swapRedBlue);
+        }
+    }
+
+    /// <summary>Size in bytes of a region halved by <see cref="Downscale2x"/>.</summary>
+    public static int Downscale2xSize(int width, int height) => width / 2 * (height / 2) * BytesPerPixel;
+
+    /// <summary>
+    /// Copies pixels, swapping red and blue. <paramref name="destination"/>
+    /// must be at least as long as <paramref name="source"/> and not overlap it.
+    /// </summary>
+    internal static void SwapRedBlue(ReadOnlySpan<byte> source, Span<byte> destination)
+    {
+        ref var src = ref MemoryMarshal.GetReference(source);
+        ref var dst = ref MemoryMarshal.GetReference(destination);
+        var length = source.Length & ~(BytesPerPixel - 1);
+        _ = destination[..length];
+        var i = 0;
+
+        if (Avx2.IsSupported)
+        {
+            var mask = Vector256.Create(SwapRedBlueMask, SwapRedBlueMask);
+            for (; i + Vector256<byte>.Count <= length; i += Vector256<byte>.Count)
+            {
+                Avx2.Shuffle(Vector256.LoadUnsafe(ref src, (nuint)i), mask).StoreUnsafe(ref dst, (nuint)i);
+            }
+        }
+
+        if (AdvSimd.Arm64.IsSupported)
+        {
+            for (; i + Vector128<byte>.Count <= length; i += Vector128<byte>.Count)
+            {
+                AdvSimd.Arm64.VectorTableLookup(Vector128.LoadUnsafe(ref src, (nuint)i), SwapRedBlueMask)
+                    .StoreUnsafe(ref dst, (nuint)i);
+            }
+        }
+        else if (Ssse3.IsSupported)
+        {
+            for (; i + Vector128<byte>.Count <= length; i += Vector128<byte>.Count)
+            {
+                Ssse3.Shuffle(Vector128.LoadUnsafe(ref src, (nuint)i), SwapRedBlueMask).StoreUnsafe(ref dst, (nuint)i);
+            }
+        }
+
+        SwapRedBlueScalar(source[i..length], destination[i..length]);
+    }
+
+    /// <summary>Scalar <see cref="SwapRedBlue"/>.</summary>
+    internal static void SwapRedBlueScalar(ReadOnlySpan<byte> source, Span<byte> destination)
+    {
+        for (var i = 0; i + BytesPerPixel <= source.Length; i += BytesPerPixel)
+        {
+            destination[i] = source[i + 2];
+            destination[i + 1] = source[i + 1];
+            destination[i + 2] = source[i];
+            destination[i + 3] = source[i + 3];
+        }
+    }
+
+    /// <summary>
+    /// Averages 2x2 blocks from two source rows into one row of half the
+    /// width: each channel is (a + b + c + d + 2) / 4.
+    /// </summary>
+    internal static void Downscale2xRow(ReadOnlySpan<byte> top, ReadOnlySpan<byte> bottom, Span<byte> destination, bool swapRedBlue)
+    {
+        ref var t = ref MemoryMarshal.GetReference(top);
+        ref var b = ref MemoryMarshal.GetReference(bottom);
+        ref var dst = ref MemoryMarshal.GetReference(destination);
+        var outLength = Math.Min(top.Length, bottom.Length) / 2 & ~(BytesPerPixel - 1);
+        _ = destination[..outLength];
+        var o = 0;
+
+        // Four output pixels per step, from eight pixels of each row
+        if (AdvSimd.Arm64.IsSupported)
+        {
+            for (; o + Vector128<byte>.Count <= outLength; o += Vector128<byte>.Count)
+            {
+                var i = (nuint)(o * 2);
+                var t0 = Vector128.LoadUnsafe(ref t, i).AsUInt32();
+                var t1 = Vector128.LoadUnsafe(ref t, i + 16).AsUInt32();
+                var b0 = Vector128.LoadUnsafe(ref b, i).AsUInt32();
+                var b1 = Vector128.LoadUnsafe(ref b, i + 16).AsUInt32();
+
+                // Left and right pixel of each block, then widened sums per channel
+                var tl = AdvSimd.Arm64.UnzipEven(t0, t1).AsByte();
+                var tr = AdvSimd.Arm64.UnzipOdd(t0, t1).AsByte();
+                var bl = AdvSimd.Arm64.UnzipEven(b0, b1).AsByte();
+                var br = AdvSimd.Arm64.UnzipOdd(b0, b1).AsByte();
+
+                var lower = AdvSimd.Add(
+                    AdvSimd.AddWideningLower(tl.GetLower(), tr.GetLower()),
+                    AdvSimd.AddWideningLower(bl.GetLower(), br.GetLower()));
+                var upper = AdvSimd.Add(
+                    AdvSimd.AddWideningUpper(tl, tr),
+                    AdvSimd.AddWideningUpper(bl, br));
+
+                var averaged = AdvSimd.ShiftRightLogicalRoundedNarrowingUpper(
+                    AdvSimd.ShiftRightLogicalRoundedNarrowingLower(lower, 2), upper, 2);
+
+                if (swapRedBlue)
+                {
+                    averaged = AdvSimd.Arm64.VectorTableLookup(averaged, SwapRedBlueMask);
+                }
+
+                averaged.StoreUnsafe(ref dst, (nuint)o);
+            }
+        }
+        else if (Ssse3.IsSupported)
+        {
+            var two = Vector128.Create((ushort)2);
+            for (; o + Vector128<byte>.Count <= outLength; o += Vector128<byte>.Count)
+            {
+                var i = (nuint)(o * 2);
+                var t0 = Vector128.LoadUnsafe(ref t, i).AsSingle();
+                var t1 = Vector128.LoadUnsafe(ref t, i + 16).AsSingle();
+                var b0 = Vector128.LoadUnsafe(ref b, i).AsSingle();
+                var b1 = Vector128.LoadUnsafe(ref b, i + 16).AsSingle();
+
+                var tl = Sse.Shuffle(t0, t1, 0b10_00_10_00).AsByte();
+                var tr = Sse.Shuffle(t0, t1, 0b11_01_11_01).AsByte();
+                var bl = Sse.Shuffle(b0, b1, 0b10_00_10_00).AsByte();
+                var br = Sse.Shuffle(b0, b1, 0b11_01_11_01).AsByte();
+
+                var lower = SumLow(tl, tr, bl, br) + two;
+                var upper = SumHigh(tl, tr, bl, br) + two;
+                var averaged = Sse2.PackUnsignedSaturate(
+                    Sse2.ShiftRightLogical(lower, 2).AsInt16(),
+                    Sse2.ShiftRightLogical(upper, 2).AsInt16());
+
+                if (swapRedBlue)
+                {
+                    averaged = Ssse3.Shuffle(averaged, SwapRedBlueMask);
+                }
+
+                averaged.StoreUnsafe(ref dst, (nuint)o);
+            }
+        }
+
+        Downscale2xRowScalar(top[(o * 2)..], bottom[(o * 2)..], destination[o..outLength], swapRedBlue);
+    }
+
+    /// <summary>Scalar <see cref="Downscale2xRow"/>.</summary>
+    internal static void Downscale2xRowScalar(ReadOnlySpan<byte> top, ReadOnlySpan<byte> bottom, Span<byte> destination, bool swapRedBlue)
+    {
+        for (var o = 0; o + BytesPerPixel <= destination.Length; o += BytesPerPixel)
+        {
+            var i = o * 2;
+            for (var c = 0; c < BytesPerPixel; c++)
+            {
+                var sum = top[i + c] + top[i + BytesPerPixel + c] + bottom[i + c] + bottom[i + BytesPerPixel + c];
+                var channel = swapRedBlue && c != 1 && c != 3 ? 2 - c : c;
+                destination[o + channel] = (byte)((sum + 2) >> 2);
+            }
+        }
+    }
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    private static Vector128<ushort> SumLow(Vector128<byte> a, Vector128<byte> b, Vector128<byte> c, Vector128<byte> d) =>
+        Sse2.UnpackLow(a, Vector128<byte>.Zero).AsUInt16() + Sse2.UnpackLow(b, Vector128<byte>.Zero).AsUInt16() +
+        Sse2.UnpackLow(c, Vector128<byte>.Zero).AsUInt16() + Sse2.UnpackLow(d, Vector128<byte>.Zero).AsUInt16();
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    private static Vector128<ushort> SumHigh(Vector128<byte> a, Vector128<byte> b, Vector128<byte> c, Vector128<byte> d) =>
+        Sse2.UnpackHigh(a, Vector128<byte>.Zero).AsUInt16() + Sse2.UnpackHigh(b, Vector128<byte>.Zero).AsUInt16() +
+        Sse2.UnpackHigh(c, Vector128<byte>.Zero).AsUInt16() + Sse2.UnpackHigh(d, Vector128<byte>.Zero).AsUInt16();
+}
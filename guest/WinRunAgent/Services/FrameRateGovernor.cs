@@ -0,0 +1,196 @@
+namespace WinRun.Agent.Services;
+
+/// <summary>
+/// Why a window is captured at its current rate. Sent to the host with each
+/// FrameReady so the bridge can show it in the stream's stats.
+/// Values match FRAME_RATE_REASONS in shared/protocol.def.
+/// </summary>
+public enum FrameRateReason
+{
+    /// <summary>Focused on the host: captured at the focused rate.</summary>
+    Focused,
+
+    /// <summary>Following how often the window's content changes.</summary>
+    Damage,
+
+    /// <summary>Changing at least as fast as its visibility allows; held at that cap.</summary>
+    Capped,
+
+    /// <summary>Slowed down because the host is skipping the window's frames to keep up.</summary>
+    Backpressure
+}
+
+/// <summary>
+/// A window's capture rate and the reason for it.
+/// </summary>
+public readonly record struct FrameRateDecision(int TargetFps, FrameRateReason Reason)
+{
+    /// <summary>Minimum time between frames for this rate.</summary>
+    public int MinIntervalMs => 1000 / Math.Max(TargetFps, 1);
+}
+
+/// <summary>
+/// Sets each window's capture rate from how often it changes, its host
+/// visibility and focus, and whether the host keeps up with its frames.
+/// </summary>
+/// <remarks>
+/// The focused window gets the focused rate. Other windows get about twice
+/// their change rate, so a window that starts changing faster ramps up within
+/// a few frames, down to <c>minFps</c> for one that doesn't change, and never
+/// above what its visibility allows. A host report of skipped frames halves
+/// the rate; every further report within <see cref="BackpressureHold"/>
+/// halves it again.
+/// A lowered rate never delays the first change after a quiet period: the
+/// interval runs from the window's last frame.
+/// </remarks>
+internal sealed class FrameRateGovernor
+{
+    // Changes are counted with an exponential decay over about this long
+    private static readonly TimeSpan DamageWindow = TimeSpan.FromMilliseconds(500);
+
+    // How long a backpressure cut holds after the host last reported skipped frames
+    private static readonly TimeSpan BackpressureHold = TimeSpan.FromSeconds(1);
+
+    // Capture this much faster than the window changes
+    private const double Headroom = 2.0;
+
+    private readonly int _minFps;
+    private readonly Dictionary<ulong, WindowRate> _windows = [];
+    private readonly object _lock = new();
+
+    /// <param name="minFps">Lowest rate for a visible window that has stopped changing.</param>
+    public FrameRateGovernor(int minFps)
+    {
+        _minFps = Math.Max(minFps, 1);
+    }
+
+    /// <summary>
+    /// Records whether a window changed in a desktop frame, whether or not it was captured.
+    /// </summary>
+    public void ObserveDamage(ulong windowId, bool changed, DateTime now)
+    {
+        lock (_lock)
+        {
+            var rate = GetOrAdd(windowId);
+            rate.ChangeScore = DecayedScore(rate, now) + (changed ? 1 : 0);
+            rate.LastObserved = now;
+        }
+    }
+
+    /// <summary>
+    /// Records that the host skipped some of a window's frames, so it is behind on it.
+    /// </summary>
+    public void ObserveBackpressure(ulong windowId, DateTime now)
+    {
+        lock (_lock)
+        {
+            var rate = GetOrAdd(windowId);
+            var current = rate.Decision is { TargetFps: > 0 } decision ? decision.TargetFps : _minFps * 2;
+            rate.BackpressureFps = Math.Max(_minFps, current / 2);
+            rate.BackpressureAt = now;
+        }
+    }
+
+    /// <summary>
+    /// Works out a window's rate.
+    /// </summary>
+    /// <param name="maxFps">Most the window's host visibility allows.</param>
+    /// <param name="isFocused">Whether the window is focused on the host.</param>
+    /// <param name="changed">True if the decision differs from the window's previous one.</param>
+    public FrameRateDecision Evaluate(ulong windowId, int maxFps, bool isFocused, DateTime now, out bool changed)
+    {
+        lock (_lock)
+        {
+            var rate = GetOrAdd(windowId);
+            var decision = Decide(rate, Math.Max(maxFps, _minFps), isFocused, now);
+            changed = rate.Decision is { } previous && previous != decision;
+            rate.Decision = decision;
+            return decision;
+        }
+    }
+
+    /// <summary>
+    /// The last decision for a window, or null if it hasn't been evaluated.
+    /// </summary>
+    public FrameRateDecision? GetDecision(ulong windowId)
+    {
+        lock (_lock)
+        {
+            return _windows.TryGetValue(windowId, out var rate) ? rate.Decision : null;
+        }
+    }
+
+    /// <summary>
+    /// Forgets windows that no longer exist.
+    /// </summary>
+    public void RemoveStale(IReadOnlySet<ulong> activeWindowIds)
+    {
+        lock (_lock)
+        {
+            foreach (var id in _windows.Keys.Where(id => !activeWindowIds.Contains(id)).ToList())
+            {
+                _ = _windows.Remove(id);
+            }
+        }
+    }
+
+    private FrameRateDecision Decide(WindowRate rate, int maxFps, bool isFocused, DateTime now)
+    {
+        FrameRateDecision decision;
+        if (isFocused)
+        {
+            decision = new FrameRateDecision(maxFps, FrameRateReason.Focused);
+        }
+        else if (rate.LastObserved == default)
+        {
+            // Nothing seen yet; start at the cap and come down as the window is watched
+            decision = new FrameRateDecision(maxFps, FrameRateReason.Capped);
+        }
+        else
+        {
+            var changesPerSecond = DecayedScore(rate, now) / DamageWindow.TotalSeconds;
+            var target = (int)Math.Ceiling(changesPerSecond * Headroom);
+            decision = target >= maxFps
+                ? new FrameRateDecision(maxFps, FrameRateReason.Capped)
+                : new FrameRateDecision(Math.Max(target, _minFps), FrameRateReason.Damage);
+        }
+
+        if (now - rate.BackpressureAt < BackpressureHold && rate.BackpressureFps < decision.TargetFps)
+        {
+            decision = new FrameRateDecision(rate.BackpressureFps, FrameRateReason.Backpressure);
+        }
+
+        return decision;
+    }
+
+    private static double DecayedScore(WindowRate rate, DateTime now)
+    {
+        if (rate.LastObserved == default)
+        {
+            return 0;
+        }
+
+        var elapsed = Math.Max((now - rate.LastObserved).TotalSeconds, 0);
+        return rate.ChangeScore * Math.Exp(-elapsed / DamageWindow.TotalSeconds);
+    }
+
+    private WindowRate GetOrAdd(ulong windowId)
+    {
+        if (!_windows.TryGetValue(windowId, out var rate))
+        {
+            rate = new WindowRate();
+            _windows[windowId] = rate;
+        }
+
+        return rate;
+    }
+
+    private sealed class WindowRate
+    {
+        public double ChangeScore;
+        public DateTime LastObserved;
+        public DateTime BackpressureAt;
+        public int BackpressureFps;
+        public FrameRateDecision? Decision;
+    }
+}
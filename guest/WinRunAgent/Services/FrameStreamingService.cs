@@ -1,3 +1,4 @@
+using System.Diagnostics;
 using System.Threading.Channels;
 
 namespace WinRun.Agent.Services;
@@ -35,6 +36,78 @@ public sealed record FrameStreamingConfig
     /// </summary>
     public FrameBufferMode BufferMode { get; init; } = FrameBufferMode.Uncompressed;
 
+    /// <summary>
+    /// Frame rate cap for windows the host reports as background when the
+    /// throttle hint does not carry its own limit.
+    /// </summary>
+    public int BackgroundMaxFps { get; init; } = 2;
+
+    /// <summary>
+    /// Send only moved and dirty regions, instead of whole frames, when the
+    /// capture source reports damage. Only used when frames aren't compressed.
+    /// </summary>
+    public bool EnableDamageFrames { get; init; } = true;
+
+    /// <summary>
+    /// Dirty area, as a fraction of the window, above which a key frame is sent instead.
+    /// </summary>
+    public double DamageKeyFrameThreshold { get; init; } = 0.5;
+
+    /// <summary>Most rectangles a damage frame may carry before a key frame is sent instead.</summary>
+    public int MaxDamageRects { get; init; } = 256;
+
+    /// <summary>
+    /// Minimum interval between key frames for a window that keeps changing
+    /// (milliseconds), so a host that lost its copy recovers. 0 disables the refresh.
+    /// </summary>
+    public int KeyFrameIntervalMs { get; init; } = 5000;
+
+    /// <summary>
+    /// Most windows cropped, compressed and written at the same time for one
+    /// desktop frame. 1 writes them one after another.
+    /// </summary>
+    public int MaxParallelWindows { get; init; } = Math.Clamp(Environment.ProcessorCount / 2, 1, 4);
+
+    /// <summary>
+    /// Capture the next desktop frame while the previous one is still being
+    /// written to the window buffers. Requires a capture source whose frames
+    /// stay valid until the capture after next.
+    /// </summary>
+    public bool PipelineCapture { get; init; } = true;
+
+    /// <summary>
+    /// How often the capture loop re-checks for demand while every window is
+    /// hidden or minimized (milliseconds). Throttle hints and window events
+    /// wake it sooner.
+    /// </summary>
+    public int IdleDemandCheckMs { get; init; } = 1000;
+
+    /// <summary>
+    /// Pace the capture loop with a high-resolution waitable timer where the
+    /// OS supports one, instead of the ~15.6 ms system tick.
+    /// </summary>
+    public bool UseHighResolutionTimer { get; init; } = true;
+
+    /// <summary>
+    /// Set each window's capture rate from how often it changes, host focus and
+    /// ring backpressure (see <see cref="FrameRateGovernor"/>). When false,
+    /// windows are captured at their visibility's fixed interval.
+    /// </summary>
+    public bool EnableFrameRateGovernor { get; init; } = true;
+
+    /// <summary>Frame rate for the window focused on the host. Also raises the loop above <see cref="TargetFps"/>.</summary>
+    public int FocusedMaxFps { get; init; } = 60;
+
+    /// <summary>Lowest frame rate the governor gives a visible window that has stopped changing.</summary>
+    public int MinWindowFps { get; init; } = 1;
+
+    /// <summary>
+    /// Send windows at half their captured size, averaging each 2x2 block:
+    /// for a guest desktop at 200% scaling shown on a host display that
+    /// doesn't need the extra pixels. Halved windows always get key frames.
+    /// </summary>
+    public bool DownscaleWindows { get; init; }
+
     /// <summary>Computed target frame interval in milliseconds.</summary>
     public int TargetFrameIntervalMs => 1000 / TargetFps;
 }
@@ -47,17 +120,39 @@ public sealed class FrameStreamingService : IDisposable
 {
     private readonly IAgentLogger _logger;
     private readonly WindowTracker _windowTracker;
-    private readonly DesktopDuplicationBridge _desktopDuplication;
+    private readonly IFrameCaptureSource _captureSource;
     private readonly PerWindowBufferManager _bufferManager;
     private readonly ChannelWriter<GuestMessage> _outboundWriter;
     private readonly FrameStreamingConfig _config;
     private readonly FrameCompressor? _compressor;
+    private readonly FrameRateGovernor? _governor;
 
     private readonly Dictionary<ulong, WindowFrameState> _windowFrameStates = [];
+    private readonly Dictionary<ulong, WindowThrottle> _windowThrottles = [];
+    private readonly Dictionary<ulong, TimeSpan> _hostDecodeTimes = [];
+    private readonly Dictionary<ulong, WindowDamageTracker> _damageTrackers = [];
     private readonly object _stateLock = new();
 
+    // Staging buffers for compressed frames, one set per window being written
+    // at a time; they grow to the largest frame and are reused
+    private readonly Stack<FrameScratch> _scratchPool = new();
+
+    // Windows to write for the desktop frame being streamed; only one frame
+    // is streamed at a time
+    private readonly List<WindowWork> _windowWork = [];
+
+    // Completed when a throttle hint or window event may have changed what
+    // needs capturing; replaced each time it fires
+    private TaskCompletionSource _demandChanged = new(TaskCreationOptions.RunContinuationsAsynchronously);
+
     private CancellationTokenSource? _cts;
     private Task? _captureTask;
+    private Task? _pendingStream;
+
+    // The newest captured frame, still the current desktop while captures
+    // return nothing; resent when a window skipped for its rate is due
+    private CapturedFrame? _lastFrame;
+    private int _trailingDamage;
     private uint _frameCounter;
     private int _consecutiveFailures;
     private bool _disposed;
@@ -67,21 +162,21 @@ public sealed class FrameStreamingService : IDisposable
     /// </summary>
     /// <param name="logger">Logger for diagnostics.</param>
     /// <param name="windowTracker">Window tracker for per-window capture.</param>
-    /// <param name="desktopDuplication">Desktop duplication bridge for frame capture.</param>
+    /// <param name="captureSource">Desktop frame source, normally a <see cref="DesktopDuplicationBridge"/>.</param>
     /// <param name="outboundChannel">Channel for sending FrameReady notifications to host.</param>
     /// <param name="config">Optional configuration settings.</param>
     /// <param name="sharedMemoryAllocator">Optional shared memory allocator for zero-copy frame transfer.</param>
     public FrameStreamingService(
         IAgentLogger logger,
         WindowTracker windowTracker,
-        DesktopDuplicationBridge desktopDuplication,
+        IFrameCaptureSource captureSource,
         Channel<GuestMessage> outboundChannel,
         FrameStreamingConfig? config = null,
         SharedMemoryAllocator? sharedMemoryAllocator = null)
     {
         _logger = logger;
         _windowTracker = windowTracker;
-        _desktopDuplication = desktopDuplication;
+        _captureSource = captureSource;
         _outboundWriter = outboundChannel.Writer;
         _config = config ?? new FrameStreamingConfig();
 
@@ -97,12 +192,20 @@ public sealed class FrameStreamingService : IDisposable
         if (_config.BufferMode == FrameBufferMode.Compressed && _config.Compression is { Enabled: true })
         {
             _compressor = new FrameCompressor(logger, _config.Compression);
-            _logger.Info($"Frame compression enabled: level={_config.Compression.CompressionLevel}");
+            _logger.Info($"Frame compression enabled: codec={_config.Compression.Codec}, level={_config.Compression.CompressionLevel}");
         }
         else if (_config.BufferMode == FrameBufferMode.Uncompressed)
         {
             _logger.Info("Frame buffer mode: Uncompressed (exact allocation, lowest latency)");
         }
+
+        if (_config.EnableFrameRateGovernor)
+        {
+            _governor = new FrameRateGovernor(_config.MinWindowFps);
+        }
+
+        // Windows appearing, restoring or closing change what the loop needs to capture
+        _windowTracker.WindowEvent += OnWindowEvent;
     }
 
     /// <summary>
@@ -148,6 +251,119 @@ public sealed class FrameStreamingService : IDisposable
         _logger.Info($"Frame buffer mode updated to: {mode}");
     }
 
+    /// <summary>
+    /// Applies a host visibility hint to a window.
+    /// Hidden windows are not captured at all; background windows are captured
+    /// at most <paramref name="maxFps"/> times per second (or
+    /// <see cref="FrameStreamingConfig.BackgroundMaxFps"/> when zero).
+    /// Visible windows use the normal per-window interval, optionally capped by
+    /// <paramref name="maxFps"/>. With the governor enabled, the focused window
+    /// may go up to <see cref="FrameStreamingConfig.FocusedMaxFps"/> and the
+    /// governor lowers the rest below these caps.
+    /// </summary>
+    /// <param name="windowId">The window the hint applies to.</param>
+    /// <param name="visibility">Visibility of the window on the host.</param>
+    /// <param name="maxFps">Frame rate cap, or 0 for the default for this visibility.</param>
+    /// <param name="isFocused">Whether the window is focused on the host.</param>
+    public void SetWindowThrottle(ulong windowId, StreamVisibility visibility, int maxFps, bool isFocused = false)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        isFocused = isFocused && visibility == StreamVisibility.Visible && _governor != null;
+
+        if (maxFps == 0 && visibility == StreamVisibility.Background)
+        {
+            maxFps = _config.BackgroundMaxFps;
+        }
+
+        int minIntervalMs;
+        if (isFocused)
+        {
+            maxFps = maxFps > 0 ? Math.Min(maxFps, _config.FocusedMaxFps) : _config.FocusedMaxFps;
+            minIntervalMs = 1000 / maxFps;
+        }
+        else
+        {
+            minIntervalMs = _config.MinWindowFrameIntervalMs;
+            if (maxFps > 0)
+            {
+                minIntervalMs = Math.Max(minIntervalMs, 1000 / maxFps);
+            }
+
+            maxFps = IntervalToFps(minIntervalMs);
+        }
+
+        lock (_stateLock)
+        {
+            if (visibility == StreamVisibility.Visible && !isFocused && minIntervalMs == _config.MinWindowFrameIntervalMs)
+            {
+                _ = _windowThrottles.Remove(windowId);
+            }
+            else
+            {
+                _windowThrottles[windowId] = new WindowThrottle(visibility, minIntervalMs, maxFps, isFocused);
+            }
+        }
+
+        SignalDemandChanged();
+
+        _logger.Debug($"Window {windowId}: visibility={visibility}, focused={isFocused}, minInterval={minIntervalMs}ms");
+    }
+
+    /// <summary>
+    /// Records how long the host takes to decode one of the window's tiled
+    /// frames. It comes out of the window's LZ4 budget, so a host that is slow
+    /// to decode gets more raw tiles, which it only has to copy.
+    /// </summary>
+    public void SetHostDecodeTime(ulong windowId, TimeSpan decodeTime)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        lock (_stateLock)
+        {
+            _hostDecodeTimes[windowId] = decodeTime;
+        }
+    }
+
+    /// <summary>
+    /// Gets the host's last reported decode time for a window's tiled frames,
+    /// or zero if it hasn't reported one.
+    /// </summary>
+    internal TimeSpan GetHostDecodeTime(ulong windowId)
+    {
+        lock (_stateLock)
+        {
+            return _hostDecodeTimes.GetValueOrDefault(windowId);
+        }
+    }
+
+    /// <summary>
+    /// Records that the host skipped some of a window's frames to catch up,
+    /// so the governor slows the window down. This is the only backpressure
+    /// signal: the host doesn't hand per-window slots back, so the guest
+    /// can't tell from its own ring how far behind the host is.
+    /// </summary>
+    public void ObserveHostBacklog(ulong windowId)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        _governor?.ObserveBackpressure(windowId, DateTime.UtcNow);
+    }
+
+    /// <summary>
+    /// Gets the visibility last reported by the host for a window.
+    /// Windows without a hint are treated as visible.
+    /// </summary>
+    public StreamVisibility GetWindowVisibility(ulong windowId)
+    {
+        lock (_stateLock)
+        {
+            return _windowThrottles.TryGetValue(windowId, out var throttle)
+                ? throttle.Visibility
+                : StreamVisibility.Visible;
+        }
+    }
+
     /// <summary>
     /// Starts the frame capture loop.
     /// </summary>
@@ -212,13 +428,28 @@ public sealed class FrameStreamingService : IDisposable
             return;
         }
 
-        var targetInterval = TimeSpan.FromMilliseconds(_config.TargetFrameIntervalMs);
+        using var pacer = new FramePacer(_config.UseHighResolutionTimer);
+        if (pacer.IsHighResolution)
+        {
+            _logger.Debug("Capture loop paced with a high-resolution timer");
+        }
 
         try
         {
             while (!token.IsCancellationRequested)
             {
-                var frameStart = DateTime.UtcNow;
+                // Taken before checking, so a change in between still wakes the wait below
+                var demandChanged = _demandChanged.Task;
+                if (!TryGetCaptureInterval(out var interval))
+                {
+                    // The host isn't showing anything: sleep until a hint or window event
+                    Stats.RecordIdleWait();
+                    _ = await Task.WhenAny(demandChanged, Task.Delay(_config.IdleDemandCheckMs, token));
+                    continue;
+                }
+
+                // A faster loop leaves less time per frame for LZ4 tiles
+                _compressor?.SetFrameInterval(interval);
 
                 try
                 {
@@ -235,6 +466,9 @@ public sealed class FrameStreamingService : IDisposable
                     Stats.RecordCaptureError();
                     _logger.Error($"Frame capture error ({_consecutiveFailures}/{_config.MaxConsecutiveFailures}): {ex.Message}");
 
+                    // A frame may have stopped partway through its windows; don't send damage against it
+                    InvalidateDamageTrackers();
+
                     if (_consecutiveFailures >= _config.MaxConsecutiveFailures)
                     {
                         _logger.Warn("Too many consecutive failures, attempting reinitialization");
@@ -243,21 +477,105 @@ public sealed class FrameStreamingService : IDisposable
                     }
                 }
 
-                // Maintain target frame rate
-                var elapsed = DateTime.UtcNow - frameStart;
-                var delay = targetInterval - elapsed;
-                if (delay > TimeSpan.Zero)
-                {
-                    await Task.Delay(delay, token);
-                }
+                // Capture already waited for the desktop to change; this only caps the rate
+                Stats.RecordPacingWait(await pacer.WaitAsync(interval, token));
             }
         }
+        catch (OperationCanceledException) when (token.IsCancellationRequested)
+        {
+            // Stopping
+        }
         finally
         {
+            // Don't return while a pipelined frame is still writing to the buffers
+            if (_pendingStream is { } pending)
+            {
+                _pendingStream = null;
+                try
+                {
+                    await pending;
+                }
+                catch (Exception ex) when (ex is OperationCanceledException || token.IsCancellationRequested)
+                {
+                    // Stopping
+                }
+            }
+
             _logger.Debug("Frame capture loop ended");
         }
     }
 
+    /// <summary>
+    /// Works out how often the loop needs to capture: as often as the most
+    /// demanding window the host is showing, but no faster than the target
+    /// rate (or the focused rate, for the focused window). This follows the
+    /// host's caps, not the governor: a capture that finds nothing changed
+    /// costs only the wait, and the loop must notice a quiet window's next change.
+    /// </summary>
+    /// <param name="interval">Time between captures, when there is demand.</param>
+    /// <returns>False if every window is hidden or minimized, so nothing needs capturing.</returns>
+    internal bool TryGetCaptureInterval(out TimeSpan interval)
+    {
+        var minIntervalMs = int.MaxValue;
+
+        lock (_stateLock)
+        {
+            if (_config.EnablePerWindowCapture)
+            {
+                foreach (var (hwnd, metadata) in _windowTracker.TrackedWindows)
+                {
+                    if (!metadata.IsMinimized)
+                    {
+                        minIntervalMs = Math.Min(minIntervalMs, GetWindowIntervalMs((ulong)hwnd));
+                    }
+                }
+            }
+            else
+            {
+                minIntervalMs = GetWindowIntervalMs(DesktopWindowId);
+            }
+        }
+
+        if (minIntervalMs == int.MaxValue)
+        {
+            interval = TimeSpan.Zero;
+            return false;
+        }
+
+        interval = TimeSpan.FromMilliseconds(minIntervalMs);
+        return true;
+    }
+
+    /// <summary>
+    /// How often the loop must run for a window, or int.MaxValue if the host hides it.
+    /// Only the focused window may run the loop faster than the target rate.
+    /// Callers hold <see cref="_stateLock"/>.
+    /// </summary>
+    private int GetWindowIntervalMs(ulong windowId)
+    {
+        if (!_windowThrottles.TryGetValue(windowId, out var throttle))
+        {
+            return Math.Max(_config.MinWindowFrameIntervalMs, _config.TargetFrameIntervalMs);
+        }
+
+        if (throttle.Visibility == StreamVisibility.Hidden)
+        {
+            return int.MaxValue;
+        }
+
+        return throttle.IsFocused ? throttle.MinIntervalMs : Math.Max(throttle.MinIntervalMs, _config.TargetFrameIntervalMs);
+    }
+
+    private static int IntervalToFps(int intervalMs) => intervalMs > 0 ? Math.Max(1000 / intervalMs, 1) : 1000;
+
+    private void SignalDemandChanged()
+    {
+        var next = new TaskCompletionSource(TaskCreationOptions.RunContinuationsAsynchronously);
+        _ = Interlocked.Exchange(ref _demandChanged, next).TrySetResult();
+    }
+
+    private void OnWindowEvent(object? sender, WindowEventArgs e) => SignalDemandChanged();
+
     private async Task<bool> TryInitializeDesktopDuplicationAsync(CancellationToken token)
     {
         const int maxAttempts = 3;
@@ -269,9 +587,9 @@ public sealed class FrameStreamingService : IDisposable
                 return false;
             }
 
-            if (_desktopDuplication.Initialize())
+            if (_captureSource.Initialize())
             {
-                _logger.Info($"Desktop duplication initialized: {_desktopDuplication.OutputWidth}x{_desktopDuplication.OutputHeight}");
+                _logger.Info($"Desktop duplication initialized: {_captureSource.OutputWidth}x{_captureSource.OutputHeight}");
                 return true;
             }
 
@@ -289,6 +607,7 @@ public sealed class FrameStreamingService : IDisposable
     private async Task ReinitializeDesktopDuplicationAsync(CancellationToken token)
     {
         _logger.Info("Reinitializing desktop duplication");
+        _lastFrame = null;
 
         // Wait before reinitializing
         await Task.Delay(_config.ReinitializationDelayMs, token);
@@ -304,15 +623,62 @@ public sealed class FrameStreamingService : IDisposable
     {
         Stats.RecordCaptureAttempt();
 
-        // Capture full desktop frame
-        var frame = _desktopDuplication.CaptureFrame(_config.CaptureTimeoutMs);
+        // Capture full desktop frame, possibly while the previous one is still being written
+        var threadId = Environment.CurrentManagedThreadId;
+        var allocatedBefore = GC.GetAllocatedBytesForCurrentThread();
+        var captureStart = Stopwatch.GetTimestamp();
+
+        var frame = _captureSource.CaptureFrame(_config.CaptureTimeoutMs);
+
+        if (frame != null)
+        {
+            Stats.RecordCaptureTime(Stopwatch.GetElapsedTime(captureStart));
+        }
+
+        // Exact only if nothing above switched threads, which is the usual case
+        if (Environment.CurrentManagedThreadId == threadId)
+        {
+            Stats.RecordCaptureAllocations(GC.GetAllocatedBytesForCurrentThread() - allocatedBefore);
+        }
+
+        // Frames are written in order, so each window's damage applies to what the host has
+        if (_pendingStream is { } previous)
+        {
+            _pendingStream = null;
+            await previous;
+        }
+
         if (frame == null)
         {
-            // No new frame available - this is normal when screen is static
-            return;
+            // No new frame available - this is normal when screen is static.
+            // A window skipped for its rate may still owe the host its last
+            // change, and the newest frame is still what's on screen.
+            if (_lastFrame is not { } last || Interlocked.Exchange(ref _trailingDamage, 0) == 0)
+            {
+                return;
+            }
+
+            frame = last with { Damage = FrameDamage.Empty };
+        }
+        else
+        {
+            Stats.RecordFrameCaptured();
+            _lastFrame = frame;
         }
 
-        Stats.RecordFrameCaptured();
+        if (_config.PipelineCapture)
+        {
+            _pendingStream = Task.Run(() => StreamCapturedFrameAsync(frame, token), token);
+        }
+        else
+        {
+            await StreamCapturedFrameAsync(frame, token);
+        }
+    }
+
+    private async Task StreamCapturedFrameAsync(CapturedFrame frame, CancellationToken token)
+    {
+        var streamStart = Stopwatch.GetTimestamp();
 
         if (_config.EnablePerWindowCapture)
         {
@@ -324,13 +690,18 @@ public sealed class FrameStreamingService : IDisposable
             // Stream full desktop frame
             await StreamFullDesktopFrameAsync(frame, token);
         }
+
+        Stats.RecordFrameTime(Stopwatch.GetElapsedTime(streamStart));
     }
 
     private async Task StreamPerWindowFramesAsync(CapturedFrame desktopFrame, CancellationToken token)
     {
         var trackedWindows = _windowTracker.TrackedWindows;
         var now = DateTime.UtcNow;
+        var desktop = new Rect(0, 0, desktopFrame.Width, desktopFrame.Height);
 
+        // Decide what each window needs first; the writes then run in parallel
+        _windowWork.Clear();
         foreach (var (hwnd, metadata) in trackedWindows)
         {
             if (token.IsCancellationRequested)
@@ -346,111 +717,367 @@ public sealed class FrameStreamingService : IDisposable
 
             var windowId = (ulong)hwnd;
 
+            // Same clipping as ExtractWindowRegion, so damage lines up with the frame
+            if (FrameDamage.Intersect(metadata.Bounds, desktop) is not { } bounds)
+            {
+                continue;
+            }
+
+            var damage = desktopFrame.Damage?.ForWindow(bounds);
+            var tracker = GetDamageTracker(windowId);
+            _governor?.ObserveDamage(windowId, changed: damage is not { IsEmpty: true }, now);
+
             // Check if enough time has passed since last frame for this window
             if (!ShouldCaptureWindow(windowId, now))
             {
+                // Keep what changed so the next frame for this window covers it,
+                // even if nothing else changes on screen before it's due. A
+                // resend that came too early re-arms itself while the window
+                // still owes the host a change.
+                tracker.Accumulate(damage, _config.MaxDamageRects);
+                if ((damage is not { IsEmpty: true } || tracker.IsBehind) &&
+                    GetWindowVisibility(windowId) != StreamVisibility.Hidden)
+                {
+                    _ = Interlocked.Exchange(ref _trailingDamage, 1);
+                }
+
                 continue;
             }
 
-            // Extract window region from desktop frame
-            var windowFrame = DesktopDuplicationBridge.ExtractWindowRegion(desktopFrame, metadata.Bounds);
-            if (windowFrame == null)
+            if (tracker.IsUpToDate(bounds, damage))
             {
+                Stats.RecordWindowUnchanged();
                 continue;
             }
 
-            // Write to shared memory and notify host
-            await WriteFrameAndNotifyAsync(windowId, windowFrame, token);
+            _windowWork.Add(new WindowWork(windowId, bounds, damage, tracker));
+        }
+
+        if (_windowWork.Count <= 1 || _config.MaxParallelWindows <= 1)
+        {
+            foreach (var work in _windowWork)
+            {
+                await StreamWindowWorkAsync(work, desktopFrame, now, token);
+            }
 
-            // Update window frame state
-            UpdateWindowFrameState(windowId, now);
+            return;
         }
+
+        // Each window has its own ring and damage tracker, so windows don't
+        // contend; FrameReady notifications for different windows may interleave
+        var options = new ParallelOptions { MaxDegreeOfParallelism = _config.MaxParallelWindows, CancellationToken = token };
+        await Parallel.ForEachAsync(_windowWork, options, (work, ct) => StreamWindowWorkAsync(work, desktopFrame, now, ct));
+    }
+
+    /// <summary>
+    /// A window that gets a frame from the current desktop frame.
+    /// </summary>
+    private readonly record struct WindowWork(ulong WindowId, Rect Bounds, FrameDamage? Damage, WindowDamageTracker Tracker);
+
+    private async ValueTask StreamWindowWorkAsync(WindowWork work, CapturedFrame desktopFrame, DateTime now, CancellationToken token)
+    {
+        // Write to shared memory and notify host
+        await StreamWindowFrameAsync(work.WindowId, work.Bounds, desktopFrame, work.Damage, work.Tracker, now, token);
+
+        // Update window frame state
+        UpdateWindowFrameState(work.WindowId, now);
     }
 
     private async Task StreamFullDesktopFrameAsync(CapturedFrame frame, CancellationToken token)
     {
         // Use window ID 0 for full desktop
-        const ulong desktopWindowId = 0;
-        await WriteFrameAndNotifyAsync(desktopWindowId, frame, token);
+        var bounds = new Rect(0, 0, frame.Width, frame.Height);
+        var tracker = GetDamageTracker(DesktopWindowId);
+        if (tracker.IsUpToDate(bounds, frame.Damage))
+        {
+            Stats.RecordWindowUnchanged();
+            return;
+        }
+
+        await StreamWindowFrameAsync(DesktopWindowId, bounds, frame, frame.Damage, tracker, DateTime.UtcNow, token);
     }
 
-    private async Task WriteFrameAndNotifyAsync(ulong windowId, CapturedFrame frame, CancellationToken token)
+    private const ulong DesktopWindowId = 0;
+
+    /// <summary>
+    /// Sends one window's part of a desktop frame: a damage frame when the host
+    /// has the previous frame and the damage is small enough, otherwise a key frame.
+    /// </summary>
+    private async Task StreamWindowFrameAsync(
+        ulong windowId,
+        Rect bounds,
+        CapturedFrame desktopFrame,
+        FrameDamage? damage,
+        WindowDamageTracker tracker,
+        DateTime now,
+        CancellationToken token)
     {
-        var frameNumber = Interlocked.Increment(ref _frameCounter);
+        var threadId = Environment.CurrentManagedThreadId;
+        var allocatedBefore = GC.GetAllocatedBytesForCurrentThread();
+        var scratch = RentScratch();
 
-        // Compress frame data if compression is enabled
-        byte[] dataToWrite;
-        var isCompressed = false;
+        try
+        {
+            await StreamWindowFrameAsync(windowId, bounds, desktopFrame, damage, tracker, now, scratch, token);
+        }
+        finally
+        {
+            ReturnScratch(scratch);
+        }
 
-        if (_compressor != null)
+        // Exact only if the write didn't resume on another thread, which is the usual case
+        if (Environment.CurrentManagedThreadId == threadId)
         {
-            var compressionResult = _compressor.Compress(frame.Data);
-            dataToWrite = compressionResult.Data;
-            isCompressed = compressionResult.IsCompressed;
+            Stats.RecordWindowAllocations(GC.GetAllocatedBytesForCurrentThread() - allocatedBefore);
+        }
+    }
+
+    private async Task StreamWindowFrameAsync(
+        ulong windowId,
+        Rect bounds,
+        CapturedFrame desktopFrame,
+        FrameDamage? damage,
+        WindowDamageTracker tracker,
+        DateTime now,
+        FrameScratch scratch,
+        CancellationToken token)
+    {
+        var isDesktop = windowId == DesktopWindowId;
+        var downscale = !isDesktop && _config.DownscaleWindows && bounds.Width >= 2 && bounds.Height >= 2;
+        var width = downscale ? bounds.Width / 2 : bounds.Width;
+        var height = downscale ? bounds.Height / 2 : bounds.Height;
+        var stride = isDesktop ? desktopFrame.Stride : width * 4;
+
+        // Window crops are converted to BGRA; the whole desktop goes as captured
+        var format = isDesktop ? desktopFrame.Format : PixelFormatType.Bgra32;
+
+        var delta = downscale ? null : SelectDamage(tracker, bounds, damage, now);
+        if (delta != null)
+        {
+            var result = await WriteFrameAndNotifyAsync(
+                windowId, width, height, stride, format,
+                new SlotPayload(desktopFrame, bounds, delta, WholeFrame: false), scratch, token);
 
-            if (compressionResult.IsCompressed)
+            switch (result)
             {
-                Stats.RecordFrameCompressed(compressionResult.BytesSaved);
+                case FrameWriteResult.Written:
+                    Stats.RecordDamageFrameWritten();
+                    tracker.Committed(bounds, isKeyFrame: false, now);
+                    return;
+                case FrameWriteResult.Dropped:
+                    // The host will be missing this change; resync with a key frame
+                    tracker.Invalidate();
+                    return;
+                case FrameWriteResult.NeedsKeyFrame:
+                    break;
             }
         }
+
+        // Key frame: the whole window, cropped straight into the slot
+        var keyResult = await WriteFrameAndNotifyAsync(
+            windowId, width, height, stride, format,
+            new SlotPayload(desktopFrame, bounds, Damage: null, WholeFrame: isDesktop, downscale), scratch, token);
+
+        if (keyResult == FrameWriteResult.Written)
+        {
+            tracker.Committed(bounds, isKeyFrame: true, now);
+        }
         else
         {
-            dataToWrite = frame.Data;
+            tracker.Invalidate();
         }
+    }
+
+    /// <summary>
+    /// Returns the damage to send for a window, or null if it should get a key frame.
+    /// </summary>
+    private FrameDamage? SelectDamage(WindowDamageTracker tracker, Rect bounds, FrameDamage? damage, DateTime now)
+    {
+        // The host can't compose onto compressed key frames
+        if (!_config.EnableDamageFrames || _compressor != null)
+        {
+            return null;
+        }
+
+        var delta = tracker.Take(bounds, damage);
+        if (delta == null)
+        {
+            return null;
+        }
+
+        if (_config.KeyFrameIntervalMs > 0 &&
+            (now - tracker.LastKeyFrameTime).TotalMilliseconds >= _config.KeyFrameIntervalMs)
+        {
+            return null;
+        }
+
+        if (delta.MoveRects.Count + delta.DirtyRects.Count > _config.MaxDamageRects)
+        {
+            return null;
+        }
+
+        var windowArea = (long)bounds.Width * bounds.Height;
+        return delta.DirtyArea > windowArea * _config.DamageKeyFrameThreshold ? null : delta;
+    }
+
+    private WindowDamageTracker GetDamageTracker(ulong windowId)
+    {
+        lock (_stateLock)
+        {
+            if (!_damageTrackers.TryGetValue(windowId, out var tracker))
+            {
+                tracker = new WindowDamageTracker();
+                _damageTrackers[windowId] = tracker;
+            }
+
+            return tracker;
+        }
+    }
+
+    /// <summary>
+    /// Forces a key frame for every window, e.g. after a frame failed partway through.
+    /// </summary>
+    private void InvalidateDamageTrackers()
+    {
+        lock (_stateLock)
+        {
+            foreach (var tracker in _damageTrackers.Values)
+            {
+                tracker.Invalidate();
+            }
+        }
+    }
+
+    private async Task<FrameWriteResult> WriteFrameAndNotifyAsync(
+        ulong windowId,
+        int width,
+        int height,
+        int stride,
+        PixelFormatType format,
+        SlotPayload payload,
+        FrameScratch scratch,
+        CancellationToken token)
+    {
+        var isDamage = payload.Damage != null;
+        var encodeStart = Stopwatch.GetTimestamp();
 
         // Get or create per-window buffer
         var buffer = _bufferManager.GetOrCreateBuffer(windowId);
 
+        var slotHeader = new FrameSlotHeader
+        {
+            WindowId = windowId,
+            Width = (uint)width,
+            Height = (uint)height,
+            Stride = (uint)stride,
+            Format = (uint)format
+        };
+
+        // Compressed key frames go straight into a reserved slot once the
+        // window has a buffer. Tranches only grow, so a frame that fits the
+        // current slot never needs a reallocation first.
+        byte[]? staged = null;
+        var dataSize = payload.Size;
+        var isCompressed = false;
+
+        if (_compressor != null && !isDamage)
+        {
+            if (buffer.IsAllocated)
+            {
+                slotHeader.FrameNumber = Interlocked.Increment(ref _frameCounter);
+                switch (CompressIntoSlot(_compressor, buffer, slotHeader, payload, scratch, out var slotIndex, out dataSize))
+                {
+                    case SlotWriteResult.Written:
+                        Stats.RecordEncodeTime(Stopwatch.GetElapsedTime(encodeStart));
+                        Stats.RecordFrameWritten(dataSize);
+                        await NotifyFrameReadyAsync(windowId, slotIndex, slotHeader.FrameNumber, isKeyFrame: true, token);
+                        return FrameWriteResult.Written;
+                    case SlotWriteResult.BufferFull:
+                        Stats.RecordBufferFull();
+                        _logger.Debug($"Buffer full for window {windowId}, dropping frame {slotHeader.FrameNumber}");
+                        return FrameWriteResult.Dropped;
+                }
+            }
+
+            // First frame, or the slot is too small: stage it and grow the buffer
+            (staged, dataSize, isCompressed) = CompressToScratch(_compressor, slotHeader, payload, scratch);
+        }
+
         // Track if buffer was already allocated before this call
         var wasAlreadyAllocated = buffer.IsAllocated;
 
         // Ensure buffer is allocated for this frame size (may trigger reallocation)
-        var allocationChanged = buffer.EnsureAllocated(frame.Width, frame.Height, dataToWrite.Length);
+        var allocationChanged = buffer.EnsureAllocated(width, height, dataSize);
 
         // If buffer was (re)allocated, notify host
         if (allocationChanged)
         {
             await NotifyBufferAllocationAsync(windowId, buffer, isReallocation: wasAlreadyAllocated, token);
+
+            // A fresh buffer has nothing to apply damage to
+            if (isDamage)
+            {
+                return FrameWriteResult.NeedsKeyFrame;
+            }
         }
 
-        // Build frame slot header
-        var slotHeader = new FrameSlotHeader
+        if (slotHeader.FrameNumber == 0)
         {
-            WindowId = windowId,
-            FrameNumber = frameNumber,
-            Width = (uint)frame.Width,
-            Height = (uint)frame.Height,
-            Stride = (uint)frame.Stride,
-            Format = (uint)frame.Format,
-            DataSize = (uint)dataToWrite.Length,
-            Flags = isCompressed ? FrameSlotFlags.Compressed | FrameSlotFlags.KeyFrame : FrameSlotFlags.KeyFrame
-        };
+            slotHeader.FrameNumber = Interlocked.Increment(ref _frameCounter);
+        }
+
+        if (isDamage)
+        {
+            slotHeader.Flags = FrameSlotFlags.Damage;
+        }
+        else
+        {
+            slotHeader.Flags = isCompressed ? CompressedKeyFrameFlags(_compressor!) : FrameSlotFlags.KeyFrame;
+        }
+
+        slotHeader.DataSize = (uint)dataSize;
 
         // Write frame to per-window buffer
-        var slotIndex = buffer.WriteFrame(slotHeader, dataToWrite);
+        var writtenSlot = staged != null
+            ? buffer.WriteFrame(slotHeader, staged.AsSpan(0, dataSize))
+            : buffer.WriteFrame(slotHeader, payload, static (slot, p) => p.WriteTo(slot));
 
-        if (slotIndex < 0)
+        if (writtenSlot < 0)
         {
             Stats.RecordBufferFull();
-            _logger.Debug($"Buffer full for window {windowId}, dropping frame {frameNumber}");
-            return;
+            _logger.Debug($"Buffer full for window {windowId}, dropping frame {slotHeader.FrameNumber}");
+            return FrameWriteResult.Dropped;
         }
 
-        Stats.RecordFrameWritten();
+        Stats.RecordEncodeTime(Stopwatch.GetElapsedTime(encodeStart));
+        Stats.RecordFrameWritten(dataSize);
+        await NotifyFrameReadyAsync(windowId, writtenSlot, slotHeader.FrameNumber, isKeyFrame: !isDamage, token);
+        return FrameWriteResult.Written;
+    }
 
-        // Send FrameReady notification to host
+    /// <summary>
+    /// Sends the FrameReady notification for a committed slot.
+    /// </summary>
+    private async Task NotifyFrameReadyAsync(ulong windowId, int slotIndex, uint frameNumber, bool isKeyFrame, CancellationToken token)
+    {
+        // The host can't see the window's rate otherwise; report it with each frame
+        var rate = _governor?.GetDecision(windowId);
         var notification = new FrameReadyMessage
         {
             WindowId = windowId,
             SlotIndex = (uint)slotIndex,
             FrameNumber = frameNumber,
-            IsKeyFrame = true
+            IsKeyFrame = isKeyFrame,
+            TargetFps = rate?.TargetFps,
+            RateReason = rate?.Reason
         };
 
+        var notifyStart = Stopwatch.GetTimestamp();
         try
         {
             await _outboundWriter.WriteAsync(notification, token);
             Stats.RecordNotificationSent();
+            Stats.RecordNotifyTime(Stopwatch.GetElapsedTime(notifyStart));
         }
         catch (ChannelClosedException)
         {
@@ -458,6 +1085,186 @@ public sealed class FrameStreamingService : IDisposable
         }
     }
 
+    private enum SlotWriteResult
+    {
+        Written,
+        BufferFull,
+        DoesNotFit
+    }
+
+    /// <summary>
+    /// Compresses a key frame directly into the next free slot. Frames that
+    /// don't compress are copied into the slot raw if they fit.
+    /// </summary>
+    /// <param name="header">Header with everything but DataSize and Flags filled in.</param>
+    /// <param name="dataSize">Bytes committed to the slot.</param>
+    /// <returns>
+    /// <see cref="SlotWriteResult.DoesNotFit"/> if neither form fits the current
+    /// slot; nothing is committed and the caller stages the frame instead.
+    /// </returns>
+    private SlotWriteResult CompressIntoSlot(
+        FrameCompressor compressor,
+        WindowFrameBuffer buffer,
+        FrameSlotHeader header,
+        SlotPayload payload,
+        FrameScratch scratch,
+        out int slotIndex,
+        out int dataSize)
+    {
+        slotIndex = -1;
+        dataSize = 0;
+
+        if (!buffer.TryReserveSlot(buffer.SlotCapacity, out var reservation))
+        {
+            return SlotWriteResult.BufferFull;
+        }
+
+        var rawLength = payload.Size;
+        var raw = StageRaw(payload, scratch).AsSpan(0, rawLength);
+        var slot = reservation.Data;
+
+        var compressedSize = compressor.CompressFrameInto(
+            raw, (int)header.Width, (int)header.Height, (int)header.Stride, slot, GetHostDecodeTime(header.WindowId));
+        if (compressedSize > 0)
+        {
+            Stats.RecordFrameCompressed(rawLength - compressedSize);
+            header.Flags = CompressedKeyFrameFlags(compressor);
+            dataSize = compressedSize;
+        }
+        else if (compressedSize == 0 && rawLength <= slot.Length)
+        {
+            raw.CopyTo(slot);
+            header.Flags = FrameSlotFlags.KeyFrame;
+            dataSize = rawLength;
+        }
+        else
+        {
+            return SlotWriteResult.DoesNotFit;
+        }
+
+        header.DataSize = (uint)dataSize;
+        slotIndex = buffer.CommitSlot(reservation, header);
+        return SlotWriteResult.Written;
+    }
+
+    private static FrameSlotFlags CompressedKeyFrameFlags(FrameCompressor compressor) =>
+        compressor.IsTiled
+            ? FrameSlotFlags.Compressed | FrameSlotFlags.Tiled | FrameSlotFlags.KeyFrame
+            : FrameSlotFlags.Compressed | FrameSlotFlags.KeyFrame;
+
+    /// <summary>
+    /// Compresses a key frame into the scratch buffer.
+    /// </summary>
+    /// <returns>The buffer holding the data to write, its length, and whether it is compressed.</returns>
+    private (byte[] Data, int Length, bool IsCompressed) CompressToScratch(
+        FrameCompressor compressor,
+        FrameSlotHeader header,
+        SlotPayload payload,
+        FrameScratch scratch)
+    {
+        var rawLength = payload.Size;
+        var raw = StageRaw(payload, scratch);
+        var (width, height, stride) = ((int)header.Width, (int)header.Height, (int)header.Stride);
+
+        var compressed = EnsureScratch(
+            ref scratch.Compressed, compressor.MaximumCompressedFrameSize(width, height, rawLength));
+        var compressedSize = compressor.CompressFrameInto(
+            raw.AsSpan(0, rawLength), width, height, stride, compressed, GetHostDecodeTime(header.WindowId));
+        if (compressedSize <= 0)
+        {
+            return (raw, rawLength, false);
+        }
+
+        Stats.RecordFrameCompressed(rawLength - compressedSize);
+        return (compressed, compressedSize, true);
+    }
+
+    /// <summary>
+    /// Returns the raw key frame: the desktop frame itself, or the window
+    /// cropped into the crop scratch buffer.
+    /// </summary>
+    private static byte[] StageRaw(SlotPayload payload, FrameScratch scratch)
+    {
+        if (payload.WholeFrame)
+        {
+            return payload.Source.Data;
+        }
+
+        var raw = EnsureScratch(ref scratch.Crop, payload.Size);
+        payload.WriteTo(raw.AsSpan(0, payload.Size));
+        return raw;
+    }
+
+    private FrameScratch RentScratch()
+    {
+        lock (_scratchPool)
+        {
+            return _scratchPool.TryPop(out var scratch) ? scratch : new FrameScratch();
+        }
+    }
+
+    private void ReturnScratch(FrameScratch scratch)
+    {
+        lock (_scratchPool)
+        {
+            _scratchPool.Push(scratch);
+        }
+    }
+
+    /// <summary>
+    /// Staging buffers for one window's compressed key frame: the cropped
+    /// window and the compressed output when it can't go straight into a slot.
+    /// </summary>
+    private sealed class FrameScratch
+    {
+        public byte[] Crop = [];
+        public byte[] Compressed = [];
+    }
+
+    private static byte[] EnsureScratch(ref byte[] scratch, int size)
+    {
+        if (scratch.Length < size)
+        {
+            scratch = new byte[size];
+        }
+
+        return scratch;
+    }
+
+    /// <summary>
+    /// The data for one slot: a damage payload, a window cropped (and maybe
+    /// halved) out of the desktop frame, or the whole desktop frame. Produced
+    /// straight into the slot so key frames don't need an intermediate copy.
+    /// </summary>
+    private readonly record struct SlotPayload(CapturedFrame Source, Rect Bounds, FrameDamage? Damage, bool WholeFrame, bool Downscale = false)
+    {
+        public int Size => Damage != null
+            ? Damage.PayloadSize
+            : WholeFrame ? Source.Data.Length
+            : Downscale ? FramePixels.Downscale2xSize(Bounds.Width, Bounds.Height)
+            : Bounds.Width * Bounds.Height * 4;
+
+        public void WriteTo(Span<byte> destination)
+        {
+            if (Damage != null)
+            {
+                _ = Damage.WritePayload(destination, Source, Bounds);
+            }
+            else if (WholeFrame)
+            {
+                Source.Data.AsSpan(0, destination.Length).CopyTo(destination);
+            }
+            else if (Downscale)
+            {
+                DesktopDuplicationBridge.DownscaleRegion(Source, Bounds, destination);
+            }
+            else
+            {
+                DesktopDuplicationBridge.CopyRegion(Source, Bounds, destination);
+            }
+        }
+    }
+
     private async Task NotifyBufferAllocationAsync(
         ulong windowId,
         WindowFrameBuffer buffer,
@@ -495,21 +1302,64 @@ public sealed class FrameStreamingService : IDisposable
         }
     }
 
-    private bool ShouldCaptureWindow(ulong windowId, DateTime now)
+    internal bool ShouldCaptureWindow(ulong windowId, DateTime now)
     {
         lock (_stateLock)
         {
+            var minIntervalMs = _config.MinWindowFrameIntervalMs;
+            var maxFps = IntervalToFps(minIntervalMs);
+            var isFocused = false;
+            if (_windowThrottles.TryGetValue(windowId, out var throttle))
+            {
+                if (throttle.Visibility == StreamVisibility.Hidden)
+                {
+                    Stats.RecordFrameThrottled();
+                    return false;
+                }
+
+                (minIntervalMs, maxFps, isFocused) = (throttle.MinIntervalMs, throttle.MaxFps, throttle.IsFocused);
+            }
+
+            if (_governor != null)
+            {
+                var decision = _governor.Evaluate(windowId, maxFps, isFocused, now, out var changed);
+                minIntervalMs = decision.MinIntervalMs;
+                if (changed)
+                {
+                    Stats.RecordRateChange();
+                    if (_logger.MinimumLevel <= LogLevel.Debug)
+                    {
+                        _logger.Debug($"Window {windowId}: {decision.TargetFps} fps ({decision.Reason})");
+                    }
+                }
+            }
+
             if (!_windowFrameStates.TryGetValue(windowId, out var state))
             {
                 return true; // First frame for this window
             }
 
-            var elapsed = (now - state.LastCaptureTime).TotalMilliseconds;
-            return elapsed >= _config.MinWindowFrameIntervalMs;
+            // The loop is paced to the shortest window interval; allow for timer
+            // jitter so a window on that interval isn't pushed to the next one
+            var elapsed = (now - state.LastCaptureTime).TotalMilliseconds + PacingToleranceMs;
+            if (elapsed >= minIntervalMs)
+            {
+                return true;
+            }
+
+            // Only count skips caused by a host throttle or the governor, not the normal pacing interval
+            if (elapsed >= _config.MinWindowFrameIntervalMs)
+            {
+                Stats.RecordFrameThrottled();
+            }
+
+            return false;
         }
     }
 
-    private void UpdateWindowFrameState(ulong windowId, DateTime captureTime)
+    private const double PacingToleranceMs = 2;
+
+    internal void UpdateWindowFrameState(ulong windowId, DateTime captureTime)
     {
         lock (_stateLock)
         {
@@ -540,12 +1390,37 @@ public sealed class FrameStreamingService : IDisposable
                 _ = _windowFrameStates.Remove(id);
             }
 
+            var staleThrottles = _windowThrottles.Keys
+                .Where(id => !activeWindowIds.Contains(id))
+                .ToList();
+
+            foreach (var id in staleThrottles)
+            {
+                _ = _windowThrottles.Remove(id);
+            }
+
+            foreach (var id in _hostDecodeTimes.Keys.Where(id => !activeWindowIds.Contains(id)).ToList())
+            {
+                _ = _hostDecodeTimes.Remove(id);
+            }
+
+            var staleTrackers = _damageTrackers.Keys
+                .Where(id => id != DesktopWindowId && !activeWindowIds.Contains(id))
+                .ToList();
+
+            foreach (var id in staleTrackers)
+            {
+                _ = _damageTrackers.Remove(id);
+            }
+
             if (staleIds.Count > 0)
             {
                 _logger.Debug($"Cleaned up {staleIds.Count} stale window frame states");
             }
         }
 
+        _governor?.RemoveStale(activeWindowIds);
+
         // Also cleanup stale buffers
         _bufferManager.CleanupStaleBuffers(activeWindowIds);
     }
@@ -563,6 +1438,7 @@ public sealed class FrameStreamingService : IDisposable
         }
 
         _disposed = true;
+        _windowTracker.WindowEvent -= OnWindowEvent;
 
         _cts?.Cancel();
         try
@@ -579,6 +1455,9 @@ public sealed class FrameStreamingService : IDisposable
         lock (_stateLock)
         {
             _windowFrameStates.Clear();
+            _windowThrottles.Clear();
+            _hostDecodeTimes.Clear();
+            _damageTrackers.Clear();
         }
 
         _bufferManager.Dispose();
@@ -597,6 +1476,44 @@ internal sealed record WindowFrameState
     public required uint FrameCount { get; init; }
 }
 
+/// <summary>
+/// Outcome of writing one frame into a window's ring.
+/// </summary>
+internal enum FrameWriteResult
+{
+    /// <summary>The frame is in the ring and the host was notified.</summary>
+    Written,
+
+    /// <summary>The ring was full; the frame was dropped.</summary>
+    Dropped,
+
+    /// <summary>The buffer was reallocated, so a damage frame can't be used.</summary>
+    NeedsKeyFrame
+}
+
+/// <summary>
+/// Host visibility of a streamed window, sent with <see cref="SetWindowThrottleMessage"/>.
+/// Values match STREAM_VISIBILITY in shared/protocol.def.
+/// </summary>
+public enum StreamVisibility
+{
+    /// <summary>Window is on screen; capture at the normal rate.</summary>
+    Visible = 0,
+
+    /// <summary>Window is on screen but not focused; capture at a reduced rate.</summary>
+    Background = 1,
+
+    /// <summary>Window is minimized or fully occluded; do not capture.</summary>
+    Hidden = 2
+}
+
+/// <summary>
+/// Per-window capture throttle derived from a host visibility hint.
+/// </summary>
+/// <param name="MaxFps">The rate cap behind <paramref name="MinIntervalMs"/>, passed to the governor.</param>
+/// <param name="IsFocused">The window is focused on the host and may use the focused rate.</param>
+internal sealed record WindowThrottle(StreamVisibility Visibility, int MinIntervalMs, int MaxFps, bool IsFocused);
+
 /// <summary>
 /// Statistics for frame streaming diagnostics.
 /// </summary>
@@ -610,6 +1527,29 @@ public sealed class FrameStreamingStats
     private long _bufferFullCount;
     private long _framesCompressed;
     private long _bytesSavedByCompression;
+    private long _framesThrottled;
+    private long _damageFramesWritten;
+    private long _windowsUnchanged;
+    private long _bytesWritten;
+    private long _allocatedBytes;
+    private long _allocationSamples;
+    private long _captureTicks;
+    private long _captureSamples;
+    private long _encodeTicks;
+    private long _encodeSamples;
+    private long _notifyTicks;
+    private long _notifySamples;
+    private long _frameTicks;
+    private long _frameSamples;
+    private long _idleWaits;
+    private long _rateChanges;
+    private long _pacingTicks;
+
+    // GC counters are process-wide; report them relative to when streaming was set up
+    private readonly int _gen0Baseline = GC.CollectionCount(0);
+    private readonly int _gen1Baseline = GC.CollectionCount(1);
+    private readonly int _gen2Baseline = GC.CollectionCount(2);
+    private readonly TimeSpan _gcPauseBaseline = GC.GetTotalPauseDuration();
 
     public long CaptureAttempts => Interlocked.Read(ref _captureAttempts);
     public long FramesCaptured => Interlocked.Read(ref _framesCaptured);
@@ -619,13 +1559,102 @@ public sealed class FrameStreamingStats
     public long BufferFullCount => Interlocked.Read(ref _bufferFullCount);
     public long FramesCompressed => Interlocked.Read(ref _framesCompressed);
     public long BytesSavedByCompression => Interlocked.Read(ref _bytesSavedByCompression);
+    public long FramesThrottled => Interlocked.Read(ref _framesThrottled);
+    public long DamageFramesWritten => Interlocked.Read(ref _damageFramesWritten);
+    public long WindowsUnchanged => Interlocked.Read(ref _windowsUnchanged);
+    public long BytesWritten => Interlocked.Read(ref _bytesWritten);
+
+    /// <summary>Managed bytes allocated by capturing frames and writing each window (crop, compress, write, notify).</summary>
+    public long AllocatedBytes => Interlocked.Read(ref _allocatedBytes);
+
+    /// <summary>Average managed bytes allocated per capture iteration; near zero in steady state.</summary>
+    public long AllocatedBytesPerCapture
+    {
+        get
+        {
+            var samples = Interlocked.Read(ref _allocationSamples);
+            return samples > 0 ? AllocatedBytes / samples : 0;
+        }
+    }
+
+    /// <summary>Average time to capture a desktop frame, including the wait for it.</summary>
+    public TimeSpan AverageCaptureTime => Average(ref _captureTicks, ref _captureSamples);
+
+    /// <summary>Average time to crop, compress and write one window's slot.</summary>
+    public TimeSpan AverageEncodeTime => Average(ref _encodeTicks, ref _encodeSamples);
+
+    /// <summary>Average time to queue one FrameReady notification.</summary>
+    public TimeSpan AverageNotifyTime => Average(ref _notifyTicks, ref _notifySamples);
+
+    /// <summary>
+    /// Average time to write every window of a desktop frame. Below the sum of
+    /// the per-window times when windows are written in parallel.
+    /// </summary>
+    public TimeSpan AverageFrameTime => Average(ref _frameTicks, ref _frameSamples);
+
+    /// <summary>Times the capture loop slept because the host wasn't showing any window.</summary>
+    public long IdleWaits => Interlocked.Read(ref _idleWaits);
+
+    /// <summary>Times the governor changed a window's capture rate or the reason for it.</summary>
+    public long RateChanges => Interlocked.Read(ref _rateChanges);
+
+    /// <summary>Total time the capture loop waited to stay under the target rate.</summary>
+    public TimeSpan PacingTime => TimeSpan.FromTicks(Interlocked.Read(ref _pacingTicks));
+
+    /// <summary>Process-wide gen 0 collections since the service was created.</summary>
+    public int Gen0Collections => GC.CollectionCount(0) - _gen0Baseline;
+
+    /// <summary>Process-wide gen 1 collections since the service was created.</summary>
+    public int Gen1Collections => GC.CollectionCount(1) - _gen1Baseline;
+
+    /// <summary>Process-wide gen 2 collections since the service was created.</summary>
+    public int Gen2Collections => GC.CollectionCount(2) - _gen2Baseline;
+
+    /// <summary>Process-wide time spent paused for GC since the service was created.</summary>
+    public TimeSpan GcPauseTime => GC.GetTotalPauseDuration() - _gcPauseBaseline;
 
     internal void RecordCaptureAttempt() => Interlocked.Increment(ref _captureAttempts);
     internal void RecordFrameCaptured() => Interlocked.Increment(ref _framesCaptured);
-    internal void RecordFrameWritten() => Interlocked.Increment(ref _framesWritten);
+    internal void RecordDamageFrameWritten() => Interlocked.Increment(ref _damageFramesWritten);
+    internal void RecordWindowUnchanged() => Interlocked.Increment(ref _windowsUnchanged);
     internal void RecordNotificationSent() => Interlocked.Increment(ref _notificationsSent);
     internal void RecordCaptureError() => Interlocked.Increment(ref _captureErrors);
     internal void RecordBufferFull() => Interlocked.Increment(ref _bufferFullCount);
+    internal void RecordFrameThrottled() => Interlocked.Increment(ref _framesThrottled);
+    internal void RecordIdleWait() => Interlocked.Increment(ref _idleWaits);
+    internal void RecordRateChange() => Interlocked.Increment(ref _rateChanges);
+    internal void RecordPacingWait(TimeSpan waited) => Interlocked.Add(ref _pacingTicks, waited.Ticks);
+
+    internal void RecordFrameWritten(int bytes = 0)
+    {
+        _ = Interlocked.Increment(ref _framesWritten);
+        _ = Interlocked.Add(ref _bytesWritten, bytes);
+    }
+
+    internal void RecordCaptureAllocations(long bytes)
+    {
+        _ = Interlocked.Increment(ref _allocationSamples);
+        _ = Interlocked.Add(ref _allocatedBytes, bytes);
+    }
+
+    internal void RecordWindowAllocations(long bytes) => Interlocked.Add(ref _allocatedBytes, bytes);
+
+    internal void RecordCaptureTime(TimeSpan elapsed) => AddSample(ref _captureTicks, ref _captureSamples, elapsed);
+    internal void RecordEncodeTime(TimeSpan elapsed) => AddSample(ref _encodeTicks, ref _encodeSamples, elapsed);
+    internal void RecordNotifyTime(TimeSpan elapsed) => AddSample(ref _notifyTicks, ref _notifySamples, elapsed);
+    internal void RecordFrameTime(TimeSpan elapsed) => AddSample(ref _frameTicks, ref _frameSamples, elapsed);
+
+    private static void AddSample(ref long ticks, ref long samples, TimeSpan elapsed)
+    {
+        _ = Interlocked.Add(ref ticks, elapsed.Ticks);
+        _ = Interlocked.Increment(ref samples);
+    }
+
+    private static TimeSpan Average(ref long ticks, ref long samples)
+    {
+        var count = Interlocked.Read(ref samples);
+        return count > 0 ? TimeSpan.FromTicks(Interlocked.Read(ref ticks) / count) : TimeSpan.Zero;
+    }
 
     internal void RecordFrameCompressed(int bytesSaved)
     {
@@ -636,5 +1665,11 @@ public sealed class FrameStreamingStats
     public override string ToString() =>
         $"Attempts={CaptureAttempts}, Captured={FramesCaptured}, Written={FramesWritten}, " +
         $"Sent={NotificationsSent}, Errors={CaptureErrors}, BufferFull={BufferFullCount}, " +
-        $"Compressed={FramesCompressed}, SavedKB={BytesSavedByCompression / 1024}";
+        $"Compressed={FramesCompressed}, SavedKB={BytesSavedByCompression / 1024}, " +
+        $"Throttled={FramesThrottled}, Damage={DamageFramesWritten}, Unchanged={WindowsUnchanged}, " +
+        $"WrittenKB={BytesWritten / 1024}, AllocB/capture={AllocatedBytesPerCapture}, " +
+        $"CaptureMs={AverageCaptureTime.TotalMilliseconds:F2}, EncodeMs={AverageEncodeTime.TotalMilliseconds:F2}, " +
+        $"NotifyMs={AverageNotifyTime.TotalMilliseconds:F2}, FrameMs={AverageFrameTime.TotalMilliseconds:F2}, " +
+        $"IdleWaits={IdleWaits}, PacingMs={PacingTime.TotalMilliseconds:F0}, RateChanges={RateChanges}, " +
+        $"GC={Gen0Collections}/{Gen1Collections}/{Gen2Collections}, GcPauseMs={GcPauseTime.TotalMilliseconds:F0}";
 }
@@ -138,6 +138,51 @@ public sealed record ConfigureStreamingMessage : HostMessage
     public FrameBufferMode FrameBufferMode { get; init; } = FrameBufferMode.Uncompressed;
 }
 
+/// <summary>
+/// Visibility-based capture throttle for a single window.
+/// Sent when a host window is minimized, occluded, or moves to the background.
+/// </summary>
+public sealed record SetWindowThrottleMessage : HostMessage
+{
+    public required ulong WindowId { get; init; }
+    public StreamVisibility Visibility { get; init; } = StreamVisibility.Visible;
+
+    /// <summary>
+    /// Maximum capture rate for this window, or 0 for the guest default
+    /// (unlimited when visible, <see cref="FrameStreamingConfig.BackgroundMaxFps"/> in the background).
+    /// </summary>
+    public int MaxFps { get; init; }
+
+    /// <summary>Whether the window is focused on the host; the focused window gets the highest rate.</summary>
+    public bool IsFocused { get; init; }
+
+    /// <summary>
+    /// Smoothed time the host takes to decode one of the window's tiled frames,
+    /// in microseconds, or null until it has decoded one.
+    /// </summary>
+    public int? HostDecodeUs { get; init; }
+
+    /// <summary>
+    /// Frames of the window the host skipped to catch up since its previous
+    /// hint, or null if it skipped none. Any skip slows the window down.
+    /// </summary>
+    public int? HostSkippedFrames { get; init; }
+}
+
+/// <summary>
+/// Liveness probe from the host. The guest answers at once with a
+/// <see cref="HeartbeatMessage"/> that echoes <see cref="Sequence"/> and <see cref="SentAt"/>,
+/// so the host can measure round-trip time against its own clock.
+/// </summary>
+public sealed record PingMessage : HostMessage
+{
+    /// <summary>Host-assigned, increasing per ping.</summary>
+    public uint Sequence { get; init; }
+
+    /// <summary>Host send time in microseconds, opaque to the guest.</summary>
+    public long SentAt { get; init; }
+}
+
 // ============================================================================
 // Guest → Host Messages
 // ============================================================================
@@ -275,6 +320,7 @@ public sealed record GuestClipboardMessage : GuestMessage
 
 /// <summary>
 /// Heartbeat to indicate agent is alive.
+/// Sent periodically, and in reply to a <see cref="PingMessage"/>.
 /// </summary>
 public sealed record HeartbeatMessage : GuestMessage
 {
@@ -282,6 +328,12 @@ public sealed record HeartbeatMessage : GuestMessage
     public long UptimeMs { get; init; }
     public float CpuUsagePercent { get; init; }
     public long MemoryUsageBytes { get; init; }
+
+    /// <summary>Sequence of the ping this answers; null for periodic heartbeats.</summary>
+    public uint? PingSequence { get; init; }
+
+    /// <summary>The ping's <see cref="PingMessage.SentAt"/>, echoed unchanged.</summary>
+    public long? PingSentAt { get; init; }
 }
 
 /// <summary>
@@ -603,6 +655,8 @@ public static class SpiceMessageSerializer
             SpiceMessageType.ListSessions => JsonSerializer.Deserialize<ListSessionsMessage>(payload, JsonOptions),
             SpiceMessageType.CloseSession => JsonSerializer.Deserialize<CloseSessionMessage>(payload, JsonOptions),
             SpiceMessageType.ListShortcuts => JsonSerializer.Deserialize<ListShortcutsMessage>(payload, JsonOptions),
+            SpiceMessageType.SetWindowThrottle => JsonSerializer.Deserialize<SetWindowThrottleMessage>(payload, JsonOptions),
+            SpiceMessageType.Ping => JsonSerializer.Deserialize<PingMessage>(payload, JsonOptions),
             SpiceMessageType.Shutdown => JsonSerializer.Deserialize<ShutdownMessage>(payload, JsonOptions),
 
             // Guest → Host (not deserialized on guest side)
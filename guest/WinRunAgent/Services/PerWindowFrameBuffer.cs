@@ -1,3 +1,6 @@
+using System.Buffers;
+using System.Numerics;
+using System.Runtime.CompilerServices;
 using System.Runtime.InteropServices;
 
 namespace WinRun.Agent.Services;
@@ -17,7 +20,8 @@ public enum FrameBufferMode
 {
     /// <summary>
     /// Uncompressed frames with exact allocation.
-    /// Buffer sized exactly for frame dimensions. Reallocates on resize.
+    /// Buffer sized exactly for the first frame; resizes reuse it while frames
+    /// fit (see <see cref="PerWindowBufferConfig.ResizeHeadroom"/>).
     /// Lowest latency, higher memory usage.
     /// </summary>
     Uncompressed,
@@ -61,6 +65,20 @@ public sealed record PerWindowBufferConfig
     /// Adds buffer space for slight size variations.
     /// </summary>
     public double ExactAllocationHeadroom { get; init; } = 1.0; // No headroom by default
+
+    /// <summary>
+    /// Growth factor for slots reallocated because the window was resized.
+    /// A window being dragged larger outgrows its buffer every few frames;
+    /// the extra room lets most of those frames reuse the buffer instead.
+    /// </summary>
+    public double ResizeHeadroom { get; init; } = 1.5;
+
+    /// <summary>
+    /// Fraction of a slot below which a shrunk window gets a smaller buffer.
+    /// Frames between this and the full slot reuse the buffer as is, so a
+    /// window resized back and forth doesn't reallocate on every frame.
+    /// </summary>
+    public double ResizeShrinkRatio { get; init; } = 0.25;
 }
 
 /// <summary>
@@ -77,6 +95,7 @@ public sealed class WindowFrameBuffer : IDisposable
     private int _expectedFrameSize;
     private bool _disposed;
     private SharedAllocation _currentAllocation;
+    private int _allocationVersion;
 
     // Ring buffer state
     private int _writeIndex;
@@ -109,6 +128,12 @@ public sealed class WindowFrameBuffer : IDisposable
     /// <summary>Number of slots in this buffer.</summary>
     public int SlotCount => _config.SlotsPerWindow;
 
+    /// <summary>Times the buffer was allocated or reallocated.</summary>
+    public int AllocationCount { get; private set; }
+
+    /// <summary>Frame size changes absorbed by the current buffer without reallocating.</summary>
+    public int ResizesInPlace { get; private set; }
+
     /// <summary>Whether this buffer uses shared memory (vs local allocation).</summary>
     public bool UsesSharedMemory => _currentAllocation.IsValid;
 
@@ -133,11 +158,55 @@ public sealed class WindowFrameBuffer : IDisposable
         };
     }
 
+    /// <summary>Bytes of frame data one slot can hold.</summary>
+    public int SlotCapacity => SlotSize - FrameSlotHeader.Size;
+
     /// <summary>
     /// Writes a frame to the next available slot.
     /// </summary>
     /// <returns>Slot index written to, or -1 if buffer full.</returns>
     public int WriteFrame(FrameSlotHeader header, ReadOnlySpan<byte> data)
+    {
+        header.DataSize = (uint)data.Length;
+        if (!TryReserveForWrite(data.Length, out var reservation))
+        {
+            return -1;
+        }
+
+        data.CopyTo(reservation.Data);
+        return CommitSlot(reservation, header);
+    }
+
+    /// <summary>
+    /// Writes a frame to the next available slot, letting <paramref name="writeData"/>
+    /// produce the frame data directly in the slot (e.g. cropping a window out of the
+    /// desktop) instead of copying it from an intermediate buffer.
+    /// </summary>
+    /// <param name="header">Slot header; <see cref="FrameSlotHeader.DataSize"/> sets the size of the span.</param>
+    /// <param name="state">State passed to <paramref name="writeData"/>, so the callback can be static.</param>
+    /// <param name="writeData">Fills the slot's data area, exactly DataSize bytes.</param>
+    /// <returns>Slot index written to, or -1 if buffer full.</returns>
+    public int WriteFrame<TState>(FrameSlotHeader header, TState state, SpanAction<byte, TState> writeData)
+    {
+        if (!TryReserveForWrite((int)header.DataSize, out var reservation))
+        {
+            return -1;
+        }
+
+        writeData(reservation.Data[..(int)header.DataSize], state);
+        return CommitSlot(reservation, header);
+    }
+
+    /// <summary>
+    /// Claims the next free slot so a producer whose output size isn't known up
+    /// front (e.g. a compressor) can write into it directly. Nothing is visible
+    /// to the host until <see cref="CommitSlot"/>; a reservation that is never
+    /// committed just leaves the slot free.
+    /// </summary>
+    /// <param name="maxDataSize">Most bytes the producer may write.</param>
+    /// <param name="reservation">The slot's data area, the whole <see cref="SlotCapacity"/>.</param>
+    /// <returns>False if the buffer is full or <paramref name="maxDataSize"/> exceeds <see cref="SlotCapacity"/>.</returns>
+    public bool TryReserveSlot(int maxDataSize, out FrameSlotReservation reservation)
     {
         ObjectDisposedException.ThrowIf(_disposed, this);
 
@@ -146,41 +215,70 @@ public sealed class WindowFrameBuffer : IDisposable
             throw new InvalidOperationException("Buffer not allocated");
         }
 
-        // Check if buffer is full
+        reservation = default;
+
+        // Check if buffer is full, and if the frame can fit
         var nextWrite = (_writeIndex + 1) % _config.SlotsPerWindow;
-        if (nextWrite == _readIndex)
+        if (nextWrite == _readIndex || maxDataSize > SlotCapacity)
         {
-            return -1; // Buffer full
+            return false;
         }
 
-        // Check if frame fits
-        if (data.Length > SlotSize - FrameSlotHeader.Size)
+        var slotPointer = _bufferPointer + (_writeIndex * SlotSize);
+        reservation = new FrameSlotReservation(_writeIndex, slotPointer + FrameSlotHeader.Size, SlotCapacity, _allocationVersion);
+        return true;
+    }
+
+    /// <summary>
+    /// Publishes a reserved slot: writes <paramref name="header"/>, whose
+    /// <see cref="FrameSlotHeader.DataSize"/> is the number of bytes actually
+    /// written, and moves on to the next slot.
+    /// </summary>
+    /// <returns>The slot index, to send in the FrameReady notification.</returns>
+    /// <exception cref="InvalidOperationException">
+    /// The reservation is stale (the buffer was reallocated or another slot was committed)
+    /// or DataSize exceeds its capacity.
+    /// </exception>
+    public int CommitSlot(in FrameSlotReservation reservation, FrameSlotHeader header)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+
+        if (reservation.Version != _allocationVersion || reservation.SlotIndex != _writeIndex || _bufferPointer == IntPtr.Zero)
         {
-            _logger.Error($"Frame too large for slot: {data.Length} > {SlotSize - FrameSlotHeader.Size}");
-            return -1;
+            throw new InvalidOperationException("Slot reservation is no longer valid");
         }
 
-        var slotOffset = _writeIndex * SlotSize;
-
-        // Write header
-        Marshal.StructureToPtr(header, _bufferPointer + slotOffset, false);
+        if (header.DataSize > reservation.Capacity)
+        {
+            throw new InvalidOperationException($"Committed {header.DataSize} bytes into a {reservation.Capacity}-byte slot");
+        }
 
-        // Write data
-        var dataOffset = slotOffset + FrameSlotHeader.Size;
+        // Slots aren't 8-byte aligned in general; store the header without boxing it
         unsafe
         {
-            fixed (byte* dataPtr = data)
-            {
-                Buffer.MemoryCopy(dataPtr, (void*)(_bufferPointer + dataOffset), data.Length, data.Length);
-            }
+            Unsafe.WriteUnaligned((void*)(_bufferPointer + (_writeIndex * SlotSize)), header);
         }
 
         var writtenSlot = _writeIndex;
-        _writeIndex = nextWrite;
-
+        _writeIndex = (_writeIndex + 1) % _config.SlotsPerWindow;
         return writtenSlot;
     }
 
+    private bool TryReserveForWrite(int dataSize, out FrameSlotReservation reservation)
+    {
+        if (TryReserveSlot(dataSize, out reservation))
+        {
+            return true;
+        }
+
+        if (dataSize > SlotCapacity)
+        {
+            _logger.Error($"Frame too large for slot: {dataSize} > {SlotCapacity}");
+        }
+
+        return false;
+    }
+
     /// <summary>
     /// Advances the read index (called by host via notification).
     /// </summary>
@@ -201,20 +299,56 @@ public sealed class WindowFrameBuffer : IDisposable
     {
         var requiredSlotSize = FrameSlotHeader.Size + (int)(rawFrameSize * _config.ExactAllocationHeadroom);
 
-        // Check if current allocation is exact match
-        if (_bufferPointer != IntPtr.Zero && _expectedFrameSize == rawFrameSize)
+        if (_bufferPointer != IntPtr.Zero)
         {
-            return false; // No reallocation needed
+            if (_expectedFrameSize == rawFrameSize)
+            {
+                return false; // No reallocation needed
+            }
+
+            // Slot headers carry each frame's geometry, so a resized frame can
+            // use the slots as they are while it fits and fills enough of them
+            if (requiredSlotSize <= SlotSize && requiredSlotSize >= SlotSize * _config.ResizeShrinkRatio)
+            {
+                _expectedFrameSize = rawFrameSize;
+                ResizesInPlace++;
+                return false;
+            }
         }
 
-        // Need to (re)allocate
-        Reallocate(requiredSlotSize);
+        // The first allocation is exact; after that the window is resizing,
+        // so leave room for it to keep going
+        var slotSize = _bufferPointer == IntPtr.Zero
+            ? requiredSlotSize
+            : ResizeSlotSize(requiredSlotSize, _config.ResizeHeadroom);
+
+        Reallocate(slotSize);
         _expectedFrameSize = rawFrameSize;
 
         _logger.Debug($"Window {WindowId}: Exact allocation for {rawFrameSize} bytes ({BufferSize / 1024} KB total)");
         return true;
     }
 
+    /// <summary>
+    /// Slot size for a window that resized: <paramref name="requiredSlotSize"/>
+    /// with headroom, rounded up to a size class. Classes are a quarter of a
+    /// power of two apart and page-aligned, so windows resizing through
+    /// similar sizes ask the allocator for the same few block sizes.
+    /// </summary>
+    internal static int ResizeSlotSize(int requiredSlotSize, double headroom)
+    {
+        var target = (long)Math.Ceiling(requiredSlotSize * Math.Max(1.0, headroom));
+        if (target <= SharedMemoryBuddyAllocator.PageSize)
+        {
+            return (int)Math.Max(target, requiredSlotSize);
+        }
+
+        var step = (long)BitOperations.RoundUpToPowerOf2((ulong)target) / 8;
+        step = Math.Max(step, SharedMemoryBuddyAllocator.PageSize);
+        var rounded = (target + step - 1) / step * step;
+        return (int)Math.Min(rounded, int.MaxValue);
+    }
+
     private bool EnsureTrancheAllocation(int compressedDataSize)
     {
         var requiredSlotSize = FrameSlotHeader.Size + compressedDataSize;
@@ -281,6 +415,8 @@ public sealed class WindowFrameBuffer : IDisposable
         // Reset ring buffer indices
         _writeIndex = 0;
         _readIndex = 0;
+        _allocationVersion++;
+        AllocationCount++;
     }
 
     private void AllocateLocal()
@@ -329,6 +465,34 @@ public sealed class WindowFrameBuffer : IDisposable
     }
 }
 
+/// <summary>
+/// A frame slot claimed with <see cref="WindowFrameBuffer.TryReserveSlot"/>,
+/// valid until it is committed or the buffer is reallocated.
+/// </summary>
+public readonly struct FrameSlotReservation
+{
+    private readonly nint _data;
+
+    internal FrameSlotReservation(int slotIndex, nint data, int capacity, int version)
+    {
+        SlotIndex = slotIndex;
+        _data = data;
+        Capacity = capacity;
+        Version = version;
+    }
+
+    /// <summary>Index of the reserved slot.</summary>
+    public int SlotIndex { get; }
+
+    /// <summary>Bytes available in <see cref="Data"/>.</summary>
+    public int Capacity { get; }
+
+    internal int Version { get; }
+
+    /// <summary>The slot's data area in the frame buffer.</summary>
+    public unsafe Span<byte> Data => new((void*)_data, Capacity);
+}
+
 /// <summary>
 /// Manages per-window frame buffers for all tracked windows.
 /// </summary>
@@ -429,9 +593,14 @@ public sealed class PerWindowBufferManager : IDisposable
             var totalMemory = 0L;
             var allocatedCount = 0;
             var sharedCount = 0;
+            var allocations = 0;
+            var resizesInPlace = 0;
 
             foreach (var buffer in _buffers.Values)
             {
+                allocations += buffer.AllocationCount;
+                resizesInPlace += buffer.ResizesInPlace;
+
                 if (buffer.IsAllocated)
                 {
                     totalMemory += buffer.BufferSize;
@@ -449,6 +618,8 @@ public sealed class PerWindowBufferManager : IDisposable
                 AllocatedBufferCount = allocatedCount,
                 SharedMemoryBufferCount = sharedCount,
                 TotalMemoryBytes = totalMemory,
+                Allocations = allocations,
+                ResizesInPlace = resizesInPlace,
                 Mode = _config.Mode,
                 UsesSharedMemory = UsesSharedMemory
             };
@@ -517,6 +688,13 @@ public sealed record BufferManagerStats
     public int AllocatedBufferCount { get; init; }
     public int SharedMemoryBufferCount { get; init; }
     public long TotalMemoryBytes { get; init; }
+
+    /// <summary>Allocations and reallocations by the current buffers.</summary>
+    public int Allocations { get; init; }
+
+    /// <summary>Frame size changes the current buffers absorbed without reallocating.</summary>
+    public int ResizesInPlace { get; init; }
+
     public FrameBufferMode Mode { get; init; }
     public bool UsesSharedMemory { get; init; }
 
@@ -532,6 +710,6 @@ public sealed record BufferManagerStats
         var allocInfo = UsesSharedMemory
             ? $"Allocated={AllocatedBufferCount} (shared={SharedMemoryBufferCount})"
             : $"Allocated={AllocatedBufferCount}";
-        return $"Mode={Mode}, Windows={WindowCount}, {allocInfo}, Memory={TotalMemoryFormatted}";
+        return $"Mode={Mode}, Windows={WindowCount}, {allocInfo}, Memory={TotalMemoryFormatted}, Resizes={ResizesInPlace} in place/{Allocations} allocations";
     }
 }
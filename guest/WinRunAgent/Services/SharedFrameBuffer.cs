@@ -14,7 +14,8 @@ namespace WinRun.Agent.Services;
 //   [Frame Slot N-1: variable]
 //
 // The header contains synchronization state and buffer metadata.
-// Each frame slot contains frame metadata followed by pixel data.
+// Each frame slot contains frame metadata followed by pixel data, or, for
+// slots flagged Damage, the changes since the previous frame (see FrameDamage).
 // ============================================================================
 
 /// <summary>
@@ -126,10 +127,20 @@ public struct FrameSlotHeader
 public enum FrameSlotFlags : uint
 {
     None = 0,
-    /// <summary>Frame data is LZ4 compressed.</summary>
+    /// <summary>Frame data is compressed: one LZ4 block, or tiles if Tiled is set.</summary>
     Compressed = 1 << 0,
     /// <summary>Frame is a key frame (not a delta).</summary>
-    KeyFrame = 1 << 1
+    KeyFrame = 1 << 1,
+    /// <summary>
+    /// Data is a damage payload (move and dirty rectangles plus dirty pixels)
+    /// to apply to the previous frame. Never combined with Compressed.
+    /// </summary>
+    Damage = 1 << 2,
+    /// <summary>
+    /// Set with Compressed: the data is a tiled frame (see TiledFrameEncoder)
+    /// instead of one LZ4 block.
+    /// </summary>
+    Tiled = 1 << 3
 }
 
 /// <summary>
@@ -431,4 +442,8 @@ public sealed record FrameReadyMessage : GuestMessage
     public required uint FrameNumber { get; init; }
     /// <summary>Whether this is a key frame (full frame vs delta).</summary>
     public bool IsKeyFrame { get; init; } = true;
+    /// <summary>The window's capture rate when governed, for the host's stream stats.</summary>
+    public int? TargetFps { get; init; }
+    /// <summary>Why the window is captured at <see cref="TargetFps"/>.</summary>
+    public FrameRateReason? RateReason { get; init; }
 }
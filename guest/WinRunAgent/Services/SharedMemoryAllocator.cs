@@ -1,4 +1,5 @@
 using System.IO.MemoryMappedFiles;
+using System.Numerics;
 
 namespace WinRun.Agent.Services;
 
@@ -57,6 +58,11 @@ public readonly struct SharedAllocation
     /// <summary>Size of the allocation in bytes.</summary>
     public int Size { get; init; }
 
+    /// <summary>
+    /// Bytes reserved for the allocation: <see cref="Size"/> rounded up to a page.
+    /// </summary>
+    public int Capacity { get; init; }
+
     /// <summary>Pointer to the allocated memory (within the mapped region).</summary>
     public nint Pointer { get; init; }
 
@@ -65,83 +71,249 @@ public readonly struct SharedAllocation
 }
 
 /// <summary>
-/// Simple allocator for tracking used regions within shared memory.
-/// Uses a first-fit free list approach.
+/// Buddy allocator over the shared region, in 4 KB pages.
 /// </summary>
-internal sealed class SharedMemoryFreeList
+/// <remarks>
+/// Free blocks are power-of-two runs of pages aligned to their size, kept in
+/// one intrusive list per order. An allocation takes the smallest free block
+/// that fits and hands the pages it doesn't need straight back, so a buffer
+/// wastes less than a page. Freeing merges a block with its buddy while the
+/// buddy is free too, so a resize storm leaves no fragments behind once the
+/// buffers are released, and the last block freed is the first reused by the
+/// next allocation of the same size. Both directions touch at most one block
+/// per order.
+/// </remarks>
+internal sealed class SharedMemoryBuddyAllocator
 {
-    private readonly List<(long Offset, int Size)> _freeBlocks = [];
+    /// <summary>Smallest block, and the alignment of every allocation.</summary>
+    public const int PageSize = 4096;
+
+    // Page 0 holds the region header
+    private const int HeaderPages = 1;
+    private const int PageShift = 12;
+    private const int OrderCount = 32;
+    private const int None = -1;
+
     private readonly object _lock = new();
+    private readonly int _pageCount;
+
+    // Per page: the order of the free block starting here, or -1
+    private readonly sbyte[] _freeOrder;
+
+    // Per page: the length of the allocation starting here, or 0
+    private readonly int[] _allocatedPages;
+
+    // Per page: links of the free list the block starting here is on
+    private readonly int[] _next;
+    private readonly int[] _prev;
+
+    private readonly int[] _freeHeads = new int[OrderCount];
+    private uint _nonEmptyOrders;
+
+    private long _freePages;
+    private int _freeBlockCount;
+    private int _allocationCount;
+    private long _allocatedBytes;
+    private long _requestedBytes;
+    private long _failedAllocations;
 
-    public SharedMemoryFreeList(long totalSize)
+    public SharedMemoryBuddyAllocator(long totalSize)
     {
-        // Start with one big free block (reserve header space)
-        const int headerSize = 4096; // Reserve first 4KB for metadata
-        _freeBlocks.Add((headerSize, (int)(totalSize - headerSize)));
+        _pageCount = (int)Math.Min(totalSize >> PageShift, int.MaxValue);
+        _freeOrder = new sbyte[_pageCount];
+        _allocatedPages = new int[_pageCount];
+        _next = new int[_pageCount];
+        _prev = new int[_pageCount];
+        Array.Fill(_freeOrder, (sbyte)None);
+        Array.Fill(_freeHeads, None);
+
+        // Cut the region into the largest aligned blocks it holds. None of
+        // them are buddies of each other, so they never merge past the header
+        // or the end of the region.
+        for (var page = HeaderPages; page < _pageCount;)
+        {
+            var order = LargestAlignedOrder(page, _pageCount - page);
+            Push(page, order);
+            page += 1 << order;
+        }
     }
 
     /// <summary>
-    /// Allocates a block of the specified size.
+    /// Allocates a block of at least the specified size, aligned to a page.
     /// Returns the offset, or -1 if no space available.
     /// </summary>
     public long Allocate(int size)
     {
-        // Align to 64 bytes for cache efficiency
-        var alignedSize = (size + 63) & ~63;
+        var pages = PagesFor(size);
+        var order = BitOperations.Log2(BitOperations.RoundUpToPowerOf2((uint)pages));
 
         lock (_lock)
         {
-            for (var i = 0; i < _freeBlocks.Count; i++)
+            var candidates = order < OrderCount ? _nonEmptyOrders & (uint.MaxValue << order) : 0;
+            if (candidates == 0)
             {
-                var (offset, blockSize) = _freeBlocks[i];
-                if (blockSize >= alignedSize)
-                {
-                    _freeBlocks.RemoveAt(i);
-                    if (blockSize > alignedSize)
-                    {
-                        // Put remainder back in free list
-                        _freeBlocks.Add((offset + alignedSize, blockSize - alignedSize));
-                    }
-                    return offset;
-                }
+                _failedAllocations++;
+                return -1;
+            }
+
+            var blockOrder = BitOperations.TrailingZeroCount(candidates);
+            var page = _freeHeads[blockOrder];
+            Remove(page, blockOrder);
+
+            // Return the tail of the block past the pages asked for
+            for (var tail = page + pages; tail < page + (1 << blockOrder);)
+            {
+                var tailOrder = LargestAlignedOrder(tail, page + (1 << blockOrder) - tail);
+                Push(tail, tailOrder);
+                tail += 1 << tailOrder;
             }
-        }
 
-        return -1; // No space
+            _allocatedPages[page] = pages;
+            _allocationCount++;
+            _allocatedBytes += (long)pages << PageShift;
+            _requestedBytes += size;
+            return (long)page << PageShift;
+        }
     }
 
     /// <summary>
-    /// Frees a previously allocated block.
+    /// Frees a previously allocated block. Returns false if the offset isn't
+    /// the start of a live allocation.
     /// </summary>
-    public void Free(long offset, int size)
+    public bool Free(long offset, int size)
     {
-        var alignedSize = (size + 63) & ~63;
+        if (offset < 0 || (offset & (PageSize - 1)) != 0 || (offset >> PageShift) >= _pageCount)
+        {
+            return false;
+        }
+
+        var start = (int)(offset >> PageShift);
 
         lock (_lock)
         {
-            _freeBlocks.Add((offset, alignedSize));
-            // Could merge adjacent blocks here for better fragmentation handling
-            // but keeping it simple for now
+            var pages = _allocatedPages[start];
+            if (pages == 0)
+            {
+                return false;
+            }
+
+            _allocatedPages[start] = 0;
+            _allocationCount--;
+            _allocatedBytes -= (long)pages << PageShift;
+            _requestedBytes -= size;
+
+            for (var page = start; page < start + pages;)
+            {
+                var order = LargestAlignedOrder(page, start + pages - page);
+                Release(page, order);
+                page += 1 << order;
+            }
+            return true;
         }
     }
 
     /// <summary>
     /// Gets statistics about allocation.
     /// </summary>
-    public (long TotalFree, int FreeBlockCount) GetStats()
+    public SharedMemoryBlockStats GetStats()
     {
         lock (_lock)
         {
-            long totalFree = 0;
-            foreach (var (_, size) in _freeBlocks)
+            var largestOrder = _nonEmptyOrders == 0 ? None : BitOperations.Log2(_nonEmptyOrders);
+            return new SharedMemoryBlockStats(
+                TotalFree: _freePages << PageShift,
+                FreeBlockCount: _freeBlockCount,
+                LargestFreeBlock: largestOrder == None ? 0 : (long)PageSize << largestOrder,
+                AllocationCount: _allocationCount,
+                AllocatedBytes: _allocatedBytes,
+                RequestedBytes: _requestedBytes,
+                FailedAllocations: _failedAllocations);
+        }
+    }
+
+    private static int PagesFor(int size) => Math.Max(1, (int)(((long)size + PageSize - 1) >> PageShift));
+
+    // The largest order aligned at `page` that fits in `pages`
+    private static int LargestAlignedOrder(int page, int pages) =>
+        Math.Min(BitOperations.TrailingZeroCount(page), BitOperations.Log2((uint)pages));
+
+    // Frees a block, merging it upwards while its buddy is free
+    private void Release(int page, int order)
+    {
+        while (order < OrderCount - 1)
+        {
+            var buddy = page ^ (1 << order);
+            if (buddy + (1 << order) > _pageCount || _freeOrder[buddy] != order)
             {
-                totalFree += size;
+                break;
             }
-            return (totalFree, _freeBlocks.Count);
+
+            Remove(buddy, order);
+            page = Math.Min(page, buddy);
+            order++;
+        }
+
+        Push(page, order);
+    }
+
+    private void Push(int page, int order)
+    {
+        var head = _freeHeads[order];
+        _next[page] = head;
+        _prev[page] = None;
+        if (head != None)
+        {
+            _prev[head] = page;
         }
+
+        _freeHeads[order] = page;
+        _freeOrder[page] = (sbyte)order;
+        _nonEmptyOrders |= 1u << order;
+        _freePages += 1L << order;
+        _freeBlockCount++;
+    }
+
+    private void Remove(int page, int order)
+    {
+        var next = _next[page];
+        var prev = _prev[page];
+        if (prev != None)
+        {
+            _next[prev] = next;
+        }
+        else
+        {
+            _freeHeads[order] = next;
+        }
+
+        if (next != None)
+        {
+            _prev[next] = prev;
+        }
+
+        if (_freeHeads[order] == None)
+        {
+            _nonEmptyOrders &= ~(1u << order);
+        }
+
+        _freeOrder[page] = None;
+        _freePages -= 1L << order;
+        _freeBlockCount--;
     }
 }
 
+/// <summary>
+/// Snapshot of <see cref="SharedMemoryBuddyAllocator"/> counters.
+/// </summary>
+internal readonly record struct SharedMemoryBlockStats(
+    long TotalFree,
+    int FreeBlockCount,
+    long LargestFreeBlock,
+    int AllocationCount,
+    long AllocatedBytes,
+    long RequestedBytes,
+    long FailedAllocations);
+
 /// <summary>
 /// Manages allocations from a VirtioFS-shared memory region.
 /// Thread-safe for concurrent allocation/deallocation.
@@ -152,7 +324,7 @@ public sealed class SharedMemoryAllocator : IDisposable
     private readonly SharedMemoryAllocatorConfig _config;
     private MemoryMappedFile? _mappedFile;
     private MemoryMappedViewAccessor? _accessor;
-    private SharedMemoryFreeList? _freeList;
+    private SharedMemoryBuddyAllocator? _freeList;
     private bool _disposed;
     private readonly object _initLock = new();
 
@@ -271,7 +443,7 @@ public sealed class SharedMemoryAllocator : IDisposable
                 BasePointer = (nint)ptr;
             }
 
-            _freeList = new SharedMemoryFreeList(RegionSize);
+            _freeList = new SharedMemoryBuddyAllocator(RegionSize);
 
             _logger.Info($"Shared memory allocator initialized: {RegionSize / (1024 * 1024)} MB at 0x{BasePointer:X}");
             return true;
@@ -319,6 +491,7 @@ public sealed class SharedMemoryAllocator : IDisposable
         {
             Offset = offset,
             Size = size,
+            Capacity = (size + SharedMemoryBuddyAllocator.PageSize - 1) & ~(SharedMemoryBuddyAllocator.PageSize - 1),
             Pointer = pointer
         };
     }
@@ -338,7 +511,12 @@ public sealed class SharedMemoryAllocator : IDisposable
             return;
         }
 
-        _freeList.Free(allocation.Offset, allocation.Size);
+        if (!_freeList.Free(allocation.Offset, allocation.Size))
+        {
+            _logger.Warn($"Ignoring free of unknown shared allocation at offset {allocation.Offset}");
+            return;
+        }
+
         _logger.Debug($"Freed {allocation.Size} bytes at offset {allocation.Offset}");
     }
 
@@ -374,13 +552,17 @@ public sealed class SharedMemoryAllocator : IDisposable
             return new SharedMemoryStats();
         }
 
-        var (totalFree, freeBlockCount) = _freeList.GetStats();
+        var blocks = _freeList.GetStats();
         return new SharedMemoryStats
         {
             TotalSizeBytes = RegionSize,
-            FreeBytes = totalFree,
-            UsedBytes = RegionSize - totalFree,
-            FreeBlockCount = freeBlockCount,
+            FreeBytes = blocks.TotalFree,
+            UsedBytes = RegionSize - blocks.TotalFree,
+            FreeBlockCount = blocks.FreeBlockCount,
+            LargestFreeBlockBytes = blocks.LargestFreeBlock,
+            AllocationCount = blocks.AllocationCount,
+            WastedBytes = blocks.AllocatedBytes - blocks.RequestedBytes,
+            FailedAllocations = blocks.FailedAllocations,
             IsInitialized = IsInitialized
         };
     }
@@ -428,8 +610,27 @@ public sealed record SharedMemoryStats
     public long FreeBytes { get; init; }
     public long UsedBytes { get; init; }
     public int FreeBlockCount { get; init; }
+
+    /// <summary>Largest single allocation that would currently succeed.</summary>
+    public long LargestFreeBlockBytes { get; init; }
+
+    /// <summary>Live allocations.</summary>
+    public int AllocationCount { get; init; }
+
+    /// <summary>Bytes lost to rounding live allocations up to a page.</summary>
+    public long WastedBytes { get; init; }
+
+    /// <summary>Allocations refused since initialization.</summary>
+    public long FailedAllocations { get; init; }
+
     public bool IsInitialized { get; init; }
 
+    /// <summary>
+    /// Share of free memory outside the largest free block: 0 when it is all
+    /// one block, approaching 1 as it splinters.
+    /// </summary>
+    public double Fragmentation => FreeBytes > 0 ? 1.0 - ((double)LargestFreeBlockBytes / FreeBytes) : 0;
+
     public string TotalFormatted => FormatBytes(TotalSizeBytes);
     public string FreeFormatted => FormatBytes(FreeBytes);
     public string UsedFormatted => FormatBytes(UsedBytes);
@@ -443,6 +644,6 @@ public sealed record SharedMemoryStats
 
     public override string ToString() =>
         IsInitialized
-            ? $"Total={TotalFormatted}, Used={UsedFormatted}, Free={FreeFormatted}, Blocks={FreeBlockCount}"
+            ? $"Total={TotalFormatted}, Used={UsedFormatted}, Free={FreeFormatted}, Blocks={FreeBlockCount}, Largest={FormatBytes(LargestFreeBlockBytes)}, Fragmentation={Fragmentation:P0}"
             : "Not initialized";
 }
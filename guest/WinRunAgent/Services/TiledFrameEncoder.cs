@@ -0,0 +1,394 @@
+using System.Buffers.Binary;
+using System.Diagnostics;
+using System.Runtime.InteropServices;
+using K4os.Compression.LZ4;
+
+namespace WinRun.Agent.Services;
+
+// ============================================================================
+// Tiled Frames
+//
+// LZ4 over a whole frame codes a window's flat toolbar and its photo the same
+// way. A tiled frame is cut into TileSize squares (the last row and column
+// clipped to the frame) and each tile is coded on its own, with the codec that
+// suits its content:
+//   Raw      the tile's pixels, Width * 4 bytes per row
+//   Lz4      an LZ4 block of the Raw bytes
+//   Rle      runs in row order: [count: uint16][pixel: uint32]
+//   Palette  [colorCount - 1: uint8][colorCount x pixel: uint32]
+//            [indices: 1, 2, 4 or 8 bits each (the fewest that fit
+//             colorCount), least significant bits first, each row padded
+//             to a whole byte]
+//
+// Tiled slot payload (FrameSlotFlags.Compressed | Tiled set, little-endian):
+//   [TiledFrameHeader: TileSize (uint16), Reserved (uint16), TileCount (uint32)]
+//   [TileCount x tile entry: Codec (uint8), Reserved (3 bytes), Length (uint32)]
+//   [Tile data: each tile in row-major order, Length bytes]
+//
+// The frame's width and height come from the slot header. The host decodes
+// tiled slots in the bridge (winrun_tiles.c).
+// ============================================================================
+
+/// <summary>
+/// How one tile of a tiled frame is coded. Values match winrun_tile_codec.
+/// </summary>
+public enum TileCodec : byte
+{
+    Raw = 0,
+    Lz4 = 1,
+    Rle = 2,
+    Palette = 3
+}
+
+/// <summary>
+/// Number of tiles coded with each codec.
+/// </summary>
+public struct TileCounts
+{
+    public int Raw;
+    public int Lz4;
+    public int Rle;
+    public int Palette;
+}
+
+/// <summary>
+/// Codes a frame as tiles, choosing each tile's codec from a single scan of
+/// its pixels.
+/// </summary>
+/// <remarks>
+/// The scan counts the tile's runs of equal pixels and its distinct colors
+/// (up to 256), which gives the exact RLE and palette sizes. Tiles where one
+/// of those is a quarter of the raw size or less are flat UI and use it.
+/// Busier tiles are LZ4 coded while the frame's LZ4 time stays within its
+/// budget, and sent raw after that: a frame that arrives late costs more than
+/// one that is a little larger.
+/// </remarks>
+internal sealed class TiledFrameEncoder
+{
+    /// <summary>Width and height of a tile, in pixels.</summary>
+    public const int TileSize = 64;
+
+    public const int HeaderSize = 8;
+    public const int TileEntrySize = 8;
+
+    private const int BytesPerPixel = 4;
+    private const int RunSize = 6;
+    private const int MaxPaletteColors = 256;
+
+    // Open-addressed color table; a power of two, twice the palette size
+    private const int ColorTableSize = 512;
+
+    // Flat codecs at this fraction of the raw size or less win outright
+    private const int FlatRatio = 4;
+
+    private readonly LZ4Level _level;
+
+    public TiledFrameEncoder(LZ4Level level)
+    {
+        _level = level;
+    }
+
+    /// <summary>Number of tiles covering a frame.</summary>
+    public static int TileCount(int width, int height) =>
+        ((width + TileSize - 1) / TileSize) * ((height + TileSize - 1) / TileSize);
+
+    /// <summary>
+    /// Largest payload <see cref="Encode"/> can produce: every tile raw.
+    /// </summary>
+    public static int MaximumEncodedSize(int width, int height) =>
+        HeaderSize + (TileCount(width, height) * TileEntrySize) + (width * height * BytesPerPixel);
+
+    /// <summary>
+    /// Codes a frame into <paramref name="destination"/>.
+    /// </summary>
+    /// <param name="pixels">BGRA pixels, <paramref name="stride"/> bytes per row.</param>
+    /// <param name="lz4Budget">Stopwatch ticks this frame may spend on LZ4 tiles.</param>
+    /// <param name="counts">Incremented for each tile coded.</param>
+    /// <returns>The payload size, or -1 if it didn't fit <paramref name="destination"/>.</returns>
+    public int Encode(
+        ReadOnlySpan<byte> pixels,
+        int width,
+        int height,
+        int stride,
+        Span<byte> destination,
+        long lz4Budget,
+        ref TileCounts counts)
+    {
+        var tileCount = TileCount(width, height);
+        var offset = HeaderSize + (tileCount * TileEntrySize);
+        if (destination.Length < offset)
+        {
+            return -1;
+        }
+
+        BinaryPrimitives.WriteUInt16LittleEndian(destination, TileSize);
+        BinaryPrimitives.WriteUInt16LittleEndian(destination[2..], 0);
+        BinaryPrimitives.WriteUInt32LittleEndian(destination[4..], (uint)tileCount);
+
+        Span<uint> colorKeys = stackalloc uint[ColorTableSize];
+        Span<short> colorSlots = stackalloc short[ColorTableSize];
+        Span<uint> palette = stackalloc uint[MaxPaletteColors];
+        Span<byte> packed = stackalloc byte[TileSize * TileSize * BytesPerPixel];
+
+        var lz4Spent = 0L;
+        var entry = HeaderSize;
+        for (var tileY = 0; tileY < height; tileY += TileSize)
+        {
+            for (var tileX = 0; tileX < width; tileX += TileSize)
+            {
+                var tile = new Tile(
+                    pixels[((tileY * stride) + (tileX * BytesPerPixel))..],
+                    Math.Min(TileSize, width - tileX),
+                    Math.Min(TileSize, height - tileY),
+                    stride);
+
+                colorSlots.Clear();
+                var (runs, colors) = Scan(tile, colorKeys, colorSlots, palette);
+                var rawSize = tile.Width * tile.Height * BytesPerPixel;
+                var rleSize = runs * RunSize;
+                var paletteSize = colors > 0 ? PaletteSize(tile, colors) : int.MaxValue;
+                var (flatCodec, flatSize) = rleSize <= paletteSize
+                    ? (TileCodec.Rle, rleSize)
+                    : (TileCodec.Palette, paletteSize);
+
+                var output = destination[offset..];
+                var codec = flatSize < rawSize ? flatCodec : TileCodec.Raw;
+                var length = Math.Min(flatSize, rawSize);
+
+                if (flatSize > rawSize / FlatRatio && lz4Spent < lz4Budget)
+                {
+                    var start = Stopwatch.GetTimestamp();
+                    tile.CopyTo(packed);
+                    var lz4Size = LZ4Codec.Encode(
+                        packed[..rawSize], output[..Math.Min(output.Length, length - 1)], _level);
+                    lz4Spent += Stopwatch.GetTimestamp() - start;
+
+                    if (lz4Size > 0)
+                    {
+                        codec = TileCodec.Lz4;
+                        length = lz4Size;
+                    }
+                }
+
+                if (length > output.Length)
+                {
+                    return -1;
+                }
+
+                switch (codec)
+                {
+                    case TileCodec.Rle:
+                        WriteRle(tile, output);
+                        counts.Rle++;
+                        break;
+                    case TileCodec.Palette:
+                        WritePalette(tile, output, colors, colorKeys, colorSlots, palette);
+                        counts.Palette++;
+                        break;
+                    case TileCodec.Raw:
+                        tile.CopyTo(output);
+                        counts.Raw++;
+                        break;
+                    default:
+                        counts.Lz4++;
+                        break;
+                }
+
+                destination[entry] = (byte)codec;
+                destination.Slice(entry + 1, 3).Clear();
+                BinaryPrimitives.WriteUInt32LittleEndian(destination[(entry + 4)..], (uint)length);
+                entry += TileEntrySize;
+                offset += length;
+            }
+        }
+
+        return offset;
+    }
+
+    /// <summary>
+    /// Counts a tile's runs and distinct colors, filling the color table and
+    /// palette. Colors is 0 if the tile has more than fit a palette.
+    /// </summary>
+    private static (int Runs, int Colors) Scan(Tile tile, Span<uint> colorKeys, Span<short> colorSlots, Span<uint> palette)
+    {
+        var runs = 0;
+        var colors = 0;
+        var paletteFull = false;
+        var previous = 0u;
+
+        for (var y = 0; y < tile.Height; y++)
+        {
+            var row = tile.Row(y);
+            for (var x = 0; x < row.Length; x++)
+            {
+                var pixel = row[x];
+                if (runs > 0 && pixel == previous)
+                {
+                    continue;
+                }
+
+                runs++;
+                previous = pixel;
+                if (!paletteFull && FindOrAdd(pixel, colorKeys, colorSlots, palette, ref colors) < 0)
+                {
+                    paletteFull = true;
+                }
+            }
+        }
+
+        return (runs, paletteFull ? 0 : colors);
+    }
+
+    /// <summary>
+    /// Returns a color's palette index, adding it if there is room.
+    /// </summary>
+    /// <returns>The index, or -1 if the palette is full.</returns>
+    private static int FindOrAdd(uint color, Span<uint> colorKeys, Span<short> colorSlots, Span<uint> palette, ref int colors)
+    {
+        // Slots hold index + 1, so a cleared table is empty
+        var slot = (int)((color * 2654435761u) >> 23) & (ColorTableSize - 1);
+        while (colorSlots[slot] != 0)
+        {
+            if (colorKeys[slot] == color)
+            {
+                return colorSlots[slot] - 1;
+            }
+
+            slot = (slot + 1) & (ColorTableSize - 1);
+        }
+
+        if (colors == MaxPaletteColors)
+        {
+            return -1;
+        }
+
+        colorKeys[slot] = color;
+        colorSlots[slot] = (short)(colors + 1);
+        palette[colors] = color;
+        return colors++;
+    }
+
+    private static int IndexBits(int colors) => colors switch
+    {
+        <= 2 => 1,
+        <= 4 => 2,
+        <= 16 => 4,
+        _ => 8
+    };
+
+    private static int PaletteRowBytes(int width, int colors) => ((width * IndexBits(colors)) + 7) / 8;
+
+    private static int PaletteSize(Tile tile, int colors) =>
+        1 + (colors * BytesPerPixel) + (tile.Height * PaletteRowBytes(tile.Width, colors));
+
+    private static void WriteRle(Tile tile, Span<byte> output)
+    {
+        var offset = 0;
+        var count = 0;
+        var previous = 0u;
+
+        for (var y = 0; y < tile.Height; y++)
+        {
+            var row = tile.Row(y);
+            for (var x = 0; x < row.Length; x++)
+            {
+                var pixel = row[x];
+                if (count > 0 && pixel == previous)
+                {
+                    count++;
+                    continue;
+                }
+
+                if (count > 0)
+                {
+                    offset = WriteRun(output, offset, count, previous);
+                }
+
+                previous = pixel;
+                count = 1;
+            }
+        }
+
+        _ = WriteRun(output, offset, count, previous);
+    }
+
+    private static int WriteRun(Span<byte> output, int offset, int count, uint pixel)
+    {
+        BinaryPrimitives.WriteUInt16LittleEndian(output[offset..], (ushort)count);
+        BinaryPrimitives.WriteUInt32LittleEndian(output[(offset + 2)..], pixel);
+        return offset + RunSize;
+    }
+
+    private static void WritePalette(
+        Tile tile,
+        Span<byte> output,
+        int colors,
+        Span<uint> colorKeys,
+        Span<short> colorSlots,
+        Span<uint> palette)
+    {
+        output[0] = (byte)(colors - 1);
+        for (var i = 0; i < colors; i++)
+        {
+            BinaryPrimitives.WriteUInt32LittleEndian(output[(1 + (i * BytesPerPixel))..], palette[i]);
+        }
+
+        var bits = IndexBits(colors);
+        var rowBytes = PaletteRowBytes(tile.Width, colors);
+        var indices = output.Slice(1 + (colors * BytesPerPixel), tile.Height * rowBytes);
+        indices.Clear();
+
+        var previous = 0u;
+        var previousIndex = -1;
+        for (var y = 0; y < tile.Height; y++)
+        {
+            var row = tile.Row(y);
+            var rowIndices = indices.Slice(y * rowBytes, rowBytes);
+            for (var x = 0; x < row.Length; x++)
+            {
+                var pixel = row[x];
+                if (previousIndex < 0 || pixel != previous)
+                {
+                    previous = pixel;
+                    previousIndex = FindOrAdd(pixel, colorKeys, colorSlots, palette, ref colors);
+                }
+
+                var bit = x * bits;
+                rowIndices[bit >> 3] |= (byte)(previousIndex << (bit & 7));
+            }
+        }
+    }
+
+    /// <summary>
+    /// A tile's pixels within the frame.
+    /// </summary>
+    private readonly ref struct Tile
+    {
+        private readonly ReadOnlySpan<byte> _origin;
+
+        public Tile(ReadOnlySpan<byte> origin, int width, int height, int stride)
+        {
+            _origin = origin;
+            Width = width;
+            Height = height;
+            Stride = stride;
+        }
+
+        public int Width { get; }
+        public int Height { get; }
+        public int Stride { get; }
+
+        public ReadOnlySpan<uint> Row(int y) =>
+            MemoryMarshal.Cast<byte, uint>(_origin.Slice(y * Stride, Width * BytesPerPixel));
+
+        /// <summary>Copies the tile's rows, packed, to <paramref name="destination"/>.</summary>
+        public void CopyTo(Span<byte> destination)
+        {
+            var rowBytes = Width * BytesPerPixel;
+            for (var y = 0; y < Height; y++)
+            {
+                _origin.Slice(y * Stride, rowBytes).CopyTo(destination[(y * rowBytes)..]);
+            }
+        }
+    }
+}
@@ -276,6 +276,14 @@ public sealed class WinRunAgentService : IDisposable
                 HandleConfigureStreaming(configureStreaming);
                 break;
 
+            case SetWindowThrottleMessage setWindowThrottle:
+                HandleSetWindowThrottle(setWindowThrottle);
+                break;
+
+            case PingMessage ping:
+                await HandlePingAsync(ping);
+                break;
+
             default:
                 _logger.Warn($"Unhandled message type {message.GetType().Name}");
                 await SendAckAsync(message.MessageId, success: false, "Unknown message type");
@@ -482,6 +490,41 @@ public sealed class WinRunAgentService : IDisposable
         _ = SendAckAsync(request.MessageId, success: true);
     }
 
+    private void HandleSetWindowThrottle(SetWindowThrottleMessage request)
+    {
+        // Visibility changes are frequent and fire-and-forget on the host, so no ack is sent
+        if (FrameStreaming == null)
+        {
+            _logger.Debug("Frame streaming not enabled, ignoring window throttle hint");
+            return;
+        }
+
+        FrameStreaming.SetWindowThrottle(request.WindowId, request.Visibility, request.MaxFps, request.IsFocused);
+        if (request.HostDecodeUs is int hostDecodeUs)
+        {
+            FrameStreaming.SetHostDecodeTime(request.WindowId, TimeSpan.FromMicroseconds(hostDecodeUs));
+        }
+
+        if (request.HostSkippedFrames is > 0)
+        {
+            FrameStreaming.ObserveHostBacklog(request.WindowId);
+        }
+    }
+
+    private async Task HandlePingAsync(PingMessage ping)
+    {
+        // Answer with a heartbeat rather than an ack so every reply also carries
+        // the guest's load. No retries: a late reply only skews the host's RTT,
+        // and the next ping supersedes it.
+        var heartbeat = SessionManager.GenerateHeartbeat() with
+        {
+            PingSequence = ping.Sequence,
+            PingSentAt = ping.SentAt
+        };
+
+        await SendMessageAsync(heartbeat, RetryPolicy.NoRetry);
+    }
+
     private async Task SendCapabilityAnnouncementAsync()
     {
         var capabilities =
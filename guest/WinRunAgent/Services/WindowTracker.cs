@@ -33,6 +33,11 @@ public sealed class WindowTracker : IDisposable
     /// </summary>
     public IReadOnlyDictionary<nint, WindowMetadata> TrackedWindows => _trackedWindows;
 
+    /// <summary>
+    /// Tracks a window without Win32 hooks, for driving capture in tests.
+    /// </summary>
+    internal void AddTrackedWindow(WindowMetadata metadata) => _trackedWindows[metadata.Hwnd] = metadata;
+
     /// <summary>
     /// Starts monitoring window events. Installs Win32 hooks for system-wide window tracking.
     /// </summary>
@@ -0,0 +1,85 @@
+// FramePixelsBench - Compares the vectorized pixel kernels in FramePixels.cs
+// against their scalar loops on a desktop-sized frame.
+//
+// Usage: dotnet run -c Release [width] [height] [iterations]
+
+using System.Diagnostics;
+using System.Numerics;
+using System.Runtime.Intrinsics.Arm;
+using System.Runtime.Intrinsics.X86;
+using WinRun.Agent.Services;
+
+var width = args.Length > 0 ? int.Parse(args[0]) : 3840;
+var height = args.Length > 1 ? int.Parse(args[1]) : 2160;
+var iterations = args.Length > 2 ? int.Parse(args[2]) : 50;
+
+var stride = width * FramePixels.BytesPerPixel;
+var source = new byte[stride * height];
+Random.Shared.NextBytes(source);
+var destination = new byte[source.Length];
+
+Console.WriteLine($"Frame {width}x{height}, {iterations} iterations");
+Console.WriteLine($"Vector<byte>: {Vector<byte>.Count * 8} bits, Avx2: {Avx2.IsSupported}, " +
+    $"Ssse3: {Ssse3.IsSupported}, AdvSimd: {AdvSimd.Arm64.IsSupported}");
+Console.WriteLine();
+
+Measure("copy", source.Length, () =>
+    FramePixels.CopyRegion(source, stride, 0, 0, width, height, swapRedBlue: false, destination));
+
+Compare("copy + RGBA->BGRA", source.Length,
+    () => FramePixels.CopyRegion(source, stride, 0, 0, width, height, swapRedBlue: true, destination),
+    () =>
+    {
+        for (var row = 0; row < height; row++)
+        {
+            FramePixels.SwapRedBlueScalar(
+                source.AsSpan(row * stride, stride), destination.AsSpan(row * stride, stride));
+        }
+    });
+
+foreach (var swap in new[] { false, true })
+{
+    var outRowBytes = width / 2 * FramePixels.BytesPerPixel;
+    Compare(swap ? "downscale 2x + RGBA->BGRA" : "downscale 2x", source.Length,
+        () => FramePixels.Downscale2x(source, stride, 0, 0, width, height, swap, destination),
+        () =>
+        {
+            for (var row = 0; row < height / 2; row++)
+            {
+                FramePixels.Downscale2xRowScalar(
+                    source.AsSpan(row * 2 * stride, stride),
+                    source.AsSpan(((row * 2) + 1) * stride, stride),
+                    destination.AsSpan(row * outRowBytes, outRowBytes),
+                    swap);
+            }
+        });
+}
+
+void Compare(string name, long bytes, Action vectorized, Action scalar)
+{
+    var fast = Measure(name, bytes, vectorized);
+    var slow = Measure(name + " (scalar)", bytes, scalar);
+    Console.WriteLine($"  speedup {slow / fast:F1}x");
+    Console.WriteLine();
+}
+
+// Returns seconds per iteration; throughput is in source bytes
+double Measure(string name, long bytes, Action action)
+{
+    // Warm up past tiered compilation
+    for (var i = 0; i < 5; i++)
+    {
+        action();
+    }
+
+    var stopwatch = Stopwatch.StartNew();
+    for (var i = 0; i < iterations; i++)
+    {
+        action();
+    }
+    stopwatch.Stop();
+
+    var seconds = stopwatch.Elapsed.TotalSeconds / iterations;
+    Console.WriteLine($"{name,-36} {seconds * 1000,8:F2} ms  {bytes / seconds / 1e6,8:F0} MB/s");
+    return seconds;
+}
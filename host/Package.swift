@@ -11,9 +11,18 @@ let spiceBridgeHelperTargets: [Target] = [
             .apt(["spice-client-glib-2.0"])
         ]
     ),
+    // libjpeg-turbo for MJPEG video streams (a spice-gtk dependency, so already installed)
+    .systemLibrary(
+        name: "CJPEGTurbo",
+        pkgConfig: "libjpeg",
+        providers: [
+            .brew(["jpeg-turbo"]),
+            .apt(["libjpeg-turbo8-dev"])
+        ]
+    ),
     .target(
         name: "CSpiceBridge",
-        dependencies: ["CSpiceGlib"],
+        dependencies: ["CSpiceGlib", "CJPEGTurbo"],
         path: "Sources/CSpiceBridge",
         publicHeadersPath: "include",
         cSettings: [
@@ -0,0 +1,115 @@
+// Measures the effect of huge pages on the frame copy and pixel conversion
+// kernels used by the bridge.
+//
+// Allocates a pool of 4K BGRA frames with winrun_buffer_alloc in each huge-page
+// mode and times two passes over the whole pool:
+//   copy     - memcpy frame to frame, as when filling pooled/shared surfaces
+//   convert  - BGRA -> RGBA swizzle, the typical pixel conversion kernel
+//
+// Build and run with `make bench-hugepages` (BENCH_ARGS="frames iterations"),
+// which compiles this file together with Sources/CSpiceBridge/winrun_buffer.c.
+//
+// Explicit huge pages need a reserved pool on Linux, e.g.
+//   echo 256 | sudo tee /proc/sys/vm/nr_hugepages
+// and transparent huge pages need /sys/kernel/mm/transparent_hugepage/enabled
+// set to `madvise` or `always`.
+
+#include "CSpiceBridge.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FRAME_WIDTH 3840
+#define FRAME_HEIGHT 2160
+#define FRAME_BYTES ((size_t)FRAME_WIDTH * FRAME_HEIGHT * 4)
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static const char *status_name(winrun_hugepage_status status) {
+    switch (status) {
+        case WINRUN_HUGEPAGE_STATUS_EXPLICIT: return "explicit";
+        case WINRUN_HUGEPAGE_STATUS_TRANSPARENT: return "transparent";
+        default: return "none";
+    }
+}
+
+static const char *mode_name(winrun_hugepage_mode mode) {
+    switch (mode) {
+        case WINRUN_HUGEPAGES_EXPLICIT: return "explicit";
+        case WINRUN_HUGEPAGES_TRANSPARENT: return "transparent";
+        default: return "off";
+    }
+}
+
+// Copies each frame to the next one in the pool
+static void copy_pass(uint8_t *pool, size_t frames) {
+    for (size_t i = 0; i + 1 < frames; ++i) {
+        memcpy(pool + (i + 1) * FRAME_BYTES, pool + i * FRAME_BYTES, FRAME_BYTES);
+    }
+}
+
+// Swizzles BGRA to RGBA in place across the pool
+static void convert_pass(uint8_t *pool, size_t frames) {
+    uint32_t *pixels = (uint32_t *)pool;
+    size_t count = frames * FRAME_BYTES / 4;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t p = pixels[i];
+        pixels[i] = (p & 0xFF00FF00u) | ((p & 0x00FF0000u) >> 16) | ((p & 0x000000FFu) << 16);
+    }
+}
+
+static void run(winrun_hugepage_mode mode, size_t frames, int iterations) {
+    winrun_buffer buffer;
+    if (!winrun_buffer_alloc(frames * FRAME_BYTES, mode, &buffer)) {
+        printf("%-12s allocation failed\n", mode_name(mode));
+        return;
+    }
+
+    // First touch faults the pages in; keep it out of the timings
+    memset(buffer.data, 0x5A, buffer.size);
+    size_t backed = winrun_hugepage_backed_bytes(buffer.data, buffer.size);
+
+    double bytes = (double)buffer.size * iterations;
+
+    double start = now_seconds();
+    for (int i = 0; i < iterations; ++i) {
+        copy_pass(buffer.data, frames);
+    }
+    double copy_gbps = bytes / (now_seconds() - start) / 1e9;
+
+    start = now_seconds();
+    for (int i = 0; i < iterations; ++i) {
+        convert_pass(buffer.data, frames);
+    }
+    double convert_gbps = bytes / (now_seconds() - start) / 1e9;
+
+    printf("%-12s %-12s %8.0f MB %10.2f %10.2f\n",
+           mode_name(mode), status_name(buffer.hugepages),
+           (double)backed / (1024 * 1024), copy_gbps, convert_gbps);
+
+    winrun_buffer_free(&buffer);
+}
+
+int main(int argc, char **argv) {
+    size_t frames = argc > 1 ? (size_t)strtoul(argv[1], NULL, 10) : 8;
+    int iterations = argc > 2 ? atoi(argv[2]) : 10;
+    if (frames < 2 || iterations < 1) {
+        fprintf(stderr, "usage: %s [frames >= 2] [iterations >= 1]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%zu x 4K BGRA frames (%.0f MB), %d iterations\n",
+           frames, (double)(frames * FRAME_BYTES) / (1024 * 1024), iterations);
+    printf("%-12s %-12s %11s %10s %10s\n", "mode", "obtained", "huge-backed", "copy GB/s", "conv GB/s");
+
+    run(WINRUN_HUGEPAGES_OFF, frames, iterations);
+    run(WINRUN_HUGEPAGES_TRANSPARENT, frames, iterations);
+    run(WINRUN_HUGEPAGES_EXPLICIT, frames, iterations);
+    return 0;
+}
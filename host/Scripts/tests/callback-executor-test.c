@@ -0,0 +1,137 @@
+// Checks callback executors: frames from several mock streams run only when
+// the consumer drains, on the draining thread, with one wakeup per batch;
+// a stream keeps only its newest frame queued; closing a stream drops its
+// queued frames; and a stream moved back to inline delivery calls its
+// consumer directly again.
+//
+// Build and run with `make test-bridge`. Linux only: on macOS the bridge talks
+// to spice-gtk.
+
+#include "CSpiceBridge.h"
+#include "check.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+
+#define STREAMS 8
+
+static pthread_t consumer_thread;
+
+typedef struct {
+    _Atomic int frames;
+    _Atomic int frames_off_consumer;
+} frame_log;
+
+static void on_frame(const uint8_t *data, size_t length, void *user_data) {
+    (void)data;
+    frame_log *log = user_data;
+    atomic_fetch_add(&log->frames, 1);
+    if (length != 1024 || !pthread_equal(pthread_self(), consumer_thread)) {
+        atomic_fetch_add(&log->frames_off_consumer, 1);
+    }
+}
+
+static void on_wakeup(void *user_data) {
+    atomic_fetch_add((_Atomic int *)user_data, 1);
+}
+
+static void sleep_ms(long ms) {
+    struct timespec delay = { .tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000 * 1000 };
+    nanosleep(&delay, NULL);
+}
+
+static winrun_spice_stream_handle open_stream(uint64_t window_id, frame_log *log) {
+    char error[256] = { 0 };
+    winrun_spice_stream_handle stream = winrun_spice_stream_open_tcp(
+        "127.0.0.1", 5900, false, window_id, log, on_frame, NULL, NULL, NULL, error, sizeof(error));
+    if (!stream) {
+        fprintf(stderr, "open failed: %s\n", error);
+    }
+    return stream;
+}
+
+static void test_batches_frames_from_many_streams(void) {
+    consumer_thread = pthread_self();
+    _Atomic int wakeups = 0;
+    winrun_executor_handle executor = winrun_executor_create(on_wakeup, &wakeups);
+    CHECK(executor != NULL);
+
+    frame_log logs[STREAMS] = { 0 };
+    winrun_spice_stream_handle streams[STREAMS];
+    for (int i = 0; i < STREAMS; ++i) {
+        streams[i] = open_stream(100 + (uint64_t)i, &logs[i]);
+        CHECK(streams[i] != NULL);
+        winrun_spice_stream_set_executor(streams[i], WINRUN_CALLBACK_FRAME, executor);
+    }
+
+    // Frames arrive every 33 ms per stream; drain every 100 ms
+    size_t drained = 0;
+    for (int round = 0; round < 5; ++round) {
+        sleep_ms(100);
+        drained += winrun_executor_drain(executor);
+    }
+
+    winrun_executor_stats stats;
+    CHECK(winrun_executor_get_stats(executor, &stats));
+    CHECK(stats.drained == drained);
+    CHECK(stats.wakeups == (uint64_t)atomic_load(&wakeups));
+
+    int frames = 0;
+    for (int i = 0; i < STREAMS; ++i) {
+        frames += atomic_load(&logs[i].frames);
+        // Only a first frame sent before the executor was set runs inline
+        CHECK(atomic_load(&logs[i].frames_off_consumer) <= 1);
+    }
+    CHECK(frames >= (int)drained && drained > 0);
+    // Roughly one wakeup per drain, not one per frame
+    CHECK(stats.wakeups <= 6);
+    // About three frames per stream arrive between drains; older ones are
+    // overwritten rather than queued behind the newest
+    CHECK(stats.coalesced > 0);
+    CHECK(stats.drained + stats.coalesced <= stats.posted);
+    CHECK(drained >= stats.wakeups * STREAMS / 2);
+
+    // Frames queued for a stream that closes are dropped, not delivered
+    sleep_ms(100);
+    for (int i = 0; i < STREAMS; ++i) {
+        winrun_spice_stream_close(streams[i]);
+    }
+    CHECK(winrun_executor_drain(executor) == 0);
+    CHECK(winrun_executor_get_stats(executor, &stats));
+    CHECK(stats.dropped > 0);
+    CHECK(stats.posted == stats.drained + stats.dropped + stats.coalesced);
+
+    winrun_executor_destroy(executor);
+}
+
+static void test_back_to_inline(void) {
+    consumer_thread = pthread_self();
+    winrun_executor_handle executor = winrun_executor_create(NULL, NULL);
+    frame_log log = { 0 };
+    winrun_spice_stream_handle stream = open_stream(7, &log);
+    CHECK(stream != NULL);
+    winrun_spice_stream_set_executor(stream, WINRUN_CALLBACK_ALL, executor);
+    sleep_ms(100);
+
+    // Queued frames are dropped when the stream leaves the executor
+    winrun_spice_stream_set_executor(stream, WINRUN_CALLBACK_FRAME, NULL);
+    CHECK(winrun_executor_drain(executor) == 0);
+
+    // Inline again: the worker thread calls the consumer itself
+    int before = atomic_load(&log.frames);
+    sleep_ms(100);
+    CHECK(atomic_load(&log.frames) > before);
+    CHECK(atomic_load(&log.frames_off_consumer) > 0);
+
+    winrun_spice_stream_close(stream);
+    winrun_executor_destroy(executor);
+}
+
+int main(void) {
+    test_batches_frames_from_many_streams();
+    test_back_to_inline();
+
+    return check_summary("callback executor");
+}
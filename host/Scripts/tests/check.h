@@ -0,0 +1,26 @@
+#pragma once
+
+// Check helpers shared by the C bridge tests. Each test counts failed CHECKs
+// and ends main with `return check_summary("<suite>");`.
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+// Reports the suite's result; returns main's exit status
+static inline int check_summary(const char *suite) {
+    if (failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("%s tests passed\n", suite);
+    return 0;
+}
@@ -0,0 +1,257 @@
+// Checks control request tracking: thousands of pipelined requests complete
+// from out-of-order responses mixed with other messages, timeouts fire from
+// the timer wheel, cancels and disconnects end requests exactly once, and a
+// response racing its timeout still runs the callback only once.
+//
+// Build and run with `make test-bridge`.
+
+#include "CSpiceBridge.h"
+#include "check.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define REQUESTS 5000
+
+typedef struct {
+    uint8_t *bytes;
+    size_t length;
+    size_t capacity;
+} chunk;
+
+static void append(chunk *c, uint8_t type, const char *json) {
+    size_t length = strlen(json);
+    if (c->length + 5 + length > c->capacity) {
+        c->capacity = (c->capacity + 5 + length) * 2;
+        c->bytes = realloc(c->bytes, c->capacity);
+    }
+    c->bytes[c->length++] = type;
+    for (int i = 0; i < 4; ++i) {
+        c->bytes[c->length++] = (uint8_t)(length >> (8 * i));
+    }
+    memcpy(c->bytes + c->length, json, length);
+    c->length += length;
+}
+
+static void append_ack(chunk *c, uint32_t message_id) {
+    char json[128];
+    snprintf(json, sizeof(json), "{\"timestamp\":1,\"messageId\":%u,\"success\":true,\"errorMessage\":null}", message_id);
+    append(c, 0xFF, json);
+}
+
+typedef struct {
+    _Atomic int calls;
+    _Atomic int status;
+    uint32_t message_id;
+    uint8_t response_type;
+} request_log;
+
+static void on_request(uint32_t message_id, winrun_request_status status, const uint8_t *response, size_t length, void *user_data) {
+    request_log *log = user_data;
+    atomic_fetch_add(&log->calls, 1);
+    atomic_store(&log->status, (int)status);
+    log->message_id = message_id;
+    log->response_type = status == WINRUN_REQUEST_COMPLETED && response && length > 5 ? response[0] : 0;
+}
+
+typedef struct {
+    int calls;
+} fallback_log;
+
+static void on_control(const uint8_t *data, size_t length, void *user_data) {
+    (void)data;
+    (void)length;
+    fallback_log *log = user_data;
+    log->calls++;
+}
+
+static void sleep_ms(long ms) {
+    struct timespec delay = { .tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000 * 1000 };
+    nanosleep(&delay, NULL);
+}
+
+static void test_pipelined_responses(void) {
+    winrun_request_tracker_handle tracker = winrun_request_tracker_create();
+    CHECK(tracker != NULL);
+
+    static request_log logs[REQUESTS];
+    static uint32_t ids[REQUESTS];
+    memset(logs, 0, sizeof(logs));
+    for (int i = 0; i < REQUESTS; ++i) {
+        ids[i] = winrun_request_begin(tracker, 5000, on_request, &logs[i]);
+        CHECK(ids[i] != 0);
+        CHECK(i == 0 || ids[i] != ids[i - 1]);
+    }
+
+    // Responses arrive in reverse, in batches, with other messages mixed in
+    chunk c = { 0 };
+    size_t matched = 0;
+    for (int i = REQUESTS - 1; i >= 0; --i) {
+        append_ack(&c, ids[i]);
+        if (i % 100 == 0) {
+            append(&c, 0x87, "{\"timestamp\":1,\"trackedWindowCount\":3,\"uptimeMs\":10}");
+            fallback_log control = { 0 };
+            matched += winrun_request_tracker_match(tracker, c.bytes, c.length, on_control, &control);
+            CHECK(control.calls == 1);
+            c.length = 0;
+        }
+    }
+    CHECK(matched == REQUESTS);
+
+    int wrong = 0;
+    for (int i = 0; i < REQUESTS; ++i) {
+        if (atomic_load(&logs[i].calls) != 1 || atomic_load(&logs[i].status) != WINRUN_REQUEST_COMPLETED ||
+            logs[i].message_id != ids[i] || logs[i].response_type != 0xFF) {
+            wrong++;
+        }
+    }
+    CHECK(wrong == 0);
+
+    // A second response for the same ID is unsolicited
+    append_ack(&c, ids[0]);
+    fallback_log late = { 0 };
+    CHECK(winrun_request_tracker_match(tracker, c.bytes, c.length, on_control, &late) == 0);
+    CHECK(late.calls == 1 && atomic_load(&logs[0].calls) == 1);
+
+    winrun_request_stats stats;
+    CHECK(winrun_request_tracker_get_stats(tracker, &stats));
+    CHECK(stats.started == REQUESTS && stats.completed == REQUESTS && stats.in_flight == 0);
+
+    free(c.bytes);
+    winrun_request_tracker_destroy(tracker);
+}
+
+static void test_response_kinds(void) {
+    winrun_request_tracker_handle tracker = winrun_request_tracker_create();
+    request_log sessions = { 0 };
+    request_log error = { 0 };
+    request_log split = { 0 };
+    uint32_t sessions_id = winrun_request_begin(tracker, 1000, on_request, &sessions);
+    uint32_t error_id = winrun_request_begin(tracker, 1000, on_request, &error);
+    uint32_t split_id = winrun_request_begin(tracker, 1000, on_request, &split);
+
+    char json[256];
+    chunk c = { 0 };
+    snprintf(json, sizeof(json), "{\"timestamp\":1,\"sessions\":[{\"messageId\":%u}],\"messageId\":%u}", error_id, sessions_id);
+    append(&c, 0x8C, json);
+    append(&c, 0xFE, "{\"timestamp\":1,\"code\":\"X\",\"message\":\"no id\",\"relatedMessageId\":null}");
+    snprintf(json, sizeof(json), "{\"timestamp\":1,\"code\":\"X\",\"message\":\"m\",\"relatedMessageId\":%u}", error_id);
+    append(&c, 0xFE, json);
+    fallback_log control = { 0 };
+    CHECK(winrun_request_tracker_match(tracker, c.bytes, c.length, on_control, &control) == 2);
+    CHECK(sessions.calls == 1 && sessions.response_type == 0x8C);
+    CHECK(error.calls == 1 && error.response_type == 0xFE);
+    CHECK(control.calls == 1);
+
+    // Half an envelope goes through untouched
+    c.length = 0;
+    append_ack(&c, split_id);
+    fallback_log partial = { 0 };
+    CHECK(winrun_request_tracker_match(tracker, c.bytes, c.length - 2, on_control, &partial) == 0);
+    CHECK(partial.calls == 1 && split.calls == 0);
+
+    free(c.bytes);
+    winrun_request_tracker_destroy(tracker);
+    CHECK(split.calls == 1 && split.status == WINRUN_REQUEST_CANCELLED);
+}
+
+static void test_timeouts_and_cancels(void) {
+    winrun_request_tracker_handle tracker = winrun_request_tracker_create();
+    static request_log short_logs[1000];
+    memset(short_logs, 0, sizeof(short_logs));
+    for (int i = 0; i < 1000; ++i) {
+        CHECK(winrun_request_begin(tracker, 30, on_request, &short_logs[i]) != 0);
+    }
+    request_log slow = { 0 };
+    request_log dropped = { 0 };
+    uint32_t slow_id = winrun_request_begin(tracker, 2000, on_request, &slow);
+    uint32_t dropped_id = winrun_request_begin(tracker, 2000, on_request, &dropped);
+
+    // Cancel hands back the user data and skips the callback
+    void *user_data = NULL;
+    CHECK(winrun_request_cancel(tracker, dropped_id, &user_data));
+    CHECK(user_data == &dropped);
+    CHECK(!winrun_request_cancel(tracker, dropped_id, NULL));
+
+    sleep_ms(150);
+    int timed_out = 0;
+    for (int i = 0; i < 1000; ++i) {
+        timed_out += atomic_load(&short_logs[i].calls) == 1 &&
+            atomic_load(&short_logs[i].status) == WINRUN_REQUEST_TIMED_OUT;
+    }
+    CHECK(timed_out == 1000);
+    CHECK(atomic_load(&slow.calls) == 0 && atomic_load(&dropped.calls) == 0);
+
+    winrun_request_stats stats;
+    CHECK(winrun_request_tracker_get_stats(tracker, &stats));
+    CHECK(stats.timed_out == 1000 && stats.in_flight == 1);
+
+    // Disconnect: what is left is cancelled, once
+    CHECK(winrun_request_cancel_all(tracker) == 1);
+    CHECK(atomic_load(&slow.calls) == 1 && atomic_load(&slow.status) == WINRUN_REQUEST_CANCELLED);
+    CHECK(!winrun_request_complete(tracker, slow_id, NULL, 0));
+
+    // The tracker goes back to sleep and wakes for the next request
+    request_log again = { 0 };
+    CHECK(winrun_request_begin(tracker, 20, on_request, &again) != 0);
+    sleep_ms(100);
+    CHECK(atomic_load(&again.calls) == 1 && atomic_load(&again.status) == WINRUN_REQUEST_TIMED_OUT);
+
+    winrun_request_tracker_destroy(tracker);
+}
+
+typedef struct {
+    winrun_request_tracker_handle tracker;
+    uint32_t *ids;
+    int count;
+} responder;
+
+static void *respond_all(void *context) {
+    responder *r = context;
+    sleep_ms(20);
+    for (int i = 0; i < r->count; ++i) {
+        uint8_t envelope[5] = { 0xFF };
+        winrun_request_complete(r->tracker, r->ids[i], envelope, sizeof(envelope));
+    }
+    return NULL;
+}
+
+static void test_response_races_timeout(void) {
+    winrun_request_tracker_handle tracker = winrun_request_tracker_create();
+    static request_log logs[REQUESTS];
+    static uint32_t ids[REQUESTS];
+    memset(logs, 0, sizeof(logs));
+    for (int i = 0; i < REQUESTS; ++i) {
+        ids[i] = winrun_request_begin(tracker, 20, on_request, &logs[i]);
+    }
+
+    responder r = { tracker, ids, REQUESTS };
+    pthread_t thread;
+    CHECK(pthread_create(&thread, NULL, respond_all, &r) == 0);
+    pthread_join(thread, NULL);
+    sleep_ms(50);
+
+    int once = 0;
+    for (int i = 0; i < REQUESTS; ++i) {
+        once += atomic_load(&logs[i].calls) == 1;
+    }
+    CHECK(once == REQUESTS);
+
+    winrun_request_stats stats;
+    CHECK(winrun_request_tracker_get_stats(tracker, &stats));
+    CHECK(stats.completed + stats.timed_out == REQUESTS && stats.in_flight == 0);
+    winrun_request_tracker_destroy(tracker);
+}
+
+int main(void) {
+    test_pipelined_responses();
+    test_response_kinds();
+    test_timeouts_and_cancels();
+    test_response_races_timeout();
+
+    return check_summary("control request");
+}
@@ -0,0 +1,78 @@
+// Checks the shared frame ring indices: pending spans, wraparound, bulk
+// release clamped to what is pending, and headers that can't be trusted.
+//
+// Build and run with `make test-bridge`.
+
+#include "CSpiceBridge.h"
+#include "check.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Header fields as u32s: slotCount [3], writeIndex [7], readIndex [8]
+static uint32_t header[16];
+
+static void set_ring(uint32_t slot_count, uint32_t write_index, uint32_t read_index) {
+    memset(header, 0, sizeof(header));
+    header[3] = slot_count;
+    header[7] = write_index;
+    header[8] = read_index;
+}
+
+static void test_pending_span(void) {
+    winrun_ring_span span;
+
+    set_ring(4, 3, 0);
+    CHECK(winrun_ring_pending(header, sizeof(header), &span));
+    CHECK(span.first == 0 && span.pending == 3 && span.latest == 2 && span.slot_count == 4);
+
+    // Wrapped: slots 3, 0 and 1 are pending
+    set_ring(4, 2, 3);
+    CHECK(winrun_ring_pending(header, sizeof(header), &span));
+    CHECK(span.first == 3 && span.pending == 3 && span.latest == 1);
+
+    set_ring(4, 1, 1);
+    CHECK(winrun_ring_pending(header, sizeof(header), &span));
+    CHECK(span.pending == 0);
+}
+
+static void test_release(void) {
+    winrun_ring_span span;
+
+    // Drain to the newest slot: release all but one, in one store
+    set_ring(4, 2, 3);
+    CHECK(winrun_ring_release(header, sizeof(header), 2) == 2);
+    CHECK(header[8] == 1);
+    CHECK(winrun_ring_pending(header, sizeof(header), &span));
+    CHECK(span.first == 1 && span.pending == 1 && span.latest == 1);
+
+    // Never past the write index
+    CHECK(winrun_ring_release(header, sizeof(header), 10) == 1);
+    CHECK(header[8] == 2);
+    CHECK(winrun_ring_release(header, sizeof(header), 1) == 0);
+    CHECK(header[8] == 2);
+}
+
+static void test_rejects_bad_headers(void) {
+    winrun_ring_span span;
+
+    set_ring(4, 1, 0);
+    CHECK(!winrun_ring_pending(header, 32, &span));
+    CHECK(!winrun_ring_pending(NULL, sizeof(header), &span));
+
+    set_ring(0, 0, 0);
+    CHECK(!winrun_ring_pending(header, sizeof(header), &span));
+
+    set_ring(4, 4, 0);
+    CHECK(!winrun_ring_pending(header, sizeof(header), &span));
+    CHECK(winrun_ring_release(header, sizeof(header), 1) == 0);
+    CHECK(header[8] == 0);
+}
+
+int main(void) {
+    test_pending_span();
+    test_release();
+    test_rejects_bad_headers();
+
+    return check_summary("frame ring");
+}
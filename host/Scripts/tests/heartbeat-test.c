@@ -0,0 +1,324 @@
+// Checks the guest heartbeat: a fake guest answering pings over a loopback
+// yields RTT percentiles and jitter, a guest that goes quiet is reported
+// stalled within the deadline and healthy again on its next reply, stale and
+// forged replies are dropped, and a mock stream can start, replace and stop
+// its heartbeat.
+//
+// Build and run with `make test-bridge`.
+
+#include "CSpiceBridge.h"
+#include "winrun_heartbeat.h"
+#include "check.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static void sleep_ms(long ms) {
+    struct timespec delay = { .tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000 * 1000 };
+    nanosleep(&delay, NULL);
+}
+
+static size_t envelope(uint8_t *buffer, uint8_t type, const char *json) {
+    size_t length = strlen(json);
+    buffer[0] = type;
+    for (int i = 0; i < 4; ++i) {
+        buffer[1 + i] = (uint8_t)(length >> (8 * i));
+    }
+    memcpy(buffer + 5, json, length);
+    return 5 + length;
+}
+
+// MARK: - Fake Guest
+
+#define GUEST_QUEUE 256
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+    pthread_t thread;
+    bool stopping;
+    // While paused the guest reads pings but never answers them
+    _Atomic bool paused;
+    long delay_ms;
+    unsigned sequences[GUEST_QUEUE];
+    long long sent_at[GUEST_QUEUE];
+    size_t head;
+    size_t tail;
+    winrun_heartbeat *heartbeat;
+    _Atomic int pings;
+} fake_guest;
+
+static bool guest_send(const uint8_t *data, size_t length, void *context) {
+    fake_guest *guest = context;
+    CHECK(length > 5 && data[0] == 0x0C);
+    char json[128] = { 0 };
+    memcpy(json, data + 5, length - 5 < sizeof(json) - 1 ? length - 5 : sizeof(json) - 1);
+    unsigned message_id = 1;
+    unsigned sequence = 0;
+    long long sent_at = 0;
+    CHECK(sscanf(json, "{\"messageId\":%u,\"sequence\":%u,\"sentAt\":%lld}", &message_id, &sequence, &sent_at) == 3);
+    CHECK(message_id == 0);
+
+    atomic_fetch_add(&guest->pings, 1);
+    pthread_mutex_lock(&guest->mutex);
+    if (!atomic_load(&guest->paused) && guest->tail - guest->head < GUEST_QUEUE) {
+        guest->sequences[guest->tail % GUEST_QUEUE] = sequence;
+        guest->sent_at[guest->tail % GUEST_QUEUE] = sent_at;
+        guest->tail++;
+        pthread_cond_signal(&guest->wake);
+    }
+    pthread_mutex_unlock(&guest->mutex);
+    return true;
+}
+
+static void *guest_main(void *context) {
+    fake_guest *guest = context;
+    pthread_mutex_lock(&guest->mutex);
+    while (!guest->stopping) {
+        if (guest->head == guest->tail) {
+            pthread_cond_wait(&guest->wake, &guest->mutex);
+            continue;
+        }
+        unsigned sequence = guest->sequences[guest->head % GUEST_QUEUE];
+        long long sent_at = guest->sent_at[guest->head % GUEST_QUEUE];
+        guest->head++;
+        pthread_mutex_unlock(&guest->mutex);
+
+        sleep_ms(guest->delay_ms);
+        char json[192];
+        snprintf(json, sizeof(json),
+            "{\"timestamp\":1,\"trackedWindowCount\":2,\"uptimeMs\":10,\"cpuUsagePercent\":1.5,"
+            "\"memoryUsageBytes\":4096,\"pingSequence\":%u,\"pingSentAt\":%lld}", sequence, sent_at);
+        uint8_t reply[256];
+        CHECK(winrun_heartbeat_receive(guest->heartbeat, reply, envelope(reply, 0x87, json)));
+
+        pthread_mutex_lock(&guest->mutex);
+    }
+    pthread_mutex_unlock(&guest->mutex);
+    return NULL;
+}
+
+static void guest_start(fake_guest *guest, long delay_ms) {
+    memset(guest, 0, sizeof(*guest));
+    pthread_mutex_init(&guest->mutex, NULL);
+    pthread_cond_init(&guest->wake, NULL);
+    guest->delay_ms = delay_ms;
+}
+
+static void guest_stop(fake_guest *guest) {
+    pthread_mutex_lock(&guest->mutex);
+    guest->stopping = true;
+    pthread_cond_signal(&guest->wake);
+    pthread_mutex_unlock(&guest->mutex);
+    pthread_join(guest->thread, NULL);
+    pthread_cond_destroy(&guest->wake);
+    pthread_mutex_destroy(&guest->mutex);
+}
+
+typedef struct {
+    _Atomic int healthy;
+    _Atomic int stalled;
+    _Atomic int last;
+    _Atomic uint64_t stalled_silence_ms;
+} health_log;
+
+static void on_health(winrun_guest_health health, const winrun_heartbeat_stats *stats, void *user_data) {
+    health_log *log = user_data;
+    CHECK(stats != NULL && stats->health == health);
+    if (health == WINRUN_GUEST_HEALTH_STALLED) {
+        atomic_store(&log->stalled_silence_ms, stats->silence_ms);
+        atomic_fetch_add(&log->stalled, 1);
+    } else if (health == WINRUN_GUEST_HEALTH_HEALTHY) {
+        atomic_fetch_add(&log->healthy, 1);
+    }
+    atomic_store(&log->last, (int)health);
+}
+
+static void wait_until(_Atomic int *counter, int value) {
+    for (int i = 0; i < 400 && atomic_load(counter) < value; ++i) {
+        sleep_ms(5);
+    }
+}
+
+// MARK: - Tests
+
+static void test_rtt_from_loopback(void) {
+    fake_guest guest;
+    guest_start(&guest, 3);
+    health_log log = { 0 };
+    guest.heartbeat = winrun_heartbeat_create(5, 500, guest_send, &guest, on_health, &log);
+    CHECK(guest.heartbeat != NULL);
+    CHECK(pthread_create(&guest.thread, NULL, guest_main, &guest) == 0);
+
+    sleep_ms(300);
+    winrun_heartbeat_stats stats;
+    winrun_heartbeat_get_stats(guest.heartbeat, &stats);
+    CHECK(stats.health == WINRUN_GUEST_HEALTH_HEALTHY);
+    CHECK(atomic_load(&log.healthy) == 1 && atomic_load(&log.stalled) == 0);
+    CHECK(stats.pings_sent >= 10 && stats.send_failures == 0);
+    CHECK(stats.replies >= 10 && stats.replies <= stats.pings_sent);
+    CHECK(stats.samples == (stats.replies < WINRUN_HEARTBEAT_WINDOW ? stats.replies : WINRUN_HEARTBEAT_WINDOW));
+    // Every reply was held back 3 ms by the guest
+    CHECK(stats.rtt_p50_us >= 3000 && stats.rtt_p50_us < 250000);
+    CHECK(stats.rtt_p50_us <= stats.rtt_p90_us && stats.rtt_p90_us <= stats.rtt_p99_us);
+    CHECK(stats.rtt_p99_us <= stats.rtt_max_us);
+    CHECK(stats.jitter_us <= stats.rtt_max_us);
+    CHECK(stats.silence_ms < 100);
+
+    winrun_heartbeat *heartbeat = guest.heartbeat;
+    guest_stop(&guest);
+    winrun_heartbeat_destroy(heartbeat);
+}
+
+static void test_stall_and_recovery(void) {
+    fake_guest guest;
+    guest_start(&guest, 0);
+    health_log log = { 0 };
+    guest.heartbeat = winrun_heartbeat_create(5, 60, guest_send, &guest, on_health, &log);
+    CHECK(pthread_create(&guest.thread, NULL, guest_main, &guest) == 0);
+    wait_until(&log.healthy, 1);
+    CHECK(atomic_load(&log.healthy) == 1);
+
+    // The guest stops answering: stalled once the deadline passes, and only once
+    atomic_store(&guest.paused, true);
+    wait_until(&log.stalled, 1);
+    CHECK(atomic_load(&log.stalled) == 1);
+    CHECK(atomic_load(&log.stalled_silence_ms) >= 60 && atomic_load(&log.stalled_silence_ms) < 500);
+    sleep_ms(100);
+    CHECK(atomic_load(&log.stalled) == 1 && atomic_load(&log.last) == WINRUN_GUEST_HEALTH_STALLED);
+
+    // Pinging carries on through the stall, and the next reply recovers
+    int pings = atomic_load(&guest.pings);
+    atomic_store(&guest.paused, false);
+    wait_until(&log.healthy, 2);
+    CHECK(atomic_load(&log.healthy) == 2 && atomic_load(&log.last) == WINRUN_GUEST_HEALTH_HEALTHY);
+    CHECK(atomic_load(&guest.pings) > pings);
+
+    winrun_heartbeat_stats stats;
+    winrun_heartbeat_get_stats(guest.heartbeat, &stats);
+    CHECK(stats.stalls == 1 && stats.health == WINRUN_GUEST_HEALTH_HEALTHY);
+
+    winrun_heartbeat *heartbeat = guest.heartbeat;
+    guest_stop(&guest);
+    winrun_heartbeat_destroy(heartbeat);
+}
+
+static void test_silent_guest_stalls(void) {
+    // An agent without Ping support never answers
+    fake_guest guest;
+    guest_start(&guest, 0);
+    atomic_store(&guest.paused, true);
+    health_log log = { 0 };
+    winrun_heartbeat *heartbeat = winrun_heartbeat_create(10, 50, guest_send, &guest, on_health, &log);
+    wait_until(&log.stalled, 1);
+    CHECK(atomic_load(&log.stalled) == 1 && atomic_load(&log.healthy) == 0);
+
+    winrun_heartbeat_stats stats;
+    winrun_heartbeat_get_stats(heartbeat, &stats);
+    CHECK(stats.replies == 0 && stats.samples == 0 && stats.rtt_max_us == 0);
+    winrun_heartbeat_destroy(heartbeat);
+    pthread_cond_destroy(&guest.wake);
+    pthread_mutex_destroy(&guest.mutex);
+}
+
+static _Atomic unsigned last_sequence;
+static _Atomic long long last_sent_at;
+
+static bool record_send(const uint8_t *data, size_t length, void *context) {
+    (void)context;
+    char json[128] = { 0 };
+    memcpy(json, data + 5, length - 5 < sizeof(json) - 1 ? length - 5 : sizeof(json) - 1);
+    unsigned sequence = 0;
+    long long sent_at = 0;
+    if (sscanf(json, "{\"messageId\":0,\"sequence\":%u,\"sentAt\":%lld}", &sequence, &sent_at) == 2) {
+        atomic_store(&last_sent_at, sent_at);
+        atomic_store(&last_sequence, sequence);
+    }
+    return true;
+}
+
+static void test_stale_and_foreign_replies(void) {
+    atomic_store(&last_sequence, 0);
+    winrun_heartbeat *heartbeat = winrun_heartbeat_create(1000, 5000, record_send, NULL, NULL, NULL);
+    for (int i = 0; i < 200 && atomic_load(&last_sequence) == 0; ++i) {
+        sleep_ms(1);
+    }
+    unsigned sequence = atomic_load(&last_sequence);
+    long long sent_at = atomic_load(&last_sent_at);
+    CHECK(sequence == 1);
+
+    uint8_t buffer[256];
+    char json[160];
+
+    // Not replies: other types, and periodic heartbeats without ping fields
+    CHECK(!winrun_heartbeat_receive(heartbeat, buffer, envelope(buffer, 0xFF, "{\"messageId\":0,\"success\":true}")));
+    CHECK(!winrun_heartbeat_receive(heartbeat, buffer, envelope(buffer, 0x87, "{\"timestamp\":1,\"uptimeMs\":5}")));
+    CHECK(!winrun_heartbeat_receive(heartbeat, buffer, envelope(buffer, 0x87, "{\"pingSequence\":null}")));
+
+    // A forged send time and a ping never sent are consumed but not sampled
+    snprintf(json, sizeof(json), "{\"pingSequence\":%u,\"pingSentAt\":%lld}", sequence, sent_at - 1000000);
+    CHECK(winrun_heartbeat_receive(heartbeat, buffer, envelope(buffer, 0x87, json)));
+    snprintf(json, sizeof(json), "{\"pingSequence\":%u,\"pingSentAt\":%lld}", sequence + 5, sent_at);
+    CHECK(winrun_heartbeat_receive(heartbeat, buffer, envelope(buffer, 0x87, json)));
+
+    // The real reply counts once; a duplicate is stale
+    snprintf(json, sizeof(json), "{\"pingSequence\":%u,\"pingSentAt\":%lld}", sequence, sent_at);
+    CHECK(winrun_heartbeat_receive(heartbeat, buffer, envelope(buffer, 0x87, json)));
+    CHECK(winrun_heartbeat_receive(heartbeat, buffer, envelope(buffer, 0x87, json)));
+
+    winrun_heartbeat_stats stats;
+    winrun_heartbeat_get_stats(heartbeat, &stats);
+    CHECK(stats.replies == 1 && stats.samples == 1 && stats.stale_replies == 3);
+    CHECK(stats.rtt_p50_us == stats.rtt_last_us && stats.rtt_max_us == stats.rtt_last_us);
+    CHECK(stats.jitter_us == 0);
+    CHECK(stats.health == WINRUN_GUEST_HEALTH_HEALTHY);
+    winrun_heartbeat_destroy(heartbeat);
+
+    CHECK(winrun_heartbeat_create(10, 10, NULL, NULL, NULL, NULL) == NULL);
+}
+
+static void test_stream_heartbeat(void) {
+    char error[256] = { 0 };
+    winrun_spice_stream_handle stream = winrun_spice_stream_open_tcp(
+        "127.0.0.1", 5900, false, 11, NULL, NULL, NULL, NULL, "ticket", error, sizeof(error));
+    CHECK(stream != NULL);
+    if (!stream) {
+        fprintf(stderr, "open failed: %s\n", error);
+        return;
+    }
+
+    winrun_heartbeat_stats stats;
+    CHECK(!winrun_spice_stream_get_heartbeat_stats(stream, &stats));
+
+    // The mock control port takes every ping and never answers
+    health_log first = { 0 };
+    health_log second = { 0 };
+    CHECK(winrun_spice_stream_start_heartbeat(stream, 5, 10000, on_health, &first));
+    CHECK(winrun_spice_stream_start_heartbeat(stream, 5, 40, on_health, &second));
+    wait_until(&second.stalled, 1);
+    CHECK(atomic_load(&second.stalled) == 1 && atomic_load(&first.stalled) == 0);
+
+    CHECK(winrun_spice_stream_get_heartbeat_stats(stream, &stats));
+    CHECK(stats.pings_sent > 0 && stats.replies == 0 && stats.health == WINRUN_GUEST_HEALTH_STALLED);
+
+    winrun_spice_stream_stop_heartbeat(stream);
+    CHECK(!winrun_spice_stream_get_heartbeat_stats(stream, &stats));
+
+    // Closing the stream stops a heartbeat that is still running
+    CHECK(winrun_spice_stream_start_heartbeat(stream, 5, 0, NULL, NULL));
+    winrun_spice_stream_close(stream);
+}
+
+int main(void) {
+    test_rtt_from_loopback();
+    test_stall_and_recovery();
+    test_silent_guest_stalls();
+    test_stale_and_foreign_replies();
+    test_stream_heartbeat();
+
+    return check_summary("heartbeat");
+}
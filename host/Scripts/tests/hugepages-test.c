@@ -0,0 +1,182 @@
+// Checks the huge-page fallback for pooled buffers and surface rings:
+// explicit huge pages, then transparent ones, then regular pages, with each
+// step reported in winrun_hugepage_status.
+//
+// mmap, memfd_create and madvise are interposed below, so the hugetlb pool
+// and transparent huge page support are whatever each check needs rather
+// than whatever the machine has. Like the kernel, an empty pool lets a
+// hugetlb memfd be created but fails to map it.
+//
+// Build and run with `make test-bridge`. Linux only.
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // MAP_HUGETLB, MFD_HUGETLB, MADV_HUGEPAGE
+#endif
+
+#include "CSpiceBridge.h"
+#include "winrun_surface.h"
+#include "check.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(MAP_HUGETLB) && defined(MADV_HUGEPAGE) && defined(SYS_memfd_create)
+
+#define HUGE_PAGE (2u * 1024u * 1024u)
+
+// Reserved huge pages left; 0 is an empty pool
+static int pool_pages = 0;
+// Whether madvise(MADV_HUGEPAGE) is accepted
+static int thp_available = 1;
+static int thp_advice_calls = 0;
+// The memfd created with MFD_HUGETLB, until mapping it fails
+static int hugetlb_fd = -1;
+static int hugetlb_memfds = 0;
+
+void *mmap(void *address, size_t length, int prot, int flags, int fd, off_t offset) {
+    bool hugetlb = (flags & MAP_HUGETLB) || (fd >= 0 && fd == hugetlb_fd);
+    if (hugetlb) {
+        if (pool_pages <= 0) {
+            // The caller closes the fd, and its number may be reused
+            hugetlb_fd = -1;
+            errno = ENOMEM;
+            return MAP_FAILED;
+        }
+        // Stand in for the pool with regular pages
+        pool_pages--;
+        flags &= ~MAP_HUGETLB;
+    }
+    return (void *)syscall(SYS_mmap, address, length, prot, flags, fd, offset);
+}
+
+int memfd_create(const char *name, unsigned int flags) {
+    int fd = (int)syscall(SYS_memfd_create, name, flags & ~(unsigned int)MFD_HUGETLB);
+    if (flags & MFD_HUGETLB) {
+        hugetlb_fd = fd;
+        hugetlb_memfds++;
+    }
+    return fd;
+}
+
+int madvise(void *address, size_t length, int advice) {
+    if (advice == MADV_HUGEPAGE) {
+        thp_advice_calls++;
+        if (!thp_available) {
+            // As on kernels built without transparent huge pages
+            errno = EINVAL;
+            return -1;
+        }
+        return 0;
+    }
+    return (int)syscall(SYS_madvise, address, length, advice);
+}
+
+static void reset(int pages, int thp) {
+    pool_pages = pages;
+    thp_available = thp;
+    thp_advice_calls = 0;
+    hugetlb_fd = -1;
+    hugetlb_memfds = 0;
+}
+
+// Allocates a buffer and checks what it reports, and that it is usable
+static void check_buffer(winrun_hugepage_mode mode, winrun_hugepage_status expected, size_t mapped_size) {
+    winrun_buffer buffer;
+    CHECK(winrun_buffer_alloc(3 * 1000 * 1000, mode, &buffer));
+    CHECK(buffer.hugepages == expected);
+    CHECK(buffer.size == 3 * 1000 * 1000);
+    CHECK(buffer.mapped_size == mapped_size);
+    if (buffer.data) {
+        buffer.data[0] = 1;
+        buffer.data[buffer.size - 1] = 2;
+        CHECK(buffer.data[buffer.size / 2] == 0);
+    }
+    winrun_buffer_free(&buffer);
+}
+
+static void test_buffer_fallback(void) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t regular = (3 * 1000 * 1000 + page - 1) / page * page;
+
+    // Explicit pages while the pool has them; no advice needed
+    reset(1, 1);
+    check_buffer(WINRUN_HUGEPAGES_EXPLICIT, WINRUN_HUGEPAGE_STATUS_EXPLICIT, 2 * HUGE_PAGE);
+    CHECK(thp_advice_calls == 0);
+
+    // Empty pool: transparent huge pages
+    reset(0, 1);
+    check_buffer(WINRUN_HUGEPAGES_EXPLICIT, WINRUN_HUGEPAGE_STATUS_TRANSPARENT, 2 * HUGE_PAGE);
+    CHECK(thp_advice_calls == 1);
+
+    // Empty pool and no THP: regular pages
+    reset(0, 0);
+    check_buffer(WINRUN_HUGEPAGES_EXPLICIT, WINRUN_HUGEPAGE_STATUS_NONE, 2 * HUGE_PAGE);
+    CHECK(thp_advice_calls == 1);
+
+    // Transparent mode never touches the pool
+    reset(1, 1);
+    check_buffer(WINRUN_HUGEPAGES_TRANSPARENT, WINRUN_HUGEPAGE_STATUS_TRANSPARENT, 2 * HUGE_PAGE);
+    CHECK(pool_pages == 1);
+
+    // Off: regular pages at the regular page size, without advice
+    reset(1, 1);
+    check_buffer(WINRUN_HUGEPAGES_OFF, WINRUN_HUGEPAGE_STATUS_NONE, regular);
+    CHECK(pool_pages == 1 && thp_advice_calls == 0);
+}
+
+// Builds a surface ring and checks what it and its frames report
+static void check_surface_ring(winrun_hugepage_mode mode, winrun_hugepage_status expected) {
+    winrun_surface_ring ring;
+    CHECK(winrun_surface_ring_init(&ring, 100 * 1000, 3, mode));
+    CHECK(ring.backing == WINRUN_SURFACE_BACKING_MEMFD);
+    CHECK(ring.hugepages == expected);
+    if (mode != WINRUN_HUGEPAGES_OFF) {
+        CHECK(ring.mapping_size % HUGE_PAGE == 0);
+    }
+
+    uint8_t frame[64] = { 0 };
+    winrun_frame_surface surface;
+    CHECK(winrun_surface_ring_write(&ring, 1, frame, sizeof(frame), &surface));
+    CHECK(surface.hugepages == expected);
+    winrun_surface_ring_destroy(&ring);
+}
+
+static void test_surface_fallback(void) {
+    // Explicit pages while the pool has them
+    reset(1, 1);
+    check_surface_ring(WINRUN_HUGEPAGES_EXPLICIT, WINRUN_HUGEPAGE_STATUS_EXPLICIT);
+    CHECK(thp_advice_calls == 0);
+
+    // Empty pool: the hugetlb memfd can't be mapped, so a regular one gets advice
+    reset(0, 1);
+    check_surface_ring(WINRUN_HUGEPAGES_EXPLICIT, WINRUN_HUGEPAGE_STATUS_TRANSPARENT);
+    CHECK(hugetlb_memfds == 1 && thp_advice_calls == 1);
+
+    // Empty pool and no THP: regular pages
+    reset(0, 0);
+    check_surface_ring(WINRUN_HUGEPAGES_EXPLICIT, WINRUN_HUGEPAGE_STATUS_NONE);
+
+    reset(1, 1);
+    check_surface_ring(WINRUN_HUGEPAGES_OFF, WINRUN_HUGEPAGE_STATUS_NONE);
+    CHECK(pool_pages == 1 && thp_advice_calls == 0);
+}
+
+int main(void) {
+    test_buffer_fallback();
+    test_surface_fallback();
+
+    return check_summary("huge page");
+}
+
+#else
+
+int main(void) {
+    printf("huge page tests skipped (needs Linux hugetlb and THP flags)\n");
+    return 0;
+}
+
+#endif
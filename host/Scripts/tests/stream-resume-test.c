@@ -0,0 +1,105 @@
+// Checks that winrun_spice_stream_resume() re-attaches a mock stream without
+// closing it: the handle and its settings survive, the worker comes back, and
+// the consumer never sees a close until the real one.
+//
+// Build and run with `make test-bridge`. Linux only: on macOS the bridge talks
+// to spice-gtk.
+
+#include "CSpiceBridge.h"
+#include "check.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+
+typedef struct {
+    _Atomic int metadata;
+    _Atomic int closes;
+    _Atomic int audio_starts;
+} event_log;
+
+static void on_metadata(const winrun_spice_window_metadata *metadata, void *user_data) {
+    (void)metadata;
+    atomic_fetch_add(&((event_log *)user_data)->metadata, 1);
+}
+
+static void on_closed(winrun_spice_close_reason reason, const char *message, void *user_data) {
+    (void)reason;
+    (void)message;
+    atomic_fetch_add(&((event_log *)user_data)->closes, 1);
+}
+
+static void on_audio_format(const winrun_audio_format *format, void *user_data) {
+    if (format) {
+        atomic_fetch_add(&((event_log *)user_data)->audio_starts, 1);
+    }
+}
+
+static void wait_until(_Atomic int *counter, int value) {
+    struct timespec delay = { .tv_sec = 0, .tv_nsec = 5 * 1000 * 1000 };
+    for (int i = 0; i < 200 && atomic_load(counter) < value; ++i) {
+        nanosleep(&delay, NULL);
+    }
+}
+
+static void test_resume_keeps_stream(void) {
+    event_log log = { 0 };
+    char error[256] = { 0 };
+    winrun_spice_stream_handle stream = winrun_spice_stream_open_tcp(
+        "127.0.0.1", 5900, false, 7, &log, NULL, on_metadata, on_closed, "ticket", error, sizeof(error));
+    CHECK(stream != NULL);
+    if (!stream) {
+        fprintf(stderr, "open failed: %s\n", error);
+        return;
+    }
+
+    winrun_spice_set_audio_callback(stream, on_audio_format, &log);
+    winrun_audio_config config = { .target_latency_ms = 60 };
+    CHECK(winrun_spice_audio_configure(stream, &config));
+    CHECK(winrun_spice_stream_set_visibility(stream, WINRUN_STREAM_VISIBILITY_BACKGROUND, 5));
+    wait_until(&log.metadata, 1);
+    wait_until(&log.audio_starts, 1);
+
+    for (int round = 0; round < 3; ++round) {
+        CHECK(winrun_spice_stream_resume(stream, -1, error, sizeof(error)));
+        // The new connection announces the window again
+        wait_until(&log.metadata, round + 2);
+        CHECK(atomic_load(&log.metadata) == round + 2);
+        CHECK(atomic_load(&log.closes) == 0);
+    }
+
+    // Playback restarts on the new connection with the configured latency
+    wait_until(&log.audio_starts, 4);
+    CHECK(atomic_load(&log.audio_starts) == 4);
+    winrun_audio_stats stats;
+    CHECK(winrun_spice_audio_get_stats(stream, &stats));
+    CHECK(stats.target_latency_ms == 60);
+
+    winrun_spice_stream_close(stream);
+    CHECK(atomic_load(&log.closes) == 1);
+}
+
+static void test_resume_shared_needs_descriptor(void) {
+    event_log log = { 0 };
+    char error[256] = { 0 };
+    winrun_spice_stream_handle stream = winrun_spice_stream_open_shared(
+        3, 8, &log, NULL, on_metadata, on_closed, NULL, error, sizeof(error));
+    CHECK(stream != NULL);
+    if (!stream) {
+        return;
+    }
+
+    CHECK(!winrun_spice_stream_resume(stream, -1, error, sizeof(error)));
+    CHECK(error[0] != '\0');
+    CHECK(winrun_spice_stream_resume(stream, 4, error, sizeof(error)));
+
+    winrun_spice_stream_close(stream);
+    CHECK(atomic_load(&log.closes) == 1);
+}
+
+int main(void) {
+    test_resume_keeps_stream();
+    test_resume_shared_needs_descriptor();
+
+    return check_summary("stream resume");
+}
@@ -0,0 +1,216 @@
+// Checks the surface ring: its memfd backing (sealed at its size) and the
+// POSIX shm fallback, the fd, offset and generation each frame reports, and
+// the reserve/commit path, where a producer writes a frame of unknown size in
+// place and readers see only the committed length.
+//
+// Build and run with `make test-bridge`. memfd_create is interposed below so
+// the shm fallback runs on kernels that have memfd.
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // memfd_create, F_GET_SEALS
+#endif
+
+#include "CSpiceBridge.h"
+#include "winrun_surface.h"
+#include "check.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(SYS_memfd_create)
+#define HAVE_MEMFD 1
+
+// Set to make memfd_create fail, as it does on kernels without it
+static int memfd_disabled = 0;
+
+int memfd_create(const char *name, unsigned int flags) {
+    if (memfd_disabled) {
+        errno = ENOSYS;
+        return -1;
+    }
+    return (int)syscall(SYS_memfd_create, name, flags);
+}
+#else
+#define HAVE_MEMFD 0
+#endif
+
+// Whether any shm object of this process is still linked under /dev/shm
+static int shm_names_left(void) {
+    char prefix[64];
+    snprintf(prefix, sizeof(prefix), "winrun-surface-%d-", (int)getpid());
+    DIR *dir = opendir("/dev/shm");
+    if (!dir) {
+        return 0;
+    }
+    int found = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        found |= strncmp(entry->d_name, prefix, strlen(prefix)) == 0;
+    }
+    closedir(dir);
+    return found;
+}
+
+static const winrun_surface_slot_header *slot_header(const winrun_surface_ring *ring, const winrun_frame_surface *surface) {
+    return (const winrun_surface_slot_header *)(ring->base + surface->offset - WINRUN_SURFACE_SLOT_HEADER_SIZE);
+}
+
+// Checks what every frame reports against a second mapping of the fd, the
+// way another process would see it
+static void check_frames_through_fd(winrun_surface_ring *ring) {
+    long page = sysconf(_SC_PAGESIZE);
+    CHECK(ring->fd >= 0);
+    CHECK(ring->slot_stride % (size_t)page == 0);
+    CHECK(ring->mapping_size == ring->slot_stride * ring->slot_count);
+    CHECK(ring->slot_capacity == ring->slot_stride - WINRUN_SURFACE_SLOT_HEADER_SIZE);
+
+    struct stat info;
+    CHECK(fstat(ring->fd, &info) == 0 && (size_t)info.st_size == ring->mapping_size);
+    CHECK(fcntl(ring->fd, F_GETFD) & FD_CLOEXEC);
+
+    uint8_t *remote = mmap(NULL, ring->mapping_size, PROT_READ, MAP_SHARED, ring->fd, 0);
+    CHECK(remote != MAP_FAILED);
+    if (remote == MAP_FAILED) {
+        return;
+    }
+
+    // One more frame than slots, so the first slot is written twice
+    for (uint32_t i = 0; i <= ring->slot_count; ++i) {
+        uint8_t frame[100];
+        memset(frame, (int)(0x20 + i), sizeof(frame));
+        winrun_frame_surface surface;
+        CHECK(winrun_surface_ring_write(ring, 5, frame, sizeof(frame), &surface));
+
+        size_t slot = i % ring->slot_count;
+        CHECK(surface.fd == ring->fd);
+        CHECK(surface.backing == ring->backing);
+        CHECK(surface.mapping_size == ring->mapping_size);
+        CHECK(surface.offset == slot * ring->slot_stride + WINRUN_SURFACE_SLOT_HEADER_SIZE);
+        CHECK(surface.length == sizeof(frame));
+        CHECK(surface.generation == i + 1);
+        CHECK(surface.window_id == 5);
+        CHECK(surface.data == ring->base + surface.offset);
+
+        const winrun_surface_slot_header *header =
+            (const winrun_surface_slot_header *)(remote + surface.offset - WINRUN_SURFACE_SLOT_HEADER_SIZE);
+        CHECK(__atomic_load_n(&header->generation, __ATOMIC_ACQUIRE) == surface.generation);
+        CHECK(header->window_id == 5);
+        CHECK(header->length == sizeof(frame));
+        CHECK(memcmp(remote + surface.offset, frame, sizeof(frame)) == 0);
+    }
+
+    munmap(remote, ring->mapping_size);
+}
+
+static void test_memfd_backing(void) {
+#if HAVE_MEMFD
+    winrun_surface_ring ring;
+    CHECK(winrun_surface_ring_init(&ring, 10000, 3, WINRUN_HUGEPAGES_OFF));
+    CHECK(ring.backing == WINRUN_SURFACE_BACKING_MEMFD);
+    CHECK(ring.hugepages == WINRUN_HUGEPAGE_STATUS_NONE);
+    check_frames_through_fd(&ring);
+
+#if defined(F_GET_SEALS)
+    // Sealed at its size, so a reader can trust the size it maps
+    int expected = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+    int seals = fcntl(ring.fd, F_GET_SEALS);
+    CHECK(seals >= 0 && (seals & expected) == expected);
+    CHECK(ftruncate(ring.fd, (off_t)ring.mapping_size * 2) != 0);
+    CHECK(ftruncate(ring.fd, 0) != 0);
+#endif
+
+    winrun_surface_ring_destroy(&ring);
+    CHECK(ring.fd == -1 && ring.base == NULL);
+#endif
+}
+
+static void test_posix_shm_fallback(void) {
+#if HAVE_MEMFD
+    memfd_disabled = 1;
+#endif
+    winrun_surface_ring ring;
+    CHECK(winrun_surface_ring_init(&ring, 10000, 2, WINRUN_HUGEPAGES_OFF));
+    CHECK(ring.backing == WINRUN_SURFACE_BACKING_POSIX_SHM);
+    check_frames_through_fd(&ring);
+
+    // Unlinked as soon as it was opened; only the fd keeps it alive
+    CHECK(!shm_names_left());
+    winrun_surface_ring_destroy(&ring);
+#if HAVE_MEMFD
+    memfd_disabled = 0;
+#endif
+}
+
+static void test_commit_smaller_than_reserved(void) {
+    winrun_surface_ring ring;
+    CHECK(winrun_surface_ring_init(&ring, 64 * 1024, 3, WINRUN_HUGEPAGES_OFF));
+    if (ring.fd < 0) {
+        return;
+    }
+
+    winrun_surface_reservation reservation;
+    CHECK(winrun_surface_ring_reserve(&ring, 9, 64 * 1024, &reservation));
+    CHECK(reservation.capacity >= 64 * 1024);
+
+    // The slot reads as being written until it is committed
+    const winrun_surface_slot_header *header =
+        (const winrun_surface_slot_header *)(reservation.data - WINRUN_SURFACE_SLOT_HEADER_SIZE);
+    CHECK(__atomic_load_n(&header->generation, __ATOMIC_ACQUIRE) == 0);
+
+    // e.g. a compressor that produced 1000 bytes
+    memset(reservation.data, 0xAB, 1000);
+    winrun_frame_surface surface;
+    CHECK(winrun_surface_ring_commit(&ring, &reservation, 1000, &surface));
+    CHECK(surface.length == 1000);
+    CHECK(surface.window_id == 9);
+    CHECK(surface.data == reservation.data);
+    CHECK(slot_header(&ring, &surface)->length == 1000);
+    CHECK(__atomic_load_n(&slot_header(&ring, &surface)->generation, __ATOMIC_ACQUIRE) == surface.generation);
+    CHECK(surface.data[999] == 0xAB);
+
+    // The next frame goes to the next slot with its own length
+    uint8_t frame[300];
+    memset(frame, 0x11, sizeof(frame));
+    winrun_frame_surface next;
+    CHECK(winrun_surface_ring_write(&ring, 9, frame, sizeof(frame), &next));
+    CHECK(next.offset != surface.offset);
+    CHECK(next.generation == surface.generation + 1);
+    CHECK(slot_header(&ring, &next)->length == sizeof(frame));
+
+    winrun_surface_ring_destroy(&ring);
+}
+
+static void test_reserve_rejects_oversized(void) {
+    winrun_surface_ring ring;
+    CHECK(winrun_surface_ring_init(&ring, 4096, 2, WINRUN_HUGEPAGES_OFF));
+    if (ring.fd < 0) {
+        return;
+    }
+
+    winrun_surface_reservation reservation;
+    CHECK(!winrun_surface_ring_reserve(&ring, 1, ring.slot_capacity + 1, &reservation));
+    CHECK(winrun_surface_ring_reserve(&ring, 1, 16, &reservation));
+
+    // Committing more than the slot holds abandons the reservation
+    winrun_frame_surface surface;
+    CHECK(!winrun_surface_ring_commit(&ring, &reservation, reservation.capacity + 1, &surface));
+    CHECK(winrun_surface_ring_commit(&ring, &reservation, reservation.capacity, &surface));
+
+    winrun_surface_ring_destroy(&ring);
+}
+
+int main(void) {
+    test_memfd_backing();
+    test_posix_shm_fallback();
+    test_commit_smaller_than_reserved();
+    test_reserve_rejects_oversized();
+
+    return check_summary("surface ring");
+}
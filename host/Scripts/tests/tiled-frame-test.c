@@ -0,0 +1,204 @@
+// Checks the tiled frame decoder: each tile codec, partial edge tiles, a
+// padded destination stride, and malformed payloads.
+//
+// Build and run with `make test-bridge`.
+
+#include "CSpiceBridge.h"
+#include "check.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define WIDTH 100
+#define HEIGHT 70
+#define STRIDE (104 * 4)
+
+typedef struct {
+    uint8_t bytes[64 * 1024];
+    size_t length;
+    size_t entry;
+} payload_builder;
+
+static void put_u8(payload_builder *b, uint8_t value) {
+    b->bytes[b->length++] = value;
+}
+
+static void put_u16(payload_builder *b, uint16_t value) {
+    put_u8(b, (uint8_t)value);
+    put_u8(b, (uint8_t)(value >> 8));
+}
+
+static void put_u32(payload_builder *b, uint32_t value) {
+    put_u16(b, (uint16_t)value);
+    put_u16(b, (uint16_t)(value >> 16));
+}
+
+static void begin(payload_builder *b, uint32_t tile_count) {
+    memset(b, 0, sizeof(*b));
+    put_u16(b, 64);
+    put_u16(b, 0);
+    put_u32(b, tile_count);
+    b->entry = b->length;
+    b->length += (size_t)tile_count * 8;
+}
+
+// Call after writing a tile's data, with where it started
+static void end_tile(payload_builder *b, winrun_tile_codec codec, size_t start) {
+    uint32_t length = (uint32_t)(b->length - start);
+    b->bytes[b->entry] = (uint8_t)codec;
+    for (int i = 0; i < 4; ++i) {
+        b->bytes[b->entry + 4 + i] = (uint8_t)(length >> (8 * i));
+    }
+    b->entry += 8;
+}
+
+static uint32_t pixel_at(const uint8_t *frame, uint32_t x, uint32_t y) {
+    uint32_t value;
+    memcpy(&value, frame + (size_t)y * STRIDE + (size_t)x * 4, 4);
+    return value;
+}
+
+// 100x70 is four tiles: 64x64 RLE, 36x64 palette, 64x6 LZ4, 36x6 raw
+static void build_frame(payload_builder *b) {
+    begin(b, 4);
+
+    // Two runs; the first ends partway through a row
+    size_t start = b->length;
+    put_u16(b, 100);
+    put_u32(b, 0xFF112233);
+    put_u16(b, 64 * 64 - 100);
+    put_u32(b, 0xFF445566);
+    end_tile(b, WINRUN_TILE_RLE, start);
+
+    // 16 colors, 4-bit indices: color x % 16
+    start = b->length;
+    put_u8(b, 15);
+    for (uint32_t i = 0; i < 16; ++i) {
+        put_u32(b, 0xFF000000 | i * 0x010101);
+    }
+    for (uint32_t y = 0; y < 64; ++y) {
+        for (uint32_t x = 0; x < 36; x += 2) {
+            put_u8(b, (uint8_t)((x % 16) | (((x + 1) % 16) << 4)));
+        }
+    }
+    end_tile(b, WINRUN_TILE_PALETTE, start);
+
+    // LZ4: one pixel, a 1528-byte overlapping match repeating it, then one
+    // last literal pixel
+    start = b->length;
+    put_u8(b, 0x4F);
+    put_u32(b, 0xFFABCDEF);
+    put_u16(b, 4);
+    for (int i = 0; i < 5; ++i) {
+        put_u8(b, 255);
+    }
+    put_u8(b, 1528 - 4 - 15 - 5 * 255);
+    put_u8(b, 0x40);
+    put_u32(b, 0xFF010203);
+    end_tile(b, WINRUN_TILE_LZ4, start);
+
+    start = b->length;
+    for (uint32_t i = 0; i < 36 * 6; ++i) {
+        put_u32(b, i);
+    }
+    end_tile(b, WINRUN_TILE_RAW, start);
+}
+
+static void test_decodes_each_codec(void) {
+    payload_builder b;
+    build_frame(&b);
+
+    static uint8_t frame[STRIDE * HEIGHT];
+    memset(frame, 0x5A, sizeof(frame));
+    winrun_tile_stats stats = { 0 };
+    CHECK(winrun_tiles_decode(b.bytes, b.length, WIDTH, HEIGHT, frame, STRIDE, &stats));
+
+    CHECK(stats.tiles[WINRUN_TILE_RAW] == 1);
+    CHECK(stats.tiles[WINRUN_TILE_LZ4] == 1);
+    CHECK(stats.tiles[WINRUN_TILE_RLE] == 1);
+    CHECK(stats.tiles[WINRUN_TILE_PALETTE] == 1);
+
+    // RLE: the first run covers row 0 and 36 pixels of row 1
+    CHECK(pixel_at(frame, 0, 0) == 0xFF112233);
+    CHECK(pixel_at(frame, 35, 1) == 0xFF112233);
+    CHECK(pixel_at(frame, 36, 1) == 0xFF445566);
+    CHECK(pixel_at(frame, 63, 63) == 0xFF445566);
+
+    // Palette
+    CHECK(pixel_at(frame, 64, 0) == 0xFF000000);
+    CHECK(pixel_at(frame, 64 + 5, 10) == 0xFF050505);
+    CHECK(pixel_at(frame, 64 + 31, 63) == 0xFF0F0F0F);
+    CHECK(pixel_at(frame, 99, 63) == (0xFF000000 | 35 % 16 * 0x010101));
+
+    // LZ4
+    CHECK(pixel_at(frame, 0, 64) == 0xFFABCDEF);
+    CHECK(pixel_at(frame, 63, 68) == 0xFFABCDEF);
+    CHECK(pixel_at(frame, 63, 69) == 0xFF010203);
+
+    // Raw
+    CHECK(pixel_at(frame, 64, 64) == 0);
+    CHECK(pixel_at(frame, 99, 69) == 36 * 6 - 1);
+
+    // Row padding is left alone
+    CHECK(frame[WIDTH * 4] == 0x5A);
+    CHECK(frame[STRIDE * HEIGHT - 1] == 0x5A);
+}
+
+static void test_small_palettes(void) {
+    // One 8x2 tile, two colors at 1 bit per index
+    payload_builder b;
+    begin(&b, 1);
+    size_t start = b.length;
+    put_u8(&b, 1);
+    put_u32(&b, 0xFF000000);
+    put_u32(&b, 0xFFFFFFFF);
+    put_u8(&b, 0x55);
+    put_u8(&b, 0xAA);
+    end_tile(&b, WINRUN_TILE_PALETTE, start);
+
+    uint32_t pixels[16];
+    CHECK(winrun_tiles_decode(b.bytes, b.length, 8, 2, (uint8_t *)pixels, 8 * 4, NULL));
+    CHECK(pixels[0] == 0xFFFFFFFF && pixels[1] == 0xFF000000 && pixels[7] == 0xFF000000);
+    CHECK(pixels[8] == 0xFF000000 && pixels[9] == 0xFFFFFFFF);
+}
+
+static void test_rejects_malformed_payloads(void) {
+    payload_builder b;
+    build_frame(&b);
+    static uint8_t frame[STRIDE * HEIGHT];
+
+    // Truncated
+    CHECK(!winrun_tiles_decode(b.bytes, b.length - 1, WIDTH, HEIGHT, frame, STRIDE, NULL));
+    CHECK(!winrun_tiles_decode(b.bytes, 4, WIDTH, HEIGHT, frame, STRIDE, NULL));
+
+    // Tile count doesn't match the frame, or the stride is too small
+    CHECK(!winrun_tiles_decode(b.bytes, b.length, WIDTH, 200, frame, STRIDE, NULL));
+    CHECK(!winrun_tiles_decode(b.bytes, b.length, WIDTH, HEIGHT, frame, WIDTH * 4 - 4, NULL));
+
+    // Unknown codec
+    payload_builder bad = b;
+    bad.bytes[8] = 9;
+    CHECK(!winrun_tiles_decode(bad.bytes, bad.length, WIDTH, HEIGHT, frame, STRIDE, NULL));
+
+    // RLE runs that overrun the tile
+    bad = b;
+    size_t rle = 8 + 4 * 8;
+    bad.bytes[rle + 6] = 0xFF;
+    bad.bytes[rle + 7] = 0xFF;
+    CHECK(!winrun_tiles_decode(bad.bytes, bad.length, WIDTH, HEIGHT, frame, STRIDE, NULL));
+
+    // LZ4 match reaching before the tile
+    bad = b;
+    size_t lz4 = rle + 12 + 1 + 16 * 4 + 64 * 18;
+    CHECK(bad.bytes[lz4] == 0x4F);
+    bad.bytes[lz4 + 5] = 8;
+    CHECK(!winrun_tiles_decode(bad.bytes, bad.length, WIDTH, HEIGHT, frame, STRIDE, NULL));
+}
+
+int main(void) {
+    test_decodes_each_codec();
+    test_small_palettes();
+    test_rejects_malformed_payloads();
+
+    return check_summary("tiled frame");
+}
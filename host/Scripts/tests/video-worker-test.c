@@ -0,0 +1,226 @@
+// Checks the video stream decode path without a Spice server: MJPEG frames
+// encoded here are queued on a mock stream through the
+// winrun_spice_video_stream_* entry points, and come back decoded as BGRA with their
+// destination rect. Corrupt frames count as drops, and ended streams give
+// their slots back once the worker has freed their decoders.
+//
+// Build and run with `make test-bridge`. Linux only: on macOS the bridge talks
+// to spice-gtk.
+
+#include "CSpiceBridge.h"
+#include "winrun_video.h"
+#include "check.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// After stdio.h, which it needs for FILE
+#include <jpeglib.h>
+
+#define WIDTH 32
+#define HEIGHT 16
+
+static void sleep_ms(long ms) {
+    struct timespec delay = { .tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000 * 1000 };
+    nanosleep(&delay, NULL);
+}
+
+// Encodes a WIDTH x HEIGHT frame of one RGB colour. Free the result with free().
+static uint8_t *encode_jpeg(uint8_t r, uint8_t g, uint8_t b, size_t *length) {
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr error;
+    cinfo.err = jpeg_std_error(&error);
+    jpeg_create_compress(&cinfo);
+
+    unsigned char *buffer = NULL;
+    unsigned long size = 0;
+    jpeg_mem_dest(&cinfo, &buffer, &size);
+    cinfo.image_width = WIDTH;
+    cinfo.image_height = HEIGHT;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, 95, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+
+    uint8_t row[WIDTH * 3];
+    for (int x = 0; x < WIDTH; ++x) {
+        row[x * 3] = r;
+        row[x * 3 + 1] = g;
+        row[x * 3 + 2] = b;
+    }
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW pointer = row;
+        jpeg_write_scanlines(&cinfo, &pointer, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    *length = size;
+    return buffer;
+}
+
+static int near(int value, int expected) {
+    return abs(value - expected) <= 8;
+}
+
+typedef struct {
+    pthread_mutex_t mutex;
+    int frames;
+    winrun_video_frame last;
+    // First pixel of the last frame, BGRA
+    uint8_t pixel[4];
+    int pixels_match;
+} video_log;
+
+static void on_video(const winrun_video_frame *frame, void *user_data) {
+    video_log *log = user_data;
+    pthread_mutex_lock(&log->mutex);
+    log->frames++;
+    log->last = *frame;
+    log->last.pixels = NULL;
+    memcpy(log->pixel, frame->pixels, 4);
+    // Solid colour: every pixel should match the first
+    log->pixels_match = 1;
+    for (uint32_t y = 0; y < frame->height; ++y) {
+        const uint8_t *row = frame->pixels + (size_t)y * frame->stride;
+        for (uint32_t x = 0; x < frame->width; ++x) {
+            for (int c = 0; c < 4; ++c) {
+                if (!near(row[x * 4 + c], log->pixel[c])) {
+                    log->pixels_match = 0;
+                }
+            }
+        }
+    }
+    pthread_mutex_unlock(&log->mutex);
+}
+
+static int frames_seen(video_log *log) {
+    pthread_mutex_lock(&log->mutex);
+    int frames = log->frames;
+    pthread_mutex_unlock(&log->mutex);
+    return frames;
+}
+
+static int wait_for_frames(video_log *log, int count) {
+    for (int i = 0; i < 200 && frames_seen(log) < count; ++i) {
+        sleep_ms(10);
+    }
+    return frames_seen(log) >= count;
+}
+
+static void test_decodes_mjpeg_frames(void) {
+    video_log log = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+    char error[256] = { 0 };
+    winrun_spice_stream_handle stream = winrun_spice_stream_open_tcp(
+        "127.0.0.1", 5900, false, 42, NULL, NULL, NULL, NULL, NULL, error, sizeof(error));
+    CHECK(stream != NULL);
+    if (!stream) {
+        return;
+    }
+    winrun_spice_set_video_callback(stream, on_video, &log);
+
+    winrun_video_rect dest = { .x = 10, .y = 20, .width = 64, .height = 32 };
+    CHECK(winrun_spice_video_stream_create(stream, 1, WINRUN_VIDEO_CODEC_MJPEG, &dest));
+    // Ids are unique per session
+    CHECK(!winrun_spice_video_stream_create(stream, 1, WINRUN_VIDEO_CODEC_MJPEG, &dest));
+
+    size_t length = 0;
+    uint8_t *red = encode_jpeg(255, 0, 0, &length);
+    CHECK(winrun_spice_video_stream_data(stream, 1, 1000, red, length));
+    CHECK(wait_for_frames(&log, 1));
+
+    pthread_mutex_lock(&log.mutex);
+    CHECK(log.last.window_id == 42);
+    CHECK(log.last.stream_id == 1);
+    CHECK(log.last.dest.x == 10 && log.last.dest.y == 20);
+    CHECK(log.last.dest.width == 64 && log.last.dest.height == 32);
+    CHECK(log.last.width == WIDTH && log.last.height == HEIGHT);
+    CHECK(log.last.stride == WIDTH * 4);
+    CHECK(log.last.mm_time == 1000);
+    CHECK(log.last.dropped_frames == 0);
+    CHECK(log.pixels_match);
+    CHECK(near(log.pixel[0], 0) && near(log.pixel[1], 0) && near(log.pixel[2], 255) && log.pixel[3] == 255);
+    pthread_mutex_unlock(&log.mutex);
+
+    // A corrupt frame is dropped; the next good one still decodes
+    uint8_t garbage[64];
+    memset(garbage, 0xAB, sizeof(garbage));
+    CHECK(winrun_spice_video_stream_data(stream, 1, 1010, garbage, sizeof(garbage)));
+    uint8_t *blue = encode_jpeg(0, 0, 255, &length);
+    CHECK(winrun_spice_video_stream_data(stream, 1, 1020, blue, length));
+    CHECK(wait_for_frames(&log, 2));
+
+    pthread_mutex_lock(&log.mutex);
+    CHECK(log.last.mm_time == 1020);
+    CHECK(log.last.dropped_frames == 1);
+    CHECK(near(log.pixel[0], 255) && near(log.pixel[1], 0) && near(log.pixel[2], 0));
+    pthread_mutex_unlock(&log.mutex);
+
+    // Nothing reaches an ended stream
+    winrun_spice_video_stream_destroy(stream, 1);
+    CHECK(!winrun_spice_video_stream_data(stream, 1, 1030, blue, length));
+
+    free(red);
+    free(blue);
+    winrun_spice_stream_close(stream);
+}
+
+// Creates `stream_id`, retrying while every slot still waits for the worker
+static int create_eventually(winrun_video_worker *worker, uint32_t stream_id) {
+    winrun_video_rect dest = { 0, 0, WIDTH, HEIGHT };
+    for (int i = 0; i < 200; ++i) {
+        if (winrun_video_worker_create_stream(worker, stream_id, WINRUN_VIDEO_CODEC_MJPEG, &dest)) {
+            return 1;
+        }
+        sleep_ms(5);
+    }
+    return 0;
+}
+
+static void test_ended_streams_free_their_slots(void) {
+    video_log log = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+    winrun_video_worker worker;
+    winrun_video_worker_init(&worker, 7);
+    winrun_video_worker_set_callback(&worker, on_video, &log);
+
+    size_t length = 0;
+    uint8_t *green = encode_jpeg(0, 255, 0, &length);
+
+    // Every stream decodes a frame, so each ended one has a decoder to free
+    // before its slot can be reused
+    int decoded = 0;
+    for (uint32_t id = 1; id <= WINRUN_VIDEO_MAX_STREAMS * 4; ++id) {
+        CHECK(create_eventually(&worker, id));
+        CHECK(winrun_video_worker_queue(&worker, id, 0, green, length));
+        CHECK(wait_for_frames(&log, ++decoded));
+        winrun_video_worker_destroy_stream(&worker, id);
+    }
+
+    // Ending them all at once, as a session reset does, frees every slot
+    for (uint32_t id = 1; id <= WINRUN_VIDEO_MAX_STREAMS; ++id) {
+        CHECK(create_eventually(&worker, id));
+    }
+    winrun_video_worker_destroy_streams(&worker);
+    for (uint32_t id = 1; id <= WINRUN_VIDEO_MAX_STREAMS; ++id) {
+        CHECK(create_eventually(&worker, id));
+    }
+
+    winrun_video_worker_destroy(&worker);
+    free(green);
+}
+
+int main(void) {
+    if (!winrun_video_codec_supported(WINRUN_VIDEO_CODEC_MJPEG)) {
+        printf("video worker tests skipped (built without libjpeg-turbo)\n");
+        return 0;
+    }
+
+    test_decodes_mjpeg_frames();
+    test_ended_streams_free_their_slots();
+
+    return check_summary("video worker");
+}
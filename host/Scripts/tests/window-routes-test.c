@@ -0,0 +1,244 @@
+// Checks per-window routing of control notifications: frameReady and
+// windowMetadata go to the window's route, everything else (and anything
+// that doesn't parse) goes to the control callback, and routes can be added
+// and removed while another thread is dispatching.
+//
+// Build and run with `make test-bridge`.
+
+#include "winrun_routes.h"
+#include "check.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    uint8_t bytes[4096];
+    size_t length;
+} chunk;
+
+static void append(chunk *c, uint8_t type, const char *json) {
+    size_t length = strlen(json);
+    c->bytes[c->length++] = type;
+    for (int i = 0; i < 4; ++i) {
+        c->bytes[c->length++] = (uint8_t)(length >> (8 * i));
+    }
+    memcpy(c->bytes + c->length, json, length);
+    c->length += length;
+}
+
+typedef struct {
+    int frames;
+    int metadata;
+    winrun_frame_ready last;
+    char reason[32];
+    uint64_t metadata_window;
+} route_log;
+
+typedef struct {
+    int calls;
+    size_t bytes;
+    uint8_t first_type;
+} fallback_log;
+
+static void on_frame(const winrun_frame_ready *frame, void *user_data) {
+    route_log *log = user_data;
+    log->frames++;
+    log->last = *frame;
+    memset(log->reason, 0, sizeof(log->reason));
+    if (frame->rate_reason) {
+        memcpy(log->reason, frame->rate_reason, frame->rate_reason_length);
+    }
+}
+
+static void on_metadata(uint64_t window_id, const uint8_t *payload, size_t length, void *user_data) {
+    (void)payload;
+    (void)length;
+    route_log *log = user_data;
+    log->metadata++;
+    log->metadata_window = window_id;
+}
+
+static void on_control(const uint8_t *data, size_t length, void *user_data) {
+    fallback_log *log = user_data;
+    if (log->calls++ == 0) {
+        log->first_type = data[0];
+    }
+    log->bytes += length;
+}
+
+#define FRAME_READY(window, slot, number) \
+    "{\"timestamp\":1700000000000,\"windowId\":" #window ",\"slotIndex\":" #slot \
+    ",\"frameNumber\":" #number ",\"isKeyFrame\":false,\"targetFps\":30,\"rateReason\":\"focused\"}"
+
+static void test_routes_by_window(void) {
+    winrun_route_table table;
+    winrun_route_table_init(&table);
+    route_log first = { 0 };
+    route_log second = { 0 };
+    CHECK(winrun_route_table_add(&table, 100, on_frame, on_metadata, &first));
+    CHECK(winrun_route_table_add(&table, 200, on_frame, NULL, &second));
+    CHECK(!winrun_route_table_add(&table, 0, on_frame, NULL, NULL));
+    CHECK(winrun_route_table_count(&table) == 2);
+
+    chunk c = { 0 };
+    append(&c, 0x8E, FRAME_READY(100, 2, 41));
+    append(&c, 0x8E, FRAME_READY(200, 0, 7));
+    append(&c, 0x8E, FRAME_READY(300, 1, 1));
+    append(&c, 0x80, "{\"windowId\":100,\"title\":\"\\\"windowId\\\":200\",\"bounds\":{\"x\":0,\"windowId\":5}}");
+    append(&c, 0x80, "{\"windowId\":200,\"title\":\"Notepad\"}");
+    append(&c, 0x81, "{\"windowId\":100}");
+
+    fallback_log control = { 0 };
+    CHECK(winrun_route_table_dispatch(&table, c.bytes, c.length, on_control, &control) == 3);
+
+    CHECK(first.frames == 1 && second.frames == 1);
+    CHECK(first.last.window_id == 100 && first.last.slot_index == 2 && first.last.frame_number == 41);
+    CHECK(!first.last.is_key_frame && first.last.target_fps == 30);
+    CHECK(first.last.timestamp == 1700000000000);
+    CHECK(strcmp(first.reason, "focused") == 0);
+    CHECK(second.last.window_id == 200 && second.last.frame_number == 7);
+
+    // Nested and quoted windowIds don't confuse the scanner
+    CHECK(first.metadata == 1 && first.metadata_window == 100);
+
+    // Window 300 has no route, window 200 has no metadata handler, and 0x81
+    // is never routed
+    CHECK(control.calls == 3 && control.first_type == 0x8E);
+
+    CHECK(winrun_route_table_remove(&table, 100));
+    CHECK(!winrun_route_table_remove(&table, 100));
+    CHECK(winrun_route_table_count(&table) == 1);
+    winrun_route_table_destroy(&table);
+}
+
+static void test_optional_fields_and_bad_payloads(void) {
+    winrun_route_table table;
+    winrun_route_table_init(&table);
+    route_log log = { 0 };
+    CHECK(winrun_route_table_add(&table, 9, on_frame, NULL, &log));
+
+    chunk c = { 0 };
+    append(&c, 0x8E, "{ \"timestamp\": -5, \"windowId\": 9, \"slotIndex\": 1,\n \"frameNumber\": 4, "
+                     "\"isKeyFrame\": true, \"targetFps\": null }");
+    fallback_log control = { 0 };
+    CHECK(winrun_route_table_dispatch(&table, c.bytes, c.length, on_control, &control) == 1);
+    CHECK(log.frames == 1 && log.last.is_key_frame && log.last.target_fps == 0);
+    CHECK(log.last.rate_reason == NULL && log.last.timestamp == -5);
+
+    // Missing, fractional, oversized and escaped fields all fall back
+    static const char *const bad[] = {
+        "{\"timestamp\":0,\"windowId\":9,\"slotIndex\":1,\"isKeyFrame\":true}",
+        "{\"timestamp\":0,\"windowId\":9,\"slotIndex\":1.5,\"frameNumber\":1,\"isKeyFrame\":true}",
+        "{\"timestamp\":0,\"windowId\":9,\"slotIndex\":4294967296,\"frameNumber\":1,\"isKeyFrame\":true}",
+        "{\"timestamp\":0,\"windowId\":9,\"slotIndex\":1,\"frameNumber\":1,\"isKeyFrame\":true,\"rateReason\":\"a\\nb\"}",
+        "{\"timestamp\":0,\"windowId\":9,\"slotIndex\":1,\"frameNumber\":1,\"isKeyFrame\":true",
+        "not json",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        chunk b = { 0 };
+        append(&b, 0x8E, bad[i]);
+        fallback_log rejected = { 0 };
+        CHECK(winrun_route_table_dispatch(&table, b.bytes, b.length, on_control, &rejected) == 0);
+        CHECK(rejected.calls == 1 && rejected.bytes == b.length);
+    }
+    CHECK(log.frames == 1);
+
+    // A message split across reads goes through untouched, in one piece
+    chunk split = { 0 };
+    append(&split, 0x8E, FRAME_READY(9, 0, 5));
+    append(&split, 0x8E, FRAME_READY(9, 1, 6));
+    fallback_log partial = { 0 };
+    CHECK(winrun_route_table_dispatch(&table, split.bytes, split.length - 3, on_control, &partial) == 0);
+    CHECK(partial.calls == 1 && partial.bytes == split.length - 3);
+    CHECK(log.frames == 1);
+
+    winrun_route_table_destroy(&table);
+}
+
+static void test_replaces_and_regrows(void) {
+    winrun_route_table table;
+    winrun_route_table_init(&table);
+    route_log old_route = { 0 };
+    route_log new_route = { 0 };
+    CHECK(winrun_route_table_add(&table, 5, on_frame, NULL, &old_route));
+    CHECK(winrun_route_table_add(&table, 5, on_frame, NULL, &new_route));
+    CHECK(winrun_route_table_count(&table) == 1);
+
+    // Windows come and go far more often than the map's capacity; tombstones
+    // must not fill it up
+    for (uint64_t window = 1000; window < 5000; ++window) {
+        CHECK(winrun_route_table_add(&table, window, on_frame, NULL, &old_route));
+        if (window % 4 != 0) {
+            CHECK(winrun_route_table_remove(&table, window));
+        }
+    }
+    CHECK(winrun_route_table_count(&table) == 1 + 1000);
+
+    chunk c = { 0 };
+    append(&c, 0x8E, FRAME_READY(5, 0, 1));
+    append(&c, 0x8E, FRAME_READY(4996, 0, 1));
+    append(&c, 0x8E, FRAME_READY(4997, 0, 1));
+    fallback_log control = { 0 };
+    CHECK(winrun_route_table_dispatch(&table, c.bytes, c.length, on_control, &control) == 2);
+    CHECK(new_route.frames == 1 && old_route.frames == 1 && control.calls == 1);
+
+    winrun_route_table_destroy(&table);
+}
+
+typedef struct {
+    winrun_route_table *table;
+    _Atomic int running;
+    _Atomic int dispatches;
+} dispatcher;
+
+static void *dispatch_loop(void *context) {
+    dispatcher *d = context;
+    chunk c = { 0 };
+    append(&c, 0x8E, FRAME_READY(1, 0, 1));
+    append(&c, 0x8E, FRAME_READY(2, 0, 1));
+    while (atomic_load(&d->running)) {
+        fallback_log control = { 0 };
+        winrun_route_table_dispatch(d->table, c.bytes, c.length, on_control, &control);
+        atomic_fetch_add(&d->dispatches, 1);
+    }
+    return NULL;
+}
+
+static void test_concurrent_dispatch(void) {
+    winrun_route_table table;
+    winrun_route_table_init(&table);
+    route_log log = { 0 };
+    CHECK(winrun_route_table_add(&table, 1, on_frame, NULL, &log));
+
+    dispatcher d = { .table = &table, .running = 1 };
+    pthread_t thread;
+    CHECK(pthread_create(&thread, NULL, dispatch_loop, &d) == 0);
+    while (atomic_load(&d.dispatches) == 0) {
+        sched_yield();
+    }
+
+    // Churn window 2 and force rebuilds while frames are being routed
+    for (uint64_t round = 0; round < 2000; ++round) {
+        CHECK(winrun_route_table_add(&table, 2, on_frame, NULL, &log));
+        CHECK(winrun_route_table_add(&table, 10000 + round, NULL, NULL, NULL));
+        CHECK(winrun_route_table_remove(&table, 2));
+        CHECK(winrun_route_table_remove(&table, 10000 + round));
+    }
+
+    atomic_store(&d.running, 0);
+    pthread_join(thread, NULL);
+    CHECK(log.frames >= atomic_load(&d.dispatches));
+    CHECK(winrun_route_table_count(&table) == 1);
+    winrun_route_table_destroy(&table);
+}
+
+int main(void) {
+    test_routes_by_window();
+    test_optional_fields_and_bad_payloads();
+    test_replaces_and_regrows();
+    test_concurrent_dispatch();
+
+    return check_summary("window route");
+}
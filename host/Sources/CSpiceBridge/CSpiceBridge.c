@@ -1,7 +1,17 @@
 #include "CSpiceBridge.h"
+#include "winrun_audio.h"
+#include "winrun_cursor.h"
+#include "winrun_envelope.h"
+#include "winrun_executor.h"
+#include "winrun_heartbeat.h"
+#include "winrun_probes.h"
+#include "winrun_routes.h"
+#include "winrun_surface.h"
+#include "winrun_video.h"
 
 #include <pthread.h>
 #include <errno.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdatomic.h>
 #include <stdlib.h>
@@ -9,6 +19,14 @@
 #include <time.h>
 #include <unistd.h>
 
+// Connect display channels' stream-create/-data/-destroy signals to the
+// video decoder. Upstream spice-gtk has no such signals (it decodes streams
+// itself), so this is only for a spice-gtk that forwards stream messages;
+// otherwise the decoder is fed through winrun_spice_video_stream_* alone.
+#ifndef WINRUN_SPICE_STREAM_SIGNALS
+#define WINRUN_SPICE_STREAM_SIGNALS 0
+#endif
+
 #if __APPLE__
 #include "shim.h"
 
@@ -30,11 +48,22 @@
 #endif
 #endif
 
+// One executor slot per winrun_callback_kind bit
+#define WINRUN_CALLBACK_KIND_COUNT 4
+
 typedef struct winrun_spice_stream {
     pthread_t worker_thread;
     _Atomic bool worker_running;
     bool worker_started;  // Tracks whether worker_thread was actually created
+    // Set while resume tears down the old connection, so its exit isn't reported as a close
+    _Atomic bool resuming;
     uint64_t window_id;
+    // Connection parameters, kept so the session can be re-established by resume
+    char *host;
+    uint16_t port;
+    bool use_tls;
+    char *ticket;
+    int shared_fd;
     void *user_data;
     winrun_spice_frame_cb frame_cb;
     winrun_spice_metadata_cb metadata_cb;
@@ -44,16 +73,57 @@ typedef struct winrun_spice_stream {
     // Control channel callback
     winrun_control_message_cb control_cb;
     void *control_user_data;
+    // Completes responses before they reach control_cb; guarded by send_mutex
+    winrun_request_tracker_handle request_tracker;
     pthread_mutex_t send_mutex;
+    // Guest heartbeat, started and stopped under heartbeat_mutex. The control
+    // reader uses it lock-free; heartbeat_users counts readers inside it so
+    // a stopped monitor is only freed once they've left.
+    pthread_mutex_t heartbeat_mutex;
+    _Atomic(winrun_heartbeat *) heartbeat;
+    _Atomic int heartbeat_users;
     // Tracks current button state for mouse motion events
     int button_state;
     // Clipboard sequence number for deduplication
     uint64_t clipboard_sequence;
+    // Monotonic open time, used for the stream-close probe
+    uint64_t opened_at_ns;
+    // Visibility throttling, written by set_visibility and read by the frame path
+    _Atomic int visibility;
+    _Atomic uint32_t max_fps;
+    uint64_t last_frame_ns;
+    // Optional fd-backed frame surfaces, guarded by surface_mutex
+    pthread_mutex_t surface_mutex;
+    winrun_surface_ring surfaces;
+    winrun_spice_surface_cb surface_cb;
+    void *surface_user_data;
+    _Atomic int surface_hugepages;
+    // Cursor events and converted shapes, guarded by cursor_mutex
+    pthread_mutex_t cursor_mutex;
+    winrun_cursor_cb cursor_cb;
+    void *cursor_user_data;
+    winrun_cursor_cache cursor_cache;
+    // Decode worker for video streams
+    winrun_video_worker video;
+    // Playback state, guarded by audio_mutex. The buffer itself is read
+    // lock-free by the pull path; audio_users counts callers inside it so
+    // a stopped buffer is only freed once they've left.
+    pthread_mutex_t audio_mutex;
+    winrun_audio_config audio_config;
+    winrun_audio_format_cb audio_format_cb;
+    void *audio_user_data;
+    _Atomic(winrun_audio_buffer *) audio;
+    _Atomic int audio_users;
+    // Where frame, metadata, clipboard and control callbacks run (NULL:
+    // inline), one per winrun_callback_kind bit, guarded by executor_mutex
+    pthread_mutex_t executor_mutex;
+    winrun_executor_handle executors[WINRUN_CALLBACK_KIND_COUNT];
 #if __APPLE__
     SpiceSession *session;
     SpiceInputsChannel *inputs_channel;
     SpiceMainChannel *main_channel;
     SpicePortChannel *control_channel;  // For bidirectional control messages
+    SpiceCursorChannel *cursor_channel;
     gulong channel_new_handler_id;
     // Clipboard signal handlers on main channel
     gulong clipboard_grab_handler_id;
@@ -62,10 +132,37 @@ typedef struct winrun_spice_stream {
     gulong clipboard_release_handler_id;
     // Control channel signal handler
     gulong control_data_handler_id;
+    // Main channel connection events, reported through closed_cb
+    gulong main_event_handler_id;
+    // Cursor channel signal handlers
+    gulong cursor_set_handler_id;
+    gulong cursor_move_handler_id;
+    gulong cursor_hide_handler_id;
+    gulong cursor_reset_handler_id;
+    // Playback channel signal handlers
+    SpicePlaybackChannel *playback_channel;
+    gulong playback_start_handler_id;
+    gulong playback_data_handler_id;
+    gulong playback_stop_handler_id;
+    gulong playback_delay_handler_id;
+#if WINRUN_SPICE_STREAM_SIGNALS
+    // Display channel stream signals, guarded by send_mutex
+    SpiceDisplayChannel *display_channel;
+    gulong video_create_handler_id;
+    gulong video_data_handler_id;
+    gulong video_destroy_handler_id;
+#endif
 #endif
 } winrun_spice_stream;
 
+// Per-window routes for control notifications, shared by every stream
+static winrun_route_table winrun_window_routes = WINRUN_ROUTE_TABLE_INIT;
+
 static void *winrun_mock_worker(void *context);
+static void winrun_audio_start(winrun_spice_stream *stream, uint32_t sample_rate, uint32_t channels);
+static void winrun_audio_stop(winrun_spice_stream *stream);
+static winrun_audio_buffer *winrun_audio_acquire(winrun_spice_stream *stream);
+static void winrun_audio_release(winrun_spice_stream *stream);
 
 #if __APPLE__
 // Forward declarations for clipboard signal handlers (needed before on_channel_new)
@@ -80,6 +177,16 @@ static void on_clipboard_release(SpiceMainChannel *channel, guint selection,
                                  gpointer user_data);
 static void on_control_port_data(SpicePortChannel *channel, gpointer data,
                                  gint size, gpointer user_data);
+static void on_main_channel_event(SpiceChannel *channel, SpiceChannelEvent event, gpointer user_data);
+static void winrun_connect_cursor_channel(winrun_spice_stream *stream, SpiceCursorChannel *channel);
+static void winrun_disconnect_cursor_channel(winrun_spice_stream *stream);
+static void winrun_connect_playback_channel(winrun_spice_stream *stream, SpicePlaybackChannel *channel);
+static void winrun_disconnect_playback_channel(winrun_spice_stream *stream);
+#if WINRUN_SPICE_STREAM_SIGNALS
+static void winrun_connect_display_channel(winrun_spice_stream *stream, SpiceDisplayChannel *channel);
+static void winrun_disconnect_display_channel(winrun_spice_stream *stream);
+#endif
+static void winrun_emit_control(const uint8_t *data, size_t length, void *context);
 
 // Port name for control channel - must match what guest listens on
 #define WINRUN_CONTROL_PORT_NAME "com.winrun.control"
@@ -118,12 +225,23 @@ static void on_channel_new(SpiceSession *session, SpiceChannel *channel, gpointe
             if (stream->clipboard_release_handler_id) {
                 g_signal_handler_disconnect(stream->main_channel, stream->clipboard_release_handler_id);
             }
+            if (stream->main_event_handler_id) {
+                g_signal_handler_disconnect(stream->main_channel, stream->main_event_handler_id);
+            }
             g_object_unref(stream->main_channel);
         }
 
         stream->main_channel = SPICE_MAIN_CHANNEL(channel);
         g_object_ref(stream->main_channel);
 
+        // The main channel carries the session; its failure means the connection dropped
+        stream->main_event_handler_id = g_signal_connect(
+            stream->main_channel,
+            "channel-event",
+            G_CALLBACK(on_main_channel_event),
+            stream
+        );
+
         // Connect clipboard signal handlers
         stream->clipboard_grab_handler_id = g_signal_connect(
             stream->main_channel,
@@ -182,6 +300,47 @@ static void on_channel_new(SpiceSession *session, SpiceChannel *channel, gpointe
         }
 
         g_free(port_name);
+    } else if (SPICE_IS_CURSOR_CHANNEL(channel)) {
+        pthread_mutex_lock(&stream->cursor_mutex);
+        winrun_connect_cursor_channel(stream, SPICE_CURSOR_CHANNEL(channel));
+        pthread_mutex_unlock(&stream->cursor_mutex);
+    } else if (SPICE_IS_PLAYBACK_CHANNEL(channel)) {
+        pthread_mutex_lock(&stream->audio_mutex);
+        winrun_connect_playback_channel(stream, SPICE_PLAYBACK_CHANNEL(channel));
+        pthread_mutex_unlock(&stream->audio_mutex);
+#if WINRUN_SPICE_STREAM_SIGNALS
+    } else if (SPICE_IS_DISPLAY_CHANNEL(channel)) {
+        pthread_mutex_lock(&stream->send_mutex);
+        winrun_connect_display_channel(stream, SPICE_DISPLAY_CHANNEL(channel));
+        pthread_mutex_unlock(&stream->send_mutex);
+#endif
+    }
+}
+
+// Reports a dropped or refused connection. Resume re-attaches to a new session
+// while keeping the stream, so the consumer should try that before reopening.
+static void on_main_channel_event(SpiceChannel *channel, SpiceChannelEvent event, gpointer user_data) {
+    (void)channel;
+    winrun_spice_stream *stream = (winrun_spice_stream *)user_data;
+    if (!stream || !stream->closed_cb) {
+        return;
+    }
+
+    switch (event) {
+        case SPICE_CHANNEL_ERROR_AUTH:
+            stream->closed_cb(WINRUN_SPICE_CLOSE_REASON_AUTHENTICATION, "Spice authentication failed", stream->user_data);
+            break;
+        case SPICE_CHANNEL_ERROR_CONNECT:
+        case SPICE_CHANNEL_ERROR_TLS:
+        case SPICE_CHANNEL_ERROR_LINK:
+        case SPICE_CHANNEL_ERROR_IO:
+            stream->closed_cb(WINRUN_SPICE_CLOSE_REASON_TRANSPORT, "Spice connection lost", stream->user_data);
+            break;
+        case SPICE_CHANNEL_CLOSED:
+            stream->closed_cb(WINRUN_SPICE_CLOSE_REASON_REMOTE, "Spice session closed", stream->user_data);
+            break;
+        default:
+            break;
     }
 }
 
@@ -195,13 +354,17 @@ static void on_control_port_data(SpicePortChannel *channel, gpointer data,
     }
 
     pthread_mutex_lock(&stream->send_mutex);
-    winrun_control_message_cb cb = stream->control_cb;
-    void *cb_user_data = stream->control_user_data;
+    bool has_control_cb = stream->control_cb != NULL;
     pthread_mutex_unlock(&stream->send_mutex);
 
-    if (cb) {
-        cb((const uint8_t *)data, (size_t)size, cb_user_data);
+    // Only the stream acting as the control channel consumes control data.
+    // Routed windows get their notifications here; the rest go to control_cb.
+    if (!has_control_cb) {
+        return;
     }
+    uint64_t start_ns = WINRUN_PROBE_START(control__recv);
+    winrun_route_table_dispatch(&winrun_window_routes, (const uint8_t *)data, (size_t)size, winrun_emit_control, stream);
+    WINRUN_PROBE3(control__recv, stream->window_id, size, winrun_probe_since_ns(start_ns));
 }
 
 // Convert our mouse button enum to Spice button number
@@ -253,6 +416,170 @@ static winrun_clipboard_format spice_to_winrun_format(guint spice_type) {
 }
 #endif
 
+static uint64_t winrun_monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Decide whether a frame should be delivered given the stream's visibility.
+// Only called from the frame delivery thread, which owns last_frame_ns.
+static bool winrun_should_deliver_frame(winrun_spice_stream *stream) {
+    int visibility = atomic_load(&stream->visibility);
+    if (visibility == WINRUN_STREAM_VISIBILITY_HIDDEN) {
+        return false;
+    }
+
+    uint32_t max_fps = atomic_load(&stream->max_fps);
+    if (max_fps == 0 && visibility == WINRUN_STREAM_VISIBILITY_BACKGROUND) {
+        max_fps = WINRUN_STREAM_BACKGROUND_DEFAULT_FPS;
+    }
+    if (max_fps == 0) {
+        return true;
+    }
+
+    uint64_t now_ns = winrun_monotonic_ns();
+    uint64_t interval_ns = 1000000000ull / max_fps;
+    if (stream->last_frame_ns != 0 && now_ns - stream->last_frame_ns < interval_ns) {
+        return false;
+    }
+    stream->last_frame_ns = now_ns;
+    return true;
+}
+
+// MARK: - Callback Dispatch
+
+// The emit helpers run a stream callback inline, or queue it on the
+// executor chosen for its kind. executor_mutex is held while posting so the
+// executor can't be swapped out and cancelled between the two.
+static winrun_executor_handle winrun_lock_executor(winrun_spice_stream *stream, winrun_callback_kind kind) {
+    pthread_mutex_lock(&stream->executor_mutex);
+    return stream->executors[__builtin_ctz((unsigned)kind)];
+}
+
+static void winrun_emit_frame(winrun_spice_stream *stream, const uint8_t *data, size_t length) {
+    winrun_executor_handle executor = winrun_lock_executor(stream, WINRUN_CALLBACK_FRAME);
+    if (executor) {
+        winrun_executor_post_frame(executor, stream, stream->frame_cb, data, length, stream->user_data);
+    }
+    pthread_mutex_unlock(&stream->executor_mutex);
+    if (!executor) {
+        stream->frame_cb(data, length, stream->user_data);
+    }
+}
+
+static void winrun_emit_metadata(winrun_spice_stream *stream, const winrun_spice_window_metadata *metadata) {
+    winrun_executor_handle executor = winrun_lock_executor(stream, WINRUN_CALLBACK_METADATA);
+    if (executor) {
+        winrun_executor_post_metadata(executor, stream, stream->metadata_cb, metadata, stream->user_data);
+    }
+    pthread_mutex_unlock(&stream->executor_mutex);
+    if (!executor) {
+        stream->metadata_cb(metadata, stream->user_data);
+    }
+}
+
+#if __APPLE__
+static void winrun_emit_clipboard(
+    winrun_spice_stream *stream,
+    winrun_clipboard_cb cb,
+    const winrun_clipboard_data *clipboard,
+    void *user_data
+) {
+    winrun_executor_handle executor = winrun_lock_executor(stream, WINRUN_CALLBACK_CLIPBOARD);
+    if (executor) {
+        winrun_executor_post_clipboard(executor, stream, cb, clipboard, user_data);
+    }
+    pthread_mutex_unlock(&stream->executor_mutex);
+    if (!executor) {
+        cb(clipboard, user_data);
+    }
+}
+
+static void winrun_emit_control_message(const uint8_t *data, size_t length, void *context) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)context;
+    pthread_mutex_lock(&stream->send_mutex);
+    winrun_control_message_cb cb = stream->control_cb;
+    void *cb_user_data = stream->control_user_data;
+    pthread_mutex_unlock(&stream->send_mutex);
+    if (!cb) {
+        return;
+    }
+
+    winrun_executor_handle executor = winrun_lock_executor(stream, WINRUN_CALLBACK_CONTROL);
+    if (executor) {
+        winrun_executor_post_control(executor, stream, cb, data, length, cb_user_data);
+    }
+    pthread_mutex_unlock(&stream->executor_mutex);
+    if (!executor) {
+        cb(data, length, cb_user_data);
+    }
+}
+
+// Responses to tracked requests complete here and go no further
+static void winrun_emit_control_response(const uint8_t *data, size_t length, winrun_spice_stream *stream) {
+    pthread_mutex_lock(&stream->send_mutex);
+    winrun_request_tracker_handle tracker = stream->request_tracker;
+    pthread_mutex_unlock(&stream->send_mutex);
+    if (tracker) {
+        winrun_request_tracker_match(tracker, data, length, winrun_emit_control_message, stream);
+    } else {
+        winrun_emit_control_message(data, length, stream);
+    }
+}
+
+// Fallback for control data that no window route took; `context` is the
+// stream. Replies to heartbeat pings are taken out first, so the rest goes
+// on in runs of the envelopes between them.
+static void winrun_emit_control(const uint8_t *data, size_t length, void *context) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)context;
+    if (!atomic_load(&stream->heartbeat) || !winrun_envelopes_are_whole(data, length)) {
+        winrun_emit_control_response(data, length, stream);
+        return;
+    }
+
+    size_t run_start = 0;
+    for (size_t offset = 0; offset < length;) {
+        size_t envelope_length = WINRUN_ENVELOPE_HEADER_SIZE + winrun_envelope_length(data + offset);
+        atomic_fetch_add(&stream->heartbeat_users, 1);
+        bool reply = winrun_heartbeat_receive(atomic_load(&stream->heartbeat), data + offset, envelope_length);
+        atomic_fetch_sub(&stream->heartbeat_users, 1);
+        if (reply) {
+            if (offset > run_start) {
+                winrun_emit_control_response(data + run_start, offset - run_start, stream);
+            }
+            run_start = offset + envelope_length;
+        }
+        offset += envelope_length;
+    }
+    if (length > run_start) {
+        winrun_emit_control_response(data + run_start, length - run_start, stream);
+    }
+}
+#endif
+
+// Hands a frame to the consumer. With shared surfaces enabled the frame is
+// copied once into the fd-backed ring and frame_cb reads it from there.
+static void winrun_deliver_frame(winrun_spice_stream *stream, const uint8_t *data, size_t length) {
+    uint64_t start_ns = WINRUN_PROBE_START(frame__deliver);
+
+    // Held across the callbacks so the mapping can't be torn down under them
+    pthread_mutex_lock(&stream->surface_mutex);
+    if (stream->surface_cb) {
+        winrun_frame_surface surface;
+        if (winrun_surface_ring_write(&stream->surfaces, stream->window_id, data, length, &surface)) {
+            stream->surface_cb(&surface, stream->surface_user_data);
+            data = surface.data;
+        }
+    }
+    if (stream->frame_cb) {
+        winrun_emit_frame(stream, data, length);
+    }
+    pthread_mutex_unlock(&stream->surface_mutex);
+
+    WINRUN_PROBE3(frame__deliver, stream->window_id, length, winrun_probe_since_ns(start_ns));
+}
+
 static void winrun_write_error(char *buffer, size_t length, const char *message) {
     if (!buffer || length == 0 || !message) {
         return;
@@ -278,6 +605,12 @@ static winrun_spice_stream *winrun_spice_stream_create(
     }
 
     stream->window_id = window_id;
+    stream->host = NULL;
+    stream->port = 0;
+    stream->use_tls = false;
+    stream->ticket = NULL;
+    stream->shared_fd = -1;
+    atomic_store(&stream->resuming, false);
     stream->user_data = user_data;
     stream->frame_cb = frame_cb;
     stream->metadata_cb = metadata_cb;
@@ -286,10 +619,34 @@ static winrun_spice_stream *winrun_spice_stream_create(
     stream->clipboard_user_data = NULL;
     stream->control_cb = NULL;
     stream->control_user_data = NULL;
+    stream->request_tracker = NULL;
+    pthread_mutex_init(&stream->heartbeat_mutex, NULL);
+    atomic_store(&stream->heartbeat, NULL);
+    atomic_store(&stream->heartbeat_users, 0);
     stream->button_state = 0;
     stream->clipboard_sequence = 0;
+    stream->opened_at_ns = winrun_probe_now_ns();
+    atomic_store(&stream->visibility, WINRUN_STREAM_VISIBILITY_VISIBLE);
+    atomic_store(&stream->max_fps, 0);
+    stream->last_frame_ns = 0;
+    pthread_mutex_init(&stream->surface_mutex, NULL);
+    stream->surfaces.fd = -1;
+    stream->surface_cb = NULL;
+    stream->surface_user_data = NULL;
+    atomic_store(&stream->surface_hugepages, WINRUN_HUGEPAGES_OFF);
+    pthread_mutex_init(&stream->cursor_mutex, NULL);
+    stream->cursor_cb = NULL;
+    stream->cursor_user_data = NULL;
+    winrun_video_worker_init(&stream->video, window_id);
+    pthread_mutex_init(&stream->audio_mutex, NULL);
+    stream->audio_config = winrun_audio_config_resolve(NULL);
+    stream->audio_format_cb = NULL;
+    stream->audio_user_data = NULL;
+    atomic_store(&stream->audio, NULL);
+    atomic_store(&stream->audio_users, 0);
     stream->worker_started = false;
     pthread_mutex_init(&stream->send_mutex, NULL);
+    pthread_mutex_init(&stream->executor_mutex, NULL);
     atomic_store(&stream->worker_running, true);
 #if __APPLE__
     stream->session = NULL;
@@ -302,36 +659,68 @@ static winrun_spice_stream *winrun_spice_stream_create(
     stream->clipboard_request_handler_id = 0;
     stream->clipboard_release_handler_id = 0;
     stream->control_data_handler_id = 0;
+    stream->main_event_handler_id = 0;
+    stream->cursor_channel = NULL;
+    stream->cursor_set_handler_id = 0;
+    stream->cursor_move_handler_id = 0;
+    stream->cursor_hide_handler_id = 0;
+    stream->cursor_reset_handler_id = 0;
+    stream->playback_channel = NULL;
+    stream->playback_start_handler_id = 0;
+    stream->playback_data_handler_id = 0;
+    stream->playback_stop_handler_id = 0;
+    stream->playback_delay_handler_id = 0;
+#if WINRUN_SPICE_STREAM_SIGNALS
+    stream->display_channel = NULL;
+    stream->video_create_handler_id = 0;
+    stream->video_data_handler_id = 0;
+    stream->video_destroy_handler_id = 0;
+#endif
 #endif
     return stream;
 }
 
-static void winrun_spice_stream_free(winrun_spice_stream *stream) {
-    if (!stream) {
-        return;
-    }
+#if __APPLE__
+// Drops the session and every channel attached to it. Callbacks, caches and
+// surfaces live on the stream and are untouched, so a new session can be
+// attached in their place.
+static void winrun_detach_session(winrun_spice_stream *stream) {
+    pthread_mutex_lock(&stream->cursor_mutex);
+    winrun_disconnect_cursor_channel(stream);
+    pthread_mutex_unlock(&stream->cursor_mutex);
+
+    pthread_mutex_lock(&stream->audio_mutex);
+    winrun_disconnect_playback_channel(stream);
+    pthread_mutex_unlock(&stream->audio_mutex);
 
-    pthread_mutex_destroy(&stream->send_mutex);
+    pthread_mutex_lock(&stream->send_mutex);
+
+    // Stream ids belong to the session; a new one starts over
+#if WINRUN_SPICE_STREAM_SIGNALS
+    winrun_disconnect_display_channel(stream);
+#endif
+    winrun_video_worker_destroy_streams(&stream->video);
 
-#if __APPLE__
     // Disconnect signal handler before releasing session
     if (stream->session && stream->channel_new_handler_id != 0) {
         g_signal_handler_disconnect(stream->session, stream->channel_new_handler_id);
     }
+    stream->channel_new_handler_id = 0;
 
-    // Disconnect clipboard handlers from main channel
+    // Disconnect clipboard and event handlers from main channel
     if (stream->main_channel) {
-        if (stream->clipboard_grab_handler_id) {
-            g_signal_handler_disconnect(stream->main_channel, stream->clipboard_grab_handler_id);
-        }
-        if (stream->clipboard_data_handler_id) {
-            g_signal_handler_disconnect(stream->main_channel, stream->clipboard_data_handler_id);
-        }
-        if (stream->clipboard_request_handler_id) {
-            g_signal_handler_disconnect(stream->main_channel, stream->clipboard_request_handler_id);
-        }
-        if (stream->clipboard_release_handler_id) {
-            g_signal_handler_disconnect(stream->main_channel, stream->clipboard_release_handler_id);
+        gulong *handler_ids[] = {
+            &stream->clipboard_grab_handler_id,
+            &stream->clipboard_data_handler_id,
+            &stream->clipboard_request_handler_id,
+            &stream->clipboard_release_handler_id,
+            &stream->main_event_handler_id
+        };
+        for (size_t i = 0; i < sizeof(handler_ids) / sizeof(handler_ids[0]); ++i) {
+            if (*handler_ids[i]) {
+                g_signal_handler_disconnect(stream->main_channel, *handler_ids[i]);
+                *handler_ids[i] = 0;
+            }
         }
     }
 
@@ -339,23 +728,60 @@ static void winrun_spice_stream_free(winrun_spice_stream *stream) {
     if (stream->control_channel) {
         if (stream->control_data_handler_id) {
             g_signal_handler_disconnect(stream->control_channel, stream->control_data_handler_id);
+            stream->control_data_handler_id = 0;
         }
         g_object_unref(stream->control_channel);
+        stream->control_channel = NULL;
     }
 
     if (stream->inputs_channel) {
         g_object_unref(stream->inputs_channel);
+        stream->inputs_channel = NULL;
     }
 
     if (stream->main_channel) {
         g_object_unref(stream->main_channel);
+        stream->main_channel = NULL;
     }
 
     if (stream->session) {
+        spice_session_disconnect(stream->session);
         g_object_unref(stream->session);
+        stream->session = NULL;
+    }
+
+    pthread_mutex_unlock(&stream->send_mutex);
+}
+#endif
+
+static void winrun_spice_stream_free(winrun_spice_stream *stream) {
+    if (!stream) {
+        return;
     }
+
+    // Its thread sends through the session
+    winrun_spice_stream_stop_heartbeat(stream);
+    pthread_mutex_destroy(&stream->heartbeat_mutex);
+
+#if __APPLE__
+    winrun_detach_session(stream);
 #endif
 
+    pthread_mutex_destroy(&stream->send_mutex);
+    // Nothing posts any more; take back what is still queued
+    winrun_spice_stream_set_executor(stream, WINRUN_CALLBACK_ALL, NULL);
+    pthread_mutex_destroy(&stream->executor_mutex);
+    winrun_video_worker_destroy(&stream->video);
+    winrun_surface_ring_destroy(&stream->surfaces);
+    pthread_mutex_destroy(&stream->surface_mutex);
+
+    winrun_cursor_cache_clear(&stream->cursor_cache);
+    pthread_mutex_destroy(&stream->cursor_mutex);
+    stream->audio_format_cb = NULL;
+    winrun_audio_stop(stream);
+    pthread_mutex_destroy(&stream->audio_mutex);
+    free(stream->host);
+    free(stream->ticket);
     free(stream);
 }
 
@@ -368,216 +794,885 @@ static bool winrun_spice_stream_start_worker(
         return false;
     }
 
-    if (pthread_create(&stream->worker_thread, NULL, winrun_mock_worker, stream) != 0) {
-        winrun_write_error(error_buffer, error_buffer_length, "Failed to spawn Spice worker thread");
-        atomic_store(&stream->worker_running, false);
-        return false;
-    }
+    if (pthread_create(&stream->worker_thread, NULL, winrun_mock_worker, stream) != 0) {
+        winrun_write_error(error_buffer, error_buffer_length, "Failed to spawn Spice worker thread");
+        atomic_store(&stream->worker_running, false);
+        return false;
+    }
+
+    stream->worker_started = true;
+    return true;
+}
+
+// Synthetic playback for the mock worker: 48 kHz stereo triangle wave at
+// 500 Hz. Consecutive samples always differ by exactly one step, so a reader
+// can spot dropped or reordered frames.
+#define WINRUN_MOCK_AUDIO_RATE 48000
+#define WINRUN_MOCK_AUDIO_CHANNELS 2
+#define WINRUN_MOCK_AUDIO_PERIOD 96
+#define WINRUN_MOCK_AUDIO_STEP 512
+
+static void winrun_mock_audio_generate(winrun_spice_stream *stream, uint64_t *frames_generated, uint64_t started_ns) {
+    uint64_t due = (winrun_monotonic_ns() - started_ns) * WINRUN_MOCK_AUDIO_RATE / 1000000000ull;
+    int16_t chunk[480 * WINRUN_MOCK_AUDIO_CHANNELS];
+
+    while (*frames_generated < due) {
+        size_t frames = (size_t)(due - *frames_generated);
+        if (frames > 480) {
+            frames = 480;
+        }
+        for (size_t i = 0; i < frames; ++i) {
+            int phase = (int)((*frames_generated + i) % WINRUN_MOCK_AUDIO_PERIOD);
+            int half = WINRUN_MOCK_AUDIO_PERIOD / 2;
+            int value = phase < half
+                ? (phase - half / 2) * WINRUN_MOCK_AUDIO_STEP
+                : (half + half / 2 - phase) * WINRUN_MOCK_AUDIO_STEP;
+            for (size_t c = 0; c < WINRUN_MOCK_AUDIO_CHANNELS; ++c) {
+                chunk[i * WINRUN_MOCK_AUDIO_CHANNELS + c] = (int16_t)value;
+            }
+        }
+        winrun_audio_buffer *audio = winrun_audio_acquire(stream);
+        if (audio) {
+            winrun_audio_buffer_write(audio, chunk, frames);
+        }
+        winrun_audio_release(stream);
+        *frames_generated += frames;
+    }
+}
+
+// Bytes in each mock frame, delivered or throttled
+#define WINRUN_MOCK_FRAME_SIZE 1024
+
+static void *winrun_mock_worker(void *context) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)context;
+    if (!stream) {
+        return NULL;
+    }
+
+    if (stream->metadata_cb) {
+        winrun_spice_window_metadata metadata = {
+            .window_id = stream->window_id,
+            .position_x = 100.0,
+            .position_y = 100.0,
+            .width = 800.0,
+            .height = 600.0,
+            .scale_factor = 1.0,
+            .is_resizable = true,
+            .title = "Spice Window"
+        };
+        winrun_emit_metadata(stream, &metadata);
+    }
+
+    struct timespec frame_delay = {
+        .tv_sec = 0,
+        .tv_nsec = 33 * 1000 * 1000
+    };
+
+    winrun_audio_start(stream, WINRUN_MOCK_AUDIO_RATE, WINRUN_MOCK_AUDIO_CHANNELS);
+    uint64_t audio_started_ns = winrun_monotonic_ns();
+    uint64_t audio_frames = 0;
+
+    while (atomic_load(&stream->worker_running)) {
+        winrun_mock_audio_generate(stream, &audio_frames, audio_started_ns);
+        if (stream->frame_cb && !winrun_should_deliver_frame(stream)) {
+            WINRUN_PROBE3(frame__throttle, stream->window_id, atomic_load(&stream->visibility), WINRUN_MOCK_FRAME_SIZE);
+        } else if (stream->frame_cb) {
+            uint8_t buffer[WINRUN_MOCK_FRAME_SIZE];
+            for (size_t i = 0; i < sizeof(buffer); ++i) {
+                buffer[i] = (uint8_t)(rand() % 255);
+            }
+            winrun_deliver_frame(stream, buffer, sizeof(buffer));
+        }
+        nanosleep(&frame_delay, NULL);
+    }
+
+    winrun_audio_stop(stream);
+
+    if (stream->closed_cb && !atomic_load(&stream->resuming)) {
+        stream->closed_cb(WINRUN_SPICE_CLOSE_REASON_REMOTE, "Stream closed", stream->user_data);
+    }
+
+    return NULL;
+}
+
+// Starts a connection with the stream's saved parameters: a new Spice session
+// on macOS, the mock worker elsewhere
+static bool winrun_attach_session(
+    winrun_spice_stream *stream,
+    char *error_buffer,
+    size_t error_buffer_length
+) {
+#if __APPLE__
+    stream->session = spice_session_new();
+    if (!stream->session) {
+        winrun_write_error(error_buffer, error_buffer_length, "Unable to create Spice session");
+        return false;
+    }
+
+    // Connect channel-new handler to capture inputs channel
+    stream->channel_new_handler_id = g_signal_connect(
+        stream->session,
+        "channel-new",
+        G_CALLBACK(on_channel_new),
+        stream
+    );
+
+    if (stream->ticket) {
+        g_object_set(stream->session, "password", stream->ticket, NULL);
+    }
+
+    if (stream->shared_fd >= 0) {
+        // Use spice_session_open_fd for pre-connected shared memory descriptor
+        // This is used with Virtualization.framework's shared memory transport
+        if (!spice_session_open_fd(stream->session, stream->shared_fd)) {
+            winrun_write_error(error_buffer, error_buffer_length, "Failed to open Spice session with shared-memory descriptor");
+            return false;
+        }
+    } else {
+        char port_string[16];
+        snprintf(port_string, sizeof(port_string), "%u", stream->port);
+        g_object_set(stream->session,
+                     "host", stream->host,
+                     stream->use_tls ? "tls-port" : "port", port_string,
+                     NULL);
+        spice_session_connect(stream->session);
+    }
+    // On macOS with libspice, real frame delivery comes from the session callbacks,
+    // not from the mock worker thread. Don't start the mock worker.
+    return true;
+#else
+    // Only start mock worker on non-macOS platforms (e.g., CI/test environments)
+    atomic_store(&stream->worker_running, true);
+    return winrun_spice_stream_start_worker(stream, error_buffer, error_buffer_length);
+#endif
+}
+
+winrun_spice_stream_handle winrun_spice_stream_open_tcp(
+    const char *host,
+    uint16_t port,
+    bool use_tls,
+    uint64_t window_id,
+    void *user_data,
+    winrun_spice_frame_cb frame_cb,
+    winrun_spice_metadata_cb metadata_cb,
+    winrun_spice_closed_cb closed_cb,
+    const char *ticket,
+    char *error_buffer,
+    size_t error_buffer_length
+) {
+    winrun_spice_stream *stream = winrun_spice_stream_create(
+        window_id,
+        user_data,
+        frame_cb,
+        metadata_cb,
+        closed_cb,
+        error_buffer,
+        error_buffer_length
+    );
+    if (!stream) {
+        return NULL;
+    }
+
+    stream->host = host ? strdup(host) : NULL;
+    stream->port = port;
+    stream->use_tls = use_tls;
+    stream->ticket = ticket ? strdup(ticket) : NULL;
+    if ((host && !stream->host) || (ticket && !stream->ticket)) {
+        winrun_write_error(error_buffer, error_buffer_length, "Allocation failure");
+        winrun_spice_stream_free(stream);
+        return NULL;
+    }
+
+    if (!winrun_attach_session(stream, error_buffer, error_buffer_length)) {
+        winrun_spice_stream_free(stream);
+        return NULL;
+    }
+
+    WINRUN_PROBE2(stream__open, window_id, WINRUN_PROBE_TRANSPORT_TCP);
+    return stream;
+}
+
+winrun_spice_stream_handle winrun_spice_stream_open_shared(
+    int shared_fd,
+    uint64_t window_id,
+    void *user_data,
+    winrun_spice_frame_cb frame_cb,
+    winrun_spice_metadata_cb metadata_cb,
+    winrun_spice_closed_cb closed_cb,
+    const char *ticket,
+    char *error_buffer,
+    size_t error_buffer_length
+) {
+    if (shared_fd < 0) {
+        winrun_write_error(error_buffer, error_buffer_length, "Invalid shared-memory descriptor");
+        return NULL;
+    }
+
+    winrun_spice_stream *stream = winrun_spice_stream_create(
+        window_id,
+        user_data,
+        frame_cb,
+        metadata_cb,
+        closed_cb,
+        error_buffer,
+        error_buffer_length
+    );
+    if (!stream) {
+        return NULL;
+    }
+
+    stream->shared_fd = shared_fd;
+    stream->ticket = ticket ? strdup(ticket) : NULL;
+    if (ticket && !stream->ticket) {
+        winrun_write_error(error_buffer, error_buffer_length, "Allocation failure");
+        winrun_spice_stream_free(stream);
+        return NULL;
+    }
+
+    if (!winrun_attach_session(stream, error_buffer, error_buffer_length)) {
+        winrun_spice_stream_free(stream);
+        return NULL;
+    }
+
+    WINRUN_PROBE2(stream__open, window_id, WINRUN_PROBE_TRANSPORT_SHARED);
+    return stream;
+}
+
+bool winrun_spice_stream_resume(
+    winrun_spice_stream_handle streamHandle,
+    int shared_fd,
+    char *error_buffer,
+    size_t error_buffer_length
+) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream) {
+        winrun_write_error(error_buffer, error_buffer_length, "Invalid stream handle");
+        return false;
+    }
+    if (stream->shared_fd >= 0) {
+        // The old descriptor went down with the connection
+        if (shared_fd < 0) {
+            winrun_write_error(error_buffer, error_buffer_length, "Invalid shared-memory descriptor");
+            return false;
+        }
+        stream->shared_fd = shared_fd;
+    }
+
+    uint64_t start_ns = WINRUN_PROBE_START(stream__resume);
+    atomic_store(&stream->resuming, true);
+#if __APPLE__
+    winrun_detach_session(stream);
+#else
+    atomic_store(&stream->worker_running, false);
+    if (stream->worker_started) {
+        pthread_join(stream->worker_thread, NULL);
+        stream->worker_started = false;
+    }
+#endif
+    // Guest audio restarts with the new playback channel; stale samples would only add delay
+    winrun_audio_stop(stream);
+    atomic_store(&stream->resuming, false);
+
+    if (!winrun_attach_session(stream, error_buffer, error_buffer_length)) {
+        return false;
+    }
+
+    WINRUN_PROBE2(stream__resume, stream->window_id, winrun_probe_since_ns(start_ns));
+    return true;
+}
+
+void winrun_spice_stream_close(winrun_spice_stream_handle streamHandle) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream) {
+        return;
+    }
+
+    atomic_store(&stream->worker_running, false);
+    WINRUN_PROBE2(stream__close, stream->window_id, winrun_probe_now_ns() - stream->opened_at_ns);
+
+    // Only join the worker thread if it was actually started
+    if (stream->worker_started) {
+        pthread_join(stream->worker_thread, NULL);
+    }
+
+    winrun_spice_stream_free(stream);
+}
+
+// MARK: - Visibility
+
+bool winrun_spice_stream_set_visibility(
+    winrun_spice_stream_handle streamHandle,
+    winrun_stream_visibility state,
+    uint32_t max_fps
+) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream) {
+        return false;
+    }
+
+    switch (state) {
+        case WINRUN_STREAM_VISIBILITY_VISIBLE:
+        case WINRUN_STREAM_VISIBILITY_BACKGROUND:
+        case WINRUN_STREAM_VISIBILITY_HIDDEN:
+            break;
+        default:
+            return false;
+    }
+
+    atomic_store(&stream->max_fps, max_fps);
+    atomic_store(&stream->visibility, (int)state);
+    WINRUN_PROBE3(stream__visibility, stream->window_id, state, max_fps);
+    return true;
+}
+
+// MARK: - Shared Surfaces
+
+bool winrun_spice_stream_enable_shared_surfaces(
+    winrun_spice_stream_handle streamHandle,
+    size_t max_frame_size,
+    uint32_t slot_count,
+    winrun_spice_surface_cb surface_cb,
+    void *user_data
+) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream || !surface_cb) {
+        return false;
+    }
+
+    // Allocate outside the lock so frame delivery isn't stalled by the mmap
+    winrun_surface_ring ring;
+    winrun_hugepage_mode hugepages = (winrun_hugepage_mode)atomic_load(&stream->surface_hugepages);
+    if (!winrun_surface_ring_init(&ring, max_frame_size, slot_count, hugepages)) {
+        return false;
+    }
+
+    pthread_mutex_lock(&stream->surface_mutex);
+    winrun_surface_ring previous = stream->surfaces;
+    stream->surfaces = ring;
+    stream->surface_cb = surface_cb;
+    stream->surface_user_data = user_data;
+    pthread_mutex_unlock(&stream->surface_mutex);
+
+    winrun_surface_ring_destroy(&previous);
+    return true;
+}
+
+void winrun_spice_stream_disable_shared_surfaces(winrun_spice_stream_handle streamHandle) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream) {
+        return;
+    }
+
+    pthread_mutex_lock(&stream->surface_mutex);
+    winrun_surface_ring previous = stream->surfaces;
+    memset(&stream->surfaces, 0, sizeof(stream->surfaces));
+    stream->surfaces.fd = -1;
+    stream->surface_cb = NULL;
+    stream->surface_user_data = NULL;
+    pthread_mutex_unlock(&stream->surface_mutex);
+
+    winrun_surface_ring_destroy(&previous);
+}
+
+bool winrun_spice_stream_set_surface_hugepages(
+    winrun_spice_stream_handle streamHandle,
+    winrun_hugepage_mode mode
+) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream) {
+        return false;
+    }
+
+    switch (mode) {
+        case WINRUN_HUGEPAGES_OFF:
+        case WINRUN_HUGEPAGES_TRANSPARENT:
+        case WINRUN_HUGEPAGES_EXPLICIT:
+            break;
+        default:
+            return false;
+    }
+
+    atomic_store(&stream->surface_hugepages, (int)mode);
+    return true;
+}
+
+// MARK: - Cursor
+
+#if __APPLE__
+// Calls the cursor callback. Must be called with cursor_mutex held, which also
+// keeps a SET event's cached pixels alive for the duration of the callback.
+static void winrun_emit_cursor_event(
+    winrun_spice_stream *stream,
+    winrun_cursor_event_type type,
+    int32_t x,
+    int32_t y,
+    const winrun_cursor_shape *shape
+) {
+    if (!stream->cursor_cb) {
+        return;
+    }
+    winrun_cursor_event event = {
+        .window_id = stream->window_id,
+        .type = type,
+        .x = x,
+        .y = y,
+        .shape = shape
+    };
+    stream->cursor_cb(&event, stream->cursor_user_data);
+}
+
+// Guest set a new pointer shape; `rgba` is straight-alpha RGBA
+static void on_cursor_set(SpiceCursorChannel *channel, gint width, gint height,
+                          gint hot_x, gint hot_y, gpointer rgba, gpointer user_data) {
+    (void)channel;
+    winrun_spice_stream *stream = (winrun_spice_stream *)user_data;
+    if (!stream || width <= 0 || height <= 0 || hot_x < 0 || hot_y < 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&stream->cursor_mutex);
+    if (stream->cursor_cb) {
+        const winrun_cursor_shape *shape = winrun_cursor_cache_lookup(
+            &stream->cursor_cache, (const uint8_t *)rgba,
+            (uint32_t)width, (uint32_t)height, (uint32_t)hot_x, (uint32_t)hot_y);
+        if (shape) {
+            winrun_emit_cursor_event(stream, WINRUN_CURSOR_EVENT_SET, 0, 0, shape);
+        }
+    }
+    pthread_mutex_unlock(&stream->cursor_mutex);
+}
+
+static void on_cursor_move(SpiceCursorChannel *channel, gint x, gint y, gpointer user_data) {
+    (void)channel;
+    winrun_spice_stream *stream = (winrun_spice_stream *)user_data;
+    if (!stream) {
+        return;
+    }
+
+    pthread_mutex_lock(&stream->cursor_mutex);
+    winrun_emit_cursor_event(stream, WINRUN_CURSOR_EVENT_MOVE, x, y, NULL);
+    pthread_mutex_unlock(&stream->cursor_mutex);
+}
+
+static void on_cursor_hide(SpiceCursorChannel *channel, gpointer user_data) {
+    (void)channel;
+    winrun_spice_stream *stream = (winrun_spice_stream *)user_data;
+    if (!stream) {
+        return;
+    }
+
+    pthread_mutex_lock(&stream->cursor_mutex);
+    winrun_emit_cursor_event(stream, WINRUN_CURSOR_EVENT_HIDE, 0, 0, NULL);
+    pthread_mutex_unlock(&stream->cursor_mutex);
+}
+
+static void on_cursor_reset(SpiceCursorChannel *channel, gpointer user_data) {
+    (void)channel;
+    winrun_spice_stream *stream = (winrun_spice_stream *)user_data;
+    if (!stream) {
+        return;
+    }
+
+    pthread_mutex_lock(&stream->cursor_mutex);
+    winrun_emit_cursor_event(stream, WINRUN_CURSOR_EVENT_RESET, 0, 0, NULL);
+    pthread_mutex_unlock(&stream->cursor_mutex);
+}
+
+// Must be called with cursor_mutex held (or during teardown)
+static void winrun_disconnect_cursor_channel(winrun_spice_stream *stream) {
+    if (!stream->cursor_channel) {
+        return;
+    }
+    gulong *handler_ids[] = {
+        &stream->cursor_set_handler_id,
+        &stream->cursor_move_handler_id,
+        &stream->cursor_hide_handler_id,
+        &stream->cursor_reset_handler_id
+    };
+    for (size_t i = 0; i < sizeof(handler_ids) / sizeof(handler_ids[0]); ++i) {
+        if (*handler_ids[i]) {
+            g_signal_handler_disconnect(stream->cursor_channel, *handler_ids[i]);
+            *handler_ids[i] = 0;
+        }
+    }
+    g_object_unref(stream->cursor_channel);
+    stream->cursor_channel = NULL;
+}
+
+// Must be called with cursor_mutex held
+static void winrun_connect_cursor_channel(winrun_spice_stream *stream, SpiceCursorChannel *channel) {
+    // Release previous channel if reconnecting
+    winrun_disconnect_cursor_channel(stream);
+
+    stream->cursor_channel = channel;
+    g_object_ref(stream->cursor_channel);
+    stream->cursor_set_handler_id = g_signal_connect(
+        channel, "cursor-set", G_CALLBACK(on_cursor_set), stream);
+    stream->cursor_move_handler_id = g_signal_connect(
+        channel, "cursor-move", G_CALLBACK(on_cursor_move), stream);
+    stream->cursor_hide_handler_id = g_signal_connect(
+        channel, "cursor-hide", G_CALLBACK(on_cursor_hide), stream);
+    stream->cursor_reset_handler_id = g_signal_connect(
+        channel, "cursor-reset", G_CALLBACK(on_cursor_reset), stream);
+}
+#endif
+
+void winrun_spice_set_cursor_callback(
+    winrun_spice_stream_handle streamHandle,
+    winrun_cursor_cb cursor_cb,
+    void *user_data
+) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream) {
+        return;
+    }
+
+    pthread_mutex_lock(&stream->cursor_mutex);
+    stream->cursor_cb = cursor_cb;
+    stream->cursor_user_data = user_data;
+    if (!cursor_cb) {
+        // Nobody will ask for the converted shapes again
+        winrun_cursor_cache_clear(&stream->cursor_cache);
+    }
+    pthread_mutex_unlock(&stream->cursor_mutex);
+}
+
+// MARK: - Video Streams
+
+void winrun_spice_set_video_callback(
+    winrun_spice_stream_handle streamHandle,
+    winrun_spice_video_cb video_cb,
+    void *user_data
+) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream) {
+        return;
+    }
+    winrun_video_worker_set_callback(&stream->video, video_cb, user_data);
+}
+
+bool winrun_spice_video_stream_create(
+    winrun_spice_stream_handle streamHandle,
+    uint32_t stream_id,
+    winrun_video_codec codec,
+    const winrun_video_rect *dest
+) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream) {
+        return false;
+    }
+    return winrun_video_worker_create_stream(&stream->video, stream_id, codec, dest);
+}
+
+bool winrun_spice_video_stream_data(
+    winrun_spice_stream_handle streamHandle,
+    uint32_t stream_id,
+    uint32_t mm_time,
+    const uint8_t *data,
+    size_t length
+) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream) {
+        return false;
+    }
+    // Hidden windows show nothing; skip the decode entirely
+    if (atomic_load(&stream->visibility) == WINRUN_STREAM_VISIBILITY_HIDDEN) {
+        return true;
+    }
+    return winrun_video_worker_queue(&stream->video, stream_id, mm_time, data, length);
+}
+
+void winrun_spice_video_stream_destroy(winrun_spice_stream_handle streamHandle, uint32_t stream_id) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream) {
+        return;
+    }
+    winrun_video_worker_destroy_stream(&stream->video, stream_id);
+}
+
+#if __APPLE__ && WINRUN_SPICE_STREAM_SIGNALS
+// Display channels that forward their stream messages emit stream-create
+// (id, codec, x, y, width, height), stream-data (id, mm_time, data, size)
+// and stream-destroy (id). A spice-gtk without them keeps decoding streams
+// itself, so they are looked up before connecting.
+static void on_display_stream_create(SpiceDisplayChannel *channel, guint id, guint codec,
+                                     gint x, gint y, guint width, guint height, gpointer user_data) {
+    (void)channel;
+    winrun_video_rect dest = { .x = x, .y = y, .width = width, .height = height };
+    winrun_spice_video_stream_create(user_data, id, (winrun_video_codec)codec, &dest);
+}
+
+static void on_display_stream_data(SpiceDisplayChannel *channel, guint id, guint mm_time,
+                                   gpointer data, guint size, gpointer user_data) {
+    (void)channel;
+    winrun_spice_video_stream_data(user_data, id, mm_time, data, size);
+}
+
+static void on_display_stream_destroy(SpiceDisplayChannel *channel, guint id, gpointer user_data) {
+    (void)channel;
+    winrun_spice_video_stream_destroy(user_data, id);
+}
+
+// Must be called with send_mutex held (or during teardown)
+static void winrun_disconnect_display_channel(winrun_spice_stream *stream) {
+    if (!stream->display_channel) {
+        return;
+    }
+    gulong *handler_ids[] = {
+        &stream->video_create_handler_id,
+        &stream->video_data_handler_id,
+        &stream->video_destroy_handler_id
+    };
+    for (size_t i = 0; i < sizeof(handler_ids) / sizeof(handler_ids[0]); ++i) {
+        if (*handler_ids[i]) {
+            g_signal_handler_disconnect(stream->display_channel, *handler_ids[i]);
+            *handler_ids[i] = 0;
+        }
+    }
+    g_object_unref(stream->display_channel);
+    stream->display_channel = NULL;
+}
+
+// Must be called with send_mutex held
+static void winrun_connect_display_channel(winrun_spice_stream *stream, SpiceDisplayChannel *channel) {
+    // Release previous channel if reconnecting
+    winrun_disconnect_display_channel(stream);
+
+    GType type = G_OBJECT_TYPE(channel);
+    if (!g_signal_lookup("stream-create", type) || !g_signal_lookup("stream-data", type) ||
+        !g_signal_lookup("stream-destroy", type)) {
+        return;
+    }
+
+    stream->display_channel = channel;
+    g_object_ref(stream->display_channel);
+    stream->video_create_handler_id = g_signal_connect(
+        channel, "stream-create", G_CALLBACK(on_display_stream_create), stream);
+    stream->video_data_handler_id = g_signal_connect(
+        channel, "stream-data", G_CALLBACK(on_display_stream_data), stream);
+    stream->video_destroy_handler_id = g_signal_connect(
+        channel, "stream-destroy", G_CALLBACK(on_display_stream_destroy), stream);
+}
+#endif
 
-    stream->worker_started = true;
-    return true;
+// MARK: - Audio Playback
+
+// Pins the current playback buffer for the caller; pair with winrun_audio_release
+// whether or not it returned one.
+static winrun_audio_buffer *winrun_audio_acquire(winrun_spice_stream *stream) {
+    atomic_fetch_add(&stream->audio_users, 1);
+    return atomic_load(&stream->audio);
 }
 
-static void *winrun_mock_worker(void *context) {
-    winrun_spice_stream *stream = (winrun_spice_stream *)context;
-    if (!stream) {
-        return NULL;
+static void winrun_audio_release(winrun_spice_stream *stream) {
+    atomic_fetch_sub(&stream->audio_users, 1);
+}
+
+// Swaps in a new playback buffer and frees the old one once no reader holds it.
+// Must be called with audio_mutex held.
+static void winrun_audio_swap(winrun_spice_stream *stream, winrun_audio_buffer *buffer) {
+    winrun_audio_buffer *previous = atomic_exchange(&stream->audio, buffer);
+    if (!previous) {
+        return;
+    }
+    // Readers only hold the buffer for one copy, so this wait is short
+    while (atomic_load(&stream->audio_users) > 0) {
+        sched_yield();
     }
+    winrun_audio_buffer_destroy(previous);
+    free(previous);
+}
 
-    if (stream->metadata_cb) {
-        winrun_spice_window_metadata metadata = {
-            .window_id = stream->window_id,
-            .position_x = 100.0,
-            .position_y = 100.0,
-            .width = 800.0,
-            .height = 600.0,
-            .scale_factor = 1.0,
-            .is_resizable = true,
-            .title = "Spice Window"
-        };
-        stream->metadata_cb(&metadata, stream->user_data);
+static void winrun_audio_start(winrun_spice_stream *stream, uint32_t sample_rate, uint32_t channels) {
+    pthread_mutex_lock(&stream->audio_mutex);
+    winrun_audio_buffer *buffer = malloc(sizeof(*buffer));
+    if (buffer && !winrun_audio_buffer_init(buffer, sample_rate, channels, &stream->audio_config)) {
+        free(buffer);
+        buffer = NULL;
     }
+    winrun_audio_swap(stream, buffer);
+    if (buffer && stream->audio_format_cb) {
+        winrun_audio_format format = { .sample_rate = sample_rate, .channels = channels };
+        stream->audio_format_cb(&format, stream->audio_user_data);
+    }
+    pthread_mutex_unlock(&stream->audio_mutex);
+}
 
-    struct timespec frame_delay = {
-        .tv_sec = 0,
-        .tv_nsec = 33 * 1000 * 1000
-    };
+static void winrun_audio_stop(winrun_spice_stream *stream) {
+    pthread_mutex_lock(&stream->audio_mutex);
+    bool was_playing = atomic_load(&stream->audio) != NULL;
+    winrun_audio_swap(stream, NULL);
+    if (was_playing && stream->audio_format_cb) {
+        stream->audio_format_cb(NULL, stream->audio_user_data);
+    }
+    pthread_mutex_unlock(&stream->audio_mutex);
+}
 
-    while (atomic_load(&stream->worker_running)) {
-        if (stream->frame_cb) {
-            uint8_t buffer[1024];
-            for (size_t i = 0; i < sizeof(buffer); ++i) {
-                buffer[i] = (uint8_t)(rand() % 255);
-            }
-            stream->frame_cb(buffer, sizeof(buffer), stream->user_data);
-        }
-        nanosleep(&frame_delay, NULL);
+#if __APPLE__
+static void on_playback_start(SpicePlaybackChannel *channel, gint format, gint channels,
+                              gint frequency, gpointer user_data) {
+    (void)channel;
+    winrun_spice_stream *stream = (winrun_spice_stream *)user_data;
+    // Spice only negotiates signed 16-bit PCM
+    if (!stream || format != SPICE_AUDIO_FMT_S16 || channels <= 0 || frequency <= 0) {
+        return;
     }
+    winrun_audio_start(stream, (uint32_t)frequency, (uint32_t)channels);
+}
 
-    if (stream->closed_cb) {
-        stream->closed_cb(WINRUN_SPICE_CLOSE_REASON_REMOTE, "Stream closed", stream->user_data);
+static void on_playback_data(SpicePlaybackChannel *channel, gpointer data, gint size,
+                             gpointer user_data) {
+    (void)channel;
+    winrun_spice_stream *stream = (winrun_spice_stream *)user_data;
+    if (!stream || !data || size <= 0) {
+        return;
     }
 
-    return NULL;
+    winrun_audio_buffer *audio = winrun_audio_acquire(stream);
+    if (audio) {
+        size_t frame_bytes = audio->channels * sizeof(int16_t);
+        winrun_audio_buffer_write(audio, (const int16_t *)data, (size_t)size / frame_bytes);
+    }
+    winrun_audio_release(stream);
 }
 
-winrun_spice_stream_handle winrun_spice_stream_open_tcp(
-    const char *host,
-    uint16_t port,
-    bool use_tls,
-    uint64_t window_id,
-    void *user_data,
-    winrun_spice_frame_cb frame_cb,
-    winrun_spice_metadata_cb metadata_cb,
-    winrun_spice_closed_cb closed_cb,
-    const char *ticket,
-    char *error_buffer,
-    size_t error_buffer_length
-) {
-    winrun_spice_stream *stream = winrun_spice_stream_create(
-        window_id,
-        user_data,
-        frame_cb,
-        metadata_cb,
-        closed_cb,
-        error_buffer,
-        error_buffer_length
-    );
+static void on_playback_stop(SpicePlaybackChannel *channel, gpointer user_data) {
+    (void)channel;
+    winrun_spice_stream *stream = (winrun_spice_stream *)user_data;
     if (!stream) {
-        return NULL;
+        return;
     }
+    winrun_audio_stop(stream);
+}
 
-#if __APPLE__
-    char port_string[16];
-    snprintf(port_string, sizeof(port_string), "%u", port);
-
-    stream->session = spice_session_new();
-    if (!stream->session) {
-        winrun_write_error(error_buffer, error_buffer_length, "Unable to create Spice session");
-        winrun_spice_stream_free(stream);
-        return NULL;
+// The server asks how far behind playback is so it can delay the matching
+// video frames (mm_time) by the same amount
+static void on_playback_get_delay(SpicePlaybackChannel *channel, gpointer user_data) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)user_data;
+    if (!stream) {
+        return;
     }
 
-    // Connect channel-new handler to capture inputs channel
-    stream->channel_new_handler_id = g_signal_connect(
-        stream->session,
-        "channel-new",
-        G_CALLBACK(on_channel_new),
-        stream
-    );
-
-    g_object_set(stream->session,
-                 "host", host,
-                 use_tls ? "tls-port" : "port", port_string,
-                 NULL);
-    if (ticket) {
-        g_object_set(stream->session, "password", ticket, NULL);
+    uint32_t delay_ms = 0;
+    winrun_audio_buffer *audio = winrun_audio_acquire(stream);
+    if (audio) {
+        delay_ms = (uint32_t)(winrun_audio_buffer_buffered(audio) * 1000 / audio->sample_rate);
     }
-    spice_session_connect(stream->session);
-    // On macOS with libspice, real frame delivery comes from the session callbacks,
-    // not from the mock worker thread. Don't start the mock worker.
-#else
-    (void)host;
-    (void)port;
-    (void)use_tls;
-    (void)ticket;
+    winrun_audio_release(stream);
+    spice_playback_channel_set_delay(channel, delay_ms);
+}
 
-    // Only start mock worker on non-macOS platforms (e.g., CI/test environments)
-    if (!winrun_spice_stream_start_worker(stream, error_buffer, error_buffer_length)) {
-        winrun_spice_stream_free(stream);
-        return NULL;
+// Must be called with audio_mutex held (or during teardown)
+static void winrun_disconnect_playback_channel(winrun_spice_stream *stream) {
+    if (!stream->playback_channel) {
+        return;
     }
-#endif
+    gulong *handler_ids[] = {
+        &stream->playback_start_handler_id,
+        &stream->playback_data_handler_id,
+        &stream->playback_stop_handler_id,
+        &stream->playback_delay_handler_id
+    };
+    for (size_t i = 0; i < sizeof(handler_ids) / sizeof(handler_ids[0]); ++i) {
+        if (*handler_ids[i]) {
+            g_signal_handler_disconnect(stream->playback_channel, *handler_ids[i]);
+            *handler_ids[i] = 0;
+        }
+    }
+    g_object_unref(stream->playback_channel);
+    stream->playback_channel = NULL;
+}
 
-    return stream;
+// Must be called with audio_mutex held
+static void winrun_connect_playback_channel(winrun_spice_stream *stream, SpicePlaybackChannel *channel) {
+    // Release previous channel if reconnecting
+    winrun_disconnect_playback_channel(stream);
+
+    stream->playback_channel = channel;
+    g_object_ref(stream->playback_channel);
+    stream->playback_start_handler_id = g_signal_connect(
+        channel, "playback-start", G_CALLBACK(on_playback_start), stream);
+    stream->playback_data_handler_id = g_signal_connect(
+        channel, "playback-data", G_CALLBACK(on_playback_data), stream);
+    stream->playback_stop_handler_id = g_signal_connect(
+        channel, "playback-stop", G_CALLBACK(on_playback_stop), stream);
+    stream->playback_delay_handler_id = g_signal_connect(
+        channel, "playback-get-delay", G_CALLBACK(on_playback_get_delay), stream);
 }
+#endif
 
-winrun_spice_stream_handle winrun_spice_stream_open_shared(
-    int shared_fd,
-    uint64_t window_id,
-    void *user_data,
-    winrun_spice_frame_cb frame_cb,
-    winrun_spice_metadata_cb metadata_cb,
-    winrun_spice_closed_cb closed_cb,
-    const char *ticket,
-    char *error_buffer,
-    size_t error_buffer_length
+void winrun_spice_set_audio_callback(
+    winrun_spice_stream_handle streamHandle,
+    winrun_audio_format_cb format_cb,
+    void *user_data
 ) {
-    if (shared_fd < 0) {
-        winrun_write_error(error_buffer, error_buffer_length, "Invalid shared-memory descriptor");
-        return NULL;
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream) {
+        return;
     }
 
-    winrun_spice_stream *stream = winrun_spice_stream_create(
-        window_id,
-        user_data,
-        frame_cb,
-        metadata_cb,
-        closed_cb,
-        error_buffer,
-        error_buffer_length
-    );
-    if (!stream) {
-        return NULL;
+    pthread_mutex_lock(&stream->audio_mutex);
+    stream->audio_format_cb = format_cb;
+    stream->audio_user_data = user_data;
+    // Playback may already be running; tell the new listener straight away
+    winrun_audio_buffer *audio = atomic_load(&stream->audio);
+    if (audio && format_cb) {
+        winrun_audio_format format = { .sample_rate = audio->sample_rate, .channels = audio->channels };
+        format_cb(&format, user_data);
     }
+    pthread_mutex_unlock(&stream->audio_mutex);
+}
 
-#if __APPLE__
-    stream->session = spice_session_new();
-    if (!stream->session) {
-        winrun_write_error(error_buffer, error_buffer_length, "Unable to create Spice session");
-        winrun_spice_stream_free(stream);
-        return NULL;
+bool winrun_spice_audio_configure(winrun_spice_stream_handle streamHandle, const winrun_audio_config *config) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream || !config) {
+        return false;
     }
 
-    // Connect channel-new handler to capture inputs channel
-    stream->channel_new_handler_id = g_signal_connect(
-        stream->session,
-        "channel-new",
-        G_CALLBACK(on_channel_new),
-        stream
-    );
+    pthread_mutex_lock(&stream->audio_mutex);
+    stream->audio_config = winrun_audio_config_resolve(config);
+    pthread_mutex_unlock(&stream->audio_mutex);
+    return true;
+}
 
-    if (ticket) {
-        g_object_set(stream->session, "password", ticket, NULL);
+size_t winrun_spice_audio_pull(
+    winrun_spice_stream_handle streamHandle,
+    int16_t *samples,
+    size_t frames,
+    uint32_t channels
+) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream || !samples || frames == 0 || channels == 0) {
+        return 0;
     }
 
-    // Use spice_session_open_fd for pre-connected shared memory descriptor
-    // This is used with Virtualization.framework's shared memory transport
-    if (!spice_session_open_fd(stream->session, shared_fd)) {
-        winrun_write_error(error_buffer, error_buffer_length, "Failed to open Spice session with shared-memory descriptor");
-        winrun_spice_stream_free(stream);
-        return NULL;
+    size_t copied = 0;
+    bool filled = false;
+    winrun_audio_buffer *audio = winrun_audio_acquire(stream);
+    // A mismatch means the format just changed and the host hasn't reconfigured yet
+    if (audio && audio->channels == channels) {
+        copied = winrun_audio_buffer_read(audio, samples, frames);
+        filled = true;
     }
-    // On macOS with libspice, real frame delivery comes from the session callbacks,
-    // not from the mock worker thread. Don't start the mock worker.
-#else
-    (void)shared_fd;
-    (void)ticket;
-
-    // Only start mock worker on non-macOS platforms (e.g., CI/test environments)
-    if (!winrun_spice_stream_start_worker(stream, error_buffer, error_buffer_length)) {
-        winrun_spice_stream_free(stream);
-        return NULL;
+    winrun_audio_release(stream);
+    if (!filled) {
+        memset(samples, 0, frames * channels * sizeof(int16_t));
     }
-#endif
-
-    return stream;
+    return copied;
 }
 
-void winrun_spice_stream_close(winrun_spice_stream_handle streamHandle) {
+bool winrun_spice_audio_get_stats(winrun_spice_stream_handle streamHandle, winrun_audio_stats *stats) {
     winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
-    if (!stream) {
-        return;
+    if (!stream || !stats) {
+        return false;
     }
 
-    atomic_store(&stream->worker_running, false);
-
-    // Only join the worker thread if it was actually started
-    if (stream->worker_started) {
-        pthread_join(stream->worker_thread, NULL);
+    winrun_audio_buffer *audio = winrun_audio_acquire(stream);
+    if (audio) {
+        winrun_audio_buffer_stats(audio, stats);
     }
-
-    winrun_spice_stream_free(stream);
+    winrun_audio_release(stream);
+    return audio != NULL;
 }
 
 // MARK: - Input Events
@@ -591,6 +1686,7 @@ bool winrun_spice_send_mouse_event(
         return false;
     }
 
+    uint64_t start_ns = WINRUN_PROBE_START(input__send);
     pthread_mutex_lock(&stream->send_mutex);
 
 #if __APPLE__
@@ -668,6 +1764,7 @@ bool winrun_spice_send_mouse_event(
 #endif
 
     pthread_mutex_unlock(&stream->send_mutex);
+    WINRUN_PROBE3(input__send, stream->window_id, WINRUN_PROBE_INPUT_MOUSE, winrun_probe_since_ns(start_ns));
     return true;
 }
 
@@ -680,6 +1777,7 @@ bool winrun_spice_send_keyboard_event(
         return false;
     }
 
+    uint64_t start_ns = WINRUN_PROBE_START(input__send);
     pthread_mutex_lock(&stream->send_mutex);
 
 #if __APPLE__
@@ -719,6 +1817,7 @@ bool winrun_spice_send_keyboard_event(
 #endif
 
     pthread_mutex_unlock(&stream->send_mutex);
+    WINRUN_PROBE3(input__send, stream->window_id, WINRUN_PROBE_INPUT_KEYBOARD, winrun_probe_since_ns(start_ns));
     return true;
 }
 
@@ -782,8 +1881,9 @@ static void on_clipboard_data(SpiceMainChannel *channel, guint selection,
             .data_length = size,
             .sequence_number = seq
         };
-        cb(&clipboard, cb_user_data);
+        winrun_emit_clipboard(stream, cb, &clipboard, cb_user_data);
     }
+    WINRUN_PROBE3(clipboard__recv, stream->window_id, spice_to_winrun_format(type), size);
 }
 
 // Called when guest requests clipboard data from host
@@ -868,6 +1968,7 @@ bool winrun_spice_send_clipboard(
 #endif
 
     pthread_mutex_unlock(&stream->send_mutex);
+    WINRUN_PROBE3(clipboard__send, stream->window_id, clipboard->format, clipboard->data_length);
     return true;
 }
 
@@ -951,6 +2052,7 @@ bool winrun_spice_send_drag_event(
         return false;
     }
 
+    uint64_t start_ns = WINRUN_PROBE_START(input__send);
     pthread_mutex_lock(&stream->send_mutex);
 
 #if __APPLE__
@@ -1022,6 +2124,7 @@ bool winrun_spice_send_drag_event(
 #endif
 
     pthread_mutex_unlock(&stream->send_mutex);
+    WINRUN_PROBE3(input__send, stream->window_id, WINRUN_PROBE_INPUT_DRAG, winrun_probe_since_ns(start_ns));
     return true;
 }
 
@@ -1053,6 +2156,7 @@ bool winrun_spice_send_control_message(
         return false;
     }
 
+    uint64_t start_ns = WINRUN_PROBE_START(control__send);
     pthread_mutex_lock(&stream->send_mutex);
 
 #if __APPLE__
@@ -1086,5 +2190,136 @@ bool winrun_spice_send_control_message(
 #endif
 
     pthread_mutex_unlock(&stream->send_mutex);
+    WINRUN_PROBE3(control__send, stream->window_id, length, winrun_probe_since_ns(start_ns));
     return true;
 }
+
+// MARK: - Window Routes
+
+bool winrun_spice_route_window(
+    uint64_t window_id,
+    winrun_window_frame_cb frame_cb,
+    winrun_window_metadata_cb metadata_cb,
+    void *user_data
+) {
+    return winrun_route_table_add(&winrun_window_routes, window_id, frame_cb, metadata_cb, user_data);
+}
+
+void winrun_spice_unroute_window(uint64_t window_id) {
+    winrun_route_table_remove(&winrun_window_routes, window_id);
+}
+
+// MARK: - Callback Executors
+
+void winrun_spice_stream_set_executor(
+    winrun_spice_stream_handle streamHandle,
+    uint32_t kinds,
+    winrun_executor_handle executor
+) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream) {
+        return;
+    }
+
+    winrun_executor_handle previous[WINRUN_CALLBACK_KIND_COUNT] = { NULL };
+    pthread_mutex_lock(&stream->executor_mutex);
+    for (int i = 0; i < WINRUN_CALLBACK_KIND_COUNT; ++i) {
+        if ((kinds & (1u << i)) && stream->executors[i] != executor) {
+            previous[i] = stream->executors[i];
+            stream->executors[i] = executor;
+        }
+    }
+    pthread_mutex_unlock(&stream->executor_mutex);
+
+    // Outside the lock: cancel may wait for a drain that is running one of
+    // this stream's callbacks
+    for (int i = 0; i < WINRUN_CALLBACK_KIND_COUNT; ++i) {
+        if (previous[i]) {
+            winrun_executor_cancel(previous[i], stream, 1u << i);
+        }
+    }
+}
+
+// MARK: - Control Requests
+
+void winrun_spice_stream_set_request_tracker(
+    winrun_spice_stream_handle streamHandle,
+    winrun_request_tracker_handle tracker
+) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream) {
+        return;
+    }
+
+    pthread_mutex_lock(&stream->send_mutex);
+    stream->request_tracker = tracker;
+    pthread_mutex_unlock(&stream->send_mutex);
+}
+
+// MARK: - Guest Heartbeat
+
+static bool winrun_heartbeat_send_ping(const uint8_t *envelope, size_t length, void *context) {
+    return winrun_spice_send_control_message((winrun_spice_stream_handle)context, envelope, length);
+}
+
+// Swaps in a new monitor and frees the old one once no reader holds it.
+// Must be called with heartbeat_mutex held.
+static void winrun_heartbeat_swap(winrun_spice_stream *stream, winrun_heartbeat *heartbeat) {
+    winrun_heartbeat *previous = atomic_exchange(&stream->heartbeat, heartbeat);
+    if (!previous) {
+        return;
+    }
+    // Readers only hold the monitor for one reply, so this wait is short
+    while (atomic_load(&stream->heartbeat_users) > 0) {
+        sched_yield();
+    }
+    winrun_heartbeat_destroy(previous);
+}
+
+bool winrun_spice_stream_start_heartbeat(
+    winrun_spice_stream_handle streamHandle,
+    uint32_t interval_ms,
+    uint32_t stall_after_ms,
+    winrun_guest_health_cb cb,
+    void *user_data
+) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream) {
+        return false;
+    }
+
+    pthread_mutex_lock(&stream->heartbeat_mutex);
+    // The old monitor goes first so its callbacks never overlap the new one's
+    winrun_heartbeat_swap(stream, NULL);
+    winrun_heartbeat *heartbeat = winrun_heartbeat_create(
+        interval_ms, stall_after_ms, winrun_heartbeat_send_ping, stream, cb, user_data);
+    atomic_store(&stream->heartbeat, heartbeat);
+    pthread_mutex_unlock(&stream->heartbeat_mutex);
+    return heartbeat != NULL;
+}
+
+void winrun_spice_stream_stop_heartbeat(winrun_spice_stream_handle streamHandle) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream) {
+        return;
+    }
+
+    pthread_mutex_lock(&stream->heartbeat_mutex);
+    winrun_heartbeat_swap(stream, NULL);
+    pthread_mutex_unlock(&stream->heartbeat_mutex);
+}
+
+bool winrun_spice_stream_get_heartbeat_stats(winrun_spice_stream_handle streamHandle, winrun_heartbeat_stats *stats) {
+    winrun_spice_stream *stream = (winrun_spice_stream *)streamHandle;
+    if (!stream || !stats) {
+        return false;
+    }
+
+    pthread_mutex_lock(&stream->heartbeat_mutex);
+    winrun_heartbeat *heartbeat = atomic_load(&stream->heartbeat);
+    if (heartbeat) {
+        winrun_heartbeat_get_stats(heartbeat, stats);
+    }
+    pthread_mutex_unlock(&stream->heartbeat_mutex);
+    return heartbeat != NULL;
+}
@@ -59,6 +59,407 @@ winrun_spice_stream_handle winrun_spice_stream_open_shared(
 
 void winrun_spice_stream_close(winrun_spice_stream_handle stream);
 
+/// Re-attach a stream to a new connection after its transport dropped.
+///
+/// The handle, callbacks, surfaces, cursor cache, visibility and audio settings
+/// all carry over; only the Spice session and its channels are replaced, and
+/// the server sends the current display state on the new channels. Shared-memory
+/// streams need a fresh descriptor in `shared_fd`; TCP streams pass -1 and
+/// reconnect to the same host. On failure the stream stays open but
+/// disconnected, and can be resumed again or closed.
+/// Returns true on success, false on failure
+bool winrun_spice_stream_resume(
+    winrun_spice_stream_handle stream,
+    int shared_fd,
+    char *error_buffer,
+    size_t error_buffer_length
+);
+
+// MARK: - Visibility
+
+typedef enum {
+    WINRUN_STREAM_VISIBILITY_VISIBLE = 0,
+    WINRUN_STREAM_VISIBILITY_BACKGROUND = 1,
+    WINRUN_STREAM_VISIBILITY_HIDDEN = 2
+} winrun_stream_visibility;
+
+/// Default frame rate for background streams when max_fps is 0
+#define WINRUN_STREAM_BACKGROUND_DEFAULT_FPS 2
+
+/// Throttle frame delivery for a stream based on its window's visibility.
+/// Hidden streams deliver no frames; background streams deliver at most
+/// max_fps frames per second (WINRUN_STREAM_BACKGROUND_DEFAULT_FPS when 0);
+/// visible streams are capped at max_fps, or unlimited when 0.
+/// The guest-side throttle hint is sent by the Swift layer over the control channel.
+/// Returns true on success, false on failure
+bool winrun_spice_stream_set_visibility(
+    winrun_spice_stream_handle stream,
+    winrun_stream_visibility state,
+    uint32_t max_fps
+);
+
+// MARK: - Buffers
+
+typedef enum {
+    /// Regular pages
+    WINRUN_HUGEPAGES_OFF = 0,
+    /// Ask the kernel to back the buffer with transparent huge pages (madvise)
+    WINRUN_HUGEPAGES_TRANSPARENT = 1,
+    /// Use reserved huge pages (MAP_HUGETLB/MFD_HUGETLB, macOS superpages),
+    /// falling back to transparent huge pages, then regular pages
+    WINRUN_HUGEPAGES_EXPLICIT = 2
+} winrun_hugepage_mode;
+
+typedef enum {
+    /// Regular pages
+    WINRUN_HUGEPAGE_STATUS_NONE = 0,
+    /// Transparent huge pages were requested; the kernel backs them as it can
+    /// (see winrun_hugepage_backed_bytes)
+    WINRUN_HUGEPAGE_STATUS_TRANSPARENT = 1,
+    /// Backed by reserved huge pages
+    WINRUN_HUGEPAGE_STATUS_EXPLICIT = 2
+} winrun_hugepage_status;
+
+/// Large page-aligned buffer for frame pools and conversion scratch space
+typedef struct {
+    uint8_t *data;
+    /// Bytes requested
+    size_t size;
+    /// Bytes mapped (size rounded up to the page or huge page size)
+    size_t mapped_size;
+    winrun_hugepage_status hugepages;
+} winrun_buffer;
+
+/// Allocate a zeroed buffer, using huge pages according to `mode`.
+/// Returns true on success, false on failure
+bool winrun_buffer_alloc(size_t size, winrun_hugepage_mode mode, winrun_buffer *buffer);
+
+/// Release a buffer from winrun_buffer_alloc. Safe to call on a zeroed buffer.
+void winrun_buffer_free(winrun_buffer *buffer);
+
+/// Bytes of the mappings covering [address, address + length) that are
+/// currently backed by huge pages. Linux only (reads /proc/self/smaps);
+/// returns 0 elsewhere.
+size_t winrun_hugepage_backed_bytes(const void *address, size_t length);
+
+// MARK: - Shared Surfaces
+
+typedef enum {
+    WINRUN_SURFACE_BACKING_NONE = 0,
+    WINRUN_SURFACE_BACKING_MEMFD = 1,
+    WINRUN_SURFACE_BACKING_POSIX_SHM = 2
+} winrun_surface_backing;
+
+/// Header at the start of every surface slot, followed by the frame data.
+/// `generation` is 0 while the slot is being written. Readers in another
+/// process load it (acquire) before and after copying or displaying the data;
+/// if the two values differ or are 0, the slot was overwritten mid-read.
+typedef struct {
+    uint64_t generation;
+    uint64_t window_id;
+    uint64_t length;
+    uint64_t reserved[5];
+} winrun_surface_slot_header;
+
+/// Size of winrun_surface_slot_header; frame data starts this far into a slot
+#define WINRUN_SURFACE_SLOT_HEADER_SIZE 64
+
+/// Describes a frame written to a shared surface.
+/// Map `mapping_size` bytes of `fd` (MAP_SHARED, offset 0) in another process
+/// and read `length` bytes at `offset`. The fd stays owned by the bridge: dup()
+/// it before handing it to another process, and don't close it.
+typedef struct {
+    uint64_t window_id;
+    int fd;
+    winrun_surface_backing backing;
+    size_t mapping_size;
+    size_t offset;
+    size_t length;
+    uint64_t generation;
+    /// The same bytes in this process's mapping
+    const uint8_t *data;
+    /// Whether the surface mapping uses huge pages
+    winrun_hugepage_status hugepages;
+} winrun_frame_surface;
+
+typedef void (*winrun_spice_surface_cb)(const winrun_frame_surface *surface, void *user_data);
+
+/// Deliver frames through fd-backed shared memory so another process can map
+/// and display them without copying. Uses memfd on Linux and falls back to an
+/// unlinked POSIX shm object. Frames are written round-robin into `slot_count`
+/// slots of up to `max_frame_size` bytes; `surface_cb` is called for each one,
+/// and frame_cb keeps receiving the same bytes from the shared mapping.
+/// Frames larger than `max_frame_size` fall back to process-private delivery.
+/// Calling again replaces the previous surfaces (and fd). Must not be called
+/// from inside a frame or surface callback.
+/// Returns true on success, false on failure
+bool winrun_spice_stream_enable_shared_surfaces(
+    winrun_spice_stream_handle stream,
+    size_t max_frame_size,
+    uint32_t slot_count,
+    winrun_spice_surface_cb surface_cb,
+    void *user_data
+);
+
+/// Stop delivering through shared surfaces and release the mapping and fd.
+void winrun_spice_stream_disable_shared_surfaces(winrun_spice_stream_handle stream);
+
+/// Huge-page mode used by the next winrun_spice_stream_enable_shared_surfaces
+/// call (default WINRUN_HUGEPAGES_OFF). The result is reported per frame in
+/// winrun_frame_surface.hugepages.
+/// Returns true on success, false on failure
+bool winrun_spice_stream_set_surface_hugepages(
+    winrun_spice_stream_handle stream,
+    winrun_hugepage_mode mode
+);
+
+// MARK: - Tiled Frames
+
+/// How one tile of a tiled frame slot is coded (guest: TiledFrameEncoder.cs)
+typedef enum {
+    WINRUN_TILE_RAW = 0,      // Pixels, width * 4 bytes per row
+    WINRUN_TILE_LZ4 = 1,      // LZ4 block of the raw pixels
+    WINRUN_TILE_RLE = 2,      // Runs of [count: uint16][pixel: uint32] in row order
+    WINRUN_TILE_PALETTE = 3   // Up to 256 colors and 1/2/4/8-bit indices
+} winrun_tile_codec;
+
+#define WINRUN_TILE_CODEC_COUNT 4
+
+/// Tiles decoded with each codec, indexed by winrun_tile_codec
+typedef struct {
+    uint64_t tiles[WINRUN_TILE_CODEC_COUNT];
+} winrun_tile_stats;
+
+/// Decode a tiled frame payload into `width` x `height` BGRA pixels at
+/// `dest`, `dest_stride` bytes per row. Tile counts are added to `stats`,
+/// which may be NULL.
+/// Returns false if the payload is malformed or doesn't cover the frame;
+/// `dest` may then be partly written.
+bool winrun_tiles_decode(
+    const uint8_t *payload,
+    size_t length,
+    uint32_t width,
+    uint32_t height,
+    uint8_t *dest,
+    size_t dest_stride,
+    winrun_tile_stats *stats
+);
+
+// MARK: - Frame Rings
+
+/// Pending slots of a shared frame buffer ring (host: SharedFrameBuffer.swift)
+typedef struct {
+    /// Oldest pending slot (the read index)
+    uint32_t first;
+    /// Slots written and not yet read
+    uint32_t pending;
+    /// Newest written slot; only meaningful when `pending` > 0
+    uint32_t latest;
+    uint32_t slot_count;
+} winrun_ring_span;
+
+/// Load the indices of the ring whose 64-byte header starts at `ring`. The
+/// write index is loaded with acquire ordering, so every pending slot is
+/// completely written.
+/// Returns false if the header is truncated or an index is out of range
+bool winrun_ring_pending(const void *ring, size_t size, winrun_ring_span *span);
+
+/// Hand the oldest `count` pending slots back to the writer with one release
+/// store of the read index. `count` is clamped to the slots pending.
+/// Returns the number of slots released
+uint32_t winrun_ring_release(void *ring, size_t size, uint32_t count);
+
+// MARK: - Cursor
+
+typedef enum {
+    WINRUN_CURSOR_EVENT_SET = 0,    // Guest changed the pointer shape; `shape` is set
+    WINRUN_CURSOR_EVENT_MOVE = 1,   // Guest moved the pointer (server mouse mode)
+    WINRUN_CURSOR_EVENT_HIDE = 2,   // Guest hid the pointer
+    WINRUN_CURSOR_EVENT_RESET = 3   // Guest dropped its shapes; show the default pointer
+} winrun_cursor_event_type;
+
+/// A pointer image converted for native display.
+typedef struct {
+    /// Content hash of the guest image and hotspot. Equal hashes mean equal
+    /// shapes, so consumers can key their own cursor objects on it.
+    uint64_t hash;
+    uint32_t width;
+    uint32_t height;
+    uint32_t hot_x;
+    uint32_t hot_y;
+    /// width * height pixels of premultiplied BGRA (CoreGraphics
+    /// premultipliedFirst + byteOrder32Little). Owned by the bridge's shape
+    /// cache and only valid during the callback.
+    const uint8_t *pixels;
+    size_t length;
+} winrun_cursor_shape;
+
+typedef struct {
+    uint64_t window_id;
+    winrun_cursor_event_type type;
+    /// Pointer position in guest coordinates, for MOVE
+    int32_t x;
+    int32_t y;
+    /// New shape for SET, NULL otherwise
+    const winrun_cursor_shape *shape;
+} winrun_cursor_event;
+
+typedef void (*winrun_cursor_cb)(const winrun_cursor_event *event, void *user_data);
+
+/// Set cursor callback for pointer shape, move and hide events from the
+/// guest's cursor channel. Shapes are converted once and cached by content
+/// hash, so switching back to a recently used pointer costs only the lookup.
+/// Pass NULL to stop receiving events.
+void winrun_spice_set_cursor_callback(
+    winrun_spice_stream_handle stream,
+    winrun_cursor_cb cursor_cb,
+    void *user_data
+);
+
+// MARK: - Video Streams
+//
+// The MJPEG decoder is fed only through winrun_spice_video_stream_*. Upstream
+// spice-gtk decodes display streams itself and doesn't hand over their data,
+// so nothing calls these for a live session unless the bridge is built with
+// WINRUN_SPICE_STREAM_SIGNALS against a spice-gtk that forwards them.
+
+/// Codecs for server-detected video regions (values match SPICE_VIDEO_CODEC_TYPE_*)
+typedef enum {
+    WINRUN_VIDEO_CODEC_MJPEG = 1
+} winrun_video_codec;
+
+typedef struct {
+    int32_t x;
+    int32_t y;
+    uint32_t width;
+    uint32_t height;
+} winrun_video_rect;
+
+/// A decoded video frame, to be composited into the window at `dest`.
+typedef struct {
+    uint64_t window_id;
+    uint32_t stream_id;
+    /// Region of the window the stream covers
+    winrun_video_rect dest;
+    /// Decoded size; scale to `dest` if it differs
+    uint32_t width;
+    uint32_t height;
+    size_t stride;
+    /// BGRA pixels, valid only during the callback
+    const uint8_t *pixels;
+    /// Stream timestamp (milliseconds) the frame was presented at
+    uint32_t mm_time;
+    uint64_t decode_ns;
+    /// Frames dropped on this stream so far (queue overflow or decode errors)
+    uint64_t dropped_frames;
+} winrun_video_frame;
+
+typedef void (*winrun_spice_video_cb)(const winrun_video_frame *frame, void *user_data);
+
+/// Whether the bridge was built with a decoder for `codec`
+bool winrun_video_codec_supported(winrun_video_codec codec);
+
+/// Set the callback for decoded video frames. Frames are decoded on a
+/// per-window worker thread and delivered from it, paced by their timestamps.
+/// Pass NULL to stop receiving frames.
+void winrun_spice_set_video_callback(
+    winrun_spice_stream_handle stream,
+    winrun_spice_video_cb video_cb,
+    void *user_data
+);
+
+/// Start a video stream covering `dest` (SPICE_MSG_DISPLAY_STREAM_CREATE).
+/// Returns false if the codec is unsupported, the id is in use, or too many
+/// streams are open.
+bool winrun_spice_video_stream_create(
+    winrun_spice_stream_handle stream,
+    uint32_t stream_id,
+    winrun_video_codec codec,
+    const winrun_video_rect *dest
+);
+
+/// Queue one compressed frame for decoding (SPICE_MSG_DISPLAY_STREAM_DATA).
+/// The data is copied. When decoding falls behind, the oldest queued frame of
+/// the stream is dropped.
+/// Returns true on success, false on failure
+bool winrun_spice_video_stream_data(
+    winrun_spice_stream_handle stream,
+    uint32_t stream_id,
+    uint32_t mm_time,
+    const uint8_t *data,
+    size_t length
+);
+
+/// End a video stream and discard its queued frames (SPICE_MSG_DISPLAY_STREAM_DESTROY).
+void winrun_spice_video_stream_destroy(winrun_spice_stream_handle stream, uint32_t stream_id);
+
+// MARK: - Audio Playback
+
+/// Guest playback format. Samples are always signed 16-bit, interleaved.
+typedef struct {
+    uint32_t sample_rate;
+    uint32_t channels;
+} winrun_audio_format;
+
+/// Jitter buffer settings. Zero fields take the defaults.
+typedef struct {
+    /// Latency the jitter buffer refills to after an underrun (default 40 ms).
+    /// Underruns raise it in 10 ms steps; clean playback lowers it back.
+    uint32_t target_latency_ms;
+    /// Buffered audio beyond this is skipped (default 200 ms)
+    uint32_t max_latency_ms;
+} winrun_audio_config;
+
+typedef struct {
+    winrun_audio_format format;
+    uint32_t buffered_ms;
+    /// Current adaptive target
+    uint32_t target_latency_ms;
+    uint64_t frames_written;
+    uint64_t frames_read;
+    /// Times the output ran dry and had to refill
+    uint64_t underruns;
+    /// Times guest audio was dropped: ring full, or trimmed back to the target
+    uint64_t overruns;
+    /// Guest frames discarded by overruns
+    uint64_t frames_dropped;
+    /// Silent frames output while refilling
+    uint64_t frames_concealed;
+} winrun_audio_stats;
+
+/// Called when guest playback starts (with its format) or stops (NULL).
+/// Start or stop the host output unit from here; it is called on the Spice
+/// event thread, so don't block or call the other audio setters.
+typedef void (*winrun_audio_format_cb)(const winrun_audio_format *format, void *user_data);
+
+/// Set the playback start/stop callback.
+void winrun_spice_set_audio_callback(
+    winrun_spice_stream_handle stream,
+    winrun_audio_format_cb format_cb,
+    void *user_data
+);
+
+/// Jitter buffer settings used from the next playback start.
+/// Returns true on success, false on failure
+bool winrun_spice_audio_configure(winrun_spice_stream_handle stream, const winrun_audio_config *config);
+
+/// Pull `frames` frames of playback for the host output. Always fills the
+/// whole buffer (frames * channels samples), with silence while nothing is
+/// playing, the jitter buffer is refilling, or `channels` doesn't match the
+/// current format. Never blocks or allocates, so it is safe to call from a
+/// real-time audio callback.
+/// Returns the number of frames that carried guest audio
+size_t winrun_spice_audio_pull(
+    winrun_spice_stream_handle stream,
+    int16_t *samples,
+    size_t frames,
+    uint32_t channels
+);
+
+/// Snapshot of the playback buffer counters.
+/// Returns false when nothing is playing
+bool winrun_spice_audio_get_stats(winrun_spice_stream_handle stream, winrun_audio_stats *stats);
+
 // MARK: - Input Events
 
 typedef enum {
@@ -225,3 +626,296 @@ bool winrun_spice_send_control_message(
 #ifdef __cplusplus
 }
 #endif
+
+// MARK: - Window Routes
+
+/// A frameReady notification, decoded by the bridge for a routed window
+/// (host: FrameReadyMessage)
+typedef struct {
+    uint64_t window_id;
+    uint32_t slot_index;
+    uint32_t frame_number;
+    bool is_key_frame;
+    /// Capture rate the guest chose for the window; 0 if it didn't report one
+    uint32_t target_fps;
+    /// Why the guest chose `target_fps`; not NUL-terminated, NULL if absent
+    const char *rate_reason;
+    size_t rate_reason_length;
+    /// Guest send time, milliseconds since the Unix epoch
+    int64_t timestamp;
+} winrun_frame_ready;
+
+/// Callback for frameReady notifications for one window. The struct and the
+/// reason string are only valid during the callback.
+typedef void (*winrun_window_frame_cb)(
+    const winrun_frame_ready *frame,
+    void *user_data
+);
+
+/// Callback for windowMetadata messages for one window, with the message's
+/// JSON payload (the envelope header stripped)
+typedef void (*winrun_window_metadata_cb)(
+    uint64_t window_id,
+    const uint8_t *payload,
+    size_t length,
+    void *user_data
+);
+
+/// Route frameReady and windowMetadata messages for `window_id` straight to
+/// these callbacks, on the thread that receives control data, instead of
+/// through the control callback. Routes are shared by every stream, since
+/// the control channel carries messages for all windows; they are only
+/// consulted on the stream that has a control callback. Either callback
+/// may be NULL to leave that message type on the control callback.
+/// Replaces any existing route for the window.
+/// Returns true on success, false on failure
+bool winrun_spice_route_window(
+    uint64_t window_id,
+    winrun_window_frame_cb frame_cb,
+    winrun_window_metadata_cb metadata_cb,
+    void *user_data
+);
+
+/// Remove the route for `window_id`. Waits for a callback already running
+/// for any routed window to return, so it must not be called from one.
+void winrun_spice_unroute_window(uint64_t window_id);
+
+// MARK: - Callback Executors
+
+/// Stream callbacks that can be moved off the bridge thread
+typedef enum {
+    WINRUN_CALLBACK_FRAME = 1 << 0,
+    WINRUN_CALLBACK_METADATA = 1 << 1,
+    WINRUN_CALLBACK_CLIPBOARD = 1 << 2,
+    WINRUN_CALLBACK_CONTROL = 1 << 3
+} winrun_callback_kind;
+
+#define WINRUN_CALLBACK_ALL \
+    (WINRUN_CALLBACK_FRAME | WINRUN_CALLBACK_METADATA | WINRUN_CALLBACK_CLIPBOARD | WINRUN_CALLBACK_CONTROL)
+
+/// A consumer-owned queue of callback events, shared by any number of
+/// streams. Events are queued with copies of their arguments and run when
+/// the consumer drains the executor.
+typedef struct winrun_executor *winrun_executor_handle;
+
+/// Called when an event is queued on an idle executor. It is not called
+/// again until a drain has emptied the queue, so one wakeup covers every
+/// event queued in the meantime. Runs on the bridge thread that queued the
+/// event: schedule a drain (for example, post to a queue) and return,
+/// without calling back into the bridge.
+typedef void (*winrun_executor_wakeup_cb)(void *user_data);
+
+typedef struct {
+    /// Events queued
+    uint64_t posted;
+    /// Times `wakeup` was called
+    uint64_t wakeups;
+    /// Events run by drains
+    uint64_t drained;
+    /// Events dropped: cancelled by a stream closing or changing executor,
+    /// or not queued because allocation failed
+    uint64_t dropped;
+    /// Queued frames replaced by a newer frame from the same stream
+    uint64_t coalesced;
+} winrun_executor_stats;
+
+/// Create an executor. Returns NULL on allocation failure
+winrun_executor_handle winrun_executor_create(winrun_executor_wakeup_cb wakeup, void *user_data);
+
+/// Destroy an executor and drop anything still queued. Every stream using
+/// it must be closed or moved to another executor first.
+void winrun_executor_destroy(winrun_executor_handle executor);
+
+/// Run queued events on the calling thread, oldest first, until the queue
+/// is empty; events queued while draining are run by the same call. Drain
+/// from one thread at a time.
+/// Returns the number of events run
+size_t winrun_executor_drain(winrun_executor_handle executor);
+
+/// Get the executor's counters. Returns false if `executor` is NULL
+bool winrun_executor_get_stats(winrun_executor_handle executor, winrun_executor_stats *stats);
+
+/// Choose where the stream's `kinds` callbacks run: queued on `executor`,
+/// or inline on the bridge thread that fires them when NULL (the default).
+/// Queued frames and clipboard data are copied; a stream keeps only its
+/// newest frame queued. Events still queued on a previous executor for
+/// these kinds are dropped. Closing the stream drops its queued events and
+/// waits for one that is running on another thread.
+void winrun_spice_stream_set_executor(
+    winrun_spice_stream_handle stream,
+    uint32_t kinds,
+    winrun_executor_handle executor
+);
+
+// MARK: - Control Requests
+
+/// How a tracked control request ended
+typedef enum {
+    WINRUN_REQUEST_COMPLETED = 0,
+    WINRUN_REQUEST_TIMED_OUT = 1,
+    WINRUN_REQUEST_CANCELLED = 2
+} winrun_request_status;
+
+/// Called exactly once per request. For WINRUN_REQUEST_COMPLETED `response`
+/// is the whole response envelope ([type][length][JSON]), valid only during
+/// the call; otherwise it is NULL. Runs on the thread that completed the
+/// request: the control port's reader, the tracker's timer thread for
+/// timeouts, or the caller of winrun_request_cancel_all. The tracker's lock
+/// is not held, so the callback may start or cancel other requests.
+typedef void (*winrun_request_cb)(
+    uint32_t message_id,
+    winrun_request_status status,
+    const uint8_t *response,
+    size_t length,
+    void *user_data
+);
+
+/// Correlates control requests with their responses. The tracker hands out
+/// message IDs, keeps the in-flight requests in a table keyed by ID, and
+/// times them out with a hashed timer wheel driven by one thread, so the
+/// cost per request stays constant however many are pipelined.
+typedef struct winrun_request_tracker *winrun_request_tracker_handle;
+
+typedef struct {
+    /// Requests started
+    uint64_t started;
+    uint64_t completed;
+    uint64_t timed_out;
+    /// Cancelled by winrun_request_cancel_all or destroy
+    uint64_t cancelled;
+    /// Requests waiting for a response
+    uint32_t in_flight;
+} winrun_request_stats;
+
+/// Create a tracker. Its timer thread starts with the first request.
+/// Returns NULL on allocation failure
+winrun_request_tracker_handle winrun_request_tracker_create(void);
+
+/// Cancel every request still in flight (WINRUN_REQUEST_CANCELLED), stop
+/// the timer thread and free the tracker. Detach it from its stream first.
+void winrun_request_tracker_destroy(winrun_request_tracker_handle tracker);
+
+/// Start tracking a request. Send it with the returned message ID; `cb`
+/// runs when a response with that ID arrives, or with
+/// WINRUN_REQUEST_TIMED_OUT once `timeout_ms` has passed (rounded up to the
+/// wheel's 10 ms tick).
+/// Returns 0 if `cb` is NULL or allocation fails
+uint32_t winrun_request_begin(
+    winrun_request_tracker_handle tracker,
+    uint32_t timeout_ms,
+    winrun_request_cb cb,
+    void *user_data
+);
+
+/// Complete a request with `response` (a whole envelope).
+/// Returns false if `message_id` is not in flight
+bool winrun_request_complete(
+    winrun_request_tracker_handle tracker,
+    uint32_t message_id,
+    const uint8_t *response,
+    size_t length
+);
+
+/// Stop tracking a request without calling its callback, for example when
+/// it couldn't be sent. Stores the request's user data in `user_data` (if
+/// not NULL) so the caller can release it.
+/// Returns false if the request already ended; its callback has then run
+/// or is running.
+bool winrun_request_cancel(winrun_request_tracker_handle tracker, uint32_t message_id, void **user_data);
+
+/// Cancel every request in flight (WINRUN_REQUEST_CANCELLED), as when the
+/// control channel disconnects.
+/// Returns the number of requests cancelled
+size_t winrun_request_cancel_all(winrun_request_tracker_handle tracker);
+
+/// Complete in-flight requests from control-port data: SessionList,
+/// ShortcutList and Ack envelopes by `messageId`, Error envelopes by
+/// `relatedMessageId`. Every other envelope, and data that isn't a whole
+/// number of envelopes, is passed to `fallback`.
+/// Returns the number of requests completed
+size_t winrun_request_tracker_match(
+    winrun_request_tracker_handle tracker,
+    const uint8_t *data,
+    size_t length,
+    winrun_control_message_cb fallback,
+    void *fallback_user_data
+);
+
+/// Get the tracker's counters. Returns false if `tracker` is NULL
+bool winrun_request_tracker_get_stats(winrun_request_tracker_handle tracker, winrun_request_stats *stats);
+
+/// Complete responses read from this stream's control port with `tracker`
+/// before they reach the control callback, or stop when NULL. Detach the
+/// tracker before destroying it.
+void winrun_spice_stream_set_request_tracker(
+    winrun_spice_stream_handle stream,
+    winrun_request_tracker_handle tracker
+);
+
+// MARK: - Guest Heartbeat
+
+/// Guest liveness as judged from replies to heartbeat pings
+typedef enum {
+    /// No reply yet
+    WINRUN_GUEST_HEALTH_UNKNOWN = 0,
+    WINRUN_GUEST_HEALTH_HEALTHY = 1,
+    /// No reply within the stall deadline
+    WINRUN_GUEST_HEALTH_STALLED = 2
+} winrun_guest_health;
+
+typedef struct {
+    winrun_guest_health health;
+    uint64_t pings_sent;
+    /// Pings the control port wouldn't take (not open yet, or closed)
+    uint64_t send_failures;
+    uint64_t replies;
+    /// Replies older than one already counted, or to no ping sent; ignored
+    uint64_t stale_replies;
+    /// Times the guest was reported stalled
+    uint64_t stalls;
+    /// Replies the percentiles cover: the most recent 128
+    uint32_t samples;
+    /// Round-trip times in microseconds, measured on the host's clock
+    uint32_t rtt_last_us;
+    uint32_t rtt_p50_us;
+    uint32_t rtt_p90_us;
+    uint32_t rtt_p99_us;
+    uint32_t rtt_max_us;
+    /// Smoothed change between consecutive RTTs (RFC 3550's jitter estimator)
+    uint32_t jitter_us;
+    /// Time since the last reply, or since the heartbeat started
+    uint64_t silence_ms;
+} winrun_heartbeat_stats;
+
+/// Called when the guest's health changes: STALLED once no reply has come
+/// within the deadline, HEALTHY on the first reply and on each recovery.
+/// Runs on the heartbeat's own thread; `stats` is valid only during the
+/// call. Don't stop the heartbeat from the callback.
+typedef void (*winrun_guest_health_cb)(
+    winrun_guest_health health,
+    const winrun_heartbeat_stats *stats,
+    void *user_data
+);
+
+/// Ping the guest over this stream's control port every `interval_ms`
+/// (0: 1000 ms) and report it stalled once `stall_after_ms` (0: three
+/// intervals) pass without a reply. Replies are taken off the control port
+/// on its reader's thread and never reach the control callback. Replaces a
+/// heartbeat that is already running.
+/// The guest must understand Ping (0x0C); an older agent never replies and
+/// is reported stalled.
+/// Returns false if the heartbeat thread couldn't start
+bool winrun_spice_stream_start_heartbeat(
+    winrun_spice_stream_handle stream,
+    uint32_t interval_ms,
+    uint32_t stall_after_ms,
+    winrun_guest_health_cb cb,
+    void *user_data
+);
+
+/// Stop the heartbeat, if any. No health callback runs once this returns.
+void winrun_spice_stream_stop_heartbeat(winrun_spice_stream_handle stream);
+
+/// Get the heartbeat's counters and RTT percentiles.
+/// Returns false if no heartbeat is running
+bool winrun_spice_stream_get_heartbeat_stats(winrun_spice_stream_handle stream, winrun_heartbeat_stats *stats);
@@ -0,0 +1,220 @@
+#include "winrun_audio.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define WINRUN_AUDIO_DEFAULT_TARGET_MS 40
+#define WINRUN_AUDIO_DEFAULT_MAX_MS 200
+#define WINRUN_AUDIO_MAX_LATENCY_MS 2000
+
+winrun_audio_config winrun_audio_config_resolve(const winrun_audio_config *config) {
+    winrun_audio_config resolved = { 0 };
+    if (config) {
+        resolved = *config;
+    }
+    if (resolved.target_latency_ms == 0) {
+        resolved.target_latency_ms = WINRUN_AUDIO_DEFAULT_TARGET_MS;
+    }
+    if (resolved.target_latency_ms > WINRUN_AUDIO_MAX_LATENCY_MS / 2) {
+        resolved.target_latency_ms = WINRUN_AUDIO_MAX_LATENCY_MS / 2;
+    }
+    if (resolved.max_latency_ms == 0) {
+        resolved.max_latency_ms = WINRUN_AUDIO_DEFAULT_MAX_MS;
+    }
+    // Leave room for the target to grow a few steps before trimming kicks in
+    uint32_t floor_ms = resolved.target_latency_ms + 2 * WINRUN_AUDIO_TARGET_STEP_MS;
+    if (resolved.max_latency_ms < floor_ms) {
+        resolved.max_latency_ms = floor_ms;
+    }
+    if (resolved.max_latency_ms > WINRUN_AUDIO_MAX_LATENCY_MS) {
+        resolved.max_latency_ms = WINRUN_AUDIO_MAX_LATENCY_MS;
+    }
+    return resolved;
+}
+
+static uint32_t winrun_audio_ms_to_frames(uint32_t ms, uint32_t sample_rate) {
+    return (uint32_t)((uint64_t)ms * sample_rate / 1000);
+}
+
+bool winrun_audio_buffer_init(
+    winrun_audio_buffer *buffer,
+    uint32_t sample_rate,
+    uint32_t channels,
+    const winrun_audio_config *config
+) {
+    if (!buffer) {
+        return false;
+    }
+    memset(buffer, 0, sizeof(*buffer));
+    if (sample_rate == 0 || sample_rate > 384000 || channels == 0 || channels > 8) {
+        return false;
+    }
+
+    winrun_audio_config resolved = winrun_audio_config_resolve(config);
+    uint32_t max_frames = winrun_audio_ms_to_frames(resolved.max_latency_ms, sample_rate);
+
+    // Room for the maximum latency plus a burst of the same size on top
+    uint64_t capacity = 1;
+    while (capacity < (uint64_t)max_frames * 2) {
+        capacity <<= 1;
+    }
+
+    buffer->samples = calloc(capacity * channels, sizeof(int16_t));
+    if (!buffer->samples) {
+        return false;
+    }
+
+    buffer->channels = channels;
+    buffer->sample_rate = sample_rate;
+    buffer->capacity = capacity;
+    buffer->min_target_frames = winrun_audio_ms_to_frames(resolved.target_latency_ms, sample_rate);
+    buffer->max_frames = max_frames;
+    buffer->max_target_frames = max_frames - winrun_audio_ms_to_frames(WINRUN_AUDIO_TARGET_STEP_MS, sample_rate);
+    atomic_store(&buffer->target_frames, buffer->min_target_frames);
+    buffer->prefilling = true;
+    return true;
+}
+
+void winrun_audio_buffer_destroy(winrun_audio_buffer *buffer) {
+    if (!buffer) {
+        return;
+    }
+    free(buffer->samples);
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+// The ring copies split at the wrap point
+static void winrun_audio_copy_in(winrun_audio_buffer *buffer, uint64_t position, const int16_t *samples, size_t frames) {
+    uint64_t index = position & (buffer->capacity - 1);
+    size_t first = (size_t)(buffer->capacity - index);
+    if (first > frames) {
+        first = frames;
+    }
+    size_t frame_bytes = buffer->channels * sizeof(int16_t);
+    memcpy(buffer->samples + index * buffer->channels, samples, first * frame_bytes);
+    memcpy(buffer->samples, samples + first * buffer->channels, (frames - first) * frame_bytes);
+}
+
+static void winrun_audio_copy_out(winrun_audio_buffer *buffer, uint64_t position, int16_t *samples, size_t frames) {
+    uint64_t index = position & (buffer->capacity - 1);
+    size_t first = (size_t)(buffer->capacity - index);
+    if (first > frames) {
+        first = frames;
+    }
+    size_t frame_bytes = buffer->channels * sizeof(int16_t);
+    memcpy(samples, buffer->samples + index * buffer->channels, first * frame_bytes);
+    memcpy(samples + first * buffer->channels, buffer->samples, (frames - first) * frame_bytes);
+}
+
+size_t winrun_audio_buffer_write(winrun_audio_buffer *buffer, const int16_t *samples, size_t frames) {
+    if (!buffer || !buffer->samples || !samples || frames == 0) {
+        return 0;
+    }
+
+    uint64_t head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&buffer->tail, memory_order_acquire);
+    uint64_t space = buffer->capacity - (head - tail);
+
+    size_t count = frames;
+    if (count > space) {
+        // Output stalled long enough to fill the ring; keep what's queued
+        count = (size_t)space;
+        atomic_fetch_add_explicit(&buffer->overruns_full, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&buffer->frames_overflowed, frames - count, memory_order_relaxed);
+    }
+    if (count > 0) {
+        winrun_audio_copy_in(buffer, head, samples, count);
+        atomic_store_explicit(&buffer->head, head + count, memory_order_release);
+        atomic_fetch_add_explicit(&buffer->frames_written, count, memory_order_relaxed);
+    }
+    return count;
+}
+
+size_t winrun_audio_buffer_read(winrun_audio_buffer *buffer, int16_t *samples, size_t frames) {
+    if (!buffer || !buffer->samples || !samples || frames == 0) {
+        return 0;
+    }
+
+    uint64_t tail = atomic_load_explicit(&buffer->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&buffer->head, memory_order_acquire);
+    uint64_t buffered = head - tail;
+    uint32_t target = atomic_load_explicit(&buffer->target_frames, memory_order_relaxed);
+
+    if (buffer->prefilling) {
+        if (buffered < target) {
+            memset(samples, 0, frames * buffer->channels * sizeof(int16_t));
+            atomic_fetch_add_explicit(&buffer->frames_concealed, frames, memory_order_relaxed);
+            return 0;
+        }
+        buffer->prefilling = false;
+        if (buffered > target) {
+            // Start at the target latency rather than behind a backlog that
+            // built up while the output wasn't pulling
+            uint64_t skip = buffered - target;
+            tail += skip;
+            buffered = target;
+            atomic_fetch_add_explicit(&buffer->frames_trimmed, skip, memory_order_relaxed);
+        }
+    }
+
+    if (buffered > buffer->max_frames) {
+        // Latency crept past the limit (a burst after a network stall); skip back to the target
+        uint64_t skip = buffered - target;
+        tail += skip;
+        buffered = target;
+        atomic_fetch_add_explicit(&buffer->overruns_trimmed, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&buffer->frames_trimmed, skip, memory_order_relaxed);
+    }
+
+    size_t count = buffered < frames ? (size_t)buffered : frames;
+    if (count > 0) {
+        winrun_audio_copy_out(buffer, tail, samples, count);
+    }
+    atomic_store_explicit(&buffer->tail, tail + count, memory_order_release);
+    atomic_fetch_add_explicit(&buffer->frames_read, count, memory_order_relaxed);
+
+    if (count < frames) {
+        memset(samples + count * buffer->channels, 0, (frames - count) * buffer->channels * sizeof(int16_t));
+        atomic_fetch_add_explicit(&buffer->frames_concealed, frames - count, memory_order_relaxed);
+        atomic_fetch_add_explicit(&buffer->underruns, 1, memory_order_relaxed);
+
+        // Refill before resuming, with more headroom than last time
+        buffer->prefilling = true;
+        buffer->frames_since_underrun = 0;
+        uint32_t step = winrun_audio_ms_to_frames(WINRUN_AUDIO_TARGET_STEP_MS, buffer->sample_rate);
+        if (target + step <= buffer->max_target_frames) {
+            atomic_store_explicit(&buffer->target_frames, target + step, memory_order_relaxed);
+        }
+        return count;
+    }
+
+    buffer->frames_since_underrun += count;
+    if (buffer->frames_since_underrun >= winrun_audio_ms_to_frames(WINRUN_AUDIO_STABLE_MS, buffer->sample_rate)) {
+        // Playback has been clean for a while; give back some latency
+        buffer->frames_since_underrun = 0;
+        uint32_t step = winrun_audio_ms_to_frames(WINRUN_AUDIO_TARGET_STEP_MS, buffer->sample_rate);
+        uint32_t lowered = target > buffer->min_target_frames + step ? target - step : buffer->min_target_frames;
+        atomic_store_explicit(&buffer->target_frames, lowered, memory_order_relaxed);
+    }
+    return count;
+}
+
+uint64_t winrun_audio_buffer_buffered(winrun_audio_buffer *buffer) {
+    uint64_t tail = atomic_load_explicit(&buffer->tail, memory_order_acquire);
+    uint64_t head = atomic_load_explicit(&buffer->head, memory_order_acquire);
+    return head > tail ? head - tail : 0;
+}
+
+void winrun_audio_buffer_stats(winrun_audio_buffer *buffer, winrun_audio_stats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->format.sample_rate = buffer->sample_rate;
+    stats->format.channels = buffer->channels;
+    stats->buffered_ms = (uint32_t)(winrun_audio_buffer_buffered(buffer) * 1000 / buffer->sample_rate);
+    stats->target_latency_ms = (uint32_t)((uint64_t)atomic_load(&buffer->target_frames) * 1000 / buffer->sample_rate);
+    stats->frames_written = atomic_load(&buffer->frames_written);
+    stats->frames_read = atomic_load(&buffer->frames_read);
+    stats->underruns = atomic_load(&buffer->underruns);
+    stats->overruns = atomic_load(&buffer->overruns_full) + atomic_load(&buffer->overruns_trimmed);
+    stats->frames_dropped = atomic_load(&buffer->frames_overflowed) + atomic_load(&buffer->frames_trimmed);
+    stats->frames_concealed = atomic_load(&buffer->frames_concealed);
+}
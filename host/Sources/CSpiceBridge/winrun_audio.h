@@ -0,0 +1,76 @@
+#pragma once
+
+// Playback buffer between the Spice event thread and the host audio callback.
+//
+// A single-producer/single-consumer ring of interleaved signed 16-bit frames.
+// The producer (Spice playback-data) and consumer (host render callback)
+// only touch their own index plus an acquire load of the other's, so neither
+// side ever blocks or allocates.
+//
+// The consumer side runs an adaptive jitter buffer: after an underrun it
+// outputs silence until `target` frames are buffered again and raises the
+// target one step; after a stretch without underruns it lowers it back toward
+// the configured latency. Playback always (re)starts exactly `target` frames
+// behind the producer, and anything buffered beyond the maximum latency is
+// skipped, so delay can't build up behind a late or stalled output.
+
+#include "CSpiceBridge.h"
+
+#include <stdatomic.h>
+
+// Step the adaptive target moves by, and how long playback must run
+// cleanly before it shrinks again
+#define WINRUN_AUDIO_TARGET_STEP_MS 10
+#define WINRUN_AUDIO_STABLE_MS 5000
+
+typedef struct {
+    int16_t *samples;
+    uint32_t channels;
+    uint32_t sample_rate;
+    uint64_t capacity;  // frames, power of two
+    uint32_t min_target_frames;
+    uint32_t max_target_frames;
+    uint32_t max_frames;
+
+    // Producer
+    _Atomic uint64_t head;
+    _Atomic uint64_t frames_written;
+    _Atomic uint64_t overruns_full;
+    _Atomic uint64_t frames_overflowed;
+
+    // Consumer
+    _Atomic uint64_t tail;
+    _Atomic uint32_t target_frames;
+    bool prefilling;
+    uint64_t frames_since_underrun;
+    _Atomic uint64_t frames_read;
+    _Atomic uint64_t underruns;
+    _Atomic uint64_t overruns_trimmed;
+    _Atomic uint64_t frames_trimmed;
+    _Atomic uint64_t frames_concealed;
+} winrun_audio_buffer;
+
+// Fills in defaults for zero fields and clamps the rest to a sane range.
+winrun_audio_config winrun_audio_config_resolve(const winrun_audio_config *config);
+
+bool winrun_audio_buffer_init(
+    winrun_audio_buffer *buffer,
+    uint32_t sample_rate,
+    uint32_t channels,
+    const winrun_audio_config *config
+);
+
+void winrun_audio_buffer_destroy(winrun_audio_buffer *buffer);
+
+// Producer: appends up to `frames` frames. Frames that don't fit are dropped
+// and counted as an overrun. Returns the number written.
+size_t winrun_audio_buffer_write(winrun_audio_buffer *buffer, const int16_t *samples, size_t frames);
+
+// Consumer: always fills `frames` frames, padding with silence while the jitter
+// buffer refills. Returns the number of guest frames copied.
+size_t winrun_audio_buffer_read(winrun_audio_buffer *buffer, int16_t *samples, size_t frames);
+
+// Frames currently queued. Safe from any thread.
+uint64_t winrun_audio_buffer_buffered(winrun_audio_buffer *buffer);
+
+void winrun_audio_buffer_stats(winrun_audio_buffer *buffer, winrun_audio_stats *stats);
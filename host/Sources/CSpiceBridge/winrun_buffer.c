@@ -0,0 +1,159 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // MAP_HUGETLB, MADV_HUGEPAGE
+#endif
+
+#include "winrun_buffer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if __APPLE__
+#include <mach/vm_statistics.h>
+#endif
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#define WINRUN_DEFAULT_HUGEPAGE_SIZE (2u * 1024u * 1024u)
+
+size_t winrun_hugepage_size(void) {
+    return WINRUN_DEFAULT_HUGEPAGE_SIZE;
+}
+
+size_t winrun_round_up_size(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+bool winrun_hugepage_advise(void *address, size_t length) {
+#ifdef MADV_HUGEPAGE
+    return madvise(address, length, MADV_HUGEPAGE) == 0;
+#else
+    (void)address;
+    (void)length;
+    return false;
+#endif
+}
+
+static size_t winrun_page_size(void) {
+    long page_size = sysconf(_SC_PAGESIZE);
+    return page_size > 0 ? (size_t)page_size : 4096;
+}
+
+// Maps from the reserved huge page pool. Returns MAP_FAILED when none are available.
+static void *winrun_map_explicit_hugepages(size_t mapped_size) {
+#if defined(MAP_HUGETLB)
+    return mmap(NULL, mapped_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#elif __APPLE__ && defined(VM_FLAGS_SUPERPAGE_SIZE_ANY)
+    // Superpages are only supported on Intel Macs; Apple silicon fails and falls back
+    return mmap(NULL, mapped_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, VM_FLAGS_SUPERPAGE_SIZE_ANY, 0);
+#else
+    (void)mapped_size;
+    return MAP_FAILED;
+#endif
+}
+
+bool winrun_buffer_alloc(size_t size, winrun_hugepage_mode mode, winrun_buffer *buffer) {
+    if (!buffer) {
+        return false;
+    }
+    memset(buffer, 0, sizeof(*buffer));
+
+    size_t huge = winrun_hugepage_size();
+    if (size == 0 || size > SIZE_MAX - huge) {
+        return false;
+    }
+
+    if (mode == WINRUN_HUGEPAGES_EXPLICIT) {
+        size_t mapped_size = winrun_round_up_size(size, huge);
+        void *data = winrun_map_explicit_hugepages(mapped_size);
+        if (data != MAP_FAILED) {
+            buffer->data = (uint8_t *)data;
+            buffer->size = size;
+            buffer->mapped_size = mapped_size;
+            buffer->hugepages = WINRUN_HUGEPAGE_STATUS_EXPLICIT;
+            return true;
+        }
+        // Pool empty or unsupported: fall through to transparent huge pages
+    }
+
+    // Rounding to whole huge pages lets the kernel back the tail with one too
+    size_t mapped_size = mode == WINRUN_HUGEPAGES_OFF
+        ? winrun_round_up_size(size, winrun_page_size())
+        : winrun_round_up_size(size, huge);
+    void *data = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    buffer->data = (uint8_t *)data;
+    buffer->size = size;
+    buffer->mapped_size = mapped_size;
+    buffer->hugepages = WINRUN_HUGEPAGE_STATUS_NONE;
+    if (mode != WINRUN_HUGEPAGES_OFF && winrun_hugepage_advise(data, mapped_size)) {
+        buffer->hugepages = WINRUN_HUGEPAGE_STATUS_TRANSPARENT;
+    }
+    return true;
+}
+
+void winrun_buffer_free(winrun_buffer *buffer) {
+    if (!buffer) {
+        return;
+    }
+    if (buffer->data) {
+        munmap(buffer->data, buffer->mapped_size);
+    }
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+size_t winrun_hugepage_backed_bytes(const void *address, size_t length) {
+#if defined(__linux__)
+    if (!address || length == 0) {
+        return 0;
+    }
+
+    FILE *smaps = fopen("/proc/self/smaps", "r");
+    if (!smaps) {
+        return 0;
+    }
+
+    uintptr_t start = (uintptr_t)address;
+    uintptr_t end = start + length;
+    bool in_range = false;
+    size_t backed_kb = 0;
+    char line[512];
+
+    while (fgets(line, sizeof(line), smaps)) {
+        unsigned long vma_start = 0;
+        unsigned long vma_end = 0;
+        char dash = 0;
+        // Mapping header lines look like "7f12...-7f13... rw-p ..."
+        if (sscanf(line, "%lx%c%lx", &vma_start, &dash, &vma_end) == 3 && dash == '-') {
+            in_range = vma_start < end && vma_end > start;
+            continue;
+        }
+        if (!in_range) {
+            continue;
+        }
+
+        size_t kb = 0;
+        if (sscanf(line, "AnonHugePages: %zu kB", &kb) == 1 ||
+            sscanf(line, "ShmemPmdMapped: %zu kB", &kb) == 1 ||
+            sscanf(line, "Shared_Hugetlb: %zu kB", &kb) == 1 ||
+            sscanf(line, "Private_Hugetlb: %zu kB", &kb) == 1) {
+            backed_kb += kb;
+        }
+    }
+
+    fclose(smaps);
+    return backed_kb * 1024;
+#else
+    (void)address;
+    (void)length;
+    return 0;
+#endif
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+// Huge-page helpers shared by winrun_buffer_alloc and the surface ring.
+
+#include "CSpiceBridge.h"
+
+// Size of the huge pages used for rounding (2 MB unless the platform says otherwise)
+size_t winrun_hugepage_size(void);
+
+// Round `size` up to a multiple of `alignment` (a power of two or not)
+size_t winrun_round_up_size(size_t size, size_t alignment);
+
+// Ask for transparent huge pages on an existing mapping.
+// Returns true if the kernel accepted the advice.
+bool winrun_hugepage_advise(void *address, size_t length);
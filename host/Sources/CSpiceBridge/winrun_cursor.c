@@ -0,0 +1,114 @@
+#include "winrun_cursor.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define WINRUN_FNV_OFFSET_BASIS 0xcbf29ce484222325ull
+#define WINRUN_FNV_PRIME 0x100000001b3ull
+
+static uint64_t winrun_fnv1a(uint64_t hash, const uint8_t *bytes, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= bytes[i];
+        hash *= WINRUN_FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t winrun_cursor_hash(
+    const uint8_t *rgba,
+    uint32_t width,
+    uint32_t height,
+    uint32_t hot_x,
+    uint32_t hot_y
+) {
+    uint32_t geometry[4] = { width, height, hot_x, hot_y };
+    uint64_t hash = winrun_fnv1a(WINRUN_FNV_OFFSET_BASIS, (const uint8_t *)geometry, sizeof(geometry));
+    if (rgba) {
+        hash = winrun_fnv1a(hash, rgba, (size_t)width * height * 4);
+    }
+    return hash;
+}
+
+static inline uint8_t winrun_premultiply(uint8_t channel, uint8_t alpha) {
+    return (uint8_t)(((uint32_t)channel * alpha + 127) / 255);
+}
+
+// Straight-alpha RGBA to premultiplied BGRA
+static void winrun_cursor_convert(const uint8_t *rgba, uint8_t *bgra, size_t pixel_count) {
+    for (size_t i = 0; i < pixel_count; ++i) {
+        const uint8_t *src = rgba + i * 4;
+        uint8_t *dst = bgra + i * 4;
+        uint8_t alpha = src[3];
+        dst[0] = winrun_premultiply(src[2], alpha);
+        dst[1] = winrun_premultiply(src[1], alpha);
+        dst[2] = winrun_premultiply(src[0], alpha);
+        dst[3] = alpha;
+    }
+}
+
+const winrun_cursor_shape *winrun_cursor_cache_lookup(
+    winrun_cursor_cache *cache,
+    const uint8_t *rgba,
+    uint32_t width,
+    uint32_t height,
+    uint32_t hot_x,
+    uint32_t hot_y
+) {
+    if (!cache || !rgba || width == 0 || height == 0 ||
+        width > WINRUN_CURSOR_MAX_DIMENSION || height > WINRUN_CURSOR_MAX_DIMENSION) {
+        return NULL;
+    }
+
+    uint64_t hash = winrun_cursor_hash(rgba, width, height, hot_x, hot_y);
+    cache->clock++;
+
+    winrun_cursor_cache_entry *victim = NULL;
+    for (uint32_t i = 0; i < cache->count; ++i) {
+        winrun_cursor_cache_entry *entry = &cache->entries[i];
+        if (entry->shape.hash == hash && entry->shape.width == width && entry->shape.height == height) {
+            entry->last_used = cache->clock;
+            cache->hits++;
+            return &entry->shape;
+        }
+        if (!victim || entry->last_used < victim->last_used) {
+            victim = entry;
+        }
+    }
+
+    size_t length = (size_t)width * height * 4;
+    uint8_t *pixels = malloc(length);
+    if (!pixels) {
+        return NULL;
+    }
+    winrun_cursor_convert(rgba, pixels, (size_t)width * height);
+    cache->misses++;
+
+    if (cache->count < WINRUN_CURSOR_CACHE_CAPACITY) {
+        victim = &cache->entries[cache->count++];
+    } else {
+        free(victim->pixels);
+    }
+
+    victim->pixels = pixels;
+    victim->last_used = cache->clock;
+    victim->shape = (winrun_cursor_shape){
+        .hash = hash,
+        .width = width,
+        .height = height,
+        .hot_x = hot_x,
+        .hot_y = hot_y,
+        .pixels = pixels,
+        .length = length,
+    };
+    return &victim->shape;
+}
+
+void winrun_cursor_cache_clear(winrun_cursor_cache *cache) {
+    if (!cache) {
+        return;
+    }
+    for (uint32_t i = 0; i < cache->count; ++i) {
+        free(cache->entries[i].pixels);
+    }
+    memset(cache, 0, sizeof(*cache));
+}
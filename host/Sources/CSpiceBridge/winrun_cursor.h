@@ -0,0 +1,57 @@
+#pragma once
+
+// Cache of pointer shapes converted for native display.
+//
+// The guest resends the same few cursors (arrow, I-beam, resize handles)
+// every time the pointer crosses between controls. Shapes are keyed by a hash
+// of the source image and hotspot, so a repeated shape costs one hash pass
+// instead of an allocation and a pixel conversion. The least recently used
+// entry is replaced once the cache is full.
+//
+// The cache is not thread-safe; the stream serializes access.
+
+#include "CSpiceBridge.h"
+
+#define WINRUN_CURSOR_CACHE_CAPACITY 32
+
+// Larger shapes are rejected; Windows cursors top out at 256x256
+#define WINRUN_CURSOR_MAX_DIMENSION 512
+
+typedef struct {
+    winrun_cursor_shape shape;
+    uint8_t *pixels;
+    uint64_t last_used;
+} winrun_cursor_cache_entry;
+
+typedef struct {
+    winrun_cursor_cache_entry entries[WINRUN_CURSOR_CACHE_CAPACITY];
+    uint32_t count;
+    uint64_t clock;
+    uint64_t hits;
+    uint64_t misses;
+} winrun_cursor_cache;
+
+// Hashes a straight-alpha RGBA shape and its hotspot (64-bit FNV-1a).
+uint64_t winrun_cursor_hash(
+    const uint8_t *rgba,
+    uint32_t width,
+    uint32_t height,
+    uint32_t hot_x,
+    uint32_t hot_y
+);
+
+// Returns the cached shape for a straight-alpha RGBA image, converting and
+// inserting it on a miss. Returns NULL for empty or oversized shapes or when
+// allocation fails. The result stays valid until the entry is replaced or
+// the cache is cleared.
+const winrun_cursor_shape *winrun_cursor_cache_lookup(
+    winrun_cursor_cache *cache,
+    const uint8_t *rgba,
+    uint32_t width,
+    uint32_t height,
+    uint32_t hot_x,
+    uint32_t hot_y
+);
+
+// Frees every entry. The cache can be reused afterwards.
+void winrun_cursor_cache_clear(winrun_cursor_cache *cache);
@@ -0,0 +1,202 @@
+// Control-port envelopes and payload fields; see winrun_envelope.h.
+
+#include "winrun_envelope.h"
+
+#include <string.h>
+
+bool winrun_envelopes_are_whole(const uint8_t *data, size_t length) {
+    if (!data) {
+        return false;
+    }
+    size_t offset = 0;
+    while (length - offset >= WINRUN_ENVELOPE_HEADER_SIZE) {
+        uint32_t payload_length = winrun_envelope_length(data + offset);
+        if (payload_length > length - offset - WINRUN_ENVELOPE_HEADER_SIZE) {
+            break;
+        }
+        offset += WINRUN_ENVELOPE_HEADER_SIZE + payload_length;
+    }
+    return offset > 0 && offset == length;
+}
+
+// MARK: - Payload Fields
+
+typedef struct {
+    const uint8_t *at;
+    const uint8_t *end;
+} winrun_json;
+
+static void winrun_json_skip_space(winrun_json *json) {
+    while (json->at < json->end &&
+           (*json->at == ' ' || *json->at == '\t' || *json->at == '\n' || *json->at == '\r')) {
+        json->at++;
+    }
+}
+
+static bool winrun_json_string(winrun_json *json, winrun_json_value *value) {
+    if (json->at >= json->end || *json->at != '"') {
+        return false;
+    }
+    const uint8_t *start = ++json->at;
+    bool escaped = false;
+    while (json->at < json->end && *json->at != '"') {
+        if (*json->at == '\\') {
+            escaped = true;
+            json->at++;
+        }
+        json->at++;
+    }
+    if (json->at >= json->end) {
+        return false;
+    }
+    *value = (winrun_json_value){ start, (size_t)(json->at - start), true, escaped };
+    json->at++;
+    return true;
+}
+
+static bool winrun_json_value_at(winrun_json *json, winrun_json_value *value) {
+    winrun_json_skip_space(json);
+    if (json->at >= json->end) {
+        return false;
+    }
+
+    if (*json->at == '"') {
+        return winrun_json_string(json, value);
+    }
+
+    const uint8_t *start = json->at;
+    if (*json->at == '{' || *json->at == '[') {
+        int depth = 0;
+        do {
+            if (json->at >= json->end) {
+                return false;
+            }
+            winrun_json_value skipped;
+            if (*json->at == '"') {
+                if (!winrun_json_string(json, &skipped)) {
+                    return false;
+                }
+                continue;
+            }
+            if (*json->at == '{' || *json->at == '[') {
+                depth++;
+            } else if (*json->at == '}' || *json->at == ']') {
+                depth--;
+            }
+            json->at++;
+        } while (depth > 0);
+    } else {
+        // Number or literal
+        while (json->at < json->end && *json->at != ',' && *json->at != '}' &&
+               *json->at != ' ' && *json->at != '\t' && *json->at != '\n' && *json->at != '\r') {
+            json->at++;
+        }
+    }
+
+    *value = (winrun_json_value){ start, (size_t)(json->at - start), false, false };
+    return value->length > 0;
+}
+
+bool winrun_json_fields(
+    const uint8_t *payload,
+    size_t length,
+    const char *const *keys,
+    size_t key_count,
+    winrun_json_value *values
+) {
+    memset(values, 0, key_count * sizeof(*values));
+    winrun_json json = { payload, payload + length };
+
+    winrun_json_skip_space(&json);
+    if (json.at >= json.end || *json.at++ != '{') {
+        return false;
+    }
+    winrun_json_skip_space(&json);
+    if (json.at < json.end && *json.at == '}') {
+        return true;
+    }
+
+    for (;;) {
+        winrun_json_value key;
+        winrun_json_value value;
+        winrun_json_skip_space(&json);
+        if (!winrun_json_string(&json, &key)) {
+            return false;
+        }
+        winrun_json_skip_space(&json);
+        if (json.at >= json.end || *json.at++ != ':' || !winrun_json_value_at(&json, &value)) {
+            return false;
+        }
+
+        for (size_t i = 0; i < key_count; ++i) {
+            if (!key.escaped && key.length == strlen(keys[i]) && memcmp(key.start, keys[i], key.length) == 0) {
+                values[i] = value;
+                break;
+            }
+        }
+
+        winrun_json_skip_space(&json);
+        if (json.at >= json.end) {
+            return false;
+        }
+        if (*json.at == '}') {
+            return true;
+        }
+        if (*json.at++ != ',') {
+            return false;
+        }
+    }
+}
+
+bool winrun_json_is_null(const winrun_json_value *value) {
+    return !value->start || (!value->is_string && value->length == 4 && memcmp(value->start, "null", 4) == 0);
+}
+
+bool winrun_json_u64(const winrun_json_value *value, uint64_t max, uint64_t *out) {
+    if (!value->start || value->is_string || value->length > 20) {
+        return false;
+    }
+    uint64_t result = 0;
+    for (size_t i = 0; i < value->length; ++i) {
+        uint8_t digit = value->start[i] - '0';
+        if (digit > 9 || result > (max - digit) / 10) {
+            return false;
+        }
+        result = result * 10 + digit;
+    }
+    *out = result;
+    return true;
+}
+
+bool winrun_json_i64(const winrun_json_value *value, int64_t *out) {
+    if (!value->start || value->is_string || value->length == 0) {
+        return false;
+    }
+    bool negative = value->start[0] == '-';
+    winrun_json_value digits = *value;
+    if (negative) {
+        digits.start++;
+        digits.length--;
+    }
+    uint64_t magnitude;
+    if (!winrun_json_u64(&digits, (uint64_t)INT64_MAX, &magnitude)) {
+        return false;
+    }
+    *out = negative ? -(int64_t)magnitude : (int64_t)magnitude;
+    return true;
+}
+
+bool winrun_json_bool(const winrun_json_value *value, bool *out) {
+    if (!value->start || value->is_string) {
+        return false;
+    }
+    if (value->length == 4 && memcmp(value->start, "true", 4) == 0) {
+        *out = true;
+        return true;
+    }
+    if (value->length == 5 && memcmp(value->start, "false", 5) == 0) {
+        *out = false;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+// Control-port envelopes and the JSON scanner that reads their fields.
+//
+// Envelopes are [type:1][length:4 LE][JSON payload]. The bridge only ever
+// needs a few top-level fields of a payload (a window ID, a message ID), so
+// rather than parsing it the scanner walks the top-level object and skips
+// every other value. Callers treat anything it isn't sure about (escaped
+// strings, missing or out-of-range fields) as "not mine" and leave the
+// envelope for the control callback, which parses the message in full.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define WINRUN_ENVELOPE_HEADER_SIZE 5
+
+// Message types (host: Protocol.generated.swift)
+#define WINRUN_MESSAGE_PING 0x0C
+#define WINRUN_MESSAGE_WINDOW_METADATA 0x80
+#define WINRUN_MESSAGE_HEARTBEAT 0x87
+#define WINRUN_MESSAGE_SESSION_LIST 0x8C
+#define WINRUN_MESSAGE_SHORTCUT_LIST 0x8D
+#define WINRUN_MESSAGE_FRAME_READY 0x8E
+#define WINRUN_MESSAGE_ERROR 0xFE
+#define WINRUN_MESSAGE_ACK 0xFF
+
+// Payload length from an envelope's header (which must be complete).
+static inline uint32_t winrun_envelope_length(const uint8_t *envelope) {
+    return (uint32_t)envelope[1] | (uint32_t)envelope[2] << 8 |
+        (uint32_t)envelope[3] << 16 | (uint32_t)envelope[4] << 24;
+}
+
+// Whether `data` is exactly a run of one or more whole envelopes. A message
+// split across reads is not, and must be passed on unchanged.
+bool winrun_envelopes_are_whole(const uint8_t *data, size_t length);
+
+// A top-level value as it appears in the payload. Strings exclude quotes.
+typedef struct {
+    const uint8_t *start;
+    size_t length;
+    bool is_string;
+    bool escaped;
+} winrun_json_value;
+
+// Fills values[i] for each of `keys` found at the top level of the object;
+// missing keys keep a NULL start. Returns false for malformed payloads.
+bool winrun_json_fields(
+    const uint8_t *payload,
+    size_t length,
+    const char *const *keys,
+    size_t key_count,
+    winrun_json_value *values
+);
+
+// Missing or a literal null.
+bool winrun_json_is_null(const winrun_json_value *value);
+
+// Each conversion returns false unless the value is exactly an integer (or
+// boolean) in range: no fractions, exponents or quotes. Only i64 takes a sign.
+bool winrun_json_u64(const winrun_json_value *value, uint64_t max, uint64_t *out);
+bool winrun_json_i64(const winrun_json_value *value, int64_t *out);
+bool winrun_json_bool(const winrun_json_value *value, bool *out);
@@ -0,0 +1,365 @@
+// Callback executors; see winrun_executor.h.
+
+#include "winrun_executor.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct winrun_executor_event {
+    struct winrun_executor_event *next;
+    const void *owner;
+    winrun_callback_kind kind;
+    union {
+        winrun_spice_frame_cb frame;
+        winrun_spice_metadata_cb metadata;
+        winrun_clipboard_cb clipboard;
+        winrun_control_message_cb control;
+    } cb;
+    void *user_data;
+    union {
+        winrun_spice_window_metadata metadata;
+        winrun_clipboard_data clipboard;
+    } args;
+    size_t length;
+    // Bytes allocated for data; a queued frame is overwritten in place when
+    // the next one fits
+    size_t capacity;
+    uint8_t data[];
+} winrun_executor_event;
+
+struct winrun_executor {
+    pthread_mutex_t mutex;
+    // Signalled after each event a drain runs, for cancel to wait on
+    pthread_cond_t idle;
+    winrun_executor_wakeup_cb wakeup;
+    void *wakeup_user_data;
+    winrun_executor_event *head;
+    winrun_executor_event *tail;
+    // Set by the post that found the queue idle, cleared by the drain that
+    // finds it empty
+    bool awake;
+    // The event a drain is running, if any
+    bool running;
+    pthread_t drain_thread;
+    const void *running_owner;
+    winrun_callback_kind running_kind;
+    winrun_executor_stats stats;
+};
+
+winrun_executor_handle winrun_executor_create(winrun_executor_wakeup_cb wakeup, void *user_data) {
+    winrun_executor_handle executor = calloc(1, sizeof(*executor));
+    if (!executor) {
+        return NULL;
+    }
+    pthread_mutex_init(&executor->mutex, NULL);
+    pthread_cond_init(&executor->idle, NULL);
+    executor->wakeup = wakeup;
+    executor->wakeup_user_data = user_data;
+    return executor;
+}
+
+void winrun_executor_destroy(winrun_executor_handle executor) {
+    if (!executor) {
+        return;
+    }
+    winrun_executor_event *event = executor->head;
+    while (event) {
+        winrun_executor_event *next = event->next;
+        free(event);
+        event = next;
+    }
+    pthread_cond_destroy(&executor->idle);
+    pthread_mutex_destroy(&executor->mutex);
+    free(executor);
+}
+
+// MARK: - Posting
+
+static winrun_executor_event *winrun_executor_event_create(
+    winrun_executor_handle executor,
+    const void *owner,
+    winrun_callback_kind kind,
+    void *user_data,
+    size_t length
+) {
+    winrun_executor_event *event = malloc(sizeof(*event) + length);
+    if (!event) {
+        pthread_mutex_lock(&executor->mutex);
+        executor->stats.dropped++;
+        pthread_mutex_unlock(&executor->mutex);
+        return NULL;
+    }
+    event->next = NULL;
+    event->owner = owner;
+    event->kind = kind;
+    event->user_data = user_data;
+    event->length = length;
+    event->capacity = length;
+    return event;
+}
+
+static void winrun_executor_enqueue(winrun_executor_handle executor, winrun_executor_event *event) {
+    pthread_mutex_lock(&executor->mutex);
+    if (executor->tail) {
+        executor->tail->next = event;
+    } else {
+        executor->head = event;
+    }
+    executor->tail = event;
+    executor->stats.posted++;
+
+    bool wake = !executor->awake;
+    executor->awake = true;
+    if (wake) {
+        executor->stats.wakeups++;
+    }
+    pthread_mutex_unlock(&executor->mutex);
+
+    if (wake && executor->wakeup) {
+        executor->wakeup(executor->wakeup_user_data);
+    }
+}
+
+// The link to `owner`'s queued frame, if it has one. Caller holds the mutex.
+static winrun_executor_event **winrun_executor_find_frame(winrun_executor_handle executor, const void *owner) {
+    for (winrun_executor_event **link = &executor->head; *link; link = &(*link)->next) {
+        if ((*link)->owner == owner && (*link)->kind == WINRUN_CALLBACK_FRAME) {
+            return link;
+        }
+    }
+    return NULL;
+}
+
+bool winrun_executor_post_frame(
+    winrun_executor_handle executor,
+    const void *owner,
+    winrun_spice_frame_cb cb,
+    const uint8_t *data,
+    size_t length,
+    void *user_data
+) {
+    if (!executor || !cb) {
+        return false;
+    }
+
+    // Only the newest frame matters, so a stream keeps at most one queued.
+    // While the consumer lags, each frame overwrites the one still waiting
+    // and no allocation is made.
+    pthread_mutex_lock(&executor->mutex);
+    winrun_executor_event **link = winrun_executor_find_frame(executor, owner);
+    if (link && (*link)->capacity >= length) {
+        winrun_executor_event *queued = *link;
+        queued->cb.frame = cb;
+        queued->user_data = user_data;
+        queued->length = length;
+        if (length > 0) {
+            memcpy(queued->data, data, length);
+        }
+        executor->stats.posted++;
+        executor->stats.coalesced++;
+        pthread_mutex_unlock(&executor->mutex);
+        return true;
+    }
+    pthread_mutex_unlock(&executor->mutex);
+
+    winrun_executor_event *event = winrun_executor_event_create(executor, owner, WINRUN_CALLBACK_FRAME, user_data, length);
+    if (!event) {
+        return false;
+    }
+    event->cb.frame = cb;
+    if (length > 0) {
+        memcpy(event->data, data, length);
+    }
+
+    // Too small to reuse: the new frame takes the old one's place. Look again,
+    // since a drain may have taken it in the meantime.
+    pthread_mutex_lock(&executor->mutex);
+    link = winrun_executor_find_frame(executor, owner);
+    if (link) {
+        winrun_executor_event *replaced = *link;
+        event->next = replaced->next;
+        *link = event;
+        if (executor->tail == replaced) {
+            executor->tail = event;
+        }
+        executor->stats.posted++;
+        executor->stats.coalesced++;
+        pthread_mutex_unlock(&executor->mutex);
+        free(replaced);
+        return true;
+    }
+    pthread_mutex_unlock(&executor->mutex);
+
+    winrun_executor_enqueue(executor, event);
+    return true;
+}
+
+bool winrun_executor_post_metadata(
+    winrun_executor_handle executor,
+    const void *owner,
+    winrun_spice_metadata_cb cb,
+    const winrun_spice_window_metadata *metadata,
+    void *user_data
+) {
+    if (!executor || !cb || !metadata) {
+        return false;
+    }
+    size_t title_length = metadata->title ? strlen(metadata->title) + 1 : 0;
+    winrun_executor_event *event =
+        winrun_executor_event_create(executor, owner, WINRUN_CALLBACK_METADATA, user_data, title_length);
+    if (!event) {
+        return false;
+    }
+    event->cb.metadata = cb;
+    event->args.metadata = *metadata;
+    if (metadata->title) {
+        memcpy(event->data, metadata->title, title_length);
+        event->args.metadata.title = (const char *)event->data;
+    }
+    winrun_executor_enqueue(executor, event);
+    return true;
+}
+
+bool winrun_executor_post_clipboard(
+    winrun_executor_handle executor,
+    const void *owner,
+    winrun_clipboard_cb cb,
+    const winrun_clipboard_data *clipboard,
+    void *user_data
+) {
+    if (!executor || !cb || !clipboard) {
+        return false;
+    }
+    size_t length = clipboard->data ? clipboard->data_length : 0;
+    winrun_executor_event *event =
+        winrun_executor_event_create(executor, owner, WINRUN_CALLBACK_CLIPBOARD, user_data, length);
+    if (!event) {
+        return false;
+    }
+    event->cb.clipboard = cb;
+    event->args.clipboard = *clipboard;
+    event->args.clipboard.data = length > 0 ? event->data : NULL;
+    event->args.clipboard.data_length = length;
+    if (length > 0) {
+        memcpy(event->data, clipboard->data, length);
+    }
+    winrun_executor_enqueue(executor, event);
+    return true;
+}
+
+bool winrun_executor_post_control(
+    winrun_executor_handle executor,
+    const void *owner,
+    winrun_control_message_cb cb,
+    const uint8_t *data,
+    size_t length,
+    void *user_data
+) {
+    if (!executor || !cb) {
+        return false;
+    }
+    winrun_executor_event *event = winrun_executor_event_create(executor, owner, WINRUN_CALLBACK_CONTROL, user_data, length);
+    if (!event) {
+        return false;
+    }
+    event->cb.control = cb;
+    if (length > 0) {
+        memcpy(event->data, data, length);
+    }
+    winrun_executor_enqueue(executor, event);
+    return true;
+}
+
+// MARK: - Draining
+
+static void winrun_executor_run(winrun_executor_event *event) {
+    switch (event->kind) {
+        case WINRUN_CALLBACK_FRAME:
+            event->cb.frame(event->data, event->length, event->user_data);
+            break;
+        case WINRUN_CALLBACK_METADATA:
+            event->cb.metadata(&event->args.metadata, event->user_data);
+            break;
+        case WINRUN_CALLBACK_CLIPBOARD:
+            event->cb.clipboard(&event->args.clipboard, event->user_data);
+            break;
+        case WINRUN_CALLBACK_CONTROL:
+            event->cb.control(event->data, event->length, event->user_data);
+            break;
+    }
+}
+
+size_t winrun_executor_drain(winrun_executor_handle executor) {
+    if (!executor) {
+        return 0;
+    }
+
+    size_t ran = 0;
+    pthread_mutex_lock(&executor->mutex);
+    executor->drain_thread = pthread_self();
+    for (;;) {
+        winrun_executor_event *event = executor->head;
+        if (!event) {
+            executor->awake = false;
+            break;
+        }
+        executor->head = event->next;
+        if (!executor->head) {
+            executor->tail = NULL;
+        }
+        executor->running = true;
+        executor->running_owner = event->owner;
+        executor->running_kind = event->kind;
+        pthread_mutex_unlock(&executor->mutex);
+
+        winrun_executor_run(event);
+        free(event);
+        ran++;
+
+        pthread_mutex_lock(&executor->mutex);
+        executor->running = false;
+        executor->stats.drained++;
+        pthread_cond_broadcast(&executor->idle);
+    }
+    pthread_mutex_unlock(&executor->mutex);
+    return ran;
+}
+
+void winrun_executor_cancel(winrun_executor_handle executor, const void *owner, uint32_t kinds) {
+    if (!executor) {
+        return;
+    }
+
+    pthread_mutex_lock(&executor->mutex);
+    winrun_executor_event **link = &executor->head;
+    executor->tail = NULL;
+    while (*link) {
+        winrun_executor_event *event = *link;
+        if (event->owner == owner && (event->kind & kinds)) {
+            *link = event->next;
+            free(event);
+            executor->stats.dropped++;
+        } else {
+            executor->tail = event;
+            link = &event->next;
+        }
+    }
+
+    // A stream closed from inside its own callback can't wait for it
+    while (executor->running && executor->running_owner == owner && (executor->running_kind & kinds) &&
+           !pthread_equal(executor->drain_thread, pthread_self())) {
+        pthread_cond_wait(&executor->idle, &executor->mutex);
+    }
+    pthread_mutex_unlock(&executor->mutex);
+}
+
+bool winrun_executor_get_stats(winrun_executor_handle executor, winrun_executor_stats *stats) {
+    if (!executor || !stats) {
+        return false;
+    }
+    pthread_mutex_lock(&executor->mutex);
+    *stats = executor->stats;
+    pthread_mutex_unlock(&executor->mutex);
+    return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+// Consumer-owned callback queues (winrun_executor_handle in CSpiceBridge.h).
+//
+// A stream whose callbacks are moved to an executor posts each event here
+// instead of calling the consumer on the bridge thread. The arguments are
+// copied into one allocation per event, except that a stream keeps at most
+// one frame queued: a newer frame overwrites it. Only the post that finds the
+// executor idle calls its wakeup; the consumer then drains every queued
+// event in one pass, and the executor counts as idle again only once a
+// drain has found the queue empty.
+//
+// Events remember the stream that posted them, so a closing stream can take
+// its events back out before its callbacks' user data goes away.
+
+#include "CSpiceBridge.h"
+
+// Each post returns false if the event couldn't be queued; it is counted
+// as dropped.
+
+bool winrun_executor_post_frame(
+    winrun_executor_handle executor,
+    const void *owner,
+    winrun_spice_frame_cb cb,
+    const uint8_t *data,
+    size_t length,
+    void *user_data
+);
+
+bool winrun_executor_post_metadata(
+    winrun_executor_handle executor,
+    const void *owner,
+    winrun_spice_metadata_cb cb,
+    const winrun_spice_window_metadata *metadata,
+    void *user_data
+);
+
+bool winrun_executor_post_clipboard(
+    winrun_executor_handle executor,
+    const void *owner,
+    winrun_clipboard_cb cb,
+    const winrun_clipboard_data *clipboard,
+    void *user_data
+);
+
+bool winrun_executor_post_control(
+    winrun_executor_handle executor,
+    const void *owner,
+    winrun_control_message_cb cb,
+    const uint8_t *data,
+    size_t length,
+    void *user_data
+);
+
+// Drops the queued `kinds` events posted by `owner`, then waits for one of
+// them that a drain is running on another thread to return.
+void winrun_executor_cancel(winrun_executor_handle executor, const void *owner, uint32_t kinds);
@@ -0,0 +1,295 @@
+// Guest heartbeat monitor; see winrun_heartbeat.h.
+
+#include "winrun_heartbeat.h"
+#include "winrun_envelope.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Pings remembered for matching replies; a reply to anything older is stale
+#define WINRUN_HEARTBEAT_PENDING 64
+
+typedef struct {
+    uint32_t sequence;
+    int64_t sent_at_us;
+} winrun_heartbeat_ping;
+
+struct winrun_heartbeat {
+    pthread_mutex_t mutex;
+    // Wakes the monitor thread for a reply after a stall, and when stopping
+    pthread_cond_t wake;
+    pthread_t thread;
+    bool stopping;
+    uint64_t interval_ns;
+    uint64_t stall_ns;
+    winrun_heartbeat_send_fn send;
+    void *send_context;
+    winrun_guest_health_cb health_cb;
+    void *user_data;
+
+    uint64_t next_ping_ns;
+    // Last reply, or the start until there is one
+    uint64_t alive_ns;
+    uint32_t last_sent;
+    uint32_t last_answered;
+    winrun_heartbeat_ping pending[WINRUN_HEARTBEAT_PENDING];
+    // Health as judged now, and as last passed to health_cb
+    winrun_guest_health health;
+    winrun_guest_health reported;
+
+    uint32_t rtt_us[WINRUN_HEARTBEAT_WINDOW];
+    uint32_t rtt_next;
+    uint32_t rtt_count;
+    uint32_t rtt_last_us;
+    double jitter_us;
+    winrun_heartbeat_stats stats;
+};
+
+static uint64_t winrun_heartbeat_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int winrun_heartbeat_compare(const void *a, const void *b) {
+    uint32_t lhs = *(const uint32_t *)a;
+    uint32_t rhs = *(const uint32_t *)b;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+// Must be called with the mutex held. Percentiles are nearest-rank over the
+// sample window, sorted on demand: stats are read far less often than
+// samples arrive.
+static void winrun_heartbeat_snapshot(winrun_heartbeat *heartbeat, uint64_t now_ns, winrun_heartbeat_stats *stats) {
+    *stats = heartbeat->stats;
+    stats->health = heartbeat->health;
+    stats->samples = heartbeat->rtt_count;
+    stats->rtt_last_us = heartbeat->rtt_last_us;
+    stats->jitter_us = (uint32_t)(heartbeat->jitter_us + 0.5);
+    stats->silence_ms = now_ns > heartbeat->alive_ns ? (now_ns - heartbeat->alive_ns) / 1000000ull : 0;
+
+    uint32_t count = heartbeat->rtt_count;
+    if (count == 0) {
+        return;
+    }
+    uint32_t sorted[WINRUN_HEARTBEAT_WINDOW];
+    memcpy(sorted, heartbeat->rtt_us, count * sizeof(sorted[0]));
+    qsort(sorted, count, sizeof(sorted[0]), winrun_heartbeat_compare);
+    stats->rtt_p50_us = sorted[(50 * count + 99) / 100 - 1];
+    stats->rtt_p90_us = sorted[(90 * count + 99) / 100 - 1];
+    stats->rtt_p99_us = sorted[(99 * count + 99) / 100 - 1];
+    stats->rtt_max_us = sorted[count - 1];
+}
+
+// MARK: - Monitor Thread
+
+// Sends the next ping with the mutex released; returns with it held again
+static void winrun_heartbeat_ping_once(winrun_heartbeat *heartbeat, uint64_t now_ns) {
+    uint32_t sequence = ++heartbeat->last_sent;
+    int64_t sent_at_us = (int64_t)(now_ns / 1000ull);
+    heartbeat->pending[sequence % WINRUN_HEARTBEAT_PENDING] = (winrun_heartbeat_ping){ sequence, sent_at_us };
+    // A thread that fell behind skips the pings it missed rather than bursting
+    heartbeat->next_ping_ns += heartbeat->interval_ns;
+    if (heartbeat->next_ping_ns <= now_ns) {
+        heartbeat->next_ping_ns = now_ns + heartbeat->interval_ns;
+    }
+    pthread_mutex_unlock(&heartbeat->mutex);
+
+    uint8_t envelope[WINRUN_ENVELOPE_HEADER_SIZE + 96];
+    int json_length = snprintf(
+        (char *)envelope + WINRUN_ENVELOPE_HEADER_SIZE,
+        sizeof(envelope) - WINRUN_ENVELOPE_HEADER_SIZE,
+        "{\"messageId\":0,\"sequence\":%u,\"sentAt\":%lld}",
+        sequence,
+        (long long)sent_at_us
+    );
+    envelope[0] = WINRUN_MESSAGE_PING;
+    for (int i = 0; i < 4; ++i) {
+        envelope[1 + i] = (uint8_t)((uint32_t)json_length >> (8 * i));
+    }
+    bool sent = heartbeat->send(envelope, WINRUN_ENVELOPE_HEADER_SIZE + (size_t)json_length, heartbeat->send_context);
+
+    pthread_mutex_lock(&heartbeat->mutex);
+    if (sent) {
+        heartbeat->stats.pings_sent++;
+    } else {
+        heartbeat->stats.send_failures++;
+    }
+}
+
+static void *winrun_heartbeat_main(void *context) {
+    winrun_heartbeat *heartbeat = context;
+    pthread_mutex_lock(&heartbeat->mutex);
+    while (!heartbeat->stopping) {
+        uint64_t now_ns = winrun_heartbeat_now_ns();
+        if (heartbeat->health != WINRUN_GUEST_HEALTH_STALLED && now_ns - heartbeat->alive_ns > heartbeat->stall_ns) {
+            heartbeat->health = WINRUN_GUEST_HEALTH_STALLED;
+            heartbeat->stats.stalls++;
+        }
+
+        if (heartbeat->health != heartbeat->reported) {
+            heartbeat->reported = heartbeat->health;
+            winrun_heartbeat_stats stats;
+            winrun_heartbeat_snapshot(heartbeat, now_ns, &stats);
+            if (heartbeat->health_cb) {
+                pthread_mutex_unlock(&heartbeat->mutex);
+                heartbeat->health_cb(stats.health, &stats, heartbeat->user_data);
+                pthread_mutex_lock(&heartbeat->mutex);
+            }
+            continue;
+        }
+
+        if (now_ns >= heartbeat->next_ping_ns) {
+            winrun_heartbeat_ping_once(heartbeat, now_ns);
+            continue;
+        }
+
+        // Sleep to the next ping, or to the deadline if that comes first.
+        // Condition variables wait on the realtime clock (macOS has no
+        // monotonic variant).
+        uint64_t wake_at_ns = heartbeat->next_ping_ns;
+        if (heartbeat->health != WINRUN_GUEST_HEALTH_STALLED) {
+            uint64_t stall_at_ns = heartbeat->alive_ns + heartbeat->stall_ns + 1;
+            if (stall_at_ns < wake_at_ns) {
+                wake_at_ns = stall_at_ns;
+            }
+        }
+        if (wake_at_ns > now_ns) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            uint64_t wake_ns = (uint64_t)deadline.tv_nsec + (wake_at_ns - now_ns);
+            deadline.tv_sec += (time_t)(wake_ns / 1000000000ull);
+            deadline.tv_nsec = (long)(wake_ns % 1000000000ull);
+            pthread_cond_timedwait(&heartbeat->wake, &heartbeat->mutex, &deadline);
+        }
+    }
+    pthread_mutex_unlock(&heartbeat->mutex);
+    return NULL;
+}
+
+// MARK: - Lifecycle
+
+winrun_heartbeat *winrun_heartbeat_create(
+    uint32_t interval_ms,
+    uint32_t stall_after_ms,
+    winrun_heartbeat_send_fn send,
+    void *send_context,
+    winrun_guest_health_cb health_cb,
+    void *user_data
+) {
+    if (!send) {
+        return NULL;
+    }
+    winrun_heartbeat *heartbeat = calloc(1, sizeof(*heartbeat));
+    if (!heartbeat) {
+        return NULL;
+    }
+
+    if (interval_ms == 0) {
+        interval_ms = WINRUN_HEARTBEAT_DEFAULT_INTERVAL_MS;
+    }
+    if (stall_after_ms == 0) {
+        stall_after_ms = 3 * interval_ms;
+    }
+    heartbeat->interval_ns = (uint64_t)interval_ms * 1000000ull;
+    heartbeat->stall_ns = (uint64_t)stall_after_ms * 1000000ull;
+    heartbeat->send = send;
+    heartbeat->send_context = send_context;
+    heartbeat->health_cb = health_cb;
+    heartbeat->user_data = user_data;
+    heartbeat->health = WINRUN_GUEST_HEALTH_UNKNOWN;
+    heartbeat->reported = WINRUN_GUEST_HEALTH_UNKNOWN;
+    heartbeat->alive_ns = winrun_heartbeat_now_ns();
+    heartbeat->next_ping_ns = heartbeat->alive_ns;
+
+    pthread_mutex_init(&heartbeat->mutex, NULL);
+    pthread_cond_init(&heartbeat->wake, NULL);
+    if (pthread_create(&heartbeat->thread, NULL, winrun_heartbeat_main, heartbeat) != 0) {
+        pthread_cond_destroy(&heartbeat->wake);
+        pthread_mutex_destroy(&heartbeat->mutex);
+        free(heartbeat);
+        return NULL;
+    }
+    return heartbeat;
+}
+
+void winrun_heartbeat_destroy(winrun_heartbeat *heartbeat) {
+    if (!heartbeat) {
+        return;
+    }
+
+    pthread_mutex_lock(&heartbeat->mutex);
+    heartbeat->stopping = true;
+    pthread_cond_signal(&heartbeat->wake);
+    pthread_mutex_unlock(&heartbeat->mutex);
+    pthread_join(heartbeat->thread, NULL);
+
+    pthread_cond_destroy(&heartbeat->wake);
+    pthread_mutex_destroy(&heartbeat->mutex);
+    free(heartbeat);
+}
+
+// MARK: - Replies
+
+bool winrun_heartbeat_receive(winrun_heartbeat *heartbeat, const uint8_t *envelope, size_t length) {
+    if (!heartbeat || length < WINRUN_ENVELOPE_HEADER_SIZE || envelope[0] != WINRUN_MESSAGE_HEARTBEAT) {
+        return false;
+    }
+
+    // Periodic heartbeats carry no ping fields and go on to the control callback
+    static const char *const keys[] = { "pingSequence", "pingSentAt" };
+    winrun_json_value values[2];
+    uint64_t sequence;
+    int64_t sent_at_us;
+    if (!winrun_json_fields(envelope + WINRUN_ENVELOPE_HEADER_SIZE, length - WINRUN_ENVELOPE_HEADER_SIZE, keys, 2, values) ||
+        !winrun_json_u64(&values[0], UINT32_MAX, &sequence) ||
+        !winrun_json_i64(&values[1], &sent_at_us)) {
+        return false;
+    }
+
+    uint64_t now_ns = winrun_heartbeat_now_ns();
+    pthread_mutex_lock(&heartbeat->mutex);
+    const winrun_heartbeat_ping *ping = &heartbeat->pending[sequence % WINRUN_HEARTBEAT_PENDING];
+    // Only replies newer than the last answered ping, to a ping still
+    // remembered, count; anything else is late, duplicated or forged
+    bool fresh = sequence > heartbeat->last_answered && sequence <= heartbeat->last_sent &&
+        ping->sequence == sequence && ping->sent_at_us == sent_at_us;
+    if (!fresh) {
+        heartbeat->stats.stale_replies++;
+        pthread_mutex_unlock(&heartbeat->mutex);
+        return true;
+    }
+
+    int64_t elapsed_us = (int64_t)(now_ns / 1000ull) - sent_at_us;
+    uint32_t rtt_us = elapsed_us <= 0 ? 0 : elapsed_us >= UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed_us;
+    if (heartbeat->stats.replies > 0) {
+        // RFC 3550's interarrival jitter estimator, over consecutive RTTs
+        double delta = (double)rtt_us - (double)heartbeat->rtt_last_us;
+        heartbeat->jitter_us += ((delta < 0 ? -delta : delta) - heartbeat->jitter_us) / 16.0;
+    }
+    heartbeat->rtt_last_us = rtt_us;
+    heartbeat->rtt_us[heartbeat->rtt_next] = rtt_us;
+    heartbeat->rtt_next = (heartbeat->rtt_next + 1) % WINRUN_HEARTBEAT_WINDOW;
+    if (heartbeat->rtt_count < WINRUN_HEARTBEAT_WINDOW) {
+        heartbeat->rtt_count++;
+    }
+    heartbeat->stats.replies++;
+    heartbeat->last_answered = (uint32_t)sequence;
+    heartbeat->alive_ns = now_ns;
+    if (heartbeat->health != WINRUN_GUEST_HEALTH_HEALTHY) {
+        heartbeat->health = WINRUN_GUEST_HEALTH_HEALTHY;
+        pthread_cond_signal(&heartbeat->wake);
+    }
+    pthread_mutex_unlock(&heartbeat->mutex);
+    return true;
+}
+
+void winrun_heartbeat_get_stats(winrun_heartbeat *heartbeat, winrun_heartbeat_stats *stats) {
+    uint64_t now_ns = winrun_heartbeat_now_ns();
+    pthread_mutex_lock(&heartbeat->mutex);
+    winrun_heartbeat_snapshot(heartbeat, now_ns, stats);
+    pthread_mutex_unlock(&heartbeat->mutex);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+// Heartbeat monitor behind winrun_spice_stream_start_heartbeat.
+//
+// A monitor thread sends a Ping envelope through `send` every interval:
+// {"messageId":0,"sequence":n,"sentAt":µs}, with sentAt read from the host's
+// monotonic clock. The guest answers each ping with a Heartbeat that echoes
+// pingSequence and pingSentAt, and the control port's reader hands those to
+// winrun_heartbeat_receive, which turns them into RTT samples against the
+// same clock. The guest's clock is never involved.
+//
+// The same thread watches the time since the last reply. Once it passes the
+// stall deadline the guest is reported STALLED; the next reply wakes the
+// thread to report it HEALTHY again. Health callbacks only ever run on the
+// monitor thread, never on the reader.
+
+#include "CSpiceBridge.h"
+
+#define WINRUN_HEARTBEAT_DEFAULT_INTERVAL_MS 1000
+// RTT samples kept for percentiles; older ones drop out
+#define WINRUN_HEARTBEAT_WINDOW 128
+
+// Sends one envelope to the guest. Returns false if it couldn't be sent.
+typedef bool (*winrun_heartbeat_send_fn)(const uint8_t *envelope, size_t length, void *context);
+
+typedef struct winrun_heartbeat winrun_heartbeat;
+
+// Starts the monitor thread; the first ping goes out at once. An interval of
+// 0 uses WINRUN_HEARTBEAT_DEFAULT_INTERVAL_MS and a stall deadline of 0
+// three intervals. Returns NULL if `send` is NULL or the thread can't start.
+winrun_heartbeat *winrun_heartbeat_create(
+    uint32_t interval_ms,
+    uint32_t stall_after_ms,
+    winrun_heartbeat_send_fn send,
+    void *send_context,
+    winrun_guest_health_cb health_cb,
+    void *user_data
+);
+
+// Stops the thread and frees the monitor. Must not be called from its
+// health callback, or while winrun_heartbeat_receive may still be running.
+void winrun_heartbeat_destroy(winrun_heartbeat *heartbeat);
+
+// Takes one whole envelope from the control port. Returns true if it was a
+// reply to a ping (sampled or, if stale, dropped), which goes no further.
+bool winrun_heartbeat_receive(winrun_heartbeat *heartbeat, const uint8_t *envelope, size_t length);
+
+void winrun_heartbeat_get_stats(winrun_heartbeat *heartbeat, winrun_heartbeat_stats *stats);
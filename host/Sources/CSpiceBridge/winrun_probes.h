@@ -0,0 +1,126 @@
+#pragma once
+
+// Static probe points (USDT) for production tracing.
+//
+// Probes are emitted under the `winrun` provider so they can be enabled with
+// DTrace on macOS or bpftrace/uprobes on Linux without attaching a debugger:
+//
+//   sudo dtrace -n 'winrun$target:::frame-deliver { @[arg0] = quantize(arg2); }' -p <pid>
+//   sudo bpftrace -p <pid> host/Scripts/tracing/frame-latency.bt
+//
+// When <sys/sdt.h> is unavailable (or WINRUN_DISABLE_PROBES is defined) every
+// probe compiles to nothing, including the timestamp reads that feed latency
+// arguments. When probes are compiled in, those reads are still skipped until
+// a tracer attaches: WINRUN_PROBE_START checks the probe's is-enabled flag (a
+// semaphore with systemtap's sdt.h, an is-enabled site with DTrace). Probe
+// names and argument order are a stable interface; add new probes rather than
+// changing existing ones. See docs/decisions/spice-bridge.md.
+//
+// Probe names are declared with double underscores (frame__deliver); DTrace
+// shows them with dashes (frame-deliver), bpftrace uses the declared name.
+//
+// | Probe             | arg0      | arg1          | arg2                  |
+// |-------------------|-----------|---------------|-----------------------|
+// | stream-open       | window_id | transport     | -                     |
+// | stream-close      | window_id | lifetime (ns) | -                     |
+// | stream-resume     | window_id | resume (ns)   | -                     |
+// | stream-visibility | window_id | visibility    | max fps               |
+// | frame-throttle    | window_id | visibility    | size (bytes)          |
+// | frame-deliver     | window_id | size (bytes)  | callback latency (ns) |
+// | input-send        | window_id | input kind    | send latency (ns)     |
+// | control-recv      | window_id | size (bytes)  | callback latency (ns) |
+// | control-send      | window_id | size (bytes)  | send latency (ns)     |
+// | clipboard-send    | window_id | format        | size (bytes)          |
+// | clipboard-recv    | window_id | format        | size (bytes)          |
+
+#include <stdint.h>
+#include <time.h>
+
+#if !defined(WINRUN_DISABLE_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+// Asks systemtap's sdt.h for per-probe semaphores; DTrace's ignores it
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+#define WINRUN_PROBES_ENABLED 1
+#endif
+#endif
+
+#ifndef WINRUN_PROBES_ENABLED
+#define WINRUN_PROBES_ENABLED 0
+#endif
+
+// Values for the stream-open `transport` argument
+#define WINRUN_PROBE_TRANSPORT_TCP 0
+#define WINRUN_PROBE_TRANSPORT_SHARED 1
+
+// Values for the input-send `input kind` argument
+#define WINRUN_PROBE_INPUT_MOUSE 0
+#define WINRUN_PROBE_INPUT_KEYBOARD 1
+#define WINRUN_PROBE_INPUT_DRAG 2
+
+// Every probe, for the is-enabled flags below
+#define WINRUN_PROBE_NAMES(X) \
+    X(stream__open) X(stream__close) X(stream__resume) X(stream__visibility) \
+    X(frame__throttle) X(frame__deliver) X(input__send) X(control__recv) \
+    X(control__send) X(clipboard__send) X(clipboard__recv)
+
+#if WINRUN_PROBES_ENABLED && defined(STAP_PROBE)
+// Tracers raise a probe's semaphore while attached to it
+#define WINRUN_PROBE_SEMAPHORE(name) \
+    __extension__ static volatile unsigned short winrun_##name##_semaphore \
+        __attribute__((unused, used, section(".probes")));
+WINRUN_PROBE_NAMES(WINRUN_PROBE_SEMAPHORE)
+#undef WINRUN_PROBE_SEMAPHORE
+#define WINRUN_PROBE_ENABLED(name) __builtin_expect(winrun_##name##_semaphore != 0, 0)
+#elif WINRUN_PROBES_ENABLED && defined(__APPLE__)
+// The linker patches these calls to return whether DTrace has the probe enabled,
+// as it does for the _ENABLED() macros `dtrace -h` generates
+#define WINRUN_PROBE_ISENABLED(name) extern int __dtrace_isenabled$winrun$##name##$v1(void);
+WINRUN_PROBE_NAMES(WINRUN_PROBE_ISENABLED)
+#undef WINRUN_PROBE_ISENABLED
+#define WINRUN_PROBE_ENABLED(name) __builtin_expect(__dtrace_isenabled$winrun$##name##$v1() != 0, 0)
+#elif WINRUN_PROBES_ENABLED
+// No is-enabled flag to check; latency arguments are always measured
+#define WINRUN_PROBE_ENABLED(name) 1
+#else
+#define WINRUN_PROBE_ENABLED(name) 0
+#endif
+
+#if WINRUN_PROBES_ENABLED
+#define WINRUN_PROBE1(name, a0) \
+    DTRACE_PROBE1(winrun, name, (uint64_t)(a0))
+#define WINRUN_PROBE2(name, a0, a1) \
+    DTRACE_PROBE2(winrun, name, (uint64_t)(a0), (uint64_t)(a1))
+#define WINRUN_PROBE3(name, a0, a1, a2) \
+    DTRACE_PROBE3(winrun, name, (uint64_t)(a0), (uint64_t)(a1), (uint64_t)(a2))
+#else
+// sizeof() keeps the arguments "used" without evaluating them
+#define WINRUN_PROBE1(name, a0) \
+    do { (void)sizeof(a0); } while (0)
+#define WINRUN_PROBE2(name, a0, a1) \
+    do { (void)sizeof(a0); (void)sizeof(a1); } while (0)
+#define WINRUN_PROBE3(name, a0, a1, a2) \
+    do { (void)sizeof(a0); (void)sizeof(a1); (void)sizeof(a2); } while (0)
+#endif
+
+// Monotonic timestamp for probe latency arguments. Returns 0 when probes are
+// compiled out so callers don't pay for clock reads nobody will see.
+static inline uint64_t winrun_probe_now_ns(void) {
+#if WINRUN_PROBES_ENABLED
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+// Start time for a latency argument of probe `name`, or 0 while no tracer
+// has it enabled
+#define WINRUN_PROBE_START(name) (WINRUN_PROBE_ENABLED(name) ? winrun_probe_now_ns() : 0)
+
+// Time since a WINRUN_PROBE_START, without reading the clock if it was 0. A
+// tracer that attaches in between sees a latency of 0 for that one call.
+static inline uint64_t winrun_probe_since_ns(uint64_t start_ns) {
+    return start_ns ? winrun_probe_now_ns() - start_ns : 0;
+}
@@ -0,0 +1,476 @@
+// Control request tracking; see "Control Requests" in CSpiceBridge.h.
+//
+// In-flight requests live in a chained hash table keyed by message ID and on
+// a hashed timer wheel: WINRUN_REQUEST_WHEEL_SLOTS lists, one per tick, with
+// a request due at tick t in slot t % slots. The timer thread visits the
+// slots as ticks pass and expires the requests that are due, leaving those
+// that are a revolution or more away. Starting, completing and cancelling a
+// request are all O(1), there is no timer per request, and the thread
+// sleeps while nothing is in flight.
+
+#include "CSpiceBridge.h"
+#include "winrun_envelope.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define WINRUN_REQUEST_TICK_MS 10
+#define WINRUN_REQUEST_TICK_NS (WINRUN_REQUEST_TICK_MS * 1000000ull)
+// 5.12 s per revolution covers the usual timeouts without a second lap
+#define WINRUN_REQUEST_WHEEL_SLOTS 512
+#define WINRUN_REQUEST_MIN_BUCKETS 64
+
+typedef struct winrun_request {
+    uint32_t message_id;
+    uint64_t due_tick;
+    winrun_request_cb cb;
+    void *user_data;
+    // Hash chain while in flight; free list and expiry list afterwards
+    struct winrun_request *next;
+    struct winrun_request *wheel_prev;
+    struct winrun_request *wheel_next;
+} winrun_request;
+
+struct winrun_request_tracker {
+    pthread_mutex_t mutex;
+    // Wakes the timer thread for its first request and when stopping
+    pthread_cond_t wake;
+    pthread_t timer_thread;
+    bool timer_started;
+    bool stopping;
+    uint64_t origin_ns;
+    // Last tick the timer thread has visited
+    uint64_t tick;
+    uint32_t next_id;
+    winrun_request **buckets;
+    size_t bucket_count;
+    winrun_request *wheel[WINRUN_REQUEST_WHEEL_SLOTS];
+    // Ended requests, reused by later ones; never longer than the most that
+    // were ever in flight at once
+    winrun_request *free_list;
+    winrun_request_stats stats;
+};
+
+static uint64_t winrun_request_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t winrun_request_now_tick(winrun_request_tracker_handle tracker) {
+    return (winrun_request_now_ns() - tracker->origin_ns) / WINRUN_REQUEST_TICK_NS;
+}
+
+// MARK: - Table and Wheel
+
+// All of these must be called with the tracker mutex held.
+
+static winrun_request **winrun_request_bucket(winrun_request_tracker_handle tracker, uint32_t message_id) {
+    // IDs are sequential, so the low bits spread them evenly
+    return &tracker->buckets[message_id & (tracker->bucket_count - 1)];
+}
+
+static winrun_request *winrun_request_find(winrun_request_tracker_handle tracker, uint32_t message_id) {
+    if (!tracker->buckets) {
+        return NULL;
+    }
+    winrun_request *request = *winrun_request_bucket(tracker, message_id);
+    while (request && request->message_id != message_id) {
+        request = request->next;
+    }
+    return request;
+}
+
+// Keeps at most one request per bucket on average
+static bool winrun_request_reserve(winrun_request_tracker_handle tracker) {
+    if (tracker->buckets && tracker->stats.in_flight < tracker->bucket_count) {
+        return true;
+    }
+    size_t count = tracker->buckets ? tracker->bucket_count * 2 : WINRUN_REQUEST_MIN_BUCKETS;
+    winrun_request **buckets = calloc(count, sizeof(*buckets));
+    if (!buckets) {
+        return false;
+    }
+    for (size_t i = 0; i < tracker->bucket_count; ++i) {
+        winrun_request *request = tracker->buckets[i];
+        while (request) {
+            winrun_request *next = request->next;
+            winrun_request **bucket = &buckets[request->message_id & (count - 1)];
+            request->next = *bucket;
+            *bucket = request;
+            request = next;
+        }
+    }
+    free(tracker->buckets);
+    tracker->buckets = buckets;
+    tracker->bucket_count = count;
+    return true;
+}
+
+static void winrun_request_link(winrun_request_tracker_handle tracker, winrun_request *request) {
+    winrun_request **bucket = winrun_request_bucket(tracker, request->message_id);
+    request->next = *bucket;
+    *bucket = request;
+
+    winrun_request **slot = &tracker->wheel[request->due_tick % WINRUN_REQUEST_WHEEL_SLOTS];
+    request->wheel_prev = NULL;
+    request->wheel_next = *slot;
+    if (*slot) {
+        (*slot)->wheel_prev = request;
+    }
+    *slot = request;
+    tracker->stats.in_flight++;
+}
+
+// Takes a request out of the table and off the wheel; it has ended
+static void winrun_request_unlink(winrun_request_tracker_handle tracker, winrun_request *request) {
+    winrun_request **link = winrun_request_bucket(tracker, request->message_id);
+    while (*link != request) {
+        link = &(*link)->next;
+    }
+    *link = request->next;
+    request->next = NULL;
+
+    if (request->wheel_prev) {
+        request->wheel_prev->wheel_next = request->wheel_next;
+    } else {
+        tracker->wheel[request->due_tick % WINRUN_REQUEST_WHEEL_SLOTS] = request->wheel_next;
+    }
+    if (request->wheel_next) {
+        request->wheel_next->wheel_prev = request->wheel_prev;
+    }
+    tracker->stats.in_flight--;
+}
+
+static void winrun_request_recycle(winrun_request_tracker_handle tracker, winrun_request *request) {
+    request->next = tracker->free_list;
+    tracker->free_list = request;
+}
+
+// MARK: - Timer Thread
+
+// Unlinks every request due by `now` into a list, visiting each slot whose
+// tick has passed since the last call (all of them after a long stall)
+static winrun_request *winrun_request_expire(winrun_request_tracker_handle tracker, uint64_t now) {
+    winrun_request *expired = NULL;
+    uint64_t steps = now - tracker->tick;
+    if (steps > WINRUN_REQUEST_WHEEL_SLOTS) {
+        steps = WINRUN_REQUEST_WHEEL_SLOTS;
+    }
+    for (uint64_t step = 1; step <= steps; ++step) {
+        winrun_request *request = tracker->wheel[(tracker->tick + step) % WINRUN_REQUEST_WHEEL_SLOTS];
+        while (request) {
+            winrun_request *next = request->wheel_next;
+            if (request->due_tick <= now) {
+                winrun_request_unlink(tracker, request);
+                request->next = expired;
+                expired = request;
+            }
+            request = next;
+        }
+    }
+    tracker->tick = now;
+    return expired;
+}
+
+static void *winrun_request_timer_main(void *context) {
+    winrun_request_tracker_handle tracker = context;
+    pthread_mutex_lock(&tracker->mutex);
+    while (!tracker->stopping) {
+        if (tracker->stats.in_flight == 0) {
+            pthread_cond_wait(&tracker->wake, &tracker->mutex);
+            continue;
+        }
+
+        winrun_request *expired = winrun_request_expire(tracker, winrun_request_now_tick(tracker));
+        if (expired) {
+            pthread_mutex_unlock(&tracker->mutex);
+            size_t count = 0;
+            for (winrun_request *request = expired; request; request = request->next) {
+                request->cb(request->message_id, WINRUN_REQUEST_TIMED_OUT, NULL, 0, request->user_data);
+                count++;
+            }
+            pthread_mutex_lock(&tracker->mutex);
+            while (expired) {
+                winrun_request *next = expired->next;
+                winrun_request_recycle(tracker, expired);
+                expired = next;
+            }
+            tracker->stats.timed_out += count;
+            continue;
+        }
+
+        // Sleep to the start of the next tick. Condition variables wait on
+        // the realtime clock (macOS has no monotonic variant).
+        uint64_t next_ns = tracker->origin_ns + (tracker->tick + 1) * WINRUN_REQUEST_TICK_NS;
+        uint64_t now_ns = winrun_request_now_ns();
+        if (next_ns > now_ns) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            uint64_t wake_ns = (uint64_t)deadline.tv_nsec + (next_ns - now_ns);
+            deadline.tv_sec += (time_t)(wake_ns / 1000000000ull);
+            deadline.tv_nsec = (long)(wake_ns % 1000000000ull);
+            pthread_cond_timedwait(&tracker->wake, &tracker->mutex, &deadline);
+        }
+    }
+    pthread_mutex_unlock(&tracker->mutex);
+    return NULL;
+}
+
+// MARK: - Lifecycle
+
+winrun_request_tracker_handle winrun_request_tracker_create(void) {
+    winrun_request_tracker_handle tracker = calloc(1, sizeof(*tracker));
+    if (!tracker) {
+        return NULL;
+    }
+    pthread_mutex_init(&tracker->mutex, NULL);
+    pthread_cond_init(&tracker->wake, NULL);
+    tracker->origin_ns = winrun_request_now_ns();
+    return tracker;
+}
+
+void winrun_request_tracker_destroy(winrun_request_tracker_handle tracker) {
+    if (!tracker) {
+        return;
+    }
+
+    pthread_mutex_lock(&tracker->mutex);
+    tracker->stopping = true;
+    pthread_cond_signal(&tracker->wake);
+    pthread_mutex_unlock(&tracker->mutex);
+    if (tracker->timer_started) {
+        pthread_join(tracker->timer_thread, NULL);
+    }
+
+    winrun_request_cancel_all(tracker);
+    while (tracker->free_list) {
+        winrun_request *next = tracker->free_list->next;
+        free(tracker->free_list);
+        tracker->free_list = next;
+    }
+    free(tracker->buckets);
+    pthread_cond_destroy(&tracker->wake);
+    pthread_mutex_destroy(&tracker->mutex);
+    free(tracker);
+}
+
+// MARK: - Requests
+
+uint32_t winrun_request_begin(
+    winrun_request_tracker_handle tracker,
+    uint32_t timeout_ms,
+    winrun_request_cb cb,
+    void *user_data
+) {
+    if (!tracker || !cb) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&tracker->mutex);
+    if (tracker->stopping || !winrun_request_reserve(tracker)) {
+        pthread_mutex_unlock(&tracker->mutex);
+        return 0;
+    }
+    if (!tracker->timer_started) {
+        if (pthread_create(&tracker->timer_thread, NULL, winrun_request_timer_main, tracker) != 0) {
+            pthread_mutex_unlock(&tracker->mutex);
+            return 0;
+        }
+        tracker->timer_started = true;
+    }
+    winrun_request *request = tracker->free_list;
+    if (request) {
+        tracker->free_list = request->next;
+    } else if (!(request = malloc(sizeof(*request)))) {
+        pthread_mutex_unlock(&tracker->mutex);
+        return 0;
+    }
+
+    // Skip 0 and, after wrapping, IDs that are still waiting
+    do {
+        tracker->next_id++;
+    } while (tracker->next_id == 0 || winrun_request_find(tracker, tracker->next_id));
+
+    uint64_t now = winrun_request_now_tick(tracker);
+    if (tracker->stats.in_flight == 0) {
+        // The timer thread was idle; nothing is behind it
+        tracker->tick = now;
+    }
+    uint64_t ticks = ((uint64_t)timeout_ms + WINRUN_REQUEST_TICK_MS - 1) / WINRUN_REQUEST_TICK_MS;
+    request->message_id = tracker->next_id;
+    request->due_tick = now + (ticks > 0 ? ticks : 1);
+    request->cb = cb;
+    request->user_data = user_data;
+    winrun_request_link(tracker, request);
+    tracker->stats.started++;
+    if (tracker->stats.in_flight == 1) {
+        pthread_cond_signal(&tracker->wake);
+    }
+
+    uint32_t message_id = request->message_id;
+    pthread_mutex_unlock(&tracker->mutex);
+    return message_id;
+}
+
+bool winrun_request_complete(
+    winrun_request_tracker_handle tracker,
+    uint32_t message_id,
+    const uint8_t *response,
+    size_t length
+) {
+    if (!tracker) {
+        return false;
+    }
+
+    pthread_mutex_lock(&tracker->mutex);
+    winrun_request *request = winrun_request_find(tracker, message_id);
+    if (!request) {
+        pthread_mutex_unlock(&tracker->mutex);
+        return false;
+    }
+    winrun_request_unlink(tracker, request);
+    pthread_mutex_unlock(&tracker->mutex);
+
+    request->cb(message_id, WINRUN_REQUEST_COMPLETED, response, length, request->user_data);
+
+    pthread_mutex_lock(&tracker->mutex);
+    winrun_request_recycle(tracker, request);
+    tracker->stats.completed++;
+    pthread_mutex_unlock(&tracker->mutex);
+    return true;
+}
+
+bool winrun_request_cancel(winrun_request_tracker_handle tracker, uint32_t message_id, void **user_data) {
+    if (!tracker) {
+        return false;
+    }
+
+    pthread_mutex_lock(&tracker->mutex);
+    winrun_request *request = winrun_request_find(tracker, message_id);
+    if (request) {
+        winrun_request_unlink(tracker, request);
+        if (user_data) {
+            *user_data = request->user_data;
+        }
+        winrun_request_recycle(tracker, request);
+    }
+    pthread_mutex_unlock(&tracker->mutex);
+    return request != NULL;
+}
+
+size_t winrun_request_cancel_all(winrun_request_tracker_handle tracker) {
+    if (!tracker) {
+        return 0;
+    }
+
+    winrun_request *cancelled = NULL;
+    pthread_mutex_lock(&tracker->mutex);
+    for (size_t i = 0; i < WINRUN_REQUEST_WHEEL_SLOTS; ++i) {
+        while (tracker->wheel[i]) {
+            winrun_request *request = tracker->wheel[i];
+            winrun_request_unlink(tracker, request);
+            request->next = cancelled;
+            cancelled = request;
+        }
+    }
+    pthread_mutex_unlock(&tracker->mutex);
+
+    size_t count = 0;
+    for (winrun_request *request = cancelled; request; request = request->next) {
+        request->cb(request->message_id, WINRUN_REQUEST_CANCELLED, NULL, 0, request->user_data);
+        count++;
+    }
+
+    pthread_mutex_lock(&tracker->mutex);
+    while (cancelled) {
+        winrun_request *next = cancelled->next;
+        winrun_request_recycle(tracker, cancelled);
+        cancelled = next;
+    }
+    tracker->stats.cancelled += count;
+    pthread_mutex_unlock(&tracker->mutex);
+    return count;
+}
+
+bool winrun_request_tracker_get_stats(winrun_request_tracker_handle tracker, winrun_request_stats *stats) {
+    if (!tracker || !stats) {
+        return false;
+    }
+    pthread_mutex_lock(&tracker->mutex);
+    *stats = tracker->stats;
+    pthread_mutex_unlock(&tracker->mutex);
+    return true;
+}
+
+// MARK: - Responses
+
+// The ID a response envelope answers, if it is one
+static bool winrun_request_response_id(uint8_t type, const uint8_t *payload, size_t length, uint32_t *message_id) {
+    static const char *const message_id_key[] = { "messageId" };
+    static const char *const related_id_key[] = { "relatedMessageId" };
+    const char *const *keys;
+    switch (type) {
+        case WINRUN_MESSAGE_SESSION_LIST:
+        case WINRUN_MESSAGE_SHORTCUT_LIST:
+        case WINRUN_MESSAGE_ACK:
+            keys = message_id_key;
+            break;
+        case WINRUN_MESSAGE_ERROR:
+            keys = related_id_key;
+            break;
+        default:
+            return false;
+    }
+
+    winrun_json_value value;
+    uint64_t id;
+    if (!winrun_json_fields(payload, length, keys, 1, &value) || !winrun_json_u64(&value, UINT32_MAX, &id)) {
+        return false;
+    }
+    *message_id = (uint32_t)id;
+    return true;
+}
+
+size_t winrun_request_tracker_match(
+    winrun_request_tracker_handle tracker,
+    const uint8_t *data,
+    size_t length,
+    winrun_control_message_cb fallback,
+    void *fallback_user_data
+) {
+    if (!data || length == 0) {
+        return 0;
+    }
+
+    bool idle = true;
+    if (tracker) {
+        pthread_mutex_lock(&tracker->mutex);
+        idle = tracker->stats.in_flight == 0;
+        pthread_mutex_unlock(&tracker->mutex);
+    }
+    if (idle || !winrun_envelopes_are_whole(data, length)) {
+        if (fallback) {
+            fallback(data, length, fallback_user_data);
+        }
+        return 0;
+    }
+
+    size_t completed = 0;
+    for (size_t offset = 0; offset < length;) {
+        const uint8_t *envelope = data + offset;
+        size_t payload_length = winrun_envelope_length(envelope);
+        size_t envelope_length = WINRUN_ENVELOPE_HEADER_SIZE + payload_length;
+        uint32_t message_id;
+        if (winrun_request_response_id(envelope[0], envelope + WINRUN_ENVELOPE_HEADER_SIZE, payload_length, &message_id) &&
+            winrun_request_complete(tracker, message_id, envelope, envelope_length)) {
+            completed++;
+        } else if (fallback) {
+            fallback(envelope, envelope_length, fallback_user_data);
+        }
+        offset += envelope_length;
+    }
+    return completed;
+}
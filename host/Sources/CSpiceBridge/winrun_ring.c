@@ -0,0 +1,57 @@
+// Index access for shared frame buffer rings (host: SharedFrameBuffer.swift).
+//
+// Header, little-endian u32 fields at fixed offsets (64 bytes in all):
+//   [magic][version][totalSize][slotCount][slotSize][maxWidth][maxHeight]
+//   [writeIndex][readIndex][flags][reserved...]
+// The guest writes a slot, then advances writeIndex; the host reads slots,
+// then advances readIndex. The loads and stores here are the ordering the
+// two sides agree on: a slot is only read after the write index covering it
+// was loaded with acquire ordering, and only handed back by a release store.
+
+#include "CSpiceBridge.h"
+
+#define WINRUN_RING_HEADER_SIZE 64
+#define WINRUN_RING_SLOT_COUNT_OFFSET 12
+#define WINRUN_RING_WRITE_INDEX_OFFSET 28
+#define WINRUN_RING_READ_INDEX_OFFSET 32
+
+static inline uint32_t *winrun_ring_field(const void *ring, size_t offset) {
+    return (uint32_t *)((uint8_t *)ring + offset);
+}
+
+bool winrun_ring_pending(const void *ring, size_t size, winrun_ring_span *span) {
+    if (!ring || !span || size < WINRUN_RING_HEADER_SIZE) {
+        return false;
+    }
+
+    uint32_t slot_count = __atomic_load_n(winrun_ring_field(ring, WINRUN_RING_SLOT_COUNT_OFFSET), __ATOMIC_RELAXED);
+    uint32_t write_index = __atomic_load_n(winrun_ring_field(ring, WINRUN_RING_WRITE_INDEX_OFFSET), __ATOMIC_ACQUIRE);
+    // Only the host stores the read index
+    uint32_t read_index = __atomic_load_n(winrun_ring_field(ring, WINRUN_RING_READ_INDEX_OFFSET), __ATOMIC_RELAXED);
+    if (slot_count == 0 || write_index >= slot_count || read_index >= slot_count) {
+        return false;
+    }
+
+    span->first = read_index;
+    span->pending = (write_index + slot_count - read_index) % slot_count;
+    span->latest = (write_index + slot_count - 1) % slot_count;
+    span->slot_count = slot_count;
+    return true;
+}
+
+uint32_t winrun_ring_release(void *ring, size_t size, uint32_t count) {
+    winrun_ring_span span;
+    if (count == 0 || !winrun_ring_pending(ring, size, &span)) {
+        return 0;
+    }
+
+    if (count > span.pending) {
+        count = span.pending;
+    }
+    __atomic_store_n(
+        winrun_ring_field(ring, WINRUN_RING_READ_INDEX_OFFSET),
+        (span.first + count) % span.slot_count,
+        __ATOMIC_RELEASE
+    );
+    return count;
+}
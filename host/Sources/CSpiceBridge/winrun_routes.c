@@ -0,0 +1,329 @@
+// Per-window routing of control-port notifications; see winrun_routes.h.
+//
+// Only the top-level fields a route needs are pulled out of the payload
+// (winrun_envelope.h). Anything the scanner isn't sure about is left for the
+// control callback, which parses the message in full.
+
+#include "winrun_routes.h"
+#include "winrun_envelope.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    winrun_window_frame_cb frame_cb;
+    winrun_window_metadata_cb metadata_cb;
+    void *user_data;
+} winrun_route;
+
+// A key of 0 is an empty slot. Keys are never cleared, so a reader that
+// finds its key can trust the slot until the map itself is replaced.
+typedef struct {
+    _Atomic uint64_t window_id;
+    _Atomic(winrun_route *) route;
+} winrun_route_slot;
+
+struct winrun_route_map {
+    size_t capacity;
+    // Keys in use, tombstones included; guarded by the table mutex
+    size_t used;
+    winrun_route_slot slots[];
+};
+
+// MARK: - Map
+
+static size_t winrun_route_hash(uint64_t window_id, size_t capacity) {
+    uint64_t hash = window_id * 0x9E3779B97F4A7C15ull;
+    return (size_t)(hash ^ (hash >> 32)) & (capacity - 1);
+}
+
+static winrun_route_map *winrun_route_map_create(size_t capacity) {
+    winrun_route_map *map = calloc(1, sizeof(*map) + capacity * sizeof(winrun_route_slot));
+    if (map) {
+        map->capacity = capacity;
+    }
+    return map;
+}
+
+// Returns the slot holding `window_id`, or NULL if the key isn't in the map
+static winrun_route_slot *winrun_route_map_find(winrun_route_map *map, uint64_t window_id) {
+    if (!map) {
+        return NULL;
+    }
+    size_t index = winrun_route_hash(window_id, map->capacity);
+    for (size_t probe = 0; probe < map->capacity; ++probe) {
+        winrun_route_slot *slot = &map->slots[(index + probe) & (map->capacity - 1)];
+        uint64_t key = atomic_load(&slot->window_id);
+        if (key == window_id) {
+            return slot;
+        }
+        if (key == 0) {
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+// Claims an empty slot for `window_id`. The route is stored before the key,
+// so a reader that sees the key also sees the route. Caller holds the mutex
+// and has made sure the map has room.
+static void winrun_route_map_insert(winrun_route_map *map, uint64_t window_id, winrun_route *route) {
+    size_t index = winrun_route_hash(window_id, map->capacity);
+    for (;; index = (index + 1) & (map->capacity - 1)) {
+        winrun_route_slot *slot = &map->slots[index];
+        if (atomic_load_explicit(&slot->window_id, memory_order_relaxed) == 0) {
+            atomic_store(&slot->route, route);
+            atomic_store(&slot->window_id, window_id);
+            map->used++;
+            return;
+        }
+    }
+}
+
+// Returns a map sized for `routes` live entries plus one, without tombstones
+static winrun_route_map *winrun_route_map_rebuild(winrun_route_map *map, size_t routes) {
+    size_t capacity = WINRUN_ROUTES_MIN_CAPACITY;
+    while (capacity < (routes + 1) * 2) {
+        capacity *= 2;
+    }
+
+    winrun_route_map *rebuilt = winrun_route_map_create(capacity);
+    if (!rebuilt || !map) {
+        return rebuilt;
+    }
+    for (size_t i = 0; i < map->capacity; ++i) {
+        winrun_route *route = atomic_load(&map->slots[i].route);
+        if (route) {
+            winrun_route_map_insert(rebuilt, atomic_load(&map->slots[i].window_id), route);
+        }
+    }
+    return rebuilt;
+}
+
+// Routes and maps are only held for one lookup and callback, so this wait
+// is short
+static void winrun_route_table_quiesce(winrun_route_table *table) {
+    while (atomic_load(&table->readers) > 0) {
+        sched_yield();
+    }
+}
+
+// MARK: - Table
+
+void winrun_route_table_init(winrun_route_table *table) {
+    pthread_mutex_init(&table->mutex, NULL);
+    atomic_store(&table->map, NULL);
+    atomic_store(&table->readers, 0);
+    atomic_store(&table->routes, 0);
+}
+
+void winrun_route_table_destroy(winrun_route_table *table) {
+    winrun_route_map *map = atomic_exchange(&table->map, NULL);
+    if (map) {
+        for (size_t i = 0; i < map->capacity; ++i) {
+            free(atomic_load(&map->slots[i].route));
+        }
+        free(map);
+    }
+    atomic_store(&table->routes, 0);
+    pthread_mutex_destroy(&table->mutex);
+}
+
+bool winrun_route_table_add(
+    winrun_route_table *table,
+    uint64_t window_id,
+    winrun_window_frame_cb frame_cb,
+    winrun_window_metadata_cb metadata_cb,
+    void *user_data
+) {
+    if (!table || window_id == 0) {
+        return false;
+    }
+    winrun_route *route = malloc(sizeof(*route));
+    if (!route) {
+        return false;
+    }
+    route->frame_cb = frame_cb;
+    route->metadata_cb = metadata_cb;
+    route->user_data = user_data;
+
+    pthread_mutex_lock(&table->mutex);
+    winrun_route_map *map = atomic_load(&table->map);
+
+    // Known key, live or tombstoned: swap the route in place
+    winrun_route_slot *slot = winrun_route_map_find(map, window_id);
+    if (slot) {
+        winrun_route *previous = atomic_exchange(&slot->route, route);
+        if (previous) {
+            winrun_route_table_quiesce(table);
+            free(previous);
+        } else {
+            atomic_fetch_add(&table->routes, 1);
+        }
+        pthread_mutex_unlock(&table->mutex);
+        return true;
+    }
+
+    // Keep probe chains short: past 3/4 full, move the live routes to a new map
+    winrun_route_map *previous_map = NULL;
+    if (!map || (map->used + 1) * 4 > map->capacity * 3) {
+        winrun_route_map *rebuilt = winrun_route_map_rebuild(map, atomic_load(&table->routes));
+        if (!rebuilt) {
+            pthread_mutex_unlock(&table->mutex);
+            free(route);
+            return false;
+        }
+        previous_map = map;
+        map = rebuilt;
+    }
+
+    winrun_route_map_insert(map, window_id, route);
+    if (previous_map) {
+        atomic_store(&table->map, map);
+        winrun_route_table_quiesce(table);
+        free(previous_map);
+    } else if (!atomic_load(&table->map)) {
+        atomic_store(&table->map, map);
+    }
+    atomic_fetch_add(&table->routes, 1);
+    pthread_mutex_unlock(&table->mutex);
+    return true;
+}
+
+bool winrun_route_table_remove(winrun_route_table *table, uint64_t window_id) {
+    if (!table || window_id == 0) {
+        return false;
+    }
+
+    pthread_mutex_lock(&table->mutex);
+    winrun_route_slot *slot = winrun_route_map_find(atomic_load(&table->map), window_id);
+    winrun_route *route = slot ? atomic_exchange(&slot->route, NULL) : NULL;
+    if (route) {
+        atomic_fetch_sub(&table->routes, 1);
+        winrun_route_table_quiesce(table);
+        free(route);
+    }
+    pthread_mutex_unlock(&table->mutex);
+    return route != NULL;
+}
+
+size_t winrun_route_table_count(winrun_route_table *table) {
+    return table ? atomic_load(&table->routes) : 0;
+}
+
+// MARK: - Payload Fields
+
+// Mirrors FrameReadyMessage: the same fields are required
+static bool winrun_parse_frame_ready(const uint8_t *payload, size_t length, winrun_frame_ready *frame) {
+    static const char *const keys[] = {
+        "windowId", "slotIndex", "frameNumber", "isKeyFrame", "timestamp", "targetFps", "rateReason",
+    };
+    winrun_json_value values[7];
+    if (!winrun_json_fields(payload, length, keys, 7, values)) {
+        return false;
+    }
+
+    uint64_t slot_index;
+    uint64_t frame_number;
+    uint64_t target_fps = 0;
+    memset(frame, 0, sizeof(*frame));
+    if (!winrun_json_u64(&values[0], UINT64_MAX, &frame->window_id) ||
+        !winrun_json_u64(&values[1], UINT32_MAX, &slot_index) ||
+        !winrun_json_u64(&values[2], UINT32_MAX, &frame_number) ||
+        !winrun_json_bool(&values[3], &frame->is_key_frame) ||
+        !winrun_json_i64(&values[4], &frame->timestamp)) {
+        return false;
+    }
+    if (!winrun_json_is_null(&values[5]) && !winrun_json_u64(&values[5], UINT32_MAX, &target_fps)) {
+        return false;
+    }
+    if (!winrun_json_is_null(&values[6])) {
+        if (!values[6].is_string || values[6].escaped) {
+            return false;
+        }
+        frame->rate_reason = (const char *)values[6].start;
+        frame->rate_reason_length = values[6].length;
+    }
+
+    frame->slot_index = (uint32_t)slot_index;
+    frame->frame_number = (uint32_t)frame_number;
+    frame->target_fps = (uint32_t)target_fps;
+    return true;
+}
+
+static bool winrun_parse_window_id(const uint8_t *payload, size_t length, uint64_t *window_id) {
+    static const char *const keys[] = { "windowId" };
+    winrun_json_value value;
+    return winrun_json_fields(payload, length, keys, 1, &value) &&
+        winrun_json_u64(&value, UINT64_MAX, window_id);
+}
+
+// MARK: - Dispatch
+
+// Delivers one envelope to its window's route. Returns false if the window
+// has no route for this kind of envelope.
+static bool winrun_route_envelope(winrun_route_table *table, uint8_t type, const uint8_t *payload, size_t length) {
+    winrun_frame_ready frame;
+    uint64_t window_id;
+    if (type == WINRUN_MESSAGE_FRAME_READY) {
+        if (!winrun_parse_frame_ready(payload, length, &frame)) {
+            return false;
+        }
+        window_id = frame.window_id;
+    } else if (type == WINRUN_MESSAGE_WINDOW_METADATA) {
+        if (!winrun_parse_window_id(payload, length, &window_id)) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    bool delivered = false;
+    atomic_fetch_add(&table->readers, 1);
+    winrun_route_slot *slot = winrun_route_map_find(atomic_load(&table->map), window_id);
+    winrun_route *route = slot ? atomic_load(&slot->route) : NULL;
+    if (route && type == WINRUN_MESSAGE_FRAME_READY && route->frame_cb) {
+        route->frame_cb(&frame, route->user_data);
+        delivered = true;
+    } else if (route && type == WINRUN_MESSAGE_WINDOW_METADATA && route->metadata_cb) {
+        route->metadata_cb(window_id, payload, length, route->user_data);
+        delivered = true;
+    }
+    atomic_fetch_sub(&table->readers, 1);
+    return delivered;
+}
+
+size_t winrun_route_table_dispatch(
+    winrun_route_table *table,
+    const uint8_t *data,
+    size_t length,
+    winrun_control_message_cb fallback,
+    void *fallback_user_data
+) {
+    if (!data || length == 0) {
+        return 0;
+    }
+
+    // Nothing to route, or a message split across reads
+    if (!table || atomic_load(&table->routes) == 0 || !winrun_envelopes_are_whole(data, length)) {
+        if (fallback) {
+            fallback(data, length, fallback_user_data);
+        }
+        return 0;
+    }
+
+    size_t routed = 0;
+    for (size_t offset = 0; offset < length;) {
+        const uint8_t *envelope = data + offset;
+        size_t payload_length = winrun_envelope_length(envelope);
+        size_t envelope_length = WINRUN_ENVELOPE_HEADER_SIZE + payload_length;
+        if (winrun_route_envelope(table, envelope[0], envelope + WINRUN_ENVELOPE_HEADER_SIZE, payload_length)) {
+            routed++;
+        } else if (fallback) {
+            fallback(envelope, envelope_length, fallback_user_data);
+        }
+        offset += envelope_length;
+    }
+    return routed;
+}
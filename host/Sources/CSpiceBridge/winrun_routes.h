@@ -0,0 +1,74 @@
+#pragma once
+
+// Per-window routes for control-port notifications.
+//
+// frameReady and windowMetadata envelopes from the guest name the window they
+// belong to. Consumers that register a route for a window get those envelopes
+// straight from the thread that read them off the control port, instead of
+// through the control callback and the Swift router's queues.
+//
+// Routes live in an open-addressed table keyed by window ID. Lookups are
+// lock-free: a dispatching thread bumps `readers`, loads the map and the
+// route, and runs the callback. Writers serialize on `mutex`, publish with
+// atomic stores, and free a replaced route or map only once `readers` drops
+// to zero. Removing a route keeps its key as a tombstone so probe chains stay
+// intact; tombstones are dropped the next time the map is rebuilt.
+
+#include "CSpiceBridge.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+// Smallest map; it grows (and sheds tombstones) once 3/4 of the keys are used
+#define WINRUN_ROUTES_MIN_CAPACITY 64
+
+typedef struct winrun_route_map winrun_route_map;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    _Atomic(winrun_route_map *) map;
+    _Atomic int readers;
+    // Windows with a route; lets dispatch skip parsing when there are none
+    _Atomic size_t routes;
+} winrun_route_table;
+
+// Static initializer; the map is allocated by the first route
+#define WINRUN_ROUTE_TABLE_INIT { .mutex = PTHREAD_MUTEX_INITIALIZER }
+
+void winrun_route_table_init(winrun_route_table *table);
+
+// Frees the map and every route. No dispatch may be running.
+void winrun_route_table_destroy(winrun_route_table *table);
+
+// Adds or replaces the route for `window_id` (which must be non-zero).
+// Either callback may be NULL; envelopes without a handler are not routed.
+// Returns false for window 0 or when allocation fails.
+bool winrun_route_table_add(
+    winrun_route_table *table,
+    uint64_t window_id,
+    winrun_window_frame_cb frame_cb,
+    winrun_window_metadata_cb metadata_cb,
+    void *user_data
+);
+
+// Removes the route for `window_id`, waiting for callbacks that are already
+// running to return. Must not be called from a route callback.
+// Returns false if the window had no route.
+bool winrun_route_table_remove(winrun_route_table *table, uint64_t window_id);
+
+// Number of windows with a route.
+size_t winrun_route_table_count(winrun_route_table *table);
+
+// Walks the control-port envelopes in `data`, handing frameReady and
+// windowMetadata envelopes for routed windows to their route. Every other
+// envelope is passed to `fallback` one at a time. Data that isn't a whole
+// number of envelopes (a message split across reads) goes to `fallback`
+// unchanged, as does everything while no window has a route.
+// Returns the number of envelopes delivered to routes.
+size_t winrun_route_table_dispatch(
+    winrun_route_table *table,
+    const uint8_t *data,
+    size_t length,
+    winrun_control_message_cb fallback,
+    void *fallback_user_data
+);
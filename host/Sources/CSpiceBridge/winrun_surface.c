@@ -0,0 +1,245 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // memfd_create
+#endif
+
+#include "winrun_surface.h"
+#include "winrun_buffer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(winrun_surface_slot_header) == WINRUN_SURFACE_SLOT_HEADER_SIZE,
+               "winrun_surface_slot_header must match WINRUN_SURFACE_SLOT_HEADER_SIZE");
+
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+static int winrun_surface_open_memfd(bool hugetlb) {
+    int flags = MFD_CLOEXEC;
+#ifdef MFD_ALLOW_SEALING
+    flags |= MFD_ALLOW_SEALING;
+#endif
+    if (hugetlb) {
+#ifdef MFD_HUGETLB
+        flags |= MFD_HUGETLB;
+#else
+        return -1;
+#endif
+    }
+    return memfd_create("winrun-surface", flags);
+}
+#endif
+
+// Creates a POSIX shm object under a unique name and unlinks it right away,
+// so only the fd keeps it alive and nothing leaks if the process crashes.
+static int winrun_surface_open_posix_shm(void) {
+    static _Atomic unsigned int counter = 0;
+
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        char name[64];
+        snprintf(name, sizeof(name), "/winrun-surface-%d-%u", (int)getpid(), atomic_fetch_add(&counter, 1));
+
+        int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd >= 0) {
+            shm_unlink(name);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+            return fd;
+        }
+        if (errno != EEXIST) {
+            break;
+        }
+    }
+    return -1;
+}
+
+// Sizes the fd and maps it. Closes the fd on failure.
+static uint8_t *winrun_surface_map(int fd, size_t mapping_size) {
+    if (ftruncate(fd, (off_t)mapping_size) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    void *base = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    return (uint8_t *)base;
+}
+
+bool winrun_surface_ring_init(
+    winrun_surface_ring *ring,
+    size_t slot_capacity,
+    uint32_t slot_count,
+    winrun_hugepage_mode hugepages
+) {
+    if (!ring) {
+        return false;
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+
+    if (slot_capacity == 0 || slot_count == 0) {
+        return false;
+    }
+
+    long page_size = sysconf(_SC_PAGESIZE);
+    size_t page = page_size > 0 ? (size_t)page_size : 4096;
+    size_t huge = winrun_hugepage_size();
+    if (slot_capacity > SIZE_MAX - WINRUN_SURFACE_SLOT_HEADER_SIZE - huge) {
+        return false;
+    }
+    size_t slot_stride = winrun_round_up_size(WINRUN_SURFACE_SLOT_HEADER_SIZE + slot_capacity, page);
+    if (slot_stride > (SIZE_MAX - huge) / slot_count) {
+        return false;
+    }
+    size_t mapping_size = slot_stride * slot_count;
+    if (hugepages != WINRUN_HUGEPAGES_OFF) {
+        // Whole huge pages, so the last slot isn't left on regular pages
+        mapping_size = winrun_round_up_size(mapping_size, huge);
+    }
+
+    int fd = -1;
+    uint8_t *base = NULL;
+    winrun_surface_backing backing = WINRUN_SURFACE_BACKING_NONE;
+    winrun_hugepage_status status = WINRUN_HUGEPAGE_STATUS_NONE;
+
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+    if (hugepages == WINRUN_HUGEPAGES_EXPLICIT) {
+        // Fails when the hugetlb pool is empty; fall back to regular shared memory below
+        fd = winrun_surface_open_memfd(true);
+        if (fd >= 0 && (base = winrun_surface_map(fd, mapping_size)) != NULL) {
+            backing = WINRUN_SURFACE_BACKING_MEMFD;
+            status = WINRUN_HUGEPAGE_STATUS_EXPLICIT;
+        }
+    }
+    if (!base) {
+        fd = winrun_surface_open_memfd(false);
+        if (fd >= 0 && (base = winrun_surface_map(fd, mapping_size)) != NULL) {
+            backing = WINRUN_SURFACE_BACKING_MEMFD;
+        }
+    }
+#endif
+    if (!base) {
+        fd = winrun_surface_open_posix_shm();
+        if (fd >= 0 && (base = winrun_surface_map(fd, mapping_size)) != NULL) {
+            backing = WINRUN_SURFACE_BACKING_POSIX_SHM;
+        }
+    }
+    if (!base) {
+        return false;
+    }
+
+#if defined(F_ADD_SEALS) && defined(F_SEAL_SHRINK)
+    // Let readers in other processes trust the size they map
+    if (backing == WINRUN_SURFACE_BACKING_MEMFD) {
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+    }
+#endif
+
+    // Shared memory only gets transparent huge pages when shmem_enabled allows advice
+    if (status == WINRUN_HUGEPAGE_STATUS_NONE && hugepages != WINRUN_HUGEPAGES_OFF &&
+        winrun_hugepage_advise(base, mapping_size)) {
+        status = WINRUN_HUGEPAGE_STATUS_TRANSPARENT;
+    }
+
+    ring->fd = fd;
+    ring->base = base;
+    ring->mapping_size = mapping_size;
+    ring->slot_stride = slot_stride;
+    ring->slot_capacity = slot_stride - WINRUN_SURFACE_SLOT_HEADER_SIZE;
+    ring->slot_count = slot_count;
+    ring->generation = 0;
+    ring->backing = backing;
+    ring->hugepages = status;
+    return true;
+}
+
+void winrun_surface_ring_destroy(winrun_surface_ring *ring) {
+    if (!ring) {
+        return;
+    }
+    if (ring->base) {
+        munmap(ring->base, ring->mapping_size);
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+bool winrun_surface_ring_reserve(
+    winrun_surface_ring *ring,
+    uint64_t window_id,
+    size_t max_length,
+    winrun_surface_reservation *reservation
+) {
+    if (!ring || !ring->base || !reservation || max_length > ring->slot_capacity) {
+        return false;
+    }
+
+    uint64_t generation = ++ring->generation;
+    size_t slot_offset = (size_t)((generation - 1) % ring->slot_count) * ring->slot_stride;
+    winrun_surface_slot_header *header = (winrun_surface_slot_header *)(ring->base + slot_offset);
+
+    // Mark the slot as being written before the producer touches the payload
+    __atomic_store_n(&header->generation, 0, __ATOMIC_RELAXED);
+    atomic_thread_fence(memory_order_release);
+
+    reservation->data = ring->base + slot_offset + WINRUN_SURFACE_SLOT_HEADER_SIZE;
+    reservation->capacity = ring->slot_capacity;
+    reservation->slot_offset = slot_offset;
+    reservation->generation = generation;
+    reservation->window_id = window_id;
+    return true;
+}
+
+bool winrun_surface_ring_commit(
+    winrun_surface_ring *ring,
+    const winrun_surface_reservation *reservation,
+    size_t length,
+    winrun_frame_surface *surface
+) {
+    if (!ring || !ring->base || !reservation || !surface || length > reservation->capacity) {
+        return false;
+    }
+
+    winrun_surface_slot_header *header = (winrun_surface_slot_header *)(ring->base + reservation->slot_offset);
+    header->window_id = reservation->window_id;
+    header->length = length;
+    __atomic_store_n(&header->generation, reservation->generation, __ATOMIC_RELEASE);
+
+    surface->window_id = reservation->window_id;
+    surface->fd = ring->fd;
+    surface->backing = ring->backing;
+    surface->mapping_size = ring->mapping_size;
+    surface->offset = reservation->slot_offset + WINRUN_SURFACE_SLOT_HEADER_SIZE;
+    surface->length = length;
+    surface->generation = reservation->generation;
+    surface->data = reservation->data;
+    surface->hugepages = ring->hugepages;
+    return true;
+}
+
+bool winrun_surface_ring_write(
+    winrun_surface_ring *ring,
+    uint64_t window_id,
+    const uint8_t *data,
+    size_t length,
+    winrun_frame_surface *surface
+) {
+    if (!data || !surface) {
+        return false;
+    }
+
+    winrun_surface_reservation reservation;
+    if (!winrun_surface_ring_reserve(ring, window_id, length, &reservation)) {
+        return false;
+    }
+    memcpy(reservation.data, data, length);
+    return winrun_surface_ring_commit(ring, &reservation, length, surface);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+// Ring of frame surfaces in fd-backed shared memory.
+//
+// One shared mapping is split into slot_count page-aligned slots. Each slot
+// holds a winrun_surface_slot_header followed by up to slot_capacity bytes of
+// frame data, so another process that maps the same fd can read frames in
+// place. The fd comes from memfd_create where available, otherwise from a
+// POSIX shm object that is unlinked as soon as it is opened.
+//
+// The ring itself is not thread-safe; the stream serializes access.
+
+#include "CSpiceBridge.h"
+
+typedef struct {
+    int fd;
+    uint8_t *base;
+    size_t mapping_size;
+    size_t slot_stride;
+    size_t slot_capacity;
+    uint32_t slot_count;
+    uint64_t generation;
+    winrun_surface_backing backing;
+    winrun_hugepage_status hugepages;
+} winrun_surface_ring;
+
+// Allocates the shared mapping, with huge pages according to `hugepages`
+// (falling back to regular pages). On failure the ring is left empty (fd -1).
+bool winrun_surface_ring_init(
+    winrun_surface_ring *ring,
+    size_t slot_capacity,
+    uint32_t slot_count,
+    winrun_hugepage_mode hugepages
+);
+
+// Unmaps and closes the ring. Safe to call on an empty ring.
+void winrun_surface_ring_destroy(winrun_surface_ring *ring);
+
+// A slot handed out by winrun_surface_ring_reserve and not yet committed.
+typedef struct {
+    uint8_t *data;
+    size_t capacity;
+    size_t slot_offset;
+    uint64_t generation;
+    uint64_t window_id;
+} winrun_surface_reservation;
+
+// Claims the next slot for a frame of up to `max_length` bytes, so a producer
+// (decoder, decompressor) can write it in place instead of into a scratch
+// buffer first. The slot reads as being written (generation 0) until
+// winrun_surface_ring_commit. `reservation->capacity` is the whole slot,
+// which may be more than `max_length`. Reservations don't nest: commit or
+// abandon one before reserving again.
+// Returns false if the ring is empty or `max_length` does not fit a slot.
+bool winrun_surface_ring_reserve(
+    winrun_surface_ring *ring,
+    uint64_t window_id,
+    size_t max_length,
+    winrun_surface_reservation *reservation
+);
+
+// Publishes the first `length` bytes written to a reservation and describes
+// them in `surface`. `length` may be anything up to the capacity; readers
+// see the committed length in the slot header.
+// Returns false if `length` exceeds the reservation's capacity; the slot then
+// stays marked as being written and the reservation is abandoned.
+bool winrun_surface_ring_commit(
+    winrun_surface_ring *ring,
+    const winrun_surface_reservation *reservation,
+    size_t length,
+    winrun_frame_surface *surface
+);
+
+// Copies a frame into the next slot and describes it in `surface`.
+// Returns false if the ring is empty or the frame does not fit.
+bool winrun_surface_ring_write(
+    winrun_surface_ring *ring,
+    uint64_t window_id,
+    const uint8_t *data,
+    size_t length,
+    winrun_frame_surface *surface
+);
@@ -0,0 +1,317 @@
+// Decoder for tiled frame slots (guest: TiledFrameEncoder.cs).
+//
+// Payload, little-endian:
+//   [tile_size: u16][reserved: u16][tile_count: u32]
+//   [tile_count x (codec: u8, reserved: 3 bytes, length: u32)]
+//   [tile data, row-major, each `length` bytes]
+// Tiles are tile_size squares, the last row and column clipped to the frame.
+//
+// Flat tiles dominate UI frames, so their paths write several pixels per
+// store: RLE runs are filled four pixels at a time with vector stores, and
+// 4-bit palette rows decode a byte (two pixels) per lookup.
+
+#include "CSpiceBridge.h"
+
+#include <string.h>
+
+#define WINRUN_TILES_HEADER_SIZE 8
+#define WINRUN_TILES_ENTRY_SIZE 8
+#define WINRUN_TILES_RUN_SIZE 6
+
+// Largest tile accepted; the guest uses 64. Bounds the LZ4 scratch on the stack.
+#define WINRUN_TILES_MAX_SIZE 64
+
+typedef uint32_t winrun_px4 __attribute__((vector_size(16)));
+
+static inline uint32_t winrun_read_u16(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+static inline uint32_t winrun_read_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+typedef struct {
+    uint8_t *origin;
+    size_t stride;
+    uint32_t width;
+    uint32_t height;
+} winrun_tile;
+
+// Pixels are copied as bytes, so BGRA order holds whatever the host's endianness
+static inline void winrun_fill_pixels(uint8_t *dst, const uint8_t pixel[4], uint32_t count) {
+    uint32_t value;
+    memcpy(&value, pixel, 4);
+    winrun_px4 four = { value, value, value, value };
+
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        memcpy(dst + (size_t)i * 4, &four, sizeof(four));
+    }
+    for (; i < count; ++i) {
+        memcpy(dst + (size_t)i * 4, &value, 4);
+    }
+}
+
+static bool winrun_tile_raw(const winrun_tile *tile, const uint8_t *data, size_t length) {
+    size_t row_bytes = (size_t)tile->width * 4;
+    if (length != row_bytes * tile->height) {
+        return false;
+    }
+    for (uint32_t y = 0; y < tile->height; ++y) {
+        memcpy(tile->origin + y * tile->stride, data + y * row_bytes, row_bytes);
+    }
+    return true;
+}
+
+// LZ4 block format: sequences of [token][literal length+][literals][offset: u16][match length+].
+// The last sequence carries only literals.
+static bool winrun_lz4_decode(const uint8_t *src, size_t src_length, uint8_t *dst, size_t dst_length) {
+    const uint8_t *ip = src;
+    const uint8_t *iend = src + src_length;
+    uint8_t *op = dst;
+    uint8_t *oend = dst + dst_length;
+
+    while (ip < iend) {
+        uint32_t token = *ip++;
+
+        size_t literals = token >> 4;
+        if (literals == 15) {
+            uint8_t more;
+            do {
+                if (ip >= iend) {
+                    return false;
+                }
+                more = *ip++;
+                literals += more;
+            } while (more == 255);
+        }
+        if (literals > (size_t)(iend - ip) || literals > (size_t)(oend - op)) {
+            return false;
+        }
+        memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+
+        if (ip == iend) {
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return false;
+        }
+        size_t offset = winrun_read_u16(ip);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) {
+            return false;
+        }
+
+        size_t match = (token & 15) + 4;
+        if ((token & 15) == 15) {
+            uint8_t more;
+            do {
+                if (ip >= iend) {
+                    return false;
+                }
+                more = *ip++;
+                match += more;
+            } while (more == 255);
+        }
+        if (match > (size_t)(oend - op)) {
+            return false;
+        }
+
+        const uint8_t *ref = op - offset;
+        if (offset >= match) {
+            memcpy(op, ref, match);
+        } else {
+            // Overlapping match repeats the last `offset` bytes
+            for (size_t i = 0; i < match; ++i) {
+                op[i] = ref[i];
+            }
+        }
+        op += match;
+    }
+
+    return op == oend;
+}
+
+static bool winrun_tile_lz4(const winrun_tile *tile, const uint8_t *data, size_t length) {
+    uint8_t scratch[WINRUN_TILES_MAX_SIZE * WINRUN_TILES_MAX_SIZE * 4];
+    size_t row_bytes = (size_t)tile->width * 4;
+    size_t size = row_bytes * tile->height;
+
+    if (!winrun_lz4_decode(data, length, scratch, size)) {
+        return false;
+    }
+    for (uint32_t y = 0; y < tile->height; ++y) {
+        memcpy(tile->origin + y * tile->stride, scratch + y * row_bytes, row_bytes);
+    }
+    return true;
+}
+
+static bool winrun_tile_rle(const winrun_tile *tile, const uint8_t *data, size_t length) {
+    if (length % WINRUN_TILES_RUN_SIZE != 0) {
+        return false;
+    }
+
+    uint32_t x = 0;
+    uint32_t y = 0;
+    for (size_t i = 0; i < length; i += WINRUN_TILES_RUN_SIZE) {
+        uint32_t count = winrun_read_u16(data + i);
+        const uint8_t *pixel = data + i + 2;
+        if (count == 0) {
+            return false;
+        }
+
+        // Runs continue across rows
+        while (count > 0) {
+            if (y >= tile->height) {
+                return false;
+            }
+            uint32_t n = count < tile->width - x ? count : tile->width - x;
+            winrun_fill_pixels(tile->origin + y * tile->stride + (size_t)x * 4, pixel, n);
+            count -= n;
+            x += n;
+            if (x == tile->width) {
+                x = 0;
+                ++y;
+            }
+        }
+    }
+
+    return x == 0 && y == tile->height;
+}
+
+static bool winrun_tile_palette(const winrun_tile *tile, const uint8_t *data, size_t length) {
+    if (length < 1) {
+        return false;
+    }
+
+    uint32_t colors = (uint32_t)data[0] + 1;
+    uint32_t bits = colors <= 2 ? 1 : colors <= 4 ? 2 : colors <= 16 ? 4 : 8;
+    size_t row_bytes = ((size_t)tile->width * bits + 7) / 8;
+    size_t palette_bytes = 1 + (size_t)colors * 4;
+    if (length != palette_bytes + row_bytes * tile->height) {
+        return false;
+    }
+
+    // Indices past the last color read as transparent black
+    uint32_t palette[256] = { 0 };
+    memcpy(palette, data + 1, (size_t)colors * 4);
+    const uint8_t *indices = data + palette_bytes;
+
+    if (bits == 4) {
+        // Each index byte is two pixels
+        uint32_t pairs[256][2];
+        for (uint32_t i = 0; i < 256; ++i) {
+            pairs[i][0] = palette[i & 15];
+            pairs[i][1] = palette[i >> 4];
+        }
+        for (uint32_t y = 0; y < tile->height; ++y) {
+            const uint8_t *row_indices = indices + y * row_bytes;
+            uint8_t *row = tile->origin + y * tile->stride;
+            uint32_t x = 0;
+            for (; x + 2 <= tile->width; x += 2) {
+                memcpy(row + (size_t)x * 4, pairs[row_indices[x / 2]], 8);
+            }
+            if (x < tile->width) {
+                memcpy(row + (size_t)x * 4, &pairs[row_indices[x / 2]][0], 4);
+            }
+        }
+        return true;
+    }
+
+    uint32_t mask = (1u << bits) - 1;
+    for (uint32_t y = 0; y < tile->height; ++y) {
+        const uint8_t *row_indices = indices + y * row_bytes;
+        uint8_t *row = tile->origin + y * tile->stride;
+        for (uint32_t x = 0; x < tile->width; ++x) {
+            uint32_t bit = x * bits;
+            uint32_t index = (row_indices[bit >> 3] >> (bit & 7)) & mask;
+            memcpy(row + (size_t)x * 4, &palette[index], 4);
+        }
+    }
+    return true;
+}
+
+bool winrun_tiles_decode(
+    const uint8_t *payload,
+    size_t length,
+    uint32_t width,
+    uint32_t height,
+    uint8_t *dest,
+    size_t dest_stride,
+    winrun_tile_stats *stats
+) {
+    if (!payload || !dest || length < WINRUN_TILES_HEADER_SIZE || width == 0 || height == 0 ||
+        dest_stride < (size_t)width * 4) {
+        return false;
+    }
+
+    uint32_t tile_size = winrun_read_u16(payload);
+    uint32_t tile_count = winrun_read_u32(payload + 4);
+    if (tile_size == 0 || tile_size > WINRUN_TILES_MAX_SIZE) {
+        return false;
+    }
+
+    uint64_t columns = (width + tile_size - 1) / tile_size;
+    uint64_t rows = (height + tile_size - 1) / tile_size;
+    if (columns * rows != tile_count) {
+        return false;
+    }
+
+    size_t offset = WINRUN_TILES_HEADER_SIZE + (size_t)tile_count * WINRUN_TILES_ENTRY_SIZE;
+    if (offset > length) {
+        return false;
+    }
+
+    const uint8_t *entry = payload + WINRUN_TILES_HEADER_SIZE;
+    for (uint32_t tile_y = 0; tile_y < height; tile_y += tile_size) {
+        for (uint32_t tile_x = 0; tile_x < width; tile_x += tile_size) {
+            uint32_t codec = entry[0];
+            size_t tile_length = winrun_read_u32(entry + 4);
+            entry += WINRUN_TILES_ENTRY_SIZE;
+            if (tile_length > length - offset) {
+                return false;
+            }
+
+            winrun_tile tile = {
+                .origin = dest + (size_t)tile_y * dest_stride + (size_t)tile_x * 4,
+                .stride = dest_stride,
+                .width = width - tile_x < tile_size ? width - tile_x : tile_size,
+                .height = height - tile_y < tile_size ? height - tile_y : tile_size,
+            };
+            const uint8_t *data = payload + offset;
+
+            bool decoded;
+            switch (codec) {
+                case WINRUN_TILE_RAW:
+                    decoded = winrun_tile_raw(&tile, data, tile_length);
+                    break;
+                case WINRUN_TILE_LZ4:
+                    decoded = winrun_tile_lz4(&tile, data, tile_length);
+                    break;
+                case WINRUN_TILE_RLE:
+                    decoded = winrun_tile_rle(&tile, data, tile_length);
+                    break;
+                case WINRUN_TILE_PALETTE:
+                    decoded = winrun_tile_palette(&tile, data, tile_length);
+                    break;
+                default:
+                    decoded = false;
+                    break;
+            }
+            if (!decoded) {
+                return false;
+            }
+
+            if (stats) {
+                stats->tiles[codec]++;
+            }
+            offset += tile_length;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,520 @@
+#include "winrun_video.h"
+
+#include <errno.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// libjpeg-turbo's libjpeg API: SIMD decoding and direct BGRA output
+#if defined(__has_include)
+#if __has_include(<jpeglib.h>)
+#include <jpeglib.h>
+#if defined(JCS_EXTENSIONS)
+#define WINRUN_HAVE_MJPEG 1
+#endif
+#endif
+#endif
+
+#ifndef WINRUN_HAVE_MJPEG
+#define WINRUN_HAVE_MJPEG 0
+#endif
+
+// Frames further than this from their expected time re-anchor the stream clock
+#define WINRUN_VIDEO_MAX_DRIFT_NS 1000000000ull
+
+struct winrun_video_job {
+    uint32_t slot;
+    uint32_t stream_id;
+    uint32_t mm_time;
+    uint8_t *data;
+    size_t length;
+    winrun_video_job *next;
+};
+
+static uint64_t winrun_video_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// MARK: - MJPEG Decoder
+
+#if WINRUN_HAVE_MJPEG
+typedef struct {
+    struct jpeg_error_mgr base;
+    jmp_buf jump;
+} winrun_jpeg_error;
+
+struct winrun_video_decoder {
+    struct jpeg_decompress_struct cinfo;
+    winrun_jpeg_error error;
+};
+
+static void winrun_jpeg_error_exit(j_common_ptr cinfo) {
+    winrun_jpeg_error *error = (winrun_jpeg_error *)cinfo->err;
+    longjmp(error->jump, 1);
+}
+
+static void winrun_jpeg_output_message(j_common_ptr cinfo) {
+    // Corrupt frames are counted as drops; don't spam stderr
+    (void)cinfo;
+}
+
+static winrun_video_decoder *winrun_video_decoder_create(void) {
+    // volatile: read again after longjmp
+    winrun_video_decoder *volatile decoder = calloc(1, sizeof(*decoder));
+    if (!decoder) {
+        return NULL;
+    }
+    decoder->cinfo.err = jpeg_std_error(&decoder->error.base);
+    decoder->error.base.error_exit = winrun_jpeg_error_exit;
+    decoder->error.base.output_message = winrun_jpeg_output_message;
+    if (setjmp(decoder->error.jump)) {
+        free(decoder);
+        return NULL;
+    }
+    jpeg_create_decompress(&decoder->cinfo);
+    return decoder;
+}
+
+static void winrun_video_decoder_free(winrun_video_decoder *decoder) {
+    if (!decoder) {
+        return;
+    }
+    jpeg_destroy_decompress(&decoder->cinfo);
+    free(decoder);
+}
+
+// Decodes one MJPEG frame into the stream's BGRA buffer, growing it as needed.
+// The decompress object is reused across frames to keep per-frame setup cheap.
+static bool winrun_mjpeg_decode(
+    winrun_video_stream *stream,
+    const uint8_t *data,
+    size_t length,
+    uint32_t *width,
+    uint32_t *height
+) {
+    winrun_video_decoder *decoder = stream->decoder;
+    struct jpeg_decompress_struct *cinfo = &decoder->cinfo;
+
+    if (setjmp(decoder->error.jump)) {
+        jpeg_abort_decompress(cinfo);
+        return false;
+    }
+
+    jpeg_mem_src(cinfo, data, (unsigned long)length);
+    if (jpeg_read_header(cinfo, TRUE) != JPEG_HEADER_OK) {
+        jpeg_abort_decompress(cinfo);
+        return false;
+    }
+    cinfo->out_color_space = JCS_EXT_BGRA;
+    // Video frames are already lossy; the fast integer IDCT is indistinguishable here
+    cinfo->dct_method = JDCT_IFAST;
+    jpeg_start_decompress(cinfo);
+
+    size_t stride = (size_t)cinfo->output_width * 4;
+    size_t needed = stride * cinfo->output_height;
+    if (needed > stream->pixels_size) {
+        uint8_t *pixels = realloc(stream->pixels, needed);
+        if (!pixels) {
+            jpeg_abort_decompress(cinfo);
+            return false;
+        }
+        stream->pixels = pixels;
+        stream->pixels_size = needed;
+    }
+
+    while (cinfo->output_scanline < cinfo->output_height) {
+        JSAMPROW row = stream->pixels + (size_t)cinfo->output_scanline * stride;
+        jpeg_read_scanlines(cinfo, &row, 1);
+    }
+
+    *width = cinfo->output_width;
+    *height = cinfo->output_height;
+    jpeg_finish_decompress(cinfo);
+    return true;
+}
+#else
+struct winrun_video_decoder {
+    int unused;
+};
+
+static winrun_video_decoder *winrun_video_decoder_create(void) {
+    return NULL;
+}
+
+static void winrun_video_decoder_free(winrun_video_decoder *decoder) {
+    free(decoder);
+}
+
+static bool winrun_mjpeg_decode(
+    winrun_video_stream *stream,
+    const uint8_t *data,
+    size_t length,
+    uint32_t *width,
+    uint32_t *height
+) {
+    (void)stream;
+    (void)data;
+    (void)length;
+    (void)width;
+    (void)height;
+    return false;
+}
+#endif
+
+bool winrun_video_codec_supported(winrun_video_codec codec) {
+    return codec == WINRUN_VIDEO_CODEC_MJPEG && WINRUN_HAVE_MJPEG;
+}
+
+// MARK: - Queue
+
+static void winrun_video_job_free(winrun_video_job *job) {
+    free(job->data);
+    free(job);
+}
+
+static void winrun_video_push(winrun_video_worker *worker, winrun_video_job *job) {
+    job->next = NULL;
+    if (worker->tail) {
+        worker->tail->next = job;
+    } else {
+        worker->head = job;
+    }
+    worker->tail = job;
+}
+
+static winrun_video_job *winrun_video_pop(winrun_video_worker *worker) {
+    winrun_video_job *job = worker->head;
+    if (job) {
+        worker->head = job->next;
+        if (!worker->head) {
+            worker->tail = NULL;
+        }
+    }
+    return job;
+}
+
+// Removes queued jobs for a slot: all of them, or just the oldest.
+// Must be called with the worker mutex held.
+static void winrun_video_discard(winrun_video_worker *worker, uint32_t slot, bool oldest_only) {
+    winrun_video_job **link = &worker->head;
+    winrun_video_job *previous = NULL;
+    while (*link) {
+        winrun_video_job *job = *link;
+        if (job->slot == slot) {
+            *link = job->next;
+            if (worker->tail == job) {
+                worker->tail = previous;
+            }
+            worker->streams[slot].queued--;
+            winrun_video_job_free(job);
+            if (oldest_only) {
+                return;
+            }
+            continue;
+        }
+        previous = job;
+        link = &job->next;
+    }
+}
+
+// MARK: - Worker Thread
+
+static void winrun_video_release_slot(winrun_video_stream *stream) {
+    winrun_video_decoder_free(stream->decoder);
+    free(stream->pixels);
+    memset(stream, 0, sizeof(*stream));
+}
+
+// Frees the decoders of streams that have ended. Only this thread decodes,
+// so a slot is never released while a frame is being decoded into it.
+// Must be called with the worker mutex held.
+static void winrun_video_release_ended(winrun_video_worker *worker) {
+    for (uint32_t i = 0; i < WINRUN_VIDEO_MAX_STREAMS; ++i) {
+        winrun_video_stream *stream = &worker->streams[i];
+        if (!stream->active && (stream->decoder || stream->pixels)) {
+            winrun_video_release_slot(stream);
+        }
+    }
+}
+
+// Whether the job's stream is still the one it was queued for.
+// Must be called with the worker mutex held.
+static bool winrun_video_job_current(winrun_video_worker *worker, const winrun_video_job *job) {
+    const winrun_video_stream *stream = &worker->streams[job->slot];
+    return stream->active && stream->id == job->stream_id;
+}
+
+// Sleeps until `due_ns` (monotonic) unless the worker stops or the stream goes away.
+// Must be called with the worker mutex held.
+static void winrun_video_wait_until(winrun_video_worker *worker, const winrun_video_job *job, uint64_t due_ns) {
+    while (!worker->stopping && winrun_video_job_current(worker, job)) {
+        uint64_t now_ns = winrun_video_now_ns();
+        if (now_ns >= due_ns) {
+            return;
+        }
+        // Condition variables wait on the realtime clock (macOS has no monotonic variant)
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        uint64_t wake_ns = (uint64_t)deadline.tv_nsec + (due_ns - now_ns);
+        deadline.tv_sec += (time_t)(wake_ns / 1000000000ull);
+        deadline.tv_nsec = (long)(wake_ns % 1000000000ull);
+        pthread_cond_timedwait(&worker->cond, &worker->mutex, &deadline);
+    }
+}
+
+// Maps a stream timestamp to the monotonic time it should be shown at,
+// anchoring the stream clock on the first frame and after large jumps.
+static uint64_t winrun_video_due_ns(winrun_video_stream *stream, uint32_t mm_time, uint64_t now_ns) {
+    if (stream->has_clock) {
+        int64_t offset_ns = (int64_t)(int32_t)(mm_time - stream->clock_mm_time) * 1000000;
+        uint64_t due_ns = stream->clock_ns + (uint64_t)offset_ns;
+        uint64_t drift_ns = due_ns > now_ns ? due_ns - now_ns : now_ns - due_ns;
+        if (offset_ns >= 0 && drift_ns <= WINRUN_VIDEO_MAX_DRIFT_NS) {
+            return due_ns;
+        }
+    }
+    stream->has_clock = true;
+    stream->clock_mm_time = mm_time;
+    stream->clock_ns = now_ns;
+    return now_ns;
+}
+
+static void winrun_video_process(winrun_video_worker *worker, winrun_video_job *job) {
+    winrun_video_stream *stream = &worker->streams[job->slot];
+
+    // Decoder state is only touched by this thread, so decode without the lock
+    pthread_mutex_unlock(&worker->mutex);
+    uint64_t start_ns = winrun_video_now_ns();
+    if (!stream->decoder) {
+        stream->decoder = winrun_video_decoder_create();
+    }
+    uint32_t width = 0;
+    uint32_t height = 0;
+    bool decoded = stream->decoder &&
+        winrun_mjpeg_decode(stream, job->data, job->length, &width, &height);
+    uint64_t decode_ns = winrun_video_now_ns() - start_ns;
+    pthread_mutex_lock(&worker->mutex);
+
+    if (!winrun_video_job_current(worker, job)) {
+        return;
+    }
+    if (!decoded) {
+        stream->dropped++;
+        return;
+    }
+
+    winrun_video_wait_until(worker, job, winrun_video_due_ns(stream, job->mm_time, winrun_video_now_ns()));
+    if (worker->stopping || !winrun_video_job_current(worker, job) || !worker->callback) {
+        return;
+    }
+
+    winrun_video_frame frame = {
+        .window_id = worker->window_id,
+        .stream_id = stream->id,
+        .dest = stream->dest,
+        .width = width,
+        .height = height,
+        .stride = (size_t)width * 4,
+        .pixels = stream->pixels,
+        .mm_time = job->mm_time,
+        .decode_ns = decode_ns,
+        .dropped_frames = stream->dropped
+    };
+    winrun_spice_video_cb callback = worker->callback;
+    void *user_data = worker->user_data;
+
+    pthread_mutex_unlock(&worker->mutex);
+    callback(&frame, user_data);
+    pthread_mutex_lock(&worker->mutex);
+}
+
+static void *winrun_video_thread(void *context) {
+    winrun_video_worker *worker = (winrun_video_worker *)context;
+
+    pthread_mutex_lock(&worker->mutex);
+    while (!worker->stopping) {
+        winrun_video_release_ended(worker);
+        winrun_video_job *job = winrun_video_pop(worker);
+        if (!job) {
+            pthread_cond_wait(&worker->cond, &worker->mutex);
+            continue;
+        }
+
+        worker->streams[job->slot].queued--;
+        if (winrun_video_job_current(worker, job)) {
+            winrun_video_process(worker, job);
+        }
+        winrun_video_job_free(job);
+    }
+    pthread_mutex_unlock(&worker->mutex);
+    return NULL;
+}
+
+// MARK: - Public Interface
+
+void winrun_video_worker_init(winrun_video_worker *worker, uint64_t window_id) {
+    memset(worker, 0, sizeof(*worker));
+    worker->window_id = window_id;
+    pthread_mutex_init(&worker->mutex, NULL);
+    pthread_cond_init(&worker->cond, NULL);
+}
+
+void winrun_video_worker_destroy(winrun_video_worker *worker) {
+    pthread_mutex_lock(&worker->mutex);
+    worker->stopping = true;
+    pthread_cond_broadcast(&worker->cond);
+    pthread_mutex_unlock(&worker->mutex);
+
+    if (worker->thread_started) {
+        pthread_join(worker->thread, NULL);
+    }
+
+    winrun_video_job *job;
+    while ((job = winrun_video_pop(worker)) != NULL) {
+        winrun_video_job_free(job);
+    }
+    for (uint32_t i = 0; i < WINRUN_VIDEO_MAX_STREAMS; ++i) {
+        winrun_video_release_slot(&worker->streams[i]);
+    }
+    pthread_cond_destroy(&worker->cond);
+    pthread_mutex_destroy(&worker->mutex);
+}
+
+void winrun_video_worker_set_callback(winrun_video_worker *worker, winrun_spice_video_cb cb, void *user_data) {
+    pthread_mutex_lock(&worker->mutex);
+    worker->callback = cb;
+    worker->user_data = user_data;
+    pthread_mutex_unlock(&worker->mutex);
+}
+
+// Must be called with the worker mutex held
+static int winrun_video_find_slot(winrun_video_worker *worker, uint32_t stream_id) {
+    for (int i = 0; i < WINRUN_VIDEO_MAX_STREAMS; ++i) {
+        if (worker->streams[i].active && worker->streams[i].id == stream_id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Slots stay reserved until the worker has released their decoder
+static bool winrun_video_slot_free(const winrun_video_stream *stream) {
+    return !stream->active && !stream->decoder && !stream->pixels;
+}
+
+bool winrun_video_worker_create_stream(
+    winrun_video_worker *worker,
+    uint32_t stream_id,
+    winrun_video_codec codec,
+    const winrun_video_rect *dest
+) {
+    if (!dest || !winrun_video_codec_supported(codec)) {
+        return false;
+    }
+
+    pthread_mutex_lock(&worker->mutex);
+    bool created = false;
+    if (!worker->stopping && winrun_video_find_slot(worker, stream_id) < 0) {
+        for (uint32_t i = 0; i < WINRUN_VIDEO_MAX_STREAMS; ++i) {
+            winrun_video_stream *stream = &worker->streams[i];
+            if (winrun_video_slot_free(stream)) {
+                memset(stream, 0, sizeof(*stream));
+                stream->active = true;
+                stream->id = stream_id;
+                stream->codec = codec;
+                stream->dest = *dest;
+                created = true;
+                break;
+            }
+        }
+    }
+
+    if (created && !worker->thread_started) {
+        if (pthread_create(&worker->thread, NULL, winrun_video_thread, worker) == 0) {
+            worker->thread_started = true;
+        } else {
+            winrun_video_release_slot(&worker->streams[winrun_video_find_slot(worker, stream_id)]);
+            created = false;
+        }
+    }
+    pthread_mutex_unlock(&worker->mutex);
+    return created;
+}
+
+bool winrun_video_worker_queue(
+    winrun_video_worker *worker,
+    uint32_t stream_id,
+    uint32_t mm_time,
+    const uint8_t *data,
+    size_t length
+) {
+    if (!data || length == 0) {
+        return false;
+    }
+
+    winrun_video_job *job = calloc(1, sizeof(*job));
+    uint8_t *copy = malloc(length);
+    if (!job || !copy) {
+        free(job);
+        free(copy);
+        return false;
+    }
+    memcpy(copy, data, length);
+
+    pthread_mutex_lock(&worker->mutex);
+    int slot = winrun_video_find_slot(worker, stream_id);
+    if (slot < 0 || worker->stopping) {
+        pthread_mutex_unlock(&worker->mutex);
+        free(job);
+        free(copy);
+        return false;
+    }
+
+    winrun_video_stream *stream = &worker->streams[slot];
+    if (stream->queued >= WINRUN_VIDEO_QUEUE_DEPTH) {
+        winrun_video_discard(worker, (uint32_t)slot, true);
+        stream->dropped++;
+    }
+
+    job->slot = (uint32_t)slot;
+    job->stream_id = stream_id;
+    job->mm_time = mm_time;
+    job->data = copy;
+    job->length = length;
+    winrun_video_push(worker, job);
+    stream->queued++;
+    pthread_cond_signal(&worker->cond);
+    pthread_mutex_unlock(&worker->mutex);
+    return true;
+}
+
+// Must be called with the worker mutex held
+static void winrun_video_end_stream(winrun_video_worker *worker, uint32_t slot) {
+    winrun_video_discard(worker, slot, false);
+    worker->streams[slot].active = false;
+    // The worker may be decoding into the slot; it frees the decoder once done
+    pthread_cond_signal(&worker->cond);
+}
+
+void winrun_video_worker_destroy_stream(winrun_video_worker *worker, uint32_t stream_id) {
+    pthread_mutex_lock(&worker->mutex);
+    int slot = winrun_video_find_slot(worker, stream_id);
+    if (slot >= 0) {
+        winrun_video_end_stream(worker, (uint32_t)slot);
+    }
+    pthread_mutex_unlock(&worker->mutex);
+}
+
+void winrun_video_worker_destroy_streams(winrun_video_worker *worker) {
+    pthread_mutex_lock(&worker->mutex);
+    for (uint32_t i = 0; i < WINRUN_VIDEO_MAX_STREAMS; ++i) {
+        if (worker->streams[i].active) {
+            winrun_video_end_stream(worker, i);
+        }
+    }
+    pthread_mutex_unlock(&worker->mutex);
+}
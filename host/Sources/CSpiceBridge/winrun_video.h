@@ -0,0 +1,78 @@
+#pragma once
+
+// Decode worker for server-detected video streams.
+//
+// Each window owns one worker. Compressed frames are queued by the caller
+// and decoded on the worker's thread, which is started with the first stream
+// so windows without video don't pay for it. Decoded frames are held until
+// their timestamp is due (relative to the stream's first frame) and then
+// handed to the video callback. Each stream keeps at most
+// WINRUN_VIDEO_QUEUE_DEPTH frames queued; older ones are dropped so playback
+// stays live instead of drifting behind.
+
+#include "CSpiceBridge.h"
+
+#include <pthread.h>
+
+#define WINRUN_VIDEO_MAX_STREAMS 8
+#define WINRUN_VIDEO_QUEUE_DEPTH 3
+
+typedef struct winrun_video_job winrun_video_job;
+typedef struct winrun_video_decoder winrun_video_decoder;
+
+typedef struct {
+    bool active;
+    uint32_t id;
+    winrun_video_codec codec;
+    winrun_video_rect dest;
+    uint32_t queued;
+    uint64_t dropped;
+    // Owned by the worker thread
+    winrun_video_decoder *decoder;
+    uint8_t *pixels;
+    size_t pixels_size;
+    bool has_clock;
+    uint32_t clock_mm_time;
+    uint64_t clock_ns;
+} winrun_video_stream;
+
+typedef struct {
+    uint64_t window_id;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_t thread;
+    bool thread_started;
+    bool stopping;
+    winrun_video_job *head;
+    winrun_video_job *tail;
+    winrun_video_stream streams[WINRUN_VIDEO_MAX_STREAMS];
+    winrun_spice_video_cb callback;
+    void *user_data;
+} winrun_video_worker;
+
+void winrun_video_worker_init(winrun_video_worker *worker, uint64_t window_id);
+
+// Stops the thread, dropping queued frames, and frees all streams.
+void winrun_video_worker_destroy(winrun_video_worker *worker);
+
+void winrun_video_worker_set_callback(winrun_video_worker *worker, winrun_spice_video_cb cb, void *user_data);
+
+bool winrun_video_worker_create_stream(
+    winrun_video_worker *worker,
+    uint32_t stream_id,
+    winrun_video_codec codec,
+    const winrun_video_rect *dest
+);
+
+bool winrun_video_worker_queue(
+    winrun_video_worker *worker,
+    uint32_t stream_id,
+    uint32_t mm_time,
+    const uint8_t *data,
+    size_t length
+);
+
+void winrun_video_worker_destroy_stream(winrun_video_worker *worker, uint32_t stream_id);
+
+// Ends every stream, as when the session they belong to goes away.
+void winrun_video_worker_destroy_streams(winrun_video_worker *worker);
@@ -47,6 +47,12 @@ final class MetalContentView: NSView {
     /// Tracks currently pressed mouse buttons for move events
     private var pressedMouseButtons: Set<MouseButton> = []
 
+    /// Pointer shown over the view, drawn natively from the guest's cursor channel
+    private var guestCursor: NSCursor = .arrow
+
+    /// Stand-in for a hidden guest pointer
+    private static let invisibleCursor = NSCursor(image: NSImage(size: NSSize(width: 1, height: 1)), hotSpot: .zero)
+
     // MARK: - Connection State Overlay
 
     private var connectionOverlay: NSVisualEffectView?
@@ -247,6 +253,19 @@ final class MetalContentView: NSView {
         metalView.needsDisplay = true
     }
 
+    /// Composite a decoded video region into the current frame.
+    /// Streams the server scales are drawn at their decoded size from the region's origin.
+    func compositeVideoFrame(_ frame: SpiceVideoFrame) {
+        renderer.updateRegion(
+            pixelData: frame.data,
+            x: Int(frame.destination.minX),
+            y: Int(frame.destination.minY),
+            width: frame.width,
+            height: frame.height
+        )
+        metalView.needsDisplay = true
+    }
+
     /// Clear the current frame
     func clearFrame() {
         renderer.clearFrame()
@@ -254,6 +273,33 @@ final class MetalContentView: NSView {
         metalView.needsDisplay = true
     }
 
+    // MARK: - Cursor
+
+    /// Show the guest's pointer shape over the view; nil restores the arrow
+    func setGuestCursor(_ cursor: NSCursor?) {
+        applyGuestCursor(cursor ?? .arrow)
+    }
+
+    /// Hide the pointer over the view until the guest sets a new shape
+    func hideGuestCursor() {
+        applyGuestCursor(Self.invisibleCursor)
+    }
+
+    private func applyGuestCursor(_ cursor: NSCursor) {
+        guard cursor !== guestCursor else { return }
+        guestCursor = cursor
+        window?.invalidateCursorRects(for: self)
+
+        // Cursor rects only update on the next mouse move; switch now if the pointer is over us
+        if let window, bounds.contains(convert(window.mouseLocationOutsideOfEventStream, from: nil)) {
+            cursor.set()
+        }
+    }
+
+    override func resetCursorRects() {
+        addCursorRect(bounds, cursor: guestCursor)
+    }
+
     // MARK: - Retina Support
 
     private func updateScaleFactorFromWindow() {
@@ -127,6 +127,10 @@ public final class SpiceFrameRenderer: NSObject, MTKViewDelegate {
             return
         }
 
+        if let damage = frame.damage, updateDamagedRegions(of: frame, damage: damage, scaleFactor: scaleFactor) {
+            return
+        }
+
         // Use the raw data path for minimal copying
         // The frame data is already in BGRA format which matches our texture format
         updateFrame(
@@ -137,6 +141,36 @@ public final class SpiceFrameRenderer: NSObject, MTKViewDelegate {
         )
     }
 
+    /// Uploads only the regions a damage frame changed.
+    /// - Returns: False if the texture doesn't match the frame and needs a full upload
+    private func updateDamagedRegions(of frame: SharedFrame, damage: SharedFrameDamage, scaleFactor: CGFloat) -> Bool {
+        textureLock.lock()
+        defer { textureLock.unlock() }
+
+        guard let texture = currentTexture, textureWidth == frame.width, textureHeight == frame.height,
+              frame.data.count >= frame.stride * frame.height else {
+            return false
+        }
+
+        self.scaleFactor = scaleFactor
+        frame.data.withUnsafeBytes { buffer in
+            guard let baseAddress = buffer.baseAddress else { return }
+            for rect in damage.changedRects {
+                let region = MTLRegion(
+                    origin: MTLOrigin(x: rect.x, y: rect.y, z: 0),
+                    size: MTLSize(width: rect.width, height: rect.height, depth: 1)
+                )
+                texture.replace(
+                    region: region,
+                    mipmapLevel: 0,
+                    withBytes: baseAddress + rect.y * frame.stride + rect.x * 4,
+                    bytesPerRow: frame.stride
+                )
+            }
+        }
+        return true
+    }
+
     /// Update the renderer with a frame using a raw memory pointer (zero-copy).
     /// - Parameters:
     ///   - pointer: Pointer to raw BGRA pixel data
@@ -182,6 +216,43 @@ public final class SpiceFrameRenderer: NSObject, MTKViewDelegate {
         )
     }
 
+    /// Composite pixels into part of the current frame, e.g. a decoded video region.
+    /// The region is clipped to the frame; nothing happens before the first full frame.
+    /// - Parameters:
+    ///   - pixelData: Raw BGRA pixel data for the region, `width * 4` bytes per row
+    ///   - x: Left edge of the region in frame pixels
+    ///   - y: Top edge of the region in frame pixels
+    ///   - width: Region width in pixels
+    ///   - height: Region height in pixels
+    public func updateRegion(pixelData: Data, x: Int, y: Int, width: Int, height: Int) {
+        textureLock.lock()
+        defer { textureLock.unlock() }
+
+        guard let texture = currentTexture else { return }
+
+        let originX = max(x, 0)
+        let originY = max(y, 0)
+        let clippedWidth = min(x + width, textureWidth) - originX
+        let clippedHeight = min(y + height, textureHeight) - originY
+        guard clippedWidth > 0, clippedHeight > 0, pixelData.count >= width * height * 4 else { return }
+
+        let region = MTLRegion(
+            origin: MTLOrigin(x: originX, y: originY, z: 0),
+            size: MTLSize(width: clippedWidth, height: clippedHeight, depth: 1)
+        )
+        let skipBytes = ((originY - y) * width + (originX - x)) * 4
+
+        pixelData.withUnsafeBytes { buffer in
+            guard let baseAddress = buffer.baseAddress else { return }
+            texture.replace(
+                region: region,
+                mipmapLevel: 0,
+                withBytes: baseAddress + skipBytes,
+                bytesPerRow: width * 4
+            )
+        }
+    }
+
     /// Update only the scale factor without providing new pixel data
     public func updateScaleFactor(_ scaleFactor: CGFloat) {
         textureLock.lock()
@@ -11,8 +11,15 @@ import WinRunSpiceBridge
 /// - Spice stream connection and frame delivery
 /// - Input event forwarding (mouse, keyboard, drag/drop)
 /// - Clipboard synchronization
+/// - Native rendering of the guest pointer
 @available(macOS 13, *)
 final class WinRunWindowController: NSObject, SpiceWindowStreamDelegate, MetalContentViewInputDelegate {
+    /// Frame rate for windows that are on screen but not focused
+    private static let backgroundFrameRate: UInt32 = 10
+
+    /// Host memory budget shared by every window's stream
+    private static let memoryBudget = SpiceMemoryBudget()
+
     private var window: NSWindow?
     private let renderer: SpiceFrameRenderer
     private var metalContentView: MetalContentView?
@@ -25,6 +32,9 @@ final class WinRunWindowController: NSObject, SpiceWindowStreamDelegate, MetalCo
     /// Clipboard synchronization
     private let clipboardManager: ClipboardManager
 
+    /// Native cursors for guest pointer shapes, keyed by shape hash
+    private let cursorCache = SpiceCursorShapeCache<NSCursor>()
+
     override init() {
         self.logger = StandardLogger(subsystem: "WinRunWindowController")
         self.stream = SpiceWindowStream(configuration: SpiceStreamConfiguration.environmentDefault())
@@ -32,6 +42,7 @@ final class WinRunWindowController: NSObject, SpiceWindowStreamDelegate, MetalCo
         self.clipboardManager = ClipboardManager()
         super.init()
         stream.delegate = self
+        stream.setMemoryBudget(Self.memoryBudget)
         clipboardManager.delegate = self
     }
 
@@ -168,6 +179,59 @@ final class WinRunWindowController: NSObject, SpiceWindowStreamDelegate, MetalCo
         // Update macOS pasteboard with clipboard data from Windows guest
         clipboardManager.setFromGuest(clipboard)
     }
+
+    func windowStream(_ stream: SpiceWindowStream, didDecodeVideoFrame frame: SpiceVideoFrame) {
+        metalContentView?.compositeVideoFrame(frame)
+    }
+
+    func windowStream(_ stream: SpiceWindowStream, didUpdateCursor event: SpiceCursorEvent) {
+        switch event {
+        case let .set(image):
+            let backingScale = window?.backingScaleFactor ?? 1.0
+            let cursor = cursorCache.value(for: image) { Self.makeCursor(from: $0, backingScale: backingScale) }
+            metalContentView?.setGuestCursor(cursor)
+        case .hide:
+            metalContentView?.hideGuestCursor()
+        case .reset:
+            metalContentView?.setGuestCursor(nil)
+        case .move:
+            // Client mouse mode: the host pointer drives the guest, not the other way round
+            break
+        }
+    }
+
+    /// Builds a native cursor from the bridge's premultiplied BGRA pixels.
+    /// Guest pixels map to backing pixels, matching how frames are sized.
+    private static func makeCursor(from image: SpiceCursorImage, backingScale: CGFloat) -> NSCursor? {
+        guard let provider = CGDataProvider(data: image.data as CFData),
+              let cgImage = CGImage(
+                  width: image.width,
+                  height: image.height,
+                  bitsPerComponent: 8,
+                  bitsPerPixel: 32,
+                  bytesPerRow: image.stride,
+                  space: CGColorSpaceCreateDeviceRGB(),
+                  bitmapInfo: CGBitmapInfo(rawValue: CGImageAlphaInfo.premultipliedFirst.rawValue)
+                      .union(.byteOrder32Little),
+                  provider: provider,
+                  decode: nil,
+                  shouldInterpolate: false,
+                  intent: .defaultIntent
+              )
+        else {
+            return nil
+        }
+
+        let scale = max(backingScale, 1.0)
+        let size = NSSize(width: CGFloat(image.width) / scale, height: CGFloat(image.height) / scale)
+        let hotSpot = NSPoint(x: CGFloat(image.hotspotX) / scale, y: CGFloat(image.hotspotY) / scale)
+        return NSCursor(image: NSImage(cgImage: cgImage, size: size), hotSpot: hotSpot)
+    }
+
+    func windowStreamDidEvictSurface(_ stream: SpiceWindowStream) {
+        // Only hidden windows lose their surface; the next frame after resuming redraws it
+        metalContentView?.clearFrame()
+    }
 }
 
 // MARK: - NSWindowDelegate
@@ -185,11 +249,25 @@ extension WinRunWindowController: NSWindowDelegate {
         guard let window = notification.object as? NSWindow else { return }
         let newScale = window.backingScaleFactor
         logger.debug("Window backing scale factor changed to \(newScale)")
+        // Cached cursors were sized for the old scale; the next shape rebuilds them
+        cursorCache.removeAll()
     }
 
     func windowDidBecomeKey(_ notification: Notification) {
         // Request clipboard from guest when window becomes active
         stream.requestClipboard(format: .plainText)
+        stream.setFocused(true)
+        if !stream.isPaused {
+            stream.setVisibility(.visible)
+        }
+    }
+
+    func windowDidResignKey(_ notification: Notification) {
+        // Unfocused windows stay on screen but don't need the full frame rate
+        stream.setFocused(false)
+        if !stream.isPaused {
+            stream.setVisibility(.background, maxFrameRate: Self.backgroundFrameRate)
+        }
     }
 
     // MARK: - Window Visibility
@@ -211,6 +289,9 @@ extension WinRunWindowController: NSWindowDelegate {
         if window.occlusionState.contains(.visible) {
             logger.debug("Window became visible, resuming stream")
             stream.resume()
+            if !window.isKeyWindow {
+                stream.setVisibility(.background, maxFrameRate: Self.backgroundFrameRate)
+            }
         } else {
             logger.debug("Window fully occluded, pausing stream")
             stream.pause()
@@ -6,17 +6,53 @@ public struct SpiceStreamMetrics: Codable, Hashable {
     public var framesReceived: Int
     public var metadataUpdates: Int
     public var reconnectAttempts: Int
+    /// Frames dropped or deferred because the window was hidden or in the background
+    public var framesThrottled: Int
+    /// Shared-memory frames skipped to show a newer one (drain-to-latest reads)
+    public var framesSkipped: Int
+    /// Video stream frames decoded by the bridge
+    public var videoFramesDecoded: Int
+    /// Video stream frames the bridge dropped because decoding fell behind or failed
+    public var videoFramesDropped: Int
+    /// Dropped connections recovered by re-attaching the existing stream
+    public var sessionResumes: Int
+    /// Frames per second actually delivered to the consumer, smoothed
+    public var effectiveFrameRate: Double
+    /// Capture rate the guest's frame rate governor chose for this window, 0 if unknown
+    public var guestTargetFrameRate: Int
+    /// Why the guest chose `guestTargetFrameRate` (`focused`, `damage`, `capped`, `backpressure`)
+    public var guestRateReason: String?
+    /// Times the guest changed this window's rate or the reason for it
+    public var guestRateChanges: Int
     public var lastErrorDescription: String?
 
     public init(
         framesReceived: Int = 0,
         metadataUpdates: Int = 0,
         reconnectAttempts: Int = 0,
+        framesThrottled: Int = 0,
+        framesSkipped: Int = 0,
+        videoFramesDecoded: Int = 0,
+        videoFramesDropped: Int = 0,
+        sessionResumes: Int = 0,
+        effectiveFrameRate: Double = 0,
+        guestTargetFrameRate: Int = 0,
+        guestRateReason: String? = nil,
+        guestRateChanges: Int = 0,
         lastErrorDescription: String? = nil
     ) {
         self.framesReceived = framesReceived
         self.metadataUpdates = metadataUpdates
         self.reconnectAttempts = reconnectAttempts
+        self.framesThrottled = framesThrottled
+        self.framesSkipped = framesSkipped
+        self.videoFramesDecoded = videoFramesDecoded
+        self.videoFramesDropped = videoFramesDropped
+        self.sessionResumes = sessionResumes
+        self.effectiveFrameRate = effectiveFrameRate
+        self.guestTargetFrameRate = guestTargetFrameRate
+        self.guestRateReason = guestRateReason
+        self.guestRateChanges = guestRateChanges
         self.lastErrorDescription = lastErrorDescription
     }
 }
@@ -32,6 +32,8 @@ public enum SpiceMessageType: UInt8, CaseIterable, Codable, Sendable {
     case listSessions = 0x08
     case closeSession = 0x09
     case listShortcuts = 0x0A
+    case setWindowThrottle = 0x0B
+    case ping = 0x0C
     case shutdown = 0x0F
 
     // Guest → Host (0x80-0xFF)
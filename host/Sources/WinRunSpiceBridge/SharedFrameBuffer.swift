@@ -1,6 +1,10 @@
 import Foundation
 import WinRunShared
 
+#if os(macOS)
+    import CSpiceBridge
+#endif
+
 // MARK: - Shared Memory Frame Buffer Protocol
 //
 // The shared memory region uses a ring buffer design for zero-copy frame transfer.
@@ -12,7 +16,9 @@ import WinRunShared
 //   [Frame Slot N-1: variable]
 //
 // The header contains synchronization state and buffer metadata.
-// Each frame slot contains frame metadata followed by pixel data.
+// Each frame slot contains frame metadata followed by pixel data, or, for
+// slots flagged `.damage`, the changes since the previous frame (see
+// `SharedFrameDamage`).
 
 /// Magic number to identify valid shared memory buffer ("WFRM" in ASCII)
 public let SharedFrameBufferMagic: UInt32 = 0x4D524657
@@ -134,10 +140,15 @@ public struct FrameSlotFlags: OptionSet {
         self.rawValue = rawValue
     }
 
-    /// Frame data is LZ4 compressed
+    /// Frame data is compressed: one LZ4 block, or tiles with `.tiled`
     public static let compressed = FrameSlotFlags(rawValue: 1 << 0)
     /// Frame is a key frame (not a delta)
     public static let keyFrame = FrameSlotFlags(rawValue: 1 << 1)
+    /// Data is a damage payload to apply to the previous frame (never compressed)
+    public static let damage = FrameSlotFlags(rawValue: 1 << 2)
+    /// Set with `.compressed`: the data is a tiled frame, decoded by the bridge
+    /// (guest: TiledFrameEncoder.cs)
+    public static let tiled = FrameSlotFlags(rawValue: 1 << 3)
 }
 
 /// Flags for SharedFrameBufferHeader.flags field
@@ -158,6 +169,186 @@ public struct SharedFrameBufferFlags: OptionSet {
     public static let compressed = SharedFrameBufferFlags(rawValue: 1 << 3)
 }
 
+// MARK: - Frame Damage
+//
+// A damage slot carries what changed since the previous frame instead of the
+// whole frame (guest: FrameDamage.cs). Little-endian:
+//   [moveCount: UInt32][dirtyCount: UInt32]
+//   [moveCount x (sourceX, sourceY, x, y, width, height): Int32]
+//   [dirtyCount x (x, y, width, height): Int32]
+//   [dirty pixels: each dirty rect in order, width * 4 bytes per row]
+// Moves are applied first, as in-place blits on the previous frame, then the
+// dirty pixels are copied in.
+
+/// A rectangle in frame pixels
+public struct SharedFrameRect: Equatable {
+    public var x: Int
+    public var y: Int
+    public var width: Int
+    public var height: Int
+
+    public init(x: Int, y: Int, width: Int, height: Int) {
+        self.x = x
+        self.y = y
+        self.width = width
+        self.height = height
+    }
+
+    /// Whether `other` lies entirely within this rectangle
+    func contains(_ other: SharedFrameRect) -> Bool {
+        other.width >= 0 && other.height >= 0 &&
+            other.x >= x && other.y >= y &&
+            other.x + other.width <= x + width &&
+            other.y + other.height <= y + height
+    }
+}
+
+/// A region whose pixels moved from (`sourceX`, `sourceY`) in the previous frame
+public struct SharedFrameMoveRect: Equatable {
+    public var sourceX: Int
+    public var sourceY: Int
+    public var destination: SharedFrameRect
+
+    public init(sourceX: Int, sourceY: Int, destination: SharedFrameRect) {
+        self.sourceX = sourceX
+        self.sourceY = sourceY
+        self.destination = destination
+    }
+}
+
+/// The regions of a frame that moved or changed since the previous frame
+public struct SharedFrameDamage: Equatable {
+    public var moveRects: [SharedFrameMoveRect]
+    public var dirtyRects: [SharedFrameRect]
+
+    static let headerSize = 8
+    static let moveRectSize = 24
+    static let dirtyRectSize = 16
+    static let bytesPerPixel = 4
+
+    public init(moveRects: [SharedFrameMoveRect] = [], dirtyRects: [SharedFrameRect] = []) {
+        self.moveRects = moveRects
+        self.dirtyRects = dirtyRects
+    }
+
+    /// Every region whose pixels differ from the previous frame
+    public var changedRects: [SharedFrameRect] {
+        moveRects.map(\.destination) + dirtyRects
+    }
+
+    /// Applies a damage payload to a frame in place.
+    /// - Parameters:
+    ///   - payload: The slot data of a `.damage` slot
+    ///   - surface: The previous frame's pixels, updated in place
+    ///   - width: Frame width in pixels
+    ///   - height: Frame height in pixels
+    ///   - stride: Bytes per row of `surface`
+    /// - Returns: The damage that was applied
+    /// - Throws: `SharedFrameBufferError.invalidDamage` if the payload is truncated or
+    ///   a rectangle falls outside the frame. Nothing is written in that case.
+    public static func apply(
+        payload: UnsafeRawBufferPointer,
+        to surface: UnsafeMutableRawBufferPointer,
+        width: Int,
+        height: Int,
+        stride: Int
+    ) throws -> SharedFrameDamage {
+        guard payload.count >= headerSize, stride >= width * bytesPerPixel, surface.count >= stride * height,
+              let source = payload.baseAddress, let base = surface.baseAddress else {
+            throw SharedFrameBufferError.invalidDamage("payload or surface too small")
+        }
+
+        func int32(at offset: Int) -> Int {
+            Int(Int32(littleEndian: payload.loadUnaligned(fromByteOffset: offset, as: Int32.self)))
+        }
+
+        let moveCount = Int(UInt32(littleEndian: payload.loadUnaligned(fromByteOffset: 0, as: UInt32.self)))
+        let dirtyCount = Int(UInt32(littleEndian: payload.loadUnaligned(fromByteOffset: 4, as: UInt32.self)))
+        guard moveCount <= payload.count / moveRectSize, dirtyCount <= payload.count / dirtyRectSize else {
+            throw SharedFrameBufferError.invalidDamage("rect counts exceed payload")
+        }
+
+        let rectsEnd = headerSize + moveCount * moveRectSize + dirtyCount * dirtyRectSize
+        guard rectsEnd <= payload.count else {
+            throw SharedFrameBufferError.invalidDamage("truncated rect list")
+        }
+
+        let frame = SharedFrameRect(x: 0, y: 0, width: width, height: height)
+        var damage = SharedFrameDamage()
+        var offset = headerSize
+
+        for _ in 0..<moveCount {
+            let move = SharedFrameMoveRect(
+                sourceX: int32(at: offset),
+                sourceY: int32(at: offset + 4),
+                destination: SharedFrameRect(
+                    x: int32(at: offset + 8),
+                    y: int32(at: offset + 12),
+                    width: int32(at: offset + 16),
+                    height: int32(at: offset + 20)
+                )
+            )
+            let moveSource = SharedFrameRect(
+                x: move.sourceX,
+                y: move.sourceY,
+                width: move.destination.width,
+                height: move.destination.height
+            )
+            guard frame.contains(move.destination), frame.contains(moveSource) else {
+                throw SharedFrameBufferError.invalidDamage("move rect outside frame")
+            }
+            damage.moveRects.append(move)
+            offset += moveRectSize
+        }
+
+        var pixelBytes = 0
+        for _ in 0..<dirtyCount {
+            let rect = SharedFrameRect(
+                x: int32(at: offset),
+                y: int32(at: offset + 4),
+                width: int32(at: offset + 8),
+                height: int32(at: offset + 12)
+            )
+            guard frame.contains(rect) else {
+                throw SharedFrameBufferError.invalidDamage("dirty rect outside frame")
+            }
+            damage.dirtyRects.append(rect)
+            pixelBytes += rect.width * rect.height * bytesPerPixel
+            offset += dirtyRectSize
+        }
+
+        guard rectsEnd + pixelBytes <= payload.count else {
+            throw SharedFrameBufferError.invalidDamage("truncated dirty pixels")
+        }
+
+        for move in damage.moveRects {
+            let rowBytes = move.destination.width * bytesPerPixel
+            // Overlapping scrolls must read each row before it is overwritten,
+            // so walk away from the destination; copyMemory handles overlap within a row
+            let rows: [Int] = move.destination.y > move.sourceY
+                ? Array((0..<move.destination.height).reversed())
+                : Array(0..<move.destination.height)
+            for row in rows {
+                let from = base + (move.sourceY + row) * stride + move.sourceX * bytesPerPixel
+                let to = base + (move.destination.y + row) * stride + move.destination.x * bytesPerPixel
+                to.copyMemory(from: UnsafeRawPointer(from), byteCount: rowBytes)
+            }
+        }
+
+        var pixelOffset = rectsEnd
+        for rect in damage.dirtyRects {
+            let rowBytes = rect.width * bytesPerPixel
+            for row in 0..<rect.height {
+                let to = base + (rect.y + row) * stride + rect.x * bytesPerPixel
+                to.copyMemory(from: source + pixelOffset, byteCount: rowBytes)
+                pixelOffset += rowBytes
+            }
+        }
+
+        return damage
+    }
+}
+
 // MARK: - Host-Side Frame Buffer Reader
 
 /// Errors that can occur during shared frame buffer operations.
@@ -168,6 +359,9 @@ public enum SharedFrameBufferError: Error, CustomStringConvertible {
     case noFramesAvailable
     case slotIndexOutOfBounds
     case mappingFailed(String)
+    case invalidDamage(String)
+    case missingKeyFrame
+    case invalidTiles(String)
 
     public var description: String {
         switch self {
@@ -183,6 +377,12 @@ public enum SharedFrameBufferError: Error, CustomStringConvertible {
             return "Frame slot index out of bounds"
         case .mappingFailed(let reason):
             return "Memory mapping failed: \(reason)"
+        case .invalidDamage(let reason):
+            return "Invalid damage frame: \(reason)"
+        case .missingKeyFrame:
+            return "Damage frame has no key frame to apply to"
+        case .invalidTiles(let reason):
+            return "Invalid tiled frame: \(reason)"
         }
     }
 }
@@ -197,6 +397,10 @@ public struct SharedFrame {
     public let format: SpicePixelFormat
     public let data: Data
     public let isCompressed: Bool
+    /// What changed since the previous frame returned by the reader, or nil for a
+    /// key frame or when skipped frames changed more. `data` is always the complete
+    /// frame; consumers can use this to upload only the changed regions.
+    public let damage: SharedFrameDamage?
 
     public init(
         windowId: UInt64,
@@ -206,7 +410,8 @@ public struct SharedFrame {
         stride: Int,
         format: SpicePixelFormat,
         data: Data,
-        isCompressed: Bool = false
+        isCompressed: Bool = false,
+        damage: SharedFrameDamage? = nil
     ) {
         self.windowId = windowId
         self.frameNumber = frameNumber
@@ -216,17 +421,33 @@ public struct SharedFrame {
         self.format = format
         self.data = data
         self.isCompressed = isCompressed
+        self.damage = damage
     }
 }
 
 /// Host-side reader for the shared frame buffer.
 /// Reads frames written by the guest agent.
+///
+/// The reader keeps the last complete frame it read or skipped, and applies
+/// damage slots to it, so every frame it returns is complete.
 public final class SharedFrameBufferReader {
-    private let memoryPointer: UnsafeMutableRawPointer
-    private let memorySize: Int
+    private var memoryPointer: UnsafeMutableRawPointer
+    private var memorySize: Int
     private let ownsMemory: Bool
     private let logger: Logger
 
+    /// The current frame, composed from the last key frame and the damage since.
+    /// Nil until an uncompressed key frame arrives, or after damage failed to apply.
+    private var surface: Data?
+    private var surfaceHeader = FrameSlotHeader()
+    /// Whether discarded frames changed the surface since the last frame returned,
+    /// in which case the next frame's damage doesn't cover everything that changed
+    private var surfaceChangedSinceRead = false
+
+    /// Smoothed time to decode a tiled key frame, nil until one is decoded.
+    /// Reported to the guest so it can weigh LZ4 tiles against raw ones.
+    public private(set) var tileDecodeTime: Duration?
+
     /// Creates a reader with an existing memory region.
     /// - Parameters:
     ///   - pointer: Pointer to the shared memory region
@@ -251,6 +472,21 @@ public final class SharedFrameBufferReader {
         }
     }
 
+    /// Whether the reader is mapped onto this memory.
+    public func isMapped(to pointer: UnsafeMutableRawPointer, size: Int) -> Bool {
+        memoryPointer == pointer && memorySize == size
+    }
+
+    /// Moves the reader onto a reallocated buffer. The composed surface is
+    /// kept, so whoever holds the reader carries on without reattaching it;
+    /// the guest starts a new buffer with a key frame.
+    /// - Precondition: The reader doesn't own its memory.
+    public func remap(pointer: UnsafeMutableRawPointer, size: Int) {
+        precondition(!ownsMemory, "Only readers over borrowed memory can be remapped")
+        memoryPointer = pointer
+        memorySize = size
+    }
+
     /// Validates the shared memory buffer header.
     public func validate() throws {
         guard memorySize >= SharedFrameBufferHeader.size else {
@@ -280,14 +516,6 @@ public final class SharedFrameBufferReader {
         memoryPointer.assumingMemoryBound(to: SharedFrameBufferHeader.self).pointee
     }
 
-    /// Updates the read index after consuming a frame.
-    private func advanceReadIndex() {
-        let headerPtr = memoryPointer.assumingMemoryBound(to: SharedFrameBufferHeader.self)
-        let currentRead = headerPtr.pointee.readIndex
-        let slotCount = headerPtr.pointee.slotCount
-        headerPtr.pointee.readIndex = (currentRead + 1) % slotCount
-    }
-
     /// Whether frames are available to read.
     public var hasFrames: Bool {
         readHeader().hasFrames
@@ -312,6 +540,72 @@ public final class SharedFrameBufferReader {
             throw SharedFrameBufferError.slotIndexOutOfBounds
         }
 
+        let (slotHeader, payload) = try slotContents(slotIndex, in: header)
+
+        // Hand the slot back once it is decoded; one that fails to decode must not wedge the ring
+        defer { releaseSlots(1) }
+
+        return try decodeSlot(slotHeader, payload: payload)
+    }
+
+    /// Reads the newest pending frame, skipping any older ones.
+    ///
+    /// Skipped frames are folded into the composed frame as `discardFrames`
+    /// does, and every slot read is handed back to the guest in one store
+    /// once it has been read. Unless a skipped frame was a key frame, the
+    /// returned frame's damage still covers everything that changed since the
+    /// previous frame returned: the skipped changes are merged in as dirty rects.
+    ///
+    /// On macOS the ring's indices go through the C bridge, which loads the
+    /// write index with acquire and stores the read index with release ordering.
+    /// - Returns: The frame and the number of frames skipped to reach it, or nil if no frames are pending
+    public func readLatestFrame() throws -> (frame: SharedFrame, skipped: Int)? {
+        guard let pending = pendingSlots(), pending.count > 0 else {
+            return nil
+        }
+
+        let header = readHeader()
+        // Hand the slots back even if the newest one fails to decode
+        defer { releaseSlots(pending.count) }
+
+        let skipped = pending.count - 1
+        let slots = (0..<skipped).map { (pending.first + UInt32($0)) % pending.slotCount }
+        let lastKeyFrame = lastKeyFrameIndex(among: slots, in: header)
+
+        // What changed since the last frame returned, or nil if that is the whole frame
+        var changed: [SharedFrameRect]? = surfaceChangedSinceRead || lastKeyFrame != nil ? nil : []
+        for slot in slots[(lastKeyFrame ?? 0)...] {
+            let damage = absorbSlot(slot, in: header)
+            changed = damage.flatMap { damage in changed.map { $0 + damage.changedRects } }
+        }
+        surfaceChangedSinceRead = changed == nil
+
+        let latest = (pending.first + UInt32(skipped)) % pending.slotCount
+        let (slotHeader, payload) = try slotContents(latest, in: header)
+        let frame = try decodeSlot(slotHeader, payload: payload)
+
+        guard skipped > 0, let changed, let damage = frame.damage else {
+            return (frame, skipped)
+        }
+        let merged = SharedFrame(
+            windowId: frame.windowId,
+            frameNumber: frame.frameNumber,
+            width: frame.width,
+            height: frame.height,
+            stride: frame.stride,
+            format: frame.format,
+            data: frame.data,
+            isCompressed: frame.isCompressed,
+            damage: SharedFrameDamage(dirtyRects: changed + damage.changedRects)
+        )
+        return (merged, skipped)
+    }
+
+    /// Locates a slot's header and data, checking both lie inside the mapping.
+    private func slotContents(
+        _ slotIndex: UInt32,
+        in header: SharedFrameBufferHeader
+    ) throws -> (FrameSlotHeader, UnsafeRawBufferPointer) {
         // Calculate slot offset
         let slotOffset = SharedFrameBufferHeader.size + Int(slotIndex) * Int(header.slotSize)
         guard slotOffset + FrameSlotHeader.size <= memorySize else {
@@ -333,31 +627,121 @@ public final class SharedFrameBufferReader {
             )
         }
 
-        let dataPtr = memoryPointer.advanced(by: dataOffset)
-        let data = Data(bytes: dataPtr, count: dataSize)
+        return (slotHeader, UnsafeRawBufferPointer(start: memoryPointer.advanced(by: dataOffset), count: dataSize))
+    }
 
+    /// Turns a slot into a complete frame, composing damage onto the surface.
+    private func decodeSlot(_ slotHeader: FrameSlotHeader, payload: UnsafeRawBufferPointer) throws -> SharedFrame {
         let slotFlags = FrameSlotFlags(rawValue: slotHeader.flags)
         let format = SpicePixelFormat(rawValue: UInt8(truncatingIfNeeded: slotHeader.format)) ?? .bgra32
 
-        let frame = SharedFrame(
-            windowId: slotHeader.windowId,
-            frameNumber: slotHeader.frameNumber,
-            width: Int(slotHeader.width),
-            height: Int(slotHeader.height),
-            stride: Int(slotHeader.stride),
-            format: format,
-            data: data,
-            isCompressed: slotFlags.contains(.compressed)
-        )
-
-        // Advance read pointer
-        advanceReadIndex()
+        let frame: SharedFrame
+        if slotFlags.contains(.damage) {
+            let damage = try applyDamage(slotHeader, payload: payload)
+            frame = SharedFrame(
+                windowId: slotHeader.windowId,
+                frameNumber: slotHeader.frameNumber,
+                width: Int(surfaceHeader.width),
+                height: Int(surfaceHeader.height),
+                stride: Int(surfaceHeader.stride),
+                format: format,
+                data: surface ?? Data(),
+                damage: surfaceChangedSinceRead ? nil : damage
+            )
+        } else {
+            let (keyHeader, data) = try keyFrame(slotHeader, payload: payload)
+            keepSurface(keyHeader, data: data)
+            frame = SharedFrame(
+                windowId: slotHeader.windowId,
+                frameNumber: slotHeader.frameNumber,
+                width: Int(slotHeader.width),
+                height: Int(slotHeader.height),
+                stride: Int(slotHeader.stride),
+                format: format,
+                data: data,
+                isCompressed: FrameSlotFlags(rawValue: keyHeader.flags).contains(.compressed)
+            )
+        }
 
+        surfaceChangedSinceRead = false
         logger.debug("Read frame \(slotHeader.frameNumber) for window \(slotHeader.windowId): \(slotHeader.width)x\(slotHeader.height)")
 
         return frame
     }
 
+    /// Gives read-only access to the newest pending frame without copying it
+    /// or advancing the read index.
+    ///
+    /// The pointer is only valid inside `body`; the guest will not overwrite
+    /// the slot while it is still pending.
+    /// - Returns: The result of `body`, or nil if no frames are pending
+    public func withLatestFrame<T>(
+        _ body: (FrameSlotHeader, UnsafeRawBufferPointer) throws -> T
+    ) throws -> T? {
+        let header = readHeader()
+
+        guard header.hasFrames, header.slotCount > 0 else {
+            return nil
+        }
+
+        let slotIndex = (header.writeIndex + header.slotCount - 1) % header.slotCount
+        let slotOffset = SharedFrameBufferHeader.size + Int(slotIndex) * Int(header.slotSize)
+        guard slotOffset + FrameSlotHeader.size <= memorySize else {
+            throw SharedFrameBufferError.slotIndexOutOfBounds
+        }
+
+        let slotPtr = memoryPointer.advanced(by: slotOffset)
+        let slotHeader = loadFrameSlotHeader(from: slotPtr)
+
+        let dataOffset = slotOffset + FrameSlotHeader.size
+        let dataSize = Int(slotHeader.dataSize)
+        guard dataOffset + dataSize <= memorySize else {
+            throw SharedFrameBufferError.bufferTooSmall(
+                required: dataOffset + dataSize,
+                actual: memorySize
+            )
+        }
+
+        let bytes = UnsafeRawBufferPointer(start: memoryPointer.advanced(by: dataOffset), count: dataSize)
+        return try body(slotHeader, bytes)
+    }
+
+    /// Gives read-only access to the reader's composed copy of the current frame.
+    ///
+    /// Unlike `withLatestFrame`, this is always a complete frame, but it lags
+    /// the ring by any frames still pending.
+    /// - Returns: The result of `body`, or nil before the first uncompressed key frame
+    public func withComposedFrame<T>(
+        _ body: (FrameSlotHeader, UnsafeRawBufferPointer) throws -> T
+    ) rethrows -> T? {
+        guard let surface else { return nil }
+        return try surface.withUnsafeBytes { try body(surfaceHeader, $0) }
+    }
+
+    /// Discards pending frames without returning them.
+    ///
+    /// Damage in the skipped slots is still applied to the composed frame, since
+    /// later damage is relative to it; only the newest key frame among them is copied.
+    /// The slots go back to the guest in one store, ordered as in `readLatestFrame`.
+    /// - Parameter keepingLatest: Leave the most recent frame readable
+    /// - Returns: The number of frames discarded
+    @discardableResult
+    public func discardFrames(keepingLatest: Bool = false) -> Int {
+        guard let pending = pendingSlots() else { return 0 }
+        let toDiscard = keepingLatest ? max(pending.count - 1, 0) : pending.count
+        guard toDiscard > 0 else { return 0 }
+
+        let header = readHeader()
+        let slots = (0..<toDiscard).map { (pending.first + UInt32($0)) % pending.slotCount }
+        let lastKeyFrame = lastKeyFrameIndex(among: slots, in: header)
+        for slot in slots[(lastKeyFrame ?? 0)...] {
+            absorbSlot(slot, in: header)
+        }
+
+        releaseSlots(toDiscard)
+        return toDiscard
+    }
+
     /// Signals that the host is actively reading.
     public func setHostActive(_ active: Bool) {
         let headerPtr = memoryPointer.assumingMemoryBound(to: SharedFrameBufferHeader.self)
@@ -370,6 +754,173 @@ public final class SharedFrameBufferReader {
         headerPtr.pointee.flags = flags.rawValue
     }
 
+    /// Slots waiting to be read, as the C bridge loads them on macOS.
+    private struct PendingSlots {
+        var first: UInt32
+        var count: Int
+        var slotCount: UInt32
+    }
+
+    /// Loads the ring's indices, or nil if they are out of range.
+    private func pendingSlots() -> PendingSlots? {
+        #if os(macOS)
+            var span = winrun_ring_span()
+            guard winrun_ring_pending(memoryPointer, memorySize, &span) else { return nil }
+            return PendingSlots(first: span.first, count: Int(span.pending), slotCount: span.slot_count)
+        #else
+            guard memorySize >= SharedFrameBufferHeader.size else { return nil }
+            let header = readHeader()
+            guard header.slotCount > 0, header.writeIndex < header.slotCount, header.readIndex < header.slotCount else {
+                return nil
+            }
+            return PendingSlots(first: header.readIndex, count: Int(header.availableFrames), slotCount: header.slotCount)
+        #endif
+    }
+
+    /// Hands the oldest `count` pending slots back to the guest.
+    private func releaseSlots(_ count: Int) {
+        #if os(macOS)
+            _ = winrun_ring_release(memoryPointer, memorySize, UInt32(count))
+        #else
+            let headerPtr = memoryPointer.assumingMemoryBound(to: SharedFrameBufferHeader.self)
+            headerPtr.pointee.readIndex = (headerPtr.pointee.readIndex + UInt32(count)) % headerPtr.pointee.slotCount
+        #endif
+    }
+
+    /// Position in `slots` of the last key frame, which makes everything before it
+    /// irrelevant. Slots that can't be read count as key frames.
+    private func lastKeyFrameIndex(among slots: [UInt32], in header: SharedFrameBufferHeader) -> Int? {
+        slots.lastIndex { slot in
+            guard let slotHeader = loadSlotHeader(slot, in: header) else { return true }
+            return !FrameSlotFlags(rawValue: slotHeader.flags).contains(.damage)
+        }
+    }
+
+    /// Loads the header of a slot, or nil if the slot lies outside the mapping.
+    private func loadSlotHeader(_ slotIndex: UInt32, in header: SharedFrameBufferHeader) -> FrameSlotHeader? {
+        let slotOffset = SharedFrameBufferHeader.size + Int(slotIndex) * Int(header.slotSize)
+        guard slotOffset + FrameSlotHeader.size <= memorySize else { return nil }
+        return loadFrameSlotHeader(from: memoryPointer.advanced(by: slotOffset))
+    }
+
+    /// Folds a skipped slot into the composed frame.
+    /// - Returns: The damage applied, or nil for a key frame or a slot that couldn't be applied
+    @discardableResult
+    private func absorbSlot(_ slotIndex: UInt32, in header: SharedFrameBufferHeader) -> SharedFrameDamage? {
+        surfaceChangedSinceRead = true
+        let dataOffset = SharedFrameBufferHeader.size + Int(slotIndex) * Int(header.slotSize) + FrameSlotHeader.size
+        guard let slotHeader = loadSlotHeader(slotIndex, in: header),
+              dataOffset + Int(slotHeader.dataSize) <= memorySize else {
+            surface = nil
+            return nil
+        }
+
+        let payload = UnsafeRawBufferPointer(
+            start: memoryPointer.advanced(by: dataOffset),
+            count: Int(slotHeader.dataSize)
+        )
+        if FrameSlotFlags(rawValue: slotHeader.flags).contains(.damage) {
+            do {
+                return try applyDamage(slotHeader, payload: payload)
+            } catch {
+                logger.debug("Dropped damage for skipped frame \(slotHeader.frameNumber): \(error)")
+            }
+        } else {
+            do {
+                let (keyHeader, data) = try keyFrame(slotHeader, payload: payload)
+                keepSurface(keyHeader, data: data)
+            } catch {
+                logger.debug("Dropped skipped key frame \(slotHeader.frameNumber): \(error)")
+            }
+        }
+        return nil
+    }
+
+    /// Returns a key frame's pixels and the header describing them. Tiled
+    /// slots are decoded into `stride`-byte rows, so they can be composed onto
+    /// like uncompressed frames; other slots are copied as they are.
+    private func keyFrame(_ slotHeader: FrameSlotHeader, payload: UnsafeRawBufferPointer) throws -> (FrameSlotHeader, Data) {
+        guard FrameSlotFlags(rawValue: slotHeader.flags).contains(.tiled) else {
+            return (slotHeader, Data(payload))
+        }
+
+        #if os(macOS)
+            let width = Int(slotHeader.width)
+            let height = Int(slotHeader.height)
+            let stride = Int(slotHeader.stride)
+            guard width > 0, height > 0, stride >= width * SharedFrameDamage.bytesPerPixel else {
+                // Later damage must not land on the previous key frame
+                surface = nil
+                throw SharedFrameBufferError.invalidTiles("bad frame geometry")
+            }
+
+            var data = Data(count: stride * height)
+            let clock = ContinuousClock()
+            let start = clock.now
+            let decoded = data.withUnsafeMutableBytes { dest in
+                winrun_tiles_decode(
+                    payload.baseAddress?.assumingMemoryBound(to: UInt8.self),
+                    payload.count,
+                    slotHeader.width,
+                    slotHeader.height,
+                    dest.baseAddress?.assumingMemoryBound(to: UInt8.self),
+                    stride,
+                    nil
+                )
+            }
+            guard decoded else {
+                surface = nil
+                throw SharedFrameBufferError.invalidTiles("malformed payload")
+            }
+            let elapsed = clock.now - start
+            // Smooth over roughly the last eight frames
+            tileDecodeTime = tileDecodeTime.map { $0 * 0.875 + elapsed * 0.125 } ?? elapsed
+
+            var keyHeader = slotHeader
+            keyHeader.flags &= ~(FrameSlotFlags.compressed.rawValue | FrameSlotFlags.tiled.rawValue)
+            keyHeader.dataSize = UInt32(data.count)
+            return (keyHeader, data)
+        #else
+            // No bridge to decode with; hand the payload on as compressed
+            return (slotHeader, Data(payload))
+        #endif
+    }
+
+    /// Records a key frame as the base for following damage slots.
+    private func keepSurface(_ slotHeader: FrameSlotHeader, data: Data) {
+        guard !FrameSlotFlags(rawValue: slotHeader.flags).contains(.compressed) else {
+            // Compressed frames can't be composed onto
+            surface = nil
+            return
+        }
+        surface = data
+        surfaceHeader = slotHeader
+    }
+
+    /// Applies a damage slot to the composed frame.
+    private func applyDamage(_ slotHeader: FrameSlotHeader, payload: UnsafeRawBufferPointer) throws -> SharedFrameDamage {
+        guard var current = surface,
+              slotHeader.width == surfaceHeader.width,
+              slotHeader.height == surfaceHeader.height else {
+            surface = nil
+            throw SharedFrameBufferError.missingKeyFrame
+        }
+
+        // Drop our reference first so the update is in place unless a consumer
+        // still holds the previous frame
+        surface = nil
+        let width = Int(surfaceHeader.width)
+        let height = Int(surfaceHeader.height)
+        let stride = Int(surfaceHeader.stride)
+        let damage = try current.withUnsafeMutableBytes { bytes in
+            try SharedFrameDamage.apply(payload: payload, to: bytes, width: width, height: height, stride: stride)
+        }
+
+        surface = current
+        surfaceHeader.frameNumber = slotHeader.frameNumber
+        return damage
+    }
+
     /// Loads a FrameSlotHeader from a potentially unaligned pointer.
     /// Reads fields individually to handle misalignment safely.
     private func loadFrameSlotHeader(from ptr: UnsafeRawPointer) -> FrameSlotHeader {
@@ -482,18 +1033,26 @@ public struct FrameReadyMessage: GuestMessage {
     public let frameNumber: UInt32
     /// Whether this is a key frame (full frame vs delta)
     public let isKeyFrame: Bool
+    /// Capture rate the guest's governor chose for the window, if it reports one
+    public let targetFps: UInt32?
+    /// Why the guest chose `targetFps` (`focused`, `damage`, `capped`, `backpressure`)
+    public let rateReason: String?
 
     public init(
         timestamp: Int64 = Int64(Date().timeIntervalSince1970 * 1000),
         windowId: UInt64,
         slotIndex: UInt32,
         frameNumber: UInt32,
-        isKeyFrame: Bool = true
+        isKeyFrame: Bool = true,
+        targetFps: UInt32? = nil,
+        rateReason: String? = nil
     ) {
         self.timestamp = timestamp
         self.windowId = windowId
         self.slotIndex = slotIndex
         self.frameNumber = frameNumber
         self.isKeyFrame = isKeyFrame
+        self.targetFps = targetFps
+        self.rateReason = rateReason
     }
 }
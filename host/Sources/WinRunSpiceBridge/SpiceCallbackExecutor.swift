@@ -0,0 +1,91 @@
+import Foundation
+
+#if os(macOS)
+    import CSpiceBridge
+#endif
+
+/// Counters for a `SpiceCallbackExecutor`.
+public struct SpiceCallbackExecutorStats: Equatable {
+    /// Events the bridge queued
+    public var posted: UInt64 = 0
+    /// Drains scheduled on the executor's queue
+    public var wakeups: UInt64 = 0
+    /// Events run by drains
+    public var drained: UInt64 = 0
+    /// Events dropped because their stream closed or allocation failed
+    public var dropped: UInt64 = 0
+    /// Queued frames replaced by a newer frame from the same stream
+    public var coalesced: UInt64 = 0
+
+    public init() {}
+}
+
+/// Runs bridge callbacks for any number of streams on one serial queue.
+///
+/// Without an executor, each bridge callback runs on the libspice thread that
+/// fired it, and the stream immediately dispatches it to its own queue. With
+/// one, the bridge copies events into a queue of its own and wakes this
+/// executor once; a single block on `queue` then runs every event queued so
+/// far. Streams created with the same executor also run their state on
+/// `queue`, so that block handles their events without further hops.
+///
+/// Close every stream that uses the executor before releasing it.
+public final class SpiceCallbackExecutor {
+    /// Where callbacks and the state of streams using this executor run
+    public let queue: DispatchQueue
+
+    #if os(macOS)
+        /// Nil only if the bridge couldn't allocate the executor; streams then
+        /// keep their callbacks inline
+        private(set) var handle: winrun_executor_handle?
+    #endif
+
+    public init(label: String = "com.winrun.spice.callbacks", qos: DispatchQoS = .userInteractive) {
+        queue = DispatchQueue(label: label, qos: qos)
+        #if os(macOS)
+            // Unretained: streams are closed before the executor goes away, and
+            // each scheduled drain holds its own reference
+            handle = winrun_executor_create(spiceExecutorWakeupThunk, Unmanaged.passUnretained(self).toOpaque())
+        #endif
+    }
+
+    deinit {
+        #if os(macOS)
+            winrun_executor_destroy(handle)
+        #endif
+    }
+
+    /// The bridge's counters; all zero where there is no bridge.
+    public func statistics() -> SpiceCallbackExecutorStats {
+        var result = SpiceCallbackExecutorStats()
+        #if os(macOS)
+            var stats = winrun_executor_stats()
+            if winrun_executor_get_stats(handle, &stats) {
+                result.posted = stats.posted
+                result.wakeups = stats.wakeups
+                result.drained = stats.drained
+                result.dropped = stats.dropped
+                result.coalesced = stats.coalesced
+            }
+        #endif
+        return result
+    }
+
+    #if os(macOS)
+        fileprivate func scheduleDrain() {
+            queue.async {
+                winrun_executor_drain(self.handle)
+            }
+        }
+    #endif
+}
+
+#if os(macOS)
+    private let spiceExecutorWakeupThunk:
+        @convention(c) (UnsafeMutableRawPointer?) -> Void = { userData in
+            guard let userData else { return }
+            Unmanaged<SpiceCallbackExecutor>.fromOpaque(userData)
+                .takeUnretainedValue()
+                .scheduleDrain()
+        }
+#endif
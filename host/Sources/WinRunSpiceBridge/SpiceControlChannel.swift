@@ -47,6 +47,10 @@ public protocol SpiceControlChannelDelegate: AnyObject {
     /// Called when a window's frame buffer has been allocated or reallocated.
     /// Host should update its buffer mapping for this window.
     func controlChannel(_ channel: SpiceControlChannel, didReceiveBufferAllocation notification: WindowBufferAllocatedMessage)
+
+    /// Called when the heartbeat finds the guest stalled, or answering again.
+    /// See `SpiceControlChannel.startHeartbeat(interval:stallAfter:)`.
+    func controlChannel(_ channel: SpiceControlChannel, didChangeGuestHealth health: SpiceGuestHealth, statistics: SpiceHeartbeatStats)
 }
 
 /// Extension with default implementations
@@ -56,6 +60,7 @@ public extension SpiceControlChannelDelegate {
     func controlChannel(_ channel: SpiceControlChannel, didReceiveMessage message: Any, type: SpiceMessageType) {}
     func controlChannel(_ channel: SpiceControlChannel, didReceiveFrameReady notification: FrameReadyMessage) {}
     func controlChannel(_ channel: SpiceControlChannel, didReceiveBufferAllocation notification: WindowBufferAllocatedMessage) {}
+    func controlChannel(_ channel: SpiceControlChannel, didChangeGuestHealth health: SpiceGuestHealth, statistics: SpiceHeartbeatStats) {}
 }
 
 /// A control channel for sending commands to the guest agent and receiving responses.
@@ -65,8 +70,8 @@ public extension SpiceControlChannelDelegate {
 public actor SpiceControlChannel {
     private let logger: Logger
     private let configuration: SpiceStreamConfiguration
-    private var messageIdCounter: UInt32 = 0
-    private var pendingStreams: [UInt32: AsyncThrowingStream<Any, Error>.Continuation] = [:]
+    // Message IDs, in-flight requests and their timeouts
+    private let requests = SpiceRequestTracker()
     private var isConnected: Bool = false
 
     // Transport for actual Spice communication
@@ -126,7 +131,9 @@ public actor SpiceControlChannel {
                     await self?.handleTransportClosed(reason)
                 }
             },
-            onClipboard: { _ in }
+            onClipboard: { _ in },
+            onCursor: { _ in },
+            onVideoFrame: { _ in }
         )
 
         do {
@@ -142,6 +149,8 @@ public actor SpiceControlChannel {
                     try? await self?.handleReceivedData(data)
                 }
             }
+            // Responses then complete in the bridge, without a hop through the actor
+            transport?.setRequestTracker(requests)
 
             isConnected = true
             _delegate?.controlChannelDidConnect(self)
@@ -163,11 +172,8 @@ public actor SpiceControlChannel {
 
         isConnected = false
 
-        // Cancel all pending streams
-        for (_, streamContinuation) in pendingStreams {
-            streamContinuation.finish(throwing: SpiceControlError.notConnected)
-        }
-        pendingStreams.removeAll()
+        // Fail all pending requests
+        requests.cancelAll()
         _delegate?.controlChannelDidDisconnect(self)
     }
 
@@ -175,11 +181,8 @@ public actor SpiceControlChannel {
         logger.warn("Control channel transport closed: \(reason.message)")
         isConnected = false
 
-        // Cancel all pending streams
-        for (_, streamContinuation) in pendingStreams {
-            streamContinuation.finish(throwing: SpiceControlError.notConnected)
-        }
-        pendingStreams.removeAll()
+        // Fail all pending requests
+        requests.cancelAll()
         _delegate?.controlChannelDidDisconnect(self)
     }
 
@@ -192,12 +195,11 @@ public actor SpiceControlChannel {
     /// - Parameter timeout: Maximum time to wait for response
     /// - Returns: List of guest sessions
     public func listSessions(timeout: Duration = .seconds(5)) async throws -> GuestSessionList {
-        let messageId = nextMessageId()
-        let request = ListSessionsSpiceMessage(messageId: messageId)
+        logger.debug("Sending ListSessions request")
 
-        logger.debug("Sending ListSessions request (messageId: \(messageId))")
-
-        let response = try await sendAndWait(request, messageId: messageId, timeout: timeout)
+        let response = try await sendAndWait(timeout: timeout) { messageId in
+            ListSessionsSpiceMessage(messageId: messageId)
+        }
 
         guard let sessionList = response as? SessionListMessage else {
             throw SpiceControlError.unexpectedResponse("Expected SessionListMessage, got \(type(of: response))")
@@ -211,12 +213,11 @@ public actor SpiceControlChannel {
     ///   - sessionId: ID of the session to close
     ///   - timeout: Maximum time to wait for acknowledgement
     public func closeSession(_ sessionId: String, timeout: Duration = .seconds(5)) async throws {
-        let messageId = nextMessageId()
-        let request = CloseSessionSpiceMessage(messageId: messageId, sessionId: sessionId)
-
-        logger.debug("Sending CloseSession request for \(sessionId) (messageId: \(messageId))")
+        logger.debug("Sending CloseSession request for \(sessionId)")
 
-        let response = try await sendAndWait(request, messageId: messageId, timeout: timeout)
+        let response = try await sendAndWait(timeout: timeout) { messageId in
+            CloseSessionSpiceMessage(messageId: messageId, sessionId: sessionId)
+        }
 
         if let ack = response as? AckMessage {
             if !ack.success {
@@ -232,12 +233,11 @@ public actor SpiceControlChannel {
     /// - Parameter timeout: Maximum time to wait for response
     /// - Returns: List of Windows shortcuts
     public func listShortcuts(timeout: Duration = .seconds(5)) async throws -> WindowsShortcutList {
-        let messageId = nextMessageId()
-        let request = ListShortcutsSpiceMessage(messageId: messageId)
-
-        logger.debug("Sending ListShortcuts request (messageId: \(messageId))")
+        logger.debug("Sending ListShortcuts request")
 
-        let response = try await sendAndWait(request, messageId: messageId, timeout: timeout)
+        let response = try await sendAndWait(timeout: timeout) { messageId in
+            ListShortcutsSpiceMessage(messageId: messageId)
+        }
 
         guard let shortcutList = response as? ShortcutListMessage else {
             throw SpiceControlError.unexpectedResponse("Expected ShortcutListMessage, got \(type(of: response))")
@@ -246,6 +246,53 @@ public actor SpiceControlChannel {
         return shortcutList.toWindowsShortcutList()
     }
 
+    // MARK: - Guest Heartbeat
+
+    /// Ping the guest every `interval` to measure round-trip time, and report
+    /// it stalled to the delegate once `stallAfter` passes without a reply.
+    ///
+    /// The bridge sends the pings and reads the replies off the control port
+    /// itself, so neither waits on this actor and the measured times exclude
+    /// it. Needs a guest agent that answers Ping; an older one is reported
+    /// stalled. Stops when the channel disconnects.
+    /// - Returns: false if not connected, or if the transport has no heartbeat
+    @discardableResult
+    public func startHeartbeat(interval: Duration = .seconds(1), stallAfter: Duration = .seconds(3)) -> Bool {
+        guard isConnected, let transport else { return false }
+
+        let started = transport.startHeartbeat(interval: interval, stallAfter: stallAfter) { [weak self] health, stats in
+            Task { [weak self] in
+                await self?.reportGuestHealth(health, statistics: stats)
+            }
+        }
+        if started {
+            logger.info("Guest heartbeat started (every \(interval), stall after \(stallAfter))")
+        }
+        return started
+    }
+
+    /// Stop pinging the guest.
+    public func stopHeartbeat() {
+        transport?.stopHeartbeat()
+    }
+
+    /// Round-trip percentiles and counters, or nil if no heartbeat is running.
+    public func heartbeatStatistics() -> SpiceHeartbeatStats? {
+        transport?.heartbeatStatistics()
+    }
+
+    private func reportGuestHealth(_ health: SpiceGuestHealth, statistics: SpiceHeartbeatStats) {
+        switch health {
+        case .stalled:
+            logger.warn("Guest stalled: no heartbeat reply for \(statistics.silence)")
+        case .healthy:
+            logger.info("Guest heartbeat healthy (p50 \(statistics.roundTripP50), p99 \(statistics.roundTripP99))")
+        case .unknown:
+            break
+        }
+        _delegate?.controlChannel(self, didChangeGuestHealth: health, statistics: statistics)
+    }
+
     // MARK: - Internal Message Handling
 
     /// Called when data is received from the Spice channel.
@@ -272,7 +319,9 @@ public actor SpiceControlChannel {
             return
         }
 
-        // Check if this is a response to a pending request
+        // Check if this is a response to a pending request. With the bridge
+        // tracking requests, responses read off the control port have already
+        // completed; this covers transports without it.
         let messageId: UInt32? = switch message {
         case let msg as SessionListMessage: msg.messageId
         case let msg as ShortcutListMessage: msg.messageId
@@ -281,31 +330,22 @@ public actor SpiceControlChannel {
         default: nil
         }
 
-        if let messageId, let streamContinuation = pendingStreams.removeValue(forKey: messageId) {
-            // This is a response to a pending request
-            if let errorMsg = message as? GuestErrorMessage {
-                streamContinuation.finish(throwing: SpiceControlError.guestError(
-                    code: errorMsg.code,
-                    message: errorMsg.message
-                ))
-            } else {
-                streamContinuation.yield(message)
-                streamContinuation.finish()
-            }
-        } else {
-            // Unsolicited message - notify delegate
-            _delegate?.controlChannel(self, didReceiveMessage: message, type: type)
+        if let messageId, requests.complete(messageId, response: data) {
+            return
         }
+
+        // Unsolicited message - notify delegate
+        _delegate?.controlChannel(self, didReceiveMessage: message, type: type)
     }
 
     // MARK: - Private Helpers
 
-    private func nextMessageId() -> UInt32 {
-        messageIdCounter += 1
-        return messageIdCounter
-    }
-
-    private func sendAndWait(_ message: some HostMessage, messageId: UInt32, timeout: Duration) async throws -> Any {
+    /// Send the message `makeMessage` builds with a tracked message ID and wait
+    /// for the guest's response to it.
+    private func sendAndWait<Message: HostMessage>(
+        timeout: Duration,
+        _ makeMessage: (UInt32) -> Message
+    ) async throws -> Any {
         guard isConnected else {
             throw SpiceControlError.notConnected
         }
@@ -314,64 +354,60 @@ public actor SpiceControlChannel {
             throw SpiceControlError.notConnected
         }
 
-        // Serialize the message
-        let data: Data
-        do {
-            data = try SpiceMessageSerializer.serialize(message)
-        } catch {
-            throw SpiceControlError.sendFailed(error)
-        }
-
-        // Send via transport
-        let sent = transport.sendControlMessage(data)
-        if !sent {
-            throw SpiceControlError.sendFailed(
-                NSError(domain: "SpiceControlChannel", code: -1, userInfo: [
-                    NSLocalizedDescriptionKey: "Transport failed to send message",
-                ])
-            )
-        }
-
-        logger.debug("Sent control message (\(data.count) bytes)")
-
-        // Wait for response with timeout using AsyncStream approach
-        // This avoids actor-isolation issues with continuations
-        return try await withThrowingTaskGroup(of: Any.self) { group in
-            // Create a stream that will receive the response
-            let (stream, streamContinuation) = AsyncThrowingStream<Any, Error>.makeStream()
-
-            // Register the stream continuation for this message ID
-            pendingStreams[messageId] = streamContinuation
-
-            // Add the request task
-            group.addTask {
-                for try await response in stream {
-                    return response
+        // The tracker completes the request exactly once: with the response,
+        // on timeout, or cancelled on disconnect
+        let envelope: Data = try await withCheckedThrowingContinuation { continuation in
+            let messageId = requests.begin(timeout: timeout) { outcome in
+                switch outcome {
+                case .response(let envelope):
+                    continuation.resume(returning: envelope)
+                case .timedOut:
+                    continuation.resume(throwing: SpiceControlError.timeout)
+                case .cancelled:
+                    continuation.resume(throwing: SpiceControlError.notConnected)
                 }
-                throw SpiceControlError.timeout
             }
-
-            // Add a timeout task
-            group.addTask {
-                try await Task.sleep(for: timeout)
-                throw SpiceControlError.timeout
+            guard let messageId else {
+                continuation.resume(throwing: SpiceControlError.sendFailed(
+                    NSError(domain: "SpiceControlChannel", code: -1, userInfo: [
+                        NSLocalizedDescriptionKey: "Could not track request",
+                    ])
+                ))
+                return
             }
 
-            // Wait for the first task to complete
             do {
-                if let result = try await group.next() {
-                    group.cancelAll()
-                    pendingStreams.removeValue(forKey: messageId)
-                    return result
+                // Serialize the message
+                let data = try SpiceMessageSerializer.serialize(makeMessage(messageId))
+
+                // Send via transport
+                guard transport.sendControlMessage(data) else {
+                    throw NSError(domain: "SpiceControlChannel", code: -1, userInfo: [
+                        NSLocalizedDescriptionKey: "Transport failed to send message",
+                    ])
                 }
-                throw SpiceControlError.timeout
+                logger.debug("Sent \(Message.self) (messageId: \(messageId), \(data.count) bytes)")
             } catch {
-                // Clean up pending stream on timeout
-                pendingStreams.removeValue(forKey: messageId)
-                streamContinuation.finish()
-                throw error
+                // Unless it already timed out, the request is still ours to fail
+                if requests.cancel(messageId) {
+                    continuation.resume(throwing: SpiceControlError.sendFailed(error))
+                }
             }
         }
+
+        let decoded: (SpiceMessageType, Any)?
+        do {
+            decoded = try SpiceMessageSerializer.deserialize(envelope)
+        } catch let error as SpiceProtocolError {
+            throw SpiceControlError.protocolError(error)
+        }
+        guard let (_, response) = decoded else {
+            throw SpiceControlError.unexpectedResponse("Incomplete response")
+        }
+        if let errorMsg = response as? GuestErrorMessage {
+            throw SpiceControlError.guestError(code: errorMsg.code, message: errorMsg.message)
+        }
+        return response
     }
 
     /// Simulate receiving a response (for testing purposes).
@@ -428,6 +464,7 @@ private final class MockTestTransport: SpiceStreamTransport {
     func sendClipboard(_ clipboard: ClipboardData) {}
     func requestClipboard(format: ClipboardFormat) {}
     func sendDragDropEvent(_ event: DragDropEvent) {}
+    func setVisibility(_ visibility: SpiceStreamVisibility, maxFrameRate: UInt32) {}
 
     func setControlCallback(_ callback: @escaping (Data) -> Void) {}
 
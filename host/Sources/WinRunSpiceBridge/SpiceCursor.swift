@@ -0,0 +1,85 @@
+import Foundation
+
+// MARK: - Cursor Image
+
+/// A guest pointer shape, converted by the bridge for native display.
+public struct SpiceCursorImage: Equatable {
+    /// Content hash of the guest image and hotspot; equal hashes mean equal shapes
+    public let hash: UInt64
+    public let width: Int
+    public let height: Int
+    public let hotspotX: Int
+    public let hotspotY: Int
+    /// Premultiplied BGRA pixels with no row padding
+    /// (CoreGraphics premultipliedFirst + byteOrder32Little)
+    public let data: Data
+
+    /// Bytes per row
+    public var stride: Int { width * 4 }
+
+    public init(hash: UInt64, width: Int, height: Int, hotspotX: Int, hotspotY: Int, data: Data) {
+        self.hash = hash
+        self.width = width
+        self.height = height
+        self.hotspotX = hotspotX
+        self.hotspotY = hotspotY
+        self.data = data
+    }
+}
+
+// MARK: - Cursor Events
+
+/// Pointer changes reported by the guest's cursor channel.
+public enum SpiceCursorEvent: Equatable {
+    /// The guest switched to a new pointer shape
+    case set(SpiceCursorImage)
+    /// The guest moved the pointer, in guest coordinates. Only meaningful in
+    /// server mouse mode; in client mode the host pointer already leads.
+    case move(x: Int32, y: Int32)
+    /// The guest hid the pointer
+    case hide
+    /// The guest dropped its shapes; show the default pointer
+    case reset
+}
+
+// MARK: - Cursor Shape Cache
+
+/// Small least-recently-used cache for native cursor objects, keyed by
+/// `SpiceCursorImage.hash`.
+///
+/// Guests cycle through a handful of shapes as the pointer crosses controls,
+/// so keeping the native objects avoids rebuilding an image on every change.
+public final class SpiceCursorShapeCache<Value> {
+    public let capacity: Int
+
+    private var entries: [UInt64: (value: Value, lastUsed: UInt64)] = [:]
+    private var clock: UInt64 = 0
+
+    public init(capacity: Int = 32) {
+        self.capacity = max(capacity, 1)
+    }
+
+    public var count: Int { entries.count }
+
+    /// Returns the cached value for `image`, building and storing it on a miss.
+    /// The least recently used entry is dropped when the cache is full.
+    public func value(for image: SpiceCursorImage, build: (SpiceCursorImage) -> Value?) -> Value? {
+        clock += 1
+        if let entry = entries[image.hash] {
+            entries[image.hash] = (entry.value, clock)
+            return entry.value
+        }
+
+        guard let value = build(image) else { return nil }
+        if entries.count >= capacity,
+           let oldest = entries.min(by: { $0.value.lastUsed < $1.value.lastUsed })?.key {
+            entries.removeValue(forKey: oldest)
+        }
+        entries[image.hash] = (value, clock)
+        return value
+    }
+
+    public func removeAll() {
+        entries.removeAll()
+    }
+}
@@ -6,6 +6,9 @@ import WinRunShared
 /// The frame router maintains a registry of active `SpiceWindowStream` instances and routes
 /// incoming `FrameReadyMessage` notifications to the correct stream based on window ID.
 /// It manages per-window frame buffer readers for reading frame data from shared memory.
+///
+/// On macOS, streams also register their window with the C bridge, which then hands
+/// their notifications to the stream directly; only unrouted windows come through here.
 public final class SpiceFrameRouter {
     private let logger: Logger
     private let routingQueue = DispatchQueue(label: "com.winrun.spice.frame-router")
@@ -25,8 +28,15 @@ public final class SpiceFrameRouter {
     /// Shared memory region size in bytes
     private var sharedMemorySize: Int = 0
 
-    public init(logger: Logger = StandardLogger(subsystem: "SpiceFrameRouter")) {
+    /// Budget that registered streams are charged to, if any
+    public let memoryBudget: SpiceMemoryBudget?
+
+    public init(
+        logger: Logger = StandardLogger(subsystem: "SpiceFrameRouter"),
+        memoryBudget: SpiceMemoryBudget? = nil
+    ) {
         self.logger = logger
+        self.memoryBudget = memoryBudget
     }
 
     // MARK: - Shared Memory Region Configuration
@@ -134,6 +144,22 @@ public final class SpiceFrameRouter {
         // Calculate the host pointer for this buffer
         let bufferPointer = basePointer.advanced(by: offset)
 
+        // A reallocation moves the existing reader instead of replacing it, so
+        // the stream keeps its reader and composed surface through a resize
+        if let reader = windowBufferReaders[windowId] {
+            guard !reader.isMapped(to: bufferPointer, size: info.bufferSize) else { return }
+            if let stream = windowStreams[windowId] {
+                stream.remapFrameBufferReader(reader, pointer: bufferPointer, size: info.bufferSize)
+            } else {
+                reader.remap(pointer: bufferPointer, size: info.bufferSize)
+            }
+            logger.debug(
+                "Remapped buffer reader for window \(windowId): " +
+                "offset=\(offset), size=\(info.bufferSize / 1024) KB"
+            )
+            return
+        }
+
         // Create the reader for this per-window buffer
         let reader = SharedFrameBufferReader(
             pointer: bufferPointer,
@@ -173,6 +199,9 @@ public final class SpiceFrameRouter {
     public func registerStream(_ stream: SpiceWindowStream, forWindowID windowID: UInt64) {
         routingQueue.async {
             self.windowStreams[windowID] = stream
+            if let budget = self.memoryBudget {
+                stream.setMemoryBudget(budget)
+            }
 
             // If we have buffer info for this window, the stream can use it
             if let bufferInfo = self.windowBufferInfo[windowID] {
@@ -202,6 +231,9 @@ public final class SpiceFrameRouter {
             // Clear the reader from the stream before removing
             if let stream = self.windowStreams[windowID] {
                 stream.setFrameBufferReader(nil)
+                if self.memoryBudget != nil {
+                    stream.setMemoryBudget(nil)
+                }
             }
 
             if self.windowStreams.removeValue(forKey: windowID) != nil {
@@ -224,6 +256,9 @@ public final class SpiceFrameRouter {
             // Clear readers from all streams
             for (_, stream) in self.windowStreams {
                 stream.setFrameBufferReader(nil)
+                if self.memoryBudget != nil {
+                    stream.setMemoryBudget(nil)
+                }
             }
 
             self.windowStreams.removeAll()
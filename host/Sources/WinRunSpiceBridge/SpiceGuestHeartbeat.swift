@@ -0,0 +1,93 @@
+import Foundation
+
+#if os(macOS)
+    import CSpiceBridge
+#endif
+
+/// Guest liveness as judged from replies to heartbeat pings.
+public enum SpiceGuestHealth: Equatable, Sendable {
+    /// No reply yet
+    case unknown
+    case healthy
+    /// No reply within the stall deadline
+    case stalled
+}
+
+/// Round-trip times and counters for the control channel's heartbeat.
+///
+/// Round trips are measured on the host's clock: each ping carries its send
+/// time and the guest echoes it back, so clock skew between host and guest
+/// doesn't enter into them.
+public struct SpiceHeartbeatStats: Equatable, Sendable {
+    public var health: SpiceGuestHealth = .unknown
+    public var pingsSent: UInt64 = 0
+    /// Pings the control port wouldn't take
+    public var sendFailures: UInt64 = 0
+    public var replies: UInt64 = 0
+    /// Late or duplicate replies, which were ignored
+    public var staleReplies: UInt64 = 0
+    /// Times the guest was reported stalled
+    public var stalls: UInt64 = 0
+    /// Replies the percentiles cover (the most recent 128)
+    public var samples: UInt32 = 0
+    public var lastRoundTrip: Duration = .zero
+    public var roundTripP50: Duration = .zero
+    public var roundTripP90: Duration = .zero
+    public var roundTripP99: Duration = .zero
+    public var maxRoundTrip: Duration = .zero
+    /// Smoothed change between consecutive round trips
+    public var jitter: Duration = .zero
+    /// Time since the last reply, or since the heartbeat started
+    public var silence: Duration = .zero
+
+    public init() {}
+}
+
+extension Duration {
+    /// Whole milliseconds, clamped to what the bridge's UInt32 timeouts hold
+    var clampedMilliseconds: UInt32 {
+        let (seconds, attoseconds) = components
+        return UInt32(clamping: max(0, seconds) * 1000 + max(0, attoseconds) / 1_000_000_000_000_000)
+    }
+
+    /// Whole microseconds, clamped to UInt32
+    var clampedMicroseconds: UInt32 {
+        let (seconds, attoseconds) = components
+        guard seconds < 4295 else { return .max }
+        return UInt32(clamping: max(0, seconds) * 1_000_000 + max(0, attoseconds) / 1_000_000_000_000)
+    }
+}
+
+#if os(macOS)
+    extension SpiceGuestHealth {
+        init(_ health: winrun_guest_health) {
+            switch health {
+            case WINRUN_GUEST_HEALTH_HEALTHY:
+                self = .healthy
+            case WINRUN_GUEST_HEALTH_STALLED:
+                self = .stalled
+            default:
+                self = .unknown
+            }
+        }
+    }
+
+    extension SpiceHeartbeatStats {
+        init(_ stats: winrun_heartbeat_stats) {
+            health = SpiceGuestHealth(stats.health)
+            pingsSent = stats.pings_sent
+            sendFailures = stats.send_failures
+            replies = stats.replies
+            staleReplies = stats.stale_replies
+            stalls = stats.stalls
+            samples = stats.samples
+            lastRoundTrip = .microseconds(stats.rtt_last_us)
+            roundTripP50 = .microseconds(stats.rtt_p50_us)
+            roundTripP90 = .microseconds(stats.rtt_p90_us)
+            roundTripP99 = .microseconds(stats.rtt_p99_us)
+            maxRoundTrip = .microseconds(stats.rtt_max_us)
+            jitter = .microseconds(stats.jitter_us)
+            silence = .milliseconds(stats.silence_ms)
+        }
+    }
+#endif
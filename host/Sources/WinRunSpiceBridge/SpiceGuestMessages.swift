@@ -267,25 +267,34 @@ public struct GuestClipboardMessage: GuestMessage {
 }
 
 /// Heartbeat to indicate agent is alive.
+/// Sent periodically, and in reply to a `PingSpiceMessage`.
 public struct HeartbeatMessage: GuestMessage {
     public let timestamp: Int64
     public let trackedWindowCount: Int32
     public let uptimeMs: Int64
     public let cpuUsagePercent: Float
     public let memoryUsageBytes: Int64
+    /// Sequence of the ping this answers; nil for periodic heartbeats
+    public let pingSequence: UInt32?
+    /// The ping's `sentAt`, echoed unchanged
+    public let pingSentAt: Int64?
 
     public init(
         timestamp: Int64 = Int64(Date().timeIntervalSince1970 * 1000),
         trackedWindowCount: Int32 = 0,
         uptimeMs: Int64 = 0,
         cpuUsagePercent: Float = 0,
-        memoryUsageBytes: Int64 = 0
+        memoryUsageBytes: Int64 = 0,
+        pingSequence: UInt32? = nil,
+        pingSentAt: Int64? = nil
     ) {
         self.timestamp = timestamp
         self.trackedWindowCount = trackedWindowCount
         self.uptimeMs = uptimeMs
         self.cpuUsagePercent = cpuUsagePercent
         self.memoryUsageBytes = memoryUsageBytes
+        self.pingSequence = pingSequence
+        self.pingSentAt = pingSentAt
     }
 }
 
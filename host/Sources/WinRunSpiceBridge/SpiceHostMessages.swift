@@ -218,6 +218,68 @@ public struct ConfigureStreamingSpiceMessage: HostMessage {
     }
 }
 
+/// Visibility-based capture throttle for a single window.
+///
+/// Sent when a host window is minimized, occluded, or moves to the background
+/// so the guest can stop or slow down capturing it.
+public struct SetWindowThrottleSpiceMessage: HostMessage {
+    public let messageId: UInt32
+    public let windowId: UInt64
+    public let visibility: SpiceStreamVisibility
+
+    /// Maximum capture rate, or 0 for the guest default
+    /// (unlimited when visible, a low background rate otherwise).
+    public let maxFps: UInt32
+
+    /// Whether the window has focus; the guest captures the focused window at its highest rate.
+    public let isFocused: Bool
+
+    /// Smoothed time the host takes to decode one of the window's tiled frames,
+    /// in microseconds; omitted until the host has decoded one. The guest takes
+    /// it out of the frame's LZ4 budget.
+    public let hostDecodeUs: UInt32?
+
+    /// Frames the host skipped to catch up since its previous hint; omitted
+    /// when it skipped none. The guest slows the window down for any.
+    public let hostSkippedFrames: UInt32?
+
+    public init(
+        messageId: UInt32 = 0,
+        windowId: UInt64,
+        visibility: SpiceStreamVisibility,
+        maxFps: UInt32 = 0,
+        isFocused: Bool = false,
+        hostDecodeUs: UInt32? = nil,
+        hostSkippedFrames: UInt32? = nil
+    ) {
+        self.messageId = messageId
+        self.windowId = windowId
+        self.visibility = visibility
+        self.maxFps = maxFps
+        self.isFocused = isFocused
+        self.hostDecodeUs = hostDecodeUs
+        self.hostSkippedFrames = hostSkippedFrames
+    }
+}
+
+/// Liveness probe for the guest agent.
+///
+/// The guest answers with a `HeartbeatMessage` echoing `sequence` and `sentAt`.
+/// The bridge's heartbeat sends these itself; `messageId` stays 0 so replies
+/// never collide with tracked requests.
+public struct PingSpiceMessage: HostMessage {
+    public let messageId: UInt32
+    public let sequence: UInt32
+    /// Host send time in microseconds, on a clock only the host reads
+    public let sentAt: Int64
+
+    public init(messageId: UInt32 = 0, sequence: UInt32, sentAt: Int64) {
+        self.messageId = messageId
+        self.sequence = sequence
+        self.sentAt = sentAt
+    }
+}
+
 /// Wire representation of frame buffer mode for protocol messages.
 ///
 /// Matches the guest's `FrameBufferMode` enum values.
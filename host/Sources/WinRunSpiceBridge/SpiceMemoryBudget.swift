@@ -0,0 +1,341 @@
+import Foundation
+import WinRunShared
+
+// MARK: - Memory Categories
+
+/// Kinds of host memory tracked by `SpiceMemoryBudget`.
+public enum SpiceMemoryCategory: String, CaseIterable, Codable, Hashable {
+    /// Backing surface the consumer keeps for the latest frame (texture, image)
+    case surface
+    /// Preview thumbnail
+    case thumbnail
+    /// Reusable scratch buffers
+    case bufferPool
+    /// Caches that can be rebuilt from the guest on demand
+    case cache
+
+    /// Whether memory in this category may be evicted from a stream with the given visibility.
+    /// Pools and caches can always be rebuilt; surfaces and thumbnails are only
+    /// dropped for hidden windows, where nothing is on screen.
+    public func isEvictable(for visibility: SpiceStreamVisibility) -> Bool {
+        switch self {
+        case .bufferPool, .cache:
+            return true
+        case .surface, .thumbnail:
+            return visibility == .hidden
+        }
+    }
+}
+
+// MARK: - Limits
+
+/// Byte limits enforced by `SpiceMemoryBudget`.
+public struct SpiceMemoryLimits: Equatable {
+    /// Upper bound for all streams combined
+    public var globalBytes: Int
+    /// Upper bound for any single stream
+    public var perStreamBytes: Int
+
+    /// Defaults sized for an 8 GB host running the VM: a 4K surface is ~33 MB,
+    /// so a handful of large windows fit before hidden ones are trimmed.
+    public init(globalBytes: Int = 384 * 1024 * 1024, perStreamBytes: Int = 96 * 1024 * 1024) {
+        self.globalBytes = globalBytes
+        self.perStreamBytes = perStreamBytes
+    }
+}
+
+/// Reported when usage crosses a limit.
+public struct SpiceMemoryLimitEvent: Equatable {
+    public enum Scope: Equatable {
+        case global
+        case stream(windowID: UInt64)
+    }
+
+    public let scope: Scope
+    public let usedBytes: Int
+    public let limitBytes: Int
+    /// Bytes eviction was requested for; less than the overage when the rest is pinned
+    public let evictableBytes: Int
+}
+
+/// Implemented by owners of budgeted memory so the budget can reclaim it.
+public protocol SpiceMemoryEvictable: AnyObject {
+    /// Releases the memory held in `categories` and reports the new usage
+    /// through the owner's `SpiceMemoryAccount`.
+    ///
+    /// Called on whichever thread reported the usage that triggered eviction,
+    /// possibly the owner's own queue, so implementations must not block on it.
+    func evictMemory(in categories: Set<SpiceMemoryCategory>)
+}
+
+// MARK: - Memory Budget
+
+/// Tracks host memory held on behalf of window streams against a global and a
+/// per-stream limit.
+///
+/// Each stream reports its usage per category through a `SpiceMemoryAccount`.
+/// When a report pushes usage over a limit, the budget asks owners to evict
+/// whatever their visibility allows, hidden streams first, then background,
+/// then visible, and reports the crossing to the limit handler.
+public final class SpiceMemoryBudget {
+    public let limits: SpiceMemoryLimits
+
+    private let logger: Logger
+    private let lock = NSLock()
+    private var accounts: [ObjectIdentifier: SpiceMemoryAccount] = [:]
+    private var totalBytes = 0
+    private var isOverGlobalLimit = false
+    private var limitHandler: ((SpiceMemoryLimitEvent) -> Void)?
+
+    public init(
+        limits: SpiceMemoryLimits = SpiceMemoryLimits(),
+        logger: Logger = StandardLogger(subsystem: "SpiceMemoryBudget")
+    ) {
+        self.limits = limits
+        self.logger = logger
+    }
+
+    /// Sets the handler called when usage crosses the global or a per-stream limit.
+    /// It fires once per crossing, on the thread that reported the usage.
+    public func setLimitHandler(_ handler: ((SpiceMemoryLimitEvent) -> Void)?) {
+        lock.lock()
+        limitHandler = handler
+        lock.unlock()
+    }
+
+    /// Opens an account for a stream. Close it when the stream goes away.
+    /// - Parameters:
+    ///   - windowID: Window the memory belongs to, used in limit events
+    ///   - evictor: Owner asked to release memory under pressure
+    public func makeAccount(windowID: UInt64, evictor: SpiceMemoryEvictable?) -> SpiceMemoryAccount {
+        let account = SpiceMemoryAccount(windowID: windowID, budget: self, evictor: evictor)
+        lock.lock()
+        accounts[ObjectIdentifier(account)] = account
+        lock.unlock()
+        return account
+    }
+
+    /// Bytes currently charged across all streams.
+    public var usedBytes: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return totalBytes
+    }
+
+    /// Bytes currently charged to a category across all streams.
+    public func usedBytes(in category: SpiceMemoryCategory) -> Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return accounts.values.reduce(0) { $0 + ($1.bytes[category] ?? 0) }
+    }
+
+    /// Number of open accounts.
+    public var accountCount: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return accounts.count
+    }
+
+    // MARK: - Account Updates
+
+    fileprivate func setUsage(_ bytes: Int, for category: SpiceMemoryCategory, in account: SpiceMemoryAccount) {
+        lock.lock()
+        guard !account.isClosed else {
+            lock.unlock()
+            return
+        }
+
+        let newBytes = max(bytes, 0)
+        let delta = newBytes - (account.bytes[category] ?? 0)
+        guard delta != 0 else {
+            lock.unlock()
+            return
+        }
+
+        account.bytes[category] = newBytes
+        totalBytes += delta
+        let pressure = delta > 0 ? collectPressure(for: account) : refreshLimitFlags(for: account)
+        lock.unlock()
+
+        relieve(pressure)
+    }
+
+    fileprivate func setVisibility(_ visibility: SpiceStreamVisibility, of account: SpiceMemoryAccount) {
+        lock.lock()
+        guard !account.isClosed, account.visibility != visibility else {
+            lock.unlock()
+            return
+        }
+
+        account.visibility = visibility
+        // A newly hidden stream may free enough to get back under the limits
+        let pressure = collectPressure(for: account)
+        lock.unlock()
+
+        relieve(pressure)
+    }
+
+    fileprivate func close(_ account: SpiceMemoryAccount) {
+        lock.lock()
+        defer { lock.unlock() }
+        guard !account.isClosed else { return }
+
+        account.isClosed = true
+        totalBytes -= account.usedBytesLocked
+        account.bytes.removeAll()
+        accounts.removeValue(forKey: ObjectIdentifier(account))
+        _ = refreshLimitFlags(for: account)
+    }
+
+    // MARK: - Pressure Handling
+
+    private struct Pressure {
+        var evictions: [ObjectIdentifier: (SpiceMemoryEvictable, Set<SpiceMemoryCategory>)] = [:]
+        var events: [SpiceMemoryLimitEvent] = []
+        var handler: ((SpiceMemoryLimitEvent) -> Void)?
+    }
+
+    /// Plans evictions for any limit currently exceeded. Must be called with `lock` held.
+    private func collectPressure(for account: SpiceMemoryAccount) -> Pressure {
+        var pressure = Pressure()
+        pressure.handler = limitHandler
+
+        let accountBytes = account.usedBytesLocked
+        if accountBytes > limits.perStreamBytes {
+            let evictable = planEviction(of: account, into: &pressure)
+            if !account.isOverLimit {
+                account.isOverLimit = true
+                pressure.events.append(SpiceMemoryLimitEvent(
+                    scope: .stream(windowID: account.windowID),
+                    usedBytes: accountBytes,
+                    limitBytes: limits.perStreamBytes,
+                    evictableBytes: evictable
+                ))
+            }
+        } else {
+            account.isOverLimit = false
+        }
+
+        if totalBytes > limits.globalBytes {
+            let overage = totalBytes - limits.globalBytes
+            var evictable = 0
+            for candidate in evictionOrder() where evictable < overage {
+                evictable += planEviction(of: candidate, into: &pressure)
+            }
+            if !isOverGlobalLimit {
+                isOverGlobalLimit = true
+                pressure.events.append(SpiceMemoryLimitEvent(
+                    scope: .global,
+                    usedBytes: totalBytes,
+                    limitBytes: limits.globalBytes,
+                    evictableBytes: evictable
+                ))
+            }
+        } else {
+            isOverGlobalLimit = false
+        }
+
+        return pressure
+    }
+
+    /// Clears limit flags once usage drops back under. Must be called with `lock` held.
+    private func refreshLimitFlags(for account: SpiceMemoryAccount) -> Pressure {
+        if account.usedBytesLocked <= limits.perStreamBytes {
+            account.isOverLimit = false
+        }
+        if totalBytes <= limits.globalBytes {
+            isOverGlobalLimit = false
+        }
+        return Pressure()
+    }
+
+    /// Hidden streams first, then background, then visible; larger reclaimable usage first.
+    private func evictionOrder() -> [SpiceMemoryAccount] {
+        accounts.values.sorted { lhs, rhs in
+            if lhs.visibility != rhs.visibility {
+                return lhs.visibility.rawValue > rhs.visibility.rawValue
+            }
+            return lhs.evictableBytesLocked > rhs.evictableBytesLocked
+        }
+    }
+
+    /// Adds an eviction request for everything the account may give up.
+    /// Must be called with `lock` held.
+    /// - Returns: The bytes requested
+    private func planEviction(of account: SpiceMemoryAccount, into pressure: inout Pressure) -> Int {
+        guard let evictor = account.evictor else { return 0 }
+        let categories = account.evictableCategoriesLocked
+        guard !categories.isEmpty else { return 0 }
+
+        let key = ObjectIdentifier(account)
+        if pressure.evictions[key] == nil {
+            pressure.evictions[key] = (evictor, categories)
+        }
+        return account.evictableBytesLocked
+    }
+
+    /// Runs planned evictions and limit callbacks outside the lock.
+    private func relieve(_ pressure: Pressure) {
+        for event in pressure.events {
+            logger.warn("Memory limit reached: \(event.scope) using \(event.usedBytes / 1024) KB of \(event.limitBytes / 1024) KB")
+        }
+        for (evictor, categories) in pressure.evictions.values {
+            evictor.evictMemory(in: categories)
+        }
+        if let handler = pressure.handler {
+            pressure.events.forEach(handler)
+        }
+    }
+}
+
+// MARK: - Memory Account
+
+/// One stream's share of a `SpiceMemoryBudget`.
+///
+/// Owners report absolute usage per category whenever it changes; the account
+/// is thread-safe and cheap to update when nothing changed.
+public final class SpiceMemoryAccount {
+    public let windowID: UInt64
+
+    private let budget: SpiceMemoryBudget
+    fileprivate weak var evictor: SpiceMemoryEvictable?
+
+    // Guarded by the budget's lock
+    fileprivate var bytes: [SpiceMemoryCategory: Int] = [:]
+    fileprivate var visibility: SpiceStreamVisibility = .visible
+    fileprivate var isOverLimit = false
+    fileprivate var isClosed = false
+
+    fileprivate init(windowID: UInt64, budget: SpiceMemoryBudget, evictor: SpiceMemoryEvictable?) {
+        self.windowID = windowID
+        self.budget = budget
+        self.evictor = evictor
+    }
+
+    /// Records the bytes currently held in a category, evicting or reporting if a limit is exceeded.
+    public func setUsage(_ bytes: Int, for category: SpiceMemoryCategory) {
+        budget.setUsage(bytes, for: category, in: self)
+    }
+
+    /// Records the stream's visibility, which decides what can be evicted from it.
+    public func setVisibility(_ visibility: SpiceStreamVisibility) {
+        budget.setVisibility(visibility, of: self)
+    }
+
+    /// Releases all charges and removes the account from the budget.
+    public func close() {
+        budget.close(self)
+    }
+
+    fileprivate var usedBytesLocked: Int {
+        bytes.values.reduce(0, +)
+    }
+
+    fileprivate var evictableCategoriesLocked: Set<SpiceMemoryCategory> {
+        Set(bytes.filter { $0.value > 0 && $0.key.isEvictable(for: visibility) }.keys)
+    }
+
+    fileprivate var evictableBytesLocked: Int {
+        bytes.reduce(0) { $0 + ($1.key.isEvictable(for: visibility) ? $1.value : 0) }
+    }
+}
@@ -66,6 +66,10 @@ public enum SpiceMessageSerializer {
             type = .closeSession
         case is ListShortcutsSpiceMessage:
             type = .listShortcuts
+        case is SetWindowThrottleSpiceMessage:
+            type = .setWindowThrottle
+        case is PingSpiceMessage:
+            type = .ping
         case is ShutdownSpiceMessage:
             type = .shutdown
         default:
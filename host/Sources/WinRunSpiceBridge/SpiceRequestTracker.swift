@@ -0,0 +1,166 @@
+import Foundation
+
+#if os(macOS)
+    import CSpiceBridge
+#endif
+
+/// How a tracked control request ended.
+enum SpiceRequestOutcome {
+    /// The guest's response envelope
+    case response(Data)
+    case timedOut
+    /// The control channel disconnected first
+    case cancelled
+}
+
+/// Hands out control message IDs and matches responses to them.
+///
+/// On macOS this wraps the bridge's request tracker: the in-flight table and
+/// the timeouts (a hashed timer wheel) live in C, and once the tracker is
+/// attached to the control stream, responses complete on the thread that
+/// read them without passing through the control callback. Each completion
+/// runs exactly once, on whichever thread ended the request.
+final class SpiceRequestTracker {
+    typealias Completion = (SpiceRequestOutcome) -> Void
+
+    #if os(macOS)
+        /// Nil only if the bridge couldn't allocate the tracker; every
+        /// request then fails to start
+        private(set) var handle: winrun_request_tracker_handle?
+    #else
+        private let lock = NSLock()
+        private var nextMessageId: UInt32 = 0
+        private var pending: [UInt32: Completion] = [:]
+    #endif
+
+    init() {
+        #if os(macOS)
+            handle = winrun_request_tracker_create()
+        #endif
+    }
+
+    deinit {
+        #if os(macOS)
+            winrun_request_tracker_destroy(handle)
+        #else
+            cancelAll()
+        #endif
+    }
+
+    /// Start tracking a request and return the message ID to send it with,
+    /// or nil if it couldn't be tracked.
+    func begin(timeout: Duration, completion: @escaping Completion) -> UInt32? {
+        let timeoutMs = timeout.clampedMilliseconds
+
+        #if os(macOS)
+            let box = Unmanaged.passRetained(CompletionBox(completion))
+            let messageId = winrun_request_begin(handle, timeoutMs, spiceRequestThunk, box.toOpaque())
+            guard messageId != 0 else {
+                box.release()
+                return nil
+            }
+            return messageId
+        #else
+            lock.lock()
+            repeat {
+                nextMessageId &+= 1
+            } while nextMessageId == 0 || pending[nextMessageId] != nil
+            let messageId = nextMessageId
+            pending[messageId] = completion
+            lock.unlock()
+
+            DispatchQueue.global().asyncAfter(deadline: .now() + .milliseconds(Int(timeoutMs))) { [weak self] in
+                self?.take(messageId)?(.timedOut)
+            }
+            return messageId
+        #endif
+    }
+
+    /// Complete a request with its response envelope. Returns false if the
+    /// request already ended (or never started).
+    @discardableResult
+    func complete(_ messageId: UInt32, response: Data) -> Bool {
+        #if os(macOS)
+            return response.withUnsafeBytes { buffer in
+                winrun_request_complete(
+                    handle,
+                    messageId,
+                    buffer.baseAddress?.assumingMemoryBound(to: UInt8.self),
+                    buffer.count
+                )
+            }
+        #else
+            guard let completion = take(messageId) else { return false }
+            completion(.response(response))
+            return true
+        #endif
+    }
+
+    /// Stop tracking a request without running its completion. Returns false
+    /// if the request already ended; its completion has run or is running.
+    func cancel(_ messageId: UInt32) -> Bool {
+        #if os(macOS)
+            var userData: UnsafeMutableRawPointer?
+            guard winrun_request_cancel(handle, messageId, &userData), let userData else {
+                return false
+            }
+            Unmanaged<CompletionBox>.fromOpaque(userData).release()
+            return true
+        #else
+            return take(messageId) != nil
+        #endif
+    }
+
+    /// End every request in flight with `.cancelled`.
+    func cancelAll() {
+        #if os(macOS)
+            _ = winrun_request_cancel_all(handle)
+        #else
+            lock.lock()
+            let completions = pending.values
+            pending.removeAll()
+            lock.unlock()
+            completions.forEach { $0(.cancelled) }
+        #endif
+    }
+
+    #if !os(macOS)
+        private func take(_ messageId: UInt32) -> Completion? {
+            lock.lock()
+            defer { lock.unlock() }
+            return pending.removeValue(forKey: messageId)
+        }
+    #endif
+}
+
+#if os(macOS)
+    private final class CompletionBox {
+        let completion: SpiceRequestTracker.Completion
+
+        init(_ completion: @escaping SpiceRequestTracker.Completion) {
+            self.completion = completion
+        }
+    }
+
+    /// Takes back the box `begin` retained; the bridge calls this once per request
+    private let spiceRequestThunk:
+        @convention(c) (
+            UInt32,
+            winrun_request_status,
+            UnsafePointer<UInt8>?,
+            Int,
+            UnsafeMutableRawPointer?
+        ) -> Void = { _, status, response, length, userData in
+            guard let userData else { return }
+            let box = Unmanaged<CompletionBox>.fromOpaque(userData).takeRetainedValue()
+            switch status {
+            case WINRUN_REQUEST_COMPLETED:
+                let data = response.map { Data(bytes: $0, count: length) } ?? Data()
+                box.completion(.response(data))
+            case WINRUN_REQUEST_TIMED_OUT:
+                box.completion(.timedOut)
+            default:
+                box.completion(.cancelled)
+            }
+        }
+#endif
@@ -14,8 +14,18 @@ public struct SpiceStreamConfiguration: Hashable {
 
     public var transport: Transport
 
-    public init(transport: Transport = .tcp(host: "127.0.0.1", port: 5930, security: .plaintext, ticket: nil)) {
+    /// Show only the newest shared-memory frame on each `FrameReady`, skipping
+    /// any that queued up behind it, instead of one frame per notification.
+    /// Keeps displayed latency at one frame when notifications are coalesced,
+    /// lost, or arrive faster than the host reads.
+    public var drainsToLatestFrame: Bool
+
+    public init(
+        transport: Transport = .tcp(host: "127.0.0.1", port: 5930, security: .plaintext, ticket: nil),
+        drainsToLatestFrame: Bool = false
+    ) {
         self.transport = transport
+        self.drainsToLatestFrame = drainsToLatestFrame
     }
 
     public static func `default`() -> SpiceStreamConfiguration {
@@ -25,9 +35,13 @@ public struct SpiceStreamConfiguration: Hashable {
     public static func environmentDefault(
         _ environment: [String: String] = ProcessInfo.processInfo.environment
     ) -> SpiceStreamConfiguration {
+        let drainsToLatestFrame = environment["WINRUN_SPICE_DRAIN_FRAMES"] == "1"
         if let fdValue = environment["WINRUN_SPICE_SHM_FD"], let fd = Int32(fdValue) {
             let ticket = environment["WINRUN_SPICE_TICKET"]
-            return SpiceStreamConfiguration(transport: .sharedMemory(descriptor: fd, ticket: ticket))
+            return SpiceStreamConfiguration(
+                transport: .sharedMemory(descriptor: fd, ticket: ticket),
+                drainsToLatestFrame: drainsToLatestFrame
+            )
         }
 
         let host = environment["WINRUN_SPICE_HOST"] ?? "127.0.0.1"
@@ -41,7 +55,8 @@ public struct SpiceStreamConfiguration: Hashable {
                 port: port,
                 security: tlsEnabled ? .tls : .plaintext,
                 ticket: ticket
-            )
+            ),
+            drainsToLatestFrame: drainsToLatestFrame
         )
     }
 }
@@ -45,6 +45,29 @@ public enum SpiceConnectionState: Equatable, CustomStringConvertible {
     }
 }
 
+// MARK: - Stream Visibility
+
+/// Host-side visibility of a streamed window, used to throttle frame delivery.
+///
+/// Raw values match `STREAM_VISIBILITY` in `shared/protocol.def` and the C
+/// bridge's `winrun_stream_visibility` enum.
+public enum SpiceStreamVisibility: Int, Codable, CustomStringConvertible {
+    /// On screen and focused; frames are delivered at the full rate.
+    case visible = 0
+    /// On screen but not focused; frames are delivered at a reduced rate.
+    case background = 1
+    /// Minimized or fully occluded; frames are not captured or delivered.
+    case hidden = 2
+
+    public var description: String {
+        switch self {
+        case .visible: return "visible"
+        case .background: return "background"
+        case .hidden: return "hidden"
+        }
+    }
+}
+
 // MARK: - Delegate Protocol
 
 /// Delegate protocol for receiving Spice window stream events.
@@ -67,6 +90,21 @@ public protocol SpiceWindowStreamDelegate: AnyObject {
 
     /// Called when clipboard data is received from the guest.
     func windowStream(_ stream: SpiceWindowStream, didReceiveClipboard clipboard: ClipboardData)
+
+    /// Called when the guest changes, moves or hides its pointer.
+    /// Draw the pointer natively instead of waiting for it in frames.
+    func windowStream(_ stream: SpiceWindowStream, didUpdateCursor event: SpiceCursorEvent)
+
+    /// Called when a video region of the window has a new decoded frame.
+    /// Composite it into the current surface at `frame.destination`.
+    func windowStream(_ stream: SpiceWindowStream, didDecodeVideoFrame frame: SpiceVideoFrame)
+
+    /// Called when the stream's preview thumbnail is refreshed.
+    func windowStream(_ stream: SpiceWindowStream, didUpdateThumbnail thumbnail: SpiceThumbnail)
+
+    /// Called when the memory budget evicts the stream's backing surface.
+    /// Release any texture or image kept for the last frame; the next frame will recreate it.
+    func windowStreamDidEvictSurface(_ stream: SpiceWindowStream)
 }
 
 public extension SpiceWindowStreamDelegate {
@@ -74,6 +112,10 @@ public extension SpiceWindowStreamDelegate {
     func windowStream(_ stream: SpiceWindowStream, didChangeState state: SpiceConnectionState) {}
     func windowStream(_ stream: SpiceWindowStream, didReceiveClipboard clipboard: ClipboardData) {}
     func windowStream(_ stream: SpiceWindowStream, didReceiveSharedFrame frame: SharedFrame) {}
+    func windowStream(_ stream: SpiceWindowStream, didUpdateCursor event: SpiceCursorEvent) {}
+    func windowStream(_ stream: SpiceWindowStream, didDecodeVideoFrame frame: SpiceVideoFrame) {}
+    func windowStream(_ stream: SpiceWindowStream, didUpdateThumbnail thumbnail: SpiceThumbnail) {}
+    func windowStreamDidEvictSurface(_ stream: SpiceWindowStream) {}
 }
 
 // MARK: - Window Metadata
@@ -160,9 +202,31 @@ struct StreamState {
 
     var lifecycle: Lifecycle = .disconnected
     var subscription: SpiceStreamSubscription?
+    /// Subscription whose transport dropped, kept so reconnects can resume it
+    var suspendedSubscription: SpiceStreamSubscription?
     var windowID: UInt64?
     var isUserInitiatedClose = false
     var isPaused = false
+    var visibility: SpiceStreamVisibility = .visible
+    /// Frame rate cap requested with `visibility`, 0 for the default
+    var maxFrameRate: UInt32 = 0
+    /// The guest was told nobody is watching this window, so it stopped capturing it
+    var releasedGuestDemand = false
+    /// Whether the window is focused, so the guest gives it the highest frame rate
+    var isFocused = false
+    /// Tiled frame decode time last sent to the guest, and when
+    var reportedDecodeUs: UInt32?
+    var decodeReportedAt: Date?
+    /// Frames skipped since the last hint, and when skips were last reported
+    var unreportedSkippedFrames: UInt32 = 0
+    var skipsReportedAt: Date?
+    var lastFrameDeliveredAt: Date?
+    /// When the previous frame reached the consumer, for `effectiveFrameRate`
+    var lastDeliveryAt: Date?
+    /// Hash of the last pointer shape reported to the delegate
+    var cursorHash: UInt64?
+    /// Latest dropped-frame count reported for each video stream
+    var videoFramesDropped: [UInt32: UInt64] = [:]
 }
 
 struct SpiceStreamCloseReason: CustomStringConvertible {
@@ -186,18 +250,39 @@ struct SpiceStreamCallbacks {
     let onMetadata: (WindowMetadata) -> Void
     let onClosed: (SpiceStreamCloseReason) -> Void
     let onClipboard: (ClipboardData) -> Void
+    let onCursor: (SpiceCursorEvent) -> Void
+    let onVideoFrame: (SpiceVideoFrame) -> Void
+    /// FrameReady notifications for the stream's window, when the transport
+    /// can route them past the control channel
+    var onFrameReady: ((FrameReadyMessage) -> Void)?
 }
 
 struct SpiceStreamSubscription {
     private let cleanupHandler: () -> Void
+    private let resumeHandler: (() throws -> Void)?
 
-    init(cleanup: @escaping () -> Void) {
+    init(cleanup: @escaping () -> Void, resume: (() throws -> Void)? = nil) {
         cleanupHandler = cleanup
+        resumeHandler = resume
     }
 
     func cleanup() {
         cleanupHandler()
     }
+
+    /// Whether the transport can re-attach this stream to a new connection
+    var canResume: Bool {
+        resumeHandler != nil
+    }
+
+    /// Re-attaches the stream to a new connection, keeping its callbacks and
+    /// bridge-side state. Throws if the connection can't be re-established.
+    func resume() throws {
+        guard let resumeHandler else {
+            throw SpiceStreamError.connectionFailed("Stream does not support resume")
+        }
+        try resumeHandler()
+    }
 }
 
 enum SpiceStreamError: Error {
@@ -28,9 +28,43 @@ protocol SpiceStreamTransport {
     // Drag and drop
     func sendDragDropEvent(_ event: DragDropEvent)
 
+    // Visibility throttling
+    func setVisibility(_ visibility: SpiceStreamVisibility, maxFrameRate: UInt32)
+
     // Control channel
     func setControlCallback(_ callback: @escaping (Data) -> Void)
     func sendControlMessage(_ data: Data) -> Bool
+    func setRequestTracker(_ tracker: SpiceRequestTracker?)
+
+    // Guest heartbeat
+    func startHeartbeat(
+        interval: Duration,
+        stallAfter: Duration,
+        onHealthChange: @escaping (SpiceGuestHealth, SpiceHeartbeatStats) -> Void
+    ) -> Bool
+    func stopHeartbeat()
+    func heartbeatStatistics() -> SpiceHeartbeatStats?
+}
+
+extension SpiceStreamTransport {
+    /// Transports without the bridge leave responses on the control callback,
+    /// where `SpiceControlChannel` completes them itself.
+    func setRequestTracker(_ tracker: SpiceRequestTracker?) {}
+
+    /// Only the bridge pings the guest; other transports report no heartbeat.
+    func startHeartbeat(
+        interval: Duration,
+        stallAfter: Duration,
+        onHealthChange: @escaping (SpiceGuestHealth, SpiceHeartbeatStats) -> Void
+    ) -> Bool {
+        false
+    }
+
+    func stopHeartbeat() {}
+
+    func heartbeatStatistics() -> SpiceHeartbeatStats? {
+        nil
+    }
 }
 
 // MARK: - macOS Implementation
@@ -38,10 +72,14 @@ protocol SpiceStreamTransport {
 #if os(macOS)
     final class LibSpiceStreamTransport: SpiceStreamTransport {
         private let logger: Logger
+        private let callbackExecutor: SpiceCallbackExecutor?
         private var currentHandle: SpiceStreamHandle?
 
-        init(logger: Logger) {
+        /// - Parameter callbackExecutor: Where the bridge runs frame, metadata, clipboard
+        ///   and control callbacks; inline on the bridge's threads when nil
+        init(logger: Logger, callbackExecutor: SpiceCallbackExecutor? = nil) {
             self.logger = logger
+            self.callbackExecutor = callbackExecutor
         }
 
         func openStream(
@@ -83,13 +121,46 @@ protocol SpiceStreamTransport {
             }
 
             self.currentHandle = handle
+            // Released with the trampoline below, after the stream is closed
+            winrun_spice_set_cursor_callback(handle, spiceCursorThunk, unmanaged.toOpaque())
+            winrun_spice_set_video_callback(handle, spiceVideoThunk, unmanaged.toOpaque())
+            if let executor = callbackExecutor?.handle {
+                let kinds = WINRUN_CALLBACK_FRAME.rawValue | WINRUN_CALLBACK_METADATA.rawValue |
+                    WINRUN_CALLBACK_CLIPBOARD.rawValue
+                winrun_spice_stream_set_executor(handle, kinds, executor)
+            }
 
-            return SpiceStreamSubscription {
-                if let handle {
-                    winrun_spice_stream_close(handle)
-                }
-                unmanaged.release()
+            // The bridge hands this window's FrameReady notifications straight to
+            // the stream instead of through the control channel and frame router
+            let routesFrames = callbacks.onFrameReady != nil &&
+                winrun_spice_route_window(windowID, spiceFrameReadyThunk, nil, unmanaged.toOpaque())
+
+            // Shared-memory resumes go through the configured descriptor again
+            let resumeDescriptor: Int32
+            if case let .sharedMemory(descriptor, _) = configuration.transport {
+                resumeDescriptor = descriptor
+            } else {
+                resumeDescriptor = -1
             }
+
+            return SpiceStreamSubscription(
+                cleanup: {
+                    if routesFrames {
+                        winrun_spice_unroute_window(windowID)
+                    }
+                    if let handle {
+                        winrun_spice_stream_close(handle)
+                    }
+                    unmanaged.release()
+                },
+                resume: {
+                    var resumeError = [CChar](repeating: 0, count: 512)
+                    guard winrun_spice_stream_resume(handle, resumeDescriptor, &resumeError, resumeError.count) else {
+                        let message = String(cString: resumeError)
+                        throw SpiceStreamError.connectionFailed(message.isEmpty ? "Unknown libspice error" : message)
+                    }
+                }
+            )
         }
 
         private func openTCPStream(
@@ -181,6 +252,10 @@ protocol SpiceStreamTransport {
             releaseControlTrampoline()
             currentHandle = nil
             subscription.cleanup()
+            requestTracker = nil
+            // Closing the stream stopped the heartbeat
+            heartbeatTrampolineRef?.release()
+            heartbeatTrampolineRef = nil
         }
 
         // MARK: - Input Forwarding
@@ -304,6 +379,17 @@ protocol SpiceStreamTransport {
             }
         }
 
+        // MARK: - Visibility
+
+        func setVisibility(_ visibility: SpiceStreamVisibility, maxFrameRate: UInt32) {
+            guard let handle = currentHandle else { return }
+            _ = winrun_spice_stream_set_visibility(
+                handle,
+                winrun_stream_visibility(rawValue: UInt32(visibility.rawValue)),
+                maxFrameRate
+            )
+        }
+
         // MARK: - Control Channel
 
         private var controlCallback: ((Data) -> Void)?
@@ -320,6 +406,63 @@ protocol SpiceStreamTransport {
             controlTrampolineRef = Unmanaged.passRetained(trampoline)
 
             winrun_spice_set_control_callback(handle, controlMessageThunk, controlTrampolineRef!.toOpaque())
+            if let executor = callbackExecutor?.handle {
+                winrun_spice_stream_set_executor(handle, WINRUN_CALLBACK_CONTROL.rawValue, executor)
+            }
+        }
+
+        /// Held until the stream closes; the bridge may be using it until then
+        private var requestTracker: SpiceRequestTracker?
+
+        func setRequestTracker(_ tracker: SpiceRequestTracker?) {
+            guard let handle = currentHandle else { return }
+            winrun_spice_stream_set_request_tracker(handle, tracker?.handle)
+            if let tracker {
+                requestTracker = tracker
+            }
+        }
+
+        // MARK: - Guest Heartbeat
+
+        /// Held until the heartbeat stops or the stream closes
+        private var heartbeatTrampolineRef: Unmanaged<HeartbeatTrampoline>?
+
+        func startHeartbeat(
+            interval: Duration,
+            stallAfter: Duration,
+            onHealthChange: @escaping (SpiceGuestHealth, SpiceHeartbeatStats) -> Void
+        ) -> Bool {
+            guard let handle = currentHandle else { return false }
+
+            let trampoline = Unmanaged.passRetained(HeartbeatTrampoline(onHealthChange: onHealthChange))
+            let started = winrun_spice_stream_start_heartbeat(
+                handle,
+                interval.clampedMilliseconds,
+                stallAfter.clampedMilliseconds,
+                spiceGuestHealthThunk,
+                trampoline.toOpaque()
+            )
+            // Starting stopped any previous heartbeat, so its trampoline is unused
+            heartbeatTrampolineRef?.release()
+            heartbeatTrampolineRef = started ? trampoline : nil
+            if !started {
+                trampoline.release()
+            }
+            return started
+        }
+
+        func stopHeartbeat() {
+            guard let handle = currentHandle else { return }
+            winrun_spice_stream_stop_heartbeat(handle)
+            heartbeatTrampolineRef?.release()
+            heartbeatTrampolineRef = nil
+        }
+
+        func heartbeatStatistics() -> SpiceHeartbeatStats? {
+            guard let handle = currentHandle else { return nil }
+            var stats = winrun_heartbeat_stats()
+            guard winrun_spice_stream_get_heartbeat_stats(handle, &stats) else { return nil }
+            return SpiceHeartbeatStats(stats)
         }
 
         /// Clean up control callback trampoline when stream closes
@@ -378,6 +521,18 @@ protocol SpiceStreamTransport {
         func handleClipboard(_ clipboard: ClipboardData) {
             callbacks.onClipboard(clipboard)
         }
+
+        func handleCursor(_ event: SpiceCursorEvent) {
+            callbacks.onCursor(event)
+        }
+
+        func handleVideoFrame(_ frame: SpiceVideoFrame) {
+            callbacks.onVideoFrame(frame)
+        }
+
+        func handleFrameReady(_ notification: FrameReadyMessage) {
+            callbacks.onFrameReady?(notification)
+        }
     }
 
     private final class ControlCallbackTrampoline {
@@ -405,6 +560,30 @@ protocol SpiceStreamTransport {
             trampoline.handleControlMessage(data)
         }
 
+    private final class HeartbeatTrampoline {
+        private let onHealthChange: (SpiceGuestHealth, SpiceHeartbeatStats) -> Void
+
+        init(onHealthChange: @escaping (SpiceGuestHealth, SpiceHeartbeatStats) -> Void) {
+            self.onHealthChange = onHealthChange
+        }
+
+        func handleHealthChange(_ health: SpiceGuestHealth, _ stats: SpiceHeartbeatStats) {
+            onHealthChange(health, stats)
+        }
+    }
+
+    private let spiceGuestHealthThunk:
+        @convention(c) (
+            winrun_guest_health,
+            UnsafePointer<winrun_heartbeat_stats>?,
+            UnsafeMutableRawPointer?
+        ) -> Void = { health, stats, userData in
+            guard let stats, let userData else { return }
+            let trampoline = Unmanaged<HeartbeatTrampoline>.fromOpaque(userData)
+                .takeUnretainedValue()
+            trampoline.handleHealthChange(SpiceGuestHealth(health), SpiceHeartbeatStats(stats.pointee))
+        }
+
     private let spiceFrameThunk:
         @convention(c) (
             UnsafePointer<UInt8>?,
@@ -444,6 +623,97 @@ protocol SpiceStreamTransport {
             trampoline.handleMetadata(windowMetadata)
         }
 
+    private let spiceCursorThunk:
+        @convention(c) (
+            UnsafePointer<winrun_cursor_event>?,
+            UnsafeMutableRawPointer?
+        ) -> Void = { eventPointer, userData in
+            guard let eventPointer, let userData else { return }
+            let event = eventPointer.pointee
+            let cursorEvent: SpiceCursorEvent
+            switch event.type {
+            case WINRUN_CURSOR_EVENT_SET:
+                guard let shape = event.shape?.pointee, let pixels = shape.pixels else { return }
+                // The bridge's shape cache owns the pixels; copy them out
+                cursorEvent = .set(SpiceCursorImage(
+                    hash: shape.hash,
+                    width: Int(shape.width),
+                    height: Int(shape.height),
+                    hotspotX: Int(shape.hot_x),
+                    hotspotY: Int(shape.hot_y),
+                    data: Data(bytes: pixels, count: shape.length)
+                ))
+            case WINRUN_CURSOR_EVENT_MOVE:
+                cursorEvent = .move(x: event.x, y: event.y)
+            case WINRUN_CURSOR_EVENT_HIDE:
+                cursorEvent = .hide
+            default:
+                cursorEvent = .reset
+            }
+
+            let trampoline = Unmanaged<CallbackTrampoline>.fromOpaque(userData)
+                .takeUnretainedValue()
+            trampoline.handleCursor(cursorEvent)
+        }
+
+    private let spiceVideoThunk:
+        @convention(c) (
+            UnsafePointer<winrun_video_frame>?,
+            UnsafeMutableRawPointer?
+        ) -> Void = { framePointer, userData in
+            guard let framePointer, let userData else { return }
+            let frame = framePointer.pointee
+            guard let pixels = frame.pixels else { return }
+
+            // Called on the bridge's decode thread; the pixel buffer is reused for the next frame
+            let videoFrame = SpiceVideoFrame(
+                windowID: frame.window_id,
+                streamID: frame.stream_id,
+                destination: CGRect(
+                    x: Int(frame.dest.x),
+                    y: Int(frame.dest.y),
+                    width: Int(frame.dest.width),
+                    height: Int(frame.dest.height)
+                ),
+                width: Int(frame.width),
+                height: Int(frame.height),
+                data: Data(bytes: pixels, count: frame.stride * Int(frame.height)),
+                presentationTime: frame.mm_time,
+                decodeDuration: TimeInterval(frame.decode_ns) / 1_000_000_000,
+                droppedFrames: frame.dropped_frames
+            )
+
+            let trampoline = Unmanaged<CallbackTrampoline>.fromOpaque(userData)
+                .takeUnretainedValue()
+            trampoline.handleVideoFrame(videoFrame)
+        }
+
+    private let spiceFrameReadyThunk:
+        @convention(c) (
+            UnsafePointer<winrun_frame_ready>?,
+            UnsafeMutableRawPointer?
+        ) -> Void = { framePointer, userData in
+            guard let framePointer, let userData else { return }
+            let frame = framePointer.pointee
+            // Called on the control port's thread; the reason points into the message
+            let rateReason = frame.rate_reason.map { pointer in
+                String(decoding: UnsafeRawBufferPointer(start: pointer, count: frame.rate_reason_length), as: UTF8.self)
+            }
+            let notification = FrameReadyMessage(
+                timestamp: frame.timestamp,
+                windowId: frame.window_id,
+                slotIndex: frame.slot_index,
+                frameNumber: frame.frame_number,
+                isKeyFrame: frame.is_key_frame,
+                targetFps: frame.target_fps == 0 ? nil : frame.target_fps,
+                rateReason: rateReason
+            )
+
+            let trampoline = Unmanaged<CallbackTrampoline>.fromOpaque(userData)
+                .takeUnretainedValue()
+            trampoline.handleFrameReady(notification)
+        }
+
     private let spiceClosedThunk:
         @convention(c) (
             winrun_spice_close_reason,
@@ -542,6 +812,12 @@ protocol SpiceStreamTransport {
                 "Mock: sendDragDropEvent type=\(event.eventType) files=\(event.files.count)")
         }
 
+        // MARK: - Visibility (Mock)
+
+        func setVisibility(_ visibility: SpiceStreamVisibility, maxFrameRate: UInt32) {
+            logger.debug("Mock: setVisibility \(visibility) maxFrameRate=\(maxFrameRate)")
+        }
+
         // MARK: - Control Channel (Mock)
 
         private var mockControlCallback: ((Data) -> Void)?
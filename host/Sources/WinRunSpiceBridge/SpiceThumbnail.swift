@@ -0,0 +1,197 @@
+import Foundation
+import WinRunShared
+
+// MARK: - Thumbnail Configuration
+
+/// Settings for the per-stream preview thumbnail used by Mission Control,
+/// the Dock and the window switcher.
+public struct SpiceThumbnailConfiguration: Equatable {
+    /// Maximum thumbnail width in pixels
+    public var maxWidth: Int
+    /// Maximum thumbnail height in pixels
+    public var maxHeight: Int
+    /// Minimum time between thumbnail refreshes
+    public var refreshInterval: TimeInterval
+
+    public init(maxWidth: Int = 256, maxHeight: Int = 256, refreshInterval: TimeInterval = 1.0) {
+        self.maxWidth = maxWidth
+        self.maxHeight = maxHeight
+        self.refreshInterval = refreshInterval
+    }
+}
+
+// MARK: - Thumbnail
+
+/// A downscaled copy of a window's most recent frame.
+/// Pixels keep the source format (normally BGRA) with no row padding.
+public struct SpiceThumbnail {
+    public let windowId: UInt64
+    public let frameNumber: UInt32
+    public let width: Int
+    public let height: Int
+    public let format: SpicePixelFormat
+    public let data: Data
+    /// Dimensions of the frame the thumbnail was made from
+    public let sourceWidth: Int
+    public let sourceHeight: Int
+    public let createdAt: Date
+
+    /// Bytes per row
+    public var stride: Int { width * 4 }
+
+    public init(
+        windowId: UInt64,
+        frameNumber: UInt32,
+        width: Int,
+        height: Int,
+        format: SpicePixelFormat,
+        data: Data,
+        sourceWidth: Int,
+        sourceHeight: Int,
+        createdAt: Date = Date()
+    ) {
+        self.windowId = windowId
+        self.frameNumber = frameNumber
+        self.width = width
+        self.height = height
+        self.format = format
+        self.data = data
+        self.sourceWidth = sourceWidth
+        self.sourceHeight = sourceHeight
+        self.createdAt = createdAt
+    }
+}
+
+extension SpiceThumbnail {
+    /// Downscales an uncompressed frame to fit `configuration`.
+    /// Returns nil for compressed frames, which need decoding first.
+    init?(frame header: FrameSlotHeader, pixels: UnsafeRawBufferPointer, fitting configuration: SpiceThumbnailConfiguration) {
+        guard !FrameSlotFlags(rawValue: header.flags).contains(.compressed) else {
+            return nil
+        }
+
+        let width = Int(header.width)
+        let height = Int(header.height)
+        let factor = ThumbnailDownscaler.scaleFactor(
+            width: width,
+            height: height,
+            maxWidth: configuration.maxWidth,
+            maxHeight: configuration.maxHeight
+        )
+        guard let scaled = ThumbnailDownscaler.downscale(
+            source: pixels,
+            width: width,
+            height: height,
+            stride: Int(header.stride),
+            factor: factor
+        ) else {
+            return nil
+        }
+
+        self.init(
+            windowId: header.windowId,
+            frameNumber: header.frameNumber,
+            width: scaled.width,
+            height: scaled.height,
+            format: SpicePixelFormat(rawValue: UInt8(truncatingIfNeeded: header.format)) ?? .bgra32,
+            data: scaled.data,
+            sourceWidth: width,
+            sourceHeight: height
+        )
+    }
+}
+
+// MARK: - Box Filter Downscaler
+
+/// Integer-factor box-filter downscaler for 32-bit pixel formats.
+///
+/// Each output pixel is the rounded mean of a `factor × factor` block of
+/// source pixels. Channels are accumulated in SIMD lanes, four pixels per
+/// 16-byte load, so only the rows and columns that contribute to the output
+/// are touched and nothing is copied beforehand.
+public enum ThumbnailDownscaler {
+    /// Returns the smallest integer factor that fits the source within the bounds.
+    public static func scaleFactor(width: Int, height: Int, maxWidth: Int, maxHeight: Int) -> Int {
+        guard maxWidth > 0, maxHeight > 0 else { return 1 }
+        let factorX = (width + maxWidth - 1) / maxWidth
+        let factorY = (height + maxHeight - 1) / maxHeight
+        return max(1, factorX, factorY)
+    }
+
+    /// Downscales 32-bit pixels by `factor` in each direction.
+    /// Trailing rows and columns that don't fill a whole block are ignored.
+    /// - Parameters:
+    ///   - source: Source pixels
+    ///   - width: Source width in pixels
+    ///   - height: Source height in pixels
+    ///   - stride: Source bytes per row
+    ///   - factor: Block size in pixels
+    /// - Returns: Tightly packed output pixels and their dimensions, or nil if the source is invalid
+    public static func downscale(
+        source: UnsafeRawBufferPointer,
+        width: Int,
+        height: Int,
+        stride: Int,
+        factor: Int
+    ) -> (data: Data, width: Int, height: Int)? {
+        guard width > 0, height > 0, factor > 0, stride >= width * 4,
+              let base = source.baseAddress,
+              source.count >= stride * (height - 1) + width * 4
+        else {
+            return nil
+        }
+
+        let blockWidth = min(factor, width)
+        let blockHeight = min(factor, height)
+        let outWidth = width / blockWidth
+        let outHeight = height / blockHeight
+        let outStride = outWidth * 4
+
+        let sampleCount = UInt32(blockWidth * blockHeight)
+        let rounding = SIMD4<UInt32>(repeating: sampleCount / 2)
+        let divisor = SIMD4<UInt32>(repeating: sampleCount)
+        let wideLoads = blockWidth / 4
+        let tailPixels = blockWidth % 4
+
+        var output = Data(count: outStride * outHeight)
+        output.withUnsafeMutableBytes { outBuffer in
+            guard let outBase = outBuffer.baseAddress else { return }
+
+            for outY in 0..<outHeight {
+                let firstRow = outY * blockHeight
+                for outX in 0..<outWidth {
+                    var wide = SIMD16<UInt32>()
+                    var narrow = SIMD4<UInt32>()
+                    let columnOffset = outX * blockWidth * 4
+
+                    for row in firstRow..<(firstRow + blockHeight) {
+                        var offset = row * stride + columnOffset
+                        for _ in 0..<wideLoads {
+                            let pixels = base.loadUnaligned(fromByteOffset: offset, as: SIMD16<UInt8>.self)
+                            wide &+= SIMD16<UInt32>(truncatingIfNeeded: pixels)
+                            offset += 16
+                        }
+                        for _ in 0..<tailPixels {
+                            let pixel = base.loadUnaligned(fromByteOffset: offset, as: SIMD4<UInt8>.self)
+                            narrow &+= SIMD4<UInt32>(truncatingIfNeeded: pixel)
+                            offset += 4
+                        }
+                    }
+
+                    // Fold the four pixels held in `wide` down to one set of channel sums
+                    let pairs = wide.lowHalf &+ wide.highHalf
+                    let sum = pairs.lowHalf &+ pairs.highHalf &+ narrow
+                    let mean = (sum &+ rounding) / divisor
+
+                    outBase.storeBytes(
+                        of: SIMD4<UInt8>(truncatingIfNeeded: mean),
+                        toByteOffset: outY * outStride + outX * 4,
+                        as: SIMD4<UInt8>.self
+                    )
+                }
+            }
+        }
+
+        return (output, outWidth, outHeight)
+    }
+}
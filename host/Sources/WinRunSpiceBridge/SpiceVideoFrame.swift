@@ -0,0 +1,52 @@
+import Foundation
+
+// MARK: - Video Frame
+
+/// A frame of a server-detected video region (e.g. playback in a browser),
+/// decoded by the bridge off the Spice event thread.
+///
+/// Video streams cover part of the window and run on their own clock, so
+/// consumers composite each frame into the window surface at `destination`
+/// rather than treating it as a full-window update.
+public struct SpiceVideoFrame {
+    public let windowID: UInt64
+    public let streamID: UInt32
+    /// Region of the window the stream covers, in guest pixels
+    public let destination: CGRect
+    /// Decoded size; differs from `destination` when the server scales the stream
+    public let width: Int
+    public let height: Int
+    /// BGRA pixels with no row padding
+    public let data: Data
+    /// Stream timestamp in milliseconds
+    public let presentationTime: UInt32
+    /// Time the bridge spent decoding the frame
+    public let decodeDuration: TimeInterval
+    /// Frames dropped on this stream so far
+    public let droppedFrames: UInt64
+
+    /// Bytes per row
+    public var stride: Int { width * 4 }
+
+    public init(
+        windowID: UInt64,
+        streamID: UInt32,
+        destination: CGRect,
+        width: Int,
+        height: Int,
+        data: Data,
+        presentationTime: UInt32,
+        decodeDuration: TimeInterval = 0,
+        droppedFrames: UInt64 = 0
+    ) {
+        self.windowID = windowID
+        self.streamID = streamID
+        self.destination = destination
+        self.width = width
+        self.height = height
+        self.data = data
+        self.presentationTime = presentationTime
+        self.decodeDuration = decodeDuration
+        self.droppedFrames = droppedFrames
+    }
+}
@@ -4,12 +4,15 @@ import WinRunShared
 /// Manages a Spice stream connection to a Windows guest window.
 ///
 /// `SpiceWindowStream` handles:
-/// - Connection lifecycle (connect, disconnect, reconnect)
+/// - Connection lifecycle (connect, disconnect, reconnect, resume after a drop)
 /// - Frame and metadata delivery to delegate
 /// - Input forwarding (mouse, keyboard)
 /// - Clipboard synchronization
 /// - Drag and drop events
 /// - Frame routing from shared memory buffer
+/// - Visibility-based frame throttling
+/// - Downscaled preview thumbnails
+/// - Memory accounting against a shared `SpiceMemoryBudget`
 public final class SpiceWindowStream {
     public weak var delegate: SpiceWindowStreamDelegate?
 
@@ -17,27 +20,42 @@ public final class SpiceWindowStream {
     private let delegateQueue: DispatchQueue
     private let transport: SpiceStreamTransport
     private let logger: Logger
-    private let stateQueue = DispatchQueue(label: "com.winrun.spice.window-stream.state")
+    private let stateQueue: DispatchQueue
     private var state = StreamState()
     private var reconnectPolicy: ReconnectPolicy
     private var reconnectWorkItem: DispatchWorkItem?
+    /// Read of the newest frame once a throttled interval is up
+    private var deferredFrameRead: DispatchWorkItem?
     private var metrics = SpiceStreamMetrics()
 
     /// Shared frame buffer reader for zero-copy frame access
     private var frameBufferReader: SharedFrameBufferReader?
 
+    /// Preview thumbnail settings, nil when thumbnails are disabled
+    private var thumbnailConfiguration: SpiceThumbnailConfiguration?
+    private var thumbnail: SpiceThumbnail?
+
+    /// Budget this stream's surfaces and thumbnails are charged to
+    private var memoryBudget: SpiceMemoryBudget?
+    private var memoryAccount: SpiceMemoryAccount?
+
+    /// - Parameter callbackExecutor: Runs this stream's bridge callbacks and state in
+    ///   batches on the executor's queue. Share one executor between windows to wake
+    ///   once for many events; nil runs callbacks on the bridge's threads.
     public convenience init(
         configuration: SpiceStreamConfiguration = SpiceStreamConfiguration.environmentDefault(),
         delegateQueue: DispatchQueue = .main,
         logger: Logger = StandardLogger(subsystem: "SpiceWindowStream"),
-        reconnectPolicy: ReconnectPolicy = ReconnectPolicy()
+        reconnectPolicy: ReconnectPolicy = ReconnectPolicy(),
+        callbackExecutor: SpiceCallbackExecutor? = nil
     ) {
         self.init(
             configuration: configuration,
             delegateQueue: delegateQueue,
             logger: logger,
             transport: nil,
-            reconnectPolicy: reconnectPolicy
+            reconnectPolicy: reconnectPolicy,
+            callbackExecutor: callbackExecutor
         )
     }
 
@@ -46,14 +64,17 @@ public final class SpiceWindowStream {
         delegateQueue: DispatchQueue = .main,
         logger: Logger = StandardLogger(subsystem: "SpiceWindowStream"),
         transport: SpiceStreamTransport?,
-        reconnectPolicy: ReconnectPolicy = ReconnectPolicy()
+        reconnectPolicy: ReconnectPolicy = ReconnectPolicy(),
+        callbackExecutor: SpiceCallbackExecutor? = nil
     ) {
         self.configuration = configuration
         self.delegateQueue = delegateQueue
         self.logger = logger
         self.reconnectPolicy = reconnectPolicy
+        // Work the executor hands over is already on its queue, so it runs without another wakeup
+        self.stateQueue = DispatchQueue(label: "com.winrun.spice.window-stream.state", target: callbackExecutor?.queue)
         #if os(macOS)
-        self.transport = transport ?? LibSpiceStreamTransport(logger: logger)
+        self.transport = transport ?? LibSpiceStreamTransport(logger: logger, callbackExecutor: callbackExecutor)
         #else
         self.transport = transport ?? MockSpiceStreamTransport(logger: logger)
         #endif
@@ -105,6 +126,7 @@ public final class SpiceWindowStream {
             self.logger.info("Disconnect requested for window stream")
             self.state.isUserInitiatedClose = true
             self.cancelReconnect()
+            self.releaseGuestDemand()
             guard let subscription = self.state.subscription else {
                 self.finishDisconnect()
                 return
@@ -136,6 +158,7 @@ public final class SpiceWindowStream {
                     self.transport.closeStream(subscription)
                     self.state.subscription = nil
                 }
+                self.discardSuspendedSubscription()
                 self.cancelReconnect()
             }
 
@@ -147,14 +170,13 @@ public final class SpiceWindowStream {
     }
 
     /// Pause the stream when window is not visible (minimized, hidden).
-    /// This helps conserve resources while the window is out of sight.
+    /// Equivalent to `setVisibility(.hidden)`: frames stop being delivered and
+    /// the guest stops capturing the window, but the connection stays open.
     public func pause() {
         stateQueue.async {
             guard self.state.lifecycle == .connected else { return }
-            self.state.isPaused = true
+            self.applyVisibility(.hidden, maxFrameRate: 0)
             self.logger.debug("Stream paused (window not visible)")
-            // Note: We don't disconnect - just flag that we're paused
-            // Transport can optionally reduce frame rate or buffer frames
         }
     }
 
@@ -162,7 +184,7 @@ public final class SpiceWindowStream {
     public func resume() {
         stateQueue.async {
             guard self.state.isPaused else { return }
-            self.state.isPaused = false
+            self.applyVisibility(.visible, maxFrameRate: 0)
             self.logger.debug("Stream resumed (window visible)")
 
             // If we disconnected while paused, reconnect
@@ -180,6 +202,41 @@ public final class SpiceWindowStream {
         stateQueue.sync { state.isPaused }
     }
 
+    /// Updates the window's visibility so frame delivery can be throttled.
+    ///
+    /// Hidden streams drop frames without reading them; background streams are
+    /// limited to `maxFrameRate` (or the bridge default when 0), and visible
+    /// ones to `maxFrameRate` when it is set. The hint is also forwarded to the
+    /// guest so it stops or slows capture for the window.
+    /// - Parameters:
+    ///   - visibility: Current visibility of the host window
+    ///   - maxFrameRate: Frame rate cap, or 0 for the default for `visibility`
+    public func setVisibility(_ visibility: SpiceStreamVisibility, maxFrameRate: UInt32 = 0) {
+        stateQueue.async {
+            guard visibility != self.state.visibility || maxFrameRate != self.state.maxFrameRate else {
+                return
+            }
+            self.applyVisibility(visibility, maxFrameRate: maxFrameRate)
+        }
+    }
+
+    /// The visibility last set for this stream.
+    public var visibility: SpiceStreamVisibility {
+        stateQueue.sync { state.visibility }
+    }
+
+    /// Tells the guest whether this window has focus. The focused window is
+    /// captured at the guest's highest rate; the others follow how often they change.
+    public func setFocused(_ focused: Bool) {
+        stateQueue.async {
+            guard focused != self.state.isFocused else { return }
+            self.state.isFocused = focused
+            if self.state.lifecycle == .connected {
+                self.sendThrottleHint()
+            }
+        }
+    }
+
     public func metricsSnapshot() -> SpiceStreamMetrics {
         stateQueue.sync { metrics }
     }
@@ -202,6 +259,20 @@ public final class SpiceWindowStream {
         }
     }
 
+    /// Moves the attached reader onto a reallocated buffer, in order with
+    /// the frames it reads.
+    /// - Parameters:
+    ///   - reader: The reader to remap; ignored unless it is the attached one
+    ///   - pointer: Start of the new buffer
+    ///   - size: Size of the new buffer in bytes
+    public func remapFrameBufferReader(_ reader: SharedFrameBufferReader, pointer: UnsafeMutableRawPointer, size: Int) {
+        stateQueue.async {
+            guard self.frameBufferReader === reader else { return }
+            reader.remap(pointer: pointer, size: size)
+            self.logger.debug("Frame buffer reader remapped (\(size / 1024) KB)")
+        }
+    }
+
     /// Handles a FrameReady notification from the control channel.
     /// Reads the frame from shared memory and delivers it to the delegate.
     /// - Parameter notification: The FrameReady message indicating a new frame is available
@@ -217,26 +288,141 @@ public final class SpiceWindowStream {
                 return
             }
 
+            self.recordGuestRate(notification)
+
             guard let reader = self.frameBufferReader else {
                 self.logger.debug("Dropping FrameReady - no frame buffer reader")
                 return
             }
 
-            do {
-                if let frame = try reader.readNextFrame() {
-                    self.metrics.framesReceived += 1
-                    self.deliverFrame(frame)
-                } else {
-                    self.logger.debug("FrameReady but no frame available in buffer")
-                }
-            } catch {
-                self.logger.error("Failed to read frame from shared memory: \(error)")
+            // Once the frame is handled, so the composed frame includes it;
+            // this also refreshes thumbnails while throttled
+            defer { self.refreshThumbnailIfNeeded(from: reader) }
+
+            if self.state.visibility == .hidden {
+                // Free the slots for the guest without copying frames nobody will see
+                self.metrics.framesThrottled += reader.discardFrames()
+                return
+            }
+            guard let interval = self.frameInterval else {
+                self.deliverNextFrame(from: reader)
+                return
+            }
+            let elapsed = self.state.lastFrameDeliveredAt.map { Date().timeIntervalSince($0) } ?? .infinity
+            if elapsed < interval {
+                // Leave the frame in the ring and come back for the newest one when the interval is up
+                self.metrics.framesThrottled += 1
+                self.scheduleDeferredFrameRead(after: interval - elapsed)
+                return
+            }
+            self.deliverLatestFrame(from: reader)
+        }
+    }
+
+    /// Minimum time between delivered frames: the background rate, or the
+    /// cap set for a visible window. Nil when visible frames aren't capped.
+    private var frameInterval: TimeInterval? {
+        switch state.visibility {
+        case .hidden, .background:
+            return 1.0 / Double(effectiveMaxFrameRate)
+        case .visible:
+            return state.maxFrameRate > 0 ? 1.0 / Double(state.maxFrameRate) : nil
+        }
+    }
+
+    /// Reads the newest frame once `delay` has passed, unless one is already
+    /// scheduled; the guest may not notify again before then.
+    /// Must be called on `stateQueue`.
+    private func scheduleDeferredFrameRead(after delay: TimeInterval) {
+        guard deferredFrameRead == nil else { return }
+        let workItem = DispatchWorkItem { [weak self] in
+            guard let self else { return }
+            self.deferredFrameRead = nil
+            guard self.state.lifecycle == .connected, self.state.visibility != .hidden,
+                  let reader = self.frameBufferReader else { return }
+            self.deliverLatestFrame(from: reader)
+        }
+        deferredFrameRead = workItem
+        stateQueue.asyncAfter(deadline: .now() + delay, execute: workItem)
+    }
+
+    private func cancelDeferredFrameRead() {
+        deferredFrameRead?.cancel()
+        deferredFrameRead = nil
+    }
+
+    /// Skips to the newest frame in the ring and delivers it.
+    /// Must be called on `stateQueue`.
+    private func deliverLatestFrame(from reader: SharedFrameBufferReader) {
+        metrics.framesThrottled += reader.discardFrames(keepingLatest: true)
+        deliverNextFrame(from: reader)
+    }
+
+    /// Must be called on `stateQueue`.
+    private func deliverNextFrame(from reader: SharedFrameBufferReader) {
+        cancelDeferredFrameRead()
+        do {
+            if let frame = try readFrame(from: reader) {
+                metrics.framesReceived += 1
+                state.lastFrameDeliveredAt = Date()
+                recordDelivery()
+                reportDecodeTime(from: reader)
+                deliverFrame(frame)
+            } else {
+                logger.debug("FrameReady but no frame available in buffer")
             }
+        } catch {
+            logger.error("Failed to read frame from shared memory: \(error)")
         }
     }
 
+    /// Reads the next frame to show: the newest one when draining to the
+    /// latest frame, otherwise the oldest pending one.
+    /// Must be called on `stateQueue`.
+    private func readFrame(from reader: SharedFrameBufferReader) throws -> SharedFrame? {
+        guard configuration.drainsToLatestFrame else {
+            return try reader.readNextFrame()
+        }
+        guard let drained = try reader.readLatestFrame() else { return nil }
+        metrics.framesSkipped += drained.skipped
+        reportSkippedFrames(drained.skipped)
+        return drained.frame
+    }
+
+    /// Keeps the guest's rate decision for the window in the stream's metrics.
+    /// Must be called on `stateQueue`.
+    private func recordGuestRate(_ notification: FrameReadyMessage) {
+        guard let targetFps = notification.targetFps else { return }
+        let target = Int(targetFps)
+        if metrics.guestTargetFrameRate != 0,
+           target != metrics.guestTargetFrameRate || notification.rateReason != metrics.guestRateReason {
+            metrics.guestRateChanges += 1
+        }
+        metrics.guestTargetFrameRate = target
+        metrics.guestRateReason = notification.rateReason
+    }
+
+    /// Updates `effectiveFrameRate` for a frame handed to the consumer.
+    /// Must be called on `stateQueue`.
+    private func recordDelivery() {
+        let now = Date()
+        defer { state.lastDeliveryAt = now }
+        guard let last = state.lastDeliveryAt else { return }
+
+        let interval = now.timeIntervalSince(last)
+        guard interval > 0 else { return }
+        let rate = 1.0 / interval
+        // Smooth over roughly the last ten frames
+        metrics.effectiveFrameRate = metrics.effectiveFrameRate == 0
+            ? rate
+            : metrics.effectiveFrameRate * 0.9 + rate * 0.1
+    }
+
     /// Delivers a frame from shared memory to the delegate.
     private func deliverFrame(_ frame: SharedFrame) {
+        // The consumer keeps one uncompressed surface of the latest frame size
+        memoryAccount?.setUsage(frame.width * frame.height * 4, for: .surface)
+
         guard let delegate else { return }
 
         // Convert SharedFrame to the format expected by the delegate
@@ -247,6 +433,202 @@ public final class SpiceWindowStream {
         }
     }
 
+    /// Frame rate used for background streams when no explicit cap was given.
+    static let defaultBackgroundFrameRate: UInt32 = 2
+
+    private var effectiveMaxFrameRate: UInt32 {
+        if state.maxFrameRate > 0 {
+            return state.maxFrameRate
+        }
+        return Self.defaultBackgroundFrameRate
+    }
+
+    /// Records the new visibility, updates the bridge, and forwards a throttle hint to the guest.
+    /// Must be called on `stateQueue`.
+    private func applyVisibility(_ visibility: SpiceStreamVisibility, maxFrameRate: UInt32) {
+        let wasHidden = state.visibility == .hidden
+        // The next notification schedules a read at the new rate
+        cancelDeferredFrameRead()
+        state.visibility = visibility
+        state.maxFrameRate = maxFrameRate
+        state.isPaused = visibility == .hidden
+        memoryAccount?.setVisibility(visibility)
+
+        guard state.lifecycle == .connected else { return }
+
+        transport.setVisibility(visibility, maxFrameRate: maxFrameRate)
+        sendThrottleHint()
+
+        // Show the newest buffered frame immediately instead of replaying stale ones
+        if wasHidden && visibility != .hidden, let reader = frameBufferReader {
+            metrics.framesThrottled += reader.discardFrames(keepingLatest: true)
+            state.lastFrameDeliveredAt = nil
+        }
+    }
+
+    /// Sends the current visibility to the guest's frame streaming service.
+    /// Must be called on `stateQueue`.
+    private func sendThrottleHint() {
+        state.releasedGuestDemand = false
+        sendThrottleHint(visibility: state.visibility, maxFrameRate: state.maxFrameRate, isFocused: state.isFocused)
+    }
+
+    /// Re-sends the throttle hint when the time to decode the guest's tiled
+    /// frames has moved by a quarter or more, at most once a second.
+    /// Must be called on `stateQueue`.
+    private func reportDecodeTime(from reader: SharedFrameBufferReader) {
+        guard let decodeUs = reader.tileDecodeTime?.clampedMicroseconds else { return }
+        if let reported = state.reportedDecodeUs, let reportedAt = state.decodeReportedAt {
+            let change = abs(Int64(decodeUs) - Int64(reported))
+            guard Date().timeIntervalSince(reportedAt) >= 1, change * 4 >= Int64(reported) else { return }
+        }
+        state.reportedDecodeUs = decodeUs
+        state.decodeReportedAt = Date()
+        sendThrottleHint()
+    }
+
+    /// Tells the guest the host had to skip frames to catch up, which is its
+    /// only sign of backpressure: the guest can't see which slots were read.
+    /// Reports at most twice a second; skips in between go with the next hint.
+    /// Must be called on `stateQueue`.
+    private func reportSkippedFrames(_ skipped: Int) {
+        guard skipped > 0 else { return }
+        state.unreportedSkippedFrames &+= UInt32(clamping: skipped)
+        if let reportedAt = state.skipsReportedAt, Date().timeIntervalSince(reportedAt) < 0.5 { return }
+        state.skipsReportedAt = Date()
+        sendThrottleHint()
+    }
+
+    /// Tells the guest nobody is watching this window any more, so it stops
+    /// capturing it instead of filling a ring nobody reads. The next connect
+    /// sends the real visibility again. Must be called on `stateQueue`.
+    private func releaseGuestDemand() {
+        guard state.lifecycle == .connected, !state.releasedGuestDemand else { return }
+        sendThrottleHint(visibility: .hidden, maxFrameRate: 0, isFocused: false)
+        state.releasedGuestDemand = true
+    }
+
+    private func sendThrottleHint(visibility: SpiceStreamVisibility, maxFrameRate: UInt32, isFocused: Bool) {
+        guard let windowID = state.windowID else { return }
+        let message = SetWindowThrottleSpiceMessage(
+            windowId: windowID,
+            visibility: visibility,
+            maxFps: maxFrameRate,
+            isFocused: isFocused,
+            hostDecodeUs: state.reportedDecodeUs,
+            hostSkippedFrames: state.unreportedSkippedFrames > 0 ? state.unreportedSkippedFrames : nil
+        )
+        do {
+            let data = try SpiceMessageSerializer.serialize(message)
+            if transport.sendControlMessage(data) {
+                state.unreportedSkippedFrames = 0
+            } else {
+                logger.debug("Throttle hint for window \(windowID) not sent - control channel unavailable")
+            }
+        } catch {
+            logger.error("Failed to serialize throttle hint: \(error)")
+        }
+    }
+
+    // MARK: - Thumbnails
+
+    /// Enables or disables the preview thumbnail for this stream.
+    ///
+    /// When enabled, the newest frame is box-filtered down to fit the configured
+    /// size at most once per `refreshInterval`, straight from shared memory and
+    /// without touching full-frame delivery.
+    /// - Parameter configuration: Thumbnail settings, or nil to disable and drop the current thumbnail
+    public func setThumbnailConfiguration(_ configuration: SpiceThumbnailConfiguration?) {
+        stateQueue.async {
+            self.thumbnailConfiguration = configuration
+            if configuration == nil {
+                self.thumbnail = nil
+                self.memoryAccount?.setUsage(0, for: .thumbnail)
+            }
+        }
+    }
+
+    /// The most recent thumbnail, if thumbnails are enabled and a frame has arrived.
+    public func latestThumbnail() -> SpiceThumbnail? {
+        stateQueue.sync { thumbnail }
+    }
+
+    /// Downscales the newest frame when the refresh interval has elapsed.
+    ///
+    /// Uncompressed key frames still pending are read in place. Anything else
+    /// comes from the reader's composed frame: damage, tiled key frames (which
+    /// it has decoded), and frames already read or discarded. Whole-frame LZ4
+    /// slots never reach the composed frame, so they keep the previous thumbnail.
+    /// Must be called on `stateQueue`.
+    private func refreshThumbnailIfNeeded(from reader: SharedFrameBufferReader) {
+        guard let config = thumbnailConfiguration else { return }
+        if let current = thumbnail, Date().timeIntervalSince(current.createdAt) < config.refreshInterval {
+            return
+        }
+
+        func makeThumbnail(header: FrameSlotHeader, bytes: UnsafeRawBufferPointer) -> SpiceThumbnail? {
+            SpiceThumbnail(frame: header, pixels: bytes, fitting: config)
+        }
+
+        do {
+            // The composed frame lags by whatever is still pending
+            let latestIsRawKeyFrame = try reader.withLatestFrame { header, _ in
+                FrameSlotFlags(rawValue: header.flags).isDisjoint(with: [.damage, .compressed])
+            } ?? false
+            let result = try latestIsRawKeyFrame
+                ? reader.withLatestFrame(makeThumbnail)
+                : reader.withComposedFrame(makeThumbnail)
+
+            guard let updated = result ?? nil else { return }
+            thumbnail = updated
+            memoryAccount?.setUsage(updated.data.count, for: .thumbnail)
+            notifyThumbnailUpdate(updated)
+        } catch {
+            logger.error("Failed to create thumbnail from shared memory: \(error)")
+        }
+    }
+
+    private func notifyThumbnailUpdate(_ thumbnail: SpiceThumbnail) {
+        guard let delegate else { return }
+        delegateQueue.async { [weak self] in
+            guard let self else { return }
+            delegate.windowStream(self, didUpdateThumbnail: thumbnail)
+        }
+    }
+
+    // MARK: - Memory Budget
+
+    /// Charges this stream's surfaces and thumbnails to `budget`.
+    /// Under pressure the budget may evict them; see `SpiceMemoryCategory.isEvictable(for:)`.
+    /// - Parameter budget: The budget to charge, or nil to stop accounting
+    public func setMemoryBudget(_ budget: SpiceMemoryBudget?) {
+        stateQueue.async {
+            guard budget !== self.memoryBudget else { return }
+            self.closeMemoryAccount()
+            self.memoryBudget = budget
+            if self.state.lifecycle == .connected {
+                self.openMemoryAccountIfNeeded()
+            }
+        }
+    }
+
+    /// Must be called on `stateQueue`.
+    private func openMemoryAccountIfNeeded() {
+        guard memoryAccount == nil, let budget = memoryBudget, let windowID = state.windowID else { return }
+        let account = budget.makeAccount(windowID: windowID, evictor: self)
+        account.setVisibility(state.visibility)
+        if let thumbnail {
+            account.setUsage(thumbnail.data.count, for: .thumbnail)
+        }
+        memoryAccount = account
+    }
+
+    /// Must be called on `stateQueue`.
+    private func closeMemoryAccount() {
+        memoryAccount?.close()
+        memoryAccount = nil
+    }
+
     // MARK: - Input Forwarding
 
     /// Send a mouse event to the Windows guest
@@ -323,6 +705,15 @@ public final class SpiceWindowStream {
             },
             onClipboard: { [weak self] clipboard in
                 self?.handleClipboard(clipboard)
+            },
+            onCursor: { [weak self] event in
+                self?.handleCursor(event)
+            },
+            onVideoFrame: { [weak self] frame in
+                self?.handleVideoFrame(frame)
+            },
+            onFrameReady: { [weak self] notification in
+                self?.handleFrameReady(notification)
             }
         )
 
@@ -334,10 +725,17 @@ public final class SpiceWindowStream {
             )
             state.subscription = subscription
             state.lifecycle = .connected
+            state.cursorHash = nil
+            openMemoryAccountIfNeeded()
             reconnectWorkItem = nil
             metrics.reconnectAttempts = 0
             logger.info("Spice stream connected for window \(windowID)")
             notifyStateChange(.connected)
+
+            // Re-apply throttling across reconnects; the guest and bridge start out visible
+            if state.visibility != .visible || state.maxFrameRate != 0 || state.isFocused || state.releasedGuestDemand {
+                applyVisibility(state.visibility, maxFrameRate: state.maxFrameRate)
+            }
         } catch let error as SpiceStreamError {
             switch error {
             case .sharedMemoryUnavailable(let description):
@@ -360,6 +758,8 @@ public final class SpiceWindowStream {
     private func handleFrame(_ frame: Data) {
         stateQueue.async {
             self.metrics.framesReceived += 1
+            self.recordDelivery()
+            self.memoryAccount?.setUsage(frame.count, for: .surface)
             guard let delegate = self.delegate else { return }
             self.delegateQueue.async { [weak self] in
                 guard let self else { return }
@@ -389,10 +789,51 @@ public final class SpiceWindowStream {
         }
     }
 
+    private func handleCursor(_ event: SpiceCursorEvent) {
+        stateQueue.async {
+            // The guest re-sends the current shape when the pointer re-enters
+            // a control; only report actual changes
+            switch event {
+            case let .set(image):
+                guard image.hash != self.state.cursorHash else { return }
+                self.state.cursorHash = image.hash
+            case .hide, .reset:
+                self.state.cursorHash = nil
+            case .move:
+                break
+            }
+            guard let delegate = self.delegate else { return }
+            self.delegateQueue.async { [weak self] in
+                guard let self else { return }
+                delegate.windowStream(self, didUpdateCursor: event)
+            }
+        }
+    }
+
+    private func handleVideoFrame(_ frame: SpiceVideoFrame) {
+        stateQueue.async {
+            self.metrics.videoFramesDecoded += 1
+            self.state.videoFramesDropped[frame.streamID] = frame.droppedFrames
+            self.metrics.videoFramesDropped = Int(self.state.videoFramesDropped.values.reduce(0, +))
+
+            // The bridge stops decoding for hidden windows; drop anything already in flight
+            guard self.state.visibility != .hidden else {
+                self.metrics.framesThrottled += 1
+                return
+            }
+            guard let delegate = self.delegate else { return }
+            self.delegateQueue.async { [weak self] in
+                guard let self else { return }
+                delegate.windowStream(self, didDecodeVideoFrame: frame)
+            }
+        }
+    }
+
     private func handleClose(reason: SpiceStreamCloseReason) {
         stateQueue.async {
             self.logger.warn("Spice stream closed: \(reason)")
             let wasUserInitiated = self.state.isUserInitiatedClose
+            let subscription = self.state.subscription
             self.state.subscription = nil
             self.metrics.lastErrorDescription = reason.message
 
@@ -400,6 +841,12 @@ public final class SpiceWindowStream {
             case .remoteClosed where !wasUserInitiated:
                 self.finishDisconnect()
             case .transportError where !wasUserInitiated:
+                // Keep the bridge stream (surfaces, caches, last frame) so the
+                // reconnect can re-attach it instead of starting over
+                if let subscription, subscription.canResume {
+                    self.discardSuspendedSubscription()
+                    self.state.suspendedSubscription = subscription
+                }
                 self.scheduleReconnect(reason: reason)
             case .authenticationFailed:
                 self.finishDisconnect()
@@ -432,7 +879,9 @@ public final class SpiceWindowStream {
             self.stateQueue.async {
                 guard !self.state.isUserInitiatedClose else { return }
                 self.logger.info("Attempting Spice reconnect #\(attempt) for window \(windowID)")
-                self.openStream(for: windowID)
+                if !self.resumeSuspendedStream(for: windowID) {
+                    self.openStream(for: windowID)
+                }
             }
         }
 
@@ -440,6 +889,49 @@ public final class SpiceWindowStream {
         DispatchQueue.global(qos: .userInitiated).asyncAfter(deadline: .now() + delay, execute: workItem)
     }
 
+    /// Re-attaches the stream that dropped, if there is one. Nothing visible is
+    /// reset: the delegate keeps its last frame and cursor, and only sees the
+    /// state go back to connected. Returns false if a full reopen is needed.
+    private func resumeSuspendedStream(for windowID: UInt64) -> Bool {
+        guard let subscription = state.suspendedSubscription else { return false }
+        state.suspendedSubscription = nil
+
+        do {
+            try subscription.resume()
+        } catch {
+            logger.warn("Spice resume failed for window \(windowID), reopening: \(error)")
+            transport.closeStream(subscription)
+            return false
+        }
+
+        state.subscription = subscription
+        state.lifecycle = .connected
+        reconnectWorkItem = nil
+        metrics.reconnectAttempts = 0
+        metrics.sessionResumes += 1
+        metrics.lastErrorDescription = nil
+        logger.info("Spice stream resumed for window \(windowID)")
+        notifyStateChange(.connected)
+
+        // The bridge keeps its own throttling; the guest may have lost it with the connection
+        if state.visibility != .visible || state.maxFrameRate != 0 || state.isFocused || state.releasedGuestDemand {
+            sendThrottleHint()
+        }
+
+        // Frames written while disconnected are stale; refresh from the newest one
+        if let reader = frameBufferReader {
+            metrics.framesThrottled += reader.discardFrames(keepingLatest: true)
+            state.lastFrameDeliveredAt = nil
+        }
+        return true
+    }
+
+    private func discardSuspendedSubscription() {
+        guard let subscription = state.suspendedSubscription else { return }
+        state.suspendedSubscription = nil
+        transport.closeStream(subscription)
+    }
+
     private func cancelReconnect() {
         reconnectWorkItem?.cancel()
         reconnectWorkItem = nil
@@ -449,6 +941,9 @@ public final class SpiceWindowStream {
         let hadError = metrics.lastErrorDescription != nil && !metrics.lastErrorDescription!.isEmpty
         state.lifecycle = .disconnected
         cancelReconnect()
+        cancelDeferredFrameRead()
+        discardSuspendedSubscription()
+        closeMemoryAccount()
 
         // Notify state change before the close callback
         if hadError {
@@ -475,3 +970,28 @@ public final class SpiceWindowStream {
         }
     }
 }
+
+// MARK: - SpiceMemoryEvictable
+
+extension SpiceWindowStream: SpiceMemoryEvictable {
+    public func evictMemory(in categories: Set<SpiceMemoryCategory>) {
+        // The budget may call in from stateQueue itself, so never block here
+        stateQueue.async {
+            if categories.contains(.thumbnail), self.thumbnail != nil {
+                self.thumbnail = nil
+                self.memoryAccount?.setUsage(0, for: .thumbnail)
+                self.logger.debug("Evicted thumbnail under memory pressure")
+            }
+
+            if categories.contains(.surface) {
+                self.memoryAccount?.setUsage(0, for: .surface)
+                self.logger.debug("Evicted backing surface under memory pressure")
+                guard let delegate = self.delegate else { return }
+                self.delegateQueue.async { [weak self] in
+                    guard let self else { return }
+                    delegate.windowStreamDidEvictSurface(self)
+                }
+            }
+        }
+    }
+}
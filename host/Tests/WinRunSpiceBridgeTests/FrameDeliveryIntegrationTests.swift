@@ -159,6 +159,75 @@ final class FrameDeliveryIntegrationTests: XCTestCase {
         XCTAssertEqual(delegate2.sharedFrames.first?.windowId, 200)
     }
 
+    /// Tests that FrameReady notifications interleaved across windows, with frame
+    /// numbers out of order between windows, still deliver each window's frames in order.
+    /// The guest writes windows in parallel and numbers frames from one counter.
+    func testInterleavedFrameReadyAcrossWindows() async {
+        let config = SharedFrameBufferConfig(slotCount: 3, maxWidth: 100, maxHeight: 100)
+        let regionSize = config.totalSize * 2
+        let regionPointer = UnsafeMutableRawPointer.allocate(
+            byteCount: regionSize,
+            alignment: MemoryLayout<UInt64>.alignment
+        )
+        regionPointer.initializeMemory(as: UInt8.self, repeating: 0, count: regionSize)
+        defer { regionPointer.deallocate() }
+
+        let router = SpiceFrameRouter(logger: NullLogger())
+        router.setSharedMemoryRegion(basePointer: regionPointer, size: regionSize)
+        try? await Task.sleep(for: .milliseconds(50))
+
+        let (stream1, delegate1) = createConnectedStream(windowID: 100)
+        let (stream2, delegate2) = createConnectedStream(windowID: 200)
+        router.registerStream(stream1, forWindowID: 100)
+        router.registerStream(stream2, forWindowID: 200)
+        waitForSetup()
+
+        // Window 100 got frames 2 and 3, window 200 frames 1 and 4
+        let frames: [(windowID: UInt64, offset: Int, numbers: [UInt32])] = [
+            (100, 0, [2, 3]),
+            (200, config.totalSize, [1, 4]),
+        ]
+        for window in frames {
+            initializePerWindowBuffer(
+                at: regionPointer,
+                offset: window.offset,
+                config: config,
+                windowID: window.windowID,
+                frameNumbers: window.numbers
+            )
+            router.handleBufferAllocation(WindowBufferAllocatedMessage(
+                windowId: window.windowID,
+                bufferPointer: UInt64(window.offset),
+                bufferSize: Int32(config.totalSize),
+                slotSize: Int32(config.slotSize),
+                slotCount: Int32(config.slotCount),
+                isCompressed: false,
+                isReallocation: false,
+                usesSharedMemory: true
+            ))
+        }
+        try? await Task.sleep(for: .milliseconds(100))
+
+        // Frame 1 is announced after window 100's newer frames
+        let order: [(windowID: UInt64, slot: UInt32, frame: UInt32)] = [
+            (100, 0, 2), (100, 1, 3), (200, 0, 1), (200, 1, 4),
+        ]
+        for notification in order {
+            router.routeFrameReady(FrameReadyMessage(
+                windowId: notification.windowID,
+                slotIndex: notification.slot,
+                frameNumber: notification.frame,
+                isKeyFrame: true
+            ))
+        }
+        waitForDelivery()
+
+        XCTAssertEqual(delegate1.sharedFrames.map(\.frameNumber), [2, 3])
+        XCTAssertEqual(delegate2.sharedFrames.map(\.frameNumber), [1, 4])
+        XCTAssertTrue(delegate1.sharedFrames.allSatisfy { $0.windowId == 100 })
+        XCTAssertTrue(delegate2.sharedFrames.allSatisfy { $0.windowId == 200 })
+    }
+
     /// Tests that frame delivery metrics are updated correctly.
     /// Uses per-window buffer allocation with shared memory region.
     func testFrameDeliveryUpdatesMetrics() async {
@@ -234,6 +303,127 @@ final class FrameDeliveryIntegrationTests: XCTestCase {
         XCTAssertEqual(delegate.sharedFrames.count, 3)
     }
 
+    /// Tests that a stream draining to the latest frame shows only the newest
+    /// queued frame, however many notifications arrive for the older ones.
+    func testDrainToLatestSkipsQueuedFrames() async throws {
+        let config = SharedFrameBufferConfig(slotCount: 4, maxWidth: 100, maxHeight: 100)
+        let regionPointer = UnsafeMutableRawPointer.allocate(
+            byteCount: config.totalSize,
+            alignment: MemoryLayout<UInt64>.alignment
+        )
+        regionPointer.initializeMemory(as: UInt8.self, repeating: 0, count: config.totalSize)
+        defer { regionPointer.deallocate() }
+
+        let router = SpiceFrameRouter(logger: NullLogger())
+        router.setSharedMemoryRegion(basePointer: regionPointer, size: config.totalSize)
+        try? await Task.sleep(for: .milliseconds(50))
+
+        let (stream, delegate) = createConnectedStream(
+            windowID: 100,
+            configuration: SpiceStreamConfiguration(drainsToLatestFrame: true)
+        )
+        router.registerStream(stream, forWindowID: 100)
+        waitForSetup()
+
+        initializePerWindowBuffer(at: regionPointer, offset: 0, config: config, windowID: 100, frameNumbers: [1, 2, 3])
+        router.handleBufferAllocation(WindowBufferAllocatedMessage(
+            windowId: 100,
+            bufferPointer: 0,
+            bufferSize: Int32(config.totalSize),
+            slotSize: Int32(config.slotSize),
+            slotCount: Int32(config.slotCount),
+            isCompressed: false,
+            isReallocation: false,
+            usesSharedMemory: true
+        ))
+        try? await Task.sleep(for: .milliseconds(100))
+
+        // The first notification drains the ring; the rest find nothing new
+        for i in 1...3 {
+            router.routeFrameReady(FrameReadyMessage(
+                windowId: 100,
+                slotIndex: UInt32(i - 1),
+                frameNumber: UInt32(i),
+                isKeyFrame: true
+            ))
+        }
+        waitForDelivery()
+
+        XCTAssertEqual(delegate.sharedFrames.map(\.frameNumber), [3])
+        let metrics = stream.metricsSnapshot()
+        XCTAssertEqual(metrics.framesReceived, 1)
+        XCTAssertEqual(metrics.framesSkipped, 2)
+
+        // The skips go back to the guest as backpressure
+        let hint = try XCTUnwrap(transport.controlMessagesSent.last { $0.first == SpiceMessageType.setWindowThrottle.rawValue })
+        let message = try JSONDecoder().decode(SetWindowThrottleSpiceMessage.self, from: hint.dropFirst(5))
+        XCTAssertEqual(message.hostSkippedFrames, 2)
+    }
+
+    /// Tests that a capped visible stream leaves a frame that arrives too soon
+    /// in the ring and reads it once the interval is up, without another notification.
+    func testCappedVisibleStreamReadsThrottledFrameLater() async {
+        await assertThrottledFrameIsReadLater(visibility: .visible, maxFrameRate: 5)
+    }
+
+    /// Tests the same for a background stream at its frame rate.
+    func testBackgroundStreamReadsThrottledFrameLater() async {
+        await assertThrottledFrameIsReadLater(visibility: .background, maxFrameRate: 5)
+    }
+
+    private func assertThrottledFrameIsReadLater(
+        visibility: SpiceStreamVisibility,
+        maxFrameRate: UInt32,
+        file: StaticString = #filePath,
+        line: UInt = #line
+    ) async {
+        let config = SharedFrameBufferConfig(slotCount: 4, maxWidth: 100, maxHeight: 100)
+        let regionPointer = UnsafeMutableRawPointer.allocate(
+            byteCount: config.totalSize,
+            alignment: MemoryLayout<UInt64>.alignment
+        )
+        regionPointer.initializeMemory(as: UInt8.self, repeating: 0, count: config.totalSize)
+        defer { regionPointer.deallocate() }
+
+        let router = SpiceFrameRouter(logger: NullLogger())
+        router.setSharedMemoryRegion(basePointer: regionPointer, size: config.totalSize)
+        try? await Task.sleep(for: .milliseconds(50))
+
+        let (stream, delegate) = createConnectedStream(windowID: 100)
+        stream.setVisibility(visibility, maxFrameRate: maxFrameRate)
+        router.registerStream(stream, forWindowID: 100)
+        waitForSetup()
+
+        initializePerWindowBuffer(at: regionPointer, offset: 0, config: config, windowID: 100, frameNumbers: [1, 2])
+        router.handleBufferAllocation(WindowBufferAllocatedMessage(
+            windowId: 100,
+            bufferPointer: 0,
+            bufferSize: Int32(config.totalSize),
+            slotSize: Int32(config.slotSize),
+            slotCount: Int32(config.slotCount),
+            isCompressed: false,
+            isReallocation: false,
+            usesSharedMemory: true
+        ))
+        try? await Task.sleep(for: .milliseconds(100))
+
+        // The first frame goes straight through, skipping to the newest
+        router.routeFrameReady(FrameReadyMessage(windowId: 100, slotIndex: 1, frameNumber: 2, isKeyFrame: true))
+        waitForDelivery(delay: 0.05)
+        XCTAssertEqual(delegate.sharedFrames.map(\.frameNumber), [2], file: file, line: line)
+
+        // The next arrives within 200 ms and waits, but no later notification is needed
+        writeKeyFrame(at: regionPointer, slot: 2, config: config, windowID: 100, frameNumber: 3)
+        regionPointer.bindMemory(to: SharedFrameBufferHeader.self, capacity: 1).pointee.writeIndex = 3
+        router.routeFrameReady(FrameReadyMessage(windowId: 100, slotIndex: 2, frameNumber: 3, isKeyFrame: true))
+        waitForDelivery(delay: 0.05)
+        XCTAssertEqual(delegate.sharedFrames.map(\.frameNumber), [2], file: file, line: line)
+
+        waitForDelivery(delay: 0.4)
+        XCTAssertEqual(delegate.sharedFrames.map(\.frameNumber), [2, 3], file: file, line: line)
+        XCTAssertGreaterThanOrEqual(stream.metricsSnapshot().framesThrottled, 1, file: file, line: line)
+    }
+
     // MARK: - Helper Methods
 
     /// Initializes a per-window buffer at a given offset in the shared memory region
@@ -243,18 +433,47 @@ final class FrameDeliveryIntegrationTests: XCTestCase {
         config: SharedFrameBufferConfig,
         windowID: UInt64,
         frameNumber: UInt32
+    ) {
+        initializePerWindowBuffer(
+            at: regionPointer,
+            offset: offset,
+            config: config,
+            windowID: windowID,
+            frameNumbers: [frameNumber]
+        )
+    }
+
+    /// Initializes a per-window buffer holding one key frame per entry of `frameNumbers`, in order
+    private func initializePerWindowBuffer(
+        at regionPointer: UnsafeMutableRawPointer,
+        offset: Int,
+        config: SharedFrameBufferConfig,
+        windowID: UInt64,
+        frameNumbers: [UInt32]
     ) {
         let bufferPtr = regionPointer.advanced(by: offset)
 
         // Initialize header
         let headerPtr = bufferPtr.bindMemory(to: SharedFrameBufferHeader.self, capacity: 1)
         var header = config.createHeader()
-        header.writeIndex = 1  // One frame written
+        header.writeIndex = UInt32(frameNumbers.count)
         header.readIndex = 0   // No frames read yet
         headerPtr.pointee = header
 
-        // Initialize frame slot
-        let slotOffset = SharedFrameBufferHeader.size
+        // Initialize frame slots
+        for (index, frameNumber) in frameNumbers.enumerated() {
+            writeKeyFrame(at: bufferPtr, slot: index, config: config, windowID: windowID, frameNumber: frameNumber)
+        }
+    }
+
+    private func writeKeyFrame(
+        at bufferPtr: UnsafeMutableRawPointer,
+        slot: Int,
+        config: SharedFrameBufferConfig,
+        windowID: UInt64,
+        frameNumber: UInt32
+    ) {
+        let slotOffset = SharedFrameBufferHeader.size + slot * config.slotSize
         let slotPtr = bufferPtr.advanced(by: slotOffset).bindMemory(to: FrameSlotHeader.self, capacity: 1)
         var slotHeader = FrameSlotHeader()
         slotHeader.windowId = windowID
@@ -269,11 +488,12 @@ final class FrameDeliveryIntegrationTests: XCTestCase {
     }
 
     private func createConnectedStream(
-        windowID: UInt64
+        windowID: UInt64,
+        configuration: SpiceStreamConfiguration = SpiceStreamConfiguration.environmentDefault()
     ) -> (SpiceWindowStream, TestSpiceWindowStreamDelegate) {
         let delegate = TestSpiceWindowStreamDelegate()
         let stream = SpiceWindowStream(
-            configuration: SpiceStreamConfiguration.environmentDefault(),
+            configuration: configuration,
             delegateQueue: testQueue,
             logger: NullLogger(),
             transport: transport,
@@ -130,7 +130,7 @@ final class ProtocolValidationTests: XCTestCase {
         let hostMessages: [SpiceMessageType] = [
             .launchProgram, .requestIcon, .clipboardData, .mouseInput,
             .keyboardInput, .dragDropEvent, .configureStreaming, .listSessions,
-            .closeSession, .listShortcuts, .shutdown,
+            .closeSession, .listShortcuts, .setWindowThrottle, .ping, .shutdown,
         ]
 
         for msg in hostMessages {
@@ -247,7 +247,7 @@ final class ProtocolValidationTests: XCTestCase {
     func testAllMessageTypesExist() {
         // Verify we have all expected message types
         let allCases = SpiceMessageType.allCases
-        XCTAssertEqual(allCases.count, 29, "Expected 29 message types (includes ConfigureStreaming, FrameReady, and WindowBufferAllocated)")
+        XCTAssertEqual(allCases.count, 31, "Expected 31 message types (includes ConfigureStreaming, SetWindowThrottle, Ping, FrameReady, and WindowBufferAllocated)")
 
         // Verify no duplicate raw values
         let rawValues = allCases.map { $0.rawValue }
@@ -119,6 +119,12 @@ final class FrameSlotFlagsTests: XCTestCase {
         XCTAssertTrue(flags.contains(.compressed))
         XCTAssertTrue(flags.contains(.keyFrame))
     }
+
+    func testTiledFlag() {
+        let flags: FrameSlotFlags = [.compressed, .tiled, .keyFrame]
+        XCTAssertEqual(FrameSlotFlags.tiled.rawValue, 8)
+        XCTAssertEqual(flags.rawValue, 11)
+    }
 }
 
 // MARK: - SharedFrameBufferConfig Tests
@@ -336,6 +342,265 @@ final class SharedFrameBufferReaderTests: XCTestCase {
         XCTAssertNil(frame3)
     }
 
+    func testDiscardFramesKeepingLatest() throws {
+        let config = SharedFrameBufferConfig(slotCount: 4, maxWidth: 100, maxHeight: 100)
+        let (pointer, _) = createValidBuffer(config: config, frameCount: 3)
+
+        writeTestFrame(to: pointer, config: config, slotIndex: 0, windowId: 100, frameNumber: 1)
+        writeTestFrame(to: pointer, config: config, slotIndex: 1, windowId: 100, frameNumber: 2)
+        writeTestFrame(to: pointer, config: config, slotIndex: 2, windowId: 100, frameNumber: 3)
+
+        let reader = SharedFrameBufferReader(
+            pointer: pointer,
+            size: config.totalSize,
+            ownsMemory: true,
+            logger: NullLogger()
+        )
+
+        XCTAssertEqual(reader.discardFrames(keepingLatest: true), 2)
+        XCTAssertEqual(reader.availableFrameCount, 1)
+
+        let frame = try reader.readNextFrame()
+        XCTAssertEqual(frame?.frameNumber, 3)
+
+        XCTAssertEqual(reader.discardFrames(), 0)
+    }
+
+    func testDiscardFramesWrapsAndLeavesBadIndicesAlone() {
+        let config = SharedFrameBufferConfig(slotCount: 4, maxWidth: 100, maxHeight: 100)
+        let (pointer, _) = createValidBuffer(config: config)
+        writeTestFrame(to: pointer, config: config, slotIndex: 3, windowId: 100, frameNumber: 1)
+        writeTestFrame(to: pointer, config: config, slotIndex: 0, windowId: 100, frameNumber: 2)
+        let headerPtr = pointer.assumingMemoryBound(to: SharedFrameBufferHeader.self)
+        headerPtr.pointee.readIndex = 3
+        headerPtr.pointee.writeIndex = 1
+
+        let reader = SharedFrameBufferReader(
+            pointer: pointer,
+            size: config.totalSize,
+            ownsMemory: true,
+            logger: NullLogger()
+        )
+
+        XCTAssertEqual(reader.discardFrames(), 2)
+        XCTAssertEqual(reader.readHeader().readIndex, 1)
+
+        // A read index past the ring isn't trusted, so nothing is discarded
+        headerPtr.pointee.readIndex = 9
+        XCTAssertEqual(reader.discardFrames(), 0)
+        XCTAssertEqual(reader.readHeader().readIndex, 9)
+    }
+
+    func testWithLatestFrameDoesNotConsume() throws {
+        let config = SharedFrameBufferConfig(slotCount: 4, maxWidth: 100, maxHeight: 100)
+        let (pointer, _) = createValidBuffer(config: config, frameCount: 2)
+
+        writeTestFrame(to: pointer, config: config, slotIndex: 0, windowId: 100, frameNumber: 1)
+        writeTestFrame(to: pointer, config: config, slotIndex: 1, windowId: 100, frameNumber: 2)
+
+        let reader = SharedFrameBufferReader(
+            pointer: pointer,
+            size: config.totalSize,
+            ownsMemory: true,
+            logger: NullLogger()
+        )
+
+        let frameNumber = try reader.withLatestFrame { header, _ in header.frameNumber }
+        XCTAssertEqual(frameNumber, 2)
+        XCTAssertEqual(reader.availableFrameCount, 2)
+
+        XCTAssertEqual(reader.discardFrames(), 2)
+        XCTAssertNil(try reader.withLatestFrame { header, _ in header.frameNumber })
+    }
+
+    func testDamageSlotIsComposedOntoKeyFrame() throws {
+        let config = SharedFrameBufferConfig(slotCount: 4, maxWidth: 100, maxHeight: 100)
+        let (pointer, _) = createValidBuffer(config: config, frameCount: 2)
+
+        writeTestFrame(to: pointer, config: config, slotIndex: 0, windowId: 100, frameNumber: 1)
+        writeDamageFrame(to: pointer, config: config, slotIndex: 1, frameNumber: 2, payload: scrollAndDrawPayload())
+
+        let reader = SharedFrameBufferReader(
+            pointer: pointer,
+            size: config.totalSize,
+            ownsMemory: true,
+            logger: NullLogger()
+        )
+
+        let keyFrame = try XCTUnwrap(reader.readNextFrame())
+        XCTAssertNil(keyFrame.damage)
+
+        let frame = try XCTUnwrap(reader.readNextFrame())
+        XCTAssertEqual(frame.frameNumber, 2)
+        XCTAssertEqual(frame.width, 100)
+        XCTAssertEqual(frame.data.count, keyFrame.data.count)
+        XCTAssertEqual(frame.damage?.moveRects.count, 1)
+        XCTAssertEqual(frame.damage?.changedRects.count, 2)
+        XCTAssertEqual(Array(frame.data), expectedScrollAndDraw(from: Array(keyFrame.data), stride: 400))
+        // The earlier frame handed out is not modified
+        XCTAssertEqual(keyFrame.data[0], 0)
+    }
+
+    func testDiscardFramesFoldsSkippedDamage() throws {
+        let config = SharedFrameBufferConfig(slotCount: 4, maxWidth: 100, maxHeight: 100)
+        let (pointer, _) = createValidBuffer(config: config, frameCount: 3)
+
+        writeTestFrame(to: pointer, config: config, slotIndex: 0, windowId: 100, frameNumber: 1)
+        writeDamageFrame(to: pointer, config: config, slotIndex: 1, frameNumber: 2, payload: scrollAndDrawPayload())
+        writeDamageFrame(to: pointer, config: config, slotIndex: 2, frameNumber: 3, payload: damagePayload(dirty: [(0, 99, 1, 1, 0x11)]))
+
+        let reader = SharedFrameBufferReader(
+            pointer: pointer,
+            size: config.totalSize,
+            ownsMemory: true,
+            logger: NullLogger()
+        )
+
+        XCTAssertEqual(reader.discardFrames(keepingLatest: true), 2)
+        let frame = try XCTUnwrap(reader.readNextFrame())
+
+        let keyFrame = (0..<(400 * 100)).map { UInt8($0 % 256) }
+        var expected = expectedScrollAndDraw(from: keyFrame, stride: 400)
+        for i in 0..<4 {
+            expected[99 * 400 + i] = 0x11
+        }
+        XCTAssertEqual(frame.frameNumber, 3)
+        XCTAssertEqual(Array(frame.data), expected)
+        // Its own damage doesn't cover the skipped frames
+        XCTAssertNil(frame.damage)
+    }
+
+    func testReadLatestFrameSkipsToNewest() throws {
+        let config = SharedFrameBufferConfig(slotCount: 4, maxWidth: 100, maxHeight: 100)
+        let (pointer, _) = createValidBuffer(config: config, frameCount: 3)
+
+        writeTestFrame(to: pointer, config: config, slotIndex: 0, windowId: 100, frameNumber: 1)
+        writeTestFrame(to: pointer, config: config, slotIndex: 1, windowId: 100, frameNumber: 2)
+        writeTestFrame(to: pointer, config: config, slotIndex: 2, windowId: 100, frameNumber: 3)
+
+        let reader = SharedFrameBufferReader(
+            pointer: pointer,
+            size: config.totalSize,
+            ownsMemory: true,
+            logger: NullLogger()
+        )
+
+        let drained = try XCTUnwrap(reader.readLatestFrame())
+        XCTAssertEqual(drained.frame.frameNumber, 3)
+        XCTAssertEqual(drained.skipped, 2)
+        XCTAssertNil(drained.frame.damage)
+        XCTAssertEqual(reader.availableFrameCount, 0)
+        XCTAssertEqual(reader.readHeader().readIndex, 3)
+
+        XCTAssertNil(try reader.readLatestFrame())
+    }
+
+    func testReadLatestFrameMergesSkippedDamage() throws {
+        let config = SharedFrameBufferConfig(slotCount: 4, maxWidth: 100, maxHeight: 100)
+        let (pointer, _) = createValidBuffer(config: config, frameCount: 3)
+
+        writeTestFrame(to: pointer, config: config, slotIndex: 0, windowId: 100, frameNumber: 1)
+        writeDamageFrame(to: pointer, config: config, slotIndex: 1, frameNumber: 2, payload: scrollAndDrawPayload())
+        writeDamageFrame(to: pointer, config: config, slotIndex: 2, frameNumber: 3, payload: damagePayload(dirty: [(0, 99, 1, 1, 0x11)]))
+
+        let reader = SharedFrameBufferReader(
+            pointer: pointer,
+            size: config.totalSize,
+            ownsMemory: true,
+            logger: NullLogger()
+        )
+
+        // The key frame was read on its own; frame 2 is skipped
+        XCTAssertEqual(try reader.readNextFrame()?.frameNumber, 1)
+
+        let drained = try XCTUnwrap(reader.readLatestFrame())
+        XCTAssertEqual(drained.frame.frameNumber, 3)
+        XCTAssertEqual(drained.skipped, 1)
+
+        let previous = (0..<(400 * 100)).map { UInt8($0 % 256) }
+        var expected = expectedScrollAndDraw(from: previous, stride: 400)
+        for i in 0..<4 {
+            expected[99 * 400 + i] = 0x11
+        }
+        XCTAssertEqual(Array(drained.frame.data), expected)
+        // The skipped frame's changes are merged into the damage
+        XCTAssertEqual(drained.frame.damage?.moveRects, [])
+        XCTAssertEqual(drained.frame.damage?.dirtyRects, [
+            SharedFrameRect(x: 0, y: 0, width: 100, height: 20),
+            SharedFrameRect(x: 5, y: 5, width: 2, height: 1),
+            SharedFrameRect(x: 0, y: 99, width: 1, height: 1)
+        ])
+    }
+
+    func testDamageWithoutKeyFrameThrows() throws {
+        let config = SharedFrameBufferConfig(slotCount: 4, maxWidth: 100, maxHeight: 100)
+        let (pointer, _) = createValidBuffer(config: config, frameCount: 1)
+
+        writeDamageFrame(to: pointer, config: config, slotIndex: 0, frameNumber: 1, payload: scrollAndDrawPayload())
+
+        let reader = SharedFrameBufferReader(
+            pointer: pointer,
+            size: config.totalSize,
+            ownsMemory: true,
+            logger: NullLogger()
+        )
+
+        XCTAssertThrowsError(try reader.readNextFrame())
+        // The bad slot is still consumed
+        XCTAssertEqual(reader.availableFrameCount, 0)
+    }
+
+    #if os(macOS)
+        func testTiledKeyFrameIsDecodedAndComposedOnto() throws {
+            let config = SharedFrameBufferConfig(slotCount: 4, maxWidth: 100, maxHeight: 100)
+            let (pointer, _) = createValidBuffer(config: config, frameCount: 2)
+
+            // 100x100 is four 64-pixel tiles (clipped at the edges), each one run of a color
+            let runs: [(count: Int, color: UInt32)] = [
+                (64 * 64, 0xFF11_2233), (36 * 64, 0xFF44_5566), (64 * 36, 0xFF77_8899), (36 * 36, 0xFFAA_BBCC)
+            ]
+            writeTiledFrame(to: pointer, config: config, slotIndex: 0, frameNumber: 1, runs: runs)
+            let damage = damagePayload(dirty: [(0, 0, 1, 1, 0x11)])
+            writeDamageFrame(to: pointer, config: config, slotIndex: 1, frameNumber: 2, payload: damage)
+
+            let reader = SharedFrameBufferReader(
+                pointer: pointer,
+                size: config.totalSize,
+                ownsMemory: true,
+                logger: NullLogger()
+            )
+
+            func pixel(_ data: Data, _ x: Int, _ y: Int) -> UInt32 {
+                data.withUnsafeBytes { $0.loadUnaligned(fromByteOffset: y * 400 + x * 4, as: UInt32.self) }
+            }
+
+            let keyFrame = try XCTUnwrap(reader.readNextFrame())
+            XCTAssertFalse(keyFrame.isCompressed)
+            XCTAssertEqual(keyFrame.data.count, 400 * 100)
+            XCTAssertEqual(pixel(keyFrame.data, 0, 0), 0xFF11_2233)
+            XCTAssertEqual(pixel(keyFrame.data, 99, 0), 0xFF44_5566)
+            XCTAssertEqual(pixel(keyFrame.data, 0, 99), 0xFF77_8899)
+            XCTAssertEqual(pixel(keyFrame.data, 99, 99), 0xFFAA_BBCC)
+
+            // Damage applies to the decoded frame
+            let frame = try XCTUnwrap(reader.readNextFrame())
+            XCTAssertEqual(pixel(frame.data, 0, 0), 0x1111_1111)
+            XCTAssertEqual(pixel(frame.data, 1, 0), 0xFF11_2233)
+        }
+    #endif
+
+    func testApplyRejectsDamageOutsideFrame() {
+        var surface = [UInt8](repeating: 0, count: 16 * 16 * 4)
+        let payload = damagePayload(dirty: [(10, 10, 8, 8, 0xFF)])
+
+        XCTAssertThrowsError(try payload.withUnsafeBytes { bytes in
+            try surface.withUnsafeMutableBytes { surfaceBytes in
+                try SharedFrameDamage.apply(payload: bytes, to: surfaceBytes, width: 16, height: 16, stride: 64)
+            }
+        })
+        XCTAssertTrue(surface.allSatisfy { $0 == 0 })
+    }
+
     func testSetHostActive() {
         let config = SharedFrameBufferConfig(slotCount: 2, maxWidth: 100, maxHeight: 100)
         let (pointer, _) = createValidBuffer(config: config)
@@ -410,6 +675,125 @@ final class SharedFrameBufferReaderTests: XCTestCase {
             dataPtr[i] = UInt8(i % 256)
         }
     }
+
+    private func writeDamageFrame(
+        to pointer: UnsafeMutableRawPointer,
+        config: SharedFrameBufferConfig,
+        slotIndex: Int,
+        frameNumber: UInt32,
+        payload: [UInt8]
+    ) {
+        let slotOffset = SharedFrameBufferHeader.size + slotIndex * config.slotSize
+
+        var slotHeader = FrameSlotHeader()
+        slotHeader.windowId = 100
+        slotHeader.frameNumber = frameNumber
+        slotHeader.width = UInt32(config.maxWidth)
+        slotHeader.height = UInt32(config.maxHeight)
+        slotHeader.stride = UInt32(config.maxWidth * config.bytesPerPixel)
+        slotHeader.format = UInt32(SpicePixelFormat.bgra32.rawValue)
+        slotHeader.dataSize = UInt32(payload.count)
+        slotHeader.flags = FrameSlotFlags.damage.rawValue
+
+        let slotPtr = pointer.advanced(by: slotOffset).bindMemory(to: FrameSlotHeader.self, capacity: 1)
+        slotPtr.pointee = slotHeader
+
+        let dataPtr = pointer.advanced(by: slotOffset + FrameSlotHeader.size)
+        payload.withUnsafeBytes { dataPtr.copyMemory(from: $0.baseAddress!, byteCount: $0.count) }
+    }
+
+    /// Writes a tiled key frame whose tiles are each a single RLE run.
+    private func writeTiledFrame(
+        to pointer: UnsafeMutableRawPointer,
+        config: SharedFrameBufferConfig,
+        slotIndex: Int,
+        frameNumber: UInt32,
+        runs: [(count: Int, color: UInt32)]
+    ) {
+        var payload: [UInt8] = []
+        func append<T: FixedWidthInteger>(_ value: T) {
+            withUnsafeBytes(of: value.littleEndian) { payload.append(contentsOf: $0) }
+        }
+
+        append(UInt16(64))
+        append(UInt16(0))
+        append(UInt32(runs.count))
+        for _ in runs {
+            append(UInt32(2))  // RLE, 3 reserved bytes
+            append(UInt32(6))
+        }
+        for run in runs {
+            append(UInt16(run.count))
+            append(run.color)
+        }
+
+        let slotOffset = SharedFrameBufferHeader.size + slotIndex * config.slotSize
+        var slotHeader = FrameSlotHeader()
+        slotHeader.windowId = 100
+        slotHeader.frameNumber = frameNumber
+        slotHeader.width = UInt32(config.maxWidth)
+        slotHeader.height = UInt32(config.maxHeight)
+        slotHeader.stride = UInt32(config.maxWidth * config.bytesPerPixel)
+        slotHeader.format = UInt32(SpicePixelFormat.bgra32.rawValue)
+        slotHeader.dataSize = UInt32(payload.count)
+        slotHeader.flags = FrameSlotFlags([.compressed, .tiled, .keyFrame]).rawValue
+
+        let slotPtr = pointer.advanced(by: slotOffset).bindMemory(to: FrameSlotHeader.self, capacity: 1)
+        slotPtr.pointee = slotHeader
+
+        let dataPtr = pointer.advanced(by: slotOffset + FrameSlotHeader.size)
+        payload.withUnsafeBytes { dataPtr.copyMemory(from: $0.baseAddress!, byteCount: $0.count) }
+    }
+
+    /// Builds a damage payload; dirty rects are filled with a single byte value.
+    private func damagePayload(
+        moves: [(sourceX: Int32, sourceY: Int32, x: Int32, y: Int32, width: Int32, height: Int32)] = [],
+        dirty: [(x: Int32, y: Int32, width: Int32, height: Int32, fill: UInt8)] = []
+    ) -> [UInt8] {
+        var payload: [UInt8] = []
+        func append(_ value: UInt32) {
+            withUnsafeBytes(of: value.littleEndian) { payload.append(contentsOf: $0) }
+        }
+
+        append(UInt32(moves.count))
+        append(UInt32(dirty.count))
+        for move in moves {
+            for value in [move.sourceX, move.sourceY, move.x, move.y, move.width, move.height] {
+                append(UInt32(bitPattern: value))
+            }
+        }
+        for rect in dirty {
+            for value in [rect.x, rect.y, rect.width, rect.height] {
+                append(UInt32(bitPattern: value))
+            }
+        }
+        for rect in dirty {
+            payload.append(contentsOf: repeatElement(rect.fill, count: Int(rect.width * rect.height) * 4))
+        }
+        return payload
+    }
+
+    /// Scrolls rows 10..<30 up to the top, then draws a 2x1 rect at (5, 5).
+    private func scrollAndDrawPayload() -> [UInt8] {
+        damagePayload(
+            moves: [(sourceX: 0, sourceY: 10, x: 0, y: 0, width: 100, height: 20)],
+            dirty: [(x: 5, y: 5, width: 2, height: 1, fill: 0xAB)]
+        )
+    }
+
+    private func expectedScrollAndDraw(from previous: [UInt8], stride: Int) -> [UInt8] {
+        var expected = previous
+        for row in 0..<20 {
+            expected.replaceSubrange(
+                (row * stride)..<((row + 1) * stride),
+                with: previous[((row + 10) * stride)..<((row + 11) * stride)]
+            )
+        }
+        for i in 0..<8 {
+            expected[5 * stride + 5 * 4 + i] = 0xAB
+        }
+        return expected
+    }
 }
 
 // MARK: - FrameReadyMessage Tests
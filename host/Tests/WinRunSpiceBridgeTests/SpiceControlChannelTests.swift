@@ -111,6 +111,91 @@ final class SpiceControlChannelTests: XCTestCase {
         }
     }
 
+    func testPipelinedRequestsCompleteOutOfOrder() async throws {
+        let channel = SpiceControlChannel()
+        await channel.simulateConnected()
+
+        let requestCount = 200
+        let closeTasks = (0..<requestCount).map { index in
+            Task {
+                try await channel.closeSession("\(index)", timeout: .seconds(2))
+            }
+        }
+
+        try await Task.sleep(for: .milliseconds(100))
+
+        // Acknowledge every message ID, newest first
+        let encoder = JSONEncoder()
+        for messageId in (1...UInt32(requestCount)).reversed() {
+            let payload = try encoder.encode(AckMessage(messageId: messageId, success: true, errorMessage: nil))
+            var envelope = Data()
+            envelope.append(SpiceMessageType.ack.rawValue)
+            var length = UInt32(payload.count).littleEndian
+            withUnsafeBytes(of: &length) { envelope.append(contentsOf: $0) }
+            envelope.append(payload)
+            try await channel.simulateResponse(envelope)
+        }
+
+        for closeTask in closeTasks {
+            try await closeTask.value
+        }
+    }
+
+    func testDisconnectFailsPendingRequests() async throws {
+        let channel = SpiceControlChannel()
+        await channel.simulateConnected()
+
+        let closeTask = Task {
+            try await channel.closeSession("12345", timeout: .seconds(5))
+        }
+
+        try await Task.sleep(for: .milliseconds(50))
+        await channel.disconnect()
+
+        do {
+            try await closeTask.value
+            XCTFail("Expected SpiceControlError.notConnected")
+        } catch let error as SpiceControlError {
+            if case .notConnected = error {
+                // Expected
+            } else {
+                XCTFail("Expected notConnected, got \(error)")
+            }
+        }
+    }
+
+    // MARK: - Heartbeat Tests
+
+    func testHeartbeatReportsGuestHealthToDelegate() async throws {
+        let transport = TestSpiceStreamTransport()
+        let channel = SpiceControlChannel(transport: transport)
+        let delegate = MockControlChannelDelegate()
+        await channel.setDelegateForTest(delegate)
+
+        let startedWhileDisconnected = await channel.startHeartbeat()
+        XCTAssertFalse(startedWhileDisconnected)
+
+        try await channel.connect()
+        let started = await channel.startHeartbeat(interval: .milliseconds(500), stallAfter: .seconds(2))
+        XCTAssertTrue(started)
+        XCTAssertEqual(transport.heartbeatStarts.count, 1)
+        XCTAssertEqual(transport.heartbeatStarts.first?.stallAfter, .seconds(2))
+
+        var statistics = SpiceHeartbeatStats()
+        statistics.health = .stalled
+        statistics.silence = .seconds(2)
+        transport.simulateGuestHealth(.stalled, statistics: statistics)
+        transport.simulateGuestHealth(.healthy)
+        try await Task.sleep(for: .milliseconds(50))
+
+        XCTAssertEqual(delegate.healthChanges.map(\.health), [.stalled, .healthy])
+        XCTAssertEqual(delegate.healthChanges.first?.statistics.silence, .seconds(2))
+
+        await channel.stopHeartbeat()
+        let statisticsAfterStop = await channel.heartbeatStatistics()
+        XCTAssertNil(statisticsAfterStop)
+    }
+
     // MARK: - Connection State Tests
 
     func testConnectedPropertyInitiallyFalse() async {
@@ -355,6 +440,7 @@ final class MockControlChannelDelegate: SpiceControlChannelDelegate {
     var receivedMessages: [(message: Any, type: SpiceMessageType)] = []
     var frameReadyNotifications: [FrameReadyMessage] = []
     var bufferAllocations: [WindowBufferAllocatedMessage] = []
+    var healthChanges: [(health: SpiceGuestHealth, statistics: SpiceHeartbeatStats)] = []
 
     func controlChannelDidConnect(_ channel: SpiceControlChannel) {
         didConnect = true
@@ -378,6 +464,14 @@ final class MockControlChannelDelegate: SpiceControlChannelDelegate {
     ) {
         bufferAllocations.append(notification)
     }
+
+    func controlChannel(
+        _ channel: SpiceControlChannel,
+        didChangeGuestHealth health: SpiceGuestHealth,
+        statistics: SpiceHeartbeatStats
+    ) {
+        healthChanges.append((health: health, statistics: statistics))
+    }
 }
 
 // MARK: - SpiceControlChannel Test Extension
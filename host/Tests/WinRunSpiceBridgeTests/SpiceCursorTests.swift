@@ -0,0 +1,49 @@
+import XCTest
+
+@testable import WinRunSpiceBridge
+
+final class SpiceCursorShapeCacheTests: XCTestCase {
+    private func image(_ hash: UInt64) -> SpiceCursorImage {
+        SpiceCursorImage(hash: hash, width: 2, height: 2, hotspotX: 0, hotspotY: 0, data: Data(count: 16))
+    }
+
+    func testBuildsOncePerShape() {
+        let cache = SpiceCursorShapeCache<String>()
+        var builds = 0
+        let build: (SpiceCursorImage) -> String? = { image in
+            builds += 1
+            return "cursor-\(image.hash)"
+        }
+
+        XCTAssertEqual(cache.value(for: image(1), build: build), "cursor-1")
+        XCTAssertEqual(cache.value(for: image(1), build: build), "cursor-1")
+        XCTAssertEqual(builds, 1)
+        XCTAssertEqual(cache.count, 1)
+    }
+
+    func testEvictsLeastRecentlyUsed() {
+        let cache = SpiceCursorShapeCache<UInt64>(capacity: 2)
+        let build: (SpiceCursorImage) -> UInt64? = { $0.hash }
+
+        _ = cache.value(for: image(1), build: build)
+        _ = cache.value(for: image(2), build: build)
+        _ = cache.value(for: image(1), build: build)
+        _ = cache.value(for: image(3), build: build)
+
+        var rebuilt: [UInt64] = []
+        let tracking: (SpiceCursorImage) -> UInt64? = { image in
+            rebuilt.append(image.hash)
+            return image.hash
+        }
+        _ = cache.value(for: image(1), build: tracking)
+        _ = cache.value(for: image(2), build: tracking)
+        XCTAssertEqual(rebuilt, [2])
+        XCTAssertEqual(cache.count, 2)
+    }
+
+    func testFailedBuildIsNotCached() {
+        let cache = SpiceCursorShapeCache<Int>()
+        XCTAssertNil(cache.value(for: image(1)) { _ in nil })
+        XCTAssertEqual(cache.count, 0)
+    }
+}
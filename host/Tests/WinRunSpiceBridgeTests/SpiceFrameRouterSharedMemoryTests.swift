@@ -289,6 +289,65 @@ final class SpiceFrameRouterSharedMemoryTests: XCTestCase {
         XCTAssertNotNil(router.bufferReader(forWindowID: 100))
     }
 
+    func testReallocationRemapsExistingReader() async {
+        let regionSize = 10 * 1024 * 1024
+        let pointer = UnsafeMutableRawPointer.allocate(
+            byteCount: regionSize,
+            alignment: MemoryLayout<UInt64>.alignment
+        )
+        pointer.initializeMemory(as: UInt8.self, repeating: 0, count: regionSize)
+        defer { pointer.deallocate() }
+
+        router.setSharedMemoryRegion(basePointer: pointer, size: regionSize)
+        try? await Task.sleep(for: .milliseconds(50))
+
+        let (stream, _) = makeStream(windowID: 100)
+        router.registerStream(stream, forWindowID: 100)
+
+        initializeBufferHeader(at: pointer, totalSize: 1024 * 1024, slotCount: 3, slotSize: 300_000)
+        router.handleBufferAllocation(WindowBufferAllocatedMessage(
+            windowId: 100,
+            bufferPointer: 0,
+            bufferSize: 1024 * 1024,
+            slotSize: 300_000,
+            slotCount: 3,
+            isCompressed: false,
+            isReallocation: false,
+            usesSharedMemory: true
+        ))
+        try? await Task.sleep(for: .milliseconds(100))
+        let reader = router.bufferReader(forWindowID: 100)
+        XCTAssertNotNil(reader)
+
+        // The window grew; its new buffer is elsewhere in the region
+        let newOffset = 4 * 1024 * 1024
+        initializeBufferHeader(
+            at: pointer.advanced(by: newOffset),
+            totalSize: 2 * 1024 * 1024,
+            slotCount: 3,
+            slotSize: 600_000
+        )
+        router.handleBufferAllocation(WindowBufferAllocatedMessage(
+            windowId: 100,
+            bufferPointer: UInt64(newOffset),
+            bufferSize: 2 * 1024 * 1024,
+            slotSize: 600_000,
+            slotCount: 3,
+            isCompressed: false,
+            isReallocation: true,
+            usesSharedMemory: true
+        ))
+        try? await Task.sleep(for: .milliseconds(100))
+
+        // Same reader, now reading the new buffer
+        XCTAssertEqual(router.activeReaderCount, 1)
+        XCTAssertTrue(router.bufferReader(forWindowID: 100) === reader)
+        XCTAssertEqual(reader?.readHeader().slotSize, 600_000)
+        XCTAssertTrue(
+            reader?.isMapped(to: pointer.advanced(by: newOffset), size: 2 * 1024 * 1024) ?? false
+        )
+    }
+
     // MARK: - Validation Tests
 
     func testInvalidBufferOffsetIsRejected() async {
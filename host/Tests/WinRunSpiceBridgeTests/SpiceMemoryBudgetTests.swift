@@ -0,0 +1,111 @@
+import XCTest
+
+@testable import WinRunShared
+@testable import WinRunSpiceBridge
+
+final class SpiceMemoryBudgetTests: XCTestCase {
+    private final class RecordingEvictor: SpiceMemoryEvictable {
+        var requests: [Set<SpiceMemoryCategory>] = []
+
+        func evictMemory(in categories: Set<SpiceMemoryCategory>) {
+            requests.append(categories)
+        }
+    }
+
+    private func makeBudget(global: Int = 1000, perStream: Int = 600) -> SpiceMemoryBudget {
+        SpiceMemoryBudget(
+            limits: SpiceMemoryLimits(globalBytes: global, perStreamBytes: perStream),
+            logger: NullLogger()
+        )
+    }
+
+    func testUsageIsAccountedPerCategory() {
+        let budget = makeBudget()
+        let account = budget.makeAccount(windowID: 1, evictor: nil)
+
+        account.setUsage(300, for: .surface)
+        account.setUsage(50, for: .thumbnail)
+        account.setUsage(200, for: .surface)
+
+        XCTAssertEqual(budget.usedBytes, 250)
+        XCTAssertEqual(budget.usedBytes(in: .surface), 200)
+        XCTAssertEqual(budget.usedBytes(in: .thumbnail), 50)
+    }
+
+    func testCloseReleasesCharges() {
+        let budget = makeBudget()
+        let account = budget.makeAccount(windowID: 1, evictor: nil)
+        account.setUsage(300, for: .surface)
+
+        account.close()
+        account.setUsage(500, for: .surface)
+
+        XCTAssertEqual(budget.usedBytes, 0)
+        XCTAssertEqual(budget.accountCount, 0)
+    }
+
+    func testPerStreamLimitEvictsOnlyWhatVisibilityAllows() {
+        let budget = makeBudget()
+        let evictor = RecordingEvictor()
+        let account = budget.makeAccount(windowID: 1, evictor: evictor)
+        var events: [SpiceMemoryLimitEvent] = []
+        budget.setLimitHandler { events.append($0) }
+
+        account.setUsage(100, for: .cache)
+        account.setUsage(550, for: .surface)
+
+        // Visible streams keep their surface; only the cache can go
+        XCTAssertEqual(evictor.requests, [[.cache]])
+        XCTAssertEqual(events, [SpiceMemoryLimitEvent(
+            scope: .stream(windowID: 1),
+            usedBytes: 650,
+            limitBytes: 600,
+            evictableBytes: 100
+        )])
+    }
+
+    func testLimitEventFiresOncePerCrossing() {
+        let budget = makeBudget()
+        let account = budget.makeAccount(windowID: 1, evictor: nil)
+        var eventCount = 0
+        budget.setLimitHandler { _ in eventCount += 1 }
+
+        account.setUsage(700, for: .surface)
+        account.setUsage(800, for: .surface)
+        XCTAssertEqual(eventCount, 1)
+
+        account.setUsage(100, for: .surface)
+        account.setUsage(700, for: .surface)
+        XCTAssertEqual(eventCount, 2)
+    }
+
+    func testGlobalLimitEvictsHiddenStreamsFirst() {
+        let budget = makeBudget(global: 1000, perStream: 1000)
+        let visibleEvictor = RecordingEvictor()
+        let hiddenEvictor = RecordingEvictor()
+        let visible = budget.makeAccount(windowID: 1, evictor: visibleEvictor)
+        let hidden = budget.makeAccount(windowID: 2, evictor: hiddenEvictor)
+        hidden.setVisibility(.hidden)
+
+        hidden.setUsage(400, for: .surface)
+        hidden.setUsage(50, for: .thumbnail)
+        visible.setUsage(100, for: .cache)
+        visible.setUsage(500, for: .surface)
+
+        // The hidden stream's 450 bytes cover the 50-byte overage on their own
+        XCTAssertEqual(hiddenEvictor.requests, [[.surface, .thumbnail]])
+        XCTAssertTrue(visibleEvictor.requests.isEmpty)
+    }
+
+    func testBecomingHiddenWhileOverLimitEvicts() {
+        let budget = makeBudget()
+        let evictor = RecordingEvictor()
+        let account = budget.makeAccount(windowID: 1, evictor: evictor)
+
+        account.setUsage(700, for: .surface)
+        XCTAssertTrue(evictor.requests.isEmpty)
+
+        account.setVisibility(.hidden)
+        XCTAssertEqual(evictor.requests, [[.surface]])
+    }
+}
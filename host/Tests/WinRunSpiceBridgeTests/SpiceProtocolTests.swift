@@ -254,6 +254,59 @@ final class SpiceMessageSerializerTests: XCTestCase {
         XCTAssertEqual(data[0], SpiceMessageType.closeSession.rawValue)
     }
 
+    func testSerializeSetWindowThrottleMessage() throws {
+        let message = SetWindowThrottleSpiceMessage(windowId: 12345, visibility: .background, maxFps: 5)
+
+        let data = try SpiceMessageSerializer.serialize(message)
+
+        XCTAssertEqual(data[0], SpiceMessageType.setWindowThrottle.rawValue)
+        let json = try JSONSerialization.jsonObject(with: data.dropFirst(5)) as? [String: Any]
+        XCTAssertEqual(json?["windowId"] as? UInt64, 12345)
+        XCTAssertEqual(json?["visibility"] as? Int, SpiceStreamVisibility.background.rawValue)
+        XCTAssertEqual(json?["maxFps"] as? Int, 5)
+        // Left out until the host has decoded a tiled frame
+        XCTAssertNil(json?["hostDecodeUs"])
+        XCTAssertNil(json?["hostSkippedFrames"])
+    }
+
+    func testSerializeSetWindowThrottleWithDecodeTimeAndSkips() throws {
+        let message = SetWindowThrottleSpiceMessage(windowId: 12345, visibility: .visible, hostDecodeUs: 1500, hostSkippedFrames: 3)
+
+        let data = try SpiceMessageSerializer.serialize(message)
+
+        let json = try JSONSerialization.jsonObject(with: data.dropFirst(5)) as? [String: Any]
+        XCTAssertEqual(json?["hostDecodeUs"] as? Int, 1500)
+        XCTAssertEqual(json?["hostSkippedFrames"] as? Int, 3)
+    }
+
+    func testSerializePingMessage() throws {
+        let message = PingSpiceMessage(sequence: 7, sentAt: 1_234_567)
+
+        let data = try SpiceMessageSerializer.serialize(message)
+
+        XCTAssertEqual(data[0], SpiceMessageType.ping.rawValue)
+        let json = try JSONSerialization.jsonObject(with: data.dropFirst(5)) as? [String: Any]
+        XCTAssertEqual(json?["messageId"] as? Int, 0)
+        XCTAssertEqual(json?["sequence"] as? Int, 7)
+        XCTAssertEqual(json?["sentAt"] as? Int, 1_234_567)
+    }
+
+    func testDeserializeHeartbeatPingReply() throws {
+        let json = #"{"timestamp":1,"trackedWindowCount":2,"uptimeMs":10,"cpuUsagePercent":1.5,"#
+            + #""memoryUsageBytes":4096,"pingSequence":7,"pingSentAt":1234567}"#
+        let payload = Data(json.utf8)
+        var envelope = Data([SpiceMessageType.heartbeat.rawValue])
+        var length = UInt32(payload.count).littleEndian
+        withUnsafeBytes(of: &length) { envelope.append(contentsOf: $0) }
+        envelope.append(payload)
+
+        let message = try SpiceMessageSerializer.deserialize(envelope)?.1 as? HeartbeatMessage
+
+        XCTAssertEqual(message?.pingSequence, 7)
+        XCTAssertEqual(message?.pingSentAt, 1_234_567)
+        XCTAssertEqual(message?.trackedWindowCount, 2)
+    }
+
     func testDeserializeSessionListMessage() throws {
         let sessionInfo = SpiceSessionInfo(
             sessionId: "1234",
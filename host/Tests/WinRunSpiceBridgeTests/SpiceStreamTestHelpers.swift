@@ -15,9 +15,12 @@ final class TestSpiceStreamTransport: SpiceStreamTransport {
     }
 
     var openBehavior: OpenBehavior = .succeed
+    /// Result of resuming a subscription, or nil for subscriptions that can't resume
+    var resumeBehavior: Result<Void, SpiceStreamError>?
     var isOpen = false
     var openCallCount = 0
     var closeCallCount = 0
+    var resumeCallCount = 0
     var lastWindowID: UInt64?
     var lastConfiguration: SpiceStreamConfiguration?
 
@@ -27,6 +30,7 @@ final class TestSpiceStreamTransport: SpiceStreamTransport {
     var clipboardSent: [ClipboardData] = []
     var clipboardRequests: [ClipboardFormat] = []
     var dragDropEvents: [DragDropEvent] = []
+    var visibilityChanges: [(SpiceStreamVisibility, UInt32)] = []
 
     // Callback storage for triggering events from tests
     private var callbacks: SpiceStreamCallbacks?
@@ -44,9 +48,18 @@ final class TestSpiceStreamTransport: SpiceStreamTransport {
         switch openBehavior {
         case .succeed:
             isOpen = true
-            return SpiceStreamSubscription { [weak self] in
+            let cleanup: () -> Void = { [weak self] in
                 self?.isOpen = false
             }
+            guard resumeBehavior != nil else {
+                return SpiceStreamSubscription(cleanup: cleanup)
+            }
+            return SpiceStreamSubscription(cleanup: cleanup, resume: { [weak self] in
+                guard let self, let behavior = self.resumeBehavior else { return }
+                self.resumeCallCount += 1
+                try behavior.get()
+                self.isOpen = true
+            })
         case .fail(let error):
             throw error
         case .delay(let interval, let thenBehavior):
@@ -85,6 +98,10 @@ final class TestSpiceStreamTransport: SpiceStreamTransport {
         dragDropEvents.append(event)
     }
 
+    func setVisibility(_ visibility: SpiceStreamVisibility, maxFrameRate: UInt32) {
+        visibilityChanges.append((visibility, maxFrameRate))
+    }
+
     // Control channel
     var controlCallback: ((Data) -> Void)?
     var controlMessagesSent: [Data] = []
@@ -102,6 +119,32 @@ final class TestSpiceStreamTransport: SpiceStreamTransport {
         controlCallback?(data)
     }
 
+    // Guest heartbeat
+    var heartbeatStarts: [(interval: Duration, stallAfter: Duration)] = []
+    private var onHealthChange: ((SpiceGuestHealth, SpiceHeartbeatStats) -> Void)?
+
+    func startHeartbeat(
+        interval: Duration,
+        stallAfter: Duration,
+        onHealthChange: @escaping (SpiceGuestHealth, SpiceHeartbeatStats) -> Void
+    ) -> Bool {
+        heartbeatStarts.append((interval, stallAfter))
+        self.onHealthChange = onHealthChange
+        return true
+    }
+
+    func stopHeartbeat() {
+        onHealthChange = nil
+    }
+
+    func heartbeatStatistics() -> SpiceHeartbeatStats? {
+        onHealthChange == nil ? nil : SpiceHeartbeatStats()
+    }
+
+    func simulateGuestHealth(_ health: SpiceGuestHealth, statistics: SpiceHeartbeatStats = SpiceHeartbeatStats()) {
+        onHealthChange?(health, statistics)
+    }
+
     // Test helpers to simulate events from guest
 
     func simulateFrame(_ data: Data) {
@@ -120,11 +163,21 @@ final class TestSpiceStreamTransport: SpiceStreamTransport {
         callbacks?.onClipboard(clipboard)
     }
 
+    func simulateCursor(_ event: SpiceCursorEvent) {
+        callbacks?.onCursor(event)
+    }
+
+    func simulateVideoFrame(_ frame: SpiceVideoFrame) {
+        callbacks?.onVideoFrame(frame)
+    }
+
     func reset() {
         openBehavior = .succeed
+        resumeBehavior = nil
         isOpen = false
         openCallCount = 0
         closeCallCount = 0
+        resumeCallCount = 0
         lastWindowID = nil
         lastConfiguration = nil
         mouseEvents.removeAll()
@@ -132,8 +185,11 @@ final class TestSpiceStreamTransport: SpiceStreamTransport {
         clipboardSent.removeAll()
         clipboardRequests.removeAll()
         dragDropEvents.removeAll()
+        visibilityChanges.removeAll()
         controlMessagesSent.removeAll()
         controlCallback = nil
+        heartbeatStarts.removeAll()
+        onHealthChange = nil
         callbacks = nil
     }
 }
@@ -146,6 +202,8 @@ final class TestSpiceWindowStreamDelegate: SpiceWindowStreamDelegate {
     var metadataUpdates: [WindowMetadata] = []
     var stateChanges: [SpiceConnectionState] = []
     var clipboardReceived: [ClipboardData] = []
+    var cursorEvents: [SpiceCursorEvent] = []
+    var videoFrames: [SpiceVideoFrame] = []
     var didCloseCallCount = 0
 
     private let stateExpectation: XCTestExpectation?
@@ -183,12 +241,22 @@ final class TestSpiceWindowStreamDelegate: SpiceWindowStreamDelegate {
         clipboardReceived.append(clipboard)
     }
 
+    func windowStream(_ stream: SpiceWindowStream, didUpdateCursor event: SpiceCursorEvent) {
+        cursorEvents.append(event)
+    }
+
+    func windowStream(_ stream: SpiceWindowStream, didDecodeVideoFrame frame: SpiceVideoFrame) {
+        videoFrames.append(frame)
+    }
+
     func reset() {
         frames.removeAll()
         sharedFrames.removeAll()
         metadataUpdates.removeAll()
         stateChanges.removeAll()
         clipboardReceived.removeAll()
+        cursorEvents.removeAll()
+        videoFrames.removeAll()
         didCloseCallCount = 0
     }
 }
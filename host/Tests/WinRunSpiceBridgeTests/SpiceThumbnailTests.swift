@@ -0,0 +1,207 @@
+import XCTest
+
+@testable import WinRunShared
+@testable import WinRunSpiceBridge
+
+final class ThumbnailDownscalerTests: XCTestCase {
+    func testScaleFactorFitsWithinBounds() {
+        XCTAssertEqual(ThumbnailDownscaler.scaleFactor(width: 3840, height: 2160, maxWidth: 256, maxHeight: 256), 15)
+        XCTAssertEqual(ThumbnailDownscaler.scaleFactor(width: 1000, height: 200, maxWidth: 256, maxHeight: 256), 4)
+        XCTAssertEqual(ThumbnailDownscaler.scaleFactor(width: 100, height: 100, maxWidth: 256, maxHeight: 256), 1)
+    }
+
+    func testScaleFactorWithInvalidBoundsIsOne() {
+        XCTAssertEqual(ThumbnailDownscaler.scaleFactor(width: 1920, height: 1080, maxWidth: 0, maxHeight: 256), 1)
+    }
+
+    func testDownscaleAveragesBlocks() {
+        // 8x2 source, factor 2 -> 4x1 output; each block holds values v and v + 2
+        let width = 8
+        let height = 2
+        var pixels = [UInt8](repeating: 0, count: width * height * 4)
+        for y in 0..<height {
+            for x in 0..<width {
+                let base = (y * width + x) * 4
+                let value = UInt8(x / 2 * 10 + y * 2)
+                pixels[base] = value
+                pixels[base + 1] = value &+ 100
+                pixels[base + 2] = 255
+                pixels[base + 3] = 0
+            }
+        }
+
+        let result = pixels.withUnsafeBytes {
+            ThumbnailDownscaler.downscale(source: $0, width: width, height: height, stride: width * 4, factor: 2)
+        }
+
+        XCTAssertEqual(result?.width, 4)
+        XCTAssertEqual(result?.height, 1)
+        XCTAssertEqual(result.map { [UInt8]($0.data) }, [
+            1, 101, 255, 0,
+            11, 111, 255, 0,
+            21, 121, 255, 0,
+            31, 131, 255, 0,
+        ])
+    }
+
+    func testDownscaleHandlesWideBlocksAndRowPadding() {
+        // Factor 5 exercises both the 4-pixel SIMD loads and the single-pixel tail
+        let width = 10
+        let height = 5
+        let stride = width * 4 + 8
+        var pixels = [UInt8](repeating: 0xEE, count: stride * height)
+        for y in 0..<height {
+            for x in 0..<width {
+                let base = y * stride + x * 4
+                pixels[base] = x < 5 ? 10 : 200
+                pixels[base + 1] = UInt8(y * 10)
+                pixels[base + 2] = 0
+                pixels[base + 3] = 255
+            }
+        }
+
+        let result = pixels.withUnsafeBytes {
+            ThumbnailDownscaler.downscale(source: $0, width: width, height: height, stride: stride, factor: 5)
+        }
+
+        XCTAssertEqual(result?.width, 2)
+        XCTAssertEqual(result?.height, 1)
+        XCTAssertEqual(result.map { [UInt8]($0.data) }, [
+            10, 20, 0, 255,
+            200, 20, 0, 255,
+        ])
+    }
+
+    func testDownscaleDropsPartialBlocks() {
+        let width = 5
+        let height = 3
+        let pixels = [UInt8](repeating: 50, count: width * height * 4)
+
+        let result = pixels.withUnsafeBytes {
+            ThumbnailDownscaler.downscale(source: $0, width: width, height: height, stride: width * 4, factor: 2)
+        }
+
+        XCTAssertEqual(result?.width, 2)
+        XCTAssertEqual(result?.height, 1)
+        XCTAssertEqual(result?.data.count, 2 * 4)
+    }
+
+    func testDownscaleRejectsShortSource() {
+        let pixels = [UInt8](repeating: 0, count: 16)
+
+        let result = pixels.withUnsafeBytes {
+            ThumbnailDownscaler.downscale(source: $0, width: 4, height: 4, stride: 16, factor: 2)
+        }
+
+        XCTAssertNil(result)
+    }
+}
+
+#if os(macOS)
+    final class SpiceWindowStreamThumbnailTests: XCTestCase {
+        private let testQueue = DispatchQueue(label: "test.thumbnails")
+        private let config = SharedFrameBufferConfig(slotCount: 4, maxWidth: 100, maxHeight: 100)
+
+        func testThumbnailIsTakenFromDecodedTiledFrame() {
+            assertTiledFrameThumbnail(visibility: .visible)
+        }
+
+        /// Hidden streams never read their frames, but still decode tiled key
+        /// frames as they discard them.
+        func testHiddenStreamThumbnailIsTakenFromDecodedTiledFrame() {
+            assertTiledFrameThumbnail(visibility: .hidden)
+        }
+
+        private func assertTiledFrameThumbnail(
+            visibility: SpiceStreamVisibility,
+            file: StaticString = #filePath,
+            line: UInt = #line
+        ) {
+            let transport = TestSpiceStreamTransport()
+            let stream = SpiceWindowStream(
+                configuration: SpiceStreamConfiguration.environmentDefault(),
+                delegateQueue: testQueue,
+                logger: NullLogger(),
+                transport: transport,
+                reconnectPolicy: ReconnectPolicy(maxAttempts: 1)
+            )
+            stream.connect(toWindowID: 100)
+            let connected = expectation(description: "Connected")
+            testQueue.asyncAfter(deadline: .now() + 0.1) {
+                connected.fulfill()
+            }
+            wait(for: [connected], timeout: 1.0)
+
+            stream.setVisibility(visibility)
+            stream.setThumbnailConfiguration(SpiceThumbnailConfiguration(maxWidth: 10, maxHeight: 10, refreshInterval: 0))
+            stream.setFrameBufferReader(SharedFrameBufferReader(
+                pointer: makeBufferWithTiledFrame(),
+                size: config.totalSize,
+                ownsMemory: true,
+                logger: NullLogger()
+            ))
+            stream.handleFrameReady(FrameReadyMessage(windowId: 100, slotIndex: 0, frameNumber: 1, isKeyFrame: true))
+
+            guard let thumbnail = stream.latestThumbnail() else {
+                XCTFail("No thumbnail for a tiled frame", file: file, line: line)
+                return
+            }
+            XCTAssertEqual(thumbnail.frameNumber, 1, file: file, line: line)
+            XCTAssertEqual(thumbnail.width, 10, file: file, line: line)
+            XCTAssertEqual(thumbnail.height, 10, file: file, line: line)
+            thumbnail.data.withUnsafeBytes { bytes in
+                XCTAssertEqual(bytes.loadUnaligned(fromByteOffset: 0, as: UInt32.self), 0xFF11_2233, file: file, line: line)
+                XCTAssertEqual(bytes.loadUnaligned(fromByteOffset: 99 * 4, as: UInt32.self), 0xFFAA_BBCC, file: file, line: line)
+            }
+        }
+
+        /// A buffer holding one 100x100 tiled key frame: four 64-pixel tiles
+        /// (clipped at the edges), each one RLE run of a color.
+        private func makeBufferWithTiledFrame() -> UnsafeMutableRawPointer {
+            let pointer = UnsafeMutableRawPointer.allocate(
+                byteCount: config.totalSize,
+                alignment: MemoryLayout<UInt64>.alignment
+            )
+            pointer.initializeMemory(as: UInt8.self, repeating: 0, count: config.totalSize)
+            var header = config.createHeader()
+            header.writeIndex = 1
+            pointer.bindMemory(to: SharedFrameBufferHeader.self, capacity: 1).pointee = header
+
+            let runs: [(count: Int, color: UInt32)] = [
+                (64 * 64, 0xFF11_2233), (36 * 64, 0xFF44_5566), (64 * 36, 0xFF77_8899), (36 * 36, 0xFFAA_BBCC)
+            ]
+            var payload: [UInt8] = []
+            func append<T: FixedWidthInteger>(_ value: T) {
+                withUnsafeBytes(of: value.littleEndian) { payload.append(contentsOf: $0) }
+            }
+            append(UInt16(64))
+            append(UInt16(0))
+            append(UInt32(runs.count))
+            for _ in runs {
+                append(UInt32(2))  // RLE, 3 reserved bytes
+                append(UInt32(6))
+            }
+            for run in runs {
+                append(UInt16(run.count))
+                append(run.color)
+            }
+
+            var slotHeader = FrameSlotHeader()
+            slotHeader.windowId = 100
+            slotHeader.frameNumber = 1
+            slotHeader.width = UInt32(config.maxWidth)
+            slotHeader.height = UInt32(config.maxHeight)
+            slotHeader.stride = UInt32(config.maxWidth * config.bytesPerPixel)
+            slotHeader.format = UInt32(SpicePixelFormat.bgra32.rawValue)
+            slotHeader.dataSize = UInt32(payload.count)
+            slotHeader.flags = FrameSlotFlags([.compressed, .tiled, .keyFrame]).rawValue
+
+            let slotPtr = pointer.advanced(by: SharedFrameBufferHeader.size)
+            slotPtr.bindMemory(to: FrameSlotHeader.self, capacity: 1).pointee = slotHeader
+            payload.withUnsafeBytes {
+                slotPtr.advanced(by: FrameSlotHeader.size).copyMemory(from: $0.baseAddress!, byteCount: $0.count)
+            }
+            return pointer
+        }
+    }
+#endif
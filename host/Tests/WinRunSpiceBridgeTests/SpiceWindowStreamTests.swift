@@ -184,6 +184,65 @@ final class SpiceWindowStreamTests: XCTestCase {
         XCTAssertEqual(stream.connectionState, .connected)
     }
 
+    func testTransportDropResumesExistingStream() {
+        transport.resumeBehavior = .success(())
+        stream = makeStream(reconnectPolicy: ReconnectPolicy(initialDelay: 0.05, maxAttempts: 3))
+        stream.connect(toWindowID: 1)
+
+        let arrow = SpiceCursorImage(hash: 1, width: 1, height: 1, hotspotX: 0, hotspotY: 0, data: Data(count: 4))
+        let connectedExpectation = expectation(description: "Connected")
+        testQueue.asyncAfter(deadline: .now() + 0.1) {
+            self.transport.simulateCursor(.set(arrow))
+            self.transport.simulateClose(SpiceStreamCloseReason(code: .transportError, message: "Link down"))
+            connectedExpectation.fulfill()
+        }
+        wait(for: [connectedExpectation], timeout: 1.0)
+
+        let resumedExpectation = expectation(description: "Resumed")
+        DispatchQueue.global().asyncAfter(deadline: .now() + 0.3) {
+            self.transport.simulateCursor(.set(arrow))
+            self.testQueue.asyncAfter(deadline: .now() + 0.1) {
+                resumedExpectation.fulfill()
+            }
+        }
+        wait(for: [resumedExpectation], timeout: 2.0)
+
+        // Same stream re-attached: no reopen, no close, cursor state kept
+        XCTAssertEqual(transport.resumeCallCount, 1)
+        XCTAssertEqual(transport.openCallCount, 1)
+        XCTAssertEqual(transport.closeCallCount, 0)
+        XCTAssertEqual(delegate.didCloseCallCount, 0)
+        XCTAssertEqual(delegate.cursorEvents, [.set(arrow)])
+        XCTAssertEqual(stream.connectionState, .connected)
+        XCTAssertEqual(stream.metricsSnapshot().sessionResumes, 1)
+    }
+
+    func testFailedResumeFallsBackToReopen() {
+        transport.resumeBehavior = .failure(.connectionFailed("Session gone"))
+        stream = makeStream(reconnectPolicy: ReconnectPolicy(initialDelay: 0.05, maxAttempts: 3))
+        stream.connect(toWindowID: 1)
+
+        let connectedExpectation = expectation(description: "Connected")
+        testQueue.asyncAfter(deadline: .now() + 0.1) {
+            self.transport.simulateClose(SpiceStreamCloseReason(code: .transportError, message: "Link down"))
+            connectedExpectation.fulfill()
+        }
+        wait(for: [connectedExpectation], timeout: 1.0)
+
+        let reopenedExpectation = expectation(description: "Reopened")
+        DispatchQueue.global().asyncAfter(deadline: .now() + 0.3) {
+            reopenedExpectation.fulfill()
+        }
+        wait(for: [reopenedExpectation], timeout: 2.0)
+
+        // The dead stream is closed and a fresh one opened in the same attempt
+        XCTAssertEqual(transport.resumeCallCount, 1)
+        XCTAssertEqual(transport.closeCallCount, 1)
+        XCTAssertEqual(transport.openCallCount, 2)
+        XCTAssertEqual(stream.connectionState, .connected)
+        XCTAssertEqual(stream.metricsSnapshot().sessionResumes, 0)
+    }
+
     // MARK: - Pause/Resume Tests
 
     func testPauseSetsPausedFlag() {
@@ -228,6 +287,136 @@ final class SpiceWindowStreamTests: XCTestCase {
 
         XCTAssertFalse(stream.isPaused)
     }
+
+    // MARK: - Visibility Tests
+
+    func testPauseMarksStreamHidden() {
+        stream = makeStream()
+        stream.connect(toWindowID: 1)
+        stream.pause()
+
+        let pauseExpectation = expectation(description: "Paused")
+        testQueue.asyncAfter(deadline: .now() + 0.1) {
+            pauseExpectation.fulfill()
+        }
+        wait(for: [pauseExpectation], timeout: 1.0)
+
+        XCTAssertEqual(stream.visibility, .hidden)
+        XCTAssertEqual(transport.visibilityChanges.last?.0, .hidden)
+    }
+
+    func testFramesAreChargedToMemoryBudget() {
+        let budget = SpiceMemoryBudget(logger: NullLogger())
+        stream = makeStream()
+        stream.setMemoryBudget(budget)
+        stream.connect(toWindowID: 7)
+
+        let connectExpectation = expectation(description: "Connected")
+        testQueue.asyncAfter(deadline: .now() + 0.1) {
+            connectExpectation.fulfill()
+        }
+        wait(for: [connectExpectation], timeout: 1.0)
+
+        transport.simulateFrame(Data(count: 4096))
+
+        let frameExpectation = expectation(description: "Frame charged")
+        testQueue.asyncAfter(deadline: .now() + 0.1) {
+            frameExpectation.fulfill()
+        }
+        wait(for: [frameExpectation], timeout: 1.0)
+
+        XCTAssertEqual(budget.usedBytes(in: .surface), 4096)
+
+        stream.disconnect()
+
+        let disconnectExpectation = expectation(description: "Account closed")
+        testQueue.asyncAfter(deadline: .now() + 0.1) {
+            disconnectExpectation.fulfill()
+        }
+        wait(for: [disconnectExpectation], timeout: 1.0)
+
+        XCTAssertEqual(budget.usedBytes, 0)
+        XCTAssertEqual(budget.accountCount, 0)
+    }
+
+    func testSetVisibilityForwardsThrottleHintToGuest() {
+        stream = makeStream()
+        stream.connect(toWindowID: 42)
+        stream.setVisibility(.background, maxFrameRate: 5)
+
+        let visibilityExpectation = expectation(description: "Visibility applied")
+        testQueue.asyncAfter(deadline: .now() + 0.1) {
+            visibilityExpectation.fulfill()
+        }
+        wait(for: [visibilityExpectation], timeout: 1.0)
+
+        XCTAssertEqual(stream.visibility, .background)
+        XCTAssertFalse(stream.isPaused)
+        XCTAssertEqual(transport.visibilityChanges.last?.0, .background)
+        XCTAssertEqual(transport.visibilityChanges.last?.1, 5)
+
+        let hint = transport.controlMessagesSent.last
+        XCTAssertEqual(hint?.first, SpiceMessageType.setWindowThrottle.rawValue)
+    }
+
+    func testDisconnectReleasesGuestDemandUntilReconnect() throws {
+        stream = makeStream()
+        stream.connect(toWindowID: 42)
+        stream.disconnect()
+
+        let disconnectExpectation = expectation(description: "Disconnected")
+        testQueue.asyncAfter(deadline: .now() + 0.1) {
+            disconnectExpectation.fulfill()
+        }
+        wait(for: [disconnectExpectation], timeout: 1.0)
+
+        // The guest stops capturing a window nobody watches
+        let release = try XCTUnwrap(transport.controlMessagesSent.last)
+        XCTAssertEqual(release.first, SpiceMessageType.setWindowThrottle.rawValue)
+        let released = try JSONDecoder().decode(SetWindowThrottleSpiceMessage.self, from: release.dropFirst(5))
+        XCTAssertEqual(released.windowId, 42)
+        XCTAssertEqual(released.visibility, .hidden)
+
+        stream.connect(toWindowID: 42)
+        let reconnectExpectation = expectation(description: "Reconnected")
+        testQueue.asyncAfter(deadline: .now() + 0.1) {
+            reconnectExpectation.fulfill()
+        }
+        wait(for: [reconnectExpectation], timeout: 1.0)
+
+        let restore = try XCTUnwrap(transport.controlMessagesSent.last)
+        let restored = try JSONDecoder().decode(SetWindowThrottleSpiceMessage.self, from: restore.dropFirst(5))
+        XCTAssertEqual(restored.visibility, .visible)
+    }
+
+    func testSetFocusedForwardsFocusToGuest() throws {
+        stream = makeStream()
+        stream.connect(toWindowID: 42)
+        stream.setFocused(true)
+
+        let focusExpectation = expectation(description: "Focus applied")
+        testQueue.asyncAfter(deadline: .now() + 0.1) {
+            focusExpectation.fulfill()
+        }
+        wait(for: [focusExpectation], timeout: 1.0)
+
+        let hint = try XCTUnwrap(transport.controlMessagesSent.last)
+        XCTAssertEqual(hint.first, SpiceMessageType.setWindowThrottle.rawValue)
+        let message = try JSONDecoder().decode(SetWindowThrottleSpiceMessage.self, from: hint.dropFirst(5))
+        XCTAssertEqual(message.windowId, 42)
+        XCTAssertEqual(message.visibility, .visible)
+        XCTAssertTrue(message.isFocused)
+
+        // Repeating the same focus sends nothing new
+        let sent = transport.controlMessagesSent.count
+        stream.setFocused(true)
+        let repeatExpectation = expectation(description: "Repeat ignored")
+        testQueue.asyncAfter(deadline: .now() + 0.1) {
+            repeatExpectation.fulfill()
+        }
+        wait(for: [repeatExpectation], timeout: 1.0)
+        XCTAssertEqual(transport.controlMessagesSent.count, sent)
+    }
 }
 
 // MARK: - Input and Clipboard Tests
@@ -418,13 +607,14 @@ final class SpiceWindowStreamDelegateTests: XCTestCase {
         super.tearDown()
     }
 
-    private func makeStream() -> SpiceWindowStream {
+    private func makeStream(callbackExecutor: SpiceCallbackExecutor? = nil) -> SpiceWindowStream {
         let stream = SpiceWindowStream(
             configuration: SpiceStreamConfiguration.environmentDefault(),
             delegateQueue: testQueue,
             logger: NullLogger(),
             transport: transport,
-            reconnectPolicy: ReconnectPolicy(maxAttempts: 3)
+            reconnectPolicy: ReconnectPolicy(maxAttempts: 3),
+            callbackExecutor: callbackExecutor
         )
         stream.delegate = delegate
         return stream
@@ -458,6 +648,31 @@ final class SpiceWindowStreamDelegateTests: XCTestCase {
         XCTAssertEqual(delegate.frames.first, frameData)
     }
 
+    func testCallbackExecutorBatchRunsOnItsQueue() {
+        let executor = SpiceCallbackExecutor(label: "test.callbacks")
+        stream = makeStream(callbackExecutor: executor)
+        connectStream()
+
+        // One drain handing over several events, as the bridge does after a wakeup.
+        // The stream's state queue targets the executor's, so the batch is handled
+        // once the drain block has returned.
+        executor.queue.async {
+            for byte in UInt8(1)...5 {
+                self.transport.simulateFrame(Data([byte]))
+            }
+        }
+        executor.queue.sync {}
+
+        let frameExpectation = expectation(description: "Frames received")
+        testQueue.asyncAfter(deadline: .now() + 0.1) {
+            frameExpectation.fulfill()
+        }
+        wait(for: [frameExpectation], timeout: 1.0)
+
+        XCTAssertEqual(delegate.frames, (UInt8(1)...5).map { Data([$0]) })
+        XCTAssertEqual(stream.connectionState, .connected)
+    }
+
     func testMetadataDeliveredToDelegate() {
         stream = makeStream()
         connectStream()
@@ -501,6 +716,70 @@ final class SpiceWindowStreamDelegateTests: XCTestCase {
         XCTAssertEqual(delegate.clipboardReceived.first?.sequenceNumber, 5)
     }
 
+    func testCursorEventsDeliveredToDelegate() {
+        stream = makeStream()
+        connectStream()
+
+        let arrow = SpiceCursorImage(hash: 1, width: 1, height: 1, hotspotX: 0, hotspotY: 0, data: Data(count: 4))
+        let beam = SpiceCursorImage(hash: 2, width: 1, height: 1, hotspotX: 0, hotspotY: 0, data: Data(count: 4))
+        transport.simulateCursor(.set(arrow))
+        transport.simulateCursor(.set(arrow))
+        transport.simulateCursor(.move(x: 10, y: 20))
+        transport.simulateCursor(.set(beam))
+        transport.simulateCursor(.hide)
+        transport.simulateCursor(.set(beam))
+
+        let cursorExpectation = expectation(description: "Cursor events received")
+        testQueue.asyncAfter(deadline: .now() + 0.1) {
+            cursorExpectation.fulfill()
+        }
+        wait(for: [cursorExpectation], timeout: 1.0)
+
+        // The repeated arrow is dropped; the beam is reported again after hiding
+        XCTAssertEqual(delegate.cursorEvents, [
+            .set(arrow),
+            .move(x: 10, y: 20),
+            .set(beam),
+            .hide,
+            .set(beam)
+        ])
+    }
+
+    func testVideoFramesDeliveredUntilHidden() {
+        stream = makeStream()
+        connectStream()
+
+        func videoFrame(_ time: UInt32, dropped: UInt64) -> SpiceVideoFrame {
+            SpiceVideoFrame(
+                windowID: 1,
+                streamID: 3,
+                destination: CGRect(x: 10, y: 20, width: 2, height: 2),
+                width: 2,
+                height: 2,
+                data: Data(count: 16),
+                presentationTime: time,
+                droppedFrames: dropped
+            )
+        }
+
+        transport.simulateVideoFrame(videoFrame(40, dropped: 0))
+        transport.simulateVideoFrame(videoFrame(80, dropped: 2))
+        stream.setVisibility(.hidden)
+        transport.simulateVideoFrame(videoFrame(120, dropped: 2))
+
+        let videoExpectation = expectation(description: "Video frames received")
+        testQueue.asyncAfter(deadline: .now() + 0.1) {
+            videoExpectation.fulfill()
+        }
+        wait(for: [videoExpectation], timeout: 1.0)
+
+        XCTAssertEqual(delegate.videoFrames.map(\.presentationTime), [40, 80])
+        XCTAssertEqual(delegate.videoFrames.first?.destination, CGRect(x: 10, y: 20, width: 2, height: 2))
+        let metrics = stream.metricsSnapshot()
+        XCTAssertEqual(metrics.videoFramesDecoded, 3)
+        XCTAssertEqual(metrics.videoFramesDropped, 2)
+    }
+
     // MARK: - Metrics Tests
 
     func testMetricsTrackFramesReceived() {
@@ -519,6 +798,29 @@ final class SpiceWindowStreamDelegateTests: XCTestCase {
 
         let metrics = stream.metricsSnapshot()
         XCTAssertEqual(metrics.framesReceived, 3)
+        XCTAssertGreaterThan(metrics.effectiveFrameRate, 0)
+    }
+
+    func testMetricsTrackGuestFrameRate() {
+        stream = makeStream()
+        connectStream()
+
+        stream.handleFrameReady(FrameReadyMessage(windowId: 1, slotIndex: 0, frameNumber: 1, targetFps: 30, rateReason: "capped"))
+        stream.handleFrameReady(FrameReadyMessage(windowId: 1, slotIndex: 1, frameNumber: 2, targetFps: 30, rateReason: "capped"))
+        stream.handleFrameReady(FrameReadyMessage(windowId: 1, slotIndex: 2, frameNumber: 3, targetFps: 15, rateReason: "backpressure"))
+        // Guests without a governor don't report a rate
+        stream.handleFrameReady(FrameReadyMessage(windowId: 1, slotIndex: 0, frameNumber: 4))
+
+        let metricsExpectation = expectation(description: "Metrics updated")
+        testQueue.asyncAfter(deadline: .now() + 0.1) {
+            metricsExpectation.fulfill()
+        }
+        wait(for: [metricsExpectation], timeout: 1.0)
+
+        let metrics = stream.metricsSnapshot()
+        XCTAssertEqual(metrics.guestTargetFrameRate, 15)
+        XCTAssertEqual(metrics.guestRateReason, "backpressure")
+        XCTAssertEqual(metrics.guestRateChanges, 1)
     }
 
     func testMetricsTrackMetadataUpdates() {